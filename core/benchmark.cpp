@@ -41,6 +41,54 @@ class AudioProducer {
   std::vector<float> audio_data_;
 };
 
+struct PassResult {
+  moonshine::Transcript transcript;
+  float duration_seconds = 0.0f;
+};
+
+// Feeds the whole file through a live stream, updating the transcript every
+// ``transcription_interval_seconds`` of audio as a caller showing live
+// captions would.
+PassResult run_pass(moonshine::Transcriber &transcriber,
+                    const std::string &wav_path,
+                    float transcription_interval_seconds) {
+  AudioProducer audio_producer(wav_path);
+  std::chrono::high_resolution_clock::time_point start =
+      std::chrono::high_resolution_clock::now();
+
+  transcriber.start();
+  std::vector<float> chunk_audio_data;
+  const int32_t samples_between_transcriptions = static_cast<int32_t>(
+      transcription_interval_seconds * audio_producer.sample_rate());
+  int32_t samples_since_last_transcription = 0;
+  while (audio_producer.getNextAudio(chunk_audio_data)) {
+    transcriber.addAudio(chunk_audio_data, audio_producer.sample_rate());
+    samples_since_last_transcription += chunk_audio_data.size();
+    if (samples_since_last_transcription < samples_between_transcriptions) {
+      continue;
+    }
+    samples_since_last_transcription = 0;
+    transcriber.updateTranscription();
+  }
+  transcriber.stop();
+  PassResult result;
+  result.transcript = transcriber.updateTranscription();
+  std::chrono::high_resolution_clock::time_point end =
+      std::chrono::high_resolution_clock::now();
+  std::chrono::milliseconds duration =
+      std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+  result.duration_seconds = duration.count() / 1000.0f;
+  return result;
+}
+
+std::string transcript_text(const moonshine::Transcript &transcript) {
+  std::string text;
+  for (const moonshine::TranscriptLine &line : transcript.lines) {
+    text += line.text + "\n";
+  }
+  return text;
+}
+
 }  // namespace
 
 int main(int argc, char *argv[]) {
@@ -51,6 +99,8 @@ int main(int argc, char *argv[]) {
   std::string keyterms;
   std::string keyterm_boost;
   std::string keyterms_path;
+  bool incremental = false;
+  std::string min_new_samples;
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
     if (arg == "-m" || arg == "--model-path") {
@@ -67,6 +117,10 @@ int main(int argc, char *argv[]) {
       keyterms_path = argv[++i];
     } else if (arg == "-b" || arg == "--keyterm-boost") {
       keyterm_boost = argv[++i];
+    } else if (arg == "-i" || arg == "--incremental") {
+      incremental = true;
+    } else if (arg == "--min-new-samples") {
+      min_new_samples = argv[++i];
     } else {
       std::cerr << "Unknown argument: " << arg << std::endl;
       return 1;
@@ -114,6 +168,20 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // The incremental options only change how in-progress lines are decoded,
+  // so a plain pass over the same audio shows what they save.
+  PassResult baseline;
+  if (incremental) {
+    moonshine::Transcriber baseline_transcriber(model_path, model_arch, 0.5,
+                                                "", options);
+    baseline = run_pass(baseline_transcriber, wav_path,
+                        transcription_interval_seconds);
+    options.emplace_back("incremental_decoding", "true");
+    if (!min_new_samples.empty()) {
+      options.emplace_back("incremental_min_new_samples", min_new_samples);
+    }
+  }
+
   AudioProducer audio_producer(wav_path);
   std::chrono::high_resolution_clock::time_point load_start =
       std::chrono::high_resolution_clock::now();
@@ -124,30 +192,10 @@ int main(int argc, char *argv[]) {
           .count() /
       1000.0f;
 
-  std::chrono::high_resolution_clock::time_point start =
-      std::chrono::high_resolution_clock::now();
-
-  transcriber.start();
-  std::vector<float> chunk_audio_data;
-  const int32_t samples_between_transcriptions = static_cast<int32_t>(
-      transcription_interval_seconds * audio_producer.sample_rate());
-  int32_t samples_since_last_transcription = 0;
-  while (audio_producer.getNextAudio(chunk_audio_data)) {
-    transcriber.addAudio(chunk_audio_data, audio_producer.sample_rate());
-    samples_since_last_transcription += chunk_audio_data.size();
-    if (samples_since_last_transcription < samples_between_transcriptions) {
-      continue;
-    }
-    samples_since_last_transcription = 0;
-    transcriber.updateTranscription();
-  }
-  transcriber.stop();
-  moonshine::Transcript transcript = transcriber.updateTranscription();
-  std::chrono::high_resolution_clock::time_point end =
-      std::chrono::high_resolution_clock::now();
-  std::chrono::milliseconds duration =
-      std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-  const float duration_seconds = duration.count() / 1000.0f;
+  PassResult result =
+      run_pass(transcriber, wav_path, transcription_interval_seconds);
+  const moonshine::Transcript &transcript = result.transcript;
+  const float duration_seconds = result.duration_seconds;
   const float wav_duration_seconds =
       audio_producer.audio_data_size() /
       static_cast<float>(audio_producer.sample_rate());
@@ -165,6 +213,22 @@ int main(int argc, char *argv[]) {
   fprintf(stderr,
           "Transcription took %.2f seconds (%.2f%% of audio duration)\n",
           duration_seconds, transcription_percentage);
+  if (incremental) {
+    const float saved_seconds =
+        baseline.duration_seconds - result.duration_seconds;
+    fprintf(stderr,
+            "Incremental decoding saved %.2f seconds (%.2f%% of the %.2f "
+            "second plain pass)\n",
+            saved_seconds,
+            baseline.duration_seconds > 0.0f
+                ? (saved_seconds / baseline.duration_seconds) * 100.0f
+                : 0.0f,
+            baseline.duration_seconds);
+    fprintf(stderr, "Transcript %s the plain pass\n",
+            transcript_text(transcript) == transcript_text(baseline.transcript)
+                ? "matches"
+                : "DIFFERS from");
+  }
   return 0;
 }
 
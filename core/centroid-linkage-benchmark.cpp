@@ -0,0 +1,107 @@
+// Measures how speaker clustering's centroid linkage scales with the number
+// of training embeddings, and checks that linkage_centroid() reproduces
+// linkage_centroid_naive() exactly wherever the naive version is still
+// affordable.
+//
+// Usage: centroid-linkage-benchmark [max_naive_count] [count...]
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "scipy_linkage.h"
+
+namespace {
+constexpr int kDimension = 128;
+constexpr int kSpeakerCount = 8;
+
+// Unit-length embeddings scattered around a few speaker centres, like the
+// row-normalized x-vectors VBx clusters.
+std::vector<double> make_embeddings(int count) {
+  uint32_t noise = 1;
+  auto next_uniform = [&noise]() {
+    noise = noise * 1664525u + 1013904223u;
+    return static_cast<double>(noise >> 8) / (1 << 24) - 0.5;
+  };
+  std::vector<double> centres(kSpeakerCount * kDimension);
+  for (double &value : centres) value = next_uniform();
+  std::vector<double> embeddings(static_cast<size_t>(count) * kDimension);
+  for (int i = 0; i < count; i++) {
+    const double *centre = &centres[(i % kSpeakerCount) * kDimension];
+    double *row = &embeddings[static_cast<size_t>(i) * kDimension];
+    double norm = 0.0;
+    for (int d = 0; d < kDimension; d++) {
+      row[d] = centre[d] + 0.3 * next_uniform();
+      norm += row[d] * row[d];
+    }
+    norm = std::sqrt(norm);
+    for (int d = 0; d < kDimension; d++) row[d] /= norm;
+  }
+  return embeddings;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  using namespace cppannote::scipy_linkage;
+  int max_naive_count = 2000;
+  std::vector<int> counts = {1000, 2000, 5000, 10000, 20000};
+  if (argc > 1) max_naive_count = atoi(argv[1]);
+  if (argc > 2) {
+    counts.clear();
+    for (int i = 2; i < argc; i++) counts.push_back(atoi(argv[i]));
+  }
+
+  printf("%d-dimensional embeddings, %d speakers\n\n", kDimension,
+         kSpeakerCount);
+  printf("%-10s %12s %14s %12s %10s\n", "count", "pdist s", "linkage s",
+         "naive s", "speedup");
+  for (const int count : counts) {
+    const std::vector<double> embeddings = make_embeddings(count);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> distances;
+    pdist_euclidean(embeddings, count, kDimension, distances);
+    const double pdist_seconds = seconds_since(start);
+
+    std::vector<double> naive_linkage;
+    double naive_seconds = 0.0;
+    const bool run_naive = count <= max_naive_count;
+    if (run_naive) {
+      start = std::chrono::steady_clock::now();
+      linkage_centroid_naive(distances, count, naive_linkage);
+      naive_seconds = seconds_since(start);
+    }
+
+    std::vector<double> linkage;
+    start = std::chrono::steady_clock::now();
+    linkage_centroid(std::move(distances), count, linkage);
+    const double linkage_seconds = seconds_since(start);
+
+    if (run_naive) {
+      printf("%-10d %12.3f %14.3f %12.3f %9.1fx\n", count, pdist_seconds,
+             linkage_seconds, naive_seconds, naive_seconds / linkage_seconds);
+      if (linkage.size() != naive_linkage.size() ||
+          memcmp(linkage.data(), naive_linkage.data(),
+                 linkage.size() * sizeof(double)) != 0) {
+        fprintf(stderr, "Linkage for %d embeddings differs from naive\n",
+                count);
+        return 1;
+      }
+    } else {
+      printf("%-10d %12.3f %14.3f %12s %10s\n", count, pdist_seconds,
+             linkage_seconds, "-", "-");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,326 @@
+#include "clustering_vbx.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpp-annote-engine.h"
+#include "plda_vbx.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest.h>
+
+using namespace cppannote;
+using namespace cppannote::clustering_vbx;
+
+namespace {
+
+constexpr int kDim = 128;
+constexpr int kLdaDim = 128;
+constexpr int kFrames = 10;
+constexpr int kLocalSpeakers = 3;
+
+// A small PLDA: the LDA keeps the first ``kLdaDim`` dimensions, and the
+// between-speaker variances fall off so the eigenvectors are well defined.
+plda_vbx::PldaModel synthetic_plda() {
+  const std::vector<double> mean1(kDim, 0.0);
+  const std::vector<float> mean2(kLdaDim, 0.0f);
+  std::vector<float> lda(kDim * kLdaDim, 0.0f);
+  for (int i = 0; i < kLdaDim; ++i) {
+    lda[i * kLdaDim + i] = 1.0f;
+  }
+  const std::vector<double> mu(kLdaDim, 0.0);
+  std::vector<double> tr(kLdaDim * kLdaDim, 0.0);
+  std::vector<double> psi(kLdaDim);
+  for (int i = 0; i < kLdaDim; ++i) {
+    tr[i * kLdaDim + i] = 1.0;
+    psi[i] = 2.0 - static_cast<double>(i) / kLdaDim;
+  }
+  plda_vbx::PldaModel plda;
+  plda.load_from_arrays(mean1.data(), kDim, mean2.data(), kLdaDim, lda.data(),
+                        kDim, kLdaDim, mu.data(), kLdaDim, tr.data(), kLdaDim,
+                        psi.data(), kLdaDim, kLdaDim);
+  return plda;
+}
+
+VbxClusteringParams synthetic_params() {
+  VbxClusteringParams params;
+  params.lda_dimension = kLdaDim;
+  return params;
+}
+
+// A recording as the streaming session sees it: in every chunk, local
+// speaker 0 talks for the first half, local speaker 1 for the second and
+// local speaker 2 is silent. ``speaker_of`` picks the voice of each active
+// local speaker; a chunk's embeddings only depend on its index, as they do
+// when a window slides over the same audio.
+class Recording {
+ public:
+  explicit Recording(int num_voices) {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    voices.resize(static_cast<size_t>(num_voices));
+    for (std::vector<float> &voice : voices) {
+      voice.resize(kDim);
+      for (float &v : voice) {
+        v = normal(rng);
+      }
+    }
+  }
+
+  // Voice 0 or 2 alternates on local speaker 0 every five chunks; voice 1 is
+  // always local speaker 1, unless ``late_voice`` takes over from
+  // ``late_chunk`` on.
+  int speaker_of(int chunk, int local) const {
+    if (local == 0) {
+      return (chunk / 5) % 2 == 0 ? 0 : 2;
+    }
+    return late_chunk >= 0 && chunk >= late_chunk ? late_voice : 1;
+  }
+
+  void embedding(int chunk, int local, float *out) const {
+    std::mt19937 rng(static_cast<uint32_t>(1000 + chunk * kLocalSpeakers +
+                                           local));
+    std::normal_distribution<float> noise(0.0f, 0.05f);
+    if (local == 2) {
+      for (int d = 0; d < kDim; ++d) {
+        out[d] = noise(rng);
+      }
+      return;
+    }
+    const std::vector<float> &voice =
+        voices[static_cast<size_t>(speaker_of(chunk, local))];
+    for (int d = 0; d < kDim; ++d) {
+      out[d] = voice[static_cast<size_t>(d)] + noise(rng);
+    }
+  }
+
+  std::vector<std::vector<float>> voices;
+  int late_chunk = -1;
+  int late_voice = 1;
+};
+
+// The chunks ``[first, first + count)`` of a recording, laid out for
+// ``vbx_clustering_hard``. Chunk keys are the chunk indices.
+struct Window {
+  int num_chunks = 0;
+  std::vector<float> embeddings;
+  std::vector<float> binarized;
+  std::vector<int64_t> keys;
+};
+
+Window make_window(const Recording &recording, int first, int count) {
+  Window window;
+  window.num_chunks = count;
+  window.embeddings.resize(static_cast<size_t>(count) * kLocalSpeakers * kDim);
+  window.binarized.assign(
+      static_cast<size_t>(count) * kFrames * kLocalSpeakers, 0.0f);
+  for (int c = 0; c < count; ++c) {
+    const int chunk = first + c;
+    window.keys.push_back(chunk);
+    for (int s = 0; s < kLocalSpeakers; ++s) {
+      recording.embedding(
+          chunk, s,
+          window.embeddings.data() + (c * kLocalSpeakers + s) * kDim);
+    }
+    for (int f = 0; f < kFrames; ++f) {
+      const int active = f < kFrames / 2 ? 0 : 1;
+      window.binarized[(c * kFrames + f) * kLocalSpeakers + active] = 1.0f;
+    }
+  }
+  return window;
+}
+
+std::vector<int8_t> cluster(const plda_vbx::PldaModel &plda,
+                            const Window &window,
+                            VbxWarmStart *warm_start = nullptr,
+                            VbxRunStats *stats = nullptr) {
+  std::vector<int8_t> hard;
+  vbx_clustering_hard(plda, synthetic_params(), window.num_chunks, kFrames,
+                      kLocalSpeakers, kDim, window.embeddings.data(),
+                      window.binarized.data(), hard,
+                      warm_start != nullptr ? window.keys.data() : nullptr,
+                      warm_start, stats);
+  return hard;
+}
+
+// True when ``a`` and ``b`` are the same clustering under some one-to-one
+// renaming of the clusters.
+bool same_up_to_relabelling(const std::vector<int8_t> &a,
+                            const std::vector<int8_t> &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  std::map<int8_t, int8_t> a_to_b;
+  std::map<int8_t, int8_t> b_to_a;
+  for (size_t i = 0; i < a.size(); ++i) {
+    const auto [ab, ab_new] = a_to_b.emplace(a[i], b[i]);
+    const auto [ba, ba_new] = b_to_a.emplace(b[i], a[i]);
+    if (ab->second != b[i] || ba->second != a[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int count_clusters(const std::vector<int8_t> &hard) {
+  std::map<int8_t, int> seen;
+  for (const int8_t h : hard) {
+    if (h >= 0) {
+      seen[h]++;
+    }
+  }
+  return static_cast<int>(seen.size());
+}
+
+}  // namespace
+
+TEST_CASE("vbx-warm-start-sliding-window-matches-cold-runs") {
+  const plda_vbx::PldaModel plda = synthetic_plda();
+  const Recording recording(3);
+  constexpr int kWindow = 20;
+  constexpr int kStep = 2;
+  constexpr int kTotal = 60;
+
+  VbxWarmStart warm;
+  DiarizationProfile total;
+  int refreshes = 0;
+  int warm_refreshes = 0;
+  int last_cold_iters = 0;
+  int expected_saved = 0;
+  for (int first = 0; first + kWindow <= kTotal; first += kStep) {
+    CAPTURE(first);
+    const Window window = make_window(recording, first, kWindow);
+    const std::vector<int8_t> cold = cluster(plda, window);
+    VbxRunStats stats;
+    const std::vector<int8_t> warmed = cluster(plda, window, &warm, &stats);
+    CHECK(count_clusters(cold) == 3);
+    CHECK(same_up_to_relabelling(warmed, cold));
+
+    // The first refresh has nothing to start from; the later ones only add
+    // a tenth of the rows, all of known voices.
+    CHECK(stats.warm_started == (first > 0));
+    CHECK(stats.iters > 0);
+    if (stats.warm_started) {
+      ++warm_refreshes;
+      CHECK(stats.cold_iters == last_cold_iters);
+      CHECK(stats.iters <= stats.cold_iters);
+      expected_saved += stats.cold_iters - stats.iters;
+    } else {
+      CHECK(stats.cold_iters == 0);
+      last_cold_iters = stats.iters;
+      CHECK(warm.cold_iters == stats.iters);
+    }
+
+    DiarizationProfile profile;
+    profile.set_vbx_run(stats);
+    CHECK(profile.vbx_iters == stats.iters);
+    total.accumulate(profile);
+    ++refreshes;
+  }
+  CHECK(warm_refreshes == refreshes - 1);
+  CHECK(total.vbx_warm_starts == warm_refreshes);
+  CHECK(total.vbx_iters_saved == expected_saved);
+  CHECK(expected_saved > 0);
+
+  std::ostringstream out;
+  total.print(out, "");
+  std::ostringstream saved;
+  saved << expected_saved << " saved by " << warm_refreshes << " warm starts";
+  CHECK(out.str().find(saved.str()) != std::string::npos);
+}
+
+TEST_CASE("vbx-warm-start-falls-back-to-ahc") {
+  const plda_vbx::PldaModel plda = synthetic_plda();
+  constexpr int kWindow = 20;
+
+  SUBCASE("over half of the rows were not in the last window") {
+    const Recording recording(3);
+    VbxWarmStart warm;
+    cluster(plda, make_window(recording, 0, kWindow), &warm);
+    VbxRunStats stats;
+    const Window window = make_window(recording, 11, kWindow);
+    const std::vector<int8_t> warmed = cluster(plda, window, &warm, &stats);
+    CHECK_FALSE(stats.warm_started);
+    CHECK(stats.cold_iters == 0);
+    CHECK(warm.cold_iters == stats.iters);
+    CHECK(same_up_to_relabelling(warmed, cluster(plda, window)));
+
+    // Exactly half is still close enough to start from.
+    VbxRunStats half;
+    cluster(plda, make_window(recording, 21, kWindow), &warm, &half);
+    CHECK(half.warm_started);
+  }
+
+  SUBCASE("an added row is beyond the threshold from every cluster") {
+    // Another voice takes over local speaker 1 in the second half of a window
+    // that is otherwise close enough to start from.
+    Recording recording(4);
+    recording.late_chunk = 20;
+    recording.late_voice = 3;
+    VbxWarmStart warm;
+    cluster(plda, make_window(recording, 0, kWindow), &warm);
+    VbxRunStats stats;
+    const Window window = make_window(recording, 10, kWindow);
+    const std::vector<int8_t> warmed = cluster(plda, window, &warm, &stats);
+    CHECK_FALSE(stats.warm_started);
+    CHECK(count_clusters(warmed) == 4);
+    CHECK(same_up_to_relabelling(warmed, cluster(plda, window)));
+
+    // Once that voice is part of the solution, refreshes warm-start
+    // again.
+    VbxRunStats next;
+    const Window after = make_window(recording, 12, kWindow);
+    const std::vector<int8_t> warmed_after =
+        cluster(plda, after, &warm, &next);
+    CHECK(next.warm_started);
+    CHECK(same_up_to_relabelling(warmed_after, cluster(plda, after)));
+  }
+
+  SUBCASE("an added row joins a cluster VBx folded into another") {
+    const Recording recording(3);
+    VbxWarmStart warm;
+    cluster(plda, make_window(recording, 0, kWindow), &warm);
+    VbxWarmStart untouched = warm;
+
+    // Split the last chunk's local speaker 1 off as its own AHC cluster. VBx
+    // keeps it with voice 1, whose other rows hold most of the mass, so the
+    // split cluster is folded into theirs.
+    const int64_t split_key = 19 * kLocalSpeakers + 1;
+    int next_cluster = 0;
+    for (const int label : warm.ahc_labels) {
+      next_cluster = std::max(next_cluster, label + 1);
+    }
+    bool split = false;
+    for (size_t r = 0; r < warm.row_keys.size(); ++r) {
+      if (warm.row_keys[r] == split_key) {
+        warm.ahc_labels[r] = next_cluster;
+        split = true;
+      }
+    }
+    REQUIRE(split);
+
+    // The next chunk repeats that row exactly, so the split cluster is the
+    // nearest.
+    Window window = make_window(recording, 2, kWindow);
+    const int from = (19 - 2) * kLocalSpeakers + 1;
+    const int to = (20 - 2) * kLocalSpeakers + 1;
+    std::copy(window.embeddings.begin() + from * kDim,
+              window.embeddings.begin() + (from + 1) * kDim,
+              window.embeddings.begin() + to * kDim);
+
+    VbxRunStats stats;
+    const std::vector<int8_t> warmed = cluster(plda, window, &warm, &stats);
+    CHECK_FALSE(stats.warm_started);
+    CHECK(same_up_to_relabelling(warmed, cluster(plda, window)));
+
+    // Without the split, the same window warm-starts.
+    VbxRunStats control;
+    cluster(plda, window, &untouched, &control);
+    CHECK(control.warm_started);
+  }
+}
@@ -0,0 +1,173 @@
+#include "cpp-annote-engine.h"
+
+#include <onnxruntime_cxx_api.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "community1_cpp_annote_embedded.h"
+#include "compute_fbank.h"
+#include "debug-utils.h"
+#include "embedding_ort_infer.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest.h>
+
+namespace {
+
+// The diarization models ship as a download (docs/diarization-models.md);
+// the tests run from test-assets, which holds a copy.
+const std::filesystem::path kDiarizationModelDir = "diarization";
+
+std::vector<float> load_fixture_audio() {
+  float *wav_data = nullptr;
+  size_t wav_data_size = 0;
+  int32_t wav_sample_rate = 0;
+  REQUIRE(load_wav_data("two_cities_16k.wav", &wav_data, &wav_data_size,
+                        &wav_sample_rate));
+  REQUIRE(wav_sample_rate == 16000);
+  std::vector<float> audio(wav_data, wav_data + wav_data_size);
+  std::free(wav_data);
+  return audio;
+}
+
+// Largest element-wise difference relative to the reference's largest
+// magnitude, so embeddings of any scale compare alike.
+float relative_difference(const float *actual, const float *expected,
+                          size_t size) {
+  float max_diff = 0.0f;
+  float max_abs = 0.0f;
+  for (size_t i = 0; i < size; ++i) {
+    max_diff = std::max(max_diff, std::abs(actual[i] - expected[i]));
+    max_abs = std::max(max_abs, std::abs(expected[i]));
+  }
+  return max_abs > 0.0f ? max_diff / max_abs : max_diff;
+}
+
+}  // namespace
+
+TEST_CASE("embedding-batch-matches-single-rows") {
+  namespace eo = cppannote::embedding_ort;
+  REQUIRE(std::filesystem::exists(kDiarizationModelDir));
+  const std::filesystem::path model_path =
+      kDiarizationModelDir / "embedding.ort";
+  Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "cpp-annote-engine-test");
+  Ort::SessionOptions options;
+  Ort::Session dynamic_session(env, model_path.c_str(), options);
+  Ort::MemoryInfo mem =
+      Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+  Ort::AllocatorWithDefaultOptions alloc;
+  REQUIRE(eo::session_has_dynamic_batch(dynamic_session));
+  CHECK(eo::embedding_batch_limit(dynamic_session, 16) == 16);
+  CHECK(eo::embedding_batch_limit(dynamic_session, 0) == 1);
+
+  // Two seconds from a different place in the clip for each row, with the
+  // same frame count so the rows stack.
+  const std::vector<float> audio = load_fixture_audio();
+  constexpr int kRows = 5;
+  constexpr int kRowSamples = 2 * 16000;
+  REQUIRE(audio.size() >= static_cast<size_t>(kRows * kRowSamples));
+  std::vector<float> fbanks;
+  int frames = 0;
+  int mel_bins = 0;
+  for (int r = 0; r < kRows; ++r) {
+    std::vector<float> fbank;
+    cppannote::fbank::wespeaker_like_fbank(16000.0f, 80, 25.0f, 10.0f,
+                                           audio.data() + r * kRowSamples,
+                                           kRowSamples, fbank, frames,
+                                           mel_bins);
+    fbanks.insert(fbanks.end(), fbank.begin(), fbank.end());
+  }
+  REQUIRE(frames > 0);
+  // Each row weights its frames differently, so a row paired with another
+  // row's weights shows up.
+  std::vector<float> weights(static_cast<size_t>(kRows) * frames);
+  for (int r = 0; r < kRows; ++r) {
+    for (int t = 0; t < frames; ++t) {
+      weights[static_cast<size_t>(r) * frames + t] =
+          (t + r) % (r + 2) == 0 ? 0.0f : 1.0f;
+    }
+  }
+  const int dim = static_cast<int>(dynamic_session.GetOutputTypeInfo(0)
+                                       .GetTensorTypeAndShapeInfo()
+                                       .GetShape()
+                                       .back());
+  REQUIRE(dim > 0);
+  const size_t fbank_size = static_cast<size_t>(frames) * mel_bins;
+
+  const bool fbank_first = eo::embedding_json_inputs_fbank_first(
+      std::string(cppannote::embedded_community1::embedding_json,
+                  cppannote::embedded_community1::embedding_json_size));
+  std::vector<float> batched(static_cast<size_t>(kRows) * dim);
+  eo::run_embedding_ort_batch(dynamic_session, mem, alloc, fbank_first,
+                              fbanks.data(), frames, mel_bins, weights.data(),
+                              frames, kRows, batched.data(), dim);
+  std::vector<float> single(static_cast<size_t>(kRows) * dim);
+  for (int r = 0; r < kRows; ++r) {
+    eo::run_embedding_ort(dynamic_session, mem, alloc, fbank_first,
+                          fbanks.data() + r * fbank_size, frames, mel_bins,
+                          weights.data() + static_cast<size_t>(r) * frames,
+                          frames, single.data() + static_cast<size_t>(r) * dim,
+                          dim);
+  }
+  for (int r = 0; r < kRows; ++r) {
+    CAPTURE(r);
+    CHECK(relative_difference(batched.data() + static_cast<size_t>(r) * dim,
+                              single.data() + static_cast<size_t>(r) * dim,
+                              static_cast<size_t>(dim)) < 1e-4f);
+  }
+
+  SUBCASE("fixed-batch-model-runs-one-row-at-a-time") {
+    // Pinning the symbolic batch dimension to 1 gives the same model with a
+    // fixed batch, as some exporters produce it.
+    Ort::SessionOptions fixed_options;
+    for (size_t i = 0; i < dynamic_session.GetInputCount(); ++i) {
+      const std::vector<const char *> dims =
+          dynamic_session.GetInputTypeInfo(i)
+              .GetTensorTypeAndShapeInfo()
+              .GetSymbolicDimensions();
+      if (dims.empty() || dims[0] == nullptr || *dims[0] == '\0') {
+        MESSAGE("embedding model's batch dimension is unnamed, skipping");
+        return;
+      }
+      Ort::ThrowOnError(Ort::GetApi().AddFreeDimensionOverrideByName(
+          fixed_options, dims[0], 1));
+    }
+    Ort::Session fixed_session(env, model_path.c_str(), fixed_options);
+    CHECK_FALSE(eo::session_has_dynamic_batch(fixed_session));
+    CHECK(eo::embedding_batch_limit(fixed_session, 16) == 1);
+    for (int r = 0; r < kRows; ++r) {
+      CAPTURE(r);
+      std::vector<float> fixed(static_cast<size_t>(dim));
+      eo::run_embedding_ort_batch(
+          fixed_session, mem, alloc, fbank_first,
+          fbanks.data() + r * fbank_size, frames, mel_bins,
+          weights.data() + static_cast<size_t>(r) * frames, frames, 1,
+          fixed.data(), dim);
+      CHECK(relative_difference(fixed.data(),
+                                single.data() + static_cast<size_t>(r) * dim,
+                                static_cast<size_t>(dim)) < 1e-4f);
+    }
+  }
+}
+
+TEST_CASE("diarization-profile-prints-one-line-per-batch-size") {
+  cppannote::DiarizationProfile profile;
+  for (int i = 0; i < 1000; ++i) {
+    profile.add_embedding_batch(16, 0.001);
+  }
+  profile.add_embedding_batch(7, 0.5);
+  std::ostringstream out;
+  profile.print(out, "");
+  const std::string text = out.str();
+  CHECK(text.find("embedding batches of 16 rows: 1000, 1.000s") !=
+        std::string::npos);
+  CHECK(text.find("embedding batches of 7 rows: 1, 0.500s") !=
+        std::string::npos);
+  CHECK(std::count(text.begin(), text.end(), '\n') == 9);
+}
@@ -0,0 +1,129 @@
+#include "cpp-annote-streaming.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "cpp-annote-engine.h"
+#include "debug-utils.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest.h>
+
+namespace {
+
+// The diarization models ship as a download (docs/diarization-models.md);
+// the tests run from test-assets, which holds a copy.
+constexpr const char *kDiarizationModelDir = "diarization";
+
+cppannote::ModelSources diarization_models() {
+  const std::filesystem::path dir(kDiarizationModelDir);
+  cppannote::ModelSources models;
+  models.segmentation.path = (dir / "segmentation.ort").string();
+  models.embedding.path = (dir / "embedding.ort").string();
+  return models;
+}
+
+// two_cities_16k.wav repeated to ``seconds`` of 16 kHz audio.
+std::vector<float> looped_fixture_audio(double seconds) {
+  float *wav_data = nullptr;
+  size_t wav_data_size = 0;
+  int32_t wav_sample_rate = 0;
+  REQUIRE(load_wav_data("two_cities_16k.wav", &wav_data, &wav_data_size,
+                        &wav_sample_rate));
+  REQUIRE(wav_sample_rate == 16000);
+  std::vector<float> audio(static_cast<size_t>(seconds * wav_sample_rate));
+  for (size_t i = 0; i < audio.size(); ++i) {
+    audio[i] = wav_data[i % wav_data_size];
+  }
+  std::free(wav_data);
+  return audio;
+}
+
+// Appends ``audio`` in ``append_samples`` pieces to a new session and drains
+// it with end_session.
+cppannote::StreamingDiarizationSnapshot diarize(
+    cppannote::CppAnnoteEngine &engine, const std::vector<float> &audio,
+    size_t append_samples, int analysis_threads,
+    int64_t *peak_fbank_frame_count) {
+  cppannote::StreamingDiarizationConfig config;
+  config.analysis_threads = analysis_threads;
+  cppannote::StreamingDiarizationSession session(engine, config);
+  session.start_session();
+  for (size_t i = 0; i < audio.size(); i += append_samples) {
+    session.add_audio_chunk(audio.data() + i,
+                            std::min(append_samples, audio.size() - i), 16000);
+  }
+  cppannote::StreamingDiarizationSnapshot snapshot = session.end_session();
+  *peak_fbank_frame_count = session.peak_fbank_frame_count();
+  return snapshot;
+}
+
+}  // namespace
+
+TEST_CASE("streaming-diarization-drains-backlog-in-bounded-memory") {
+  REQUIRE(std::filesystem::exists(kDiarizationModelDir));
+  cppannote::CppAnnoteEngine engine(diarization_models());
+  cppannote::StreamingDiarizationSession session(engine);
+  session.start_session();
+
+  // Half-minute appends analyze one window each, so nearly all of the four
+  // minutes is left for end_session to drain.
+  const double total_sec = 240.0;
+  const std::vector<float> audio = looped_fixture_audio(total_sec);
+  const size_t append = 30 * 16000;
+  for (size_t i = 0; i < audio.size(); i += append) {
+    session.add_audio_chunk(audio.data() + i,
+                            std::min(append, audio.size() - i), 16000);
+  }
+  const cppannote::StreamingDiarizationSnapshot snapshot =
+      session.end_session();
+  CHECK(!snapshot.turns.empty());
+  CHECK(snapshot.input_end_sec == doctest::Approx(total_sec));
+
+  // The fbank cache only has to cover the windows being analyzed together,
+  // not everything still waiting in the buffer.
+  const double peak_sec =
+      static_cast<double>(session.peak_fbank_frame_count()) *
+      engine.embedding_fbank_frame_shift_samples() /
+      engine.segmentation_model_sample_rate();
+  MESSAGE("peak fbank cache: " << peak_sec << " s of " << total_sec << " s");
+  CHECK(peak_sec > 0.0);
+  CHECK(peak_sec < 60.0);
+}
+
+TEST_CASE("streaming-diarization-turns-do-not-depend-on-threads") {
+  REQUIRE(std::filesystem::exists(kDiarizationModelDir));
+  cppannote::CppAnnoteEngine engine(diarization_models());
+  // One append, as one-shot diarization does, so end_session drains the
+  // whole recording on the analysis threads.
+  const double total_sec = 240.0;
+  const std::vector<float> audio = looped_fixture_audio(total_sec);
+  int64_t single_peak = 0;
+  const cppannote::StreamingDiarizationSnapshot single =
+      diarize(engine, audio, audio.size(), 1, &single_peak);
+  int64_t threaded_peak = 0;
+  const cppannote::StreamingDiarizationSnapshot threaded =
+      diarize(engine, audio, audio.size(), 2, &threaded_peak);
+
+  REQUIRE(!single.turns.empty());
+  REQUIRE(threaded.turns.size() == single.turns.size());
+  for (size_t i = 0; i < single.turns.size(); ++i) {
+    CAPTURE(i);
+    CHECK(threaded.turns[i].start == single.turns[i].start);
+    CHECK(threaded.turns[i].end == single.turns[i].end);
+    CHECK(threaded.turns[i].speaker == single.turns[i].speaker);
+  }
+
+  // The threads drain the backlog in rounds too, so their fbank cache stays
+  // bounded like the sequential one.
+  const double threaded_peak_sec =
+      static_cast<double>(threaded_peak) *
+      engine.embedding_fbank_frame_shift_samples() /
+      engine.segmentation_model_sample_rate();
+  MESSAGE("peak fbank cache with 2 threads: " << threaded_peak_sec << " s");
+  CHECK(threaded_peak_sec > 0.0);
+  CHECK(threaded_peak_sec < 60.0);
+}
@@ -10,6 +10,8 @@
 #include <random>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_map>
+#include <utility>
 
 #include "filter_train.h"
 #include "hungarian.h"
@@ -161,13 +163,122 @@ void hungarian_maximize(const Eigen::MatrixXd& score,
   }
 }
 
+// Seeds VBx from the previous refresh. Carried rows keep their
+// responsibilities and AHC cluster; each new row joins the AHC cluster with
+// the nearest centroid and starts from that cluster's mean responsibilities.
+// Returns false, leaving AHC to initialize, when the speaker count could
+// change: most rows are new, a new row is further than ``threshold`` from
+// every cluster centroid (AHC would keep it apart), or it joins a cluster
+// VBx folded into another cluster's speaker (which may now hold its own).
+bool seed_from_warm_start(const VbxWarmStart& warm,
+                          const std::vector<std::int64_t>& row_keys,
+                          const Eigen::MatrixXd& train_n, double threshold,
+                          Eigen::MatrixXd& gamma, Eigen::VectorXd& pi,
+                          std::vector<int>& ahc_labels) {
+  const int T = static_cast<int>(train_n.rows());
+  const int S = static_cast<int>(warm.pi.size());
+  if (S <= 0 || warm.gamma.cols() != S) {
+    return false;
+  }
+  std::unordered_map<std::int64_t, int> prev_row;
+  prev_row.reserve(warm.row_keys.size());
+  for (std::size_t i = 0; i < warm.row_keys.size(); ++i) {
+    prev_row.emplace(warm.row_keys[i], static_cast<int>(i));
+  }
+  std::vector<int> carried(static_cast<std::size_t>(T), -1);
+  int num_carried = 0;
+  int num_clusters = 0;
+  for (int t = 0; t < T; ++t) {
+    auto it = prev_row.find(row_keys[static_cast<std::size_t>(t)]);
+    if (it != prev_row.end()) {
+      carried[static_cast<std::size_t>(t)] = it->second;
+      ++num_carried;
+      num_clusters = std::max(
+          num_clusters,
+          warm.ahc_labels[static_cast<std::size_t>(it->second)] + 1);
+    }
+  }
+  if (2 * num_carried < T) {
+    return false;
+  }
+
+  // Centroids and mean responsibilities of the carried rows of each AHC
+  // cluster, in the normalized space ``threshold`` applies to.
+  Eigen::MatrixXd centroids =
+      Eigen::MatrixXd::Zero(num_clusters, train_n.cols());
+  Eigen::MatrixXd cluster_gamma = Eigen::MatrixXd::Zero(num_clusters, S);
+  std::vector<int> counts(static_cast<std::size_t>(num_clusters), 0);
+  for (int t = 0; t < T; ++t) {
+    const int r = carried[static_cast<std::size_t>(t)];
+    if (r < 0) {
+      continue;
+    }
+    const int c = warm.ahc_labels[static_cast<std::size_t>(r)];
+    centroids.row(c) += train_n.row(t);
+    cluster_gamma.row(c) += warm.gamma.row(r);
+    ++counts[static_cast<std::size_t>(c)];
+  }
+  // The cluster holding most of each speaker's mass; the others VBx folded
+  // into that speaker.
+  std::vector<int> owner(static_cast<std::size_t>(S), -1);
+  for (int k = 0; k < S; ++k) {
+    Eigen::Index c = 0;
+    cluster_gamma.col(k).maxCoeff(&c);
+    owner[static_cast<std::size_t>(k)] = static_cast<int>(c);
+  }
+  for (int c = 0; c < num_clusters; ++c) {
+    if (counts[static_cast<std::size_t>(c)] > 0) {
+      centroids.row(c) /= counts[static_cast<std::size_t>(c)];
+      cluster_gamma.row(c) /= counts[static_cast<std::size_t>(c)];
+    }
+  }
+
+  gamma.resize(T, S);
+  ahc_labels.assign(static_cast<std::size_t>(T), 0);
+  for (int t = 0; t < T; ++t) {
+    const int r = carried[static_cast<std::size_t>(t)];
+    if (r >= 0) {
+      gamma.row(t) = warm.gamma.row(r);
+      ahc_labels[static_cast<std::size_t>(t)] =
+          warm.ahc_labels[static_cast<std::size_t>(r)];
+      continue;
+    }
+    double best = std::numeric_limits<double>::infinity();
+    int best_c = -1;
+    for (int c = 0; c < num_clusters; ++c) {
+      if (counts[static_cast<std::size_t>(c)] == 0) {
+        continue;
+      }
+      const double d = (train_n.row(t) - centroids.row(c)).norm();
+      if (d < best) {
+        best = d;
+        best_c = c;
+      }
+    }
+    if (best_c < 0 || best > threshold) {
+      return false;
+    }
+    Eigen::Index speaker = 0;
+    cluster_gamma.row(best_c).maxCoeff(&speaker);
+    if (owner[static_cast<std::size_t>(speaker)] != best_c) {
+      return false;
+    }
+    gamma.row(t) = cluster_gamma.row(best_c);
+    ahc_labels[static_cast<std::size_t>(t)] = best_c;
+  }
+  pi = warm.pi;
+  return true;
+}
+
 }  // namespace
 
 void vbx_clustering_hard(const plda_vbx::PldaModel& plda,
                          const VbxClusteringParams& pr, int num_chunks,
                          int num_frames, int num_speakers, int dim,
                          const float* embeddings, const float* binarized,
-                         std::vector<std::int8_t>& hard_clusters) {
+                         std::vector<std::int8_t>& hard_clusters,
+                         const std::int64_t* chunk_keys,
+                         VbxWarmStart* warm_start, VbxRunStats* stats) {
   hard_clusters.assign(static_cast<std::size_t>(num_chunks * num_speakers), 0);
   std::vector<int> c_idx;
   std::vector<int> s_idx;
@@ -184,26 +295,26 @@ void vbx_clustering_hard(const plda_vbx::PldaModel& plda,
           << " dim=" << dim;
       parity::log_light(oss.str());
     }
+    if (warm_start != nullptr) {
+      warm_start->clear();
+    }
     return;
   }
+  if (chunk_keys == nullptr) {
+    warm_start = nullptr;
+  }
+  std::vector<std::int64_t> row_keys;
+  if (warm_start != nullptr) {
+    row_keys.resize(static_cast<std::size_t>(T));
+    for (int t = 0; t < T; ++t) {
+      row_keys[static_cast<std::size_t>(t)] =
+          chunk_keys[c_idx[static_cast<std::size_t>(t)]] * num_speakers +
+          s_idx[static_cast<std::size_t>(t)];
+    }
+  }
 
   Eigen::MatrixXd train_n = train;
   row_normalize(train_n);
-  std::vector<double> xflat(
-      static_cast<std::size_t>(train_n.rows() * train_n.cols()));
-  for (int i = 0; i < train_n.rows(); ++i) {
-    for (int j = 0; j < train_n.cols(); ++j) {
-      xflat[static_cast<std::size_t>(i * train_n.cols() + j)] = train_n(i, j);
-    }
-  }
-  std::vector<double> pd;
-  scipy_linkage::pdist_euclidean(xflat, T, dim, pd);
-  std::vector<double> Z;
-  scipy_linkage::linkage_centroid_naive(pd, T, Z);
-  std::vector<int> fc;
-  scipy_linkage::fcluster_distance(Z, T, pr.threshold, fc);
-  std::vector<int> ahc;
-  scipy_linkage::remap_labels_contiguous(fc, ahc);
 
   Eigen::MatrixXd fea = plda(train);
   Eigen::VectorXd Phi = plda.phi_between;
@@ -217,9 +328,40 @@ void vbx_clustering_hard(const plda_vbx::PldaModel& plda,
   Eigen::VectorXd sp_pi;
   int vbx_iters_done = 0;
   double vbx_last_elbo_delta = 0.0;
-  plda_vbx::cluster_vbx(ahc, fea, Phi, pr.Fa, pr.Fb, pr.max_vbx_iters,
-                        pr.init_smoothing, q, sp_pi, 1e-4, nullptr, nullptr,
-                        &vbx_iters_done, &vbx_last_elbo_delta);
+  std::vector<int> ahc;
+  const bool warm =
+      warm_start != nullptr && !warm_start->empty() &&
+      seed_from_warm_start(*warm_start, row_keys, train_n, pr.threshold, q,
+                           sp_pi, ahc);
+  if (warm) {
+    plda_vbx::vbx_iterate(fea, Phi, pr.Fa, pr.Fb, pr.max_vbx_iters, q, sp_pi,
+                          1e-4, nullptr, nullptr, &vbx_iters_done,
+                          &vbx_last_elbo_delta);
+  } else {
+    std::vector<double> xflat(
+        static_cast<std::size_t>(train_n.rows() * train_n.cols()));
+    for (int i = 0; i < train_n.rows(); ++i) {
+      for (int j = 0; j < train_n.cols(); ++j) {
+        xflat[static_cast<std::size_t>(i * train_n.cols() + j)] =
+            train_n(i, j);
+      }
+    }
+    std::vector<double> pd;
+    scipy_linkage::pdist_euclidean(xflat, T, dim, pd);
+    std::vector<double> Z;
+    scipy_linkage::linkage_centroid(std::move(pd), T, Z);
+    std::vector<int> fc;
+    scipy_linkage::fcluster_distance(Z, T, pr.threshold, fc);
+    scipy_linkage::remap_labels_contiguous(fc, ahc);
+    plda_vbx::cluster_vbx(ahc, fea, Phi, pr.Fa, pr.Fb, pr.max_vbx_iters,
+                          pr.init_smoothing, q, sp_pi, 1e-4, nullptr, nullptr,
+                          &vbx_iters_done, &vbx_last_elbo_delta);
+  }
+  if (stats != nullptr) {
+    stats->iters = vbx_iters_done;
+    stats->warm_started = warm;
+    stats->cold_iters = warm ? warm_start->cold_iters : 0;
+  }
   std::vector<int> keep_cols;
   for (int j = 0; j < sp_pi.size(); ++j) {
     if (sp_pi(j) > 1e-7) {
@@ -230,6 +372,22 @@ void vbx_clustering_hard(const plda_vbx::PldaModel& plda,
   if (Kvb <= 0) {
     throw std::runtime_error("VBx produced no speakers");
   }
+  if (warm_start != nullptr) {
+    // Only live speakers are carried; their priors are renormalized.
+    warm_start->row_keys = std::move(row_keys);
+    warm_start->ahc_labels = std::move(ahc);
+    warm_start->gamma.resize(T, Kvb);
+    warm_start->pi.resize(Kvb);
+    for (int j = 0; j < Kvb; ++j) {
+      const int col = keep_cols[static_cast<std::size_t>(j)];
+      warm_start->gamma.col(j) = q.col(col);
+      warm_start->pi(j) = sp_pi(col);
+    }
+    warm_start->pi /= warm_start->pi.sum();
+    if (!warm) {
+      warm_start->cold_iters = vbx_iters_done;
+    }
+  }
   Eigen::MatrixXd W(T, Kvb);
   for (int t = 0; t < T; ++t) {
     for (int j = 0; j < Kvb; ++j) {
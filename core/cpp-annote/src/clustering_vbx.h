@@ -5,6 +5,7 @@
 #ifndef CLUSTERING_VBX_H_
 #define CLUSTERING_VBX_H_
 
+#include <Eigen/Dense>
 #include <cstdint>
 #include <vector>
 
@@ -29,13 +30,48 @@ struct VbxClusteringParams {
       -1;  // optional forced count (``num_speakers``); -1 = unset
 };
 
+/// The VBx solution of the previous call over an overlapping window, kept by
+/// a streaming session to warm-start the next refresh.  Training rows are
+/// identified by ``chunk_key * num_speakers + local speaker``.
+struct VbxWarmStart {
+  std::vector<std::int64_t> row_keys;
+  /// Each row's cluster from the last AHC, extended to rows added since.
+  std::vector<int> ahc_labels;
+  Eigen::MatrixXd gamma;  // (rows, speakers) responsibilities
+  Eigen::VectorXd pi;     // (speakers) priors
+  /// Iterations of the last run initialized from AHC.
+  int cold_iters = 0;
+
+  bool empty() const { return row_keys.empty(); }
+  void clear() { *this = VbxWarmStart{}; }
+};
+
+struct VbxRunStats {
+  int iters = 0;
+  bool warm_started = false;
+  /// ``VbxWarmStart::cold_iters`` when this run was warm-started.
+  int cold_iters = 0;
+};
+
 /// ``embeddings`` row-major ``(num_chunks * num_speakers * dim)``;
 /// ``binarized`` ``(num_chunks * num_frames * num_speakers)``.
+///
+/// With ``chunk_keys`` (a stable id per chunk, such as its absolute sample
+/// offset) and a non-empty ``warm_start``, AHC is skipped and VBx starts from
+/// the previous responsibilities and priors, each new row joining the
+/// previous AHC cluster with the nearest centroid.  AHC still runs when the
+/// speaker count could change: over half the rows are new, or a new row is
+/// further than ``threshold`` from every cluster or joins one VBx folded into
+/// another cluster's speaker.  ``warm_start`` is updated with this call's
+/// solution either way.
 void vbx_clustering_hard(const plda_vbx::PldaModel& plda,
                          const VbxClusteringParams& pr, int num_chunks,
                          int num_frames, int num_speakers, int dim,
                          const float* embeddings, const float* binarized,
-                         std::vector<std::int8_t>& hard_clusters);
+                         std::vector<std::int8_t>& hard_clusters,
+                         const std::int64_t* chunk_keys = nullptr,
+                         VbxWarmStart* warm_start = nullptr,
+                         VbxRunStats* stats = nullptr);
 
 }  // namespace cppannote::clustering_vbx
 
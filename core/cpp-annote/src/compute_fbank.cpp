@@ -15,6 +15,17 @@ void wespeaker_like_fbank(float sample_hz, int num_mel_bins,
                           const float* mono, int num_samples,
                           std::vector<float>& out_rowmajor, int& num_frames,
                           int& mel_dim_out) {
+  wespeaker_like_fbank_frames(sample_hz, num_mel_bins, frame_length_ms,
+                              frame_shift_ms, mono, num_samples, out_rowmajor,
+                              num_frames, mel_dim_out);
+  subtract_fbank_mean(out_rowmajor, num_frames, mel_dim_out);
+}
+
+void wespeaker_like_fbank_frames(float sample_hz, int num_mel_bins,
+                                 float frame_length_ms, float frame_shift_ms,
+                                 const float* mono, int num_samples,
+                                 std::vector<float>& out_rowmajor,
+                                 int& num_frames, int& mel_dim_out) {
   knf::FbankOptions opts;
   opts.frame_opts.samp_freq = sample_hz;
   opts.frame_opts.frame_length_ms = frame_length_ms;
@@ -54,22 +65,32 @@ void wespeaker_like_fbank(float sample_hz, int num_mel_bins,
                               static_cast<std::size_t>(mel_dim_out)],
                 row, static_cast<std::size_t>(mel_dim_out) * sizeof(float));
   }
-  for (int m = 0; m < mel_dim_out; ++m) {
+}
+
+void subtract_fbank_mean(std::vector<float>& rowmajor, int num_frames,
+                         int mel_dim) {
+  for (int m = 0; m < mel_dim; ++m) {
     double sum = 0.0;
     for (int t = 0; t < num_frames; ++t) {
       sum += static_cast<double>(
-          out_rowmajor[static_cast<std::size_t>(t) *
-                           static_cast<std::size_t>(mel_dim_out) +
-                       static_cast<std::size_t>(m)]);
+          rowmajor[static_cast<std::size_t>(t) *
+                       static_cast<std::size_t>(mel_dim) +
+                   static_cast<std::size_t>(m)]);
     }
     const float mean =
         static_cast<float>(sum / static_cast<double>(std::max(1, num_frames)));
     for (int t = 0; t < num_frames; ++t) {
-      out_rowmajor[static_cast<std::size_t>(t) *
-                       static_cast<std::size_t>(mel_dim_out) +
-                   static_cast<std::size_t>(m)] -= mean;
+      rowmajor[static_cast<std::size_t>(t) * static_cast<std::size_t>(mel_dim) +
+               static_cast<std::size_t>(m)] -= mean;
     }
   }
 }
 
+int fbank_window_samples(float sample_hz, float window_ms) {
+  knf::FrameExtractionOptions opts;
+  opts.samp_freq = sample_hz;
+  opts.frame_length_ms = window_ms;
+  return static_cast<int>(opts.WindowSize());
+}
+
 }  // namespace cppannote::fbank
@@ -19,6 +19,24 @@ void wespeaker_like_fbank(float sample_hz, int num_mel_bins,
                           std::vector<float>& out_rowmajor, int& num_frames,
                           int& mel_dim_out);
 
+/// ``wespeaker_like_fbank`` without the mean subtraction. With
+/// ``snip_edges`` every frame only depends on its own window of samples, so
+/// frames computed from any run of audio starting on a frame boundary match
+/// the ones a longer run would produce there.
+void wespeaker_like_fbank_frames(float sample_hz, int num_mel_bins,
+                                 float frame_length_ms, float frame_shift_ms,
+                                 const float* mono, int num_samples,
+                                 std::vector<float>& out_rowmajor,
+                                 int& num_frames, int& mel_dim_out);
+
+/// Per-mel mean subtraction over the ``num_frames`` rows of
+/// ``rowmajor``, as applied by ``wespeaker_like_fbank``.
+void subtract_fbank_mean(std::vector<float>& rowmajor, int num_frames,
+                         int mel_dim);
+
+/// Window length and shift in samples, rounded the way the fbank rounds them.
+int fbank_window_samples(float sample_hz, float window_ms);
+
 }  // namespace cppannote::fbank
 
 #endif  // COMPUTE_FBANK_H_
@@ -7,11 +7,14 @@
 
 #include <onnxruntime_cxx_api.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "clustering_vbx.h"
@@ -20,41 +23,129 @@
 
 namespace cppannote {
 
+/// CPU seconds used so far by the whole process, across all of its threads
+/// (including ONNX Runtime's thread pools).
+double process_cpu_sec();
+
 struct DiarizationProfile {
+  /// One embedding ORT run: how many (chunk, speaker) rows it stacked and
+  /// how long the run took.
+  struct EmbeddingBatch {
+    int rows = 0;
+    double ort_sec = 0.;
+  };
+
   int total_chunks = 0;
   int num_frames = 0;
   int num_classes = 0;
+  /// Wall-clock seconds per stage. When windows are analyzed on several
+  /// threads these are the spans of each parallel stage, not sums over the
+  /// threads.
   double segmentation_ort_sec = 0.;
+  double fbank_sec = 0.;
   double embedding_ort_sec = 0.;
   double clustering_vbx_sec = 0.;
   double reconstruct_sec = 0.;
   double total_sec = 0.;
+  /// Process CPU seconds (``process_cpu_sec``) spent during each stage.
+  double segmentation_cpu_sec = 0.;
+  double fbank_cpu_sec = 0.;
+  double embedding_cpu_sec = 0.;
+  double clustering_vbx_cpu_sec = 0.;
+  double reconstruct_cpu_sec = 0.;
+  double total_cpu_sec = 0.;
+  /// Embedding runs behind ``embedding_ort_sec``. ``accumulate`` only sums
+  /// the counts below, so long sessions don't keep every batch.
+  std::vector<EmbeddingBatch> embedding_batches;
+  int embedding_batch_count = 0;
+  int embedding_rows = 0;
+  /// VBx iterations run, and how many fewer than the last AHC-initialized
+  /// run needed when the refresh was warm-started from the previous one.
+  int vbx_iters = 0;
+  int vbx_warm_starts = 0;
+  int vbx_iters_saved = 0;
+
+  /// Records the iteration counts of one ``vbx_clustering_hard`` run.
+  void set_vbx_run(const clustering_vbx::VbxRunStats& stats) {
+    vbx_iters = stats.iters;
+    vbx_warm_starts = stats.warm_started ? 1 : 0;
+    vbx_iters_saved =
+        stats.warm_started ? std::max(0, stats.cold_iters - stats.iters) : 0;
+  }
+
+  void add_embedding_batch(int rows, double ort_sec) {
+    embedding_batches.push_back(EmbeddingBatch{rows, ort_sec});
+    embedding_ort_sec += ort_sec;
+    ++embedding_batch_count;
+    embedding_rows += rows;
+  }
 
   void print(std::ostream& os, const char* prefix = "  ") const {
-    char buf[512];
-    std::snprintf(buf, sizeof(buf),
-                  "%s%d chunks, %d frames, %d classes\n"
-                  "%ssegmentation_ort: %.3fs\n"
-                  "%sembedding_ort:    %.3fs\n"
-                  "%sclustering_vbx:   %.3fs\n"
-                  "%sreconstruct:      %.3fs\n"
-                  "%stotal:            %.3fs\n",
-                  prefix, total_chunks, num_frames, num_classes, prefix,
-                  segmentation_ort_sec, prefix, embedding_ort_sec, prefix,
-                  clustering_vbx_sec, prefix, reconstruct_sec, prefix,
-                  total_sec);
+    char buf[896];
+    std::snprintf(
+        buf, sizeof(buf),
+        "%s%d chunks, %d frames, %d classes\n"
+        "%ssegmentation_ort: %.3fs (cpu %.3fs)\n"
+        "%sfbank:            %.3fs (cpu %.3fs)\n"
+        "%sembedding_ort:    %.3fs (cpu %.3fs, %d rows in %d batches)\n"
+        "%sclustering_vbx:   %.3fs (cpu %.3fs, %d iterations, %d saved by "
+        "%d warm starts)\n"
+        "%sreconstruct:      %.3fs (cpu %.3fs)\n"
+        "%stotal:            %.3fs (cpu %.3fs)\n",
+        prefix, total_chunks, num_frames, num_classes, prefix,
+        segmentation_ort_sec, segmentation_cpu_sec, prefix, fbank_sec,
+        fbank_cpu_sec, prefix, embedding_ort_sec, embedding_cpu_sec,
+        embedding_rows, embedding_batch_count, prefix, clustering_vbx_sec,
+        clustering_vbx_cpu_sec, vbx_iters, vbx_iters_saved, vbx_warm_starts,
+        prefix, reconstruct_sec, reconstruct_cpu_sec,
+        prefix, total_sec, total_cpu_sec);
     os << buf;
+    // One line per batch size rather than per run, which a long session
+    // would otherwise turn into thousands of lines.
+    std::map<int, std::pair<int, double>> runs_by_rows;  // (runs, seconds)
+    for (const EmbeddingBatch& batch : embedding_batches) {
+      std::pair<int, double>& runs = runs_by_rows[batch.rows];
+      ++runs.first;
+      runs.second += batch.ort_sec;
+    }
+    for (const auto& [rows, runs] : runs_by_rows) {
+      std::snprintf(buf, sizeof(buf),
+                    "%s  embedding batches of %d rows: %d, %.3fs\n", prefix,
+                    rows, runs.first, runs.second);
+      os << buf;
+    }
   }
 
   void accumulate(const DiarizationProfile& o) {
     segmentation_ort_sec += o.segmentation_ort_sec;
+    fbank_sec += o.fbank_sec;
     embedding_ort_sec += o.embedding_ort_sec;
     clustering_vbx_sec += o.clustering_vbx_sec;
     reconstruct_sec += o.reconstruct_sec;
     total_sec += o.total_sec;
+    segmentation_cpu_sec += o.segmentation_cpu_sec;
+    fbank_cpu_sec += o.fbank_cpu_sec;
+    embedding_cpu_sec += o.embedding_cpu_sec;
+    clustering_vbx_cpu_sec += o.clustering_vbx_cpu_sec;
+    reconstruct_cpu_sec += o.reconstruct_cpu_sec;
+    total_cpu_sec += o.total_cpu_sec;
+    embedding_batch_count += o.embedding_batch_count;
+    embedding_rows += o.embedding_rows;
+    vbx_iters += o.vbx_iters;
+    vbx_warm_starts += o.vbx_warm_starts;
+    vbx_iters_saved += o.vbx_iters_saved;
   }
 };
 
+/// One analysis window for ``CppAnnoteEngine::run_embedding_ort_chunks``;
+/// the fields match the arguments of ``run_embedding_ort_single``.
+struct EmbeddingChunk {
+  const float* chunk_mono = nullptr;
+  const float* seg_binarized = nullptr;
+  const float* fbank_frames = nullptr;
+  int fbank_frame_count = 0;
+};
+
 class CppAnnoteEngine {
  public:
   /// Construct from the community-1 segmentation and embedding models, given
@@ -73,18 +164,57 @@ class CppAnnoteEngine {
                                                 int chunk_num_samples,
                                                 int num_channels);
 
+  /// Segmentation ORT for one window. Safe to call from several threads at
+  /// once after the first call, which discovers the output shape, has
+  /// returned; ``run_embedding_ort_chunks`` and
+  /// ``compute_embedding_fbank_frames`` are always safe to call concurrently.
   std::vector<float> run_segmentation_ort_single(const float* chunk_buf);
 
   /// Embedding ORT for one analysis window. Speaker classes with no
   /// segmentation frame above 0.5 are filled with NaN and skipped; if none
-  /// have speech, fbank is skipped too.
-  std::vector<float> run_embedding_ort_single(const float* chunk_mono,
-                                              const float* seg_binarized);
+  /// have speech, fbank is skipped too. ``fbank_frames`` may hold the first
+  /// ``fbank_frame_count`` raw fbank frames of the window, as returned by
+  /// ``compute_embedding_fbank_frames``; only the rest are computed from
+  /// ``chunk_mono``, and the mean is then subtracted over the whole window.
+  std::vector<float> run_embedding_ort_single(
+      const float* chunk_mono, const float* seg_binarized,
+      const float* fbank_frames = nullptr, int fbank_frame_count = 0);
+
+  /// Embeddings for several windows, as ``run_embedding_ort_single`` would
+  /// give for each. The (chunk, speaker) rows with speech are stacked into
+  /// ORT runs of up to ``embedding_max_batch_size()`` rows; each run is
+  /// recorded in ``profile`` when it is non-null.
+  std::vector<std::vector<float>> run_embedding_ort_chunks(
+      const EmbeddingChunk* chunks, int num_chunks,
+      DiarizationProfile* profile = nullptr);
+
+  /// Most rows stacked into one embedding run. Defaults to 16; forced to 1
+  /// when the embedding model has a fixed batch dimension.
+  int embedding_max_batch_size() const { return embed_max_batch_size_; }
+  void set_embedding_max_batch_size(int rows);
+
+  /// Samples between embedding fbank frames of model-rate audio, or 0 when
+  /// the embedding model resamples each window first, in which case frames
+  /// can't be reused across windows.
+  int embedding_fbank_frame_shift_samples() const;
+  int embedding_fbank_frame_length_samples() const;
+  int embedding_fbank_mel_bins() const { return embed_mel_bins_; }
+
+  /// Raw (not mean-normalized) embedding fbank frames for ``num_samples`` of
+  /// model-rate mono audio. Only valid when
+  /// ``embedding_fbank_frame_shift_samples()`` is non-zero.
+  void compute_embedding_fbank_frames(const float* mono, int num_samples,
+                                      std::vector<float>& out_rowmajor,
+                                      int& num_frames) const;
 
+  /// ``chunk_keys`` and ``warm_start`` are passed on to
+  /// ``clustering_vbx::vbx_clustering_hard`` so a session's refreshes can
+  /// warm-start VBx from the previous one.
   std::vector<DiarizationTurn> cluster_and_decode(
       const std::vector<float>& seg_out, const std::vector<float>& emb, int C,
       DiarizationProfile& profile, double chunk_step_sec_override = 0.0,
-      double chunks_start_sec = 0.0);
+      double chunks_start_sec = 0.0, const int64_t* chunk_keys = nullptr,
+      clustering_vbx::VbxWarmStart* warm_start = nullptr);
 
   int segmentation_model_sample_rate() const { return cfg_.sr_model; }
   int segmentation_num_channels() const { return cfg_.num_channels; }
@@ -133,6 +263,7 @@ class CppAnnoteEngine {
 
   std::unique_ptr<Ort::Session> embed_session_;
   bool embed_inputs_fbank_then_weights_ = true;
+  int embed_max_batch_size_ = 16;
 
   std::unique_ptr<plda_vbx::PldaModel> plda_model_;
   clustering_vbx::VbxClusteringParams vbx_params_{};
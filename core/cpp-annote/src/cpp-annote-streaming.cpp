@@ -3,14 +3,18 @@
 #include "cpp-annote-streaming.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <exception>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -19,6 +23,12 @@
 namespace cppannote {
 namespace {
 
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
 double segment_iou(double a0, double a1, double b0, double b1) {
   const double inter = std::max(0., std::min(a1, b1) - std::max(a0, b0));
   const double span = std::max(a1, b1) - std::min(a0, b0);
@@ -35,6 +45,49 @@ bool turns_match(const StreamingDiarizationTurn& a,
          std::abs(a.end - b.end) < kTol;
 }
 
+// Runs task(index) for every index in [0, count) on up to `threads` threads.
+// Each thread claims the next unclaimed index as it finishes one, so a slow
+// window holds up only its own thread. The first exception is rethrown once
+// every thread has stopped.
+template <typename Task>
+void parallel_for(int count, int threads, const Task& task) {
+  threads = std::max(1, std::min(threads, count));
+  if (threads == 1) {
+    for (int i = 0; i < count; ++i) {
+      task(i);
+    }
+    return;
+  }
+  std::atomic<int> next{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  auto work = [&]() {
+    for (int i = next++; i < count; i = next++) {
+      try {
+        task(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        next = count;
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(static_cast<std::size_t>(threads - 1));
+  for (int t = 1; t < threads; ++t) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 }  // namespace
 
 StreamingDiarizationSession::StreamingDiarizationSession(
@@ -49,6 +102,14 @@ StreamingDiarizationSession::StreamingDiarizationSession(
     }
     effective_step_sec_ = cfg_.analyze_cadence;
   }
+  if (cfg_.analysis_threads < 0) {
+    throw std::runtime_error(
+        "StreamingDiarizationConfig::analysis_threads must be >=0");
+  }
+  analysis_threads_ =
+      (cfg_.analysis_threads > 0)
+          ? cfg_.analysis_threads
+          : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
   cfg_.cluster_cadence = std::max(0.0, cfg_.cluster_cadence);
   if (cfg_.cluster_window_sec < 0.0) {
     cfg_.cluster_window_sec = 0.0;
@@ -66,13 +127,20 @@ void StreamingDiarizationSession::start_session() {
   window_start_sec_ = 0.;
   buffer_abs_start_samples_ = 0;
   chunk_cache_.clear();
+  fbank_frames_.clear();
+  fbank_first_frame_ = 0;
+  fbank_frame_count_ = 0;
+  peak_fbank_frame_count_ = 0;
   last_refresh_analyzed_complete_ = -1;
   analyzed_complete_chunks_ = 0;
   frozen_turns_.clear();
   freeze_cutoff_sec_ = 0.;
   prev_active_turns_.clear();
   next_persistent_label_ = 0;
+  vbx_warm_start_.clear();
   cumulative_profile_ = DiarizationProfile{};
+  pending_profile_ = DiarizationProfile{};
+  last_refresh_profile_ = DiarizationProfile{};
   refresh_count_ = 0;
   snapshot_ = StreamingDiarizationSnapshot{};
 }
@@ -157,15 +225,231 @@ int64_t StreamingDiarizationSession::complete_chunk_count(
 StreamingDiarizationSession::CachedChunk
 StreamingDiarizationSession::analyze_buffer_chunk(int64_t buf_off,
                                                   int64_t num_samples) {
+  return std::move(analyze_buffer_chunks(&buf_off, 1, num_samples).front());
+}
+
+std::vector<StreamingDiarizationSession::CachedChunk>
+StreamingDiarizationSession::analyze_buffer_chunks(const int64_t* buf_offs,
+                                                   int count,
+                                                   int64_t num_samples) {
   const int num_channels = engine_.segmentation_num_channels();
   const int chunk_num_samples = engine_.segmentation_chunk_num_samples();
-  auto chunk_buf = CppAnnoteEngine::extract_chunk_audio(
-      buffer_.data(), num_samples, buf_off, chunk_num_samples, num_channels);
-  auto seg = engine_.run_segmentation_ort_single(chunk_buf.data());
-  auto mono = CppAnnoteEngine::extract_chunk_audio(
-      buffer_.data(), num_samples, buf_off, chunk_num_samples, 1);
-  auto emb = engine_.run_embedding_ort_single(mono.data(), seg.data());
-  return CachedChunk{std::move(seg), std::move(emb)};
+  std::vector<CachedChunk> chunks(static_cast<std::size_t>(count));
+  std::vector<std::vector<float>> monos(static_cast<std::size_t>(count));
+  const auto t_seg = Clock::now();
+  const double cpu_seg = process_cpu_sec();
+  for (int i = 0; i < count; ++i) {
+    auto chunk_buf = CppAnnoteEngine::extract_chunk_audio(
+        buffer_.data(), num_samples, buf_offs[i], chunk_num_samples,
+        num_channels);
+    chunks[static_cast<std::size_t>(i)].seg =
+        engine_.run_segmentation_ort_single(chunk_buf.data());
+    monos[static_cast<std::size_t>(i)] = CppAnnoteEngine::extract_chunk_audio(
+        buffer_.data(), num_samples, buf_offs[i], chunk_num_samples, 1);
+  }
+  pending_profile_.segmentation_ort_sec += seconds_since(t_seg);
+  pending_profile_.segmentation_cpu_sec += process_cpu_sec() - cpu_seg;
+  // Windows come in increasing order, so one extension covers all of them
+  // and the cached pointers stay valid until the embeddings are done.
+  extend_fbank_frames(buffer_abs_start_samples_ + buf_offs[count - 1] +
+                      chunk_num_samples);
+  std::vector<EmbeddingChunk> inputs(static_cast<std::size_t>(count));
+  for (int i = 0; i < count; ++i) {
+    EmbeddingChunk& input = inputs[static_cast<std::size_t>(i)];
+    input.chunk_mono = monos[static_cast<std::size_t>(i)].data();
+    input.seg_binarized = chunks[static_cast<std::size_t>(i)].seg.data();
+    input.fbank_frames =
+        cached_fbank_frames(buffer_abs_start_samples_ + buf_offs[i],
+                            &input.fbank_frame_count);
+  }
+  const double cpu_emb = process_cpu_sec();
+  std::vector<std::vector<float>> embs =
+      engine_.run_embedding_ort_chunks(inputs.data(), count, &pending_profile_);
+  pending_profile_.embedding_cpu_sec += process_cpu_sec() - cpu_emb;
+  for (int i = 0; i < count; ++i) {
+    chunks[static_cast<std::size_t>(i)].emb =
+        std::move(embs[static_cast<std::size_t>(i)]);
+  }
+  return chunks;
+}
+
+std::vector<StreamingDiarizationSession::CachedChunk>
+StreamingDiarizationSession::analyze_buffer_chunks_parallel(
+    const int64_t* buf_offs, int count, int64_t num_samples) {
+  const int num_channels = engine_.segmentation_num_channels();
+  const int chunk_num_samples = engine_.segmentation_chunk_num_samples();
+  std::vector<CachedChunk> chunks(static_cast<std::size_t>(count));
+  if (count == 0) {
+    return chunks;
+  }
+
+  // The stages run one after another, each split across the threads: every
+  // window's embedding needs the fbank frames of its neighbours, and the
+  // first segmentation run fixes the output shape the others check against.
+  extend_fbank_frames(
+      buffer_abs_start_samples_ + buf_offs[count - 1] + chunk_num_samples,
+      analysis_threads_);
+
+  const auto t_seg = Clock::now();
+  const double cpu_seg = process_cpu_sec();
+  auto segment = [&](int i) {
+    const std::vector<float> chunk_buf = CppAnnoteEngine::extract_chunk_audio(
+        buffer_.data(), num_samples, buf_offs[i],
+        chunk_num_samples, num_channels);
+    chunks[static_cast<std::size_t>(i)].seg =
+        engine_.run_segmentation_ort_single(chunk_buf.data());
+  };
+  int first_parallel = 0;
+  if (engine_.seg_frames_per_chunk() == 0) {
+    segment(0);
+    first_parallel = 1;
+  }
+  parallel_for(count - first_parallel, analysis_threads_,
+               [&](int i) { segment(first_parallel + i); });
+  pending_profile_.segmentation_ort_sec += seconds_since(t_seg);
+  pending_profile_.segmentation_cpu_sec += process_cpu_sec() - cpu_seg;
+
+  // Windows are embedded in the same groups as the sequential path, so the
+  // batches match it. Each group records its runs in its own profile, merged
+  // in order afterwards.
+  const int group = chunks_per_embedding_batch();
+  const int num_groups = (count + group - 1) / group;
+  std::vector<DiarizationProfile> group_profiles(
+      static_cast<std::size_t>(num_groups));
+  const auto t_emb = Clock::now();
+  const double cpu_emb = process_cpu_sec();
+  parallel_for(num_groups, analysis_threads_, [&](int g) {
+    const int first = g * group;
+    const int size = std::min(group, count - first);
+    std::vector<std::vector<float>> monos(static_cast<std::size_t>(size));
+    std::vector<EmbeddingChunk> inputs(static_cast<std::size_t>(size));
+    for (int i = 0; i < size; ++i) {
+      const int c = first + i;
+      monos[static_cast<std::size_t>(i)] = CppAnnoteEngine::extract_chunk_audio(
+          buffer_.data(), num_samples, buf_offs[c], chunk_num_samples, 1);
+      EmbeddingChunk& input = inputs[static_cast<std::size_t>(i)];
+      input.chunk_mono = monos[static_cast<std::size_t>(i)].data();
+      input.seg_binarized = chunks[static_cast<std::size_t>(c)].seg.data();
+      input.fbank_frames =
+          cached_fbank_frames(buffer_abs_start_samples_ + buf_offs[c],
+                              &input.fbank_frame_count);
+    }
+    std::vector<std::vector<float>> embs = engine_.run_embedding_ort_chunks(
+        inputs.data(), size, &group_profiles[static_cast<std::size_t>(g)]);
+    for (int i = 0; i < size; ++i) {
+      chunks[static_cast<std::size_t>(first + i)].emb =
+          std::move(embs[static_cast<std::size_t>(i)]);
+    }
+  });
+  const double embedding_ort_sec = seconds_since(t_emb);
+  // The runs overlapped, so the stage counts its span rather than their sum.
+  const double earlier_ort_sec = pending_profile_.embedding_ort_sec;
+  for (const DiarizationProfile& profile : group_profiles) {
+    for (const DiarizationProfile::EmbeddingBatch& batch :
+         profile.embedding_batches) {
+      pending_profile_.add_embedding_batch(batch.rows, batch.ort_sec);
+    }
+  }
+  pending_profile_.embedding_ort_sec = earlier_ort_sec + embedding_ort_sec;
+  pending_profile_.embedding_cpu_sec += process_cpu_sec() - cpu_emb;
+  return chunks;
+}
+
+int StreamingDiarizationSession::chunks_per_embedding_batch() const {
+  return std::max(1, engine_.embedding_max_batch_size() /
+                         std::max(1, engine_.seg_classes()));
+}
+
+void StreamingDiarizationSession::extend_fbank_frames(int64_t abs_end,
+                                                      int threads) {
+  const int shift = engine_.embedding_fbank_frame_shift_samples();
+  const int length = engine_.embedding_fbank_frame_length_samples();
+  if (shift <= 0 || length <= 0) {
+    return;
+  }
+  const int64_t buffer_end =
+      buffer_abs_start_samples_ + static_cast<int64_t>(buffer_.size());
+  abs_end = std::min(abs_end, buffer_end);
+  int64_t next_frame = fbank_first_frame_ + fbank_frame_count_;
+  if (next_frame * shift < buffer_abs_start_samples_) {
+    // The audio for the next frame has been trimmed; restart the cache at
+    // the first frame the buffer still holds.
+    fbank_frames_.clear();
+    fbank_first_frame_ = (buffer_abs_start_samples_ + shift - 1) / shift;
+    fbank_frame_count_ = 0;
+    next_frame = fbank_first_frame_;
+  }
+  const int64_t from = next_frame * shift;
+  if (abs_end - from < length) {
+    return;
+  }
+  const auto t_fbank = Clock::now();
+  const double cpu_fbank = process_cpu_sec();
+  // Each frame only reads its own samples, so contiguous runs of frames can
+  // be computed separately and concatenated without changing any value.
+  const int64_t num_frames = (abs_end - from - length) / shift + 1;
+  const int parts = static_cast<int>(
+      std::max<int64_t>(1, std::min<int64_t>(threads, num_frames)));
+  std::vector<std::vector<float>> frames(static_cast<std::size_t>(parts));
+  parallel_for(parts, parts, [&](int p) {
+    const int64_t first = num_frames * p / parts;
+    const int64_t end = num_frames * (p + 1) / parts;
+    const int64_t offset = from + first * shift - buffer_abs_start_samples_;
+    int computed = 0;
+    engine_.compute_embedding_fbank_frames(
+        buffer_.data() + offset,
+        static_cast<int>((end - first - 1) * shift + length),
+        frames[static_cast<std::size_t>(p)], computed);
+    if (computed != end - first) {
+      throw std::runtime_error("embedding fbank: unexpected frame count");
+    }
+  });
+  for (const std::vector<float>& part : frames) {
+    fbank_frames_.insert(fbank_frames_.end(), part.begin(), part.end());
+  }
+  fbank_frame_count_ += num_frames;
+  peak_fbank_frame_count_ =
+      std::max(peak_fbank_frame_count_, fbank_frame_count_);
+  pending_profile_.fbank_sec += seconds_since(t_fbank);
+  pending_profile_.fbank_cpu_sec += process_cpu_sec() - cpu_fbank;
+}
+
+const float* StreamingDiarizationSession::cached_fbank_frames(
+    int64_t abs_off, int* frame_count) const {
+  *frame_count = 0;
+  const int shift = engine_.embedding_fbank_frame_shift_samples();
+  if (shift <= 0 || abs_off % shift != 0) {
+    return nullptr;
+  }
+  const int64_t first = abs_off / shift;
+  const int64_t end = fbank_first_frame_ + fbank_frame_count_;
+  if (first < fbank_first_frame_ || first >= end) {
+    return nullptr;
+  }
+  *frame_count = static_cast<int>(end - first);
+  return fbank_frames_.data() +
+         static_cast<std::size_t>(first - fbank_first_frame_) *
+             static_cast<std::size_t>(engine_.embedding_fbank_mel_bins());
+}
+
+void StreamingDiarizationSession::trim_fbank_frames() {
+  const int shift = engine_.embedding_fbank_frame_shift_samples();
+  if (shift <= 0 || fbank_frame_count_ == 0) {
+    return;
+  }
+  const int64_t drop =
+      std::min(fbank_frame_count_,
+               buffer_abs_start_samples_ / shift - fbank_first_frame_);
+  if (drop <= 0) {
+    return;
+  }
+  fbank_frames_.erase(
+      fbank_frames_.begin(),
+      fbank_frames_.begin() +
+          static_cast<std::ptrdiff_t>(
+              drop * static_cast<int64_t>(engine_.embedding_fbank_mel_bins())));
+  fbank_first_frame_ += drop;
+  fbank_frame_count_ -= drop;
 }
 
 void StreamingDiarizationSession::trim_buffer_if_needed() {
@@ -208,6 +492,7 @@ void StreamingDiarizationSession::trim_buffer_if_needed() {
                 buffer_.begin() + static_cast<std::ptrdiff_t>(drop));
   window_start_sec_ += static_cast<double>(drop) / static_cast<double>(sr);
   buffer_abs_start_samples_ += static_cast<int64_t>(drop);
+  trim_fbank_frames();
 }
 
 int StreamingDiarizationSession::cache_new_chunks(int max_chunks) {
@@ -218,21 +503,55 @@ int StreamingDiarizationSession::cache_new_chunks(int max_chunks) {
   }
   const int64_t num_samples_i = static_cast<int64_t>(buffer_.size());
   const int64_t n_complete = complete_chunk_count(num_samples_i);
-  int analyzed = 0;
+  std::vector<int64_t> new_offsets;
   for (int64_t c = 0; c < n_complete; ++c) {
     const int64_t buf_off = c * step;
     const int64_t abs_off = buffer_abs_start_samples_ + buf_off;
     if (chunk_cache_.count(abs_off)) {
       continue;
     }
-    if (max_chunks >= 0 && analyzed >= max_chunks) {
+    if (max_chunks >= 0 &&
+        static_cast<int64_t>(new_offsets.size()) >= max_chunks) {
       break;
     }
-    chunk_cache_[abs_off] = analyze_buffer_chunk(buf_off, num_samples_i);
-    ++analyzed_complete_chunks_;
-    ++analyzed;
+    new_offsets.push_back(buf_off);
+  }
+  // From here on the offsets are absolute, since trimming after each round
+  // moves the buffer start.
+  for (int64_t& off : new_offsets) {
+    off += buffer_abs_start_samples_;
+  }
+  // A round is one embedding group per thread, so the parallel path batches
+  // the same windows together as the sequential one.
+  const std::size_t round =
+      static_cast<std::size_t>(chunks_per_embedding_batch()) *
+      static_cast<std::size_t>(analysis_threads_);
+  std::vector<int64_t> buf_offs;
+  for (std::size_t first = 0; first < new_offsets.size(); first += round) {
+    const int count =
+        static_cast<int>(std::min(round, new_offsets.size() - first));
+    buf_offs.clear();
+    for (int i = 0; i < count; ++i) {
+      buf_offs.push_back(new_offsets[first + static_cast<std::size_t>(i)] -
+                         buffer_abs_start_samples_);
+    }
+    const int64_t num_samples = static_cast<int64_t>(buffer_.size());
+    std::vector<CachedChunk> analyzed =
+        (analysis_threads_ > 1 && count > 1)
+            ? analyze_buffer_chunks_parallel(buf_offs.data(), count,
+                                             num_samples)
+            : analyze_buffer_chunks(buf_offs.data(), count, num_samples);
+    for (int i = 0; i < count; ++i) {
+      chunk_cache_[new_offsets[first + static_cast<std::size_t>(i)]] =
+          std::move(analyzed[static_cast<std::size_t>(i)]);
+      ++analyzed_complete_chunks_;
+    }
+    // Let go of the audio and fbank frames only these windows needed, so
+    // draining a long backlog (end_session after a catch-up dump) holds
+    // about one round's worth at a time rather than the whole recording.
+    trim_buffer_if_needed();
   }
-  return analyzed;
+  return static_cast<int>(new_offsets.size());
 }
 
 void StreamingDiarizationSession::add_audio_chunk(const float* pcm,
@@ -437,7 +756,6 @@ void StreamingDiarizationSession::maybe_refresh(bool force,
   using Clock = std::chrono::steady_clock;
 
   const int sr_model = engine_.segmentation_model_sample_rate();
-  const int num_channels = engine_.segmentation_num_channels();
   const int chunk_num_samples = engine_.segmentation_chunk_num_samples();
   const int step = step_samples();
   if (step <= 0 || chunk_num_samples <= 0) {
@@ -468,6 +786,7 @@ void StreamingDiarizationSession::maybe_refresh(bool force,
   }
 
   const auto t_seg_start = Clock::now();
+  const double cpu_seg_start = process_cpu_sec();
 
   // Complete chunks are already cached by cache_new_chunks(). The padded tail
   // is a second analyze, so skip it when this call already spent its budget on
@@ -477,18 +796,9 @@ void StreamingDiarizationSession::maybe_refresh(bool force,
     const int64_t buf_off = num_complete_chunks * step;
     const int64_t abs_off = buffer_abs_start_samples_ + buf_off;
     tail_abs_off = abs_off;
-    auto chunk_buf = CppAnnoteEngine::extract_chunk_audio(
-        buffer_.data(), num_samples_i, buf_off, chunk_num_samples,
-        num_channels);
-    auto seg = engine_.run_segmentation_ort_single(chunk_buf.data());
-    auto mono = CppAnnoteEngine::extract_chunk_audio(
-        buffer_.data(), num_samples_i, buf_off, chunk_num_samples, 1);
-    auto emb_chunk = engine_.run_embedding_ort_single(mono.data(), seg.data());
-    chunk_cache_[abs_off] = CachedChunk{std::move(seg), std::move(emb_chunk)};
+    chunk_cache_[abs_off] = analyze_buffer_chunk(buf_off, num_samples_i);
   }
 
-  const auto t_after_seg_emb = Clock::now();
-
   // Include a margin of chunks before the window start so the oldest edge
   // (where turns freeze) is decoded with full segmentation context.
   const double decode_window_start_sec = cluster_decode_window_start_sec();
@@ -542,18 +852,18 @@ void StreamingDiarizationSession::maybe_refresh(bool force,
   const double chunks_start_sec =
       static_cast<double>(all_offsets.front()) / static_cast<double>(sr_model);
 
-  DiarizationProfile prof;
-  prof.segmentation_ort_sec = 0.;
-  prof.embedding_ort_sec =
-      std::chrono::duration<double>(t_after_seg_emb - t_seg_start).count();
+  DiarizationProfile prof = std::move(pending_profile_);
+  pending_profile_ = DiarizationProfile{};
 
   std::vector<DiarizationTurn> raw = engine_.cluster_and_decode(
-      seg_out, emb_all, C_full, prof, effective_step_sec_, chunks_start_sec);
+      seg_out, emb_all, C_full, prof, effective_step_sec_, chunks_start_sec,
+      all_offsets.data(), cfg_.warm_start_vbx ? &vbx_warm_start_ : nullptr);
 
-  prof.segmentation_ort_sec = 0.;
   prof.total_sec =
       std::chrono::duration<double>(Clock::now() - t_seg_start).count();
+  prof.total_cpu_sec = process_cpu_sec() - cpu_seg_start;
   cumulative_profile_.accumulate(prof);
+  last_refresh_profile_ = std::move(prof);
   ++refresh_count_;
 
   std::vector<StreamingDiarizationTurn> active_turns;
@@ -31,6 +31,20 @@ struct StreamingDiarizationConfig {
   /// chunks are evicted from the cache and their turns are frozen.  Zero means
   /// unlimited (full-history re-clustering).
   double cluster_window_sec = 120.0;
+
+  /// Threads that analyze windows (fbank, segmentation, embedding) when a
+  /// backlog is drained at once by ``end_session`` or
+  /// ``refresh_and_snapshot``, as in one-shot diarization.  Zero means one per
+  /// hardware thread.  Appends still analyze at most one window, on the
+  /// caller's thread.
+  int analysis_threads = 1;
+
+  /// Start each refresh's VBx from the previous refresh's responsibilities
+  /// and speaker priors, skipping AHC unless the speaker count looks likely
+  /// to change (see ``clustering_vbx::vbx_clustering_hard``).  Off by
+  /// default: labels can then differ from a cold re-clustering of the same
+  /// window.
+  bool warm_start_vbx = false;
 };
 
 struct StreamingDiarizationTurn : DiarizationTurn {
@@ -78,6 +92,16 @@ class StreamingDiarizationSession {
   /// padded tail), and return the snapshot.
   StreamingDiarizationSnapshot end_session();
 
+  /// Timings of the last refresh. Its segmentation, fbank and embedding
+  /// figures cover every window analyzed since the refresh before, with one
+  /// entry per batched embedding run.
+  const DiarizationProfile& last_refresh_profile() const {
+    return last_refresh_profile_;
+  }
+
+  /// Most embedding fbank frames cached at once since ``start_session``.
+  int64_t peak_fbank_frame_count() const { return peak_fbank_frame_count_; }
+
   StreamingDiarizationSession(const StreamingDiarizationSession&) = delete;
   StreamingDiarizationSession& operator=(const StreamingDiarizationSession&) =
       delete;
@@ -92,6 +116,27 @@ class StreamingDiarizationSession {
   /// Returns how many were added to the cache.
   int cache_new_chunks(int max_chunks);
   CachedChunk analyze_buffer_chunk(int64_t buf_off, int64_t num_samples);
+  /// Segments each of ``count`` windows, then embeds them all with one
+  /// ``run_embedding_ort_chunks`` call so their speakers share ORT runs.
+  std::vector<CachedChunk> analyze_buffer_chunks(const int64_t* buf_offs,
+                                                 int count,
+                                                 int64_t num_samples);
+  /// Same results as ``analyze_buffer_chunks`` over groups of
+  /// ``chunks_per_embedding_batch()`` windows, with each stage shared by
+  /// ``analysis_threads_`` threads.
+  std::vector<CachedChunk> analyze_buffer_chunks_parallel(
+      const int64_t* buf_offs, int count, int64_t num_samples);
+  /// Windows analyzed together by cache_new_chunks on each thread: enough to
+  /// fill about one embedding batch, assuming every speaker class is active.
+  int chunks_per_embedding_batch() const;
+  /// Computes the embedding fbank frames that lie entirely before absolute
+  /// sample ``abs_end`` (and within the buffer) and are not cached yet,
+  /// splitting them across ``threads`` threads.
+  void extend_fbank_frames(int64_t abs_end, int threads = 1);
+  /// Cached frames for a window starting at absolute sample ``abs_off``, or
+  /// nullptr if it doesn't start on a cached frame.
+  const float* cached_fbank_frames(int64_t abs_off, int* frame_count) const;
+  void trim_fbank_frames();
   int64_t complete_chunk_count(int64_t num_samples) const;
   int step_samples() const;
   void trim_buffer_if_needed();
@@ -120,6 +165,7 @@ class StreamingDiarizationSession {
   double effective_step_sec_ = 1.0;  // resolved analyze_cadence
   int cluster_every_chunks_ =
       1;  // derived from cfg_.cluster_cadence / effective_step_sec_
+  int analysis_threads_ = 1;  // resolved cfg_.analysis_threads
 
   std::vector<float> buffer_;
   double input_end_sec_ = 0.;
@@ -128,6 +174,15 @@ class StreamingDiarizationSession {
 
   std::unordered_map<int64_t, CachedChunk> chunk_cache_;
 
+  // Raw embedding fbank frames of the buffered audio, by absolute frame
+  // index from fbank_first_frame_. Each frame is computed once and sliced
+  // into every window that covers it; at the default 1 s cadence that is
+  // ten windows.
+  std::vector<float> fbank_frames_;
+  int64_t fbank_first_frame_ = 0;
+  int64_t fbank_frame_count_ = 0;
+  int64_t peak_fbank_frame_count_ = 0;
+
   int last_refresh_analyzed_complete_ = -1;
   int64_t analyzed_complete_chunks_ = 0;
 
@@ -140,7 +195,13 @@ class StreamingDiarizationSession {
   std::vector<StreamingDiarizationTurn> prev_active_turns_;
   int next_persistent_label_ = 0;
 
+  // The last refresh's VBx solution, when cfg_.warm_start_vbx is set.
+  clustering_vbx::VbxWarmStart vbx_warm_start_;
+
   DiarizationProfile cumulative_profile_{};
+  // Embedding runs since the last refresh, and that refresh's profile.
+  DiarizationProfile pending_profile_{};
+  DiarizationProfile last_refresh_profile_{};
   int refresh_count_ = 0;
 
   StreamingDiarizationSnapshot snapshot_;
@@ -11,6 +11,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
@@ -22,6 +23,12 @@
 #include <sstream>
 #include <stdexcept>
 
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
 #include "annotation_support.h"
 #include "clustering_vbx.h"
 #include "community1_cpp_annote_embedded.h"
@@ -486,6 +493,23 @@ bool try_regex_int(const std::string &json, const std::string &key_esc,
 
 }  // namespace
 
+double process_cpu_sec() {
+#ifdef _WIN32
+  // The MSVC std::clock() counts wall time, not CPU time.
+  FILETIME creation, exit, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel,
+                       &user)) {
+    return 0.;
+  }
+  auto ticks = [](const FILETIME &t) {
+    return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+  };
+  return static_cast<double>(ticks(kernel) + ticks(user)) * 1e-7;
+#else
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
 // Both models were compiled into the library until version 26.8. They are 8.2
 // MB together and only a fraction of callers diarize, so they are downloaded
 // now; a missing one is a caller error rather than something to fall back from.
@@ -587,6 +611,7 @@ void CppAnnoteEngine::init_config_and_models(
         embedding_ort::embedding_json_inputs_fbank_first(emb_json);
     embed_session_ =
         make_embedding_session(ort_env_, session_options_, embedding_model);
+    set_embedding_max_batch_size(embed_max_batch_size_);
     min_num_samples_ = embedding_ort::discover_min_num_samples_embedding(
         *embed_session_, mem_, alloc_, embed_inputs_fbank_then_weights_,
         embed_sr_, embed_mel_bins_, embed_frame_length_ms_,
@@ -677,8 +702,49 @@ std::vector<float> CppAnnoteEngine::run_segmentation_ort_single(
   return std::vector<float>(op, op + F * K);
 }
 
+int CppAnnoteEngine::embedding_fbank_frame_shift_samples() const {
+  if (cfg_.sr_model != embed_sr_) {
+    return 0;
+  }
+  return cppannote::fbank::fbank_window_samples(
+      static_cast<float>(embed_sr_), embed_frame_shift_ms_);
+}
+
+int CppAnnoteEngine::embedding_fbank_frame_length_samples() const {
+  return cppannote::fbank::fbank_window_samples(static_cast<float>(embed_sr_),
+                                                embed_frame_length_ms_);
+}
+
+void CppAnnoteEngine::compute_embedding_fbank_frames(
+    const float *mono, int num_samples, std::vector<float> &out_rowmajor,
+    int &num_frames) const {
+  int mel_dim = 0;
+  cppannote::fbank::wespeaker_like_fbank_frames(
+      static_cast<float>(embed_sr_), embed_mel_bins_, embed_frame_length_ms_,
+      embed_frame_shift_ms_, mono, num_samples, out_rowmajor, num_frames,
+      mel_dim);
+  if (num_frames > 0 && mel_dim != embed_mel_bins_) {
+    throw std::runtime_error("embedding fbank: unexpected mel dimension");
+  }
+}
+
 std::vector<float> CppAnnoteEngine::run_embedding_ort_single(
-    const float *chunk_mono, const float *seg_binarized) {
+    const float *chunk_mono, const float *seg_binarized,
+    const float *fbank_frames, int fbank_frame_count) {
+  const EmbeddingChunk chunk{chunk_mono, seg_binarized, fbank_frames,
+                             fbank_frame_count};
+  std::vector<std::vector<float>> results = run_embedding_ort_chunks(&chunk, 1);
+  return std::move(results.front());
+}
+
+void CppAnnoteEngine::set_embedding_max_batch_size(int rows) {
+  embed_max_batch_size_ =
+      embedding_ort::embedding_batch_limit(*embed_session_, rows);
+}
+
+std::vector<std::vector<float>> CppAnnoteEngine::run_embedding_ort_chunks(
+    const EmbeddingChunk *chunks, int num_chunks, DiarizationProfile *profile) {
+  using Clock = std::chrono::steady_clock;
   const int F = seg_F_;
   const int K = seg_K_;
   const int dim = embed_dim_;
@@ -689,89 +755,183 @@ std::vector<float> CppAnnoteEngine::run_embedding_ort_single(
         "run_embedding_ort_single: call run_segmentation_ort_single first");
   }
 
-  std::vector<char> class_has_speech(static_cast<size_t>(K), 0);
-  bool any_speech = false;
-  for (int sp = 0; sp < K; ++sp) {
-    for (int f = 0; f < F; ++f) {
-      if (seg_binarized[f * K + sp] > 0.5f) {
-        class_has_speech[static_cast<size_t>(sp)] = 1;
-        any_speech = true;
-        break;
-      }
-    }
-  }
-
-  std::vector<float> result(static_cast<size_t>(K) * static_cast<size_t>(dim),
-                            std::numeric_limits<float>::quiet_NaN());
-  if (!any_speech) {
-    return result;
-  }
-
-  std::vector<float> chunk_for_fbank(chunk_mono,
-                                     chunk_mono + chunk_num_samples);
-  int wav_sr_use = sr_model;
-  if (sr_model != embed_sr_) {
-    chunk_for_fbank =
-        wav_pcm::linear_resample(chunk_for_fbank, sr_model, embed_sr_);
-    wav_sr_use = embed_sr_;
-  }
-  const int chunk_embed_samples = static_cast<int>(chunk_for_fbank.size());
-  const int min_nf_seg =
-      embedding_exclude_overlap_
-          ? static_cast<int>(std::ceil(
-                static_cast<double>(F) * static_cast<double>(min_num_samples_) /
-                static_cast<double>(chunk_embed_samples)))
-          : -1;
-
+  std::vector<std::vector<float>> results(
+      static_cast<size_t>(std::max(0, num_chunks)),
+      std::vector<float>(static_cast<size_t>(K) * static_cast<size_t>(dim),
+                         std::numeric_limits<float>::quiet_NaN()));
+
+  // One row per (chunk, speaker) with speech. Rows of a chunk share its
+  // fbank, which is copied into the stacked batch input at run time.
+  struct EmbeddingRow {
+    int chunk = 0;
+    int speaker = 0;
+    size_t fbank = 0;
+    std::vector<float> weights;
+  };
+  std::vector<std::vector<float>> fbanks;
+  std::vector<EmbeddingRow> rows;
   int Tf = 0;
   int Mfb = 0;
-  std::vector<float> fbank_all;
-  cppannote::fbank::wespeaker_like_fbank(
-      static_cast<float>(wav_sr_use), embed_mel_bins_, embed_frame_length_ms_,
-      embed_frame_shift_ms_, chunk_for_fbank.data(),
-      static_cast<int>(chunk_for_fbank.size()), fbank_all, Tf, Mfb);
-  if (Tf < 1 || Mfb != embed_mel_bins_) {
-    throw std::runtime_error(
-        "embedding fbank: unexpected frames or mel dimension");
-  }
-
-  for (int sp = 0; sp < K; ++sp) {
-    if (!class_has_speech[static_cast<size_t>(sp)]) {
+  const int frame_shift = embedding_fbank_frame_shift_samples();
+  const int frame_length = embedding_fbank_frame_length_samples();
+
+  for (int ci = 0; ci < num_chunks; ++ci) {
+    const EmbeddingChunk &chunk = chunks[ci];
+    const float *seg_binarized = chunk.seg_binarized;
+    std::vector<char> class_has_speech(static_cast<size_t>(K), 0);
+    bool any_speech = false;
+    for (int sp = 0; sp < K; ++sp) {
+      for (int f = 0; f < F; ++f) {
+        if (seg_binarized[f * K + sp] > 0.5f) {
+          class_has_speech[static_cast<size_t>(sp)] = 1;
+          any_speech = true;
+          break;
+        }
+      }
+    }
+    if (!any_speech) {
       continue;
     }
-    std::vector<float> clean_col(static_cast<size_t>(F), 0.f);
-    std::vector<float> full_col(static_cast<size_t>(F), 0.f);
-    for (int f = 0; f < F; ++f) {
-      float rowsum = 0.f;
-      for (int j = 0; j < K; ++j) {
-        rowsum += seg_binarized[f * K + j];
+    int chunk_embed_samples = chunk_num_samples;
+    int chunk_Tf = 0;
+    int chunk_Mfb = 0;
+    std::vector<float> fbank_all;
+    if (chunk.fbank_frames != nullptr && chunk.fbank_frame_count > 0 &&
+        frame_shift > 0 && chunk_num_samples >= frame_length) {
+      // Frames depend only on their own window, so the cached prefix is
+      // bit-identical to what the full computation below would give; just
+      // the per-window mean has to be taken over this window's frames.
+      chunk_Tf = (chunk_num_samples - frame_length) / frame_shift + 1;
+      chunk_Mfb = embed_mel_bins_;
+      const int cached = std::min(chunk.fbank_frame_count, chunk_Tf);
+      fbank_all.reserve(static_cast<size_t>(chunk_Tf) *
+                        static_cast<size_t>(chunk_Mfb));
+      fbank_all.assign(chunk.fbank_frames,
+                       chunk.fbank_frames + static_cast<size_t>(cached) *
+                                                static_cast<size_t>(chunk_Mfb));
+      if (cached < chunk_Tf) {
+        std::vector<float> rest;
+        int rest_frames = 0;
+        const int rest_offset = cached * frame_shift;
+        compute_embedding_fbank_frames(chunk.chunk_mono + rest_offset,
+                                       chunk_num_samples - rest_offset, rest,
+                                       rest_frames);
+        if (rest_frames != chunk_Tf - cached) {
+          throw std::runtime_error("embedding fbank: unexpected frame count");
+        }
+        fbank_all.insert(fbank_all.end(), rest.begin(), rest.end());
+      }
+      cppannote::fbank::subtract_fbank_mean(fbank_all, chunk_Tf, chunk_Mfb);
+    } else {
+      std::vector<float> chunk_for_fbank(
+          chunk.chunk_mono, chunk.chunk_mono + chunk_num_samples);
+      int wav_sr_use = sr_model;
+      if (sr_model != embed_sr_) {
+        chunk_for_fbank =
+            wav_pcm::linear_resample(chunk_for_fbank, sr_model, embed_sr_);
+        wav_sr_use = embed_sr_;
       }
-      const float overlap_ok = (rowsum < 2.f - 1e-5f) ? 1.f : 0.f;
-      const float v = seg_binarized[f * K + sp];
-      full_col[static_cast<size_t>(f)] = v;
-      clean_col[static_cast<size_t>(f)] = v * overlap_ok;
+      chunk_embed_samples = static_cast<int>(chunk_for_fbank.size());
+      cppannote::fbank::wespeaker_like_fbank(
+          static_cast<float>(wav_sr_use), embed_mel_bins_,
+          embed_frame_length_ms_, embed_frame_shift_ms_,
+          chunk_for_fbank.data(), static_cast<int>(chunk_for_fbank.size()),
+          fbank_all, chunk_Tf, chunk_Mfb);
     }
-    float sum_clean = 0.f;
-    for (int f = 0; f < F; ++f) {
-      if (clean_col[static_cast<size_t>(f)] > 0.5f) {
-        sum_clean += 1.f;
+    const int min_nf_seg =
+        embedding_exclude_overlap_
+            ? static_cast<int>(
+                  std::ceil(static_cast<double>(F) *
+                            static_cast<double>(min_num_samples_) /
+                            static_cast<double>(chunk_embed_samples)))
+            : -1;
+    if (chunk_Tf < 1 || chunk_Mfb != embed_mel_bins_) {
+      throw std::runtime_error(
+          "embedding fbank: unexpected frames or mel dimension");
+    }
+    if (Tf == 0) {
+      Tf = chunk_Tf;
+      Mfb = chunk_Mfb;
+    } else if (chunk_Tf != Tf) {
+      throw std::runtime_error("embedding fbank: frame count changed");
+    }
+    fbanks.push_back(std::move(fbank_all));
+
+    for (int sp = 0; sp < K; ++sp) {
+      if (!class_has_speech[static_cast<size_t>(sp)]) {
+        continue;
+      }
+      std::vector<float> clean_col(static_cast<size_t>(F), 0.f);
+      std::vector<float> full_col(static_cast<size_t>(F), 0.f);
+      for (int f = 0; f < F; ++f) {
+        float rowsum = 0.f;
+        for (int j = 0; j < K; ++j) {
+          rowsum += seg_binarized[f * K + j];
+        }
+        const float overlap_ok = (rowsum < 2.f - 1e-5f) ? 1.f : 0.f;
+        const float v = seg_binarized[f * K + sp];
+        full_col[static_cast<size_t>(f)] = v;
+        clean_col[static_cast<size_t>(f)] = v * overlap_ok;
+      }
+      float sum_clean = 0.f;
+      for (int f = 0; f < F; ++f) {
+        if (clean_col[static_cast<size_t>(f)] > 0.5f) {
+          sum_clean += 1.f;
+        }
       }
+      const bool prefer_clean =
+          (min_nf_seg < 0) ? true
+                           : (sum_clean > static_cast<float>(min_nf_seg));
+      rows.push_back(EmbeddingRow{ci, sp, fbanks.size() - 1,
+                                  prefer_clean ? clean_col : full_col});
+    }
+  }
+
+  const size_t fbank_size = static_cast<size_t>(Tf) * static_cast<size_t>(Mfb);
+  const size_t max_batch =
+      static_cast<size_t>(std::max(1, embed_max_batch_size_));
+  std::vector<float> batch_fbank;
+  std::vector<float> batch_weights;
+  std::vector<float> batch_out;
+  for (size_t first = 0; first < rows.size(); first += max_batch) {
+    const size_t batch = std::min(max_batch, rows.size() - first);
+    batch_fbank.resize(batch * fbank_size);
+    batch_weights.resize(batch * static_cast<size_t>(F));
+    batch_out.resize(batch * static_cast<size_t>(dim));
+    for (size_t r = 0; r < batch; ++r) {
+      const EmbeddingRow &row = rows[first + r];
+      std::memcpy(&batch_fbank[r * fbank_size], fbanks[row.fbank].data(),
+                  fbank_size * sizeof(float));
+      std::memcpy(&batch_weights[r * static_cast<size_t>(F)],
+                  row.weights.data(), static_cast<size_t>(F) * sizeof(float));
     }
-    const bool prefer_clean =
-        (min_nf_seg < 0) ? true : (sum_clean > static_cast<float>(min_nf_seg));
-    const std::vector<float> &src = prefer_clean ? clean_col : full_col;
-    float *dst = &result[static_cast<size_t>(sp) * static_cast<size_t>(dim)];
-    embedding_ort::run_embedding_ort(
+    const auto t_run = Clock::now();
+    embedding_ort::run_embedding_ort_batch(
         *embed_session_, mem_, alloc_, embed_inputs_fbank_then_weights_,
-        fbank_all.data(), Tf, Mfb, src.data(), F, dst, dim);
+        batch_fbank.data(), Tf, Mfb, batch_weights.data(), F,
+        static_cast<int>(batch), batch_out.data(), dim);
+    if (profile != nullptr) {
+      profile->add_embedding_batch(
+          static_cast<int>(batch),
+          std::chrono::duration<double>(Clock::now() - t_run).count());
+    }
+    for (size_t r = 0; r < batch; ++r) {
+      const EmbeddingRow &row = rows[first + r];
+      std::memcpy(&results[static_cast<size_t>(row.chunk)]
+                          [static_cast<size_t>(row.speaker) *
+                           static_cast<size_t>(dim)],
+                  &batch_out[r * static_cast<size_t>(dim)],
+                  static_cast<size_t>(dim) * sizeof(float));
+    }
   }
-  return result;
+  return results;
 }
 
 std::vector<DiarizationTurn> CppAnnoteEngine::cluster_and_decode(
     const std::vector<float> &seg_out, const std::vector<float> &emb, int C,
     DiarizationProfile &profile, double chunk_step_sec_override,
-    double chunks_start_sec) {
+    double chunks_start_sec, const int64_t *chunk_keys,
+    clustering_vbx::VbxWarmStart *warm_start) {
   using Clock = std::chrono::steady_clock;
   const int F = seg_F_;
   const int Kcls = seg_K_;
@@ -791,14 +951,18 @@ std::vector<DiarizationTurn> CppAnnoteEngine::cluster_and_decode(
   std::vector<float> binarized = seg_out;
 
   const auto t_vbx_start = Clock::now();
+  const double cpu_vbx_start = process_cpu_sec();
 
   std::vector<std::int8_t> hard_clusters_row;
-  clustering_vbx::vbx_clustering_hard(*plda_model_, vbx_params_, C, F, Kcls,
-                                      dim, emb.data(), binarized.data(),
-                                      hard_clusters_row);
+  clustering_vbx::VbxRunStats vbx_stats;
+  clustering_vbx::vbx_clustering_hard(
+      *plda_model_, vbx_params_, C, F, Kcls, dim, emb.data(), binarized.data(),
+      hard_clusters_row, chunk_keys, warm_start, &vbx_stats);
+  profile.set_vbx_run(vbx_stats);
   const std::int8_t *hptr = hard_clusters_row.data();
 
   const auto t_after_vbx = Clock::now();
+  const double cpu_after_vbx = process_cpu_sec();
 
   double seg_ss = chunks_start_sec;
   double seg_sd = chunk_dur_sec;
@@ -816,7 +980,9 @@ std::vector<DiarizationTurn> CppAnnoteEngine::cluster_and_decode(
   if (max_cnt == 0) {
     profile.clustering_vbx_sec =
         std::chrono::duration<double>(t_after_vbx - t_vbx_start).count();
+    profile.clustering_vbx_cpu_sec = cpu_after_vbx - cpu_vbx_start;
     profile.reconstruct_sec = 0.;
+    profile.reconstruct_cpu_sec = 0.;
     profile.total_chunks = C;
     profile.num_frames = F;
     profile.num_classes = Kcls;
@@ -920,6 +1086,9 @@ std::vector<DiarizationTurn> CppAnnoteEngine::cluster_and_decode(
       std::chrono::duration<double>(t_after_vbx - t_vbx_start).count();
   profile.reconstruct_sec =
       std::chrono::duration<double>(t_end - t_after_vbx).count();
+  const double cpu_end = process_cpu_sec();
+  profile.clustering_vbx_cpu_sec = cpu_after_vbx - cpu_vbx_start;
+  profile.reconstruct_cpu_sec = cpu_end - cpu_after_vbx;
   profile.total_chunks = C;
   profile.num_frames = F;
   profile.num_classes = Kcls;
@@ -1035,10 +1204,12 @@ void CppAnnote::add_audio_to_stream(int32_t stream_id, const float *audio_data,
 
 DiarizationResults CppAnnote::diarize(const float *audio_data,
                                       uint64_t audio_length,
-                                      int32_t sample_rate) {
+                                      int32_t sample_rate,
+                                      int num_threads) {
   constexpr double kNeverRefresh = 1e18;
   StreamingDiarizationConfig cfg;
   cfg.cluster_cadence = kNeverRefresh;
+  cfg.analysis_threads = num_threads;
   StreamingDiarizationSession sess(impl_->engine, cfg);
   sess.start_session();
   sess.add_audio_chunk(audio_data, static_cast<std::size_t>(audio_length),
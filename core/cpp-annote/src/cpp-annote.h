@@ -74,8 +74,11 @@ class CppAnnote {
   CppAnnote &operator=(CppAnnote &&) noexcept;
 
   /// Diarize an entire buffer of mono PCM audio in one shot.
+  /// ``num_threads`` threads share the segmentation, fbank and embedding
+  /// work of the analysis windows (0 = one per hardware thread) before a
+  /// single clustering pass; the turns don't depend on it.
   DiarizationResults diarize(const float *audio_data, uint64_t audio_length,
-                             int32_t sample_rate = 16000);
+                             int32_t sample_rate = 16000, int num_threads = 1);
 
   /// Allocate a new streaming diarization session and return its handle.
   /// ``cluster_cadence`` controls how often VBx re-clustering runs (seconds).
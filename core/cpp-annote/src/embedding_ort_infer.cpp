@@ -42,18 +42,33 @@ void run_embedding_ort(Ort::Session& sess, Ort::MemoryInfo& mem,
                        bool fbank_first, const float* fbank_rowmajor,
                        int fbank_num_frames, int M, const float* weights,
                        int weight_num_frames, float* out, int dim) {
+  run_embedding_ort_batch(sess, mem, alloc, fbank_first, fbank_rowmajor,
+                          fbank_num_frames, M, weights, weight_num_frames, 1,
+                          out, dim);
+}
+
+void run_embedding_ort_batch(Ort::Session& sess, Ort::MemoryInfo& mem,
+                             Ort::AllocatorWithDefaultOptions& alloc,
+                             bool fbank_first, const float* fbank_rowmajor,
+                             int fbank_num_frames, int M, const float* weights,
+                             int weight_num_frames, int batch_size, float* out,
+                             int dim) {
   Ort::AllocatedStringPtr in0 = sess.GetInputNameAllocated(0, alloc);
   Ort::AllocatedStringPtr in1 = sess.GetInputNameAllocated(1, alloc);
   Ort::AllocatedStringPtr on0 = sess.GetOutputNameAllocated(0, alloc);
-  std::array<int64_t, 3> shf{1, static_cast<int64_t>(fbank_num_frames),
+  std::array<int64_t, 3> shf{static_cast<int64_t>(batch_size),
+                             static_cast<int64_t>(fbank_num_frames),
                              static_cast<int64_t>(M)};
-  std::array<int64_t, 2> shw{1, static_cast<int64_t>(weight_num_frames)};
+  std::array<int64_t, 2> shw{static_cast<int64_t>(batch_size),
+                             static_cast<int64_t>(weight_num_frames)};
   Ort::Value fb = Ort::Value::CreateTensor<float>(
       mem, const_cast<float*>(fbank_rowmajor),
-      static_cast<size_t>(fbank_num_frames) * static_cast<size_t>(M),
+      static_cast<size_t>(batch_size) * static_cast<size_t>(fbank_num_frames) *
+          static_cast<size_t>(M),
       shf.data(), shf.size());
   Ort::Value wt = Ort::Value::CreateTensor<float>(
-      mem, const_cast<float*>(weights), static_cast<size_t>(weight_num_frames),
+      mem, const_cast<float*>(weights),
+      static_cast<size_t>(batch_size) * static_cast<size_t>(weight_num_frames),
       shw.data(), shw.size());
   Ort::Value inputs[2];
   const char* in_names[2];
@@ -72,7 +87,25 @@ void run_embedding_ort(Ort::Session& sess, Ort::MemoryInfo& mem,
   auto outs =
       sess.Run(Ort::RunOptions{nullptr}, in_names, inputs, 2, out_names, 1);
   float* op = outs[0].GetTensorMutableData<float>();
-  std::memcpy(out, op, static_cast<size_t>(dim) * sizeof(float));
+  std::memcpy(out, op,
+              static_cast<size_t>(batch_size) * static_cast<size_t>(dim) *
+                  sizeof(float));
+}
+
+bool session_has_dynamic_batch(Ort::Session& sess) {
+  const size_t num_inputs = sess.GetInputCount();
+  for (size_t i = 0; i < num_inputs; ++i) {
+    const std::vector<int64_t> shape =
+        sess.GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape();
+    if (shape.empty() || shape[0] >= 0) {
+      return false;
+    }
+  }
+  return num_inputs > 0;
+}
+
+int embedding_batch_limit(Ort::Session& sess, int rows) {
+  return session_has_dynamic_batch(sess) ? std::max(1, rows) : 1;
 }
 
 int discover_min_num_samples_embedding(Ort::Session& sess, Ort::MemoryInfo& mem,
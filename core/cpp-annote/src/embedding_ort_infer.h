@@ -19,6 +19,24 @@ void run_embedding_ort(Ort::Session& sess, Ort::MemoryInfo& mem,
                        int fbank_num_frames, int M, const float* weights,
                        int weight_num_frames, float* out, int dim);
 
+/// ``run_embedding_ort`` for ``batch_size`` rows in one run: ``fbank_rowmajor``
+/// is ``(batch_size, fbank_num_frames, M)``, ``weights`` is
+/// ``(batch_size, weight_num_frames)`` and ``out`` receives
+/// ``batch_size * dim`` floats.
+void run_embedding_ort_batch(Ort::Session& sess, Ort::MemoryInfo& mem,
+                             Ort::AllocatorWithDefaultOptions& alloc,
+                             bool fbank_first, const float* fbank_rowmajor,
+                             int fbank_num_frames, int M, const float* weights,
+                             int weight_num_frames, int batch_size, float* out,
+                             int dim);
+
+/// True if every input of ``sess`` has a dynamic leading (batch) dimension.
+bool session_has_dynamic_batch(Ort::Session& sess);
+
+/// Most rows ``run_embedding_ort_batch`` may stack for ``sess``: ``rows``
+/// (at least 1) when its batch dimension is dynamic, otherwise 1.
+int embedding_batch_limit(Ort::Session& sess, int rows);
+
 int discover_min_num_samples_embedding(Ort::Session& sess, Ort::MemoryInfo& mem,
                                        Ort::AllocatorWithDefaultOptions& alloc,
                                        bool fbank_first, int embed_sr,
@@ -304,10 +304,6 @@ void cluster_vbx(const std::vector<int>& ahc_init, const Eigen::MatrixXd& fea,
                  std::vector<Eigen::VectorXd>* trace_pi, int* out_vbx_iters,
                  double* out_last_elbo_delta) {
   const int T = static_cast<int>(fea.rows());
-  const int D = static_cast<int>(fea.cols());
-  if (static_cast<int>(Phi.size()) != D) {
-    throw std::runtime_error("Phi dimension mismatch");
-  }
   if (static_cast<int>(ahc_init.size()) != T) {
     throw std::runtime_error("ahc_init length mismatch");
   }
@@ -331,6 +327,27 @@ void cluster_vbx(const std::vector<int>& ahc_init, const Eigen::MatrixXd& fea,
   pi.resize(S);
   pi.setConstant(1.0 / static_cast<double>(S));
 
+  vbx_iterate(fea, Phi, Fa, Fb, max_iters, gamma, pi, elbo_epsilon,
+              trace_gamma, trace_pi, out_vbx_iters, out_last_elbo_delta);
+}
+
+void vbx_iterate(const Eigen::MatrixXd& fea, const Eigen::VectorXd& Phi,
+                 double Fa, double Fb, int max_iters, Eigen::MatrixXd& gamma,
+                 Eigen::VectorXd& pi, double elbo_epsilon,
+                 std::vector<Eigen::MatrixXd>* trace_gamma,
+                 std::vector<Eigen::VectorXd>* trace_pi, int* out_vbx_iters,
+                 double* out_last_elbo_delta) {
+  const int T = static_cast<int>(fea.rows());
+  const int D = static_cast<int>(fea.cols());
+  if (static_cast<int>(Phi.size()) != D) {
+    throw std::runtime_error("Phi dimension mismatch");
+  }
+  if (static_cast<int>(gamma.rows()) != T ||
+      gamma.cols() != pi.size() || pi.size() == 0) {
+    throw std::runtime_error("VBx gamma/pi shape mismatch");
+  }
+  const int S = static_cast<int>(pi.size());
+
   Eigen::MatrixXd alpha;
   Eigen::MatrixXd invL;
 
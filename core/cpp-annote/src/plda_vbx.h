@@ -58,6 +58,18 @@ void cluster_vbx(const std::vector<int>& ahc_init, const Eigen::MatrixXd& fea,
                  int* out_vbx_iters = nullptr,
                  double* out_last_elbo_delta = nullptr);
 
+/// The VBx iterations of ``cluster_vbx`` from caller-supplied responsibilities
+/// ``gamma`` (T x S) and speaker priors ``pi`` (S), both updated in place.
+/// ``cluster_vbx`` calls this after initializing them from the AHC labels;
+/// a caller holding a nearby solution can start from it instead.
+void vbx_iterate(const Eigen::MatrixXd& fea, const Eigen::VectorXd& Phi,
+                 double Fa, double Fb, int max_iters, Eigen::MatrixXd& gamma,
+                 Eigen::VectorXd& pi, double elbo_epsilon = 1e-4,
+                 std::vector<Eigen::MatrixXd>* trace_gamma = nullptr,
+                 std::vector<Eigen::VectorXd>* trace_pi = nullptr,
+                 int* out_vbx_iters = nullptr,
+                 double* out_last_elbo_delta = nullptr);
+
 }  // namespace cppannote::plda_vbx
 
 #endif  // PLDA_VBX_H_
@@ -146,22 +146,147 @@ void cluster_monocrit(const double* Z, int n, const std::vector<double>& MC,
   }
 }
 
+// Indexed binary min-heap over rows 0..count-1, ordered by (keys[i], i).
+// The keys live in the caller's vector; call update(i) after changing one.
+class RowMinHeap {
+ public:
+  RowMinHeap(const std::vector<double>& keys, int count)
+      : keys_(keys),
+        heap_(static_cast<std::size_t>(count)),
+        position_(static_cast<std::size_t>(count)) {
+    for (int i = 0; i < count; ++i) {
+      heap_[static_cast<std::size_t>(i)] = i;
+      position_[static_cast<std::size_t>(i)] = i;
+    }
+    for (int p = count / 2 - 1; p >= 0; --p) {
+      sift_down(p);
+    }
+  }
+
+  int top() const { return heap_.front(); }
+
+  void update(int row) {
+    const int p = position_[static_cast<std::size_t>(row)];
+    if (p < 0) {
+      return;
+    }
+    sift_up(p);
+    sift_down(position_[static_cast<std::size_t>(row)]);
+  }
+
+  void remove(int row) {
+    const int p = position_[static_cast<std::size_t>(row)];
+    if (p < 0) {
+      return;
+    }
+    const int last = heap_.back();
+    heap_.pop_back();
+    position_[static_cast<std::size_t>(row)] = -1;
+    if (last == row) {
+      return;
+    }
+    heap_[static_cast<std::size_t>(p)] = last;
+    position_[static_cast<std::size_t>(last)] = p;
+    update(last);
+  }
+
+ private:
+  bool before(int a, int b) const {
+    const double ka = keys_[static_cast<std::size_t>(a)];
+    const double kb = keys_[static_cast<std::size_t>(b)];
+    return ka < kb || (ka == kb && a < b);
+  }
+
+  void place(int p, int row) {
+    heap_[static_cast<std::size_t>(p)] = row;
+    position_[static_cast<std::size_t>(row)] = p;
+  }
+
+  void sift_up(int p) {
+    const int row = heap_[static_cast<std::size_t>(p)];
+    while (p > 0) {
+      const int parent = (p - 1) / 2;
+      const int parent_row = heap_[static_cast<std::size_t>(parent)];
+      if (!before(row, parent_row)) {
+        break;
+      }
+      place(p, parent_row);
+      p = parent;
+    }
+    place(p, row);
+  }
+
+  void sift_down(int p) {
+    const int size = static_cast<int>(heap_.size());
+    const int row = heap_[static_cast<std::size_t>(p)];
+    while (true) {
+      int child = 2 * p + 1;
+      if (child >= size) {
+        break;
+      }
+      if (child + 1 < size &&
+          before(heap_[static_cast<std::size_t>(child + 1)],
+                 heap_[static_cast<std::size_t>(child)])) {
+        ++child;
+      }
+      const int child_row = heap_[static_cast<std::size_t>(child)];
+      if (!before(child_row, row)) {
+        break;
+      }
+      place(p, child_row);
+      p = child;
+    }
+    place(p, row);
+  }
+
+  const std::vector<double>& keys_;
+  std::vector<int> heap_;
+  std::vector<int> position_;
+};
+
 }  // namespace
 
 void pdist_euclidean(const std::vector<double>& X, int n, int d,
                      std::vector<double>& dist) {
   const std::size_t m = static_cast<std::size_t>(n * (n - 1) / 2);
   dist.assign(m, 0.0);
-  for (int i = 0; i < n; ++i) {
-    for (int j = i + 1; j < n; ++j) {
-      double s = 0.0;
-      for (int t = 0; t < d; ++t) {
-        const double a = X[static_cast<std::size_t>(i * d + t)];
-        const double b = X[static_cast<std::size_t>(j * d + t)];
-        const double di = a - b;
-        s += di * di;
+  // Four rows j at a time against a block of rows i that stays in cache.
+  // The four sums are independent, so they overlap instead of waiting on
+  // each other, but each pair still adds its d terms in order and the
+  // distances match a pair-at-a-time loop bit for bit.
+  constexpr int kRowBlock = 32;
+  const std::size_t ud = static_cast<std::size_t>(d);
+  for (int i0 = 0; i0 < n - 1; i0 += kRowBlock) {
+    const int i1 = std::min(i0 + kRowBlock, n - 1);
+    for (int j = i0 + 1; j < n; j += 4) {
+      const int columns = std::min(4, n - j);
+      // A short final group repeats its first row; those sums are dropped.
+      const double* b0 = X.data() + static_cast<std::size_t>(j) * ud;
+      const double* b1 = columns > 1 ? b0 + ud : b0;
+      const double* b2 = columns > 2 ? b0 + 2 * ud : b0;
+      const double* b3 = columns > 3 ? b0 + 3 * ud : b0;
+      const int i_end = std::min(i1, j + columns - 1);
+      for (int i = i0; i < i_end; ++i) {
+        const double* a = X.data() + static_cast<std::size_t>(i) * ud;
+        double s0 = 0.0;
+        double s1 = 0.0;
+        double s2 = 0.0;
+        double s3 = 0.0;
+        for (int t = 0; t < d; ++t) {
+          const double d0 = a[t] - b0[t];
+          const double d1 = a[t] - b1[t];
+          const double d2 = a[t] - b2[t];
+          const double d3 = a[t] - b3[t];
+          s0 += d0 * d0;
+          s1 += d1 * d1;
+          s2 += d2 * d2;
+          s3 += d3 * d3;
+        }
+        const double sums[4] = {s0, s1, s2, s3};
+        for (int c = std::max(0, i + 1 - j); c < columns; ++c) {
+          dist[condensed_index(n, i, j + c)] = std::sqrt(sums[c]);
+        }
       }
-      dist[condensed_index(n, i, j)] = std::sqrt(s);
     }
   }
 }
@@ -234,6 +359,132 @@ void linkage_centroid_naive(const std::vector<double>& dist, int n,
   }
 }
 
+void linkage_centroid(std::vector<double> dist, int n,
+                      std::vector<double>& Z) {
+  Z.assign(static_cast<std::size_t>(std::max(0, n - 1)) * 4, 0.0);
+  if (n < 2) {
+    return;
+  }
+  std::vector<double>& D = dist;
+  std::vector<int> id_map(static_cast<std::size_t>(n));
+  for (int i = 0; i < n; ++i) {
+    id_map[static_cast<std::size_t>(i)] = i;
+  }
+
+  // For each active row i, the smallest D(i, j) over j > i and the first j
+  // that attains it. Removed columns are kept at kInf in every active row
+  // above them, exactly as the naive scan leaves them, so a row's minimum
+  // can be found from its contiguous slice of the condensed matrix. A stale
+  // row's row_min is only a lower bound, and it is rescanned once it
+  // reaches the top of the heap.
+  std::vector<double> row_min(static_cast<std::size_t>(n), kInf);
+  std::vector<int> row_arg(static_cast<std::size_t>(n), -1);
+  std::vector<unsigned char> row_stale(static_cast<std::size_t>(n), 0);
+  auto rescan_row = [&](int i) {
+    double best = kInf;
+    int best_j = -1;
+    if (i < n - 1) {
+      const double* row = D.data() + condensed_index(n, i, i + 1);
+      for (int j = 0; j < n - i - 1; ++j) {
+        if (row[j] < best) {
+          best = row[j];
+          best_j = i + j + 1;
+        }
+      }
+    }
+    row_min[static_cast<std::size_t>(i)] = best;
+    row_arg[static_cast<std::size_t>(i)] = best_j;
+    row_stale[static_cast<std::size_t>(i)] = 0;
+  };
+  for (int i = 0; i < n - 1; ++i) {
+    rescan_row(i);
+  }
+  RowMinHeap heap(row_min, n - 1);
+
+  for (int merge = 0; merge < n - 1; ++merge) {
+    // The naive scan takes the first minimum in (i, j) order. The heap
+    // orders rows by (row_min, i) and each fresh row holds its first j, so
+    // once the top row is fresh it is that same pair: any row with an equal
+    // true minimum and a lower index would have a bound no higher, and so
+    // would sit above it.
+    int x = heap.top();
+    while (row_stale[static_cast<std::size_t>(x)]) {
+      rescan_row(x);
+      heap.update(x);
+      x = heap.top();
+    }
+    const double current_min = row_min[static_cast<std::size_t>(x)];
+    const int y = row_arg[static_cast<std::size_t>(x)];
+
+    const int id_x = id_map[static_cast<std::size_t>(x)];
+    const int id_y = id_map[static_cast<std::size_t>(y)];
+    int nx = 1;
+    if (id_x >= n) {
+      nx = static_cast<int>(Z[static_cast<std::size_t>(id_x - n) * 4 + 3]);
+    }
+    int ny = 1;
+    if (id_y >= n) {
+      ny = static_cast<int>(Z[static_cast<std::size_t>(id_y - n) * 4 + 3]);
+    }
+
+    Z[static_cast<std::size_t>(merge) * 4 + 0] =
+        static_cast<double>(std::min(id_x, id_y));
+    Z[static_cast<std::size_t>(merge) * 4 + 1] =
+        static_cast<double>(std::max(id_x, id_y));
+    Z[static_cast<std::size_t>(merge) * 4 + 2] = current_min;
+    Z[static_cast<std::size_t>(merge) * 4 + 3] = static_cast<double>(nx + ny);
+
+    id_map[static_cast<std::size_t>(x)] = -1;
+    id_map[static_cast<std::size_t>(y)] = n + merge;
+    heap.remove(x);
+
+    for (int i = 0; i < n; ++i) {
+      const int id_i = id_map[static_cast<std::size_t>(i)];
+      if (id_i == -1 || id_i == n + merge) {
+        continue;
+      }
+      int ni = 1;
+      if (id_i >= n) {
+        ni = static_cast<int>(Z[static_cast<std::size_t>(id_i - n) * 4 + 3]);
+      }
+      const std::size_t iy = condensed_index(n, i, y);
+      const double updated = centroid_update(D[condensed_index(n, i, x)],
+                                             D[iy], current_min, nx, ny, ni);
+      D[iy] = updated;
+      if (i < x) {
+        D[condensed_index(n, i, x)] = kInf;
+      }
+      if (i > y) {
+        // Row i only covers columns above it, which this merge left alone.
+        continue;
+      }
+      // Every other entry of row i is at least row_min, so it stays a lower
+      // bound unless the new D(i, y) falls below it, in which case that
+      // entry is the row's unique minimum.
+      const std::size_t ui = static_cast<std::size_t>(i);
+      const double bound = row_min[ui];
+      const int arg = row_arg[ui];
+      if (updated < bound) {
+        row_min[ui] = updated;
+        row_arg[ui] = y;
+        row_stale[ui] = 0;
+        heap.update(i);
+      } else if (row_stale[ui]) {
+        continue;
+      } else if (arg == x || (arg == y && updated > bound)) {
+        row_stale[ui] = 1;
+      } else if (updated == bound && y < arg) {
+        row_arg[ui] = y;
+      }
+    }
+    // Every distance in the merged cluster's own row changed.
+    if (y < n - 1) {
+      rescan_row(y);
+      heap.update(y);
+    }
+  }
+}
+
 void fcluster_distance(const std::vector<double>& Z, int n, double cutoff,
                        std::vector<int>& T) {
   std::vector<double> MD;
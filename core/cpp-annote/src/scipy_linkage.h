@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: MIT
-// SciPy-compatible helpers: condensed pdist (Euclidean), naive centroid
-// linkage, fcluster(..., criterion='distance').
+// SciPy-compatible helpers: condensed pdist (Euclidean), centroid linkage,
+// fcluster(..., criterion='distance').
 
 #ifndef SCIPY_LINKAGE_H_
 #define SCIPY_LINKAGE_H_
@@ -29,6 +29,14 @@ void pdist_euclidean(const std::vector<double>& X, int n, int d,
 void linkage_centroid_naive(const std::vector<double>& dist, int n,
                             std::vector<double>& Z);
 
+/// Same merges, distances and ``Z`` as ``linkage_centroid_naive``, bit for
+/// bit, but each cluster keeps its nearest higher-indexed neighbour so a
+/// merge only rescans the rows whose neighbour it changed: about O(n²)
+/// instead of O(n³). ``dist`` is updated in place, so pass it by move when
+/// the caller no longer needs it.
+void linkage_centroid(std::vector<double> dist, int n,
+                      std::vector<double>& Z);
+
 /// ``fcluster(Z, t, criterion='distance')`` → labels in **SciPy convention**
 /// (1..K inclusive). Implemented like SciPy: ``get_max_dist_for_each_cluster``
 /// + ``cluster_monocrit`` (not pairwise cophenetic union).
@@ -890,6 +890,94 @@ TEST_CASE("moonshine-phonemes-to-speech-c-api") {
   }
 }
 
+namespace {
+
+struct StreamedTtsAudio {
+  std::vector<std::vector<float>> chunks;
+  int32_t sample_rate = 0;
+  size_t stop_after = 0;
+};
+
+int32_t collect_streamed_tts_audio(void* user_data, const float* samples,
+                                   uint64_t sample_count, int32_t sample_rate) {
+  auto* out = static_cast<StreamedTtsAudio*>(user_data);
+  out->chunks.emplace_back(samples, samples + sample_count);
+  out->sample_rate = sample_rate;
+  return out->stop_after != 0 && out->chunks.size() >= out->stop_after;
+}
+
+}  // namespace
+
+TEST_CASE("moonshine-text-to-speech-streaming-c-api") {
+  SUBCASE("invalid-handle") {
+    StreamedTtsAudio got;
+    CHECK(moonshine_text_to_speech_streaming(
+              -1, "Hello", nullptr, 0, collect_streamed_tts_audio, &got) ==
+          MOONSHINE_ERROR_INVALID_HANDLE);
+    CHECK(got.chunks.empty());
+  }
+
+  SUBCASE("kokoro-chunks-match-length") {
+    const auto data_root = find_moonshine_tts_data_dir();
+    if (!data_root) {
+      MESSAGE("skip: moonshine-tts data directory not found");
+      return;
+    }
+    const std::string root_str = data_root->string();
+    const moonshine_option_t create_opts[] = {
+        {"model_root", root_str.c_str()},
+        {"lang", "en_us"},
+        {"voice", "kokoro_af_heart"},
+        {"normalize_audio", "false"},
+    };
+    const int32_t tts = moonshine_create_tts_synthesizer_from_files(
+        "en_us", nullptr, 0, create_opts,
+        static_cast<uint64_t>(sizeof(create_opts) / sizeof(create_opts[0])),
+        MOONSHINE_HEADER_VERSION);
+    REQUIRE(tts >= 0);
+    CHECK(moonshine_text_to_speech_streaming(tts, nullptr, nullptr, 0,
+                                             collect_streamed_tts_audio,
+                                             nullptr) ==
+          MOONSHINE_ERROR_INVALID_ARGUMENT);
+
+    const char* text =
+        "Streaming speech starts with a short first chunk, so playback can "
+        "begin quickly. The rest of this longer paragraph follows in larger "
+        "pieces while the first one is still playing.";
+    StreamedTtsAudio got;
+    REQUIRE(moonshine_text_to_speech_streaming(tts, text, nullptr, 0,
+                                               collect_streamed_tts_audio,
+                                               &got) == MOONSHINE_ERROR_NONE);
+    CHECK(got.sample_rate == 24000);
+    REQUIRE(got.chunks.size() >= 2);
+    CHECK(got.chunks[0].size() < got.chunks[1].size());
+    size_t streamed_n = 0;
+    for (const auto& c : got.chunks) {
+      streamed_n += c.size();
+    }
+
+    float* audio = nullptr;
+    uint64_t n = 0;
+    int32_t sr = 0;
+    REQUIRE(moonshine_text_to_speech(tts, text, nullptr, 0, &audio, &n, &sr) ==
+            MOONSHINE_ERROR_NONE);
+    // Chunk boundaries differ from the batch path, so only the overall
+    // duration is comparable.
+    CHECK(std::fabs(static_cast<double>(streamed_n) - static_cast<double>(n)) <
+          0.15 * static_cast<double>(n));
+    std::free(audio);
+
+    StreamedTtsAudio stopped;
+    stopped.stop_after = 1;
+    REQUIRE(moonshine_text_to_speech_streaming(tts, text, nullptr, 0,
+                                               collect_streamed_tts_audio,
+                                               &stopped) ==
+            MOONSHINE_ERROR_NONE);
+    CHECK(stopped.chunks.size() == 1);
+    moonshine_free_tts_synthesizer(tts);
+  }
+}
+
 TEST_CASE("grapheme-to-phonemizer-c-api") {
   SUBCASE("create-invalid-filenames-pointer") {
     const moonshine_option_t opts[] = {
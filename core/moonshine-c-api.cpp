@@ -158,6 +158,19 @@ void parse_transcriber_options(const OptionVector &options,
       out_options.use_speculative_decoding = bool_from_string(option_value);
     } else if (option_name == "decode_incomplete_lines") {
       out_options.decode_incomplete_lines = bool_from_string(option_value);
+    } else if (option_name == "decoder_batch_max_wait_ms") {
+      out_options.decoder_batch_max_wait_ms = float_from_string(option_value);
+    } else if (option_name == "decoder_batch_max_size") {
+      out_options.decoder_batch_max_size = int32_from_string(option_value);
+    } else if (option_name == "vad_batch_max_wait_ms") {
+      out_options.vad_batch_max_wait_ms = float_from_string(option_value);
+    } else if (option_name == "vad_batch_max_size") {
+      out_options.vad_batch_max_size = int32_from_string(option_value);
+    } else if (option_name == "incremental_decoding") {
+      out_options.incremental_decoding = bool_from_string(option_value);
+    } else if (option_name == "incremental_min_new_samples") {
+      out_options.incremental_min_new_samples =
+          size_t_from_string(option.second);
     } else if (option_name == "keyterms") {
       out_options.keyterms = parse_keyterms(option_value);
     } else if (option_name == "keyterm_boost") {
@@ -175,6 +188,8 @@ void parse_transcriber_options(const OptionVector &options,
     } else if (option_name == "diarization_cluster_window_sec") {
       out_options.diarization_cluster_window_sec =
           float_from_string(option_value);
+    } else if (option_name == "diarization_threads") {
+      out_options.diarization_threads = int32_from_string(option_value);
     } else if (option_name == "diarization_model_dir") {
       out_options.diarization_model_dir = option_value;
     } else if (option_name == "return_audio_data") {
@@ -1224,10 +1239,18 @@ void maybe_autotranscribe_zipvoice_clone(
   }
 }
 
+// Looks a synthesizer up under the table lock, so threads can synthesize on
+// their own handles while others create or free theirs.
+moonshine_tts::MoonshineTTS *find_tts_synthesizer(int32_t handle) {
+  std::lock_guard<std::mutex> lock(text_to_speech_synthesizer_map_mutex);
+  const auto it = text_to_speech_synthesizer_map.find(handle);
+  return it == text_to_speech_synthesizer_map.end() ? nullptr : it->second;
+}
+
 #define CHECK_TTS_SYNTHESIZER_HANDLE(synth_handle)                             \
   do {                                                                         \
     if ((synth_handle) < 0 ||                                                  \
-        !text_to_speech_synthesizer_map.contains((synth_handle))) {            \
+        find_tts_synthesizer((synth_handle)) == nullptr) {                     \
       LOGF(                                                                    \
           "Moonshine text to speech synthesizer handle is invalid: handle %d", \
           (int)(synth_handle));                                                \
@@ -1541,7 +1564,7 @@ int32_t moonshine_text_to_speech(int32_t tts_synthesizer_handle,
   CHECK_TTS_SYNTHESIZER_HANDLE(tts_synthesizer_handle);
   try {
     moonshine_tts::MoonshineTTS *synth =
-        text_to_speech_synthesizer_map[tts_synthesizer_handle];
+        find_tts_synthesizer(tts_synthesizer_handle);
     const std::vector<std::pair<std::string, std::string>> tts_pairs =
         tts_option_pairs_from_c(options, options_count);
     const std::vector<float> wave = tts_pairs.empty()
@@ -1594,7 +1617,7 @@ int32_t moonshine_phonemes_to_speech(int32_t tts_synthesizer_handle,
   CHECK_TTS_SYNTHESIZER_HANDLE(tts_synthesizer_handle);
   try {
     moonshine_tts::MoonshineTTS *synth =
-        text_to_speech_synthesizer_map[tts_synthesizer_handle];
+        find_tts_synthesizer(tts_synthesizer_handle);
     const std::vector<std::pair<std::string, std::string>> tts_pairs =
         tts_option_pairs_from_c(options, options_count);
     const std::vector<float> wave =
@@ -1621,6 +1644,82 @@ int32_t moonshine_phonemes_to_speech(int32_t tts_synthesizer_handle,
 
 namespace {
 
+/* Shared body of the two streaming entry points; ``run`` performs the
+   synthesis given the option pairs and the C++ chunk callback. */
+template <typename Run>
+int32_t tts_streaming_call(int32_t tts_synthesizer_handle,
+                           const struct moonshine_option_t *options,
+                           uint64_t options_count,
+                           moonshine_tts_audio_callback_t callback,
+                           void *user_data, Run &&run) {
+  CHECK_TTS_SYNTHESIZER_HANDLE(tts_synthesizer_handle);
+  try {
+    moonshine_tts::MoonshineTTS *synth =
+        find_tts_synthesizer(tts_synthesizer_handle);
+    const std::vector<std::pair<std::string, std::string>> tts_pairs =
+        tts_option_pairs_from_c(options, options_count);
+    const moonshine_tts::TtsAudioChunkCallback on_audio =
+        [callback, user_data](const float *samples, size_t sample_count) {
+          return callback(user_data, samples,
+                          static_cast<uint64_t>(sample_count),
+                          moonshine_tts::MoonshineTTS::kSampleRateHz) == 0;
+        };
+    run(*synth, tts_pairs, on_audio);
+  } catch (const std::exception &e) {
+    LOGF("Failed to stream speech synthesis: %s", e.what());
+    return MOONSHINE_ERROR_UNKNOWN;
+  }
+  return MOONSHINE_ERROR_NONE;
+}
+
+}  // namespace
+
+int32_t moonshine_text_to_speech_streaming(
+    int32_t tts_synthesizer_handle, const char *text,
+    const struct moonshine_option_t *options, uint64_t options_count,
+    moonshine_tts_audio_callback_t callback, void *user_data) {
+  if (log_api_calls) {
+    LOGF(
+        "moonshine_text_to_speech_streaming(handle=%d, text=%s, options=%p, "
+        "options_count=%" PRIu64 ", callback=%s, user_data=%p)",
+        tts_synthesizer_handle, text, static_cast<const void *>(options),
+        options_count, callback != nullptr ? "set" : "NULL", user_data);
+  }
+  if (text == nullptr || callback == nullptr) {
+    return MOONSHINE_ERROR_INVALID_ARGUMENT;
+  }
+  return tts_streaming_call(
+      tts_synthesizer_handle, options, options_count, callback, user_data,
+      [text](moonshine_tts::MoonshineTTS &synth, const auto &pairs,
+             const moonshine_tts::TtsAudioChunkCallback &on_audio) {
+        synth.synthesize_streaming(text, pairs, on_audio);
+      });
+}
+
+int32_t moonshine_phonemes_to_speech_streaming(
+    int32_t tts_synthesizer_handle, const char *phonemes,
+    const struct moonshine_option_t *options, uint64_t options_count,
+    moonshine_tts_audio_callback_t callback, void *user_data) {
+  if (log_api_calls) {
+    LOGF(
+        "moonshine_phonemes_to_speech_streaming(handle=%d, phonemes=%s, "
+        "options=%p, options_count=%" PRIu64 ", callback=%s, user_data=%p)",
+        tts_synthesizer_handle, phonemes, static_cast<const void *>(options),
+        options_count, callback != nullptr ? "set" : "NULL", user_data);
+  }
+  if (phonemes == nullptr || callback == nullptr) {
+    return MOONSHINE_ERROR_INVALID_ARGUMENT;
+  }
+  return tts_streaming_call(
+      tts_synthesizer_handle, options, options_count, callback, user_data,
+      [phonemes](moonshine_tts::MoonshineTTS &synth, const auto &pairs,
+                 const moonshine_tts::TtsAudioChunkCallback &on_audio) {
+        synth.synthesize_from_phonemes_streaming(phonemes, pairs, on_audio);
+      });
+}
+
+namespace {
+
 char *malloc_string_copy(const std::string &s) {
   char *p = static_cast<char *>(std::malloc(s.size() + 1));
   if (p == nullptr) {
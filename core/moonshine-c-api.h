@@ -399,6 +399,24 @@ MOONSHINE_EXPORT const char *moonshine_transcript_to_string(
    decoder on in-progress lines so the transcript can update while someone
    is still talking. Set false to encode (and diarize) as audio arrives
    but wait until the line is complete before decoding.
+   Pass ``decoder_batch_max_wait_ms`` (float, default 0) to let streams of a
+   streaming-architecture transcriber that decode at the same time share
+   batched decoder runs; it is how long the first waiting step holds a batch
+   open for the others, and 0 leaves batching off. ``decoder_batch_max_size``
+   (int, default 8) caps the streams per run. Decodes with key terms or word
+   timestamps are not batched.
+   Pass ``vad_batch_max_wait_ms`` (float, default 0) to let started streams
+   whose ``moonshine_transcribe_stream`` calls arrive at the same time share
+   voice activity detection runs; it is how long the first waiting call holds
+   a batch open for the others, and 0 leaves batching off.
+   ``vad_batch_max_size`` (int, default 16) caps the streams per batch.
+   Pass ``incremental_decoding`` (bool, default false) to have the
+   non-streaming architectures use the previous decode of an in-progress line
+   as a draft, checked in a single decoder run, instead of decoding each
+   update from scratch; the text is unchanged. With it,
+   ``incremental_min_new_samples`` (int, default 0) keeps the previous text
+   for an in-progress line that has grown by fewer than that many 16 kHz
+   samples.
    Pass ``keyterms`` (comma-separated terms, e.g.
    ``Kubernetes,Anushka Sharma,ANSI/ISO``) to bias the decoder towards words it
    would otherwise be unlikely to produce - jargon, product names, contact
@@ -432,6 +450,9 @@ MOONSHINE_EXPORT const char *moonshine_transcript_to_string(
    embedding inference), and ``diarization_cluster_window_sec``
    (float seconds, default 120.0) limits how much audio history VBx
    re-clustering considers on each refresh (0 = unlimited full history).
+   ``diarization_threads`` (int, default 1) shares the segmentation and
+   embedding work of non-streaming transcription across that many threads
+   (0 = one per hardware thread).
    Pass ``"spelling_model_path"`` with a path to a
    spelling-CNN ``.ort`` file (e.g.
    ``https://download.moonshine.ai/model/spelling-en/spelling_cnn.ort``)
@@ -1187,6 +1208,43 @@ MOONSHINE_EXPORT int32_t moonshine_phonemes_to_speech(
     float **out_audio_data, uint64_t *out_audio_data_size,
     int32_t *out_sample_rate);
 
+/* Receives streamed text-to-speech audio: ``sample_count`` mono float samples
+   in ``[-1, 1]`` at ``sample_rate`` Hz, consecutive with the previous call.
+   ``samples`` is owned by the library and only valid during the call.
+   Return zero to continue, or non-zero to stop synthesis after this chunk.
+   The callback runs on the calling thread and must not use the same
+   synthesizer handle. */
+typedef int32_t (*moonshine_tts_audio_callback_t)(void *user_data,
+                                                  const float *samples,
+                                                  uint64_t sample_count,
+                                                  int32_t sample_rate);
+
+/* Streaming form of ``moonshine_text_to_speech``: instead of returning one
+   buffer, calls ``callback`` with each chunk's audio as soon as it has been
+   vocoded, starting with a deliberately short first chunk so playback can
+   begin early. Blocks until synthesis finishes or ``callback`` asks to stop.
+   ``options`` / ``options_count`` are the same per-call overrides as
+   ``moonshine_text_to_speech``. With ``normalize_audio`` enabled the gain is
+   set by the first chunk's peak and held for the whole utterance, and a
+   limiter keeps louder later peaks within full scale. The level matches
+   the non-streaming call when the first chunk holds the loudest peak and
+   is otherwise louder.
+
+   Returns zero on success (including an early stop requested by
+   ``callback``), or a non-zero error code on failure.
+*/
+MOONSHINE_EXPORT int32_t moonshine_text_to_speech_streaming(
+    int32_t tts_synthesizer_handle, const char *text,
+    const struct moonshine_option_t *options, uint64_t options_count,
+    moonshine_tts_audio_callback_t callback, void *user_data);
+
+/* Streaming form of ``moonshine_phonemes_to_speech``; see
+   ``moonshine_text_to_speech_streaming``. */
+MOONSHINE_EXPORT int32_t moonshine_phonemes_to_speech_streaming(
+    int32_t tts_synthesizer_handle, const char *phonemes,
+    const struct moonshine_option_t *options, uint64_t options_count,
+    moonshine_tts_audio_callback_t callback, void *user_data);
+
 /* Creates a grapheme to phonemizer from files on disk.
    Returns a non-negative handle on success, or a negative error code on
    failure. The error code can be converted to a human-readable string using
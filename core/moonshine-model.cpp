@@ -25,7 +25,9 @@
 #include <array>
 #include <chrono>
 #include <map>
+#include <memory>
 #include <numeric>
+#include <utility>
 #include <vector>
 
 #include "bin-tokenizer.h"
@@ -77,6 +79,24 @@ int set_model_options_from_arch(MoonshineModel *model, int32_t model_arch) {
   }
   return 0;
 }
+
+// Drops every position after the first ``count`` from a [1, heads,
+// positions, head_dim] key or value cache, compacting the kept rows of each
+// head to the front of the buffer.
+void keep_leading_positions(float *data, int64_t heads, int64_t positions,
+                            int64_t count, int64_t head_dim) {
+  if (count >= positions) {
+    return;
+  }
+  for (int64_t h = 1; h < heads; h++) {
+    memmove(data + h * count * head_dim, data + h * positions * head_dim,
+            count * head_dim * sizeof(float));
+  }
+}
+
+int64_t argmax_row(const float *row, size_t count) {
+  return static_cast<int64_t>(std::max_element(row, row + count) - row);
+}
 }  // namespace
 
 MoonshineModel::MoonshineModel(
@@ -124,6 +144,7 @@ MoonshineModel::MoonshineModel(
 }
 
 MoonshineModel::~MoonshineModel() {
+  free_decoder_io_names();
   ort_api->ReleaseEnv(ort_env);
   ort_api->ReleaseMemoryInfo(ort_memory_info);
   ort_api->ReleaseSessionOptions(ort_session_options);
@@ -157,6 +178,7 @@ int MoonshineModel::load(const char *encoder_model_path,
   RETURN_ON_NULL(decoder_session);
   tokenizer = new BinTokenizer(tokenizer_path);
   RETURN_ON_NULL(tokenizer);
+  RETURN_ON_ERROR(load_decoder_io());
   return 0;
 }
 
@@ -179,6 +201,7 @@ int MoonshineModel::load_from_memory(const uint8_t *encoder_model_data,
   RETURN_ON_NULL(decoder_session);
   tokenizer = new BinTokenizer(tokenizer_data, tokenizer_data_size);
   RETURN_ON_NULL(tokenizer);
+  RETURN_ON_ERROR(load_decoder_io());
   return 0;
 }
 
@@ -209,12 +232,21 @@ int MoonshineModel::load_from_assets(const char *encoder_model_path,
     LOGF("Failed to load tokenizer from '%s'\n", tokenizer_path);
     return 1;
   }
+  RETURN_ON_ERROR(load_decoder_io());
   return 0;
 }
 #endif
 
 int MoonshineModel::transcribe(const float *input_audio_data,
                                size_t input_audio_data_size, char **out_text) {
+  return transcribe_with_draft(input_audio_data, input_audio_data_size, {},
+                               nullptr, out_text);
+}
+
+int MoonshineModel::transcribe_with_draft(
+    const float *input_audio_data, size_t input_audio_data_size,
+    const std::vector<int64_t> &draft_tokens, std::vector<int64_t> *tokens_out,
+    char **out_text) {
   // TIMER_START(moonshine_transcribe);
 
   *out_text = nullptr;
@@ -228,8 +260,18 @@ int MoonshineModel::transcribe(const float *input_audio_data,
   size_t encoder_output_count = 0;
   RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetOutputCount(
                                    encoder_session, &encoder_output_count));
-  std::vector<char *> encoder_input_names(encoder_input_count);
-  std::vector<char *> encoder_output_names(encoder_output_count);
+  std::vector<char *> encoder_input_names(encoder_input_count, nullptr);
+  std::vector<char *> encoder_output_names(encoder_output_count, nullptr);
+  ScopeExit free_encoder_names([&]() {
+    for (std::vector<char *> *names :
+         {&encoder_input_names, &encoder_output_names}) {
+      for (char *name : *names) {
+        if (name != nullptr) {
+          ort_string_allocator->base.Free(&ort_string_allocator->base, name);
+        }
+      }
+    }
+  });
   for (size_t i = 0; i < encoder_input_count; i++) {
     RETURN_ON_ORT_ERROR(ort_api,
                         ort_api->SessionGetInputName(
@@ -246,7 +288,7 @@ int MoonshineModel::transcribe(const float *input_audio_data,
       ort_get_input_shape(ort_api, encoder_session, 0);
   encoder_input_shape[0] = 1;
   encoder_input_shape[1] = input_audio_data_size;
-  MoonshineTensorView *encoder_input_tensor = new MoonshineTensorView(
+  auto encoder_input_tensor = std::make_unique<MoonshineTensorView>(
       encoder_input_shape, ort_get_input_type(ort_api, encoder_session, 0),
       const_cast<float *>(input_audio_data), "encoder_input_tensor");
   std::vector<OrtValue *> encoder_inputs;
@@ -254,40 +296,34 @@ int MoonshineModel::transcribe(const float *input_audio_data,
       encoder_input_tensor->create_ort_value(ort_api, ort_memory_info));
   // Newer versions of the optimum onnx converter include an attention mask
   // input.
-  MoonshineTensorView *encoder_attention_mask_tensor = nullptr;
+  std::unique_ptr<MoonshineTensorView> encoder_attention_mask_tensor;
   if (encoder_input_count > 1) {
-    encoder_attention_mask_tensor = new MoonshineTensorView(
-        {1, static_cast<int64_t>(input_audio_data_size)}, MOONSHINE_DTYPE_INT64,
-        nullptr, "encoder_attention_mask");
+    encoder_attention_mask_tensor = std::make_unique<MoonshineTensorView>(
+        std::vector<int64_t>{1, static_cast<int64_t>(input_audio_data_size)},
+        MOONSHINE_DTYPE_INT64, nullptr, "encoder_attention_mask");
     for (size_t i = 0; i < input_audio_data_size; i++) {
       encoder_attention_mask_tensor->data<int64_t>()[i] = 1;
     }
     encoder_inputs.push_back(encoder_attention_mask_tensor->create_ort_value(
         ort_api, ort_memory_info));
   }
-  std::vector<OrtValue *> encoder_outputs(encoder_output_count);
+  std::vector<OrtValue *> encoder_outputs(encoder_output_count, nullptr);
   // TIMER_START(moonshine_encoder_run);
-  RETURN_ON_ORT_ERROR(
-      ort_api, ORT_RUN(ort_api, encoder_session, encoder_input_names.data(),
-                       encoder_inputs.data(), encoder_input_count,
-                       encoder_output_names.data(), encoder_output_count,
-                       encoder_outputs.data()));
+  OrtStatus *encoder_status =
+      ORT_RUN(ort_api, encoder_session, encoder_input_names.data(),
+              encoder_inputs.data(), encoder_input_count,
+              encoder_output_names.data(), encoder_output_count,
+              encoder_outputs.data());
   // TIMER_END(moonshine_encoder_run);
   for (size_t i = 0; i < encoder_inputs.size(); i++) {
     ort_api->ReleaseValue(encoder_inputs[i]);
   }
-  for (char *encoder_input_name : encoder_input_names) {
-    ort_string_allocator->base.Free(&ort_string_allocator->base,
-                                    encoder_input_name);
+  RETURN_ON_ORT_ERROR(ort_api, encoder_status);
+  auto last_hidden_state_tensor = std::make_unique<MoonshineTensorView>(
+      ort_api, encoder_outputs[0], "last_hidden_state_tensor");
+  for (OrtValue *encoder_output : encoder_outputs) {
+    ort_api->ReleaseValue(encoder_output);
   }
-  for (char *encoder_output_name : encoder_output_names) {
-    ort_string_allocator->base.Free(&ort_string_allocator->base,
-                                    encoder_output_name);
-  }
-  OrtValue *last_hidden_state = encoder_outputs[0];
-  MoonshineTensorView *last_hidden_state_tensor = new MoonshineTensorView(
-      ort_api, last_hidden_state, "last_hidden_state_tensor");
-  ort_api->ReleaseValue(last_hidden_state);
 
   // Save encoder hidden states for word alignment (if alignment model loaded)
   if (alignment_session != nullptr) {
@@ -301,245 +337,338 @@ int MoonshineModel::transcribe(const float *input_audio_data,
            last_hidden_state_tensor->data<float>(), total * sizeof(float));
   }
 
-  delete encoder_input_tensor;
-  encoder_input_tensor = nullptr;
-
-  size_t decoder_input_count;
-  RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetInputCount(
-                                   decoder_session, &decoder_input_count));
+  encoder_input_tensor.reset();
 
-  const size_t expected_decoder_input_count_v1 = (num_layers * 4) + 3;
-  const size_t expected_decoder_input_count_v2 = (num_layers * 4) + 4;
-  if ((decoder_input_count != expected_decoder_input_count_v1) &&
-      (decoder_input_count != expected_decoder_input_count_v2)) {
-    LOGF(
-        "Expected decoder input count to be %zu or "
-        "%zu, but got %zu. This "
-        "often indicates you're specifying the "
-        "wrong model architecture "
-        "(for example tiny instead of base).\n",
-        expected_decoder_input_count_v1, expected_decoder_input_count_v2,
-        decoder_input_count);
-    return 1;
-  }
+  RETURN_ON_ERROR(load_decoder_io());
 
-  std::vector<const char *> decoder_input_names(decoder_input_count);
-  for (size_t i = 0; i < decoder_input_count; i++) {
-    char *decoder_input_name = nullptr;
-    RETURN_ON_ORT_ERROR(
-        ort_api, ort_api->SessionGetInputName(decoder_session, i,
-                                              &ort_string_allocator->base,
-                                              &decoder_input_name));
-    decoder_input_names[i] = decoder_input_name;
-  }
-  size_t decoder_output_count;
-  RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetOutputCount(
-                                   decoder_session, &decoder_output_count));
-  std::vector<const char *> decoder_output_names(decoder_output_count);
-  for (size_t i = 0; i < decoder_output_count; i++) {
-    char *decoder_output_name = nullptr;
-    RETURN_ON_ORT_ERROR(
-        ort_api, ort_api->SessionGetOutputName(decoder_session, i,
-                                               &ort_string_allocator->base,
-                                               &decoder_output_name));
-    decoder_output_names[i] = decoder_output_name;
-  }
   const float audio_duration = input_audio_data_size / 16000.0f;
   const int max_len =
       static_cast<int>(std::ceil(audio_duration * this->max_tokens_per_second));
-  auto decoder_input_name_to_index = name_to_index(decoder_input_names);
-  auto decoder_output_name_to_index = name_to_index(decoder_output_names);
-  std::vector<std::string> layer_suffixes;
-  std::map<std::string, MoonshineTensorView *> past_key_values_by_name;
-  for (int i = 0; i < num_layers; i++) {
-    for (const char *a : {"decoder", "encoder"}) {
-      for (const char *b : {"key", "value"}) {
-        std::vector<int64_t> past_key_values_shape = {1, num_kv_heads, 1,
-                                                      head_dim};
-        std::string layer_suffix = std::to_string(i) + "." + a + "." + b;
-        layer_suffixes.push_back(layer_suffix);
-        std::string past_key_values_name = "past_key_values." + layer_suffix;
-        MoonshineTensorView *tensor_and_data = new MoonshineTensorView(
-            past_key_values_shape, MOONSHINE_DTYPE_FLOAT32, nullptr,
-            TENSOR_NAME(past_key_values_name));
-        past_key_values_by_name[past_key_values_name] = tensor_and_data;
-      }
-    }
-  }
 
   std::vector<int64_t> tokens = {MOONSHINE_DECODER_START_TOKEN_ID};
+  tokens.reserve(max_len + 1);
   std::vector<int64_t> inputIDs = tokens;
 
+  // The first run has no cache yet, so it can take the whole draft at no
+  // extra cost in runs. Decoders that emit cross attentions expect one
+  // entry per step, so they always decode from scratch.
+  last_decoder_run_count = 0;
+  last_draft_tokens_accepted = 0;
+  size_t draft_len = 0;
+  if (decoder_attention_indices.empty() && max_len > 0) {
+    while (draft_len < draft_tokens.size() &&
+           draft_len + 1 < static_cast<size_t>(max_len) &&
+           draft_tokens[draft_len] != MOONSHINE_EOS_TOKEN_ID) {
+      draft_len++;
+    }
+    inputIDs.insert(inputIDs.end(), draft_tokens.begin(),
+                    draft_tokens.begin() + draft_len);
+  }
+
+  // Size every buffer for the longest output this clip allows, so the loop
+  // below never grows or copies them. It still wraps them in new OrtValues on
+  // every step, because their shapes change as the cache grows, but those
+  // only point at the data. Self-attention caches hold a position per token
+  // fed to the decoder, cross-attention ones a position per encoder frame.
+  const int64_t encoder_frames = last_hidden_state_tensor->shape()[1];
+  const size_t head_size = static_cast<size_t>(num_kv_heads) * head_dim;
+  const size_t decoder_kv_capacity = head_size * (max_len + 1);
+  const size_t encoder_kv_size = head_size * encoder_frames;
+  for (int layer = 0; layer < num_layers; layer++) {
+    for (int kind = 0; kind < MOONSHINE_KV_KIND_COUNT; kind++) {
+      const bool is_encoder = kind >= MOONSHINE_KV_ENCODER_KEY;
+      reserve_decode_buffer(&past_kv[layer][kind],
+                            is_encoder ? encoder_kv_size : decoder_kv_capacity);
+      reserve_decode_buffer(&present_kv[layer][kind],
+                            is_encoder ? head_size : decoder_kv_capacity);
+    }
+  }
+  if (decoder_vocab_size > 0) {
+    reserve_decode_buffer(&decoder_logits,
+                          inputIDs.size() * decoder_vocab_size);
+  }
+
+  auto wrap = [this](void *data, size_t bytes, const int64_t *shape,
+                     size_t rank, ONNXTensorElementDataType type) {
+    OrtValue *value = nullptr;
+    LOG_ORT_ERROR(ort_api, ort_api->CreateTensorWithDataAsOrtValue(
+                               ort_memory_info, data, bytes, shape, rank, type,
+                               &value));
+    return value;
+  };
+  const ONNXTensorElementDataType f32 = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+  const ONNXTensorElementDataType i64 = ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64;
+
+  // Inputs that are the same on every step are wrapped once. The cached
+  // cross-attention keys and values join them after the first step.
+  std::vector<OrtValue *> steady_values;
+  OrtValue *encoder_hidden_states_value =
+      last_hidden_state_tensor->create_ort_value(ort_api, ort_memory_info);
+  steady_values.push_back(encoder_hidden_states_value);
+  // The attention mask is optional: the attention-enabled decoder
+  // (decoder_with_attention.ort) omits this input since it was not
+  // present in the original HuggingFace export. Only pass it if
+  // the decoder actually accepts it.
+  OrtValue *encoder_attention_mask_value = nullptr;
+  if (encoder_attention_mask_tensor != nullptr &&
+      decoder_encoder_attention_mask_index >= 0) {
+    encoder_attention_mask_value =
+        encoder_attention_mask_tensor->create_ort_value(ort_api,
+                                                        ort_memory_info);
+    steady_values.push_back(encoder_attention_mask_value);
+  }
+  uint8_t use_cache_branch_data[2] = {0, 1};
+  const int64_t use_cache_branch_shape[1] = {1};
+  OrtValue *use_cache_branch_values[2];
+  for (int i = 0; i < 2; i++) {
+    use_cache_branch_values[i] =
+        wrap(&use_cache_branch_data[i], 1, use_cache_branch_shape,
+             1, ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL);
+    steady_values.push_back(use_cache_branch_values[i]);
+  }
+  std::vector<OrtValue *> encoder_kv_values(num_layers * 2, nullptr);
+  // Where cache-branch steps write the cross-attention caches the decoder
+  // echoes back. Null until the first such step has shown their shapes.
+  std::vector<OrtValue *> encoder_kv_echo_values(num_layers * 2, nullptr);
+  bool encoder_kv_echo_known = false;
+  // Lets go of a run's outputs. The echo wrappers are steady values, so they
+  // are only taken out of the output slots here.
+  auto release_outputs = [this, &encoder_kv_echo_values]() {
+    for (OrtValue *&value : decoder_output_values) {
+      if (std::find(encoder_kv_echo_values.begin(),
+                    encoder_kv_echo_values.end(),
+                    value) == encoder_kv_echo_values.end()) {
+        ort_api->ReleaseValue(value);
+      }
+      value = nullptr;
+    }
+  };
+  // Every way out of the decoding loop, early error returns included, lets go
+  // of the values wrapped around the buffers.
+  auto release_values = [this, &steady_values, &release_outputs]() {
+    for (OrtValue *&value : decoder_step_values) {
+      ort_api->ReleaseValue(value);
+    }
+    decoder_step_values.clear();
+    release_outputs();
+    for (OrtValue *&value : steady_values) {
+      ort_api->ReleaseValue(value);
+    }
+    steady_values.clear();
+  };
+  ScopeExit release_on_exit(release_values);
+
   // Buffer for collecting cross-attention weights during single-pass decoding.
-  // Filled when the decoder model has cross_attentions.* outputs.
+  // Filled when the decoder model has cross_attentions.* outputs, and the one
+  // thing in the loop that still grows as it goes.
   std::vector<float> cross_attention_buffer;
   int cross_attn_heads = 0;
   int cross_attn_enc_len = 0;
   int cross_attn_steps = 0;
 
+  int64_t cache_len = 0;
   for (int token_index = 0; token_index < max_len; token_index++) {
     const bool use_cache_branch = token_index > 0;
-    std::vector<MoonshineTensorView *> decoder_inputs_data(decoder_input_count);
-
-    std::vector<int64_t> input_ids_shape = {
-        1, static_cast<int64_t>(inputIDs.size())};
-    const int64_t input_ids_index = decoder_input_name_to_index["input_ids"];
-    decoder_inputs_data[input_ids_index] =
-        new MoonshineTensorView(input_ids_shape, MOONSHINE_DTYPE_INT64,
-                                inputIDs.data(), TENSOR_NAME("input_ids"));
-
-    const int64_t encoder_hidden_states_index =
-        decoder_input_name_to_index["encoder_hidden_states"];
-    decoder_inputs_data[encoder_hidden_states_index] =
-        new MoonshineTensorView(*last_hidden_state_tensor);
-
-    // The attention mask is optional: the attention-enabled decoder
-    // (decoder_with_attention.ort) omits this input since it was not
-    // present in the original HuggingFace export. Only pass it if
-    // the decoder actually accepts it.
-    if (encoder_attention_mask_tensor != nullptr &&
-        decoder_input_name_to_index.find("encoder_attention_mask") !=
-            decoder_input_name_to_index.end()) {
-      const int64_t encoder_attention_mask_index =
-          decoder_input_name_to_index["encoder_attention_mask"];
-      decoder_inputs_data[encoder_attention_mask_index] =
-          new MoonshineTensorView(*encoder_attention_mask_tensor);
+    const int64_t input_len = static_cast<int64_t>(inputIDs.size());
+    // The first step ignores its past inputs, so they are one-position
+    // placeholders, and its present outputs hold only the fed tokens.
+    const int64_t past_len = use_cache_branch ? cache_len : 1;
+    const int64_t present_len = (use_cache_branch ? cache_len : 0) + input_len;
+    const int64_t input_ids_shape[2] = {1, input_len};
+    const int64_t past_shape[4] = {1, num_kv_heads, past_len, head_dim};
+    const int64_t present_shape[4] = {1, num_kv_heads, present_len, head_dim};
+    const int64_t encoder_kv_shape[4] = {1, num_kv_heads, encoder_frames,
+                                         head_dim};
+    const int64_t logits_shape[3] = {1, input_len, decoder_vocab_size};
+
+    auto step_input = [&](void *data, size_t bytes, const int64_t *shape,
+                          size_t rank, ONNXTensorElementDataType type) {
+      OrtValue *value = wrap(data, bytes, shape, rank, type);
+      decoder_step_values.push_back(value);
+      return value;
+    };
+    decoder_input_values[decoder_input_ids_index] =
+        step_input(inputIDs.data(), input_len * sizeof(int64_t),
+                   input_ids_shape, 2, i64);
+    decoder_input_values[decoder_encoder_hidden_states_index] =
+        encoder_hidden_states_value;
+    if (decoder_encoder_attention_mask_index >= 0) {
+      decoder_input_values[decoder_encoder_attention_mask_index] =
+          encoder_attention_mask_value;
     }
-
-    std::vector<uint8_t> use_cache_branch_vector = {
-        use_cache_branch ? static_cast<uint8_t>(1) : static_cast<uint8_t>(0)};
-    std::vector<int64_t> use_cache_branch_shape = {1};
-    const int64_t use_cache_branch_index =
-        decoder_input_name_to_index["use_cache_branch"];
-    decoder_inputs_data[use_cache_branch_index] = new MoonshineTensorView(
-        use_cache_branch_shape, MOONSHINE_DTYPE_BOOL,
-        use_cache_branch_vector.data(), TENSOR_NAME("use_cache_branch"));
-    for (const auto &[key, value] : past_key_values_by_name) {
-      RETURN_ON_FALSE(decoder_input_name_to_index.find(key) !=
-                      decoder_input_name_to_index.end());
-      const int64_t key_index = decoder_input_name_to_index[key];
-      if (decoder_inputs_data[key_index] != nullptr) {
-        LOGF(
-            "Decoder input data for key %s is not "
-            "nullptr\n",
-            key.c_str());
-        return 1;
+    decoder_input_values[decoder_use_cache_branch_index] =
+        use_cache_branch_values[use_cache_branch ? 1 : 0];
+    for (int layer = 0; layer < num_layers; layer++) {
+      const auto &past_indices = decoder_past_indices[layer];
+      const auto &present_indices = decoder_present_indices[layer];
+      for (int kind : {MOONSHINE_KV_DECODER_KEY, MOONSHINE_KV_DECODER_VALUE}) {
+        decoder_input_values[past_indices[kind]] = step_input(
+            past_kv[layer][kind].data(), head_size * past_len * sizeof(float),
+            past_shape, 4, f32);
+        decoder_output_values[present_indices[kind]] =
+            wrap(present_kv[layer][kind].data(),
+                 head_size * present_len * sizeof(float), present_shape, 4,
+                 f32);
+      }
+      for (int kind : {MOONSHINE_KV_ENCODER_KEY, MOONSHINE_KV_ENCODER_VALUE}) {
+        const int cache = layer * 2 + kind - MOONSHINE_KV_ENCODER_KEY;
+        if (use_cache_branch) {
+          // The cache branch of some exports echoes these back in a
+          // different shape, so the first such step leaves the outputs to
+          // ORT, and the ones after write them to scratch of that shape.
+          decoder_input_values[past_indices[kind]] = encoder_kv_values[cache];
+          decoder_output_values[present_indices[kind]] =
+              encoder_kv_echo_values[cache];
+          continue;
+        }
+        decoder_input_values[past_indices[kind]] = step_input(
+            present_kv[layer][kind].data(), head_size * sizeof(float),
+            past_shape, 4, f32);
+        decoder_output_values[present_indices[kind]] =
+            wrap(past_kv[layer][kind].data(), encoder_kv_size * sizeof(float),
+                 encoder_kv_shape, 4, f32);
       }
-      decoder_inputs_data[key_index] = new MoonshineTensorView(*value);
     }
-    std::vector<OrtValue *> decoder_inputs;
-    for (size_t i = 0; i < decoder_input_count; i++) {
-      MoonshineTensorView *decoder_view = decoder_inputs_data[i];
-      if (decoder_view == nullptr) {
+    if (decoder_vocab_size > 0) {
+      decoder_output_values[decoder_logits_index] =
+          wrap(decoder_logits.data(),
+               input_len * decoder_vocab_size * sizeof(float), logits_shape, 3,
+               f32);
+    }
+    for (size_t i = 0; i < decoder_input_values.size(); i++) {
+      if (decoder_input_values[i] == nullptr) {
         LOGF("Decoder input %s is nullptr\n", decoder_input_names[i]);
         return 1;
       }
-      decoder_inputs.push_back(
-          decoder_view->create_ort_value(ort_api, ort_memory_info));
     }
 
     // TIMER_START(moonshine_decoder_run);
-    std::vector<OrtValue *> decoder_outputs(decoder_output_count);
-    RETURN_ON_ORT_ERROR(
-        ort_api, ORT_RUN(ort_api, decoder_session, decoder_input_names.data(),
-                         decoder_inputs.data(), decoder_inputs.size(),
-                         decoder_output_names.data(),
-                         decoder_output_names.size(), decoder_outputs.data()));
+    OrtStatus *run_status =
+        ORT_RUN(ort_api, decoder_session, decoder_input_names.data(),
+                decoder_input_values.data(), decoder_input_values.size(),
+                decoder_output_names.data(), decoder_output_names.size(),
+                decoder_output_values.data());
     // TIMER_END(moonshine_decoder_run);
-    for (size_t i = 0; i < decoder_inputs_data.size(); i++) {
-      delete decoder_inputs_data[i];
-      ort_api->ReleaseValue(decoder_inputs[i]);
+    if (run_status != nullptr) {
+      LOG_ORT_ERROR(ort_api, run_status);
+      return 1;
+    }
+    last_decoder_run_count++;
+    for (OrtValue *&value : decoder_step_values) {
+      ort_api->ReleaseValue(value);
     }
-    decoder_inputs_data.clear();
-
-    OrtValue *logits_tensor = decoder_outputs[0];
-    MoonshineTensorView logits_tensor_view =
-        MoonshineTensorView(ort_api, logits_tensor, "logits_tensor");
-
-    // Copy over the values output from the last run
-    // into the corresponding inputs for the next
-    // decoding run.
-    for (const auto &layer_suffix : layer_suffixes) {
-      if (!use_cache_branch ||
-          layer_suffix.find("decoder") != std::string::npos) {
-        std::string past_key_values_name = "past_key_values." + layer_suffix;
-        std::string present_key_values_name = "present." + layer_suffix;
-        assert(decoder_output_name_to_index.find(present_key_values_name) !=
-               decoder_output_name_to_index.end());
-        const int64_t present_key_values_index =
-            decoder_output_name_to_index[present_key_values_name];
-
-        delete past_key_values_by_name[past_key_values_name];
-        past_key_values_by_name[past_key_values_name] = new MoonshineTensorView(
-            ort_api, decoder_outputs[present_key_values_index],
-            TENSOR_NAME(past_key_values_name));
+    decoder_step_values.clear();
+
+    if (use_cache_branch && !encoder_kv_echo_known) {
+      encoder_kv_echo_known = true;
+      const int echo_error = bind_encoder_kv_echoes(&encoder_kv_echo_values);
+      // Released with the steady values, even if only some got wrapped.
+      steady_values.insert(steady_values.end(), encoder_kv_echo_values.begin(),
+                           encoder_kv_echo_values.end());
+      RETURN_ON_ERROR(echo_error);
+    }
+
+    const float *logits = decoder_logits.data();
+    size_t vocab_size = static_cast<size_t>(decoder_vocab_size);
+    if (decoder_vocab_size <= 0) {
+      OrtValue *logits_value = decoder_output_values[decoder_logits_index];
+      OrtTensorTypeAndShapeInfo *logits_info = nullptr;
+      size_t logits_count = 0;
+      void *logits_data = nullptr;
+      RETURN_ON_ORT_ERROR(
+          ort_api, ort_api->GetTensorTypeAndShape(logits_value, &logits_info));
+      RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorShapeElementCount(
+                                       logits_info, &logits_count));
+      ort_api->ReleaseTensorTypeAndShapeInfo(logits_info);
+      RETURN_ON_ORT_ERROR(
+          ort_api, ort_api->GetTensorMutableData(logits_value, &logits_data));
+      logits = static_cast<const float *>(logits_data);
+      vocab_size = logits_count / input_len;
+    }
+
+    // Logits are [1, inputIDs, vocab]. Position i predicts the token after
+    // inputIDs[i], so the draft holds while each prediction matches the next
+    // draft token, and the prediction after the last match is the next token.
+    size_t accepted = 0;
+    while (accepted + 1 < inputIDs.size() &&
+           argmax_row(logits + accepted * vocab_size, vocab_size) ==
+               draft_tokens[accepted]) {
+      accepted++;
+    }
+    const int64_t next_token =
+        argmax_row(logits + accepted * vocab_size, vocab_size);
+
+    // The grown self-attention cache becomes the next step's input. Cached
+    // positions past the last accepted draft token belong to a continuation
+    // the model has rejected.
+    const int64_t kept_len = present_len - input_len + accepted + 1;
+    for (int layer = 0; layer < num_layers; layer++) {
+      for (int kind : {MOONSHINE_KV_DECODER_KEY, MOONSHINE_KV_DECODER_VALUE}) {
+        keep_leading_positions(present_kv[layer][kind].data(), num_kv_heads,
+                               present_len, kept_len, head_dim);
+        std::swap(past_kv[layer][kind], present_kv[layer][kind]);
+      }
+      if (!use_cache_branch) {
+        for (int kind :
+             {MOONSHINE_KV_ENCODER_KEY, MOONSHINE_KV_ENCODER_VALUE}) {
+          OrtValue *value =
+              wrap(past_kv[layer][kind].data(),
+                   encoder_kv_size * sizeof(float), encoder_kv_shape, 4, f32);
+          encoder_kv_values[layer * 2 + kind - MOONSHINE_KV_ENCODER_KEY] =
+              value;
+          steady_values.push_back(value);
+        }
       }
     }
+    cache_len = kept_len;
+
     // Collect cross-attention weights if available (single-pass mode)
     if (alignment_session == nullptr) {
-      // Check if decoder outputs include cross_attentions (modified decoder)
-      for (int layer_idx = 0; layer_idx < num_layers; layer_idx++) {
-        std::string attn_name = "cross_attentions." + std::to_string(layer_idx);
-        if (decoder_output_name_to_index.find(attn_name) !=
-            decoder_output_name_to_index.end()) {
-          const int64_t attn_index = decoder_output_name_to_index[attn_name];
-          MoonshineTensorView attn_view(ort_api, decoder_outputs[attn_index],
-                                        "cross_attn");
-          auto &attn_shape = attn_view.shape();
-          // Shape: [1, heads, dec_step_len, enc_len]
-          int heads = static_cast<int>(attn_shape[1]);
-          int step_len = static_cast<int>(attn_shape[2]);
-          int enc_len = static_cast<int>(attn_shape[3]);
-          size_t step_size = heads * step_len * enc_len;
-          size_t old_size = cross_attention_buffer.size();
-          cross_attention_buffer.resize(old_size + step_size);
-          memcpy(cross_attention_buffer.data() + old_size,
-                 attn_view.data<float>(), step_size * sizeof(float));
-          if (token_index == 0) {
-            cross_attn_heads = heads;
-            cross_attn_enc_len = enc_len;
-          }
-          cross_attn_steps++;
+      for (int64_t attn_index : decoder_attention_indices) {
+        OrtValue *attn_value = decoder_output_values[attn_index];
+        OrtTensorTypeAndShapeInfo *attn_info = nullptr;
+        // Shape: [1, heads, dec_step_len, enc_len]
+        int64_t attn_shape[4] = {0, 0, 0, 0};
+        void *attn_data = nullptr;
+        RETURN_ON_ORT_ERROR(
+            ort_api, ort_api->GetTensorTypeAndShape(attn_value, &attn_info));
+        RETURN_ON_ORT_ERROR(
+            ort_api, ort_api->GetDimensions(attn_info, attn_shape, 4));
+        ort_api->ReleaseTensorTypeAndShapeInfo(attn_info);
+        RETURN_ON_ORT_ERROR(
+            ort_api, ort_api->GetTensorMutableData(attn_value, &attn_data));
+        int heads = static_cast<int>(attn_shape[1]);
+        int step_len = static_cast<int>(attn_shape[2]);
+        int enc_len = static_cast<int>(attn_shape[3]);
+        size_t step_size = heads * step_len * enc_len;
+        size_t old_size = cross_attention_buffer.size();
+        cross_attention_buffer.resize(old_size + step_size);
+        memcpy(cross_attention_buffer.data() + old_size, attn_data,
+               step_size * sizeof(float));
+        if (token_index == 0) {
+          cross_attn_heads = heads;
+          cross_attn_enc_len = enc_len;
         }
+        cross_attn_steps++;
       }
     }
 
-    for (size_t i = 0; i < decoder_output_count; i++) {
-      ort_api->ReleaseValue(decoder_outputs[i]);
-    }
+    release_outputs();
 
-    int64_t next_token = logits_tensor_view.argmax();
+    tokens.insert(tokens.end(), draft_tokens.begin(),
+                  draft_tokens.begin() + accepted);
+    token_index += static_cast<int>(accepted);
+    last_draft_tokens_accepted += static_cast<int>(accepted);
     tokens.push_back(next_token);
+    if (decoder_run_observer) {
+      decoder_run_observer(last_decoder_run_count - 1);
+    }
     if (next_token == MOONSHINE_EOS_TOKEN_ID) {
       break;
     }
     inputIDs = {next_token};
   }
-
-  for (const char *decoder_input_name : decoder_input_names) {
-    ort_string_allocator->base.Free(&ort_string_allocator->base,
-                                    (char *)decoder_input_name);
-  }
-  decoder_input_names.clear();
-
-  for (const char *decoder_output_name : decoder_output_names) {
-    ort_string_allocator->base.Free(&ort_string_allocator->base,
-                                    (char *)decoder_output_name);
-  }
-  decoder_output_names.clear();
-
-  delete last_hidden_state_tensor;
-  last_hidden_state_tensor = nullptr;
-
-  if (encoder_attention_mask_tensor != nullptr) {
-    delete encoder_attention_mask_tensor;
-    encoder_attention_mask_tensor = nullptr;
-  }
-
-  for (const auto &[key, value] : past_key_values_by_name) {
-    delete value;
-  }
-  past_key_values_by_name.clear();
+  release_values();
 
   // Save tokens and attention for word alignment (only when needed)
   if (!cross_attention_buffer.empty() || alignment_session != nullptr) {
@@ -554,6 +683,13 @@ int MoonshineModel::transcribe(const float *input_audio_data,
     last_cross_attn_steps = cross_attn_steps;
   }
 
+  if (tokens_out != nullptr) {
+    tokens_out->assign(tokens.begin() + 1, tokens.end());
+    if (!tokens_out->empty() && tokens_out->back() == MOONSHINE_EOS_TOKEN_ID) {
+      tokens_out->pop_back();
+    }
+  }
+
   last_result = tokenizer->tokens_to_text(tokens);
   *out_text = (char *)(last_result.c_str());
 
@@ -562,6 +698,194 @@ int MoonshineModel::transcribe(const float *input_audio_data,
   return 0;
 }
 
+int MoonshineModel::load_decoder_io() {
+  if (decoder_session == nullptr) {
+    LOG("Decoder session is not loaded\n");
+    return 1;
+  }
+  if (decoder_io_session == decoder_session) {
+    return 0;
+  }
+  free_decoder_io_names();
+
+  size_t decoder_input_count = 0;
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetInputCount(
+                                   decoder_session, &decoder_input_count));
+  const size_t expected_decoder_input_count_v1 = (num_layers * 4) + 3;
+  const size_t expected_decoder_input_count_v2 = (num_layers * 4) + 4;
+  if ((decoder_input_count != expected_decoder_input_count_v1) &&
+      (decoder_input_count != expected_decoder_input_count_v2)) {
+    LOGF(
+        "Expected decoder input count to be %zu or "
+        "%zu, but got %zu. This "
+        "often indicates you're specifying the "
+        "wrong model architecture "
+        "(for example tiny instead of base).\n",
+        expected_decoder_input_count_v1, expected_decoder_input_count_v2,
+        decoder_input_count);
+    return 1;
+  }
+  for (size_t i = 0; i < decoder_input_count; i++) {
+    char *decoder_input_name = nullptr;
+    RETURN_ON_ORT_ERROR(
+        ort_api, ort_api->SessionGetInputName(decoder_session, i,
+                                              &ort_string_allocator->base,
+                                              &decoder_input_name));
+    decoder_input_names.push_back(decoder_input_name);
+  }
+  size_t decoder_output_count = 0;
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetOutputCount(
+                                   decoder_session, &decoder_output_count));
+  for (size_t i = 0; i < decoder_output_count; i++) {
+    char *decoder_output_name = nullptr;
+    RETURN_ON_ORT_ERROR(
+        ort_api, ort_api->SessionGetOutputName(decoder_session, i,
+                                               &ort_string_allocator->base,
+                                               &decoder_output_name));
+    decoder_output_names.push_back(decoder_output_name);
+  }
+
+  auto input_name_to_index = name_to_index(decoder_input_names);
+  auto output_name_to_index = name_to_index(decoder_output_names);
+  auto find_index = [](const std::map<std::string, int64_t> &indices,
+                       const std::string &name) -> int64_t {
+    auto it = indices.find(name);
+    return it == indices.end() ? -1 : it->second;
+  };
+  decoder_input_ids_index = find_index(input_name_to_index, "input_ids");
+  decoder_encoder_hidden_states_index =
+      find_index(input_name_to_index, "encoder_hidden_states");
+  decoder_encoder_attention_mask_index =
+      find_index(input_name_to_index, "encoder_attention_mask");
+  decoder_use_cache_branch_index =
+      find_index(input_name_to_index, "use_cache_branch");
+  decoder_logits_index = find_index(output_name_to_index, "logits");
+  RETURN_ON_FALSE(decoder_input_ids_index >= 0);
+  RETURN_ON_FALSE(decoder_encoder_hidden_states_index >= 0);
+  RETURN_ON_FALSE(decoder_use_cache_branch_index >= 0);
+  RETURN_ON_FALSE(decoder_logits_index >= 0);
+
+  static const char *kind_suffixes[MOONSHINE_KV_KIND_COUNT] = {
+      "decoder.key", "decoder.value", "encoder.key", "encoder.value"};
+  decoder_past_indices.resize(num_layers);
+  decoder_present_indices.resize(num_layers);
+  decoder_attention_indices.clear();
+  for (int layer = 0; layer < num_layers; layer++) {
+    for (int kind = 0; kind < MOONSHINE_KV_KIND_COUNT; kind++) {
+      const std::string layer_suffix =
+          std::to_string(layer) + "." + kind_suffixes[kind];
+      const std::string past_name = "past_key_values." + layer_suffix;
+      const std::string present_name = "present." + layer_suffix;
+      decoder_past_indices[layer][kind] =
+          find_index(input_name_to_index, past_name);
+      decoder_present_indices[layer][kind] =
+          find_index(output_name_to_index, present_name);
+      if (decoder_past_indices[layer][kind] < 0 ||
+          decoder_present_indices[layer][kind] < 0) {
+        LOGF("Decoder is missing %s or %s\n", past_name.c_str(),
+             present_name.c_str());
+        return 1;
+      }
+    }
+    const int64_t attention_index = find_index(
+        output_name_to_index, "cross_attentions." + std::to_string(layer));
+    if (attention_index >= 0) {
+      decoder_attention_indices.push_back(attention_index);
+    }
+  }
+
+  std::vector<int64_t> logits_shape =
+      ort_get_output_shape(ort_api, decoder_session, decoder_logits_index);
+  decoder_vocab_size =
+      (logits_shape.size() == 3 && logits_shape[2] > 0) ? logits_shape[2] : 0;
+
+  decoder_input_values.assign(decoder_input_count, nullptr);
+  decoder_output_values.assign(decoder_output_count, nullptr);
+  decoder_step_values.reserve(decoder_input_count);
+  past_kv.resize(num_layers);
+  present_kv.resize(num_layers);
+  decoder_io_session = decoder_session;
+  return 0;
+}
+
+int MoonshineModel::reload_decoder_io() {
+  free_decoder_io_names();
+  return load_decoder_io();
+}
+
+void MoonshineModel::free_decoder_io_names() {
+  for (const char *name : decoder_input_names) {
+    ort_string_allocator->base.Free(&ort_string_allocator->base,
+                                    const_cast<char *>(name));
+  }
+  decoder_input_names.clear();
+  for (const char *name : decoder_output_names) {
+    ort_string_allocator->base.Free(&ort_string_allocator->base,
+                                    const_cast<char *>(name));
+  }
+  decoder_output_names.clear();
+  decoder_io_session = nullptr;
+}
+
+void MoonshineModel::reserve_decode_buffer(std::vector<float> *buffer,
+                                           size_t size) {
+  if (buffer->capacity() < size) {
+    buffer->reserve(size);
+  }
+  if (buffer->size() < size) {
+    buffer->resize(size, 0.0f);
+  }
+}
+
+int MoonshineModel::bind_encoder_kv_echoes(
+    std::vector<OrtValue *> *echo_values) {
+  std::vector<std::vector<int64_t>> shapes(echo_values->size());
+  std::vector<size_t> counts(echo_values->size(), 0);
+  size_t total = 0;
+  for (int layer = 0; layer < num_layers; layer++) {
+    for (int kind : {MOONSHINE_KV_ENCODER_KEY, MOONSHINE_KV_ENCODER_VALUE}) {
+      const size_t cache = layer * 2 + kind - MOONSHINE_KV_ENCODER_KEY;
+      OrtValue *value =
+          decoder_output_values[decoder_present_indices[layer][kind]];
+      if (value == nullptr) {
+        return 0;
+      }
+      OrtTensorTypeAndShapeInfo *info = nullptr;
+      RETURN_ON_ORT_ERROR(ort_api,
+                          ort_api->GetTensorTypeAndShape(value, &info));
+      ScopeExit release_info(
+          [&]() { ort_api->ReleaseTensorTypeAndShapeInfo(info); });
+      ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+      size_t rank = 0;
+      RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorElementType(info, &type));
+      RETURN_ON_ORT_ERROR(ort_api, ort_api->GetDimensionsCount(info, &rank));
+      shapes[cache].resize(rank);
+      RETURN_ON_ORT_ERROR(ort_api, ort_api->GetDimensions(
+                                       info, shapes[cache].data(), rank));
+      RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorShapeElementCount(
+                                       info, &counts[cache]));
+      if (type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+        // Not worth a scratch buffer of its own type; ORT keeps them.
+        return 0;
+      }
+      total += counts[cache];
+    }
+  }
+  // One slice per output, so no two outputs of a run share memory.
+  reserve_decode_buffer(&decoder_echo_scratch, std::max<size_t>(total, 1));
+  size_t offset = 0;
+  for (size_t cache = 0; cache < echo_values->size(); cache++) {
+    RETURN_ON_ORT_ERROR(
+        ort_api, ort_api->CreateTensorWithDataAsOrtValue(
+                     ort_memory_info, decoder_echo_scratch.data() + offset,
+                     counts[cache] * sizeof(float), shapes[cache].data(),
+                     shapes[cache].size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
+                     &(*echo_values)[cache]));
+    offset += counts[cache];
+  }
+  return 0;
+}
+
 int MoonshineModel::transcribe_wav(const char *wav_path, char **out_text) {
   *out_text = nullptr;
   if (wav_path == nullptr) {
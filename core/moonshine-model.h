@@ -4,6 +4,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <array>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -14,6 +16,16 @@
 #include "onnxruntime_c_api.h"
 #include "word-alignment.h"
 
+// The four key/value caches each decoder layer keeps, in the order the
+// decoder's past_key_values.{layer}.* inputs are declared.
+enum MoonshineKvKind {
+  MOONSHINE_KV_DECODER_KEY = 0,
+  MOONSHINE_KV_DECODER_VALUE,
+  MOONSHINE_KV_ENCODER_KEY,
+  MOONSHINE_KV_ENCODER_VALUE,
+  MOONSHINE_KV_KIND_COUNT,
+};
+
 struct MoonshineModel {
   const OrtApi *ort_api;
   OrtEnv *ort_env;
@@ -64,6 +76,16 @@ struct MoonshineModel {
   int last_cross_attn_enc_len = 0;
   int last_cross_attn_steps = 0;
 
+  // Decoder work done by the last transcribe() call: how many decoder runs it
+  // took, and how many draft tokens transcribe_with_draft() accepted (each of
+  // which would otherwise have cost a run of its own).
+  int last_decoder_run_count = 0;
+  int last_draft_tokens_accepted = 0;
+
+  // If set, called after each decoder run of transcribe_with_draft() with
+  // the run's index, so a test can see what every step costs.
+  std::function<void(int run)> decoder_run_observer;
+
   MoonshineModel(bool log_ort_run = false, float max_tokens_per_second = 6.5f,
                  const std::vector<std::string> &ort_provider_names = {},
                  const std::string &coreml_cache_dir = {});
@@ -96,6 +118,19 @@ struct MoonshineModel {
   int transcribe(const float *input_audio_data, size_t input_audio_data_size,
                  char **out_text);
 
+  // Like transcribe(), but checks ``draft_tokens`` first. These are the
+  // tokens an earlier call produced for a shorter prefix of the same audio,
+  // without the start and end tokens. The first decoder run feeds the whole
+  // draft and keeps the prefix the model still predicts, and greedy decoding
+  // resumes from the first mismatch, so the text is the same as transcribe()
+  // gives. The tokens decoded this time, in the same form as the draft, are
+  // written to ``tokens_out`` if it is non-null. The draft is ignored when
+  // the decoder emits cross attentions for word timestamps.
+  int transcribe_with_draft(const float *input_audio_data,
+                            size_t input_audio_data_size,
+                            const std::vector<int64_t> &draft_tokens,
+                            std::vector<int64_t> *tokens_out, char **out_text);
+
   int transcribe_wav(const char *wav_path, char **out_text);
 
   // Compute word-level timestamps using the alignment model and saved
@@ -105,6 +140,65 @@ struct MoonshineModel {
   // Returns 0 on success.
   int compute_word_timestamps(float audio_duration,
                               std::vector<TranscriberWord> &words_out);
+
+  // Re-reads the decoder's inputs and outputs. Call after replacing
+  // decoder_session, as the transcriber does to load the attention decoder.
+  int reload_decoder_io();
+
+ private:
+  /* Reads the decoder's input and output names and the positions of each
+   * one transcribe() feeds or reads, unless they are already loaded for
+   * decoder_session. Called at the end of every load path. */
+  int load_decoder_io();
+  void free_decoder_io_names();
+
+  /* Makes sure ``buffer`` can hold ``size`` floats. */
+  void reserve_decode_buffer(std::vector<float> *buffer, size_t size);
+
+  /* Wraps a slice of decoder_echo_scratch in a value for each cross-attention
+   * cache the last cache-branch run echoed, shaped as ORT gave it, and stores
+   * them in ``echo_values`` by layer and key/value. Leaves them null if the
+   * outputs are not float tensors. */
+  int bind_encoder_kv_echoes(std::vector<OrtValue *> *echo_values);
+
+  const OrtSession *decoder_io_session = nullptr;
+  std::vector<const char *> decoder_input_names;
+  std::vector<const char *> decoder_output_names;
+  int64_t decoder_input_ids_index = -1;
+  int64_t decoder_encoder_hidden_states_index = -1;
+  // -1 for the attention decoder, which has no mask input.
+  int64_t decoder_encoder_attention_mask_index = -1;
+  int64_t decoder_use_cache_branch_index = -1;
+  int64_t decoder_logits_index = -1;
+  // Zero if the export leaves the logits' vocabulary dimension dynamic, in
+  // which case ORT allocates the logits itself.
+  int64_t decoder_vocab_size = 0;
+  // past_key_values.{layer}.* inputs and present.{layer}.* outputs, by layer
+  // and MoonshineKvKind.
+  std::vector<std::array<int64_t, MOONSHINE_KV_KIND_COUNT>>
+      decoder_past_indices;
+  std::vector<std::array<int64_t, MOONSHINE_KV_KIND_COUNT>>
+      decoder_present_indices;
+  // cross_attentions.{layer} outputs, empty unless the decoder emits them.
+  std::vector<int64_t> decoder_attention_indices;
+  // One slot per decoder input and output, reused by every run, and the
+  // wrappers a run creates for its own inputs, released once it is done.
+  std::vector<OrtValue *> decoder_input_values;
+  std::vector<OrtValue *> decoder_output_values;
+  std::vector<OrtValue *> decoder_step_values;
+
+  // Cache storage by layer and MoonshineKvKind. The decoder reads a step's
+  // self-attention cache from past_kv and writes the grown one to
+  // present_kv, and the two swap afterwards. The encoder entries of
+  // present_kv are unused: cross-attention keys and values are computed on
+  // the first step and only read after that.
+  std::vector<std::array<std::vector<float>, MOONSHINE_KV_KIND_COUNT>> past_kv;
+  std::vector<std::array<std::vector<float>, MOONSHINE_KV_KIND_COUNT>>
+      present_kv;
+  std::vector<float> decoder_logits;
+  // Where cache-branch steps write the cross-attention keys and values the
+  // decoder echoes back, which are never read.
+  std::vector<float> decoder_echo_scratch;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "moonshine-streaming-decode-scheduler.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest.h>
+
+namespace {
+
+constexpr int kStreams = 4;
+constexpr int kStepsPerStream = 20;
+
+// Stands in for MoonshineStreamingModel::decode_step_batch. Each row's
+// "logits" are its token plus its state's cache length, and the step grows
+// that cache, so a row handed another row's result or run twice shows up.
+struct FakeDecoder {
+  std::mutex mutex;
+  std::vector<int> batch_sizes;
+
+  int operator()(MoonshineStreamingState *const *states, const int *tokens,
+                 float *const *logits_out, int batch_size) {
+    for (int b = 0; b < batch_size; ++b) {
+      logits_out[b][0] =
+          static_cast<float>(tokens[b] + states[b]->cache_seq_len);
+      states[b]->cache_seq_len++;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    batch_sizes.push_back(batch_size);
+    return 0;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("decode-scheduler-batches-concurrent-steps") {
+  FakeDecoder decoder;
+  // The wait only ends on its deadline if a step never arrives, which would
+  // be a bug; it is long so a slow machine can't split a batch.
+  MoonshineStreamingDecodeScheduler scheduler(
+      [&](MoonshineStreamingState *const *states, const int *tokens,
+          float *const *logits_out, int batch_size) {
+        return decoder(states, tokens, logits_out, batch_size);
+      },
+      10000.0f, kStreams);
+
+  // Every stream is counted as decoding before any of them queues a step, so
+  // the leader always waits for all of them.
+  for (int i = 0; i < kStreams; ++i) {
+    scheduler.begin_decode();
+  }
+  std::vector<MoonshineStreamingState> states(kStreams);
+  std::vector<int> wrong_results(kStreams, 0);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < kStreams; ++i) {
+    workers.emplace_back([&, i] {
+      MoonshineStreamingState &state = states[i];
+      state.cache_seq_len = 0;
+      for (int step = 0; step < kStepsPerStream; ++step) {
+        const int token = 1000 * (i + 1) + step;
+        float logits = -1.0f;
+        if (scheduler.decode_step(&state, token, &logits) != 0 ||
+            logits != static_cast<float>(token + step)) {
+          wrong_results[i]++;
+        }
+      }
+      scheduler.end_decode();
+    });
+  }
+  for (auto &t : workers) {
+    t.join();
+  }
+
+  for (int i = 0; i < kStreams; ++i) {
+    CAPTURE(i);
+    CHECK(wrong_results[i] == 0);
+    CHECK(states[i].cache_seq_len == kStepsPerStream);
+  }
+  const MoonshineDecodeBatchStats stats = scheduler.stats();
+  CHECK(stats.step_count == kStreams * kStepsPerStream);
+  CHECK(stats.batch_count == kStepsPerStream);
+  CHECK(stats.max_batch_size == kStreams);
+  REQUIRE(decoder.batch_sizes.size() == kStepsPerStream);
+  for (int size : decoder.batch_sizes) {
+    CHECK(size == kStreams);
+  }
+}
+
+TEST_CASE("decode-scheduler-caps-batch-size") {
+  FakeDecoder decoder;
+  constexpr int kMaxBatch = 3;
+  MoonshineStreamingDecodeScheduler scheduler(
+      [&](MoonshineStreamingState *const *states, const int *tokens,
+          float *const *logits_out, int batch_size) {
+        return decoder(states, tokens, logits_out, batch_size);
+      },
+      10000.0f, kMaxBatch);
+
+  for (int i = 0; i < kStreams; ++i) {
+    scheduler.begin_decode();
+  }
+  std::vector<MoonshineStreamingState> states(kStreams);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < kStreams; ++i) {
+    workers.emplace_back([&, i] {
+      states[i].cache_seq_len = 0;
+      for (int step = 0; step < kStepsPerStream; ++step) {
+        float logits = 0.0f;
+        scheduler.decode_step(&states[i], step, &logits);
+      }
+      scheduler.end_decode();
+    });
+  }
+  for (auto &t : workers) {
+    t.join();
+  }
+
+  const MoonshineDecodeBatchStats stats = scheduler.stats();
+  CHECK(stats.step_count == kStreams * kStepsPerStream);
+  CHECK(stats.max_batch_size == kMaxBatch);
+  for (int i = 0; i < kStreams; ++i) {
+    CHECK(states[i].cache_seq_len == kStepsPerStream);
+  }
+}
+
+TEST_CASE("decode-scheduler-returns-runner-errors") {
+  MoonshineStreamingDecodeScheduler scheduler(
+      [](MoonshineStreamingState *const *, const int *, float *const *,
+         int) { return 7; },
+      0.0f, kStreams);
+  MoonshineStreamingDecodeScheduler::ScopedDecode active(&scheduler);
+  MoonshineStreamingState state;
+  float logits = 0.0f;
+  CHECK(scheduler.decode_step(&state, 1, &logits) == 7);
+  CHECK(scheduler.stats().batch_count == 1);
+}
@@ -0,0 +1,108 @@
+#include "moonshine-streaming-decode-scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+MoonshineStreamingDecodeScheduler::MoonshineStreamingDecodeScheduler(
+    MoonshineStreamingModel *model, float max_wait_ms, int max_batch_size)
+    : MoonshineStreamingDecodeScheduler(
+          [model](MoonshineStreamingState *const *states, const int *tokens,
+                  float *const *logits_out, int batch_size) {
+            return model->decode_step_batch(states, tokens, logits_out,
+                                            batch_size);
+          },
+          max_wait_ms, max_batch_size) {}
+
+MoonshineStreamingDecodeScheduler::MoonshineStreamingDecodeScheduler(
+    BatchRunner run, float max_wait_ms, int max_batch_size)
+    : run(std::move(run)),
+      max_wait(static_cast<int64_t>(std::max(0.0f, max_wait_ms) * 1000.0f)),
+      max_batch_size(static_cast<size_t>(std::max(1, max_batch_size))) {}
+
+int MoonshineStreamingDecodeScheduler::decode_step(
+    MoonshineStreamingState *state, int token, float *logits_out) {
+  Request request{state, token, logits_out};
+  std::unique_lock<std::mutex> lock(mutex);
+  pending.push_back(&request);
+  changed.notify_all();
+  while (!request.done) {
+    if (!leader_running) {
+      leader_running = true;
+      run_batch(lock);
+      leader_running = false;
+      changed.notify_all();
+    } else {
+      changed.wait(lock, [&] { return request.done || !leader_running; });
+    }
+  }
+  return request.err;
+}
+
+void MoonshineStreamingDecodeScheduler::run_batch(
+    std::unique_lock<std::mutex> &lock) {
+  const auto deadline = std::chrono::steady_clock::now() + max_wait;
+  changed.wait_until(lock, deadline, [&] {
+    const size_t expected =
+        static_cast<size_t>(std::max(1, active_decoders));
+    return pending.size() >= std::min(expected, max_batch_size);
+  });
+
+  // Oldest first, so a step that missed a full batch goes in the next one.
+  const size_t count = std::min(pending.size(), max_batch_size);
+  std::vector<Request *> batch(pending.begin(), pending.begin() + count);
+  pending.erase(pending.begin(), pending.begin() + count);
+
+  std::vector<MoonshineStreamingState *> states(count);
+  std::vector<int> tokens(count);
+  std::vector<float *> logits(count);
+  for (size_t i = 0; i < count; ++i) {
+    states[i] = batch[i]->state;
+    tokens[i] = batch[i]->token;
+    logits[i] = batch[i]->logits_out;
+  }
+
+  lock.unlock();
+  const int err = run(states.data(), tokens.data(), logits.data(),
+                      static_cast<int>(count));
+  lock.lock();
+
+  for (Request *request : batch) {
+    request->err = err;
+    request->done = true;
+  }
+  batch_stats.batch_count++;
+  batch_stats.step_count += count;
+  batch_stats.max_batch_size =
+      std::max(batch_stats.max_batch_size, static_cast<int>(count));
+}
+
+void MoonshineStreamingDecodeScheduler::begin_decode() {
+  std::lock_guard<std::mutex> lock(mutex);
+  active_decoders++;
+}
+
+void MoonshineStreamingDecodeScheduler::end_decode() {
+  std::lock_guard<std::mutex> lock(mutex);
+  active_decoders--;
+  // A leader may be waiting on this decoder's next step, which won't come.
+  changed.notify_all();
+}
+
+MoonshineDecodeBatchStats MoonshineStreamingDecodeScheduler::stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return batch_stats;
+}
+
+MoonshineStreamingDecodeScheduler::ScopedDecode::ScopedDecode(
+    MoonshineStreamingDecodeScheduler *scheduler)
+    : scheduler(scheduler) {
+  if (scheduler != nullptr) {
+    scheduler->begin_decode();
+  }
+}
+
+MoonshineStreamingDecodeScheduler::ScopedDecode::~ScopedDecode() {
+  if (scheduler != nullptr) {
+    scheduler->end_decode();
+  }
+}
@@ -0,0 +1,99 @@
+#ifndef MOONSHINE_STREAMING_DECODE_SCHEDULER_H
+#define MOONSHINE_STREAMING_DECODE_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "moonshine-streaming-model.h"
+
+// Occupancy counters for MoonshineStreamingDecodeScheduler. The mean batch
+// size is step_count / batch_count.
+struct MoonshineDecodeBatchStats {
+  uint64_t batch_count = 0;  // decoder runs issued
+  uint64_t step_count = 0;   // rows decoded across all of those runs
+  int max_batch_size = 0;    // largest batch seen so far
+};
+
+// Combines single-token decode steps from streams that share one streaming
+// model into batched decoder_kv runs.
+//
+// Streams decode on their own threads, so there is no scheduler thread.
+// Each caller queues its step; the first one to find nobody collecting
+// becomes the leader, waits up to ``max_wait_ms`` for the other active
+// decoders to queue theirs, runs up to ``max_batch_size`` of them through
+// MoonshineStreamingModel::decode_step_batch, and wakes their owners. The
+// wait ends early as soon as every active decoder has a step queued, so a
+// lone stream only pays for it while another is between steps.
+//
+// The model falls back to one run per row for decoders that weren't
+// exported for batching, so the scheduler is safe to use with any model.
+class MoonshineStreamingDecodeScheduler {
+ public:
+  // Runs one batch of steps; same contract as
+  // MoonshineStreamingModel::decode_step_batch.
+  using BatchRunner = std::function<int(MoonshineStreamingState *const *,
+                                        const int *, float *const *, int)>;
+
+  MoonshineStreamingDecodeScheduler(MoonshineStreamingModel *model,
+                                    float max_wait_ms, int max_batch_size);
+  // Runs batches through ``run`` instead of a model, so the queueing can be
+  // tested on its own.
+  MoonshineStreamingDecodeScheduler(BatchRunner run, float max_wait_ms,
+                                    int max_batch_size);
+
+  // Same contract as MoonshineStreamingModel::decode_step. Blocks until the
+  // batch holding this step has run. ``state`` must not be used by anyone
+  // else until it returns.
+  int decode_step(MoonshineStreamingState *state, int token, float *logits_out);
+
+  // Brackets a whole token loop, so the leader knows how many steps are
+  // worth waiting for. A stream that's decoding but not inside decode_step
+  // is busy with its argmax and will be back shortly.
+  void begin_decode();
+  void end_decode();
+
+  MoonshineDecodeBatchStats stats();
+
+  // begin_decode/end_decode for a scope. A null scheduler makes it a no-op,
+  // which keeps the unbatched path free of special cases.
+  class ScopedDecode {
+   public:
+    explicit ScopedDecode(MoonshineStreamingDecodeScheduler *scheduler);
+    ~ScopedDecode();
+    ScopedDecode(const ScopedDecode &) = delete;
+    ScopedDecode &operator=(const ScopedDecode &) = delete;
+
+   private:
+    MoonshineStreamingDecodeScheduler *scheduler;
+  };
+
+ private:
+  struct Request {
+    MoonshineStreamingState *state;
+    int token;
+    float *logits_out;
+    bool done = false;
+    int err = 0;
+  };
+
+  // Collects and runs one batch. Called by the leader with ``lock`` held;
+  // drops it around the model call.
+  void run_batch(std::unique_lock<std::mutex> &lock);
+
+  BatchRunner run;
+  std::chrono::microseconds max_wait;
+  size_t max_batch_size;
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<Request *> pending;
+  bool leader_running = false;
+  int active_decoders = 0;
+  MoonshineDecodeBatchStats batch_stats;
+};
+
+#endif
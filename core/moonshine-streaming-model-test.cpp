@@ -0,0 +1,262 @@
+#include "moonshine-streaming-model.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "debug-utils.h"
+#include "moonshine-c-api.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest.h>
+
+namespace {
+
+// Small enough to check every element, with each dimension distinct so a
+// swapped index shows up.
+MoonshineStreamingConfig tiny_config() {
+  MoonshineStreamingConfig cfg{};
+  cfg.depth = 2;
+  cfg.nheads = 3;
+  cfg.head_dim = 4;
+  cfg.vocab_size = 5;
+  cfg.max_seq_len = 16;
+  return cfg;
+}
+
+// A distinct non-zero value for every cache entry of every row, so padding
+// (zero) and misplaced entries are both visible.
+float cache_value(int row, int layer, int head, int pos, int dim) {
+  return static_cast<float>(10000 * (row + 1) + 1000 * layer + 100 * head +
+                            10 * pos + dim + 1);
+}
+
+// Fills a [depth, 1, nheads, len, head_dim] cache for ``row``. V entries are
+// the negated K entries.
+void fill_cache(const MoonshineStreamingConfig &cfg, int row, int len,
+                std::vector<float> &k, std::vector<float> &v) {
+  k.clear();
+  v.clear();
+  for (int l = 0; l < cfg.depth; ++l) {
+    for (int h = 0; h < cfg.nheads; ++h) {
+      for (int p = 0; p < len; ++p) {
+        for (int d = 0; d < cfg.head_dim; ++d) {
+          k.push_back(cache_value(row, l, h, p, d));
+          v.push_back(-cache_value(row, l, h, p, d));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST_CASE("decoder-batch-pads-rows-of-different-lengths") {
+  const MoonshineStreamingConfig cfg = tiny_config();
+  const int B = 3;
+  const int cache_lens[B] = {1, 3, 0};
+  const int cross_lens[B] = {4, 2, 3};
+  const int tokens[B] = {7, 8, 9};
+
+  std::vector<MoonshineStreamingState> rows(B);
+  std::vector<MoonshineStreamingState *> states;
+  for (int b = 0; b < B; ++b) {
+    rows[b].reset(cfg);
+    rows[b].cache_seq_len = cache_lens[b];
+    rows[b].cross_len = cross_lens[b];
+    fill_cache(cfg, b, cache_lens[b], rows[b].k_self, rows[b].v_self);
+    // Offset the cross values so they can't be mistaken for self entries.
+    fill_cache(cfg, b + 10, cross_lens[b], rows[b].k_cross, rows[b].v_cross);
+    states.push_back(&rows[b]);
+  }
+
+  MoonshineDecoderBatch batch;
+  batch.pack(cfg, states.data(), tokens, B);
+  REQUIRE(batch.cache_len == 3);
+  REQUIRE(batch.cross_len == 4);
+  REQUIRE(batch.k_self.size() ==
+          static_cast<size_t>(cfg.depth * B * cfg.nheads * 3 * cfg.head_dim));
+  REQUIRE(batch.k_cross.size() ==
+          static_cast<size_t>(cfg.depth * B * cfg.nheads * 4 * cfg.head_dim));
+
+  for (int b = 0; b < B; ++b) {
+    CAPTURE(b);
+    CHECK(batch.tokens[b] == tokens[b]);
+    CHECK(batch.position_ids[b] == cache_lens[b]);
+    // Self entries are right-aligned and cross entries left-aligned.
+    const int self_pad = 3 - cache_lens[b];
+    for (int p = 0; p < 3; ++p) {
+      CHECK(batch.self_mask[b * 3 + p] == (p >= self_pad ? 1 : 0));
+    }
+    for (int p = 0; p < 4; ++p) {
+      CHECK(batch.cross_mask[b * 4 + p] == (p < cross_lens[b] ? 1 : 0));
+    }
+    for (int l = 0; l < cfg.depth; ++l) {
+      for (int h = 0; h < cfg.nheads; ++h) {
+        const int row = (l * B + b) * cfg.nheads + h;
+        for (int d = 0; d < cfg.head_dim; ++d) {
+          for (int p = 0; p < 3; ++p) {
+            const float expected =
+                p >= self_pad ? cache_value(b, l, h, p - self_pad, d) : 0.0f;
+            const size_t i = (row * 3 + p) * cfg.head_dim + d;
+            CHECK(batch.k_self[i] == expected);
+            CHECK(batch.v_self[i] == -expected);
+          }
+          for (int p = 0; p < 4; ++p) {
+            const float expected =
+                p < cross_lens[b] ? cache_value(b + 10, l, h, p, d) : 0.0f;
+            const size_t i = (row * 4 + p) * cfg.head_dim + d;
+            CHECK(batch.k_cross[i] == expected);
+            CHECK(batch.v_cross[i] == -expected);
+          }
+        }
+      }
+    }
+  }
+
+  // What the decoder hands back: every row's cache grown by one entry at the
+  // shared last position, still right-aligned, with garbage in the padding.
+  const int out_len = 4;
+  std::vector<float> k_out(cfg.depth * B * cfg.nheads * out_len * cfg.head_dim,
+                           -1.0f);
+  std::vector<float> v_out(k_out.size(), -1.0f);
+  for (int b = 0; b < B; ++b) {
+    const int pad = out_len - (cache_lens[b] + 1);
+    for (int l = 0; l < cfg.depth; ++l) {
+      for (int h = 0; h < cfg.nheads; ++h) {
+        const int row = (l * B + b) * cfg.nheads + h;
+        for (int p = pad; p < out_len; ++p) {
+          for (int d = 0; d < cfg.head_dim; ++d) {
+            const size_t i = (row * out_len + p) * cfg.head_dim + d;
+            k_out[i] = cache_value(b, l, h, p - pad, d);
+            v_out[i] = -cache_value(b, l, h, p - pad, d);
+          }
+        }
+      }
+    }
+  }
+  batch.unpack_self_kv(cfg, states.data(), k_out.data(), v_out.data());
+
+  for (int b = 0; b < B; ++b) {
+    CAPTURE(b);
+    CHECK(rows[b].cache_seq_len == cache_lens[b] + 1);
+    std::vector<float> k_expected;
+    std::vector<float> v_expected;
+    fill_cache(cfg, b, cache_lens[b] + 1, k_expected, v_expected);
+    CHECK(rows[b].k_self == k_expected);
+    CHECK(rows[b].v_self == v_expected);
+  }
+}
+
+TEST_CASE("cross-kv-append-matches-full-projection") {
+  const MoonshineStreamingConfig cfg = tiny_config();
+  const size_t head_count = static_cast<size_t>(cfg.depth) * cfg.nheads;
+  const size_t D = cfg.head_dim;
+
+  // What a full recompute over all the frames produces, and the same frames
+  // arriving as the streaming updates would hand them to cross_kv.
+  const int total_frames = 11;
+  std::vector<float> full;
+  std::vector<float> unused;
+  fill_cache(cfg, 0, total_frames, full, unused);
+  const int updates[] = {3, 1, 4, 2, 1};
+
+  std::vector<float> buffer;
+  size_t old_len = 0;
+  for (const int new_len : updates) {
+    // The slice of every head's frames [old_len, old_len + new_len).
+    std::vector<float> slice;
+    for (size_t i = 0; i < head_count; ++i) {
+      const float *head = full.data() + i * total_frames * D;
+      slice.insert(slice.end(), head + old_len * D,
+                   head + (old_len + new_len) * D);
+    }
+    append_cross_kv(buffer, slice.data(), head_count, D, old_len, new_len);
+    old_len += new_len;
+
+    // At every step the buffer is exactly what projecting the frames so far
+    // in one go would give.
+    std::vector<float> expected;
+    for (size_t i = 0; i < head_count; ++i) {
+      const float *head = full.data() + i * total_frames * D;
+      expected.insert(expected.end(), head, head + old_len * D);
+    }
+    CAPTURE(old_len);
+    CHECK(buffer == expected);
+  }
+  REQUIRE(old_len == static_cast<size_t>(total_frames));
+
+  // A new segment starts from an empty buffer and keeps the capacity, so
+  // refilling it to the same length doesn't reallocate.
+  const float *data = buffer.data();
+  buffer.clear();
+  append_cross_kv(buffer, full.data(), head_count, D, 0, total_frames);
+  CHECK(buffer == full);
+  CHECK(buffer.data() == data);
+}
+
+TEST_CASE("decode-step-grows-self-kv-in-place") {
+  const std::string model_dir = "tiny-streaming-en";
+  REQUIRE(std::filesystem::exists(model_dir));
+  MoonshineStreamingModel model;
+  const std::string tokenizer_path = model_dir + "/tokenizer.bin";
+  REQUIRE(model.load(model_dir.c_str(), tokenizer_path.c_str(),
+                     MOONSHINE_MODEL_ARCH_TINY_STREAMING) == 0);
+  const MoonshineStreamingConfig &cfg = model.config;
+
+  float *wav_data = nullptr;
+  size_t wav_data_size = 0;
+  int32_t wav_sample_rate = 0;
+  REQUIRE(load_wav_data("two_cities_16k.wav", &wav_data, &wav_data_size,
+                        &wav_sample_rate));
+  REQUIRE(wav_sample_rate == 16000);
+  std::unique_ptr<MoonshineStreamingState> state(model.create_state());
+  // Two seconds, in the 80 ms chunks the streaming frontend takes.
+  const size_t chunk = 1280;
+  const size_t samples = std::min<size_t>(wav_data_size, 2 * 16000);
+  for (size_t i = 0; i + chunk <= samples; i += chunk) {
+    REQUIRE(model.process_audio_chunk(state.get(), wav_data + i,
+                                      static_cast<int>(chunk), nullptr) == 0);
+  }
+  free(wav_data);
+  int new_frames = 0;
+  REQUIRE(model.encode(state.get(), true, &new_frames) == 0);
+  REQUIRE(state->memory_len > 0);
+
+  // Greedy steps. Each one reads the cache from one buffer of a pair and
+  // writes the grown cache into the other, so the pair's storage must stay
+  // put for the whole decode.
+  constexpr int kSteps = 8;
+  std::vector<int> fed = {cfg.bos_id};
+  std::vector<float> step_logits(kSteps * cfg.vocab_size);
+  const float *k_pair[2] = {nullptr, nullptr};
+  for (int step = 0; step < kSteps; ++step) {
+    float *logits = step_logits.data() + step * cfg.vocab_size;
+    REQUIRE(model.decode_step(state.get(), fed.back(), logits) == 0);
+    CHECK(state->cache_seq_len == step + 1);
+    if (step == 0) {
+      k_pair[0] = state->k_self.data();
+      k_pair[1] = state->k_self_next.data();
+    } else {
+      const float *now[2] = {state->k_self.data(), state->k_self_next.data()};
+      CHECK(((now[0] == k_pair[0] && now[1] == k_pair[1]) ||
+             (now[0] == k_pair[1] && now[1] == k_pair[0])));
+    }
+    fed.push_back(static_cast<int>(
+        std::max_element(logits, logits + cfg.vocab_size) - logits));
+  }
+  fed.pop_back();
+
+  // The same tokens in one multi-token run give the same logits at every
+  // position, so the swapped buffers held the right cache at each step.
+  model.decoder_reset(state.get());
+  std::vector<float> all_logits(kSteps * cfg.vocab_size);
+  REQUIRE(model.decode_tokens(state.get(), fed.data(), kSteps,
+                              all_logits.data()) == 0);
+  for (size_t i = 0; i < all_logits.size(); ++i) {
+    REQUIRE(all_logits[i] == doctest::Approx(step_logits[i]).epsilon(1e-3));
+  }
+}
@@ -15,10 +15,13 @@
 
 #include <algorithm>
 #include <fstream>
+#include <set>
 #include <sstream>
+#include <utility>
 
 #include "bin-tokenizer.h"
 #include "moonshine-ort-allocator.h"
+#include "moonshine-streaming-decode-scheduler.h"
 #include "string-utils.h"
 
 #define DEBUG_ALLOC_ENABLED 1
@@ -143,9 +146,11 @@ void MoonshineStreamingState::reset(const MoonshineStreamingConfig &cfg) {
   memory.clear();
   memory_len = 0;
 
-  // Decoder cache
+  // Decoder cache. Clearing keeps the capacity reserved for max_seq_len.
   k_self.clear();
   v_self.clear();
+  k_self_next.clear();
+  v_self_next.clear();
   cache_seq_len = 0;
 
   // Cross-attention KV cache
@@ -155,6 +160,25 @@ void MoonshineStreamingState::reset(const MoonshineStreamingConfig &cfg) {
   cross_kv_valid = false;
 }
 
+void append_cross_kv(std::vector<float> &buffer, const float *src,
+                     size_t head_count, size_t head_dim, size_t old_len,
+                     size_t new_len) {
+  const size_t total_len = old_len + new_len;
+  const size_t needed = head_count * total_len * head_dim;
+  if (buffer.capacity() < needed) {
+    buffer.reserve(needed * 2);
+  }
+  buffer.resize(needed);
+  float *data = buffer.data();
+  for (size_t i = head_count; i-- > 0;) {
+    float *head = data + i * total_len * head_dim;
+    std::memmove(head, data + i * old_len * head_dim,
+                 old_len * head_dim * sizeof(float));
+    std::memcpy(head + old_len * head_dim, src + i * new_len * head_dim,
+                new_len * head_dim * sizeof(float));
+  }
+}
+
 /* ============================================================================
  * MoonshineStreamingModel Implementation
  * ============================================================================
@@ -189,6 +213,7 @@ MoonshineStreamingModel::MoonshineStreamingModel(
 }
 
 MoonshineStreamingModel::~MoonshineStreamingModel() {
+  if (decoder_io_binding) ort_api->ReleaseIoBinding(decoder_io_binding);
   ort_api->ReleaseEnv(ort_env);
   ort_api->ReleaseMemoryInfo(ort_memory_info);
   ort_api->ReleaseSessionOptions(ort_session_options);
@@ -785,30 +810,60 @@ int MoonshineStreamingModel::compute_cross_kv(MoonshineStreamingState *state) {
     return 1;
   }
 
-  // Input: memory [1, mem_len, decoder_dim]
-  std::vector<int64_t> memory_shape = {1, state->memory_len,
+  // Cross K/V are per-frame projections of the memory, and the memory only
+  // grows within a segment. An export that takes a frame offset is declared
+  // to work on a slice, so only the frames added since the last call need
+  // projecting. Older exports get the whole memory every time.
+  RETURN_ON_ERROR(inspect_cross_kv_io());
+  const size_t head_count = static_cast<size_t>(config.depth) * config.nheads;
+  const bool can_append =
+      cross_kv_io_frame_offset && state->cross_len > 0 &&
+      state->cross_len < state->memory_len &&
+      state->k_cross.size() ==
+          head_count * state->cross_len * config.head_dim;
+  int64_t first_frame = can_append ? state->cross_len : 0;
+
+  // Input: memory [1, mem_len, decoder_dim], from first_frame on
+  std::vector<int64_t> memory_shape = {1, state->memory_len - first_frame,
                                        config.decoder_dim};
+  float *memory_data = state->memory.data() + first_frame * config.decoder_dim;
+  size_t memory_bytes = static_cast<size_t>(memory_shape[1]) *
+                        config.decoder_dim * sizeof(float);
 
-  OrtValue *memory_tensor = nullptr;
+  // Every value created here is released on the way out, including the
+  // early returns below.
+  OrtValue *inputs[] = {nullptr, nullptr};
+  OrtValue *outputs[2] = {nullptr, nullptr};
+  ScopeExit release_values([&]() {
+    for (OrtValue *value : {inputs[0], inputs[1], outputs[0], outputs[1]}) {
+      if (value != nullptr) {
+        ort_api->ReleaseValue(value);
+      }
+    }
+  });
   RETURN_ON_ORT_ERROR(
       ort_api, ort_api->CreateTensorWithDataAsOrtValue(
-                   ort_memory_info, state->memory.data(),
-                   state->memory.size() * sizeof(float), memory_shape.data(),
-                   memory_shape.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
-                   &memory_tensor));
+                   ort_memory_info, memory_data, memory_bytes,
+                   memory_shape.data(), memory_shape.size(),
+                   ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &inputs[0]));
 
   // Run cross_kv session
-  const char *input_names[] = {"memory"};
+  const char *input_names[] = {"memory", "frame_offset"};
   const char *output_names[] = {"k_cross", "v_cross"};
 
-  OrtValue *inputs[] = {memory_tensor};
-  OrtValue *outputs[2] = {nullptr, nullptr};
-
-  OrtStatus *status = ORT_RUN(ort_api, cross_kv_session, input_names, inputs, 1,
-                              output_names, 2, outputs);
-
-  ort_api->ReleaseValue(memory_tensor);
+  size_t input_count = 1;
+  if (cross_kv_io_frame_offset) {
+    std::vector<int64_t> offset_shape = {1};
+    RETURN_ON_ORT_ERROR(
+        ort_api, ort_api->CreateTensorWithDataAsOrtValue(
+                     ort_memory_info, &first_frame, sizeof(int64_t),
+                     offset_shape.data(), offset_shape.size(),
+                     ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &inputs[1]));
+    input_count = 2;
+  }
 
+  OrtStatus *status = ORT_RUN(ort_api, cross_kv_session, input_names, inputs,
+                              input_count, output_names, 2, outputs);
   if (status != nullptr) {
     LOG_ORT_ERROR(ort_api, status);
     return 1;
@@ -818,27 +873,20 @@ int MoonshineStreamingModel::compute_cross_kv(MoonshineStreamingState *state) {
   OrtTensorTypeAndShapeInfo *k_info = nullptr;
   RETURN_ON_ORT_ERROR(ort_api,
                       ort_api->GetTensorTypeAndShape(outputs[0], &k_info));
+  ScopeExit release_k_info(
+      [&]() { ort_api->ReleaseTensorTypeAndShapeInfo(k_info); });
   size_t num_dims = 0;
   RETURN_ON_ORT_ERROR(ort_api, ort_api->GetDimensionsCount(k_info, &num_dims));
   std::vector<int64_t> k_shape(num_dims);
   RETURN_ON_ORT_ERROR(ort_api,
                       ort_api->GetDimensions(k_info, k_shape.data(), num_dims));
-  ort_api->ReleaseTensorTypeAndShapeInfo(k_info);
 
   if (num_dims != 5) {
     LOG("Expected 5D cross KV tensor\n");
-    for (int i = 0; i < 2; i++) ort_api->ReleaseValue(outputs[i]);
     return 1;
   }
 
   int cross_len = static_cast<int>(k_shape[3]);
-  size_t kv_size = static_cast<size_t>(config.depth) * config.nheads *
-                   cross_len * config.head_dim;
-
-  // Copy to state
-  state->k_cross.resize(kv_size);
-  state->v_cross.resize(kv_size);
-  state->cross_len = cross_len;
 
   float *k_data = nullptr;
   float *v_data = nullptr;
@@ -847,15 +895,14 @@ int MoonshineStreamingModel::compute_cross_kv(MoonshineStreamingState *state) {
   RETURN_ON_ORT_ERROR(
       ort_api, ort_api->GetTensorMutableData(outputs[1], (void **)&v_data));
 
-  memcpy(state->k_cross.data(), k_data, kv_size * sizeof(float));
-  memcpy(state->v_cross.data(), v_data, kv_size * sizeof(float));
+  // Copy to state, after any frames already there
+  const size_t old_len = static_cast<size_t>(first_frame);
+  append_cross_kv(state->k_cross, k_data, head_count, config.head_dim,
+                  old_len, cross_len);
+  append_cross_kv(state->v_cross, v_data, head_count, config.head_dim,
+                  old_len, cross_len);
+  state->cross_len = static_cast<int>(old_len) + cross_len;
   state->cross_kv_valid = true;
-
-  // Release outputs
-  for (int i = 0; i < 2; i++) {
-    ort_api->ReleaseValue(outputs[i]);
-  }
-
   return 0;
 }
 
@@ -866,7 +913,7 @@ int MoonshineStreamingModel::compute_cross_kv(MoonshineStreamingState *state) {
 
 int MoonshineStreamingModel::run_decoder_with_cross_kv(
     MoonshineStreamingState *state, const std::vector<int64_t> &tokens,
-    std::vector<float> &logits_out) {
+    float *logits_out) {
   if (state == nullptr || decoder_kv_session == nullptr) {
     return 1;
   }
@@ -879,205 +926,231 @@ int MoonshineStreamingModel::run_decoder_with_cross_kv(
   if (token_len == 0) {
     return 1;
   }
-
-  // Token input [1, token_len]
-  std::vector<int64_t> token_shape = {1, static_cast<int64_t>(token_len)};
-  std::vector<int64_t> token_data(tokens.begin(), tokens.end());
-
-  OrtValue *token_tensor = nullptr;
-  RETURN_ON_ORT_ERROR(
-      ort_api, ort_api->CreateTensorWithDataAsOrtValue(
-                   ort_memory_info, token_data.data(),
-                   token_data.size() * sizeof(int64_t), token_shape.data(),
-                   token_shape.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64,
-                   &token_tensor));
-
-  // Self-attention KV cache [depth, 1, nheads, cache_len, head_dim]
-  int cache_len = state->cache_seq_len;
-  std::vector<int64_t> kv_self_shape = {config.depth, 1, config.nheads,
-                                        cache_len, config.head_dim};
-  size_t kv_self_size = static_cast<size_t>(config.depth) * config.nheads *
-                        cache_len * config.head_dim;
-
-  if (state->k_self.size() != kv_self_size) {
+  RETURN_ON_ERROR(inspect_decoder_io());
+
+  // Self-attention KV cache [depth, 1, nheads, cache_len, head_dim]. The
+  // decoder reads the cache from k_self/v_self and writes the grown one
+  // straight into k_self_next/v_self_next, and the pairs swap afterwards, so
+  // a step neither copies the cache nor, once reserved, reallocates it.
+  const size_t head_count = static_cast<size_t>(config.depth) * config.nheads;
+  const int cache_len = state->cache_seq_len;
+  const int new_cache_len = cache_len + token_len;
+  const size_t kv_self_size = head_count * cache_len * config.head_dim;
+  const size_t new_kv_self_size = head_count * new_cache_len * config.head_dim;
+  const size_t kv_self_capacity =
+      head_count * (config.max_seq_len + 1) * config.head_dim;
+  for (std::vector<float> *buffer : {&state->k_self, &state->v_self,
+                                     &state->k_self_next,
+                                     &state->v_self_next}) {
+    if (buffer->capacity() < kv_self_capacity) {
+      buffer->reserve(kv_self_capacity);
+    }
+  }
+  if (state->k_self.size() < kv_self_size) {
     state->k_self.resize(kv_self_size, 0.0f);
     state->v_self.resize(kv_self_size, 0.0f);
   }
+  state->k_self_next.resize(new_kv_self_size);
+  state->v_self_next.resize(new_kv_self_size);
 
-  OrtValue *k_self_tensor = nullptr;
-  RETURN_ON_ORT_ERROR(
-      ort_api, ort_api->CreateTensorWithDataAsOrtValue(
-                   ort_memory_info, state->k_self.data(),
-                   state->k_self.size() * sizeof(float), kv_self_shape.data(),
-                   kv_self_shape.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
-                   &k_self_tensor));
-
-  OrtValue *v_self_tensor = nullptr;
-  RETURN_ON_ORT_ERROR(
-      ort_api, ort_api->CreateTensorWithDataAsOrtValue(
-                   ort_memory_info, state->v_self.data(),
-                   state->v_self.size() * sizeof(float), kv_self_shape.data(),
-                   kv_self_shape.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
-                   &v_self_tensor));
-
-  // Cross-attention KV cache [depth, 1, nheads, cross_len, head_dim]
-  std::vector<int64_t> kv_cross_shape = {config.depth, 1, config.nheads,
-                                         state->cross_len, config.head_dim};
-  size_t kv_cross_size = static_cast<size_t>(config.depth) * config.nheads *
-                         state->cross_len * config.head_dim;
-
-  OrtValue *k_cross_tensor = nullptr;
-  RETURN_ON_ORT_ERROR(
-      ort_api,
-      ort_api->CreateTensorWithDataAsOrtValue(
-          ort_memory_info, state->k_cross.data(), kv_cross_size * sizeof(float),
-          kv_cross_shape.data(), kv_cross_shape.size(),
-          ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &k_cross_tensor));
-
-  OrtValue *v_cross_tensor = nullptr;
-  RETURN_ON_ORT_ERROR(
-      ort_api,
-      ort_api->CreateTensorWithDataAsOrtValue(
-          ort_memory_info, state->v_cross.data(), kv_cross_size * sizeof(float),
-          kv_cross_shape.data(), kv_cross_shape.size(),
-          ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &v_cross_tensor));
-
-  // Run decoder_kv session
-  // Build output names dynamically (base 5 + optional cross_attentions)
-  size_t decoder_output_count = 0;
-  RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetOutputCount(
-                                   decoder_kv_session, &decoder_output_count));
-
-  std::vector<const char *> output_names_vec;
-  std::vector<char *> output_names_alloc(decoder_output_count);
-  for (size_t i = 0; i < decoder_output_count; i++) {
-    RETURN_ON_ORT_ERROR(ort_api,
-                        ort_api->SessionGetOutputName(decoder_kv_session, i,
-                                                      &ort_allocator->base,
-                                                      &output_names_alloc[i]));
-    output_names_vec.push_back(output_names_alloc[i]);
+  std::vector<int64_t> token_data(tokens.begin(), tokens.end());
+  std::vector<int64_t> position_ids(token_len);
+  for (int t = 0; t < token_len; ++t) {
+    position_ids[t] = cache_len + t;
+  }
+  // A decoder exported for batching also wants positions and masks. With a
+  // single unpadded row every cache and memory position is real.
+  std::vector<int64_t> self_mask;
+  std::vector<int64_t> cross_mask;
+  if (decoder_io_batch_inputs) {
+    self_mask.assign(cache_len, 1);
+    cross_mask.assign(state->cross_len, 1);
+  }
+
+  const std::vector<int64_t> token_shape = {1, token_len};
+  const std::vector<int64_t> kv_self_shape = {config.depth, 1, config.nheads,
+                                              cache_len, config.head_dim};
+  const std::vector<int64_t> new_kv_self_shape = {
+      config.depth, 1, config.nheads, new_cache_len, config.head_dim};
+  const std::vector<int64_t> kv_cross_shape = {
+      config.depth, 1, config.nheads, state->cross_len, config.head_dim};
+  const std::vector<int64_t> self_mask_shape = {1, cache_len};
+  const std::vector<int64_t> cross_mask_shape = {1, state->cross_len};
+  const std::vector<int64_t> logits_shape = {1, token_len, config.vocab_size};
+  const size_t kv_cross_size = head_count * state->cross_len * config.head_dim;
+
+  // Inputs and outputs are all wrappers around buffers owned by the state or
+  // the caller; ORT reads and writes those buffers directly.
+  std::vector<OrtValue *> values;
+  auto release_values = [&]() {
+    for (OrtValue *value : values) {
+      ort_api->ReleaseValue(value);
+    }
+  };
+  auto wrap = [&](void *data, size_t bytes, const std::vector<int64_t> &shape,
+                  ONNXTensorElementDataType type) -> OrtValue * {
+    OrtValue *value = nullptr;
+    OrtStatus *status = ort_api->CreateTensorWithDataAsOrtValue(
+        ort_memory_info, data, bytes, shape.data(), shape.size(), type,
+        &value);
+    if (status != nullptr) {
+      LOG_ORT_ERROR(ort_api, status);
+      return nullptr;
+    }
+    values.push_back(value);
+    return value;
+  };
+  const ONNXTensorElementDataType f32 = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+  const ONNXTensorElementDataType i64 = ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64;
+
+  std::vector<std::pair<const char *, OrtValue *>> inputs = {
+      {"token", wrap(token_data.data(), token_data.size() * sizeof(int64_t),
+                     token_shape, i64)},
+      {"k_self", wrap(state->k_self.data(), kv_self_size * sizeof(float),
+                      kv_self_shape, f32)},
+      {"v_self", wrap(state->v_self.data(), kv_self_size * sizeof(float),
+                      kv_self_shape, f32)},
+      {"out_k_cross", wrap(state->k_cross.data(), kv_cross_size * sizeof(float),
+                           kv_cross_shape, f32)},
+      {"out_v_cross", wrap(state->v_cross.data(), kv_cross_size * sizeof(float),
+                           kv_cross_shape, f32)},
+  };
+  if (decoder_io_batch_inputs) {
+    inputs.push_back(
+        {"self_attention_mask",
+         wrap(self_mask.data(), self_mask.size() * sizeof(int64_t),
+              self_mask_shape, i64)});
+    inputs.push_back(
+        {"cross_attention_mask",
+         wrap(cross_mask.data(), cross_mask.size() * sizeof(int64_t),
+              cross_mask_shape, i64)});
+    inputs.push_back(
+        {"position_ids",
+         wrap(position_ids.data(), position_ids.size() * sizeof(int64_t),
+              token_shape, i64)});
+  }
+  const std::pair<const char *, OrtValue *> outputs[] = {
+      {"logits",
+       wrap(logits_out,
+            static_cast<size_t>(token_len) * config.vocab_size * sizeof(float),
+            logits_shape, f32)},
+      {"out_k_self", wrap(state->k_self_next.data(),
+                          new_kv_self_size * sizeof(float), new_kv_self_shape,
+                          f32)},
+      {"out_v_self", wrap(state->v_self_next.data(),
+                          new_kv_self_size * sizeof(float), new_kv_self_shape,
+                          f32)},
+  };
+  if (values.size() != inputs.size() + 3) {
+    release_values();
+    return 1;
   }
 
-  const char *input_names[] = {"token", "k_self", "v_self", "out_k_cross",
-                               "out_v_cross"};
-  OrtValue *inputs[] = {token_tensor, k_self_tensor, v_self_tensor,
-                        k_cross_tensor, v_cross_tensor};
-  std::vector<OrtValue *> outputs(decoder_output_count, nullptr);
+  // Bind everything the step needs. The cross K/V outputs only echo their
+  // inputs, so they are left unbound and never materialized; cross
+  // attentions, when the decoder has them, go to ORT-allocated memory since
+  // their layout is the export's business.
+  ort_api->ClearBoundInputs(decoder_io_binding);
+  ort_api->ClearBoundOutputs(decoder_io_binding);
+  OrtStatus *status = nullptr;
+  for (const auto &input : inputs) {
+    if (status == nullptr) {
+      status = ort_api->BindInput(decoder_io_binding, input.first,
+                                  input.second);
+    }
+  }
+  for (const auto &output : outputs) {
+    if (status == nullptr) {
+      status = ort_api->BindOutput(decoder_io_binding, output.first,
+                                   output.second);
+    }
+  }
+  for (const std::string &name : decoder_io_attention_names) {
+    if (status == nullptr) {
+      status = ort_api->BindOutputToDevice(decoder_io_binding, name.c_str(),
+                                           ort_memory_info);
+    }
+  }
+  if (status == nullptr) {
+    status = ORT_RUN_WITH_BINDING(ort_api, decoder_kv_session,
+                                  decoder_io_binding);
+  }
+  ort_api->ClearBoundInputs(decoder_io_binding);
+  release_values();
+  if (status != nullptr) {
+    ort_api->ClearBoundOutputs(decoder_io_binding);
+    LOG_ORT_ERROR(ort_api, status);
+    return 1;
+  }
 
-  OrtStatus *status =
-      ORT_RUN(ort_api, decoder_kv_session, input_names, inputs, 5,
-              output_names_vec.data(), decoder_output_count, outputs.data());
+  std::swap(state->k_self, state->k_self_next);
+  std::swap(state->v_self, state->v_self_next);
+  state->cache_seq_len = new_cache_len;
 
-  // Release inputs
-  for (int i = 0; i < 5; i++) {
-    ort_api->ReleaseValue(inputs[i]);
+  if (decoder_io_attention_names.empty()) {
+    ort_api->ClearBoundOutputs(decoder_io_binding);
+    return 0;
   }
 
+  // Collect cross-attention weights. Bound values come back in binding
+  // order, so the attention outputs follow the three bound above.
+  OrtValue **bound = nullptr;
+  size_t bound_count = 0;
+  status = ort_api->GetBoundOutputValues(
+      decoder_io_binding, &ort_allocator->base, &bound, &bound_count);
+  ort_api->ClearBoundOutputs(decoder_io_binding);
   if (status != nullptr) {
     LOG_ORT_ERROR(ort_api, status);
-    for (auto *n : output_names_alloc)
-      ort_allocator->base.Free(&ort_allocator->base, n);
     return 1;
   }
-
-  // Build name→index map for outputs
-  std::map<std::string, size_t> output_index;
-  for (size_t i = 0; i < decoder_output_count; i++) {
-    output_index[output_names_vec[i]] = i;
+  int err = 0;
+  for (size_t i = 3; i < bound_count && err == 0; i++) {
+    err = collect_cross_attention(bound[i], state->cross_len);
   }
+  for (size_t i = 0; i < bound_count; i++) {
+    ort_api->ReleaseValue(bound[i]);
+  }
+  ort_allocator->base.Free(&ort_allocator->base, bound);
+  return err;
+}
 
-  // Copy logits [1, token_len, vocab_size]
-  float *logits_data = nullptr;
-  RETURN_ON_ORT_ERROR(
-      ort_api, ort_api->GetTensorMutableData(outputs[output_index["logits"]],
-                                             (void **)&logits_data));
-
-  size_t total_logits = token_len * config.vocab_size;
-  logits_out.resize(total_logits);
-  memcpy(logits_out.data(), logits_data, total_logits * sizeof(float));
-
-  // Update self-attention KV cache
-  size_t k_idx = output_index["out_k_self"];
-  OrtTensorTypeAndShapeInfo *k_info = nullptr;
+int MoonshineStreamingModel::collect_cross_attention(OrtValue *attention,
+                                                     int cross_len) {
+  OrtTensorTypeAndShapeInfo *attn_info = nullptr;
   RETURN_ON_ORT_ERROR(ort_api,
-                      ort_api->GetTensorTypeAndShape(outputs[k_idx], &k_info));
-  size_t num_dims = 0;
-  RETURN_ON_ORT_ERROR(ort_api, ort_api->GetDimensionsCount(k_info, &num_dims));
-  std::vector<int64_t> k_shape(num_dims);
+                      ort_api->GetTensorTypeAndShape(attention, &attn_info));
+  size_t attn_ndims = 0;
   RETURN_ON_ORT_ERROR(ort_api,
-                      ort_api->GetDimensions(k_info, k_shape.data(), num_dims));
-  ort_api->ReleaseTensorTypeAndShapeInfo(k_info);
-
-  int new_cache_len = static_cast<int>(k_shape[3]);
-  size_t new_cache_size = static_cast<size_t>(config.depth) * config.nheads *
-                          new_cache_len * config.head_dim;
+                      ort_api->GetDimensionsCount(attn_info, &attn_ndims));
+  std::vector<int64_t> attn_shape(attn_ndims);
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->GetDimensions(
+                                   attn_info, attn_shape.data(), attn_ndims));
+  ort_api->ReleaseTensorTypeAndShapeInfo(attn_info);
 
-  state->k_self.resize(new_cache_size);
-  state->v_self.resize(new_cache_size);
+  // Shape: [batch, heads, seq_len, enc_len] or similar
+  int heads =
+      (attn_ndims >= 2) ? static_cast<int>(attn_shape[1]) : config.nheads;
+  int enc_len = (attn_ndims >= 4)   ? static_cast<int>(attn_shape[3])
+                : (attn_ndims >= 3) ? static_cast<int>(attn_shape[2])
+                                    : cross_len;
 
-  float *k_out_data = nullptr;
-  float *v_out_data = nullptr;
-  RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorMutableData(
-                                   outputs[k_idx], (void **)&k_out_data));
-  size_t v_idx = output_index["out_v_self"];
+  float *attn_data = nullptr;
   RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorMutableData(
-                                   outputs[v_idx], (void **)&v_out_data));
-
-  memcpy(state->k_self.data(), k_out_data, new_cache_size * sizeof(float));
-  memcpy(state->v_self.data(), v_out_data, new_cache_size * sizeof(float));
-  state->cache_seq_len = new_cache_len;
-
-  // Collect cross-attention weights if decoder has them
-  for (int layer = 0; layer < config.depth; layer++) {
-    std::string attn_name = "cross_attentions." + std::to_string(layer);
-    auto it = output_index.find(attn_name);
-    if (it == output_index.end()) break;
-
-    OrtTensorTypeAndShapeInfo *attn_info = nullptr;
-    RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorTypeAndShape(
-                                     outputs[it->second], &attn_info));
-    size_t attn_ndims = 0;
-    RETURN_ON_ORT_ERROR(ort_api,
-                        ort_api->GetDimensionsCount(attn_info, &attn_ndims));
-    std::vector<int64_t> attn_shape(attn_ndims);
-    RETURN_ON_ORT_ERROR(ort_api, ort_api->GetDimensions(
-                                     attn_info, attn_shape.data(), attn_ndims));
-    ort_api->ReleaseTensorTypeAndShapeInfo(attn_info);
-
-    // Shape: [batch, heads, seq_len, enc_len] or similar
-    int heads =
-        (attn_ndims >= 2) ? static_cast<int>(attn_shape[1]) : config.nheads;
-    int enc_len = (attn_ndims >= 4)   ? static_cast<int>(attn_shape[3])
-                  : (attn_ndims >= 3) ? static_cast<int>(attn_shape[2])
-                                      : state->cross_len;
-
-    float *attn_data = nullptr;
-    RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorMutableData(
-                                     outputs[it->second], (void **)&attn_data));
-
-    size_t step_size = 1;
-    for (size_t d = 0; d < attn_ndims; d++) step_size *= attn_shape[d];
+                                   attention, (void **)&attn_data));
 
-    size_t old_size = cross_attention_buffer.size();
-    cross_attention_buffer.resize(old_size + step_size);
-    memcpy(cross_attention_buffer.data() + old_size, attn_data,
-           step_size * sizeof(float));
+  size_t step_size = 1;
+  for (size_t d = 0; d < attn_ndims; d++) step_size *= attn_shape[d];
 
-    if (cross_attn_steps == 0) {
-      cross_attn_heads = heads;
-      cross_attn_enc_len = enc_len;
-    }
-    cross_attn_steps++;
-  }
+  size_t old_size = cross_attention_buffer.size();
+  cross_attention_buffer.resize(old_size + step_size);
+  memcpy(cross_attention_buffer.data() + old_size, attn_data,
+         step_size * sizeof(float));
 
-  // Release outputs
-  for (size_t i = 0; i < decoder_output_count; i++) {
-    if (outputs[i]) ort_api->ReleaseValue(outputs[i]);
+  if (cross_attn_steps == 0) {
+    cross_attn_heads = heads;
+    cross_attn_enc_len = enc_len;
   }
-  for (auto *n : output_names_alloc) {
-    ort_allocator->base.Free(&ort_allocator->base, n);
-  }
-
+  cross_attn_steps++;
   return 0;
 }
 
@@ -1104,7 +1177,6 @@ int MoonshineStreamingModel::decode_step(MoonshineStreamingState *state,
   std::lock_guard<std::mutex> lock(processing_mutex);
 
   std::vector<int64_t> tokens = {static_cast<int64_t>(token)};
-  std::vector<float> logits;
 
   int err;
 
@@ -1117,14 +1189,331 @@ int MoonshineStreamingModel::decode_step(MoonshineStreamingState *state,
     }
   }
 
-  err = run_decoder_with_cross_kv(state, tokens, logits);
+  // The decoder writes the logits straight into the caller's buffer.
+  return run_decoder_with_cross_kv(state, tokens, logits_out);
+}
+
+/* ============================================================================
+ * Batched single-token decode step (one row per stream)
+ * ============================================================================
+ */
+
+int MoonshineStreamingModel::inspect_decoder_io() {
+  if (decoder_kv_session == nullptr) {
+    return 1;
+  }
+  if (decoder_io_session == decoder_kv_session) {
+    return 0;
+  }
+  size_t input_count = 0;
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetInputCount(decoder_kv_session,
+                                                             &input_count));
+  bool has_position_ids = false;
+  for (size_t i = 0; i < input_count; i++) {
+    char *name = nullptr;
+    RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetInputName(
+                                     decoder_kv_session, i,
+                                     &ort_allocator->base, &name));
+    if (std::strcmp(name, "position_ids") == 0) {
+      has_position_ids = true;
+    }
+    ort_allocator->base.Free(&ort_allocator->base, name);
+  }
+  size_t output_count = 0;
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetOutputCount(
+                                   decoder_kv_session, &output_count));
+  std::set<std::string> output_names;
+  for (size_t i = 0; i < output_count; i++) {
+    char *name = nullptr;
+    RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetOutputName(
+                                     decoder_kv_session, i,
+                                     &ort_allocator->base, &name));
+    output_names.insert(name);
+    ort_allocator->base.Free(&ort_allocator->base, name);
+  }
+  // Attention weights are collected layer by layer, stopping at the first
+  // layer the export doesn't provide.
+  decoder_io_attention_names.clear();
+  for (int layer = 0; layer < config.depth; layer++) {
+    std::string name = "cross_attentions." + std::to_string(layer);
+    if (output_names.count(name) == 0) break;
+    decoder_io_attention_names.push_back(name);
+  }
+
+  if (decoder_io_binding != nullptr) {
+    ort_api->ReleaseIoBinding(decoder_io_binding);
+    decoder_io_binding = nullptr;
+  }
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->CreateIoBinding(decoder_kv_session,
+                                                        &decoder_io_binding));
+  decoder_io_batch_inputs = has_position_ids;
+  decoder_io_session = decoder_kv_session;
+  return 0;
+}
+
+int MoonshineStreamingModel::inspect_cross_kv_io() {
+  if (cross_kv_session == nullptr) {
+    return 1;
+  }
+  if (cross_kv_io_session == cross_kv_session) {
+    return 0;
+  }
+  size_t input_count = 0;
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetInputCount(cross_kv_session,
+                                                             &input_count));
+  bool has_frame_offset = false;
+  for (size_t i = 0; i < input_count; i++) {
+    char *name = nullptr;
+    RETURN_ON_ORT_ERROR(ort_api, ort_api->SessionGetInputName(
+                                     cross_kv_session, i,
+                                     &ort_allocator->base, &name));
+    if (std::strcmp(name, "frame_offset") == 0) {
+      has_frame_offset = true;
+    }
+    ort_allocator->base.Free(&ort_allocator->base, name);
+  }
+  cross_kv_io_frame_offset = has_frame_offset;
+  cross_kv_io_session = cross_kv_session;
+  return 0;
+}
+
+bool MoonshineStreamingModel::decoder_supports_batch() {
+  std::lock_guard<std::mutex> lock(processing_mutex);
+  if (inspect_decoder_io() != 0) {
+    return false;
+  }
+  // Attention weights are collected into one model-wide buffer per step, so
+  // rows from different streams can't share a run with them.
+  return decoder_io_batch_inputs && decoder_io_attention_names.empty();
+}
+
+int MoonshineStreamingModel::decode_step_batch(
+    MoonshineStreamingState *const *states, const int *tokens,
+    float *const *logits_out, int batch_size) {
+  if (states == nullptr || tokens == nullptr || logits_out == nullptr ||
+      batch_size <= 0) {
+    LOG("Invalid batch decode arguments\n");
+    return 1;
+  }
+  if (batch_size == 1 || !decoder_supports_batch()) {
+    for (int b = 0; b < batch_size; ++b) {
+      RETURN_ON_ERROR(decode_step(states[b], tokens[b], logits_out[b]));
+    }
+    return 0;
+  }
+  for (int b = 0; b < batch_size; ++b) {
+    if (states[b] == nullptr || logits_out[b] == nullptr ||
+        states[b]->memory_len == 0) {
+      LOG("Invalid batch decode row\n");
+      return 1;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(processing_mutex);
+  for (int b = 0; b < batch_size; ++b) {
+    if (!states[b]->cross_kv_valid) {
+      int err = compute_cross_kv(states[b]);
+      if (err != 0) {
+        LOG("Failed to compute cross K/V\n");
+        return err;
+      }
+    }
+  }
+  return run_batched_decoder_step(states, tokens, logits_out, batch_size);
+}
+
+void MoonshineDecoderBatch::pack(const MoonshineStreamingConfig &cfg,
+                                 const MoonshineStreamingState *const *states,
+                                 const int *row_tokens, int rows) {
+  const int64_t B = rows;
+  const int64_t L = cfg.depth;
+  const int64_t H = cfg.nheads;
+  const int64_t D = cfg.head_dim;
+
+  batch_size = B;
+  cache_len = 0;
+  cross_len = 0;
+  for (int64_t b = 0; b < B; ++b) {
+    cache_len = std::max<int64_t>(cache_len, states[b]->cache_seq_len);
+    cross_len = std::max<int64_t>(cross_len, states[b]->cross_len);
+  }
+
+  const size_t self_size = static_cast<size_t>(L * B * H * cache_len * D);
+  const size_t cross_size = static_cast<size_t>(L * B * H * cross_len * D);
+  k_self.assign(self_size, 0.0f);
+  v_self.assign(self_size, 0.0f);
+  k_cross.assign(cross_size, 0.0f);
+  v_cross.assign(cross_size, 0.0f);
+  tokens.resize(B);
+  position_ids.resize(B);
+  self_mask.assign(B * cache_len, 0);
+  cross_mask.assign(B * cross_len, 0);
+
+  for (int64_t b = 0; b < B; ++b) {
+    const MoonshineStreamingState *state = states[b];
+    const int64_t c = state->cache_seq_len;
+    const int64_t m = state->cross_len;
+    tokens[b] = row_tokens[b];
+    position_ids[b] = c;
+    std::fill_n(self_mask.begin() + b * cache_len + (cache_len - c), c, 1);
+    std::fill_n(cross_mask.begin() + b * cross_len, m, 1);
+    for (int64_t l = 0; l < L; ++l) {
+      for (int64_t h = 0; h < H; ++h) {
+        const int64_t row = (l * B + b) * H + h;
+        const size_t self_src = static_cast<size_t>((l * H + h) * c * D);
+        const size_t self_dst =
+            static_cast<size_t>((row * cache_len + cache_len - c) * D);
+        std::copy_n(state->k_self.data() + self_src, c * D,
+                    k_self.data() + self_dst);
+        std::copy_n(state->v_self.data() + self_src, c * D,
+                    v_self.data() + self_dst);
+        const size_t cross_src = static_cast<size_t>((l * H + h) * m * D);
+        const size_t cross_dst = static_cast<size_t>(row * cross_len * D);
+        std::copy_n(state->k_cross.data() + cross_src, m * D,
+                    k_cross.data() + cross_dst);
+        std::copy_n(state->v_cross.data() + cross_src, m * D,
+                    v_cross.data() + cross_dst);
+      }
+    }
+  }
+}
+
+void MoonshineDecoderBatch::unpack_self_kv(
+    const MoonshineStreamingConfig &cfg, MoonshineStreamingState *const *states,
+    const float *k_out, const float *v_out) const {
+  const int64_t B = batch_size;
+  const int64_t L = cfg.depth;
+  const int64_t H = cfg.nheads;
+  const int64_t D = cfg.head_dim;
+  // Each row's grown cache is its old entries plus the one just appended,
+  // right-aligned like the input.
+  const int64_t out_len = cache_len + 1;
+  for (int64_t b = 0; b < B; ++b) {
+    MoonshineStreamingState *state = states[b];
+    const int64_t c = state->cache_seq_len + 1;
+    state->k_self.resize(static_cast<size_t>(L * H * c * D));
+    state->v_self.resize(static_cast<size_t>(L * H * c * D));
+    for (int64_t l = 0; l < L; ++l) {
+      for (int64_t h = 0; h < H; ++h) {
+        const int64_t row = (l * B + b) * H + h;
+        const size_t src =
+            static_cast<size_t>((row * out_len + out_len - c) * D);
+        const size_t dst = static_cast<size_t>((l * H + h) * c * D);
+        std::copy_n(k_out + src, c * D, state->k_self.data() + dst);
+        std::copy_n(v_out + src, c * D, state->v_self.data() + dst);
+      }
+    }
+    state->cache_seq_len = static_cast<int>(c);
+  }
+}
+
+int MoonshineStreamingModel::run_batched_decoder_step(
+    MoonshineStreamingState *const *states, const int *tokens,
+    float *const *logits_out, int batch_size) {
+  MoonshineDecoderBatch &batch = decoder_batch;
+  batch.pack(config, states, tokens, batch_size);
+
+  const int64_t B = batch_size;
+  const int64_t L = config.depth;
+  const int64_t H = config.nheads;
+  const int64_t D = config.head_dim;
+  const std::vector<int64_t> token_shape = {B, 1};
+  const std::vector<int64_t> self_shape = {L, B, H, batch.cache_len, D};
+  const std::vector<int64_t> cross_shape = {L, B, H, batch.cross_len, D};
+  const std::vector<int64_t> self_mask_shape = {B, batch.cache_len};
+  const std::vector<int64_t> cross_mask_shape = {B, batch.cross_len};
+
+  std::vector<OrtValue *> inputs;
+  auto add_input = [&](auto &data, const std::vector<int64_t> &shape,
+                       ONNXTensorElementDataType type) -> OrtStatus * {
+    OrtValue *value = nullptr;
+    OrtStatus *status = ort_api->CreateTensorWithDataAsOrtValue(
+        ort_memory_info, data.data(), data.size() * sizeof(data[0]),
+        shape.data(), shape.size(), type, &value);
+    if (status == nullptr) {
+      inputs.push_back(value);
+    }
+    return status;
+  };
+  auto release_inputs = [&]() {
+    for (OrtValue *input : inputs) {
+      ort_api->ReleaseValue(input);
+    }
+  };
+
+  const ONNXTensorElementDataType f32 = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+  const ONNXTensorElementDataType i64 = ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64;
+  OrtStatus *status = add_input(batch.tokens, token_shape, i64);
+  if (status == nullptr) {
+    status = add_input(batch.k_self, self_shape, f32);
+  }
+  if (status == nullptr) {
+    status = add_input(batch.v_self, self_shape, f32);
+  }
+  if (status == nullptr) {
+    status = add_input(batch.k_cross, cross_shape, f32);
+  }
+  if (status == nullptr) {
+    status = add_input(batch.v_cross, cross_shape, f32);
+  }
+  if (status == nullptr) {
+    status = add_input(batch.self_mask, self_mask_shape, i64);
+  }
+  if (status == nullptr) {
+    status = add_input(batch.cross_mask, cross_mask_shape, i64);
+  }
+  if (status == nullptr) {
+    status = add_input(batch.position_ids, token_shape, i64);
+  }
+  if (status != nullptr) {
+    release_inputs();
+    LOG_ORT_ERROR(ort_api, status);
+    return 1;
+  }
+
+  const char *input_names[] = {"token",
+                               "k_self",
+                               "v_self",
+                               "out_k_cross",
+                               "out_v_cross",
+                               "self_attention_mask",
+                               "cross_attention_mask",
+                               "position_ids"};
+  // Only what the rows need back. The cross K/V outputs just echo the padded
+  // inputs, and each state already holds its own copy.
+  const char *output_names[] = {"logits", "out_k_self", "out_v_self"};
+  OrtValue *outputs[3] = {nullptr, nullptr, nullptr};
+  ScopeExit release_outputs([&]() {
+    for (OrtValue *output : outputs) {
+      if (output != nullptr) {
+        ort_api->ReleaseValue(output);
+      }
+    }
+  });
 
-  if (err != 0) {
-    return err;
+  status = ORT_RUN(ort_api, decoder_kv_session, input_names, inputs.data(),
+                   inputs.size(), output_names, 3, outputs);
+  release_inputs();
+  if (status != nullptr) {
+    LOG_ORT_ERROR(ort_api, status);
+    return 1;
   }
 
-  // Copy logits to output
-  memcpy(logits_out, logits.data(), config.vocab_size * sizeof(float));
+  float *logits_data = nullptr;
+  float *k_out_data = nullptr;
+  float *v_out_data = nullptr;
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorMutableData(
+                                   outputs[0], (void **)&logits_data));
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorMutableData(
+                                   outputs[1], (void **)&k_out_data));
+  RETURN_ON_ORT_ERROR(ort_api, ort_api->GetTensorMutableData(
+                                   outputs[2], (void **)&v_out_data));
+
+  for (int64_t b = 0; b < B; ++b) {
+    std::copy_n(logits_data + b * config.vocab_size, config.vocab_size,
+                logits_out[b]);
+  }
+  batch.unpack_self_kv(config, states, k_out_data, v_out_data);
   return 0;
 }
 
@@ -1160,7 +1549,6 @@ int MoonshineStreamingModel::decode_tokens(MoonshineStreamingState *state,
     token_vec[i] = static_cast<int64_t>(tokens[i]);
   }
 
-  std::vector<float> logits;
   int err;
 
   // Compute cross K/V if not valid
@@ -1172,16 +1560,8 @@ int MoonshineStreamingModel::decode_tokens(MoonshineStreamingState *state,
     }
   }
 
-  err = run_decoder_with_cross_kv(state, token_vec, logits);
-
-  if (err != 0) {
-    return err;
-  }
-
-  // Copy all logits to output
-  memcpy(logits_out, logits.data(),
-         tokens_len * config.vocab_size * sizeof(float));
-  return 0;
+  // All positions' logits land directly in the caller's buffer.
+  return run_decoder_with_cross_kv(state, token_vec, logits_out);
 }
 
 /* ============================================================================
@@ -1193,7 +1573,9 @@ int MoonshineStreamingModel::decode_full(MoonshineStreamingState *state,
                                          const int *speculative_tokens,
                                          int speculative_len, int **tokens_out,
                                          int *tokens_len_out,
-                                         ContextBiaser *biaser) {
+                                         ContextBiaser *biaser,
+                                         MoonshineStreamingDecodeScheduler
+                                             *scheduler) {
   if (state == nullptr) {
     LOG("State is null\n");
     return 1;
@@ -1209,7 +1591,20 @@ int MoonshineStreamingModel::decode_full(MoonshineStreamingState *state,
     return 0;
   }
 
-  std::lock_guard<std::mutex> lock(processing_mutex);
+  // Without a scheduler the whole decode holds the model. With one, the
+  // lock is taken per run instead, since the scheduler's batched steps need
+  // it too.
+  std::unique_lock<std::mutex> lock(processing_mutex, std::defer_lock);
+  if (scheduler == nullptr) {
+    lock.lock();
+  }
+  auto lock_for_run = [&]() {
+    std::unique_lock<std::mutex> run_lock(processing_mutex, std::defer_lock);
+    if (scheduler != nullptr) {
+      run_lock.lock();
+    }
+    return run_lock;
+  };
 
   std::vector<int> result_tokens;
 
@@ -1246,8 +1641,10 @@ int MoonshineStreamingModel::decode_full(MoonshineStreamingState *state,
   };
 
   // Helper to run decoder (requires cross_kv path)
-  auto run_decoder = [this, state](const std::vector<int64_t> &tokens,
-                                   std::vector<float> &logits) -> int {
+  auto run_decoder = [this, state, &lock_for_run](
+                         const std::vector<int64_t> &tokens,
+                         std::vector<float> &logits) -> int {
+    std::unique_lock<std::mutex> run_lock = lock_for_run();
     if (!state->cross_kv_valid) {
       int err = compute_cross_kv(state);
       if (err != 0) {
@@ -1255,11 +1652,15 @@ int MoonshineStreamingModel::decode_full(MoonshineStreamingState *state,
         return err;
       }
     }
-    return run_decoder_with_cross_kv(state, tokens, logits);
+    // Callers keep ``logits`` across steps, so after the first step of a
+    // given length this is no allocation at all.
+    logits.resize(tokens.size() * config.vocab_size);
+    return run_decoder_with_cross_kv(state, tokens, logits.data());
   };
 
   // Compute cross K/V upfront
   if (!state->cross_kv_valid) {
+    std::unique_lock<std::mutex> run_lock = lock_for_run();
     int err = compute_cross_kv(state);
     if (err != 0) {
       LOG("Failed to compute cross K/V\n");
@@ -1279,8 +1680,15 @@ int MoonshineStreamingModel::decode_full(MoonshineStreamingState *state,
         biaser->advance(current_token);
       }
 
-      std::vector<int64_t> next_input = {static_cast<int64_t>(current_token)};
-      int err = run_decoder(next_input, logits);
+      int err = 0;
+      if (scheduler != nullptr) {
+        logits.resize(config.vocab_size);
+        err = scheduler->decode_step(state, current_token, logits.data());
+      } else {
+        std::vector<int64_t> next_input = {
+            static_cast<int64_t>(current_token)};
+        err = run_decoder(next_input, logits);
+      }
       if (err != 0) break;
 
       current_token = biased_argmax(logits.data());
@@ -14,6 +14,8 @@
 #include "onnxruntime_c_api.h"
 #include "word-alignment.h"
 
+class MoonshineStreamingDecodeScheduler;
+
 /* Streaming model configuration (matches streaming_config.json) */
 struct MoonshineStreamingConfig {
   int encoder_dim;      /* Encoder hidden dimension (320) */
@@ -55,13 +57,21 @@ struct MoonshineStreamingState {
   std::vector<float> memory;  // [T, decoder_dim]
   int memory_len;
 
-  // Decoder self-attention KV cache
+  // Decoder self-attention KV cache. Only the first cache_seq_len positions
+  // are meaningful. The *_next buffers are where the decoder writes the
+  // grown cache; each step swaps them with k_self/v_self, and all four
+  // reserve room for max_seq_len up front, so no step copies or reallocates.
   std::vector<float> k_self;
   std::vector<float> v_self;
+  std::vector<float> k_self_next;
+  std::vector<float> v_self_next;
   int cache_seq_len;
 
   // Cross-attention KV cache (precomputed from memory)
-  // Used with decoder_kv.onnx for more efficient decoding
+  // Used with decoder_kv.onnx for more efficient decoding. With an export
+  // that supports it, new memory frames are appended rather than the whole
+  // cache recomputed; cross_len is then the number of frames covered, and
+  // cross_kv_valid means it has caught up with memory_len.
   std::vector<float> k_cross;
   std::vector<float> v_cross;
   int cross_len;
@@ -70,6 +80,49 @@ struct MoonshineStreamingState {
   void reset(const MoonshineStreamingConfig &cfg);
 };
 
+/* Padded decoder_kv inputs for one single-token step over several states,
+ * as MoonshineStreamingModel::decode_step_batch runs them. Self caches are
+ * aligned to the right edge of the longest one, so every row's new token
+ * lands at the same index; cross K/V rows start at zero and are padded on
+ * the right. The masks mark the real entries. Kept between steps so steady
+ * batches don't reallocate. */
+struct MoonshineDecoderBatch {
+  int64_t batch_size = 0;
+  int64_t cache_len = 0;  // longest self cache among the rows
+  int64_t cross_len = 0;  // most cross K/V frames among the rows
+
+  std::vector<int64_t> tokens;        // [B, 1]
+  std::vector<int64_t> position_ids;  // [B, 1]
+  std::vector<float> k_self;          // [depth, B, nheads, cache_len, head_dim]
+  std::vector<float> v_self;
+  std::vector<float> k_cross;  // [depth, B, nheads, cross_len, head_dim]
+  std::vector<float> v_cross;
+  std::vector<int64_t> self_mask;   // [B, cache_len]
+  std::vector<int64_t> cross_mask;  // [B, cross_len]
+
+  void pack(const MoonshineStreamingConfig &cfg,
+            const MoonshineStreamingState *const *states, const int *row_tokens,
+            int rows);
+
+  /* Hands each row the valid tail of its grown self cache from the decoder's
+   * out_k_self/out_v_self, laid out [depth, B, nheads, cache_len + 1,
+   * head_dim], and advances its cache_seq_len. ``states`` must be the rows
+   * passed to pack(). */
+  void unpack_self_kv(const MoonshineStreamingConfig &cfg,
+                      MoonshineStreamingState *const *states,
+                      const float *k_out, const float *v_out) const;
+};
+
+/* Grows a [depth, 1, nheads, old_len, head_dim] cross K/V buffer in place to
+ * hold ``new_len`` more frames per head, copied from ``src`` which is laid
+ * out [depth, 1, nheads, new_len, head_dim]. Heads are moved back to front,
+ * so no head is overwritten before it has moved. Capacity grows with
+ * headroom, so most appends over a segment only move memory without
+ * reallocating. */
+void append_cross_kv(std::vector<float> &buffer, const float *src,
+                     size_t head_count, size_t head_dim, size_t old_len,
+                     size_t new_len);
+
 struct MoonshineStreamingModel {
   const OrtApi *ort_api;
   OrtEnv *ort_env;
@@ -152,6 +205,22 @@ struct MoonshineStreamingModel {
   /* Single-token decode step (auto-regressive) */
   int decode_step(MoonshineStreamingState *state, int token, float *logits_out);
 
+  /* Runs one decode step for several independent states in a single
+   * decoder_kv pass. Row b feeds tokens[b] to states[b] and writes
+   * config.vocab_size logits to logits_out[b]. Self-attention caches of
+   * different lengths are left-padded and cross K/V right-padded to a common
+   * size, with attention masks hiding the padding. Needs a decoder exported
+   * with the batching inputs (position_ids and the two masks); with any other
+   * decoder, or one that also emits cross attentions for word timestamps, the
+   * rows run one after another through decode_step. Returns 0 on success. */
+  int decode_step_batch(MoonshineStreamingState *const *states,
+                        const int *tokens, float *const *logits_out,
+                        int batch_size);
+
+  /* True if decoder_kv_session accepts the batching inputs that
+   * decode_step_batch needs to combine rows into one run. */
+  bool decoder_supports_batch();
+
   /* Multi-token decode step - processes multiple tokens at once, returns logits
    * for each position. Useful for speculative decoding verification. logits_out
    * must have space for (tokens_len * config.vocab_size) floats. Returns logits
@@ -170,10 +239,14 @@ struct MoonshineStreamingModel {
    * reject the biased draft from the previous pass and then re-decode without
    * the bias, losing the biasing entirely on streaming updates. The biaser's
    * walk state is reset and advanced by this call.
+   * When ``scheduler`` is non-null, the single-token steps after the draft
+   * go through it so they can share decoder runs with other streams, and the
+   * model is only locked around the multi-token runs.
    * Returns 0 on success. */
   int decode_full(MoonshineStreamingState *state, const int *speculative_tokens,
                   int speculative_len, int **tokens_out, int *tokens_len_out,
-                  ContextBiaser *biaser = nullptr);
+                  ContextBiaser *biaser = nullptr,
+                  MoonshineStreamingDecodeScheduler *scheduler = nullptr);
 
   void decoder_reset(MoonshineStreamingState *state);
 
@@ -191,13 +264,51 @@ struct MoonshineStreamingModel {
  private:
   int load_config(const char *config_path);
 
-  /* Internal helper that uses precomputed cross K/V */
+  /* Internal helper that uses precomputed cross K/V. logits_out must have
+   * room for tokens.size() * config.vocab_size floats; the decoder writes
+   * them there directly. Caller holds processing_mutex. */
   int run_decoder_with_cross_kv(MoonshineStreamingState *state,
                                 const std::vector<int64_t> &tokens,
-                                std::vector<float> &logits_out);
+                                float *logits_out);
+
+  /* Appends one layer's cross-attention weights for the current step to
+   * cross_attention_buffer. */
+  int collect_cross_attention(OrtValue *attention, int cross_len);
 
   /* Compute cross-attention K/V from current memory state */
   int compute_cross_kv(MoonshineStreamingState *state);
+
+  /* Batched counterpart of run_decoder_with_cross_kv for one token per row.
+   * Caller holds processing_mutex. */
+  int run_batched_decoder_step(MoonshineStreamingState *const *states,
+                               const int *tokens, float *const *logits_out,
+                               int batch_size);
+
+  /* Refreshes the decoder_io_* fields below if decoder_kv_session has changed
+   * since they were last read. Caller holds processing_mutex. */
+  int inspect_decoder_io();
+
+  /* Same for cross_kv_io_frame_offset. Caller holds processing_mutex. */
+  int inspect_cross_kv_io();
+
+  // Whether cross_kv_session takes a frame_offset input, which marks an
+  // export that can project just the memory frames added since the last
+  // call.
+  const OrtSession *cross_kv_io_session = nullptr;
+  bool cross_kv_io_frame_offset = false;
+
+  // Input/output layout of decoder_kv_session. Read lazily, keyed on the
+  // session, because the transcriber swaps in the word-timestamp decoder
+  // after load.
+  const OrtSession *decoder_io_session = nullptr;
+  bool decoder_io_batch_inputs = false;
+  std::vector<std::string> decoder_io_attention_names;
+  // Reused by every run_decoder_with_cross_kv call, which binds the caller's
+  // logits buffer and the state's self-KV buffers to it.
+  OrtIoBinding *decoder_io_binding = nullptr;
+
+  // Inputs for run_batched_decoder_step. Guarded by processing_mutex.
+  MoonshineDecoderBatch decoder_batch;
 };
 
 #endif
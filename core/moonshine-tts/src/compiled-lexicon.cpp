@@ -0,0 +1,449 @@
+#include "compiled-lexicon.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace moonshine_tts {
+
+namespace {
+
+constexpr size_t kHeaderBytes = 40;
+constexpr size_t kKeyRowBytes = 16;
+constexpr size_t kSlotBytes = 4;
+constexpr size_t kAltRowBytes = 8;
+
+void set_u32(std::string& out, size_t at, uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    out[at + i] = static_cast<char>((v >> (8 * i)) & 0xFFu);
+  }
+}
+
+void set_u64(std::string& out, size_t at, uint64_t v) {
+  for (int i = 0; i < 8; ++i) {
+    out[at + i] = static_cast<char>((v >> (8 * i)) & 0xFFu);
+  }
+}
+
+uint32_t get_u32(const char* p) {
+  uint32_t v = 0;
+  for (int i = 3; i >= 0; --i) {
+    v = (v << 8) | static_cast<unsigned char>(p[i]);
+  }
+  return v;
+}
+
+uint64_t get_u64(const char* p) {
+  uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) {
+    v = (v << 8) | static_cast<unsigned char>(p[i]);
+  }
+  return v;
+}
+
+/// FNV-1a, so the index (and the source hash) is the same whichever platform
+/// built the file.
+uint64_t key_hash(std::string_view key) {
+  uint64_t h = 14695981039346656037ull;
+  for (const char c : key) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+uint32_t checked_u32(size_t v, const char* what) {
+  if (v > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error(std::string("CompiledLexicon: too many ") + what);
+  }
+  return static_cast<uint32_t>(v);
+}
+
+std::string read_file_bytes(const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("CompiledLexicon: cannot open " + path.string());
+  }
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+bool file_has_magic(const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::array<char, CompiledLexicon::kMagic.size()> head{};
+  if (!in.read(head.data(), static_cast<std::streamsize>(head.size()))) {
+    return false;
+  }
+  return CompiledLexicon::has_magic(std::string_view(head.data(), head.size()));
+}
+
+}  // namespace
+
+std::string_view CompiledLexicon::Alternatives::operator[](size_t i) const {
+  if (i >= count_) {
+    throw std::out_of_range("CompiledLexicon: alternative index out of range");
+  }
+  const char* row = lexicon_->base() + lexicon_->alts_offset_ +
+                    (static_cast<size_t>(first_) + i) * kAltRowBytes;
+  return lexicon_->blob_string(get_u32(row), get_u32(row + 4));
+}
+
+std::vector<std::string> CompiledLexicon::Alternatives::to_strings() const {
+  std::vector<std::string> out;
+  out.reserve(count_);
+  for (size_t i = 0; i < count_; ++i) {
+    out.emplace_back((*this)[i]);
+  }
+  return out;
+}
+
+CompiledLexicon::~CompiledLexicon() { release(); }
+
+CompiledLexicon::CompiledLexicon(CompiledLexicon&& other) noexcept {
+  *this = std::move(other);
+}
+
+CompiledLexicon& CompiledLexicon::operator=(CompiledLexicon&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  release();
+  mapping_ = std::exchange(other.mapping_, nullptr);
+  mapping_size_ = std::exchange(other.mapping_size_, 0);
+  owned_ = std::move(other.owned_);
+  other.owned_.clear();
+  kind_ = std::exchange(other.kind_, 0);
+  key_count_ = std::exchange(other.key_count_, 0);
+  alt_count_ = std::exchange(other.alt_count_, 0);
+  slot_count_ = std::exchange(other.slot_count_, 0);
+  source_ = std::exchange(other.source_, Source{});
+  slots_offset_ = std::exchange(other.slots_offset_, 0);
+  alts_offset_ = std::exchange(other.alts_offset_, 0);
+  blob_offset_ = std::exchange(other.blob_offset_, 0);
+  blob_size_ = std::exchange(other.blob_size_, 0);
+  return *this;
+}
+
+void CompiledLexicon::release() {
+#ifndef _WIN32
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+#endif
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+}
+
+std::string CompiledLexicon::serialize(const std::vector<Entry>& entries,
+                                       uint32_t kind,
+                                       const Source& source) {
+  const uint32_t key_count = checked_u32(entries.size(), "keys");
+  size_t alt_count = 0;
+  size_t blob_bytes = 0;
+  for (const auto& [key, ipas] : entries) {
+    alt_count += ipas.size();
+    blob_bytes += key.size();
+    for (const std::string& ipa : ipas) {
+      blob_bytes += ipa.size();
+    }
+  }
+  checked_u32(alt_count, "alternatives");
+  checked_u32(blob_bytes, "string bytes");
+  // Load factor at most one half keeps probe sequences short.
+  size_t slot_count = 1;
+  while (slot_count < 2 * entries.size()) {
+    slot_count *= 2;
+  }
+  checked_u32(slot_count, "keys");
+
+  const size_t slots_offset = kHeaderBytes + entries.size() * kKeyRowBytes;
+  const size_t alts_offset = slots_offset + slot_count * kSlotBytes;
+  const size_t blob_offset = alts_offset + alt_count * kAltRowBytes;
+  std::string out(blob_offset + blob_bytes, '\0');
+  out.replace(0, kMagic.size(), kMagic);
+  set_u32(out, 8, kind);
+  set_u32(out, 12, key_count);
+  set_u32(out, 16, static_cast<uint32_t>(alt_count));
+  set_u32(out, 20, static_cast<uint32_t>(slot_count));
+  set_u64(out, 24, source.bytes);
+  set_u64(out, 32, source.content_hash);
+
+  const auto put_string = [&](std::string_view str, size_t& blob_used) {
+    out.replace(blob_offset + blob_used, str.size(), str);
+    blob_used += str.size();
+  };
+  size_t blob_used = 0;
+  uint32_t next_alt = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const auto& [key, ipas] = entries[i];
+    const size_t row = kHeaderBytes + i * kKeyRowBytes;
+    set_u32(out, row, static_cast<uint32_t>(blob_used));
+    set_u32(out, row + 4, static_cast<uint32_t>(key.size()));
+    set_u32(out, row + 8, next_alt);
+    set_u32(out, row + 12, static_cast<uint32_t>(ipas.size()));
+    put_string(key, blob_used);
+    for (const std::string& ipa : ipas) {
+      const size_t alt_row = alts_offset + size_t{next_alt} * kAltRowBytes;
+      set_u32(out, alt_row, static_cast<uint32_t>(blob_used));
+      set_u32(out, alt_row + 4, static_cast<uint32_t>(ipa.size()));
+      put_string(ipa, blob_used);
+      ++next_alt;
+    }
+
+    size_t slot = key_hash(key) & (slot_count - 1);
+    while (true) {
+      const size_t at = slots_offset + slot * kSlotBytes;
+      const uint32_t other = get_u32(out.data() + at);
+      if (other == 0) {
+        set_u32(out, at, static_cast<uint32_t>(i + 1));
+        break;
+      }
+      if (entries[other - 1].first == key) {
+        throw std::runtime_error("CompiledLexicon: duplicate key " + key);
+      }
+      slot = (slot + 1) & (slot_count - 1);
+    }
+  }
+  return out;
+}
+
+void CompiledLexicon::write_file(const std::filesystem::path& path,
+                                 std::vector<Entry> entries, uint32_t kind,
+                                 const Source& source) {
+  // Sorted so that the same lexicon always compiles to the same bytes.
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.first < b.first; });
+  const std::string bytes = serialize(entries, kind, source);
+  std::filesystem::path tmp = path;
+  tmp += ".tmp" + std::to_string(std::random_device{}());
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::runtime_error("CompiledLexicon: cannot write " +
+                               tmp.string());
+    }
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+      throw std::runtime_error("CompiledLexicon: failed writing " +
+                               tmp.string());
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    throw std::runtime_error("CompiledLexicon: cannot replace " +
+                             path.string());
+  }
+}
+
+#ifdef _WIN32
+// No memory mapping on Windows: the file is read into one heap buffer, which
+// still skips parsing.
+CompiledLexicon CompiledLexicon::map_file(const std::filesystem::path& path,
+                                          uint32_t kind) {
+  return from_bytes(read_file_bytes(path), kind);
+}
+#else
+CompiledLexicon CompiledLexicon::map_file(const std::filesystem::path& path,
+                                          uint32_t kind) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    throw std::runtime_error("CompiledLexicon: cannot open " + path.string());
+  }
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size <= 0) {
+    ::close(fd);
+    throw std::runtime_error("CompiledLexicon: cannot size " + path.string());
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error("CompiledLexicon: cannot map " + path.string());
+  }
+  CompiledLexicon lex;
+  lex.mapping_ = mapped;
+  lex.mapping_size_ = size;
+  lex.index(kind);
+  return lex;
+}
+#endif
+
+CompiledLexicon CompiledLexicon::from_bytes(std::string bytes, uint32_t kind) {
+  CompiledLexicon lex;
+  lex.owned_ = std::move(bytes);
+  lex.index(kind);
+  return lex;
+}
+
+CompiledLexicon CompiledLexicon::open(const std::filesystem::path& path,
+                                      uint32_t kind, const TsvParser& parse) {
+  std::error_code ec;
+  const std::filesystem::path sibling = compiled_sibling_path(path);
+  if (!std::filesystem::is_regular_file(path, ec) && sibling != path &&
+      std::filesystem::is_regular_file(sibling, ec)) {
+    return map_file(sibling, kind);
+  }
+  if (file_has_magic(path)) {
+    return map_file(path, kind);
+  }
+  // Reading the TSV costs far less than parsing it, and the hash catches any
+  // edit, including one that keeps the size.
+  const std::string contents = read_file_bytes(path);
+  const Source source = describe_source(contents);
+  if (sibling != path && std::filesystem::is_regular_file(sibling, ec) &&
+      file_has_magic(sibling)) {
+    // A sibling compiled from another version of the TSV (or for another
+    // loader) is ignored rather than trusted.
+    try {
+      CompiledLexicon lex = map_file(sibling, kind);
+      if (lex.source() == source) {
+        return lex;
+      }
+    } catch (const std::runtime_error&) {
+    }
+  }
+  std::istringstream in(contents);
+  return from_bytes(serialize(parse(in), kind, source), kind);
+}
+
+bool CompiledLexicon::can_open(const std::filesystem::path& path) {
+  std::error_code ec;
+  return std::filesystem::is_regular_file(path, ec) ||
+         std::filesystem::is_regular_file(compiled_sibling_path(path), ec);
+}
+
+CompiledLexicon CompiledLexicon::open_bytes(std::string_view bytes,
+                                            uint32_t kind,
+                                            const TsvParser& parse) {
+  if (has_magic(bytes)) {
+    return from_bytes(std::string(bytes), kind);
+  }
+  std::istringstream in{std::string(bytes)};
+  return from_bytes(serialize(parse(in), kind, describe_source(bytes)), kind);
+}
+
+CompiledLexicon::Source CompiledLexicon::describe_source(
+    std::string_view contents) {
+  return Source{contents.size(), key_hash(contents)};
+}
+
+bool CompiledLexicon::has_magic(std::string_view bytes) {
+  return bytes.substr(0, kMagic.size()) == kMagic;
+}
+
+std::filesystem::path CompiledLexicon::compiled_sibling_path(
+    const std::filesystem::path& tsv_path) {
+  std::filesystem::path p = tsv_path;
+  p.replace_extension(kFileExtension);
+  return p;
+}
+
+const char* CompiledLexicon::base() const {
+  return mapping_ != nullptr ? static_cast<const char*>(mapping_)
+                             : owned_.data();
+}
+
+void CompiledLexicon::index(uint32_t kind) {
+  const size_t size = mapping_ != nullptr ? mapping_size_ : owned_.size();
+  const char* p = base();
+  if (size < kHeaderBytes || !has_magic(std::string_view(p, size))) {
+    throw std::runtime_error("CompiledLexicon: not a compiled lexicon");
+  }
+  if (get_u32(p + 8) != kind) {
+    throw std::runtime_error(
+        "CompiledLexicon: built as kind " + std::to_string(get_u32(p + 8)) +
+        ", expected " + std::to_string(kind));
+  }
+  kind_ = kind;
+  key_count_ = get_u32(p + 12);
+  alt_count_ = get_u32(p + 16);
+  slot_count_ = get_u32(p + 20);
+  source_.bytes = get_u64(p + 24);
+  source_.content_hash = get_u64(p + 32);
+  if (slot_count_ == 0 || (slot_count_ & (slot_count_ - 1)) != 0 ||
+      slot_count_ < uint64_t{key_count_} + 1) {
+    throw std::runtime_error("CompiledLexicon: bad hash index size");
+  }
+  const uint64_t slots_offset =
+      kHeaderBytes + uint64_t{key_count_} * kKeyRowBytes;
+  const uint64_t alts_offset =
+      slots_offset + uint64_t{slot_count_} * kSlotBytes;
+  const uint64_t blob_offset =
+      alts_offset + uint64_t{alt_count_} * kAltRowBytes;
+  if (blob_offset > size) {
+    throw std::runtime_error("CompiledLexicon: truncated tables");
+  }
+  slots_offset_ = static_cast<size_t>(slots_offset);
+  alts_offset_ = static_cast<size_t>(alts_offset);
+  blob_offset_ = static_cast<size_t>(blob_offset);
+  blob_size_ = size - blob_offset_;
+}
+
+std::string_view CompiledLexicon::blob_string(uint32_t offset,
+                                              uint32_t length) const {
+  if (offset > blob_size_ || length > blob_size_ - offset) {
+    throw std::runtime_error("CompiledLexicon: string out of range");
+  }
+  return std::string_view(base() + blob_offset_ + offset, length);
+}
+
+std::string_view CompiledLexicon::key_at(size_t i) const {
+  if (i >= key_count_) {
+    throw std::out_of_range("CompiledLexicon: key index out of range");
+  }
+  const char* row = base() + kHeaderBytes + i * kKeyRowBytes;
+  return blob_string(get_u32(row), get_u32(row + 4));
+}
+
+CompiledLexicon::Alternatives CompiledLexicon::alternatives_at(
+    size_t i) const {
+  if (i >= key_count_) {
+    throw std::out_of_range("CompiledLexicon: key index out of range");
+  }
+  const char* row = base() + kHeaderBytes + i * kKeyRowBytes;
+  const uint32_t first = get_u32(row + 8);
+  const uint32_t count = get_u32(row + 12);
+  if (uint64_t{first} + count > alt_count_) {
+    throw std::runtime_error("CompiledLexicon: alternatives out of range");
+  }
+  return Alternatives(this, first, count);
+}
+
+CompiledLexicon::Alternatives CompiledLexicon::lookup(
+    std::string_view key) const {
+  if (key_count_ == 0) {
+    return {};
+  }
+  const char* slots = base() + slots_offset_;
+  const size_t mask = slot_count_ - 1;
+  // The index has more slots than keys, so an empty slot ends every probe.
+  size_t s = key_hash(key) & mask;
+  for (uint32_t probes = 0; probes < slot_count_; ++probes) {
+    const uint32_t row = get_u32(slots + s * kSlotBytes);
+    if (row == 0) {
+      break;
+    }
+    if (key_at(row - 1) == key) {
+      return alternatives_at(row - 1);
+    }
+    s = (s + 1) & mask;
+  }
+  return {};
+}
+
+}  // namespace moonshine_tts
@@ -0,0 +1,168 @@
+#ifndef MOONSHINE_TTS_COMPILED_LEXICON_H
+#define MOONSHINE_TTS_COMPILED_LEXICON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace moonshine_tts {
+
+/// The TSV a compiled lexicon was built from, recorded in its header so a
+/// compiled sibling is only used while it still matches. Only the contents
+/// count: copying, installing or checking out the pair keeps it valid.
+struct CompiledLexiconSource {
+  uint64_t bytes = 0;
+  uint64_t content_hash = 0;
+
+  bool operator==(const CompiledLexiconSource&) const = default;
+};
+
+/// Read-only word -> pronunciation alternatives table, stored in one flat
+/// buffer and queried in place. A compiled lexicon file (``.mlex``) is
+/// memory-mapped on POSIX, so every process that opens it shares the same
+/// page-cache pages and startup does no parsing; TSV lexicons are packed into
+/// the same layout in memory after parsing, so lookups never depend on where
+/// the table came from.
+///
+/// File layout (all integers little-endian):
+///
+///   0   char[8]  magic ``MNSLEX03``
+///   8   u32      kind (which loader's key and merge rules built it)
+///   12  u32      key count K
+///   16  u32      alternative count A
+///   20  u32      hash slot count S (a power of two, at least 2K)
+///   24  u64      size in bytes of the source TSV (0 when unknown)
+///   32  u64      FNV-1a hash of the source TSV's bytes (0 when unknown)
+///   40  K x {u32 key offset, u32 key length, u32 first alternative,
+///            u32 alternative count}
+///   ..  S x u32  open-addressing index: key row + 1, or 0 for an empty slot;
+///                a key starts probing at FNV-1a(key) mod S
+///   ..  A x {u32 offset, u32 length}
+///   ..  string blob that all offsets point into
+///
+/// Keys are compared as raw bytes, so the builder and the lookup only need to
+/// agree on the normalization applied before the key is stored.
+class CompiledLexicon {
+ public:
+  using Entry = std::pair<std::string, std::vector<std::string>>;
+  using TsvParser = std::function<std::vector<Entry>(std::istream&)>;
+
+  static constexpr std::string_view kMagic{"MNSLEX03"};
+  static constexpr std::string_view kFileExtension{".mlex"};
+
+  /// View of one word's alternatives; valid while the lexicon is alive.
+  class Alternatives {
+   public:
+    Alternatives() = default;
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    std::string_view operator[](size_t i) const;
+    std::vector<std::string> to_strings() const;
+
+   private:
+    friend class CompiledLexicon;
+    Alternatives(const CompiledLexicon* lexicon, uint32_t first,
+                 uint32_t count)
+        : lexicon_(lexicon), first_(first), count_(count) {}
+
+    const CompiledLexicon* lexicon_ = nullptr;
+    uint32_t first_ = 0;
+    uint32_t count_ = 0;
+  };
+
+  using Source = CompiledLexiconSource;
+
+  /// ``Source`` of a TSV whose bytes are ``contents``.
+  static Source describe_source(std::string_view contents);
+
+  /// Empty lexicon: every lookup misses.
+  CompiledLexicon() = default;
+  ~CompiledLexicon();
+
+  CompiledLexicon(const CompiledLexicon&) = delete;
+  CompiledLexicon& operator=(const CompiledLexicon&) = delete;
+  CompiledLexicon(CompiledLexicon&& other) noexcept;
+  CompiledLexicon& operator=(CompiledLexicon&& other) noexcept;
+
+  /// Packs ``entries`` (keys must be unique) into the file layout above,
+  /// keeping their order.
+  static std::string serialize(const std::vector<Entry>& entries,
+                               uint32_t kind, const Source& source = {});
+  /// Sorts ``entries`` by key, so equal lexicons give identical files, then
+  /// ``serialize``s and writes atomically (temporary file, then rename).
+  static void write_file(const std::filesystem::path& path,
+                         std::vector<Entry> entries, uint32_t kind,
+                         const Source& source = {});
+
+  /// Memory-maps a compiled lexicon file (reads it on platforms without
+  /// ``mmap``). Throws when the file is not a compiled lexicon of ``kind``.
+  static CompiledLexicon map_file(const std::filesystem::path& path,
+                                  uint32_t kind);
+  /// Takes ownership of compiled lexicon bytes.
+  static CompiledLexicon from_bytes(std::string bytes, uint32_t kind);
+
+  /// Opens the lexicon at ``path``:
+  ///
+  ///   * a compiled lexicon is mapped without further checks;
+  ///   * a TSV path with no file but a compiled sibling (``path`` with
+  ///     ``kFileExtension``) maps the sibling, so a ``.mlex`` can ship alone;
+  ///   * a TSV is read and hashed, and its sibling is mapped when it was
+  ///     compiled (as ``kind``) from the same bytes. Otherwise the TSV is
+  ///     parsed with ``parse`` and packed in memory.
+  ///
+  /// Only the first two skip reading the TSV.
+  static CompiledLexicon open(const std::filesystem::path& path, uint32_t kind,
+                              const TsvParser& parse);
+  /// True when ``open`` has a file to load at ``path``: ``path`` itself or
+  /// its compiled sibling.
+  static bool can_open(const std::filesystem::path& path);
+  /// Same as ``open`` for an in-memory asset: compiled bytes or TSV text.
+  static CompiledLexicon open_bytes(std::string_view bytes, uint32_t kind,
+                                    const TsvParser& parse);
+
+  static bool has_magic(std::string_view bytes);
+  static std::filesystem::path compiled_sibling_path(
+      const std::filesystem::path& tsv_path);
+
+  size_t size() const { return key_count_; }
+  bool empty() const { return key_count_ == 0; }
+  uint32_t kind() const { return kind_; }
+  const Source& source() const { return source_; }
+  /// True when the table is a memory-mapped file rather than a heap buffer.
+  bool is_mapped() const { return mapping_ != nullptr; }
+
+  Alternatives lookup(std::string_view key) const;
+  std::string_view key_at(size_t i) const;
+  Alternatives alternatives_at(size_t i) const;
+
+ private:
+  const char* base() const;
+  /// Reads and checks the header of the buffer at ``base()``.
+  void index(uint32_t kind);
+  std::string_view blob_string(uint32_t offset, uint32_t length) const;
+  void release();
+
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  std::string owned_;
+  uint32_t kind_ = 0;
+  uint32_t key_count_ = 0;
+  uint32_t alt_count_ = 0;
+  uint32_t slot_count_ = 0;
+  Source source_{};
+  size_t slots_offset_ = 0;
+  size_t alts_offset_ = 0;
+  size_t blob_offset_ = 0;
+  size_t blob_size_ = 0;
+};
+
+}  // namespace moonshine_tts
+
+#endif  // MOONSHINE_TTS_COMPILED_LEXICON_H
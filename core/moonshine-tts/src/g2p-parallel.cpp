@@ -0,0 +1,125 @@
+#include "g2p-parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+#include "rule-based-g2p.h"
+#include "utf8-utils.h"
+
+namespace moonshine_tts {
+
+std::vector<std::string> texts_to_ipa_parallel(
+    const std::vector<RuleBasedG2p*>& engines,
+    const std::vector<std::string>& texts,
+    std::vector<std::vector<G2pWordLog>>* per_text_logs) {
+  if (engines.empty()) {
+    throw std::invalid_argument("texts_to_ipa_parallel: no engines");
+  }
+  std::vector<std::string> out(texts.size());
+  if (per_text_logs != nullptr) {
+    per_text_logs->assign(texts.size(), {});
+  }
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  auto work = [&](RuleBasedG2p* engine) {
+    try {
+      for (size_t i = next.fetch_add(1); i < texts.size() && !failed.load();
+           i = next.fetch_add(1)) {
+        out[i] = engine->text_to_ipa(
+            texts[i], per_text_logs != nullptr ? &(*per_text_logs)[i]
+                                               : nullptr);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      failed.store(true);
+    }
+  };
+
+  const size_t n_threads = std::min(engines.size(), texts.size());
+  std::vector<std::thread> threads;
+  if (n_threads > 1) {
+    threads.reserve(n_threads - 1);
+    for (size_t t = 1; t < n_threads; ++t) {
+      threads.emplace_back(work, engines[t]);
+    }
+  }
+  work(engines[0]);
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return out;
+}
+
+std::string join_sentence_ipa(const std::vector<std::string>& ipa) {
+  std::string out;
+  for (const std::string& s : ipa) {
+    if (s.empty()) {
+      continue;
+    }
+    if (!out.empty()) {
+      out.push_back(' ');
+    }
+    out += s;
+  }
+  return out;
+}
+
+size_t count_lines(std::string_view text) {
+  size_t lines = static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+  if (!text.empty() && text.back() != '\n') {
+    ++lines;
+  }
+  return lines;
+}
+
+void report_rate(std::ostream& err, size_t lines, size_t threads,
+                 std::chrono::steady_clock::time_point start) {
+  const double sec = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  err << lines << " lines in " << sec << " s ("
+      << (sec > 0.0 ? static_cast<double>(lines) / sec : 0.0) << " lines/s, "
+      << threads << " threads)\n";
+}
+
+void convert_lines_parallel(const std::vector<RuleBasedG2p*>& engines,
+                            std::istream& in, std::ostream& out,
+                            std::ostream& err) {
+  std::vector<std::string> lines;
+  std::vector<std::string> texts;
+  std::string line;
+  while (std::getline(in, line)) {
+    lines.push_back(trim_ascii_ws_copy(line));
+    if (!lines.back().empty()) {
+      texts.push_back(lines.back());
+    }
+  }
+  const auto start = std::chrono::steady_clock::now();
+  const std::vector<std::string> ipa = texts_to_ipa_parallel(engines, texts);
+  report_rate(err, lines.size(), engines.size(), start);
+  size_t next = 0;
+  for (const std::string& l : lines) {
+    if (!l.empty()) {
+      out << ipa[next++];
+    }
+    out << '\n';
+  }
+}
+
+}  // namespace moonshine_tts
@@ -0,0 +1,51 @@
+#ifndef MOONSHINE_TTS_G2P_PARALLEL_H
+#define MOONSHINE_TTS_G2P_PARALLEL_H
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "g2p-word-log.h"
+
+namespace moonshine_tts {
+
+class RuleBasedG2p;
+
+/// Converts every entry of ``texts`` to IPA with ``engines``, one thread per
+/// engine (the first on the calling thread). Engines are not thread-safe, so
+/// each is used by exactly one thread; threads take the next unconverted text
+/// until none are left, and results come back in input order however the
+/// work was scheduled. When ``per_text_logs`` is set it receives one word log
+/// per text. If any conversion throws, the remaining texts are skipped and
+/// the first exception is rethrown once every thread has stopped.
+std::vector<std::string> texts_to_ipa_parallel(
+    const std::vector<RuleBasedG2p*>& engines,
+    const std::vector<std::string>& texts,
+    std::vector<std::vector<G2pWordLog>>* per_text_logs = nullptr);
+
+/// Joins the non-empty entries of ``ipa`` with single spaces, which is how
+/// ``MoonshineG2P`` stitches sentences converted separately back together.
+std::string join_sentence_ipa(const std::vector<std::string>& ipa);
+
+/// Number of lines in ``text``, counting a last line without a newline.
+size_t count_lines(std::string_view text);
+
+/// Writes "N lines in S s (R lines/s, T threads)" to ``err``, timing from
+/// ``start``. The batch G2P tools report throughput this way.
+void report_rate(std::ostream& err, size_t lines, size_t threads,
+                 std::chrono::steady_clock::time_point start);
+
+/// Line mode of the batch G2P tools on several engines: reads all of ``in``,
+/// converts its trimmed non-empty lines with ``texts_to_ipa_parallel`` and
+/// writes one line per input line to ``out`` in input order (an empty line
+/// for a blank one), then reports the rate to ``err``.
+void convert_lines_parallel(const std::vector<RuleBasedG2p*>& engines,
+                            std::istream& in, std::ostream& out,
+                            std::ostream& err);
+
+}  // namespace moonshine_tts
+
+#endif  // MOONSHINE_TTS_G2P_PARALLEL_H
@@ -0,0 +1,260 @@
+#include "g2p-pronunciation-cache.h"
+
+#include <fstream>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace moonshine_tts {
+
+namespace {
+
+/// List node, index node and string headers of one entry, on top of its
+/// key and IPA bytes.
+constexpr size_t kEntryOverheadBytes = 128;
+
+constexpr char kKeySeparator = '\x1f';
+constexpr std::string_view kFileMagic = "moonshine-g2p-pronunciation-cache ";
+/// Bumped when the key format changes. A file of another version is ignored
+/// and overwritten on the next save.
+constexpr std::string_view kFileVersion = "2";
+
+bool is_storable(std::string_view s) {
+  return s.find_first_of("\t\n\r") == std::string_view::npos;
+}
+
+std::string file_id(const std::filesystem::path& path) {
+  return path.lexically_normal().string();
+}
+
+}  // namespace
+
+G2pPronunciationCache::G2pPronunciationCache(size_t capacity_bytes)
+    : capacity_bytes_(capacity_bytes) {}
+
+G2pPronunciationCache::~G2pPronunciationCache() {
+  for (const std::string& path : persist_files_) {
+    try {
+      save_if_changed(path);
+    } catch (const std::exception&) {
+      // Nowhere to report it this late; the next run rebuilds the entries.
+    }
+  }
+}
+
+G2pPronunciationCache& G2pPronunciationCache::global() {
+  static G2pPronunciationCache cache(0);
+  return cache;
+}
+
+std::string G2pPronunciationCache::make_key(uint64_t scope, char context,
+                                            std::string_view token) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  std::string key;
+  key.reserve(16 + token.size() + 3);
+  for (int shift = 60; shift >= 0; shift -= 4) {
+    key += kHex[(scope >> shift) & 0xf];
+  }
+  key += kKeySeparator;
+  key += context;
+  key += kKeySeparator;
+  key.append(token);
+  return key;
+}
+
+G2pPronunciationCache::Shard& G2pPronunciationCache::shard_for(
+    std::string_view key) {
+  return shards_[std::hash<std::string_view>{}(key) % kShards];
+}
+
+std::optional<G2pCachedPronunciation> G2pPronunciationCache::get(
+    const std::string& key) {
+  if (capacity_bytes() == 0) {
+    return std::nullopt;
+  }
+  Shard& shard = shard_for(key);
+  std::lock_guard<std::mutex> lock(shard.mu);
+  const auto it = shard.index.find(std::string_view(key));
+  if (it == shard.index.end()) {
+    ++misses_;
+    return std::nullopt;
+  }
+  shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+  ++hits_;
+  return it->second->value;
+}
+
+void G2pPronunciationCache::put(const std::string& key,
+                                G2pCachedPronunciation value) {
+  const size_t cap = capacity_bytes() / kShards;
+  const size_t bytes = key.size() + value.ipa.size() + kEntryOverheadBytes;
+  if (bytes > cap) {
+    return;
+  }
+  Shard& shard = shard_for(key);
+  std::lock_guard<std::mutex> lock(shard.mu);
+  const auto it = shard.index.find(std::string_view(key));
+  if (it != shard.index.end()) {
+    Entry& entry = *it->second;
+    shard.bytes -= entry.bytes;
+    entry.value = std::move(value);
+    entry.bytes = bytes;
+    shard.bytes += bytes;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+  } else {
+    shard.lru.push_front(Entry{key, std::move(value), bytes});
+    shard.index.emplace(std::string_view(shard.lru.front().key),
+                        shard.lru.begin());
+    shard.bytes += bytes;
+  }
+  ++generation_;
+  evict_over(shard, cap);
+}
+
+void G2pPronunciationCache::evict_over(Shard& shard, size_t cap) {
+  while (shard.bytes > cap && !shard.lru.empty()) {
+    const Entry& oldest = shard.lru.back();
+    shard.bytes -= oldest.bytes;
+    shard.index.erase(std::string_view(oldest.key));
+    shard.lru.pop_back();
+    ++evictions_;
+  }
+}
+
+void G2pPronunciationCache::reserve_capacity(size_t bytes) {
+  size_t current = capacity_bytes_.load();
+  while (current < bytes &&
+         !capacity_bytes_.compare_exchange_weak(current, bytes)) {
+  }
+}
+
+void G2pPronunciationCache::clear() {
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mu);
+    shard.index.clear();
+    shard.lru.clear();
+    shard.bytes = 0;
+  }
+  ++generation_;
+}
+
+G2pPronunciationCacheStats G2pPronunciationCache::stats() const {
+  G2pPronunciationCacheStats s;
+  s.hits = hits_.load();
+  s.misses = misses_.load();
+  s.evictions = evictions_.load();
+  s.capacity_bytes = capacity_bytes();
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mu);
+    s.entries += shard.lru.size();
+    s.bytes += shard.bytes;
+  }
+  return s;
+}
+
+void G2pPronunciationCache::save(const std::filesystem::path& path) const {
+  std::filesystem::path tmp = path;
+  tmp += ".tmp" + std::to_string(std::random_device{}());
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::runtime_error("G2pPronunciationCache: cannot write " +
+                               tmp.string());
+    }
+    out << kFileMagic << kFileVersion << '\n';
+    for (const Shard& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mu);
+      // Oldest first, so loading the file rebuilds the same recency order.
+      for (auto it = shard.lru.rbegin(); it != shard.lru.rend(); ++it) {
+        if (!is_storable(it->key) || !is_storable(it->value.ipa)) {
+          continue;
+        }
+        out << it->key << '\t' << static_cast<int>(it->value.path) << '\t'
+            << it->value.ipa << '\n';
+      }
+    }
+    if (!out) {
+      throw std::runtime_error("G2pPronunciationCache: failed writing " +
+                               tmp.string());
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    throw std::runtime_error("G2pPronunciationCache: cannot replace " +
+                             path.string());
+  }
+}
+
+bool G2pPronunciationCache::load(const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::string line;
+  if (!std::getline(in, line) || line.compare(0, kFileMagic.size(),
+                                              kFileMagic) != 0) {
+    throw std::runtime_error("G2pPronunciationCache: " + path.string() +
+                             " is not a pronunciation cache file");
+  }
+  if (std::string_view(line).substr(kFileMagic.size()) != kFileVersion) {
+    return false;
+  }
+  while (std::getline(in, line)) {
+    const size_t tab1 = line.find('\t');
+    const size_t tab2 =
+        tab1 == std::string::npos ? tab1 : line.find('\t', tab1 + 1);
+    if (tab2 == std::string::npos) {
+      continue;
+    }
+    G2pCachedPronunciation value;
+    try {
+      value.path = static_cast<G2pWordPath>(
+          std::stoi(line.substr(tab1 + 1, tab2 - tab1 - 1)));
+    } catch (const std::exception&) {
+      continue;
+    }
+    value.ipa = line.substr(tab2 + 1);
+    put(line.substr(0, tab1), std::move(value));
+  }
+  std::lock_guard<std::mutex> lock(files_mu_);
+  file_generations_[file_id(path)] = generation_.load();
+  return true;
+}
+
+bool G2pPronunciationCache::load_once(const std::filesystem::path& path) {
+  {
+    std::lock_guard<std::mutex> lock(files_mu_);
+    if (!loaded_files_.insert(file_id(path)).second) {
+      return false;
+    }
+  }
+  return load(path);
+}
+
+bool G2pPronunciationCache::save_if_changed(
+    const std::filesystem::path& path) {
+  const std::string id = file_id(path);
+  const uint64_t generation = generation_.load();
+  {
+    std::lock_guard<std::mutex> lock(files_mu_);
+    const auto it = file_generations_.find(id);
+    if (it != file_generations_.end() && it->second == generation) {
+      return false;
+    }
+  }
+  save(path);
+  std::lock_guard<std::mutex> lock(files_mu_);
+  file_generations_[id] = generation;
+  return true;
+}
+
+void G2pPronunciationCache::persist_to(const std::filesystem::path& path) {
+  std::lock_guard<std::mutex> lock(files_mu_);
+  persist_files_.insert(file_id(path));
+}
+
+}  // namespace moonshine_tts
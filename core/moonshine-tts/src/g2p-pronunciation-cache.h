@@ -0,0 +1,130 @@
+#ifndef MOONSHINE_TTS_G2P_PRONUNCIATION_CACHE_H
+#define MOONSHINE_TTS_G2P_PRONUNCIATION_CACHE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "g2p-word-log.h"
+
+namespace moonshine_tts {
+
+/// A word's pronunciation as a G2P engine produced it, and how.
+struct G2pCachedPronunciation {
+  std::string ipa;
+  G2pWordPath path = G2pWordPath::kRuleBasedG2p;
+};
+
+struct G2pPronunciationCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  size_t entries = 0;
+  size_t bytes = 0;
+  size_t capacity_bytes = 0;
+};
+
+/// Bounded, thread-safe word -> pronunciation cache, normally the single
+/// process-wide instance from ``global()`` shared by every ``MoonshineG2P``.
+///
+/// Keys come from ``make_key``: a 64-bit scope id hashed from the dialect and
+/// the options the engine's output depends on, a context tag, and the
+/// normalized token.
+/// Entries live in ``kShards`` independently locked LRU lists chosen by key
+/// hash, each capped at its share of ``capacity_bytes``, so concurrent
+/// synthesizers rarely wait on each other. A capacity of 0 disables it.
+class G2pPronunciationCache {
+ public:
+  static constexpr size_t kShards = 16;
+
+  /// Context tag for pronunciations that depend on the token alone. A
+  /// pronunciation chosen from surrounding words (heteronym resolution over a
+  /// ``heteronym-context`` window) must be cached under a tag that encodes
+  /// that window, or not at all.
+  static constexpr char kContextFree = '0';
+
+  explicit G2pPronunciationCache(size_t capacity_bytes);
+  /// Saves to every ``persist_to`` file whose entries changed since it was
+  /// last written; for ``global()`` this happens at process exit.
+  ~G2pPronunciationCache();
+
+  G2pPronunciationCache(const G2pPronunciationCache&) = delete;
+  G2pPronunciationCache& operator=(const G2pPronunciationCache&) = delete;
+
+  /// The process-wide cache; starts with a capacity of 0 until a
+  /// ``MoonshineG2P`` reserves some.
+  static G2pPronunciationCache& global();
+
+  static std::string make_key(uint64_t scope, char context,
+                              std::string_view token);
+
+  /// The cached pronunciation for ``key``, marking it most recently used.
+  std::optional<G2pCachedPronunciation> get(const std::string& key);
+  void put(const std::string& key, G2pCachedPronunciation value);
+
+  size_t capacity_bytes() const { return capacity_bytes_.load(); }
+  /// Raises the byte cap to at least ``bytes``. Never lowers it, since other
+  /// users of the cache may have asked for more.
+  void reserve_capacity(size_t bytes);
+  void clear();
+  G2pPronunciationCacheStats stats() const;
+
+  /// Writes every entry to ``path`` (through a temporary file and rename).
+  void save(const std::filesystem::path& path) const;
+  /// Adds the entries saved in ``path``. Returns false when the file does not
+  /// exist; throws ``std::runtime_error`` when it is not a cache file.
+  bool load(const std::filesystem::path& path);
+  /// ``load`` the first time ``path`` is passed in this process; later calls
+  /// return false without reading it again.
+  bool load_once(const std::filesystem::path& path);
+  /// ``save`` unless no entry was added or replaced since ``path`` was last
+  /// saved or loaded. Returns whether the file was written.
+  bool save_if_changed(const std::filesystem::path& path);
+  /// Registers ``path`` to be written by ``save_if_changed`` when the cache is
+  /// destroyed.
+  void persist_to(const std::filesystem::path& path);
+
+ private:
+  struct Entry {
+    std::string key;
+    G2pCachedPronunciation value;
+    size_t bytes = 0;
+  };
+  struct Shard {
+    mutable std::mutex mu;
+    std::list<Entry> lru;  // Most recently used first.
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    size_t bytes = 0;
+  };
+
+  Shard& shard_for(std::string_view key);
+  void evict_over(Shard& shard, size_t cap);
+
+  std::atomic<size_t> capacity_bytes_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> evictions_{0};
+  /// Bumped by every ``put`` and ``clear``, so a file knows whether it is
+  /// behind.
+  std::atomic<uint64_t> generation_{0};
+  std::array<Shard, kShards> shards_;
+  std::mutex files_mu_;
+  std::set<std::string> loaded_files_;
+  std::set<std::string> persist_files_;
+  /// ``generation_`` when each file was last saved or loaded.
+  std::map<std::string, uint64_t> file_generations_;
+};
+
+}  // namespace moonshine_tts
+
+#endif  // MOONSHINE_TTS_G2P_PRONUNCIATION_CACHE_H
@@ -655,6 +655,103 @@ std::u32string strip_arabic_diacritics_u32(const std::u32string& s) {
 
 }  // namespace ar_wp
 
+namespace {
+
+/// Keeps ``[CLS]``, the first ``max_sequence_length - 2`` tokens and
+/// ``[SEP]`` of an over-long encoding.
+void truncate_encoding(ar_wp::EncodedWp& enc, int max_sequence_length) {
+  if (static_cast<int>(enc.input_ids.size()) <= max_sequence_length) {
+    return;
+  }
+  const int keep = max_sequence_length - 2;
+  const int64_t cls_id = enc.input_ids.front();
+  const int64_t sep_id = enc.input_ids.back();
+  std::vector<int64_t> inner(enc.input_ids.begin() + 1,
+                             enc.input_ids.end() - 1);
+  if (static_cast<int>(inner.size()) > keep) {
+    inner.resize(static_cast<std::size_t>(keep));
+  }
+  std::vector<std::pair<int, int>> inner_off(enc.offsets_cp.begin() + 1,
+                                             enc.offsets_cp.end() - 1);
+  if (static_cast<int>(inner_off.size()) > keep) {
+    inner_off.resize(static_cast<std::size_t>(keep));
+  }
+  enc.input_ids.clear();
+  enc.input_ids.push_back(cls_id);
+  enc.input_ids.insert(enc.input_ids.end(), inner.begin(), inner.end());
+  enc.input_ids.push_back(sep_id);
+  enc.offsets_cp.clear();
+  enc.offsets_cp.push_back({0, 0});
+  enc.offsets_cp.insert(enc.offsets_cp.end(), inner_off.begin(),
+                        inner_off.end());
+  enc.offsets_cp.push_back({0, 0});
+}
+
+/// NFC text of ``enc`` with the harakāt its token logits predict.
+std::string apply_diacritics(
+    const ar_wp::EncodedWp& enc, const float* logits,
+    const std::vector<std::string>& id2label,
+    const std::unordered_map<std::string, std::string>& label_to_diac) {
+  const int64_t T = static_cast<int64_t>(enc.input_ids.size());
+  const int64_t num_labels = static_cast<int64_t>(id2label.size());
+  const std::u32string& ref = enc.ref_u32;
+  const auto& offs = enc.offsets_cp;
+  std::unordered_map<int, std::string> diac_after;
+
+  for (int64_t ti = 0; ti < T; ++ti) {
+    if (ti == 0 || ti == T - 1) {
+      continue;
+    }
+    int best = 0;
+    const std::size_t base =
+        static_cast<std::size_t>(ti) * static_cast<std::size_t>(num_labels);
+    float best_v = logits[base];
+    for (int64_t j = 1; j < num_labels; ++j) {
+      const float v = logits[base + static_cast<std::size_t>(j)];
+      if (v > best_v) {
+        best_v = v;
+        best = static_cast<int>(j);
+      }
+    }
+    const std::string& lab = id2label[static_cast<std::size_t>(best)];
+    if (lab == "X") {
+      continue;
+    }
+    const auto it = label_to_diac.find(lab);
+    if (it == label_to_diac.end() || it->second.empty()) {
+      continue;
+    }
+    const int s = offs[static_cast<std::size_t>(ti)].first;
+    const int e = offs[static_cast<std::size_t>(ti)].second;
+    const auto aj = ar_wp::anchor_index_for_span(ref, s, e);
+    if (!aj.has_value()) {
+      continue;
+    }
+    diac_after[*aj] += it->second;
+  }
+
+  std::string out_utf8;
+  for (int i = 0; i < static_cast<int>(ref.size()); ++i) {
+    utf8_append_codepoint(out_utf8, ref[static_cast<std::size_t>(i)]);
+    const auto d = diac_after.find(i);
+    if (d != diac_after.end()) {
+      out_utf8 += d->second;
+    }
+  }
+  std::u32string nfc_u = ar_wp::utf8_to_u32(out_utf8);
+  std::string nfc8 = ar_wp::u32_to_utf8(nfc_u);
+  utf8proc_uint8_t* nfc =
+      utf8proc_NFC(reinterpret_cast<const utf8proc_uint8_t*>(nfc8.c_str()));
+  if (nfc == nullptr) {
+    return nfc8;
+  }
+  std::string composed(reinterpret_cast<char*>(nfc));
+  std::free(nfc);
+  return composed;
+}
+
+}  // namespace
+
 ArabicDiacOnnx::ArabicDiacOnnx(std::filesystem::path model_dir, bool use_cuda)
     : ArabicDiacOnnx(nullptr, std::string_view{}, std::move(model_dir),
                      use_cuda) {}
@@ -706,20 +803,31 @@ ArabicDiacOnnx::ArabicDiacOnnx(const MoonshineG2POptions* opt,
     auto out_ptr = session_->GetOutputNameAllocated(0, alloc);
     logits_output_name_ = std::string(out_ptr.get());
   }
+  batch_dynamic_ = first_input_batch_dynamic(*session_);
 }
 
 ArabicDiacOnnx::~ArabicDiacOnnx() = default;
 
 std::string ArabicDiacOnnx::diacritize(std::string_view text_utf8) const {
-  const std::string trimmed = trim_ascii_ws_copy(text_utf8);
-  if (trimmed.empty()) {
-    return "";
+  return std::move(diacritize_batch({std::string(text_utf8)}).front());
+}
+
+std::vector<std::string> ArabicDiacOnnx::diacritize_batch(
+    const std::vector<std::string>& texts) const {
+  std::vector<std::string> out(texts.size());
+  std::vector<std::string> undiacritized(texts.size());
+  bool any = false;
+  for (size_t i = 0; i < texts.size(); ++i) {
+    const std::string trimmed = trim_ascii_ws_copy(texts[i]);
+    if (trimmed.empty()) {
+      continue;
+    }
+    undiacritized[i] = ar_wp::u32_to_utf8(
+        ar_wp::strip_arabic_diacritics_u32(utf8_str_to_u32(trimmed)));
+    any = any || !undiacritized[i].empty();
   }
-  std::u32string u32 = utf8_str_to_u32(trimmed);
-  u32 = ar_wp::strip_arabic_diacritics_u32(u32);
-  const std::string und = ar_wp::u32_to_utf8(u32);
-  if (und.empty()) {
-    return "";
+  if (!any) {
+    return out;
   }
 
   if (cached_vocab_txt_.empty() || cached_tokenizer_cfg_json_.empty()) {
@@ -738,127 +846,31 @@ std::string ArabicDiacOnnx::diacritize(std::string_view text_utf8) const {
   const std::string cls_utf8 = cfg.at("cls_token").get<std::string>();
   const std::string sep_utf8 = cfg.at("sep_token").get<std::string>();
 
-  ar_wp::EncodedWp enc = ar_wp::encode_bert_wordpiece(
-      ar_wp::utf8_to_u32(und), vocab, bcfg, unk_utf8, cls_utf8, sep_utf8);
-  if (static_cast<int>(enc.input_ids.size()) > max_sequence_length_) {
-    const int keep = max_sequence_length_ - 2;
-    const int64_t cls_id = enc.input_ids.front();
-    const int64_t sep_id = enc.input_ids.back();
-    std::vector<int64_t> inner(enc.input_ids.begin() + 1,
-                               enc.input_ids.end() - 1);
-    if (static_cast<int>(inner.size()) > keep) {
-      inner.resize(static_cast<std::size_t>(keep));
-    }
-    std::vector<std::pair<int, int>> inner_off(enc.offsets_cp.begin() + 1,
-                                               enc.offsets_cp.end() - 1);
-    if (static_cast<int>(inner_off.size()) > keep) {
-      inner_off.resize(static_cast<std::size_t>(keep));
-    }
-    enc.input_ids.clear();
-    enc.input_ids.push_back(cls_id);
-    enc.input_ids.insert(enc.input_ids.end(), inner.begin(), inner.end());
-    enc.input_ids.push_back(sep_id);
-    enc.offsets_cp.clear();
-    enc.offsets_cp.push_back({0, 0});
-    enc.offsets_cp.insert(enc.offsets_cp.end(), inner_off.begin(),
-                          inner_off.end());
-    enc.offsets_cp.push_back({0, 0});
-  }
-
-  std::vector<int64_t> ids_mut = enc.input_ids;
-  const int64_t T = static_cast<int64_t>(ids_mut.size());
-  // A split model's weights are graph inputs and so cannot be pre-packed, and
-  // its MatMul takes a much slower path below this many rows. Padding up costs
-  // nothing: attention_mask zeroes the padding out.
-  const int64_t padded =
-      split_weights_.empty() ? T : std::max(T, kSplitWeightsMinSequenceLength);
-  ids_mut.resize(static_cast<size_t>(padded), pad_id_);
-  std::vector<int64_t> mask(static_cast<size_t>(padded), 0);
-  for (int64_t i = 0; i < T; ++i) {
-    if (ids_mut[static_cast<size_t>(i)] != pad_id_) {
-      mask[static_cast<size_t>(i)] = 1;
-    }
-  }
-
-  const std::array<int64_t, 2> shape{1, padded};
-  std::vector<Ort::Value> inputs;
-  inputs.push_back(Ort::Value::CreateTensor<int64_t>(
-      mem_, ids_mut.data(), ids_mut.size(), shape.data(), shape.size()));
-  inputs.push_back(Ort::Value::CreateTensor<int64_t>(
-      mem_, mask.data(), mask.size(), shape.data(), shape.size()));
-
-  std::vector<const char*> in_names{"input_ids", "attention_mask"};
-  append_split_weight_inputs(split_weights_, mem_, inputs, in_names);
-
-  const char* out_names[] = {logits_output_name_.c_str()};
-  auto outputs = session_->Run(Ort::RunOptions{nullptr}, in_names.data(),
-                               inputs.data(), inputs.size(), out_names, 1);
-  const float* logits = outputs[0].GetTensorData<float>();
-  const auto info = outputs[0].GetTensorTypeAndShapeInfo();
-  const auto oshape = info.GetShape();
-  if (oshape.size() != 3 || oshape[0] != 1 || oshape[1] != padded) {
-    throw std::runtime_error("ArabicDiacOnnx: unexpected logits shape");
-  }
-  const int64_t num_labels = oshape[2];
-  if (num_labels != static_cast<int64_t>(id2label_.size())) {
-    throw std::runtime_error(
-        "ArabicDiacOnnx: logits last dim != id2label size");
-  }
-
-  const std::u32string& ref = enc.ref_u32;
-  const auto& offs = enc.offsets_cp;
-  std::unordered_map<int, std::string> diac_after;
-
-  for (int64_t ti = 0; ti < T; ++ti) {
-    if (ti == 0 || ti == T - 1) {
-      continue;
-    }
-    int best = 0;
-    const std::size_t base =
-        static_cast<std::size_t>(ti) * static_cast<std::size_t>(num_labels);
-    float best_v = logits[base];
-    for (int64_t j = 1; j < num_labels; ++j) {
-      const float v = logits[base + static_cast<std::size_t>(j)];
-      if (v > best_v) {
-        best_v = v;
-        best = static_cast<int>(j);
-      }
-    }
-    const std::string& lab = id2label_[static_cast<std::size_t>(best)];
-    if (lab == "X") {
-      continue;
-    }
-    const auto it = label_to_diac_.find(lab);
-    if (it == label_to_diac_.end() || it->second.empty()) {
+  std::vector<ar_wp::EncodedWp> encoded;
+  std::vector<size_t> encoded_text;
+  for (size_t i = 0; i < texts.size(); ++i) {
+    if (undiacritized[i].empty()) {
       continue;
     }
-    const int s = offs[static_cast<std::size_t>(ti)].first;
-    const int e = offs[static_cast<std::size_t>(ti)].second;
-    const auto aj = ar_wp::anchor_index_for_span(ref, s, e);
-    if (!aj.has_value()) {
-      continue;
-    }
-    diac_after[*aj] += it->second;
-  }
-
-  std::string out_utf8;
-  for (int i = 0; i < static_cast<int>(ref.size()); ++i) {
-    utf8_append_codepoint(out_utf8, ref[static_cast<std::size_t>(i)]);
-    const auto d = diac_after.find(i);
-    if (d != diac_after.end()) {
-      out_utf8 += d->second;
-    }
+    encoded.push_back(ar_wp::encode_bert_wordpiece(
+        ar_wp::utf8_to_u32(undiacritized[i]), vocab, bcfg, unk_utf8, cls_utf8,
+        sep_utf8));
+    encoded_text.push_back(i);
+    truncate_encoding(encoded.back(), max_sequence_length_);
+  }
+  std::vector<std::vector<int64_t>> ids;
+  ids.reserve(encoded.size());
+  for (const ar_wp::EncodedWp& enc : encoded) {
+    ids.push_back(enc.input_ids);
+  }
+  const std::vector<std::vector<float>> logits = run_token_classifier_batched(
+      *session_, mem_, split_weights_, logits_output_name_, ids, pad_id_,
+      id2label_.size(), batch_dynamic_, "ArabicDiacOnnx");
+  for (size_t k = 0; k < encoded.size(); ++k) {
+    out[encoded_text[k]] = apply_diacritics(encoded[k], logits[k].data(),
+                                            id2label_, label_to_diac_);
   }
-  std::u32string nfc_u = ar_wp::utf8_to_u32(out_utf8);
-  std::string nfc8 = ar_wp::u32_to_utf8(nfc_u);
-  utf8proc_uint8_t* nfc =
-      utf8proc_NFC(reinterpret_cast<const utf8proc_uint8_t*>(nfc8.c_str()));
-  if (nfc == nullptr) {
-    return nfc8;
-  }
-  std::string composed(reinterpret_cast<char*>(nfc));
-  std::free(nfc);
-  return composed;
+  return out;
 }
 
 }  // namespace moonshine_tts
@@ -38,6 +38,11 @@ class ArabicDiacOnnx {
   /// as Python post-process applied separately in :class:`ArabicRuleG2p`).
   std::string diacritize(std::string_view text_utf8) const;
 
+  /// ``diacritize`` for each of ``texts``, run through the model in
+  /// length-bucketed padded batches rather than one session run each.
+  std::vector<std::string> diacritize_batch(
+      const std::vector<std::string>& texts) const;
+
   const std::filesystem::path& model_dir() const { return model_dir_; }
 
   /// True when the model loaded as a split ORT pair rather than a single file.
@@ -50,6 +55,8 @@ class ArabicDiacOnnx {
   std::vector<std::string> id2label_;
   int64_t pad_id_{0};
   int max_sequence_length_{512};
+  /// Whether the model accepts more than one row per run.
+  bool batch_dynamic_{false};
   std::unique_ptr<Ort::Session> session_;
   std::string logits_output_name_;
   std::unordered_map<std::string, std::string> label_to_diac_;
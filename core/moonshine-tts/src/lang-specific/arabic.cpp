@@ -2,10 +2,10 @@
 
 #include <algorithm>
 #include <cctype>
-#include <fstream>
 #include <istream>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_set>
 
 #include "arabic-ipa.h"
 #include "g2p-path.h"
@@ -48,9 +48,30 @@ bool has_arabic_script(std::string_view s) {
   return false;
 }
 
-std::unordered_map<std::string, std::string> load_lex_first_tsv_stream(
+CompiledLexicon load_lex_first_tsv(const std::filesystem::path& p) {
+  if (!CompiledLexicon::can_open(p)) {
+    return {};
+  }
+  return CompiledLexicon::open(p, ArabicRuleG2p::kCompiledLexiconKind,
+                               &ArabicRuleG2p::parse_lexicon_entries);
+}
+
+CompiledLexicon load_lex_first_tsv_bytes(std::string_view utf8) {
+  return CompiledLexicon::open_bytes(utf8, ArabicRuleG2p::kCompiledLexiconKind,
+                                     &ArabicRuleG2p::parse_lexicon_entries);
+}
+
+std::string strip_lex_ipa_segment_dots(std::string ipa) {
+  ipa.erase(std::remove(ipa.begin(), ipa.end(), '.'), ipa.end());
+  return ipa;
+}
+
+}  // namespace
+
+std::vector<CompiledLexicon::Entry> ArabicRuleG2p::parse_lexicon_entries(
     std::istream& in) {
-  std::unordered_map<std::string, std::string> lex;
+  std::vector<CompiledLexicon::Entry> entries;
+  std::unordered_set<std::string> seen;
   std::string line;
   while (std::getline(in, line)) {
     if (!line.empty() && line.back() == '\r') {
@@ -74,29 +95,14 @@ std::unordered_map<std::string, std::string> load_lex_first_tsv_stream(
     if (!(iss >> ipa0)) {
       continue;
     }
-    if (lex.count(w) == 0) {
-      lex.emplace(std::move(w), std::move(ipa0));
+    if (seen.insert(w).second) {
+      entries.emplace_back(std::move(w),
+                           std::vector<std::string>{std::move(ipa0)});
     }
   }
-  return lex;
-}
-
-std::unordered_map<std::string, std::string> load_lex_first_tsv(
-    const std::filesystem::path& p) {
-  std::ifstream in(p);
-  if (!in) {
-    return {};
-  }
-  return load_lex_first_tsv_stream(in);
-}
-
-std::string strip_lex_ipa_segment_dots(std::string ipa) {
-  ipa.erase(std::remove(ipa.begin(), ipa.end(), '.'), ipa.end());
-  return ipa;
+  return entries;
 }
 
-}  // namespace
-
 ArabicRuleG2p::ArabicRuleG2p(std::filesystem::path onnx_model_dir,
                              std::filesystem::path dict_tsv, bool use_cuda)
     : diac_(std::make_unique<ArabicDiacOnnx>(std::move(onnx_model_dir),
@@ -107,10 +113,7 @@ ArabicRuleG2p::ArabicRuleG2p(std::filesystem::path onnx_model_dir,
                              std::string dict_tsv_utf8, bool use_cuda)
     : diac_(std::make_unique<ArabicDiacOnnx>(std::move(onnx_model_dir),
                                              use_cuda)),
-      lex_() {
-  std::istringstream in(std::move(dict_tsv_utf8));
-  lex_ = load_lex_first_tsv_stream(in);
-}
+      lex_(load_lex_first_tsv_bytes(dict_tsv_utf8)) {}
 
 ArabicRuleG2p::ArabicRuleG2p(const MoonshineG2POptions& opt,
                              std::filesystem::path onnx_model_dir,
@@ -124,10 +127,7 @@ ArabicRuleG2p::ArabicRuleG2p(const MoonshineG2POptions& opt,
                              std::string dict_tsv_utf8, bool use_cuda)
     : diac_(std::make_unique<ArabicDiacOnnx>(
           &opt, kG2pArabicOnnxDirKey, std::move(onnx_model_dir), use_cuda)),
-      lex_() {
-  std::istringstream in(std::move(dict_tsv_utf8));
-  lex_ = load_lex_first_tsv_stream(in);
-}
+      lex_(load_lex_first_tsv_bytes(dict_tsv_utf8)) {}
 
 std::vector<std::string> ArabicRuleG2p::dialect_ids() {
   return dedupe_dialect_ids_preserve_first(
@@ -155,22 +155,6 @@ std::filesystem::path resolve_arabic_onnx_model_dir(
   return base / "ar_msa" / "arabertv02_tashkeel_fadel_onnx";
 }
 
-std::string ArabicRuleG2p::g2p_word(std::string_view word_utf8) {
-  const std::string w = trim_ascii_ws_copy(word_utf8);
-  if (w.empty() || !has_arabic_script(w)) {
-    return "";
-  }
-  const std::string key = arabic_msa_strip_diacritics_utf8(w);
-  const auto it = lex_.find(key);
-  if (it != lex_.end()) {
-    return strip_lex_ipa_segment_dots(it->second);
-  }
-  const std::string diac = diac_->diacritize(w);
-  const std::string filled =
-      arabic_msa_apply_onnx_partial_postprocess_utf8(diac);
-  return arabic_msa_word_to_ipa_with_assimilation_utf8(filled, w);
-}
-
 std::string ArabicRuleG2p::text_to_ipa(std::string text,
                                        std::vector<G2pWordLog>* per_word_log) {
   (void)per_word_log;
@@ -178,7 +162,7 @@ std::string ArabicRuleG2p::text_to_ipa(std::string text,
   if (raw.empty()) {
     return "";
   }
-  std::vector<std::string> ipa_words;
+  std::vector<std::string> words;
   std::size_t i = 0;
   while (i < raw.size()) {
     while (i < raw.size() &&
@@ -193,19 +177,48 @@ std::string ArabicRuleG2p::text_to_ipa(std::string text,
            std::isspace(static_cast<unsigned char>(raw[j])) == 0) {
       ++j;
     }
-    const std::string tok = raw.substr(i, j - i);
+    words.push_back(trim_ascii_ws_copy(raw.substr(i, j - i)));
     i = j;
-    const std::string ipa = g2p_word(tok);
+  }
+
+  // Lexicon words are looked up directly; the rest of the paragraph's Arabic
+  // words are diacritized together in as few model runs as possible.
+  std::vector<std::string> ipa_words(words.size());
+  std::vector<std::string> oov_words;
+  std::vector<std::size_t> oov_index;
+  for (std::size_t k = 0; k < words.size(); ++k) {
+    const std::string& w = words[k];
+    if (w.empty() || !has_arabic_script(w)) {
+      continue;
+    }
+    const CompiledLexicon::Alternatives ipa =
+        lex_.lookup(arabic_msa_strip_diacritics_utf8(w));
     if (!ipa.empty()) {
-      ipa_words.push_back(ipa);
+      ipa_words[k] = strip_lex_ipa_segment_dots(std::string(ipa[0]));
+    } else {
+      oov_words.push_back(w);
+      oov_index.push_back(k);
     }
   }
+  if (!oov_words.empty()) {
+    const std::vector<std::string> diac = diac_->diacritize_batch(oov_words);
+    for (std::size_t k = 0; k < oov_words.size(); ++k) {
+      const std::string filled =
+          arabic_msa_apply_onnx_partial_postprocess_utf8(diac[k]);
+      ipa_words[oov_index[k]] =
+          arabic_msa_word_to_ipa_with_assimilation_utf8(filled, oov_words[k]);
+    }
+  }
+
   std::string out;
-  for (std::size_t k = 0; k < ipa_words.size(); ++k) {
-    if (k > 0) {
+  for (const std::string& ipa : ipa_words) {
+    if (ipa.empty()) {
+      continue;
+    }
+    if (!out.empty()) {
       out.push_back(' ');
     }
-    out += ipa_words[k];
+    out += ipa;
   }
   return out;
 }
@@ -1,14 +1,16 @@
 #ifndef MOONSHINE_TTS_LANG_SPECIFIC_ARABIC_H
 #define MOONSHINE_TTS_LANG_SPECIFIC_ARABIC_H
 
+#include <cstdint>
 #include <filesystem>
+#include <istream>
 #include <memory>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <vector>
 
 #include "arabic-diac-onnx.h"
+#include "compiled-lexicon.h"
 #include "rule-based-g2p.h"
 
 namespace moonshine_tts {
@@ -38,6 +40,13 @@ class ArabicRuleG2p : public RuleBasedG2p {
 
   static std::vector<std::string> dialect_ids();
 
+  /// ``CompiledLexicon`` kind of lexicons built by ``parse_lexicon_entries``.
+  static constexpr uint32_t kCompiledLexiconKind = 2;
+  /// Lexicon TSV rows as stored: the first IPA token of the first row of each
+  /// word.
+  static std::vector<CompiledLexicon::Entry> parse_lexicon_entries(
+      std::istream& in);
+
   std::string text_to_ipa(
       std::string text,
       std::vector<G2pWordLog>* per_word_log = nullptr) override;
@@ -47,8 +56,7 @@ class ArabicRuleG2p : public RuleBasedG2p {
  private:
   std::string dialect_id_{"ar-MSA"};
   std::unique_ptr<ArabicDiacOnnx> diac_;
-  std::unordered_map<std::string, std::string> lex_;
-  std::string g2p_word(std::string_view word_utf8);
+  CompiledLexicon lex_;
 };
 
 bool dialect_resolves_to_arabic_rules(std::string_view dialect_id);
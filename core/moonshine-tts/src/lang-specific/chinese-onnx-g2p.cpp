@@ -1,9 +1,11 @@
 #include "chinese-onnx-g2p.h"
 
+#include <iterator>
 #include <utility>
 
 #include "g2p-word-log.h"
 #include "moonshine-g2p-options.h"
+#include "tts-pipeline.h"
 #include "utf8-utils.h"
 
 extern "C" {
@@ -53,7 +55,17 @@ std::string ChineseOnnxG2p::text_to_ipa(std::string text_utf8,
   if (raw.empty()) {
     return "";
   }
-  const auto pairs = tok_.annotate(raw);
+  // The sentences of a paragraph are tagged together, in batched model runs.
+  std::vector<std::pair<std::string, std::string>> pairs;
+  const std::vector<std::string> sentences = split_text_for_g2p_pipeline(raw);
+  if (sentences.size() > 1) {
+    for (auto& sentence_pairs : tok_.annotate_batch(sentences)) {
+      pairs.insert(pairs.end(), std::make_move_iterator(sentence_pairs.begin()),
+                   std::make_move_iterator(sentence_pairs.end()));
+    }
+  } else {
+    pairs = tok_.annotate(raw);
+  }
   std::string out;
   for (const auto& pr : pairs) {
     const std::string& w = pr.first;
@@ -3,7 +3,6 @@
 #include <nlohmann/json.h>
 
 #include <algorithm>
-#include <array>
 #include <cctype>
 #include <cmath>
 #include <cstdint>
@@ -635,6 +634,80 @@ std::size_t cjk_tokpos_chunk_exclusive_end(const std::u32string& full,
   return best_excl;
 }
 
+/// Merges one chunk's BIO token labels into ``(surface, UPOS)`` words.
+std::vector<std::pair<std::string, std::string>> bio_words(
+    const EncodedWp& enc, const float* logits,
+    const std::vector<std::string>& id2label) {
+  const int64_t T = static_cast<int64_t>(enc.input_ids.size());
+  const int64_t num_labels = static_cast<int64_t>(id2label.size());
+  std::vector<std::pair<std::string, std::string>> chunk_pairs;
+  const std::u32string& ref = enc.ref_u32;
+  std::vector<std::pair<int, int>> cur_spans;
+  std::string cur_tag;
+
+  auto flush = [&]() {
+    if (cur_spans.empty()) {
+      cur_tag.clear();
+      return;
+    }
+    std::string surf;
+    for (const auto& sp : cur_spans) {
+      surf += u32_to_utf8(
+          ref.substr(static_cast<std::size_t>(sp.first),
+                     static_cast<std::size_t>(sp.second - sp.first)));
+    }
+    chunk_pairs.emplace_back(std::move(surf),
+                             cur_tag.empty() ? std::string("X") : cur_tag);
+    cur_spans.clear();
+    cur_tag.clear();
+  };
+
+  for (int64_t ti = 0; ti < T; ++ti) {
+    if (ti == 0 || ti == T - 1) {
+      flush();
+      continue;
+    }
+    const int s = enc.offsets_cp[static_cast<std::size_t>(ti)].first;
+    const int e = enc.offsets_cp[static_cast<std::size_t>(ti)].second;
+    int best = 0;
+    const std::size_t base =
+        static_cast<std::size_t>(ti) * static_cast<std::size_t>(num_labels);
+    float best_v = logits[base];
+    for (int64_t j = 1; j < num_labels; ++j) {
+      const float v = logits[base + static_cast<std::size_t>(j)];
+      if (v > best_v) {
+        best_v = v;
+        best = static_cast<int>(j);
+      }
+    }
+    const std::string& lab = id2label[static_cast<std::size_t>(best)];
+    if (lab.size() >= 2 && lab.compare(0, 2, "B-") == 0) {
+      flush();
+      cur_tag = lab.substr(2);
+      cur_spans.push_back({s, e});
+    } else if (lab.size() >= 2 && lab.compare(0, 2, "I-") == 0) {
+      const std::string suf = lab.substr(2);
+      if (cur_spans.empty()) {
+        cur_tag = suf;
+        cur_spans.push_back({s, e});
+      } else {
+        cur_spans.push_back({s, e});
+        if (cur_tag.empty()) {
+          cur_tag = suf;
+        }
+      }
+    } else {
+      flush();
+      chunk_pairs.emplace_back(
+          u32_to_utf8(ref.substr(static_cast<std::size_t>(s),
+                                 static_cast<std::size_t>(e - s))),
+          lab);
+    }
+  }
+  flush();
+  return chunk_pairs;
+}
+
 }  // namespace
 
 std::filesystem::path default_chinese_tok_pos_model_dir(
@@ -696,6 +769,7 @@ ChineseTokPosOnnx::ChineseTokPosOnnx(const MoonshineG2POptions* opt,
     auto out_ptr = session_->GetOutputNameAllocated(0, alloc);
     logits_output_name_ = std::string(out_ptr.get());
   }
+  batch_dynamic_ = first_input_batch_dynamic(*session_);
 }
 
 std::string ChineseTokPosOnnx::format_annotated_line(
@@ -712,9 +786,21 @@ std::string ChineseTokPosOnnx::format_annotated_line(
 
 std::vector<std::pair<std::string, std::string>> ChineseTokPosOnnx::annotate(
     std::string_view text_utf8) {
-  std::string trimmed = trim_ascii_ws_copy(text_utf8);
-  if (trimmed.empty()) {
-    return {};
+  return std::move(annotate_batch({std::string(text_utf8)}).front());
+}
+
+std::vector<std::vector<std::pair<std::string, std::string>>>
+ChineseTokPosOnnx::annotate_batch(const std::vector<std::string>& texts) {
+  std::vector<std::vector<std::pair<std::string, std::string>>> out(
+      texts.size());
+  std::vector<std::string> trimmed(texts.size());
+  bool any = false;
+  for (size_t i = 0; i < texts.size(); ++i) {
+    trimmed[i] = trim_ascii_ws_copy(texts[i]);
+    any = any || !trimmed[i].empty();
+  }
+  if (!any) {
+    return out;
   }
 
   if (cached_vocab_txt_.empty() || cached_tokenizer_cfg_json_.empty()) {
@@ -732,136 +818,46 @@ std::vector<std::pair<std::string, std::string>> ChineseTokPosOnnx::annotate(
   const std::string unk_utf8 = cfg.at("unk_token").get<std::string>();
   const std::string cls_utf8 = cfg.at("cls_token").get<std::string>();
   const std::string sep_utf8 = cfg.at("sep_token").get<std::string>();
-
-  const std::u32string full_u32 = utf8_to_u32(trimmed);
   auto encode_chunk = [&](const std::u32string& chunk_u32) {
     return encode_bert_wordpiece(chunk_u32, vocab, bcfg, unk_utf8, cls_utf8,
                                  sep_utf8);
   };
 
-  std::vector<std::pair<std::string, std::string>> all_pairs;
-  std::size_t cp_start = 0;
-  while (cp_start < full_u32.size()) {
-    const std::size_t cp_end = cjk_tokpos_chunk_exclusive_end(
-        full_u32, cp_start, static_cast<std::int64_t>(max_sequence_length_),
-        encode_chunk);
-    if (cp_end <= cp_start) {
-      break;
-    }
-    EncodedWp enc =
-        encode_bert_wordpiece(full_u32.substr(cp_start, cp_end - cp_start),
-                              vocab, bcfg, unk_utf8, cls_utf8, sep_utf8);
-
-    const int64_t T = static_cast<int64_t>(enc.input_ids.size());
-    // A split model's weights are graph inputs and so cannot be pre-packed, and
-    // its MatMul takes a much slower path below this many rows. Padding up
-    // costs nothing: attention_mask zeroes the padding out.
-    const int64_t padded = split_weights_.empty()
-                               ? T
-                               : std::max(T, kSplitWeightsMinSequenceLength);
-    std::vector<int64_t> ids = enc.input_ids;
-    ids.resize(static_cast<size_t>(padded), pad_id_);
-    std::vector<int64_t> mask(static_cast<size_t>(padded), 0);
-    for (int64_t i = 0; i < T; ++i) {
-      if (ids[static_cast<size_t>(i)] != pad_id_) {
-        mask[static_cast<size_t>(i)] = 1;
+  // Every text is cut into chunks that fit the model, and all chunks of all
+  // texts go through the model together.
+  std::vector<EncodedWp> chunks;
+  std::vector<size_t> chunk_text;
+  for (size_t i = 0; i < texts.size(); ++i) {
+    const std::u32string full_u32 = utf8_to_u32(trimmed[i]);
+    std::size_t cp_start = 0;
+    while (cp_start < full_u32.size()) {
+      const std::size_t cp_end = cjk_tokpos_chunk_exclusive_end(
+          full_u32, cp_start, static_cast<std::int64_t>(max_sequence_length_),
+          encode_chunk);
+      if (cp_end <= cp_start) {
+        break;
       }
+      chunks.push_back(
+          encode_chunk(full_u32.substr(cp_start, cp_end - cp_start)));
+      chunk_text.push_back(i);
+      cp_start = cp_end;
     }
-
-    const std::array<int64_t, 2> shape{1, padded};
-    std::vector<Ort::Value> inputs;
-    inputs.push_back(Ort::Value::CreateTensor<int64_t>(
-        mem_, ids.data(), ids.size(), shape.data(), shape.size()));
-    inputs.push_back(Ort::Value::CreateTensor<int64_t>(
-        mem_, mask.data(), mask.size(), shape.data(), shape.size()));
-
-    std::vector<const char*> in_names{"input_ids", "attention_mask"};
-    append_split_weight_inputs(split_weights_, mem_, inputs, in_names);
-
-    const char* out_names[] = {logits_output_name_.c_str()};
-    auto outputs = session_->Run(Ort::RunOptions{nullptr}, in_names.data(),
-                                 inputs.data(), inputs.size(), out_names, 1);
-    const float* logits = outputs[0].GetTensorData<float>();
-    const auto info = outputs[0].GetTensorTypeAndShapeInfo();
-    const auto oshape = info.GetShape();
-    if (oshape.size() != 3 || oshape[0] != 1 || oshape[1] != padded) {
-      throw std::runtime_error("ChineseTokPosOnnx: unexpected logits shape");
-    }
-    const int64_t num_labels = oshape[2];
-    if (num_labels != static_cast<int64_t>(id2label_.size())) {
-      throw std::runtime_error(
-          "ChineseTokPosOnnx: logits last dim != id2label size");
-    }
-
-    std::vector<std::pair<std::string, std::string>> chunk_pairs;
-    const std::u32string& ref = enc.ref_u32;
-    std::vector<std::pair<int, int>> cur_spans;
-    std::string cur_tag;
-
-    auto flush = [&]() {
-      if (cur_spans.empty()) {
-        cur_tag.clear();
-        return;
-      }
-      std::string surf;
-      for (const auto& sp : cur_spans) {
-        surf += u32_to_utf8(
-            ref.substr(static_cast<std::size_t>(sp.first),
-                       static_cast<std::size_t>(sp.second - sp.first)));
-      }
-      chunk_pairs.emplace_back(std::move(surf),
-                               cur_tag.empty() ? std::string("X") : cur_tag);
-      cur_spans.clear();
-      cur_tag.clear();
-    };
-
-    for (int64_t ti = 0; ti < T; ++ti) {
-      if (ti == 0 || ti == T - 1) {
-        flush();
-        continue;
-      }
-      const int s = enc.offsets_cp[static_cast<std::size_t>(ti)].first;
-      const int e = enc.offsets_cp[static_cast<std::size_t>(ti)].second;
-      int best = 0;
-      const std::size_t base =
-          static_cast<std::size_t>(ti) * static_cast<std::size_t>(num_labels);
-      float best_v = logits[base];
-      for (int64_t j = 1; j < num_labels; ++j) {
-        const float v = logits[base + static_cast<std::size_t>(j)];
-        if (v > best_v) {
-          best_v = v;
-          best = static_cast<int>(j);
-        }
-      }
-      const std::string& lab = id2label_[static_cast<std::size_t>(best)];
-      if (lab.size() >= 2 && lab.compare(0, 2, "B-") == 0) {
-        flush();
-        cur_tag = lab.substr(2);
-        cur_spans.push_back({s, e});
-      } else if (lab.size() >= 2 && lab.compare(0, 2, "I-") == 0) {
-        const std::string suf = lab.substr(2);
-        if (cur_spans.empty()) {
-          cur_tag = suf;
-          cur_spans.push_back({s, e});
-        } else {
-          cur_spans.push_back({s, e});
-          if (cur_tag.empty()) {
-            cur_tag = suf;
-          }
-        }
-      } else {
-        flush();
-        chunk_pairs.emplace_back(
-            u32_to_utf8(ref.substr(static_cast<std::size_t>(s),
-                                   static_cast<std::size_t>(e - s))),
-            lab);
-      }
+  }
+  std::vector<std::vector<int64_t>> ids;
+  ids.reserve(chunks.size());
+  for (const EncodedWp& enc : chunks) {
+    ids.push_back(enc.input_ids);
+  }
+  const std::vector<std::vector<float>> logits = run_token_classifier_batched(
+      *session_, mem_, split_weights_, logits_output_name_, ids, pad_id_,
+      id2label_.size(), batch_dynamic_, "ChineseTokPosOnnx");
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    std::vector<std::pair<std::string, std::string>>& dst = out[chunk_text[c]];
+    for (auto& pr : bio_words(chunks[c], logits[c].data(), id2label_)) {
+      dst.push_back(std::move(pr));
     }
-    flush();
-    all_pairs.insert(all_pairs.end(), chunk_pairs.begin(), chunk_pairs.end());
-    cp_start = cp_end;
   }
-  return all_pairs;
+  return out;
 }
 
 }  // namespace moonshine_tts
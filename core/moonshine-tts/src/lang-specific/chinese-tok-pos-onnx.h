@@ -37,6 +37,12 @@ class ChineseTokPosOnnx {
   std::vector<std::pair<std::string, std::string>> annotate(
       std::string_view text_utf8);
 
+  /// ``annotate`` for each of ``texts``, with the chunks of all texts run
+  /// through the model in length-bucketed padded batches rather than one
+  /// session run each.
+  std::vector<std::vector<std::pair<std::string, std::string>>> annotate_batch(
+      const std::vector<std::string>& texts);
+
   /// ``tok1/UPOS1 tok2/UPOS2 `` (trailing space if non-empty).
   static std::string format_annotated_line(
       const std::vector<std::pair<std::string, std::string>>& pairs);
@@ -54,6 +60,8 @@ class ChineseTokPosOnnx {
   std::vector<std::string> id2label_;
   int64_t pad_id_ = 1;
   int max_sequence_length_ = 512;
+  /// Whether the model accepts more than one row per run.
+  bool batch_dynamic_ = false;
   std::string logits_output_name_;
   std::string cached_vocab_txt_;
   std::string cached_tokenizer_cfg_json_;
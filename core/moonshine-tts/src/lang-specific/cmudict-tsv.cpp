@@ -1,19 +1,17 @@
 #include "cmudict-tsv.h"
 
-#include <fstream>
-#include <istream>
 #include <set>
-#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
 
 #include "text-normalize.h"
 
 namespace moonshine_tts {
 
-namespace {
-
-void parse_cmudict_tsv_lines(
-    std::istream& in,
-    std::unordered_map<std::string, std::vector<std::string>>& ipa_by_word) {
+std::vector<CompiledLexicon::Entry> CmudictTsv::parse_entries(
+    std::istream& in) {
   std::unordered_map<std::string, std::set<std::string>> raw;
   std::string line;
   while (std::getline(in, line)) {
@@ -47,35 +45,28 @@ void parse_cmudict_tsv_lines(
     const std::string key = normalize_grapheme_key(word_token);
     raw[key].insert(std::move(ipa));
   }
-  ipa_by_word.clear();
+  std::vector<CompiledLexicon::Entry> entries;
+  entries.reserve(raw.size());
   for (auto& [k, v] : raw) {
-    ipa_by_word[k] = {v.begin(), v.end()};
+    entries.emplace_back(k, std::vector<std::string>(v.begin(), v.end()));
   }
+  return entries;
 }
 
-}  // namespace
-
 CmudictTsv::CmudictTsv(const std::filesystem::path& path) {
-  std::ifstream in(path);
-  if (!in) {
+  if (!CompiledLexicon::can_open(path)) {
     throw std::runtime_error("failed to open dictionary: " + path.string());
   }
-  parse_cmudict_tsv_lines(in, ipa_by_word_);
+  lexicon_ =
+      CompiledLexicon::open(path, kCompiledLexiconKind, &parse_entries);
 }
 
-CmudictTsv::CmudictTsv(std::string_view utf8_contents) {
-  const std::string buf(utf8_contents);
-  std::istringstream in(buf);
-  parse_cmudict_tsv_lines(in, ipa_by_word_);
-}
+CmudictTsv::CmudictTsv(std::string_view utf8_contents)
+    : lexicon_(CompiledLexicon::open_bytes(
+          utf8_contents, kCompiledLexiconKind, &parse_entries)) {}
 
-const std::vector<std::string>* CmudictTsv::lookup(std::string_view key) const {
-  const std::string k(key.begin(), key.end());
-  const auto it = ipa_by_word_.find(k);
-  if (it == ipa_by_word_.end()) {
-    return nullptr;
-  }
-  return &it->second;
+CompiledLexicon::Alternatives CmudictTsv::lookup(std::string_view key) const {
+  return lexicon_.lookup(key);
 }
 
 }  // namespace moonshine_tts
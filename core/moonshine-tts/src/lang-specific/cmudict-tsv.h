@@ -1,25 +1,38 @@
 #ifndef MOONSHINE_TTS_CMUDICT_TSV_H
 #define MOONSHINE_TTS_CMUDICT_TSV_H
 
+#include <cstdint>
 #include <filesystem>
-#include <string>
+#include <istream>
 #include <string_view>
-#include <unordered_map>
 #include <vector>
 
+#include "compiled-lexicon.h"
+
 namespace moonshine_tts {
 
 // word key (normalized grapheme) -> sorted unique IPA strings (TSV:
-// word<TAB>ipa).
+// word<TAB>ipa). Either form loads into a ``CompiledLexicon``; a compiled
+// ``.mlex`` file (or one next to the TSV, see ``CompiledLexicon::open``) is
+// memory-mapped instead of parsed.
 class CmudictTsv {
  public:
+  /// ``CompiledLexicon`` kind of lexicons built by ``parse_entries``.
+  static constexpr uint32_t kCompiledLexiconKind = 1;
+
   explicit CmudictTsv(const std::filesystem::path& path);
   explicit CmudictTsv(std::string_view utf8_contents);
 
-  const std::vector<std::string>* lookup(std::string_view key) const;
+  /// Normalized keys with their sorted, de-duplicated alternatives.
+  static std::vector<CompiledLexicon::Entry> parse_entries(std::istream& in);
+
+  /// Empty when ``key`` is not in the lexicon.
+  CompiledLexicon::Alternatives lookup(std::string_view key) const;
+
+  const CompiledLexicon& lexicon() const { return lexicon_; }
 
  private:
-  std::unordered_map<std::string, std::vector<std::string>> ipa_by_word_;
+  CompiledLexicon lexicon_;
 };
 
 }  // namespace moonshine_tts
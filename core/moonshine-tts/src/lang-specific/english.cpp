@@ -8,11 +8,13 @@
 #include <optional>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 #include "cmudict-tsv.h"
 #include "english-hand-oov.h"
 #include "english-numbers.h"
+#include "g2p-pronunciation-cache.h"
 #include "g2p-word-log.h"
 #include "onnx-g2p-models.h"
 #include "ort-utils-cxx.h"
@@ -90,7 +92,7 @@ EnglishRuleG2p::EnglishRuleG2p(
     : impl_(std::make_unique<Impl>()),
       prefer_british_heteronyms_(prefer_british_heteronyms) {
   (void)use_cuda;
-  if (!std::filesystem::is_regular_file(dict_tsv)) {
+  if (!CompiledLexicon::can_open(dict_tsv)) {
     throw std::runtime_error("English G2P: dictionary not found at " +
                              dict_tsv.generic_string());
   }
@@ -146,6 +148,57 @@ std::vector<std::string> EnglishRuleG2p::dialect_ids() {
 
 std::string EnglishRuleG2p::text_to_ipa(std::string text,
                                         std::vector<G2pWordLog>* per_word_log) {
+  // Pronunciations of lexicon misses, resolved before the main pass below:
+  // from the pronunciation cache when one is attached, otherwise through the
+  // OOV model (all of the text's misses in one batch) or the hand rules.
+  // An OOV pronunciation depends on the word alone, never its neighbours.
+  const auto cache_key = [this](const std::string& gkey) {
+    return G2pPronunciationCache::make_key(
+        pronunciation_cache_scope_, G2pPronunciationCache::kContextFree, gkey);
+  };
+  std::unordered_map<std::string, G2pCachedPronunciation> oov;
+  {
+    std::vector<std::string> pending;
+    for (const auto& token : split_text_to_words(text)) {
+      const std::string key_lookup = normalize_word_for_lookup(token);
+      if (key_lookup.empty() || english_number_token_ipa(key_lookup)) {
+        continue;
+      }
+      std::string gkey = normalize_grapheme_key(key_lookup);
+      if (!impl_->dict->lookup(gkey).empty() || oov.count(gkey) != 0) {
+        continue;
+      }
+      if (pronunciation_cache_ != nullptr) {
+        auto hit = pronunciation_cache_->get(cache_key(gkey));
+        if (hit) {
+          oov.emplace(std::move(gkey), std::move(*hit));
+          continue;
+        }
+      }
+      oov.emplace(gkey, G2pCachedPronunciation{});
+      pending.push_back(std::move(gkey));
+    }
+    std::vector<std::vector<std::string>> phones(pending.size());
+    if (impl_->oov && !pending.empty()) {
+      phones = impl_->oov->predict_phonemes_batch(pending);
+    }
+    for (size_t i = 0; i < pending.size(); ++i) {
+      G2pCachedPronunciation& p = oov[pending[i]];
+      if (!phones[i].empty()) {
+        for (const std::string& ph : phones[i]) {
+          p.ipa += ph;
+        }
+        p.path = G2pWordPath::kOovModel;
+      } else {
+        p.ipa = english_hand_oov_rules_ipa(pending[i]);
+        p.path = G2pWordPath::kOovHandRules;
+      }
+      if (pronunciation_cache_ != nullptr) {
+        pronunciation_cache_->put(cache_key(pending[i]), p);
+      }
+    }
+  }
+
   std::vector<std::string> parts;
   int pos = 0;
   for (const auto& token : split_text_to_words(text)) {
@@ -182,43 +235,28 @@ std::string EnglishRuleG2p::text_to_ipa(std::string text,
       continue;
     }
 
-    const std::vector<std::string>* alts_ptr = impl_->dict->lookup(gkey);
-    if (!alts_ptr || alts_ptr->empty()) {
-      if (impl_->oov) {
-        const std::vector<std::string> phones =
-            impl_->oov->predict_phonemes(gkey);
-        if (!phones.empty()) {
-          std::string chunk;
-          for (const auto& p : phones) {
-            chunk += p;
-          }
-          append_log(per_word_log,
-                     G2pWordLog{token, gkey, G2pWordPath::kOovModel, chunk});
-          parts.push_back(std::move(chunk));
-        } else {
-          const std::string hand = english_hand_oov_rules_ipa(gkey);
-          append_log(per_word_log,
-                     G2pWordLog{token, gkey, G2pWordPath::kOovHandRules, hand});
-          parts.push_back(hand);
-        }
+    const CompiledLexicon::Alternatives dict_alts = impl_->dict->lookup(gkey);
+    if (dict_alts.empty()) {
+      const auto found = oov.find(gkey);
+      G2pCachedPronunciation p;
+      if (found != oov.end()) {
+        p = found->second;
       } else {
-        const std::string hand = english_hand_oov_rules_ipa(gkey);
-        append_log(per_word_log,
-                   G2pWordLog{token, gkey, G2pWordPath::kOovHandRules, hand});
-        parts.push_back(hand);
+        p = {english_hand_oov_rules_ipa(gkey), G2pWordPath::kOovHandRules};
       }
+      append_log(per_word_log, G2pWordLog{token, gkey, p.path, p.ipa});
+      parts.push_back(std::move(p.ipa));
       continue;
     }
 
-    std::vector<std::string> alts = *alts_ptr;
-    if (alts.size() == 1) {
-      append_log(
-          per_word_log,
-          G2pWordLog{token, gkey, G2pWordPath::kDictUnambiguous, alts[0]});
-      parts.push_back(alts[0]);
+    if (dict_alts.size() == 1) {
+      std::string ipa(dict_alts[0]);
+      append_log(per_word_log,
+                 G2pWordLog{token, gkey, G2pWordPath::kDictUnambiguous, ipa});
+      parts.push_back(std::move(ipa));
     } else {
       const std::string chosen = pick_english_heteronym_ipa(
-          std::move(alts), prefer_british_heteronyms_);
+          dict_alts.to_strings(), prefer_british_heteronyms_);
       append_log(per_word_log,
                  G2pWordLog{token, gkey,
                             G2pWordPath::kDictFirstAlternativeNoHeteronymModel,
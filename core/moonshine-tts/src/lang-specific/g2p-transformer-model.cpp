@@ -1,5 +1,6 @@
 #include "g2p-transformer-model.h"
 
+#include <array>
 #include <cstdio>
 #include <memory>
 #include <stdexcept>
@@ -7,6 +8,7 @@
 #include <utility>
 
 #include "g2p-path.h"
+#include "length-buckets.h"
 #include "moonshine-g2p-options.h"
 #include "ort-session-options.h"
 
@@ -144,4 +146,60 @@ G2pTransformerModel load_g2p_transformer_model(
                            " (no split ORT pair and no .ort found)");
 }
 
+bool first_input_batch_dynamic(const Ort::Session& session) {
+  const std::vector<int64_t> shape =
+      session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+  return !shape.empty() && shape[0] < 0;
+}
+
+std::vector<std::vector<float>> run_token_classifier_batched(
+    Ort::Session& session, const Ort::MemoryInfo& mem,
+    const std::vector<SplitWeight>& split_weights,
+    const std::string& logits_output_name,
+    const std::vector<std::vector<int64_t>>& sequences, int64_t pad_id,
+    size_t num_labels, bool batch_dynamic, std::string_view owner) {
+  // A split model's weights are graph inputs and so cannot be pre-packed, and
+  // its MatMul takes a much slower path below this many rows. Padding up costs
+  // nothing: attention_mask zeroes the padding out.
+  const size_t min_length =
+      split_weights.empty()
+          ? size_t{0}
+          : static_cast<size_t>(kSplitWeightsMinSequenceLength);
+  LengthBucketLimits limits;
+  if (!batch_dynamic) {
+    limits.max_rows = 1;
+  }
+  const auto run = [&](const std::vector<int64_t>& ids,
+                       const std::vector<int64_t>& mask, int64_t rows,
+                       int64_t padded, std::vector<float>& logits) {
+    const std::array<int64_t, 2> shape{rows, padded};
+    std::vector<Ort::Value> inputs;
+    inputs.push_back(Ort::Value::CreateTensor<int64_t>(
+        mem, const_cast<int64_t*>(ids.data()), ids.size(), shape.data(),
+        shape.size()));
+    inputs.push_back(Ort::Value::CreateTensor<int64_t>(
+        mem, const_cast<int64_t*>(mask.data()), mask.size(), shape.data(),
+        shape.size()));
+    std::vector<const char*> in_names{"input_ids", "attention_mask"};
+    append_split_weight_inputs(split_weights, mem, inputs, in_names);
+
+    const char* out_names[] = {logits_output_name.c_str()};
+    auto outputs = session.Run(Ort::RunOptions{nullptr}, in_names.data(),
+                               inputs.data(), inputs.size(), out_names, 1);
+    const auto oshape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
+    if (oshape.size() != 3 || oshape[0] != rows || oshape[1] != padded) {
+      throw std::runtime_error(std::string(owner) +
+                               ": unexpected logits shape");
+    }
+    if (oshape[2] != static_cast<int64_t>(num_labels)) {
+      throw std::runtime_error(std::string(owner) +
+                               ": logits last dim != id2label size");
+    }
+    const float* data = outputs[0].GetTensorData<float>();
+    logits.assign(data, data + ids.size() * num_labels);
+  };
+  return run_padded_batches(sequences, pad_id, num_labels, min_length, limits,
+                            run);
+}
+
 }  // namespace moonshine_tts
@@ -46,6 +46,26 @@ G2pTransformerModel load_g2p_transformer_model(
 std::string g2p_split_model_file(std::string_view model_file);
 std::string g2p_split_weights_file(std::string_view model_file);
 
+/// True when *session*'s first input has a dynamic batch dimension.
+bool first_input_batch_dynamic(const Ort::Session& session);
+
+/// Runs a token-classification transformer (int64 ``input_ids`` and
+/// ``attention_mask`` ``[B, T]`` in, float logits ``[B, T, num_labels]`` out)
+/// on every entry of *sequences* and returns each one's logits, ``T_i *
+/// num_labels`` floats, in input order.
+///
+/// Sequences are grouped by length (``run_padded_batches``) and each group is
+/// one session run, padded with *pad_id* to its longest member and masked
+/// off; a split model's rows are padded to at least
+/// ``kSplitWeightsMinSequenceLength``. When *batch_dynamic* is false every
+/// sequence runs on its own. *owner* only labels error messages.
+std::vector<std::vector<float>> run_token_classifier_batched(
+    Ort::Session& session, const Ort::MemoryInfo& mem,
+    const std::vector<SplitWeight>& split_weights,
+    const std::string& logits_output_name,
+    const std::vector<std::vector<int64_t>>& sequences, int64_t pad_id,
+    size_t num_labels, bool batch_dynamic, std::string_view owner);
+
 }  // namespace moonshine_tts
 
 #endif  // MOONSHINE_TTS_G2P_TRANSFORMER_MODEL_H
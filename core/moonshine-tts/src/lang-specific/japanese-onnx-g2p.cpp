@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <fstream>
 #include <istream>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
 #include <utility>
@@ -10,6 +11,7 @@
 
 #include "japanese-kana-to-ipa.h"
 #include "moonshine-g2p-options.h"
+#include "tts-pipeline.h"
 #include "utf8-utils.h"
 
 extern "C" {
@@ -359,9 +361,17 @@ std::string JapaneseOnnxG2p::text_to_ipa(std::string text_utf8) {
   if (raw.empty()) {
     return "";
   }
-  auto pairs = tok_.annotate(raw);
-  std::vector<std::pair<std::string, std::string>> pv(pairs.begin(),
-                                                      pairs.end());
+  // The sentences of a paragraph are tagged together, in batched model runs.
+  std::vector<std::pair<std::string, std::string>> pv;
+  const std::vector<std::string> sentences = split_text_for_g2p_pipeline(raw);
+  if (sentences.size() > 1) {
+    for (auto& sentence_pairs : tok_.annotate_batch(sentences)) {
+      pv.insert(pv.end(), std::make_move_iterator(sentence_pairs.begin()),
+                std::make_move_iterator(sentence_pairs.end()));
+    }
+  } else {
+    pv = tok_.annotate(raw);
+  }
   pv = merge_for_lexicon_lookup(std::move(pv));
   std::vector<std::string> ipa_words;
   for (const auto& pr : pv) {
@@ -3,7 +3,6 @@
 #include <nlohmann/json.h>
 
 #include <algorithm>
-#include <array>
 #include <cctype>
 #include <cmath>
 #include <cstdint>
@@ -16,6 +15,7 @@
 #include <unordered_set>
 
 #include "g2p-path.h"
+#include "g2p-transformer-model.h"
 #include "moonshine-g2p-options.h"
 #include "ort-session-options.h"
 #include "utf8-utils.h"
@@ -711,6 +711,51 @@ std::size_t cjk_tokpos_chunk_exclusive_end(const std::u32string& full,
   return best_excl;
 }
 
+/// One ``(surface, UPOS)`` per word group of a chunk: the label with the
+/// highest logit averaged over the group's tokens.
+std::vector<std::pair<std::string, std::string>> pooled_words(
+    const EncodedWp& enc, const float* logits,
+    const std::vector<std::string>& id2label) {
+  const int64_t T = static_cast<int64_t>(enc.input_ids.size());
+  const int64_t num_labels = static_cast<int64_t>(id2label.size());
+  std::vector<std::pair<std::string, std::string>> pairs;
+  for (const std::vector<int>& g : enc.word_groups) {
+    if (g.empty()) {
+      continue;
+    }
+    std::vector<double> pooled(static_cast<size_t>(num_labels), 0.0);
+    for (int ti : g) {
+      if (ti < 0 || static_cast<int64_t>(ti) >= T) {
+        continue;
+      }
+      const std::size_t base =
+          static_cast<std::size_t>(ti) * static_cast<std::size_t>(num_labels);
+      for (int64_t j = 0; j < num_labels; ++j) {
+        pooled[static_cast<size_t>(j)] +=
+            static_cast<double>(logits[base + static_cast<size_t>(j)]);
+      }
+    }
+    const double denom = static_cast<double>(g.size());
+    int best = 0;
+    double best_v = pooled[0] / denom;
+    for (int64_t j = 1; j < num_labels; ++j) {
+      const double v = pooled[static_cast<size_t>(j)] / denom;
+      if (v > best_v) {
+        best_v = v;
+        best = static_cast<int>(j);
+      }
+    }
+    const std::string& raw_label = id2label[static_cast<size_t>(best)];
+    const std::string upos = morph_label_to_upos(raw_label);
+    const int st = enc.offsets_cp[static_cast<size_t>(g.front())].first;
+    const int en = enc.offsets_cp[static_cast<size_t>(g.back())].second;
+    std::u32string surf_u = enc.ref_u32.substr(
+        static_cast<std::size_t>(st), static_cast<std::size_t>(en - st));
+    pairs.emplace_back(u32_to_utf8(surf_u), upos);
+  }
+  return pairs;
+}
+
 }  // namespace
 
 std::filesystem::path default_japanese_tok_pos_model_dir(
@@ -780,6 +825,7 @@ JapaneseTokPosOnnx::JapaneseTokPosOnnx(const MoonshineG2POptions* opt,
     auto out_ptr = session_->GetOutputNameAllocated(0, alloc);
     logits_output_name_ = std::string(out_ptr.get());
   }
+  batch_dynamic_ = first_input_batch_dynamic(*session_);
 }
 
 std::string JapaneseTokPosOnnx::format_annotated_line(
@@ -796,9 +842,21 @@ std::string JapaneseTokPosOnnx::format_annotated_line(
 
 std::vector<std::pair<std::string, std::string>> JapaneseTokPosOnnx::annotate(
     std::string_view text_utf8) {
-  std::string trimmed = trim_ascii_ws_copy(text_utf8);
-  if (trimmed.empty()) {
-    return {};
+  return std::move(annotate_batch({std::string(text_utf8)}).front());
+}
+
+std::vector<std::vector<std::pair<std::string, std::string>>>
+JapaneseTokPosOnnx::annotate_batch(const std::vector<std::string>& texts) {
+  std::vector<std::vector<std::pair<std::string, std::string>>> out(
+      texts.size());
+  std::vector<std::string> trimmed(texts.size());
+  bool any = false;
+  for (size_t i = 0; i < texts.size(); ++i) {
+    trimmed[i] = trim_ascii_ws_copy(texts[i]);
+    any = any || !trimmed[i].empty();
+  }
+  if (!any) {
+    return out;
   }
 
   if (cached_vocab_txt_.empty() || cached_tokenizer_cfg_json_.empty()) {
@@ -816,95 +874,47 @@ std::vector<std::pair<std::string, std::string>> JapaneseTokPosOnnx::annotate(
   const std::string unk_utf8 = cfg.at("unk_token").get<std::string>();
   const std::string cls_utf8 = cfg.at("cls_token").get<std::string>();
   const std::string sep_utf8 = cfg.at("sep_token").get<std::string>();
-
-  const std::u32string full_u32 = utf8_to_u32(trimmed);
   auto encode_chunk = [&](const std::u32string& chunk_u32) {
     return encode_bert_wordpiece(chunk_u32, vocab, bcfg, unk_utf8, cls_utf8,
                                  sep_utf8);
   };
 
-  std::vector<std::pair<std::string, std::string>> all_pairs;
-  std::size_t cp_start = 0;
-  while (cp_start < full_u32.size()) {
-    const std::size_t cp_end = cjk_tokpos_chunk_exclusive_end(
-        full_u32, cp_start, static_cast<std::int64_t>(max_sequence_length_),
-        encode_chunk);
-    if (cp_end <= cp_start) {
-      break;
-    }
-    EncodedWp enc =
-        encode_bert_wordpiece(full_u32.substr(cp_start, cp_end - cp_start),
-                              vocab, bcfg, unk_utf8, cls_utf8, sep_utf8);
-
-    const int64_t T = static_cast<int64_t>(enc.input_ids.size());
-    std::vector<int64_t> ids = enc.input_ids;
-    std::vector<int64_t> mask(static_cast<size_t>(T), 1);
-    for (int64_t i = 0; i < T; ++i) {
-      if (ids[static_cast<size_t>(i)] == pad_id_) {
-        mask[static_cast<size_t>(i)] = 0;
+  // Every text is cut into chunks that fit the model, and all chunks of all
+  // texts go through the model together.
+  std::vector<EncodedWp> chunks;
+  std::vector<size_t> chunk_text;
+  for (size_t i = 0; i < texts.size(); ++i) {
+    const std::u32string full_u32 = utf8_to_u32(trimmed[i]);
+    std::size_t cp_start = 0;
+    while (cp_start < full_u32.size()) {
+      const std::size_t cp_end = cjk_tokpos_chunk_exclusive_end(
+          full_u32, cp_start, static_cast<std::int64_t>(max_sequence_length_),
+          encode_chunk);
+      if (cp_end <= cp_start) {
+        break;
       }
+      chunks.push_back(
+          encode_chunk(full_u32.substr(cp_start, cp_end - cp_start)));
+      chunk_text.push_back(i);
+      cp_start = cp_end;
     }
-
-    const std::array<int64_t, 2> shape{1, T};
-    std::vector<Ort::Value> inputs;
-    inputs.push_back(Ort::Value::CreateTensor<int64_t>(
-        mem_, ids.data(), ids.size(), shape.data(), shape.size()));
-    inputs.push_back(Ort::Value::CreateTensor<int64_t>(
-        mem_, mask.data(), mask.size(), shape.data(), shape.size()));
-
-    const char* in_names[] = {"input_ids", "attention_mask"};
-    const char* out_names[] = {logits_output_name_.c_str()};
-    auto outputs = session_->Run(Ort::RunOptions{nullptr}, in_names,
-                                 inputs.data(), inputs.size(), out_names, 1);
-    const float* logits = outputs[0].GetTensorData<float>();
-    const auto info = outputs[0].GetTensorTypeAndShapeInfo();
-    const auto oshape = info.GetShape();
-    if (oshape.size() != 3 || oshape[0] != 1 || oshape[1] != T) {
-      throw std::runtime_error("JapaneseTokPosOnnx: unexpected logits shape");
-    }
-    const int64_t num_labels = oshape[2];
-    if (num_labels != static_cast<int64_t>(id2label_.size())) {
-      throw std::runtime_error(
-          "JapaneseTokPosOnnx: logits last dim != id2label size");
-    }
-
-    for (const std::vector<int>& g : enc.word_groups) {
-      if (g.empty()) {
-        continue;
-      }
-      std::vector<double> pooled(static_cast<size_t>(num_labels), 0.0);
-      for (int ti : g) {
-        if (ti < 0 || static_cast<int64_t>(ti) >= T) {
-          continue;
-        }
-        const std::size_t base =
-            static_cast<std::size_t>(ti) * static_cast<std::size_t>(num_labels);
-        for (int64_t j = 0; j < num_labels; ++j) {
-          pooled[static_cast<size_t>(j)] +=
-              static_cast<double>(logits[base + static_cast<size_t>(j)]);
-        }
-      }
-      const double denom = static_cast<double>(g.size());
-      int best = 0;
-      double best_v = pooled[0] / denom;
-      for (int64_t j = 1; j < num_labels; ++j) {
-        const double v = pooled[static_cast<size_t>(j)] / denom;
-        if (v > best_v) {
-          best_v = v;
-          best = static_cast<int>(j);
-        }
-      }
-      const std::string& raw_label = id2label_[static_cast<size_t>(best)];
-      const std::string upos = morph_label_to_upos(raw_label);
-      const int st = enc.offsets_cp[static_cast<size_t>(g.front())].first;
-      const int en = enc.offsets_cp[static_cast<size_t>(g.back())].second;
-      std::u32string surf_u = enc.ref_u32.substr(
-          static_cast<std::size_t>(st), static_cast<std::size_t>(en - st));
-      all_pairs.emplace_back(u32_to_utf8(surf_u), upos);
+  }
+  std::vector<std::vector<int64_t>> ids;
+  ids.reserve(chunks.size());
+  for (const EncodedWp& enc : chunks) {
+    ids.push_back(enc.input_ids);
+  }
+  static const std::vector<SplitWeight> kNoSplitWeights;
+  const std::vector<std::vector<float>> logits = run_token_classifier_batched(
+      *session_, mem_, kNoSplitWeights, logits_output_name_, ids, pad_id_,
+      id2label_.size(), batch_dynamic_, "JapaneseTokPosOnnx");
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    std::vector<std::pair<std::string, std::string>>& dst = out[chunk_text[c]];
+    for (auto& pr : pooled_words(chunks[c], logits[c].data(), id2label_)) {
+      dst.push_back(std::move(pr));
     }
-    cp_start = cp_end;
   }
-  return all_pairs;
+  return out;
 }
 
 }  // namespace moonshine_tts
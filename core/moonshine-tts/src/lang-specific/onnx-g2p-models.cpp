@@ -2,6 +2,7 @@
 
 #include <nlohmann/json.h>
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <filesystem>
@@ -11,6 +12,7 @@
 #include <vector>
 
 #include "constants.h"
+#include "g2p-transformer-model.h"
 #include "ort-session-options.h"
 #include "utf8-utils.h"
 
@@ -55,21 +57,6 @@ std::vector<int64_t> encode_chars_for_model(
   return ids;
 }
 
-void decoder_io_padded(const std::vector<int64_t>& cur, int max_phoneme_len,
-                       int64_t pad_token_id, std::vector<int64_t>& dec_row,
-                       std::vector<int64_t>& dec_mask, int& L) {
-  L = static_cast<int>(cur.size());
-  if (L > max_phoneme_len) {
-    throw std::runtime_error("decoder length > max_phoneme_len");
-  }
-  dec_row = cur;
-  dec_row.resize(static_cast<size_t>(max_phoneme_len), pad_token_id);
-  dec_mask.assign(static_cast<size_t>(max_phoneme_len), 0);
-  for (int i = 0; i < L; ++i) {
-    dec_mask[static_cast<size_t>(i)] = 1;
-  }
-}
-
 int argmax_vocab_row(const float* logits, int64_t vocab, int time_index) {
   const size_t base =
       static_cast<size_t>(time_index) * static_cast<size_t>(vocab);
@@ -85,14 +72,39 @@ int argmax_vocab_row(const float* logits, int64_t vocab, int time_index) {
   return best;
 }
 
+/// True when *session*'s inputs named *names* all have a dynamic second
+/// (sequence) dimension.
+bool inputs_length_dynamic(const Ort::Session& session,
+                           const std::vector<std::string>& names) {
+  Ort::AllocatorWithDefaultOptions alloc;
+  size_t found = 0;
+  for (size_t i = 0; i < session.GetInputCount(); ++i) {
+    const std::string name = session.GetInputNameAllocated(i, alloc).get();
+    if (std::find(names.begin(), names.end(), name) == names.end()) {
+      continue;
+    }
+    const std::vector<int64_t> shape =
+        session.GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape();
+    if (shape.size() != 2 || shape[1] >= 0) {
+      return false;
+    }
+    ++found;
+  }
+  return found == names.size();
+}
+
+const std::vector<std::string> kOovSequenceInputs{"encoder_input_ids",
+                                                  "decoder_input_ids"};
+
 }  // namespace
 
 OnnxOovG2p::OnnxOovG2p(Ort::Env& env, const std::filesystem::path& model_onnx,
                        const std::vector<std::string>& ort_providers,
                        const std::string& coreml_cache_dir)
     : tab_(load_oov_tables(model_onnx)),
-      session_(open_session(env, model_onnx, ort_providers, coreml_cache_dir)) {
-}
+      session_(open_session(env, model_onnx, ort_providers, coreml_cache_dir)),
+      padded_batch_dynamic_(first_input_batch_dynamic(session_)),
+      length_dynamic_(inputs_length_dynamic(session_, kOovSequenceInputs)) {}
 
 OnnxOovG2p::OnnxOovG2p(Ort::Env& env, const void* model_onnx_bytes,
                        size_t model_onnx_size,
@@ -101,81 +113,163 @@ OnnxOovG2p::OnnxOovG2p(Ort::Env& env, const void* model_onnx_bytes,
                        const std::string& coreml_cache_dir)
     : tab_(load_oov_tables_from_json(onnx_config, "onnx-config (memory)")),
       session_(open_session_memory(env, model_onnx_bytes, model_onnx_size,
-                                   ort_providers, coreml_cache_dir)) {}
+                                   ort_providers, coreml_cache_dir)),
+      padded_batch_dynamic_(first_input_batch_dynamic(session_)),
+      length_dynamic_(inputs_length_dynamic(session_, kOovSequenceInputs)) {}
 
 std::vector<std::string> OnnxOovG2p::predict_phonemes(const std::string& word) {
   if (word.empty()) {
     return {};
   }
-  std::vector<int64_t> ids = encode_chars_for_model(word, tab_.char_stoi);
-  if (static_cast<int>(ids.size()) > tab_.max_seq_len) {
-    ids.resize(static_cast<size_t>(tab_.max_seq_len));
+  return predict_phonemes_batch({word})[0];
+}
+
+std::vector<std::vector<std::string>> OnnxOovG2p::predict_phonemes_batch(
+    const std::vector<std::string>& words) {
+  std::vector<std::vector<std::string>> out(words.size());
+  std::vector<std::vector<int64_t>> rows;
+  std::vector<size_t> row_word;
+  for (size_t i = 0; i < words.size(); ++i) {
+    if (words[i].empty()) {
+      continue;
+    }
+    std::vector<int64_t> ids = encode_chars_for_model(words[i], tab_.char_stoi);
+    if (static_cast<int>(ids.size()) > tab_.max_seq_len) {
+      ids.resize(static_cast<size_t>(tab_.max_seq_len));
+    }
+    rows.push_back(std::move(ids));
+    row_word.push_back(i);
   }
-  const int enc_len = static_cast<int>(ids.size());
-  std::vector<int64_t> enc_ids(static_cast<size_t>(tab_.max_seq_len),
-                               tab_.pad_id);
-  std::vector<int64_t> enc_mask(static_cast<size_t>(tab_.max_seq_len), 0);
-  for (int i = 0; i < enc_len; ++i) {
-    enc_ids[static_cast<size_t>(i)] = ids[static_cast<size_t>(i)];
-    enc_mask[static_cast<size_t>(i)] = 1;
+  if (rows.empty()) {
+    return out;
   }
+  std::vector<std::vector<int64_t>> decoded;
+  if (padded_batch_dynamic_) {
+    decoded = decode_padded(rows);
+  } else {
+    for (const std::vector<int64_t>& row : rows) {
+      decoded.push_back(std::move(decode_padded({row})[0]));
+    }
+  }
+  for (size_t r = 0; r < rows.size(); ++r) {
+    out[row_word[r]] = ids_to_phonemes(decoded[r]);
+  }
+  return out;
+}
 
-  const std::array<int64_t, 2> enc_shape{1, tab_.max_seq_len};
-
-  std::vector<int64_t> cur;
-  cur.push_back(tab_.bos);
+std::vector<std::vector<int64_t>> OnnxOovG2p::decode_padded(
+    const std::vector<std::vector<int64_t>>& rows) {
+  const size_t batch = rows.size();
+  // With dynamic lengths the characters are padded only to the longest word
+  // and the decoder sees only the prefix decoded so far; otherwise both are
+  // padded to the export's fixed lengths and masked off.
+  size_t seq = static_cast<size_t>(tab_.max_seq_len);
+  if (length_dynamic_) {
+    seq = 1;
+    for (const std::vector<int64_t>& row : rows) {
+      seq = std::max(seq, row.size());
+    }
+  }
+  const size_t dec_len = static_cast<size_t>(tab_.max_phoneme_len);
+  std::vector<int64_t> enc_ids(batch * seq, tab_.pad_id);
+  std::vector<int64_t> enc_mask(batch * seq, 0);
+  std::vector<int64_t> dec_ids(batch * dec_len, tab_.phon_pad);
+  std::vector<int64_t> dec_mask(batch * dec_len, 0);
+  for (size_t b = 0; b < batch; ++b) {
+    std::copy(rows[b].begin(), rows[b].end(), enc_ids.begin() + b * seq);
+    std::fill_n(enc_mask.begin() + b * seq, rows[b].size(), 1);
+    dec_ids[b * dec_len] = tab_.bos;
+    dec_mask[b * dec_len] = 1;
+  }
 
+  // The tensors view the buffers above, which each step updates in place. A
+  // dynamic-length decoder input is instead viewed ``[batch, len]`` each
+  // step, which is contiguous once the rows are packed to that width.
+  const std::array<int64_t, 2> enc_shape{static_cast<int64_t>(batch),
+                                         static_cast<int64_t>(seq)};
+  std::array<int64_t, 2> dec_shape{static_cast<int64_t>(batch),
+                                   tab_.max_phoneme_len};
+  std::vector<int64_t> step_ids;
+  std::vector<int64_t> step_mask;
+  if (length_dynamic_) {
+    step_ids.reserve(batch * dec_len);
+    step_mask.reserve(batch * dec_len);
+  }
+  std::array<Ort::Value, 4> inputs{
+      Ort::Value::CreateTensor<int64_t>(mem_, enc_ids.data(), enc_ids.size(),
+                                        enc_shape.data(), enc_shape.size()),
+      Ort::Value::CreateTensor<int64_t>(mem_, enc_mask.data(), enc_mask.size(),
+                                        enc_shape.data(), enc_shape.size()),
+      Ort::Value::CreateTensor<int64_t>(mem_, dec_ids.data(), dec_ids.size(),
+                                        dec_shape.data(), dec_shape.size()),
+      Ort::Value::CreateTensor<int64_t>(mem_, dec_mask.data(), dec_mask.size(),
+                                        dec_shape.data(), dec_shape.size())};
   const char* in_names[] = {"encoder_input_ids", "encoder_attention_mask",
                             "decoder_input_ids", "decoder_attention_mask"};
   const char* out_names[] = {"logits"};
 
-  for (int step = 0; step < tab_.max_phoneme_len; ++step) {
-    (void)step;
-    std::vector<int64_t> dec_row;
-    std::vector<int64_t> dec_mask;
-    int L = 0;
-    decoder_io_padded(cur, tab_.max_phoneme_len, tab_.phon_pad, dec_row,
-                      dec_mask, L);
-
-    const std::array<int64_t, 2> dec_shape{1, tab_.max_phoneme_len};
-
-    std::vector<Ort::Value> inputs;
-    inputs.push_back(
-        Ort::Value::CreateTensor<int64_t>(mem_, enc_ids.data(), enc_ids.size(),
-                                          enc_shape.data(), enc_shape.size()));
-    inputs.push_back(Ort::Value::CreateTensor<int64_t>(
-        mem_, enc_mask.data(), enc_mask.size(), enc_shape.data(),
-        enc_shape.size()));
-    inputs.push_back(
-        Ort::Value::CreateTensor<int64_t>(mem_, dec_row.data(), dec_row.size(),
-                                          dec_shape.data(), dec_shape.size()));
-    inputs.push_back(Ort::Value::CreateTensor<int64_t>(
-        mem_, dec_mask.data(), dec_mask.size(), dec_shape.data(),
-        dec_shape.size()));
-
+  std::vector<std::vector<int64_t>> out(batch);
+  std::vector<bool> done(batch, false);
+  size_t live = batch;
+  for (size_t len = 1; live > 0; ++len) {
+    if (length_dynamic_) {
+      step_ids.clear();
+      step_mask.clear();
+      for (size_t b = 0; b < batch; ++b) {
+        const auto row = dec_ids.begin() + static_cast<ptrdiff_t>(b * dec_len);
+        step_ids.insert(step_ids.end(), row, row + static_cast<ptrdiff_t>(len));
+        const auto mask =
+            dec_mask.begin() + static_cast<ptrdiff_t>(b * dec_len);
+        step_mask.insert(step_mask.end(), mask,
+                         mask + static_cast<ptrdiff_t>(len));
+      }
+      dec_shape[1] = static_cast<int64_t>(len);
+      inputs[2] = Ort::Value::CreateTensor<int64_t>(
+          mem_, step_ids.data(), step_ids.size(), dec_shape.data(),
+          dec_shape.size());
+      inputs[3] = Ort::Value::CreateTensor<int64_t>(
+          mem_, step_mask.data(), step_mask.size(), dec_shape.data(),
+          dec_shape.size());
+    }
     auto outputs = session_.Run(Ort::RunOptions{nullptr}, in_names,
                                 inputs.data(), inputs.size(), out_names, 1);
     const float* logits = outputs[0].GetTensorData<float>();
-    const auto info = outputs[0].GetTensorTypeAndShapeInfo();
-    const auto shape = info.GetShape();
+    const auto shape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
     if (shape.size() != 3) {
       throw std::runtime_error("unexpected logits rank");
     }
-    const int64_t vocab = shape[2];
-    const int nxt = argmax_vocab_row(logits, vocab, L - 1);
-    if (nxt == static_cast<int>(tab_.eos) ||
-        nxt == static_cast<int>(tab_.phon_pad)) {
-      break;
+    const size_t row_stride = static_cast<size_t>(shape[1] * shape[2]);
+    for (size_t b = 0; b < batch; ++b) {
+      if (done[b]) {
+        continue;
+      }
+      const int nxt = argmax_vocab_row(logits + b * row_stride, shape[2],
+                                       static_cast<int>(len - 1));
+      if (nxt == static_cast<int>(tab_.eos) ||
+          nxt == static_cast<int>(tab_.phon_pad)) {
+        done[b] = true;
+        --live;
+        continue;
+      }
+      out[b].push_back(nxt);
+      if (len < dec_len) {
+        dec_ids[b * dec_len + len] = nxt;
+      }
     }
-    cur.push_back(nxt);
-    if (static_cast<int>(cur.size()) >= tab_.max_phoneme_len) {
+    if (len + 1 >= dec_len) {
       break;
     }
+    for (size_t b = 0; b < batch; ++b) {
+      dec_mask[b * dec_len + len] = 1;
+    }
   }
+  return out;
+}
 
+std::vector<std::string> OnnxOovG2p::ids_to_phonemes(
+    const std::vector<int64_t>& ids) const {
   std::vector<std::string> out;
-  for (size_t i = 1; i < cur.size(); ++i) {
-    const int64_t tid = cur[i];
+  for (const int64_t tid : ids) {
     if (tid == tab_.eos) {
       break;
     }
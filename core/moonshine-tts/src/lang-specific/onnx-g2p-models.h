@@ -14,6 +14,13 @@
 
 namespace moonshine_tts {
 
+/// Character-to-phoneme model for English words missing from the lexicon.
+///
+/// The export (``model.ort``) has no key/value cache: it is re-run on the
+/// whole decoded prefix at every step. When its ``encoder_input_ids`` and
+/// ``decoder_input_ids`` lengths are dynamic, a batch's characters are padded
+/// only to its longest word and each step feeds only the prefix decoded so
+/// far; otherwise both are padded to ``max_seq_len`` / ``max_phoneme_len``.
 class OnnxOovG2p {
  public:
   OnnxOovG2p(Ort::Env& env, const std::filesystem::path& model_onnx,
@@ -26,9 +33,24 @@ class OnnxOovG2p {
 
   std::vector<std::string> predict_phonemes(const std::string& word);
 
+  /// Phonemes for each of ``words``, decoded together (one model run per
+  /// step for the whole batch) when the export's batch dimension is dynamic.
+  /// Same result as ``predict_phonemes`` on each word.
+  std::vector<std::vector<std::string>> predict_phonemes_batch(
+      const std::vector<std::string>& words);
+
  private:
+  std::vector<std::vector<int64_t>> decode_padded(
+      const std::vector<std::vector<int64_t>>& rows);
+  std::vector<std::string> ids_to_phonemes(
+      const std::vector<int64_t>& ids) const;
+
   OovOnnxTables tab_;
   Ort::Session session_;
+  /// Whether the export accepts more than one row per run.
+  bool padded_batch_dynamic_ = false;
+  /// Whether the export accepts inputs shorter than the config's maximums.
+  bool length_dynamic_ = false;
   Ort::MemoryInfo mem_{
       Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)};
 };
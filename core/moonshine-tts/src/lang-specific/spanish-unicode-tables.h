@@ -3,19 +3,50 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <utility>
 
 namespace moonshine_tts::spanish_unicode {
 
-// Definitions in spanish_unicode_tables.cpp (generated Unicode data).
-extern const std::pair<char32_t, const char*> k_unicode_strip_table[];
-extern const std::size_t k_unicode_strip_table_size;
-extern const std::pair<char32_t, const char*> k_unicode_lower_table[];
-extern const std::size_t k_unicode_lower_table_size;
-extern const std::uint32_t k_unicode_word_bitmap[];
-extern const std::uint32_t k_unicode_word_bitmap_words;
-extern const std::uint32_t k_unicode_space_bitmap[];
-extern const std::uint32_t k_unicode_space_bitmap_words;
+// Definitions in spanish-unicode-tables.cpp, generated by
+// scripts/generate-spanish-unicode-tables.py (which must agree with the
+// constants and integer widths here).
+//
+// A codepoint's properties are found in two steps: k_unicode_stage1 maps its
+// block (cp >> k_unicode_block_shift) to a stored block of k_unicode_stage2,
+// whose entry for the codepoint indexes k_unicode_props. Identical blocks are
+// stored once, and record 0 is the codepoint with no properties.
+
+inline constexpr char32_t k_unicode_table_limit = 0x110000;
+inline constexpr unsigned k_unicode_block_shift = 7;
+inline constexpr std::size_t k_unicode_block_size = std::size_t{1}
+                                                    << k_unicode_block_shift;
+
+enum UnicodePropFlags : std::uint8_t {
+  /// Python ``re`` ``\w``.
+  kUnicodeWord = 1,
+  /// Python ``str.isspace()``.
+  kUnicodeSpace = 2,
+  /// ``str.lower()`` changes the codepoint; see ``lower_offset``.
+  kUnicodeHasLower = 4,
+  /// Removing nonspacing marks after NFD changes the codepoint (possibly to
+  /// nothing); see ``strip_offset``. Hangul syllables are decomposed in code
+  /// and never set this.
+  kUnicodeHasStrip = 8,
+};
+
+/// Replacements are UTF-8 byte ranges of k_unicode_strings.
+struct UnicodeProps {
+  std::uint16_t lower_offset;
+  std::uint16_t strip_offset;
+  std::uint8_t lower_length;
+  std::uint8_t strip_length;
+  std::uint8_t flags;
+};
+
+extern const std::uint8_t
+    k_unicode_stage1[k_unicode_table_limit >> k_unicode_block_shift];
+extern const std::uint16_t k_unicode_stage2[];
+extern const UnicodeProps k_unicode_props[];
+extern const char k_unicode_strings[];
 
 }  // namespace moonshine_tts::spanish_unicode
 
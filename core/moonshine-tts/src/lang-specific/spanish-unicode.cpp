@@ -1,7 +1,8 @@
 #include "spanish-unicode.h"
 
-#include <algorithm>
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 #include "spanish-unicode-tables.h"
 #include "utf8-utils.h"
@@ -9,30 +10,49 @@
 namespace moonshine_tts::spanish_unicode {
 namespace {
 
-const char* lookup_sorted_pair(const std::pair<char32_t, const char*>* table,
-                               size_t n, char32_t key) {
-  const auto* first = table;
-  const auto* last = table + n;
-  const auto* it =
-      std::lower_bound(first, last, key,
-                       [](const std::pair<char32_t, const char*>& e,
-                          char32_t k) { return e.first < k; });
-  if (it != last && it->first == key) {
-    return it->second;
+// Hangul syllables decompose arithmetically into conjoining jamo (Unicode
+// 3.12), which is far smaller than listing all 11172 of them.
+constexpr char32_t kHangulFirst = 0xAC00;
+constexpr char32_t kHangulCount = 11172;
+constexpr char32_t kHangulVowelCount = 21;
+constexpr char32_t kHangulTrailingCount = 28;
+
+const UnicodeProps& props_of(char32_t cp) {
+  if (cp >= k_unicode_table_limit) {
+    return k_unicode_props[0];
   }
-  return nullptr;
+  const std::size_t block = k_unicode_stage1[cp >> k_unicode_block_shift];
+  return k_unicode_props[k_unicode_stage2[block * k_unicode_block_size +
+                                          (cp & (k_unicode_block_size - 1))]];
 }
 
-bool unicode_bitmap_get(const std::uint32_t* bitmap, std::uint32_t nwords,
-                        char32_t cp) {
-  if (cp >= 0x110000) {
-    return false;
+std::string_view lower_of(const UnicodeProps& p) {
+  return {k_unicode_strings + p.lower_offset, p.lower_length};
+}
+
+bool append_stripped(char32_t cp, const UnicodeProps& p, std::string& out) {
+  if (cp >= kHangulFirst && cp - kHangulFirst < kHangulCount) {
+    const char32_t s = cp - kHangulFirst;
+    const char32_t per_leading = kHangulVowelCount * kHangulTrailingCount;
+    utf8_append_codepoint(out, 0x1100 + s / per_leading);
+    utf8_append_codepoint(
+        out, 0x1161 + (s % per_leading) / kHangulTrailingCount);
+    if (s % kHangulTrailingCount != 0) {
+      utf8_append_codepoint(out, 0x11A7 + s % kHangulTrailingCount);
+    }
+    return true;
   }
-  const std::uint32_t wi = static_cast<std::uint32_t>(cp) / 32u;
-  if (wi >= nwords) {
+  if ((p.flags & kUnicodeHasStrip) == 0) {
     return false;
   }
-  return (bitmap[wi] & (1u << (static_cast<std::uint32_t>(cp) % 32u))) != 0u;
+  out.append(k_unicode_strings + p.strip_offset, p.strip_length);
+  return true;
+}
+
+void append_stripped_or_self(char32_t cp, std::string& out) {
+  if (!append_stripped(cp, props_of(cp), out)) {
+    utf8_append_codepoint(out, cp);
+  }
 }
 
 }  // namespace
@@ -52,18 +72,13 @@ std::u32string utf8_to_utf32(const std::string& s) {
 
 std::string unicode_lower_utf8(const std::string& s) {
   std::string out;
+  out.reserve(s.size());
   size_t i = 0;
   while (i < s.size()) {
     char32_t cp = 0;
     size_t adv = 0;
     utf8_decode_at(s, i, cp, adv);
-    const char* rep = lookup_sorted_pair(k_unicode_lower_table,
-                                         k_unicode_lower_table_size, cp);
-    if (rep != nullptr) {
-      out += rep;
-    } else {
-      utf8_append_codepoint(out, cp);
-    }
+    append_lower_utf8(cp, out);
     i += adv;
   }
   return out;
@@ -71,40 +86,79 @@ std::string unicode_lower_utf8(const std::string& s) {
 
 std::string strip_accents_utf8(const std::string& s) {
   std::string out;
+  out.reserve(s.size());
   size_t i = 0;
   while (i < s.size()) {
     char32_t cp = 0;
     size_t adv = 0;
     utf8_decode_at(s, i, cp, adv);
-    const char* rep = lookup_sorted_pair(k_unicode_strip_table,
-                                         k_unicode_strip_table_size, cp);
-    if (rep != nullptr) {
-      out += rep;
-    } else {
-      utf8_append_codepoint(out, cp);
-    }
+    append_stripped_or_self(cp, out);
     i += adv;
   }
   return out;
 }
 
 std::string word_key(const std::string& wraw) {
-  return strip_accents_utf8(unicode_lower_utf8(wraw));
+  std::string out;
+  word_key_into(wraw, out);
+  return out;
+}
+
+void word_key_into(std::string_view wraw, std::string& out) {
+  out.clear();
+  size_t i = 0;
+  while (i < wraw.size()) {
+    const unsigned char c = static_cast<unsigned char>(wraw[i]);
+    if (c < 0x80) {
+      // ASCII only lower-cases A-Z and has no accents (the generator checks).
+      out.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a')
+                                         : static_cast<char>(c));
+      ++i;
+      continue;
+    }
+    char32_t cp = 0;
+    size_t adv = 0;
+    utf8_decode_at(wraw, i, cp, adv);
+    i += adv;
+    const UnicodeProps& p = props_of(cp);
+    if ((p.flags & kUnicodeHasLower) == 0) {
+      if (!append_stripped(cp, p, out)) {
+        utf8_append_codepoint(out, cp);
+      }
+      continue;
+    }
+    // The lower-case form may be several codepoints; strip each of them.
+    const std::string_view lower = lower_of(p);
+    size_t j = 0;
+    while (j < lower.size()) {
+      char32_t lcp = 0;
+      size_t ladv = 0;
+      utf8_decode_at(lower, j, lcp, ladv);
+      append_stripped_or_self(lcp, out);
+      j += ladv;
+    }
+  }
 }
 
 bool is_word_char(char32_t cp) {
-  return unicode_bitmap_get(k_unicode_word_bitmap, k_unicode_word_bitmap_words,
-                            cp);
+  return (props_of(cp).flags & kUnicodeWord) != 0;
 }
 
 bool is_space_char(char32_t cp) {
-  return unicode_bitmap_get(k_unicode_space_bitmap,
-                            k_unicode_space_bitmap_words, cp);
+  return (props_of(cp).flags & kUnicodeSpace) != 0;
+}
+
+void append_lower_utf8(char32_t cp, std::string& out) {
+  const UnicodeProps& p = props_of(cp);
+  if ((p.flags & kUnicodeHasLower) != 0) {
+    out += lower_of(p);
+  } else {
+    utf8_append_codepoint(out, cp);
+  }
 }
 
-const char* strip_replacement_utf8(char32_t cp) {
-  return lookup_sorted_pair(k_unicode_strip_table, k_unicode_strip_table_size,
-                            cp);
+bool append_strip_replacement_utf8(char32_t cp, std::string& out) {
+  return append_stripped(cp, props_of(cp), out);
 }
 
 }  // namespace moonshine_tts::spanish_unicode
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace moonshine_tts::spanish_unicode {
 
@@ -11,10 +12,17 @@ std::u32string utf8_to_utf32(const std::string& s);
 std::string unicode_lower_utf8(const std::string& s);
 std::string strip_accents_utf8(const std::string& s);
 std::string word_key(const std::string& wraw);
+/// Writes ``word_key(wraw)`` to ``out`` (cleared first) in one pass without
+/// temporaries, so a buffer reused across words stops allocating once it has
+/// grown to the longest key.
+void word_key_into(std::string_view wraw, std::string& out);
 bool is_word_char(char32_t cp);
 bool is_space_char(char32_t cp);
-/// UTF-8 replacement from the strip table, or nullptr when absent.
-const char* strip_replacement_utf8(char32_t cp);
+/// Appends the lower-case form of ``cp`` (Python ``str.lower``) to ``out``.
+void append_lower_utf8(char32_t cp, std::string& out);
+/// Appends ``cp`` with its accents stripped to ``out`` and returns true, or
+/// returns false (leaving ``out`` alone) when stripping does not change it.
+bool append_strip_replacement_utf8(char32_t cp, std::string& out);
 
 }  // namespace moonshine_tts::spanish_unicode
 
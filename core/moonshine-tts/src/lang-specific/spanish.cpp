@@ -53,13 +53,12 @@ bool should_hiatus(char32_t a, char32_t b) {
     return true;
   }
   auto strip_one = [](char32_t c) -> char32_t {
-    const char *r = spanish_unicode::strip_replacement_utf8(c);
-    if (r == nullptr || *r == '\0') {
+    std::string tmp;
+    if (!spanish_unicode::append_strip_replacement_utf8(c, tmp)) {
       return c;
     }
     char32_t o = 0;
     size_t adv = 0;
-    std::string tmp(r);
     if (!tmp.empty() && utf8_decode_at(tmp, 0, o, adv) && adv == tmp.size()) {
       return o;
     }
@@ -494,11 +493,11 @@ bool y_is_consonant(const std::u32string &letters_lower, size_t i) {
 }
 
 char32_t to_lower_cp(char32_t c) {
-  std::string tmp;
-  utf8_append_codepoint(tmp, c);
-  const std::string lo = spanish_unicode::unicode_lower_utf8(tmp);
-  const std::u32string u = spanish_unicode::utf8_to_utf32(lo);
-  return u.empty() ? c : u.front();
+  std::string lo;
+  spanish_unicode::append_lower_utf8(c, lo);
+  char32_t o = 0;
+  size_t adv = 0;
+  return utf8_decode_at(lo, 0, o, adv) ? o : c;
 }
 
 std::string letters_to_ipa_no_stress(const std::u32string &syl_lower,
@@ -1003,6 +1002,7 @@ std::string SpanishRuleG2p::word_to_ipa(const std::string &word) const {
 std::string SpanishRuleG2p::text_to_ipa_no_expand(
     const std::string &text, std::vector<G2pWordLog> *per_word_log) const {
   std::string out;
+  std::string k;
   size_t pos = 0;
   const size_t n = text.size();
   while (pos < n) {
@@ -1031,7 +1031,7 @@ std::string SpanishRuleG2p::text_to_ipa_no_expand(
         pos += adv;
       }
       const std::string tok = text.substr(start, pos - start);
-      const std::string k = spanish_unicode::word_key(tok);
+      spanish_unicode::word_key_into(tok, k);
       const char *exc = lookup_x_exception(k);
       std::string wipa;
       if (exc != nullptr) {
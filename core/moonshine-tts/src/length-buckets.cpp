@@ -0,0 +1,88 @@
+#include "length-buckets.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace moonshine_tts {
+
+std::vector<std::vector<size_t>> plan_length_buckets(
+    const std::vector<size_t>& lengths, const LengthBucketLimits& limits) {
+  std::vector<size_t> order(lengths.size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return lengths[a] > lengths[b];
+  });
+
+  std::vector<std::vector<size_t>> batches;
+  size_t padded_length = 0;
+  for (const size_t i : order) {
+    const size_t len = lengths[i];
+    if (!batches.empty()) {
+      std::vector<size_t>& batch = batches.back();
+      const bool fits =
+          batch.size() < limits.max_rows &&
+          (batch.size() + 1) * padded_length <= limits.max_tokens &&
+          static_cast<double>(padded_length) <=
+              static_cast<double>(len) * limits.max_padding_ratio +
+                  static_cast<double>(limits.padding_slack);
+      if (fits) {
+        batch.push_back(i);
+        continue;
+      }
+    }
+    batches.push_back({i});
+    padded_length = len;
+  }
+  return batches;
+}
+
+std::vector<std::vector<float>> run_padded_batches(
+    const std::vector<std::vector<int64_t>>& sequences, int64_t pad_id,
+    size_t num_labels, size_t min_length, const LengthBucketLimits& limits,
+    const PaddedBatchRunner& run) {
+  std::vector<size_t> lengths;
+  lengths.reserve(sequences.size());
+  for (const std::vector<int64_t>& seq : sequences) {
+    lengths.push_back(std::max(seq.size(), min_length));
+  }
+
+  std::vector<std::vector<float>> out(sequences.size());
+  std::vector<int64_t> ids;
+  std::vector<int64_t> mask;
+  std::vector<float> logits;
+  for (const std::vector<size_t>& batch :
+       plan_length_buckets(lengths, limits)) {
+    const size_t padded = lengths[batch.front()];
+    if (padded == 0) {
+      continue;
+    }
+    ids.assign(batch.size() * padded, pad_id);
+    mask.assign(ids.size(), 0);
+    for (size_t r = 0; r < batch.size(); ++r) {
+      const std::vector<int64_t>& seq = sequences[batch[r]];
+      const size_t row = r * padded;
+      for (size_t t = 0; t < seq.size(); ++t) {
+        ids[row + t] = seq[t];
+        mask[row + t] = seq[t] != pad_id ? 1 : 0;
+      }
+    }
+    logits.clear();
+    run(ids, mask, static_cast<int64_t>(batch.size()),
+        static_cast<int64_t>(padded), logits);
+    if (logits.size() != ids.size() * num_labels) {
+      throw std::runtime_error("run_padded_batches: runner returned " +
+                               std::to_string(logits.size()) +
+                               " logits, expected " +
+                               std::to_string(ids.size() * num_labels));
+    }
+    for (size_t r = 0; r < batch.size(); ++r) {
+      const float* row = logits.data() + r * padded * num_labels;
+      out[batch[r]].assign(row, row + sequences[batch[r]].size() * num_labels);
+    }
+  }
+  return out;
+}
+
+}  // namespace moonshine_tts
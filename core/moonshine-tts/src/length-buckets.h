@@ -0,0 +1,52 @@
+#ifndef MOONSHINE_TTS_LENGTH_BUCKETS_H
+#define MOONSHINE_TTS_LENGTH_BUCKETS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace moonshine_tts {
+
+/// Limits on one padded batch of variable-length sequences.
+struct LengthBucketLimits {
+  size_t max_rows = 16;
+  /// Cap on rows x padded length, i.e. the tokens one model run processes.
+  size_t max_tokens = 2048;
+  /// A sequence joins a batch only while the batch's padded length is at
+  /// most ``max_padding_ratio`` times its own length plus ``padding_slack``
+  /// tokens, so short sequences are not padded out to long ones.
+  double max_padding_ratio = 1.25;
+  size_t padding_slack = 8;
+};
+
+/// Groups the indices of ``lengths`` into batches for padded inference.
+/// Sequences are taken longest first, so each batch is padded to its first
+/// member's length, and a batch is closed as soon as the next sequence would
+/// break a limit in ``limits``. Every index lands in exactly one batch; a
+/// sequence longer than ``max_tokens`` gets a batch of its own. Equal lengths
+/// keep their input order.
+std::vector<std::vector<size_t>> plan_length_buckets(
+    const std::vector<size_t>& lengths, const LengthBucketLimits& limits = {});
+
+/// Runs one padded batch of a token classifier. ``ids`` and ``mask`` are
+/// ``[rows, padded]``, row-major; the runner fills ``logits`` with the
+/// ``[rows, padded, num_labels]`` output.
+using PaddedBatchRunner = std::function<void(
+    const std::vector<int64_t>& ids, const std::vector<int64_t>& mask,
+    int64_t rows, int64_t padded, std::vector<float>& logits)>;
+
+/// Runs a token classifier over every entry of ``sequences`` in the batches
+/// ``plan_length_buckets`` picks, and returns each one's logits (``size() *
+/// num_labels`` floats) in input order. Rows are padded with ``pad_id`` to
+/// their batch's longest member, and to at least ``min_length``; the mask is
+/// 0 for every ``pad_id`` token. Throws ``std::runtime_error`` when ``run``
+/// returns the wrong number of logits.
+std::vector<std::vector<float>> run_padded_batches(
+    const std::vector<std::vector<int64_t>>& sequences, int64_t pad_id,
+    size_t num_labels, size_t min_length, const LengthBucketLimits& limits,
+    const PaddedBatchRunner& run);
+
+}  // namespace moonshine_tts
+
+#endif  // MOONSHINE_TTS_LENGTH_BUCKETS_H
@@ -0,0 +1,78 @@
+#include "linear-resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace moonshine_tts {
+
+std::vector<float> resample_linear(const std::vector<float>& x, int src_sr,
+                                   int dst_sr) {
+  if (src_sr == dst_sr || x.size() < 2) {
+    return x;
+  }
+  const double duration =
+      static_cast<double>(x.size() - 1) / static_cast<double>(src_sr);
+  const size_t n_out = std::max<size_t>(
+      2, static_cast<size_t>(std::llround(duration * dst_sr)) + 1);
+  std::vector<float> y(n_out);
+  for (size_t i = 0; i < n_out; ++i) {
+    const double t =
+        static_cast<double>(i) * duration / static_cast<double>(n_out - 1);
+    const double fidx = t * static_cast<double>(src_sr);
+    const size_t i0 = static_cast<size_t>(std::floor(fidx));
+    const size_t i1 = std::min(i0 + 1, x.size() - 1);
+    const double frac = fidx - static_cast<double>(i0);
+    y[i] = static_cast<float>(x[i0] * (1.0 - frac) + x[i1] * frac);
+  }
+  return y;
+}
+
+StreamingLinearResampler::StreamingLinearResampler(int src_sr, int dst_sr)
+    : src_sr_(src_sr), dst_sr_(dst_sr) {
+  if (src_sr <= 0 || dst_sr <= 0) {
+    throw std::runtime_error("StreamingLinearResampler: invalid sample rates");
+  }
+}
+
+void StreamingLinearResampler::process(const std::vector<float>& chunk,
+                                       std::vector<float>& out) {
+  if (chunk.empty()) {
+    return;
+  }
+  if (src_sr_ == dst_sr_) {
+    out.insert(out.end(), chunk.begin(), chunk.end());
+    return;
+  }
+  // Input index ``consumed_ - 1`` is the previous chunk's last sample.
+  const auto sample = [&](int64_t i) {
+    return i < consumed_ ? last_ : chunk[static_cast<size_t>(i - consumed_)];
+  };
+  const int64_t end = consumed_ + static_cast<int64_t>(chunk.size());
+  for (;;) {
+    const int64_t i0 = next_pos() / dst_sr_;
+    if (i0 + 1 >= end) {
+      break;
+    }
+    const double frac = static_cast<double>(next_pos() % dst_sr_) /
+                        static_cast<double>(dst_sr_);
+    out.push_back(static_cast<float>(sample(i0) * (1.0 - frac) +
+                                     sample(i0 + 1) * frac));
+    ++next_out_;
+  }
+  consumed_ = end;
+  last_ = chunk.back();
+}
+
+void StreamingLinearResampler::flush(std::vector<float>& out) {
+  if (src_sr_ == dst_sr_ || consumed_ == 0) {
+    return;
+  }
+  if (next_pos() == (consumed_ - 1) * dst_sr_) {
+    out.push_back(last_);
+    ++next_out_;
+  }
+}
+
+}  // namespace moonshine_tts
@@ -0,0 +1,42 @@
+#ifndef MOONSHINE_TTS_LINEAR_RESAMPLE_H
+#define MOONSHINE_TTS_LINEAR_RESAMPLE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace moonshine_tts {
+
+/// Resamples ``x`` from ``src_sr`` to ``dst_sr`` Hz by linear interpolation,
+/// keeping the first and last samples at the ends of the output. Input of
+/// fewer than two samples, or at equal rates, is returned unchanged.
+std::vector<float> resample_linear(const std::vector<float>& x, int src_sr,
+                                   int dst_sr);
+
+/// Linear-interpolation resampler for audio delivered chunk by chunk. The
+/// last input sample and the output position carry over between calls, so
+/// the samples either side of a chunk boundary are interpolated like any
+/// others and splitting the input doesn't change the output.
+class StreamingLinearResampler {
+ public:
+  StreamingLinearResampler(int src_sr, int dst_sr);
+
+  /// Appends the output samples that ``chunk`` completes to ``out``.
+  void process(const std::vector<float>& chunk, std::vector<float>& out);
+  /// Appends the output that falls on the final input sample, if any. Call
+  /// once after the last chunk.
+  void flush(std::vector<float>& out);
+
+ private:
+  /// Input index (times ``dst_sr_``) of the next output sample.
+  int64_t next_pos() const { return next_out_ * src_sr_; }
+
+  int64_t src_sr_;
+  int64_t dst_sr_;
+  int64_t next_out_ = 0;
+  int64_t consumed_ = 0;
+  float last_ = 0.F;
+};
+
+}  // namespace moonshine_tts
+
+#endif  // MOONSHINE_TTS_LINEAR_RESAMPLE_H
@@ -101,6 +101,11 @@ bool is_known_g2p_option(std::string_view key) {
       "oov_onnx_config",
       "allow_builtin_g2p_data",
       "log_profiling",
+      "g2p_cache_bytes",
+      "pronunciation_cache_bytes",
+      "g2p_cache_file",
+      "pronunciation_cache_file",
+      "g2p_threads",
   };
   return kKnown.find(std::string(key)) != kKnown.end();
 }
@@ -311,6 +316,13 @@ void MoonshineG2POptions::parse_options(
       (void)v;
     } else if (key == "log_profiling") {
       log_profiling = bool_from_string(v);
+    } else if (key == "g2p_cache_bytes" ||
+               key == "pronunciation_cache_bytes") {
+      pronunciation_cache_bytes = size_t_from_string(trim(value));
+    } else if (key == "g2p_cache_file" || key == "pronunciation_cache_file") {
+      pronunciation_cache_file = std::filesystem::path(trim(value));
+    } else if (key == "g2p_threads") {
+      g2p_threads = size_t_from_string(trim(value));
     } else {
       throw std::logic_error(
           "MoonshineG2POptions::parse_options: unhandled option '" + name +
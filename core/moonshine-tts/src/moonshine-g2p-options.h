@@ -177,6 +177,20 @@ struct MoonshineG2POptions {
 
   FileInformationMap files;
 
+  /// Byte cap the process-wide word pronunciation cache
+  /// (``G2pPronunciationCache::global``) is raised to; 0 leaves it alone.
+  size_t pronunciation_cache_bytes = size_t{16} << 20;
+  /// If set, the cache is filled from this file when the first G2P using it
+  /// is created, and written back when such a G2P is destroyed with entries
+  /// not yet saved, and at process exit.
+  std::filesystem::path pronunciation_cache_file{};
+
+  /// Threads ``MoonshineG2P`` converts with, each on its own engine instance
+  /// (so its own ONNX sessions). Above 1, multi-sentence input is split at
+  /// sentence boundaries and the sentences are converted in parallel; 0 uses
+  /// one thread per hardware thread.
+  size_t g2p_threads = 1;
+
   /// Relative path (under ``g2p_root``) for a bundled asset. If ``files`` has
   /// no entry for
   /// ``canonical_key``, returns ``std::filesystem::path(canonical_key)``.
@@ -1,7 +1,12 @@
 #include "moonshine-g2p.h"
 
+#include <algorithm>
 #include <cctype>
+#include <cstdint>
+#include <iterator>
 #include <stdexcept>
+#include <string_view>
+#include <thread>
 
 #include "arabic.h"
 #include "chinese.h"
@@ -9,6 +14,7 @@
 #include "dutch.h"
 #include "english.h"
 #include "french.h"
+#include "g2p-parallel.h"
 #include "german.h"
 #include "hindi.h"
 #include "italian.h"
@@ -19,6 +25,7 @@
 #include "rule-based-g2p.h"
 #include "russian.h"
 #include "spanish.h"
+#include "tts-pipeline.h"
 #include "turkish.h"
 #include "ukrainian.h"
 #include "utf8-utils.h"
@@ -103,6 +110,56 @@ const char* rule_backend_name(RuleBasedG2pKind k) {
   return "Unknown";
 }
 
+/// FNV-1a, so a scope id means the same in every process that reads a saved
+/// cache file.
+uint64_t fnv1a(std::string_view bytes,
+               uint64_t h = 14695981039346656037ull) {
+  for (const char c : bytes) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+/// Id of what a cached pronunciation depends on besides the word: the
+/// dialect, the data files (by path, or by size and content when supplied in
+/// memory) and every output-affecting flag.
+uint64_t pronunciation_cache_scope(const std::string& dialect_id,
+                                   const MoonshineG2POptions& o) {
+  std::string scope = dialect_id + "|" + o.g2p_root.generic_string();
+  for (const auto& [key, fi] : o.files.entries) {
+    scope += "|" + key + "=";
+    if (fi.has_memory()) {
+      const std::string_view bytes(
+          static_cast<const char*>(static_cast<const void*>(fi.memory)),
+          fi.memory_size);
+      scope += "mem:" + std::to_string(fi.memory_size) + ":" +
+               std::to_string(fnv1a(bytes));
+    } else {
+      scope += fi.path.generic_string();
+    }
+  }
+  scope += "|";
+  for (const bool flag :
+       {o.spanish_with_stress, o.spanish_narrow_obstruents,
+        o.german_with_stress, o.german_vocoder_stress, o.french_with_stress,
+        o.french_liaison, o.french_liaison_optional, o.french_oov_rules,
+        o.french_expand_cardinal_digits, o.dutch_with_stress,
+        o.dutch_vocoder_stress, o.dutch_expand_cardinal_digits,
+        o.italian_with_stress, o.italian_vocoder_stress,
+        o.italian_expand_cardinal_digits, o.russian_with_stress,
+        o.russian_vocoder_stress, o.korean_expand_cardinal_digits,
+        o.portuguese_with_stress, o.portuguese_vocoder_stress,
+        o.portuguese_keep_syllable_dots, o.portuguese_expand_cardinal_digits,
+        o.portuguese_apply_pt_pt_final_esh, o.turkish_with_stress,
+        o.turkish_expand_cardinal_digits, o.ukrainian_with_stress,
+        o.ukrainian_expand_cardinal_digits, o.hindi_with_stress,
+        o.hindi_expand_cardinal_digits}) {
+    scope += flag ? '1' : '0';
+  }
+  return fnv1a(scope);
+}
+
 }  // namespace
 
 bool dialect_resolves_to_spanish_rules(std::string_view dialect_id,
@@ -178,7 +235,18 @@ bool dialect_uses_rule_based_g2p(std::string_view dialect_id,
   return false;
 }
 
-MoonshineG2P::~MoonshineG2P() = default;
+MoonshineG2P::~MoonshineG2P() {
+  if (pronunciation_cache_file_.empty()) {
+    return;
+  }
+  // Skipped when nothing was added since the file was last written. Entries
+  // added after this are written at process exit.
+  try {
+    G2pPronunciationCache::global().save_if_changed(pronunciation_cache_file_);
+  } catch (const std::exception& e) {
+    LOGF("MoonshineG2P: could not save pronunciation cache: %s", e.what());
+  }
+}
 
 MoonshineG2P::MoonshineG2P(MoonshineG2P&&) noexcept = default;
 MoonshineG2P& MoonshineG2P::operator=(MoonshineG2P&&) noexcept = default;
@@ -200,8 +268,36 @@ MoonshineG2P::MoonshineG2P(std::string dialect_id,
     dialect_id_ = std::move(rb->canonical_dialect_id);
     rules_ = std::move(rb->engine);
     rule_backend_ = rb->kind;
-    LOGF_IF(log_profiling_, "MoonshineG2P: dialect='%s', rule backend=%s",
-            dialect_id_.c_str(), rule_backend_name(rb->kind));
+    size_t threads = options.g2p_threads;
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Built now rather than on first use: client-supplied asset buffers in
+    // ``options`` only have to outlive the constructor.
+    for (size_t i = 1; i < threads; ++i) {
+      auto worker = create_rule_based_g2p(norm, options);
+      if (!worker) {
+        throw std::logic_error("MoonshineG2P: worker engine not created");
+      }
+      worker_rules_.push_back(std::move(worker->engine));
+    }
+    if (options.pronunciation_cache_bytes > 0) {
+      G2pPronunciationCache& cache = G2pPronunciationCache::global();
+      cache.reserve_capacity(options.pronunciation_cache_bytes);
+      if (!options.pronunciation_cache_file.empty()) {
+        pronunciation_cache_file_ = options.pronunciation_cache_file;
+        cache.load_once(pronunciation_cache_file_);
+        cache.persist_to(pronunciation_cache_file_);
+      }
+      const uint64_t scope = pronunciation_cache_scope(dialect_id_, options);
+      rules_->set_pronunciation_cache(&cache, scope);
+      for (const auto& worker : worker_rules_) {
+        worker->set_pronunciation_cache(&cache, scope);
+      }
+    }
+    LOGF_IF(log_profiling_,
+            "MoonshineG2P: dialect='%s', rule backend=%s, threads=%zu",
+            dialect_id_.c_str(), rule_backend_name(rb->kind), threads);
     TIMER_END_IF(log_profiling_, g2p_init);
     return;
   }
@@ -218,17 +314,66 @@ std::string MoonshineG2P::text_to_ipa(std::string_view text,
                                       std::vector<G2pWordLog>* per_word_log) {
   TIMER_START_IF(log_profiling_, g2p_text_to_ipa);
   if (rules_) {
-    std::string result = rules_->text_to_ipa(std::string(text), per_word_log);
+    std::vector<std::string> sentences;
+    if (!worker_rules_.empty()) {
+      sentences = split_text_for_g2p_pipeline(text);
+    }
+    std::string result;
+    if (sentences.size() > 1) {
+      std::vector<std::vector<G2pWordLog>> logs;
+      result = join_sentence_ipa(texts_to_ipa_parallel(
+          engines(), sentences, per_word_log != nullptr ? &logs : nullptr));
+      if (per_word_log != nullptr) {
+        for (auto& log : logs) {
+          per_word_log->insert(per_word_log->end(),
+                               std::make_move_iterator(log.begin()),
+                               std::make_move_iterator(log.end()));
+        }
+      }
+    } else {
+      result = rules_->text_to_ipa(std::string(text), per_word_log);
+    }
     LOGF_IF(log_profiling_, "MoonshineG2P: text_to_ipa input='%.*s'%s",
             (int)std::min(text.size(), (size_t)200), text.data(),
             text.size() > 200 ? "..." : "");
     LOGF_IF(log_profiling_, "MoonshineG2P: text_to_ipa IPA output='%.*s'%s",
             (int)std::min(result.size(), (size_t)500), result.c_str(),
             result.size() > 500 ? "..." : "");
+    if (log_profiling_) {
+      const G2pPronunciationCacheStats cs = pronunciation_cache_stats();
+      LOGF("MoonshineG2P: pronunciation cache %llu hits, %llu misses, "
+           "%zu entries (%zu / %zu bytes)",
+           static_cast<unsigned long long>(cs.hits),
+           static_cast<unsigned long long>(cs.misses), cs.entries, cs.bytes,
+           cs.capacity_bytes);
+    }
     TIMER_END_IF(log_profiling_, g2p_text_to_ipa);
     return result;
   }
   throw std::logic_error("MoonshineG2P: no backend initialized");
 }
 
+std::vector<std::string> MoonshineG2P::texts_to_ipa(
+    const std::vector<std::string>& texts) {
+  if (!rules_) {
+    throw std::logic_error("MoonshineG2P: no backend initialized");
+  }
+  TIMER_START_IF(log_profiling_, g2p_texts_to_ipa);
+  std::vector<std::string> result = texts_to_ipa_parallel(engines(), texts);
+  LOGF_IF(log_profiling_, "MoonshineG2P: texts_to_ipa %zu texts on %zu threads",
+          texts.size(), threads());
+  TIMER_END_IF(log_profiling_, g2p_texts_to_ipa);
+  return result;
+}
+
+std::vector<RuleBasedG2p*> MoonshineG2P::engines() const {
+  std::vector<RuleBasedG2p*> out;
+  out.reserve(threads());
+  out.push_back(rules_.get());
+  for (const auto& worker : worker_rules_) {
+    out.push_back(worker.get());
+  }
+  return out;
+}
+
 }  // namespace moonshine_tts
@@ -7,6 +7,7 @@
 #include <string_view>
 #include <vector>
 
+#include "g2p-pronunciation-cache.h"
 #include "g2p-word-log.h"
 #include "moonshine-g2p-options.h"
 #include "rule-based-g2p-factory.h"
@@ -42,9 +43,20 @@ class MoonshineG2P {
   MoonshineG2P(MoonshineG2P&&) noexcept;
   MoonshineG2P& operator=(MoonshineG2P&&) noexcept;
 
+  /// With ``g2p_threads`` above 1 and more than one sentence in ``text``
+  /// (``split_text_for_g2p_pipeline``), the sentences are converted in
+  /// parallel and their IPA joined with spaces, in order.
   std::string text_to_ipa(std::string_view text,
                           std::vector<G2pWordLog>* per_word_log = nullptr);
 
+  /// Converts each entry of ``texts`` as one ``text_to_ipa`` input (without
+  /// splitting it further), spreading the entries over ``threads()``
+  /// engines. Results are in input order.
+  std::vector<std::string> texts_to_ipa(const std::vector<std::string>& texts);
+
+  /// Number of engine instances conversions are spread over.
+  size_t threads() const { return rules_ ? 1 + worker_rules_.size() : 0; }
+
   bool uses_spanish_rules() const {
     return rule_backend_ == RuleBasedG2pKind::Spanish;
   }
@@ -102,10 +114,21 @@ class MoonshineG2P {
   /// English).
   const std::string& dialect_id() const { return dialect_id_; }
 
+  /// Hit, miss and size counters of the process-wide word pronunciation
+  /// cache shared by all instances (see ``pronunciation_cache_bytes``).
+  static G2pPronunciationCacheStats pronunciation_cache_stats() {
+    return G2pPronunciationCache::global().stats();
+  }
+
  private:
+  std::vector<RuleBasedG2p*> engines() const;
+
   std::string dialect_id_;
   std::unique_ptr<RuleBasedG2p> rules_;
+  /// Extra engines for ``g2p_threads`` > 1, built with the same options.
+  std::vector<std::unique_ptr<RuleBasedG2p>> worker_rules_;
   std::optional<RuleBasedG2pKind> rule_backend_;
+  std::filesystem::path pronunciation_cache_file_;
   bool log_profiling_ = false;
 };
 
@@ -4,11 +4,13 @@
 #include <cmath>
 #include <stdexcept>
 #include <string_view>
+#include <utility>
 
 #include "g2p-path.h"
 #include "ort-model-format.h"
 #include "ort-utils.h"
 #include "string-utils.h"
+#include "utf8-utils.h"
 
 namespace moonshine_tts {
 
@@ -38,6 +40,121 @@ void apply_synthesis_output_effects(std::vector<float>& audio,
   }
 }
 
+namespace {
+
+bool is_clause_punctuation(char32_t c) {
+  switch (c) {
+    case U',':
+    case U'.':
+    case U';':
+    case U':':
+    case U'!':
+    case U'?':
+    case U'\u2026':  // …
+    case U'\u2014':  // —
+    case U'\u3001':  // 、
+    case U'\u3002':  // 。
+    case U'\uFF0C':  // ，
+    case U'\uFF01':  // ！
+    case U'\uFF1F':  // ？
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+std::vector<std::string> split_phonemes_for_streaming(std::string_view phonemes,
+                                                      std::size_t first_max_cp,
+                                                      std::size_t max_cp) {
+  std::vector<std::string> chunks;
+  const std::u32string u = utf8_str_to_u32(std::string(phonemes));
+  max_cp = std::max<std::size_t>(max_cp, 1);
+  std::size_t budget = std::clamp<std::size_t>(first_max_cp, 1, max_cp);
+  std::size_t start = 0;
+  while (start < u.size()) {
+    while (start < u.size() && u[start] == U' ') {
+      ++start;
+    }
+    if (start >= u.size()) {
+      break;
+    }
+    std::size_t end = u.size();
+    if (u.size() - start > budget) {
+      // u[limit] exists here; a cut at i drops the space at u[i].
+      const std::size_t limit = start + budget;
+      std::size_t clause = 0;
+      std::size_t space = 0;
+      for (std::size_t i = limit; i > start; --i) {
+        if (u[i] != U' ') {
+          continue;
+        }
+        if (space == 0) {
+          space = i;
+        }
+        if (is_clause_punctuation(u[i - 1])) {
+          clause = i;
+          break;
+        }
+      }
+      if (clause > start + budget / 2) {
+        end = clause;
+      } else if (space != 0) {
+        end = space;
+      } else {
+        end = limit;
+      }
+    }
+    std::string piece;
+    for (std::size_t i = start; i < end; ++i) {
+      utf8_append_codepoint(piece, u[i]);
+    }
+    piece = trim_ascii_ws_copy(piece);
+    if (!piece.empty()) {
+      chunks.push_back(std::move(piece));
+    }
+    start = end;
+    budget = std::min(max_cp, budget * 2);
+  }
+  return chunks;
+}
+
+void StreamingOutputEffects::apply(std::vector<float>& chunk) {
+  if (normalize_audio_ && !chunk.empty()) {
+    if (gain_ == 0.F) {
+      float peak = 0.F;
+      for (float x : chunk) {
+        peak = std::max(peak, std::fabs(x));
+      }
+      gain_ = peak < 1e-8F ? 0.F : 1.F / peak;
+    }
+    // The limiter gain each sample needs to stay within full scale, then
+    // slew-limited: backwards so it ramps down ahead of a peak, forwards so
+    // it recovers gradually (and carries on from the previous chunk).
+    const size_t n = chunk.size();
+    envelope_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      chunk[i] *= gain_;
+      const float level = std::fabs(chunk[i]);
+      envelope_[i] = level > 1.F ? 1.F / level : 1.F;
+    }
+    for (size_t i = n - 1; i > 0; --i) {
+      envelope_[i - 1] =
+          std::min(envelope_[i - 1], envelope_[i] + kLimiterStep);
+    }
+    envelope_[0] = std::min(envelope_[0], limiter_ + kLimiterStep);
+    for (size_t i = 1; i < n; ++i) {
+      envelope_[i] = std::min(envelope_[i], envelope_[i - 1] + kLimiterStep);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      chunk[i] *= envelope_[i];
+    }
+    limiter_ = envelope_.back();
+  }
+  apply_synthesis_output_effects(chunk, /*normalize_audio=*/false, volume_);
+}
+
 MoonshineTTSOptions::MoonshineTTSOptions() {
   files.set_path(kTtsKokoroModelKey, std::filesystem::path{kTtsKokoroModelKey});
   files.set_path(kTtsKokoroConfigJsonKey,
@@ -179,6 +296,8 @@ void MoonshineTTSOptions::parse_options(
       normalize_audio = bool_from_string(value.c_str());
     } else if (key == "output_volume" || key == "piper_output_volume") {
       output_volume = float_from_string(value.c_str());
+    } else if (key == "pipeline_synthesis" || key == "tts_pipeline") {
+      pipeline_synthesis = bool_from_string(value.c_str());
     } else if (key == "piper_noise_scale" ||
                key == "piper_noise_scale_override") {
       const std::string t = trim(value);
@@ -200,6 +319,9 @@ void MoonshineTTSOptions::parse_options(
         zipvoice_clone_sample_rate =
             static_cast<int>(float_from_string(t.c_str()));
       }
+    } else if (key == "zipvoice_clone_cache_dir" ||
+               key == "clone_cache_dir") {
+      zipvoice_clone_cache_dir = std::filesystem::path(trim(value));
     } else if (key == "zipvoice_model" || key == "zipvoice_model_name") {
       // ``zipvoice`` (full) vs ``zipvoice_distill`` (default). Only changes
       // sampling defaults.
@@ -216,6 +338,13 @@ void MoonshineTTSOptions::parse_options(
       if (!t.empty()) {
         zipvoice_guidance_scale = float_from_string(t.c_str());
       }
+    } else if (key == "zipvoice_max_batch_chunks" ||
+               key == "zipvoice_batch_chunks") {
+      const std::string t = trim(value);
+      if (!t.empty()) {
+        zipvoice_max_batch_chunks =
+            static_cast<int>(float_from_string(t.c_str()));
+      }
     } else if (key == "zipvoice_t_shift" || key == "t_shift") {
       const std::string t = trim(value);
       if (!t.empty()) {
@@ -1,7 +1,10 @@
 #ifndef MOONSHINE_TTS_MOONSHINE_TTS_OPTIONS_H
 #define MOONSHINE_TTS_MOONSHINE_TTS_OPTIONS_H
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -91,6 +94,11 @@ struct MoonshineTTSOptions {
   /// Linear gain applied after ``normalize_audio`` and before clipping to
   /// ``[-1, 1]``. Matches ``piper-tts`` ``SynthesisConfig.volume`` semantics.
   float output_volume = 1.F;
+  /// Overlap text-to-phoneme work on one sentence with model inference on the
+  /// previous one (and, for ZipVoice, flow matching with vocoding) using a
+  /// worker thread. Off (the default) runs every stage serially on the
+  /// calling thread.
+  bool pipeline_synthesis = false;
   std::optional<float> piper_noise_scale_override{};
   std::optional<float> piper_noise_w_override{};
 
@@ -101,10 +109,15 @@ struct MoonshineTTSOptions {
   /// ``clone_sample_rate`` is its sample rate.
   std::string zipvoice_clone_transcript{};
   int zipvoice_clone_sample_rate = 24000;
+  /// ``ZipVoiceTTSOptions::clone_cache_dir``; empty disables the cache.
+  std::filesystem::path zipvoice_clone_cache_dir{};
   bool zipvoice_distill = true;
   int zipvoice_num_step = 0;
   float zipvoice_guidance_scale = -1.F;
   float zipvoice_t_shift = 0.5F;
+  /// Chunks per batched flow-matching / vocoder call
+  /// (``ZipVoiceTTSOptions::max_batch_chunks``).
+  int zipvoice_max_batch_chunks = 1;
 
   /// Default WAV path for CLI-style tooling (``-o`` / ``output`` in
   /// ``parse_options``).
@@ -153,6 +166,55 @@ struct MoonshineTTSOptions {
 void apply_synthesis_output_effects(std::vector<float>& audio,
                                     bool normalize_audio, float volume);
 
+/// Receives consecutive mono float PCM at 24 kHz from the streaming synthesis
+/// entry points, one call per vocoded chunk. ``samples`` is only valid for the
+/// duration of the call. Return ``false`` to stop synthesis after this chunk.
+using TtsAudioChunkCallback =
+    std::function<bool(const float* samples, std::size_t sample_count)>;
+
+/// Phoneme budget (IPA code points or engine tokens) of the first streamed
+/// chunk. Each later chunk may be up to twice as long as the one before it,
+/// capped by the engine's own limit, so it is vocoded while the previous one
+/// plays.
+inline constexpr std::size_t kTtsStreamFirstChunkPhonemes = 40;
+
+/// Splits a normalized phoneme string into streaming chunks following the
+/// ``kTtsStreamFirstChunkPhonemes`` growth rule, starting at ``first_max_cp``
+/// code points and never exceeding ``max_cp``. Cuts prefer a space after
+/// clause punctuation, then any space, and only split a word when there is no
+/// space in the window. Chunks are trimmed; empty ones are dropped.
+std::vector<std::string> split_phonemes_for_streaming(std::string_view phonemes,
+                                                      std::size_t first_max_cp,
+                                                      std::size_t max_cp);
+
+/// ``apply_synthesis_output_effects`` for audio delivered chunk by chunk. The
+/// final peak is unknown until the last chunk, so normalization fixes its
+/// gain from the first chunk that isn't silent: that chunk is scaled exactly
+/// as the batch path would scale a one-chunk utterance, and every later chunk
+/// gets the same gain, so the level never drops partway through. Where a
+/// louder later chunk would pass full scale, a limiter lowers the gain just
+/// around those samples, ramping down before them and back up after, rather
+/// than clipping them or turning down the rest of the utterance.
+class StreamingOutputEffects {
+ public:
+  /// Largest change in limiter gain from one sample to the next.
+  static constexpr float kLimiterStep = 1.F / 256.F;
+
+  StreamingOutputEffects(bool normalize_audio, float volume)
+      : normalize_audio_(normalize_audio), volume_(volume) {}
+
+  void apply(std::vector<float>& chunk);
+
+ private:
+  bool normalize_audio_;
+  float volume_;
+  /// Zero until the first chunk with a non-silent peak.
+  float gain_ = 0.F;
+  /// Limiter gain at the end of the previous chunk.
+  float limiter_ = 1.F;
+  std::vector<float> envelope_;
+};
+
 }  // namespace moonshine_tts
 
 #endif  // MOONSHINE_TTS_MOONSHINE_TTS_OPTIONS_H
@@ -11,6 +11,8 @@
 #include "ort-utils-cxx.h"
 #include "piper-tts.h"
 #include "string-utils.h"
+#include "tts-pipeline.h"
+#include "tts-shared-model.h"
 #include "utf8-utils.h"
 #include "zipvoice-tts.h"
 #include "zipvoice-voices.h"
@@ -27,6 +29,7 @@ extern "C" {
 #include <cstring>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <sstream>
@@ -554,8 +557,11 @@ std::string normalize_ipa_to_kokoro(
   return collapse_whitespace_join_single_space(kept);
 }
 
-std::vector<std::string> chunk_phonemes(const std::string& ps,
-                                        int max_cp = 510) {
+/// Kokoro accepts at most 512 input ids, two of which are the pad tokens.
+constexpr int kKokoroMaxChunkPhonemes = 510;
+
+std::vector<std::string> chunk_phonemes(
+    const std::string& ps, int max_cp = kKokoroMaxChunkPhonemes) {
   std::vector<std::string> chunks;
   if (ps.empty()) {
     return chunks;
@@ -751,6 +757,7 @@ PiperTTSOptions make_piper_options(std::string_view language,
   p.coreml_cache_dir = opt.coreml_cache_dir;
   p.normalize_audio = opt.normalize_audio;
   p.output_volume = opt.output_volume;
+  p.pipeline_synthesis = opt.pipeline_synthesis;
   p.piper_noise_scale_override = opt.piper_noise_scale_override;
   p.piper_noise_w_override = opt.piper_noise_w_override;
   p.tts_asset_files = opt.files;
@@ -891,12 +898,15 @@ ZipVoiceTTSOptions make_zipvoice_options(std::string_view language,
   z.coreml_cache_dir = opt.coreml_cache_dir;
   z.normalize_audio = opt.normalize_audio;
   z.output_volume = opt.output_volume;
+  z.pipeline_synthesis = opt.pipeline_synthesis;
   z.distill = opt.zipvoice_distill;
   z.num_step = opt.zipvoice_num_step;
   z.guidance_scale = opt.zipvoice_guidance_scale;
   z.t_shift = opt.zipvoice_t_shift;
+  z.max_batch_chunks = opt.zipvoice_max_batch_chunks;
   z.clone_sample_rate = opt.zipvoice_clone_sample_rate;
   z.clone_transcript = opt.zipvoice_clone_transcript;
+  z.clone_cache_dir = opt.zipvoice_clone_cache_dir;
   z.tts_asset_files = opt.files;
   z.voice_id = opt.voice;  // engine prefix already stripped
   const auto it =
@@ -954,13 +964,20 @@ list_zipvoice_voices_with_availability(const MoonshineTTSOptions& opt) {
   return out;
 }
 
+/// Kokoro weights, shared by every engine loaded from the same model file.
+struct KokoroSharedModel {
+  Ort::Env env = make_ort_env(ORT_LOGGING_LEVEL_WARNING, "moonshine_tts");
+  Ort::Session session{nullptr};
+};
+
 struct KokoroTtsEngine {
   std::filesystem::path model_path_;
   std::filesystem::path config_path_;
   std::filesystem::path voices_dir_;
   FileInformationMap tts_files_;
-  Ort::Env env_ = make_ort_env(ORT_LOGGING_LEVEL_WARNING, "moonshine_tts");
-  Ort::Session session_{nullptr};
+  /// Shared, read-only after load; ``session_`` points into it.
+  std::shared_ptr<KokoroSharedModel> model_{};
+  Ort::Session* session_ = nullptr;
   Ort::MemoryInfo mem_{
       Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)};
 
@@ -987,6 +1004,9 @@ struct KokoroTtsEngine {
   /// the style vector ``style``; local torch exports use ``ref_s``.
   std::string style_input_name_ = "ref_s";
   bool log_profiling_ = false;
+  /// Run G2P for the next sentence on a worker thread while Kokoro vocodes
+  /// the current one (``pipeline_synthesis``).
+  bool pipeline_ = true;
 
   ~KokoroTtsEngine() {
     for (auto& e : tts_files_.entries) {
@@ -995,7 +1015,7 @@ struct KokoroTtsEngine {
   }
 
   void detect_kokoro_style_input_name() {
-    const std::vector<std::string> names = session_.GetInputNames();
+    const std::vector<std::string> names = session_->GetInputNames();
     for (const std::string& n : names) {
       if (n == "style") {
         style_input_name_ = "style";
@@ -1009,11 +1029,11 @@ struct KokoroTtsEngine {
     // Kokoro ONNX convention: inputs [0]=input_ids, [1]=ref_s|style, [2]=speed.
     // Community HF models use float32 speed [1]; local torch exports use double
     // scalar.
-    const size_t n_in = session_.GetInputCount();
+    const size_t n_in = session_->GetInputCount();
     if (n_in < 3) {
       return;
     }
-    Ort::TypeInfo ti = session_.GetInputTypeInfo(2);
+    Ort::TypeInfo ti = session_->GetInputTypeInfo(2);
     if (ti.GetONNXType() != ONNX_TYPE_TENSOR) {
       return;
     }
@@ -1047,6 +1067,7 @@ struct KokoroTtsEngine {
     speed_ = opt.speed;
     normalize_audio_ = opt.normalize_audio;
     output_volume_ = opt.output_volume;
+    pipeline_ = opt.pipeline_synthesis;
     g2p_opt_ = std::move(opt.g2p_options);
     tts_files_ = std::move(opt.files);
     const std::filesystem::path& root = g2p_opt_.g2p_root;
@@ -1102,21 +1123,33 @@ struct KokoroTtsEngine {
     TIMER_END_IF(log_profiling_, kokoro_load_config);
 
     TIMER_START_IF(log_profiling_, kokoro_load_model);
-    const uint8_t* model_buf = nullptr;
-    size_t model_len = 0;
-    model_fi.load(&model_buf, &model_len);
-    if (model_len == 0) {
-      model_fi.free();
-      throw std::runtime_error("MoonshineTTS: empty Kokoro model (" +
-                               model_path_.string() + ")");
-    }
-    require_ort_model_bytes(model_buf, model_len, "Kokoro model");
-    Ort::SessionOptions session_opts =
-        make_ort_session_options(opt.ort_provider_names, opt.coreml_cache_dir);
-    session_ = Ort::Session(env_, model_buf, model_len, session_opts);
-    model_fi.free();
-    LOGF_IF(log_profiling_, "KokoroTtsEngine: model loaded (%zu bytes)",
-            model_len);
+    const std::string model_key = shared_model_session_key(
+        model_fi.has_memory()
+            ? shared_model_bytes_key(model_fi.memory, model_fi.memory_size)
+            : shared_model_file_key(model_path_),
+        opt.ort_provider_names, opt.coreml_cache_dir);
+    model_ = SharedModelRegistry<KokoroSharedModel>::instance().get(
+        model_key, [&] {
+          const uint8_t* model_buf = nullptr;
+          size_t model_len = 0;
+          model_fi.load(&model_buf, &model_len);
+          if (model_len == 0) {
+            model_fi.free();
+            throw std::runtime_error("MoonshineTTS: empty Kokoro model (" +
+                                     model_path_.string() + ")");
+          }
+          require_ort_model_bytes(model_buf, model_len, "Kokoro model");
+          Ort::SessionOptions session_opts = make_ort_session_options(
+              opt.ort_provider_names, opt.coreml_cache_dir);
+          auto model = std::make_shared<KokoroSharedModel>();
+          model->session =
+              Ort::Session(model->env, model_buf, model_len, session_opts);
+          model_fi.free();
+          LOGF_IF(log_profiling_, "KokoroTtsEngine: model loaded (%zu bytes)",
+                  model_len);
+          return model;
+        });
+    session_ = &model_->session;
     TIMER_END_IF(log_profiling_, kokoro_load_model);
 
     detect_kokoro_style_input_name();
@@ -1191,11 +1224,130 @@ struct KokoroTtsEngine {
     read_kokorovoice(path, voice_, voice_rows_, voice_cols_);
   }
 
-  std::vector<float> synthesize(std::string_view text) {
+  /// Vocodes one phoneme chunk (``ci`` counts chunks, for logging) and
+  /// returns its raw waveform, before output effects.
+  std::vector<float> run_chunk(const std::string& piece, size_t ci) {
+    if (trim_ascii_ws_copy(piece).empty()) {
+      return {};
+    }
+    std::vector<int64_t> ids = phoneme_str_to_input_ids(piece, vocab_);
+    if (ids.size() > 512) {
+      throw std::runtime_error(
+          "MoonshineTTS: phoneme token sequence too long for Kokoro (>512)");
+    }
+    LOGF_IF(log_profiling_,
+            "KokoroTtsEngine::synthesize: chunk %zu, %zu tokens", ci + 1,
+            ids.size());
+
+    const int64_t ntok = static_cast<int64_t>(ids.size());
+    const std::array<int64_t, 2> shape_ids{1, ntok};
+
+    const std::u32string pu = utf8_str_to_u32(piece);
+    const size_t ncp = std::max<size_t>(pu.size(), 1);
+    const size_t idx = std::min(
+        ncp - 1, static_cast<size_t>(voice_rows_ > 0 ? voice_rows_ - 1 : 0));
+    const size_t off = idx * static_cast<size_t>(voice_cols_);
+    std::vector<float> ref_row(voice_cols_);
+    if (off + voice_cols_ > voice_.size()) {
+      throw std::runtime_error("MoonshineTTS: voice tensor index out of range");
+    }
+    std::copy(voice_.begin() + static_cast<std::ptrdiff_t>(off),
+              voice_.begin() + static_cast<std::ptrdiff_t>(off + voice_cols_),
+              ref_row.begin());
+    const std::array<int64_t, 2> shape_ref{1,
+                                           static_cast<int64_t>(voice_cols_)};
+
+    std::vector<Ort::Value> inputs;
+    inputs.push_back(Ort::Value::CreateTensor<int64_t>(
+        mem_, ids.data(), ids.size(), shape_ids.data(), shape_ids.size()));
+    inputs.push_back(
+        Ort::Value::CreateTensor<float>(mem_, ref_row.data(), ref_row.size(),
+                                        shape_ref.data(), shape_ref.size()));
+    float speed_f = static_cast<float>(speed_);
+    double speed_val = speed_;
+    if (speed_elem_type_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+      const std::array<int64_t, 1> shape_speed{1};
+      inputs.push_back(Ort::Value::CreateTensor<float>(
+          mem_, &speed_f, 1, shape_speed.data(), 1));
+    } else {
+      inputs.push_back(
+          Ort::Value::CreateTensor<double>(mem_, &speed_val, 1, nullptr, 0));
+    }
+
+    const char* in_names[3] = {"input_ids", style_input_name_.c_str(), "speed"};
+    static const char* out_names[] = {"waveform"};
+    TIMER_START_IF(log_profiling_, kokoro_onnx_run);
+    Ort::RunOptions run_opts{nullptr};
+    auto outputs = session_->Run(run_opts, in_names, inputs.data(),
+                                inputs.size(), out_names, 1);
+    TIMER_END_IF(log_profiling_, kokoro_onnx_run);
+
+    const Ort::Value& wav = outputs[0];
+    const auto ti = wav.GetTensorTypeAndShapeInfo();
+    const size_t n_el = ti.GetElementCount();
+    if (ti.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+      throw std::runtime_error("MoonshineTTS: ONNX output is not float32");
+    }
+    const float* wptr = wav.GetTensorData<float>();
+    LOGF_IF(log_profiling_,
+            "KokoroTtsEngine::synthesize: chunk %zu produced %zu samples",
+            ci + 1, n_el);
+    return std::vector<float>(wptr, wptr + n_el);
+  }
+
+  /// G2P plus Kokoro phoneme normalization for one piece of text.
+  std::string text_to_kokoro_phonemes(const std::string& text) {
     TIMER_START_IF(log_profiling_, kokoro_g2p);
     const std::string ipa = g2p_->text_to_ipa(text, nullptr);
     TIMER_END_IF(log_profiling_, kokoro_g2p);
-    return synthesize_from_ipa(ipa);
+    return normalize_ipa_to_kokoro(ipa, kokoro_lang_, vocab_keys_);
+  }
+
+  /// Vocodes normalized ``phonemes`` in chunks of at most
+  /// ``kKokoroMaxChunkPhonemes`` and appends the raw audio to ``wave``.
+  /// ``ci`` counts chunks across calls.
+  void vocode_phonemes(const std::string& phonemes, std::vector<float>& wave,
+                       size_t& ci) {
+    const std::vector<std::string> chunks = chunk_phonemes(phonemes);
+    LOGF_IF(log_profiling_,
+            "KokoroTtsEngine::synthesize: %zu phoneme chunk(s), "
+            "phonemes='%.*s'%s",
+            chunks.size(), (int)std::min(phonemes.size(), (size_t)300),
+            phonemes.c_str(), phonemes.size() > 300 ? "..." : "");
+    for (const std::string& chunk : chunks) {
+      const std::vector<float> wav = run_chunk(chunk, ci++);
+      wave.insert(wave.end(), wav.begin(), wav.end());
+    }
+  }
+
+  std::vector<float> finish_wave(std::vector<float> wave_all) {
+    apply_synthesis_output_effects(wave_all, normalize_audio_, output_volume_);
+    LOGF_IF(log_profiling_,
+            "KokoroTtsEngine::synthesize: total %zu samples (%.2fs at %dHz)",
+            wave_all.size(),
+            static_cast<double>(wave_all.size()) / MoonshineTTS::kSampleRateHz,
+            MoonshineTTS::kSampleRateHz);
+    return wave_all;
+  }
+
+  /// With ``pipeline_`` set, each sentence is vocoded on its own while the
+  /// next one goes through G2P on a worker thread.
+  std::vector<float> synthesize(std::string_view text) {
+    TIMER_START_IF(log_profiling_, kokoro_synthesize);
+    std::vector<float> wave_all;
+    size_t ci = 0;
+    for_each_sentence_pipelined<std::string>(
+        text, pipeline_,
+        [this](const std::string& piece) {
+          return text_to_kokoro_phonemes(piece);
+        },
+        [&](std::string phonemes) {
+          vocode_phonemes(phonemes, wave_all, ci);
+          return true;
+        });
+    wave_all = finish_wave(std::move(wave_all));
+    TIMER_END_IF(log_profiling_, kokoro_synthesize);
+    return wave_all;
   }
 
   /// Synthesize from an existing IPA phoneme string (skips G2P). The input is
@@ -1210,109 +1362,89 @@ struct KokoroTtsEngine {
     }
 
     TIMER_START_IF(log_profiling_, kokoro_normalize_ipa);
-    std::string phonemes =
+    const std::string phonemes =
         normalize_ipa_to_kokoro(std::string(ipa), kokoro_lang_, vocab_keys_);
     TIMER_END_IF(log_profiling_, kokoro_normalize_ipa);
-    if (phonemes.empty()) {
-      return {};
-    }
-    const std::vector<std::string> chunks = chunk_phonemes(phonemes);
-    if (chunks.empty()) {
-      return {};
-    }
-    LOGF_IF(log_profiling_,
-            "KokoroTtsEngine::synthesize: %zu phoneme chunk(s), "
-            "phonemes='%.*s'%s",
-            chunks.size(), (int)std::min(phonemes.size(), (size_t)300),
-            phonemes.c_str(), phonemes.size() > 300 ? "..." : "");
-
     std::vector<float> wave_all;
-    wave_all.reserve(chunks.size() * 8192);
-
-    const char* in_names[3] = {"input_ids", style_input_name_.c_str(), "speed"};
-    static const char* out_names[] = {"waveform"};
-
-    for (size_t ci = 0; ci < chunks.size(); ++ci) {
-      const std::string& piece = chunks[ci];
-      if (trim_ascii_ws_copy(piece).empty()) {
-        continue;
-      }
-      std::vector<int64_t> ids = phoneme_str_to_input_ids(piece, vocab_);
-      if (ids.size() > 512) {
-        throw std::runtime_error(
-            "MoonshineTTS: phoneme token sequence too long for Kokoro (>512)");
-      }
-      LOGF_IF(log_profiling_,
-              "KokoroTtsEngine::synthesize: chunk %zu/%zu, %zu tokens", ci + 1,
-              chunks.size(), ids.size());
-
-      const int64_t ntok = static_cast<int64_t>(ids.size());
-      const std::array<int64_t, 2> shape_ids{1, ntok};
-
-      const std::u32string pu = utf8_str_to_u32(piece);
-      const size_t ncp = std::max<size_t>(pu.size(), 1);
-      const size_t idx = std::min(
-          ncp - 1, static_cast<size_t>(voice_rows_ > 0 ? voice_rows_ - 1 : 0));
-      const size_t off = idx * static_cast<size_t>(voice_cols_);
-      std::vector<float> ref_row(voice_cols_);
-      if (off + voice_cols_ > voice_.size()) {
-        throw std::runtime_error(
-            "MoonshineTTS: voice tensor index out of range");
-      }
-      std::copy(voice_.begin() + static_cast<std::ptrdiff_t>(off),
-                voice_.begin() + static_cast<std::ptrdiff_t>(off + voice_cols_),
-                ref_row.begin());
-      const std::array<int64_t, 2> shape_ref{1,
-                                             static_cast<int64_t>(voice_cols_)};
-
-      std::vector<Ort::Value> inputs;
-      inputs.push_back(Ort::Value::CreateTensor<int64_t>(
-          mem_, ids.data(), ids.size(), shape_ids.data(), shape_ids.size()));
-      inputs.push_back(
-          Ort::Value::CreateTensor<float>(mem_, ref_row.data(), ref_row.size(),
-                                          shape_ref.data(), shape_ref.size()));
-      if (speed_elem_type_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
-        float speed_f = static_cast<float>(speed_);
-        const std::array<int64_t, 1> shape_speed{1};
-        inputs.push_back(Ort::Value::CreateTensor<float>(
-            mem_, &speed_f, 1, shape_speed.data(), 1));
-      } else {
-        double speed_val = speed_;
-        inputs.push_back(
-            Ort::Value::CreateTensor<double>(mem_, &speed_val, 1, nullptr, 0));
-      }
-
-      TIMER_START_IF(log_profiling_, kokoro_onnx_run);
-      Ort::RunOptions run_opts{nullptr};
-      auto outputs = session_.Run(run_opts, in_names, inputs.data(),
-                                  inputs.size(), out_names, 1);
-      TIMER_END_IF(log_profiling_, kokoro_onnx_run);
-
-      const Ort::Value& wav = outputs[0];
-      const auto ti = wav.GetTensorTypeAndShapeInfo();
-      const size_t n_el = ti.GetElementCount();
-      if (ti.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
-        throw std::runtime_error("MoonshineTTS: ONNX output is not float32");
-      }
-      const float* wptr = wav.GetTensorData<float>();
-      for (size_t i = 0; i < n_el; ++i) {
-        wave_all.push_back(wptr[i]);
-      }
-      LOGF_IF(log_profiling_,
-              "KokoroTtsEngine::synthesize: chunk %zu produced %zu samples",
-              ci + 1, n_el);
-    }
-
-    apply_synthesis_output_effects(wave_all, normalize_audio_, output_volume_);
-
-    LOGF_IF(log_profiling_,
-            "KokoroTtsEngine::synthesize: total %zu samples (%.2fs at %dHz)",
-            wave_all.size(),
-            static_cast<double>(wave_all.size()) / MoonshineTTS::kSampleRateHz,
-            MoonshineTTS::kSampleRateHz);
+    size_t ci = 0;
+    vocode_phonemes(phonemes, wave_all, ci);
+    wave_all = finish_wave(std::move(wave_all));
     TIMER_END_IF(log_profiling_, kokoro_synthesize);
     return wave_all;
   }
+
+  /// Streaming form of ``synthesize``. Sentences are converted to phonemes
+  /// on a worker thread and fed to an ``IncrementalChunker``, so the chunks
+  /// match ``synthesize_from_ipa_streaming`` on the whole text's phonemes.
+  size_t synthesize_streaming(std::string_view text,
+                              const TtsAudioChunkCallback& on_audio) {
+    StreamingOutputEffects effects(normalize_audio_, output_volume_);
+    StreamingChunkSink sink{this, &effects, &on_audio};
+    const auto split = [](const std::string& phonemes, size_t released) {
+      return split_phonemes_for_streaming(
+          phonemes,
+          streaming_chunk_budget(kTtsStreamFirstChunkPhonemes,
+                                 kKokoroMaxChunkPhonemes, released),
+          kKokoroMaxChunkPhonemes);
+    };
+    IncrementalChunker<std::string, decltype(split)> chunker(split, " ");
+    bool more = true;
+    for_each_sentence_pipelined<std::string>(
+        text, pipeline_,
+        [this](const std::string& piece) {
+          return text_to_kokoro_phonemes(piece);
+        },
+        [&](std::string phonemes) {
+          more = sink.emit(chunker.add(phonemes));
+          return more;
+        });
+    if (more) {
+      sink.emit(chunker.finish());
+    }
+    return sink.delivered;
+  }
+
+  /// Streaming form of ``synthesize_from_ipa``: chunks follow
+  /// ``split_phonemes_for_streaming`` and each one is passed to ``on_audio``
+  /// as soon as Kokoro returns it. Returns the number of samples delivered.
+  size_t synthesize_from_ipa_streaming(std::string_view ipa,
+                                       const TtsAudioChunkCallback& on_audio) {
+    if (trim_ascii_ws_copy(ipa).empty()) {
+      return 0;
+    }
+    const std::string phonemes =
+        normalize_ipa_to_kokoro(std::string(ipa), kokoro_lang_, vocab_keys_);
+    StreamingOutputEffects effects(normalize_audio_, output_volume_);
+    StreamingChunkSink sink{this, &effects, &on_audio};
+    sink.emit(split_phonemes_for_streaming(
+        phonemes, kTtsStreamFirstChunkPhonemes, kKokoroMaxChunkPhonemes));
+    return sink.delivered;
+  }
+
+  /// Vocodes streamed chunks in order and hands them to the caller.
+  struct StreamingChunkSink {
+    KokoroTtsEngine* engine;
+    StreamingOutputEffects* effects;
+    const TtsAudioChunkCallback* on_audio;
+    size_t chunk_index = 0;
+    size_t delivered = 0;
+
+    /// Returns false once ``on_audio`` asks to stop.
+    bool emit(const std::vector<std::string>& chunks) {
+      for (const std::string& chunk : chunks) {
+        std::vector<float> wav = engine->run_chunk(chunk, chunk_index++);
+        if (wav.empty()) {
+          continue;
+        }
+        effects->apply(wav);
+        delivered += wav.size();
+        if (!(*on_audio)(wav.data(), wav.size())) {
+          return false;
+        }
+      }
+      return true;
+    }
+  };
 };
 
 struct MoonshineTTS::Impl {
@@ -1415,6 +1547,28 @@ struct MoonshineTTS::Impl {
     return piper_->synthesize_from_ipa(phonemes);
   }
 
+  size_t synthesize_streaming_unlocked(std::string_view text,
+                                       const TtsAudioChunkCallback& on_audio) {
+    if (zipvoice_) {
+      return zipvoice_->synthesize_streaming(text, on_audio);
+    }
+    if (kokoro_) {
+      return kokoro_->synthesize_streaming(text, on_audio);
+    }
+    return piper_->synthesize_streaming(text, on_audio);
+  }
+
+  size_t synthesize_from_phonemes_streaming_unlocked(
+      std::string_view phonemes, const TtsAudioChunkCallback& on_audio) {
+    if (zipvoice_) {
+      return zipvoice_->synthesize_from_ipa_streaming(phonemes, on_audio);
+    }
+    if (kokoro_) {
+      return kokoro_->synthesize_from_ipa_streaming(phonemes, on_audio);
+    }
+    return piper_->synthesize_from_ipa_streaming(phonemes, on_audio);
+  }
+
   std::vector<float> synthesize(std::string_view text) {
     std::lock_guard<std::mutex> lock(synth_mu_);
     return synthesize_unlocked(text);
@@ -1436,12 +1590,27 @@ struct MoonshineTTS::Impl {
     return run_with_overrides(ov, [&] { return synthesize_unlocked(text); });
   }
 
+  size_t synthesize_streaming(std::string_view text,
+                              const SynthesisOverrides& ov,
+                              const TtsAudioChunkCallback& on_audio) {
+    return run_with_overrides(
+        ov, [&] { return synthesize_streaming_unlocked(text, on_audio); });
+  }
+
+  size_t synthesize_from_phonemes_streaming(
+      std::string_view phonemes, const SynthesisOverrides& ov,
+      const TtsAudioChunkCallback& on_audio) {
+    return run_with_overrides(ov, [&] {
+      return synthesize_from_phonemes_streaming_unlocked(phonemes, on_audio);
+    });
+  }
+
   /// Applies ``ov`` to the active engine, invokes ``produce`` while holding the
   /// synthesis lock, then restores the previous effect settings (even if
   /// ``produce`` throws).
   template <typename Produce>
-  std::vector<float> run_with_overrides(const SynthesisOverrides& ov,
-                                        Produce&& produce) {
+  auto run_with_overrides(const SynthesisOverrides& ov, Produce&& produce)
+      -> decltype(produce()) {
     std::lock_guard<std::mutex> lock(synth_mu_);
     if (zipvoice_) {
       const double prev_speed = zipvoice_->speed();
@@ -1456,9 +1625,9 @@ struct MoonshineTTS::Impl {
                ov.normalize_audio.value_or(prev_normalize),
                ov.output_volume.value_or(prev_volume));
       try {
-        std::vector<float> wave = produce();
+        auto result = produce();
         apply_zv(prev_speed, prev_normalize, prev_volume);
-        return wave;
+        return result;
       } catch (...) {
         apply_zv(prev_speed, prev_normalize, prev_volume);
         throw;
@@ -1484,9 +1653,9 @@ struct MoonshineTTS::Impl {
           ov.normalize_audio.value_or(prev_normalize),
           ov.output_volume.value_or(prev_volume));
     try {
-      std::vector<float> wave = produce();
+      auto result = produce();
       apply(prev_speed, prev_normalize, prev_volume);
-      return wave;
+      return result;
     } catch (...) {
       apply(prev_speed, prev_normalize, prev_volume);
       throw;
@@ -1540,6 +1709,34 @@ std::vector<float> MoonshineTTS::synthesize_from_phonemes(
   return impl_->synthesize_from_phonemes_with_overrides(phonemes, ov);
 }
 
+size_t MoonshineTTS::synthesize_streaming(
+    std::string_view text, const TtsAudioChunkCallback& on_audio) {
+  return synthesize_streaming(text, {}, on_audio);
+}
+
+size_t MoonshineTTS::synthesize_streaming(
+    std::string_view text,
+    const std::vector<std::pair<std::string, std::string>>& option_overrides,
+    const TtsAudioChunkCallback& on_audio) {
+  const SynthesisOverrides ov =
+      parse_synthesis_overrides_from_pairs(option_overrides);
+  return impl_->synthesize_streaming(text, ov, on_audio);
+}
+
+size_t MoonshineTTS::synthesize_from_phonemes_streaming(
+    std::string_view phonemes, const TtsAudioChunkCallback& on_audio) {
+  return synthesize_from_phonemes_streaming(phonemes, {}, on_audio);
+}
+
+size_t MoonshineTTS::synthesize_from_phonemes_streaming(
+    std::string_view phonemes,
+    const std::vector<std::pair<std::string, std::string>>& option_overrides,
+    const TtsAudioChunkCallback& on_audio) {
+  const SynthesisOverrides ov =
+      parse_synthesis_overrides_from_pairs(option_overrides);
+  return impl_->synthesize_from_phonemes_streaming(phonemes, ov, on_audio);
+}
+
 void write_wav_mono_pcm16(const std::filesystem::path& path,
                           const std::vector<float>& samples) {
   // parent_path() is empty for plain filenames like "out.wav";
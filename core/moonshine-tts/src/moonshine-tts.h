@@ -56,6 +56,35 @@ class MoonshineTTS {
       std::string_view phonemes,
       const std::vector<std::pair<std::string, std::string>>& option_overrides);
 
+  /// Streaming form of ``synthesize``: instead of returning the whole
+  /// waveform, passes each chunk's PCM to ``on_audio`` as soon as it is
+  /// vocoded. The first chunk is cut short (``kTtsStreamFirstChunkPhonemes``)
+  /// to minimize time to first sample. With ``normalize_audio`` the gain is
+  /// set by the first chunk's peak and held for the whole utterance, with a
+  /// limiter on louder later peaks (see ``StreamingOutputEffects``). It
+  /// matches ``synthesize`` when the first chunk holds the loudest peak and
+  /// is otherwise louder. Blocks until synthesis finishes or ``on_audio``
+  /// returns false; ``on_audio`` must not call back into this object. Returns
+  /// the number of samples delivered.
+  size_t synthesize_streaming(std::string_view text,
+                              const TtsAudioChunkCallback& on_audio);
+
+  /// ``synthesize_streaming`` with per-call option overrides (same keys as the
+  /// ``synthesize`` overload).
+  size_t synthesize_streaming(
+      std::string_view text,
+      const std::vector<std::pair<std::string, std::string>>& option_overrides,
+      const TtsAudioChunkCallback& on_audio);
+
+  /// Streaming form of ``synthesize_from_phonemes``.
+  size_t synthesize_from_phonemes_streaming(
+      std::string_view phonemes, const TtsAudioChunkCallback& on_audio);
+
+  size_t synthesize_from_phonemes_streaming(
+      std::string_view phonemes,
+      const std::vector<std::pair<std::string, std::string>>& option_overrides,
+      const TtsAudioChunkCallback& on_audio);
+
  private:
   struct Impl;
   std::unique_ptr<Impl> impl_;
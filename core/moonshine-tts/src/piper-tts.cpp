@@ -6,12 +6,15 @@
 #include "debug-utils.h"
 #include "g2p-path.h"
 #include "ipa-postprocess.h"
+#include "linear-resample.h"
 #include "moonshine-g2p.h"
 #include "moonshine-tts-options.h"
 #include "ort-session-options.h"
 #include "ort-utils-cxx.h"
 #include "piper-voice-catalog.h"
 #include "split-weights.h"
+#include "tts-pipeline.h"
+#include "tts-shared-model.h"
 #include "utf8-utils.h"
 
 extern "C" {
@@ -25,10 +28,12 @@ extern "C" {
 #include <filesystem>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <set>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 namespace moonshine_tts {
 
@@ -336,29 +341,6 @@ std::vector<int64_t> ipa_utf8_to_piper_ids(
   return ids;
 }
 
-std::vector<float> resample_linear(const std::vector<float>& x, int src_sr,
-                                   int dst_sr) {
-  if (src_sr == dst_sr || x.empty()) {
-    return x;
-  }
-  const double duration =
-      static_cast<double>(x.size() - 1) / static_cast<double>(src_sr);
-  const size_t n_out = std::max<size_t>(
-      2, static_cast<size_t>(std::llround(duration * dst_sr)) + 1);
-  std::vector<float> y(n_out);
-  for (size_t i = 0; i < n_out; ++i) {
-    const double t = (n_out <= 1) ? 0.0
-                                  : (static_cast<double>(i) * duration /
-                                     static_cast<double>(n_out - 1));
-    const double fidx = t * static_cast<double>(src_sr);
-    const size_t i0 = static_cast<size_t>(std::floor(fidx));
-    const size_t i1 = std::min(i0 + 1, x.size() - 1);
-    const double frac = fidx - static_cast<double>(i0);
-    y[i] = static_cast<float>(x[i0] * (1.0 - frac) + x[i1] * frac);
-  }
-  return y;
-}
-
 void load_piper_onnx_json(
     const std::filesystem::path& json_path,
     std::unordered_map<std::string, std::vector<int64_t>>& phoneme_id_map,
@@ -460,6 +442,31 @@ void load_piper_onnx_json_bytes(
   }
 }
 
+/// Piper has no input limit; this only caps how far streamed chunks grow so
+/// each later one stays roughly sentence-sized.
+constexpr size_t kPiperMaxStreamChunkPhonemes = 512;
+
+Ort::Session open_piper_session(Ort::Env& env,
+                                const std::filesystem::path& model_path,
+                                const Ort::SessionOptions& session_opts) {
+#ifdef _WIN32
+  const std::wstring wmodel = model_path.wstring();
+  return Ort::Session(env, wmodel.c_str(), session_opts);
+#else
+  const std::string u8 = model_path.string();
+  return Ort::Session(env, u8.c_str(), session_opts);
+#endif
+}
+
+/// Weights of one Piper voice, shared by every ``PiperTTS`` that loads it.
+struct PiperSharedModel {
+  Ort::Env env = make_ort_env(ORT_LOGGING_LEVEL_WARNING, "piper_tts");
+  Ort::Session session{nullptr};
+  /// Float32 weights supplied to the graph on every inference, for voices
+  /// that ship as a split ORT pair. See split-weights.h.
+  std::vector<SplitWeight> split_weights{};
+};
+
 }  // namespace
 
 struct PiperTTS::Impl {
@@ -467,15 +474,11 @@ struct PiperTTS::Impl {
   std::filesystem::path voices_json_dir_;
   std::filesystem::path onnx_path_;
   std::filesystem::path explicit_onnx_json_path_;
-  Ort::Env env_ = make_ort_env(ORT_LOGGING_LEVEL_WARNING, "piper_tts");
-  Ort::Session session_{nullptr};
+  /// Shared with other instances using the same voice; only ever read.
+  std::shared_ptr<PiperSharedModel> model_{};
   Ort::MemoryInfo mem_{
       Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)};
 
-  /// Float32 weights supplied to the graph on every inference, for voices that
-  /// ship as a split ORT pair. See split-weights.h.
-  std::vector<SplitWeight> split_weights_{};
-
   std::unordered_map<std::string, std::vector<int64_t>> phoneme_id_map_{};
   std::unordered_set<std::string> phoneme_map_keys_{};
   std::string piper_ipa_lang_key_{};
@@ -498,6 +501,7 @@ struct PiperTTS::Impl {
   std::string coreml_cache_dir_{};
   bool normalize_audio_ = true;
   float output_volume_ = 1.F;
+  bool pipeline_ = true;
   std::optional<float> noise_scale_override_{};
   std::optional<float> noise_w_override_{};
   FileInformationMap tts_asset_files_{};
@@ -509,6 +513,22 @@ struct PiperTTS::Impl {
   }
 
   std::vector<float> run_ort_from_phoneme_ids(const std::vector<int64_t>& ids) {
+    std::vector<float> wave = run_ort_raw(ids);
+    apply_synthesis_output_effects(wave, normalize_audio_, output_volume_);
+    return resample_to_output_rate(std::move(wave));
+  }
+
+  std::vector<float> resample_to_output_rate(std::vector<float> wave) const {
+    if (native_sample_rate_ != PiperTTS::kSampleRateHz) {
+      wave =
+          resample_linear(wave, native_sample_rate_, PiperTTS::kSampleRateHz);
+    }
+    return wave;
+  }
+
+  /// Runs the voice on ``ids`` and returns the waveform at the model's native
+  /// rate, before output effects.
+  std::vector<float> run_ort_raw(const std::vector<int64_t>& ids) {
     if (ids.size() < 3) {
       throw std::runtime_error("PiperTTS: phoneme id sequence too short");
     }
@@ -555,12 +575,13 @@ struct PiperTTS::Impl {
 
     // Split-weights voices keep their weights out of the model, so pass them
     // alongside the text inputs.
-    append_split_weight_inputs(split_weights_, mem_, inputs, in_names);
+    append_split_weight_inputs(model_->split_weights, mem_, inputs, in_names);
 
     Ort::RunOptions run_opts{nullptr};
     const char* out_names[] = {"output"};
-    auto outputs = session_.Run(run_opts, in_names.data(), inputs.data(),
-                                inputs.size(), out_names, 1);
+    auto outputs = model_->session.Run(run_opts, in_names.data(),
+                                       inputs.data(), inputs.size(),
+                                       out_names, 1);
     const Ort::Value& outv = outputs[0];
     const auto ti = outv.GetTensorTypeAndShapeInfo();
     if (ti.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
@@ -568,22 +589,16 @@ struct PiperTTS::Impl {
     }
     const size_t n_el = ti.GetElementCount();
     const float* ptr = outv.GetTensorData<float>();
-    std::vector<float> wave(ptr, ptr + n_el);
-    apply_synthesis_output_effects(wave, normalize_audio_, output_volume_);
-    if (native_sample_rate_ != PiperTTS::kSampleRateHz) {
-      wave =
-          resample_linear(wave, native_sample_rate_, PiperTTS::kSampleRateHz);
-    }
-    return wave;
+    return std::vector<float>(ptr, ptr + n_el);
   }
 
-  /// Loads the split-weights form of a voice if it is present on disk.
-  ///
-  /// Returns false when the pair is absent, leaving the caller to open the
-  /// single-file form. See split-weights.h for why voices ship this way.
-  bool load_split_weight_sessions(const Ort::SessionOptions& session_opts) {
+  /// The split-weights form of the voice as ``{model, weights}`` paths, or
+  /// empty paths when the pair is absent on disk (the caller then opens the
+  /// single-file form). See split-weights.h for why voices ship this way.
+  std::pair<std::filesystem::path, std::filesystem::path> split_weight_paths()
+      const {
     if (onnx_path_.empty()) {
-      return false;
+      return {};
     }
     std::filesystem::path model_path = onnx_path_;
     model_path.replace_extension(".model.ort");
@@ -591,20 +606,9 @@ struct PiperTTS::Impl {
     weights_path.replace_extension(".weights.ort");
     if (!std::filesystem::is_regular_file(model_path) ||
         !std::filesystem::is_regular_file(weights_path)) {
-      return false;
+      return {};
     }
-
-    std::vector<SplitWeight> weights =
-        run_split_weights_model(env_, weights_path, session_opts);
-#ifdef _WIN32
-    const std::wstring wmodel = model_path.wstring();
-    session_ = Ort::Session(env_, wmodel.c_str(), session_opts);
-#else
-    const std::string model_u8 = model_path.string();
-    session_ = Ort::Session(env_, model_u8.c_str(), session_opts);
-#endif
-    split_weights_ = std::move(weights);
-    return true;
+    return {model_path, weights_path};
   }
 
   void reload_session() {
@@ -639,23 +643,51 @@ struct PiperTTS::Impl {
     for (const auto& e : phoneme_id_map_) {
       phoneme_map_keys_.insert(e.first);
     }
-    Ort::SessionOptions session_opts =
-        make_ort_session_options(ort_provider_names_, coreml_cache_dir_);
-    split_weights_.clear();
+    // Sessions come from the shared registry, so instances for the same voice
+    // and providers reuse one copy of the weights.
+    auto& registry = SharedModelRegistry<PiperSharedModel>::instance();
+    const auto model_key = [&](std::string key) {
+      return shared_model_session_key(std::move(key), ort_provider_names_,
+                                      coreml_cache_dir_);
+    };
+    const auto session_opts = [&] {
+      return make_ort_session_options(ort_provider_names_, coreml_cache_dir_);
+    };
     const auto oit = tts_asset_files_.entries.find(k_piper_onnx);
-    if (oit == tts_asset_files_.entries.end() &&
-        load_split_weight_sessions(session_opts)) {
-      return;
+    if (oit == tts_asset_files_.entries.end()) {
+      const auto split = split_weight_paths();
+      if (!split.first.empty()) {
+        model_ = registry.get(
+            model_key(shared_model_file_key(split.first) + "+" +
+                      shared_model_file_key(split.second)),
+            [&] {
+              const Ort::SessionOptions opts = session_opts();
+              auto model = std::make_shared<PiperSharedModel>();
+              model->split_weights =
+                  run_split_weights_model(model->env, split.second, opts);
+              model->session =
+                  open_piper_session(model->env, split.first, opts);
+              return model;
+            });
+        return;
+      }
     }
     if (oit != tts_asset_files_.entries.end()) {
       FileInformation& of = oit->second;
-      const uint8_t* ob = nullptr;
-      size_t on = 0;
-      of.load(&ob, &on);
-      require_ort_model_bytes(ob, on,
-                              "Piper voice supplied as " + k_piper_onnx);
-      session_ = Ort::Session(env_, ob, on, session_opts);
-      of.free();
+      const std::string key =
+          of.has_memory() ? shared_model_bytes_key(of.memory, of.memory_size)
+                          : shared_model_file_key(of.path);
+      model_ = registry.get(model_key(key), [&] {
+        const uint8_t* ob = nullptr;
+        size_t on = 0;
+        of.load(&ob, &on);
+        require_ort_model_bytes(ob, on,
+                                "Piper voice supplied as " + k_piper_onnx);
+        auto model = std::make_shared<PiperSharedModel>();
+        model->session = Ort::Session(model->env, ob, on, session_opts());
+        of.free();
+        return model;
+      });
     } else {
       // onnx_path_ is only an anchor for the voice name; the file on disk is
       // an .ort, in one of the two forms piper_voice_model_path knows.
@@ -667,13 +699,12 @@ struct PiperTTS::Impl {
                                  onnx_path_.stem().string() + " in " +
                                  onnx_path_.parent_path().string());
       }
-#ifdef _WIN32
-      const std::wstring wmodel = model_path.wstring();
-      session_ = Ort::Session(env_, wmodel.c_str(), session_opts);
-#else
-      const std::string u8 = model_path.string();
-      session_ = Ort::Session(env_, u8.c_str(), session_opts);
-#endif
+      model_ = registry.get(model_key(shared_model_file_key(model_path)), [&] {
+        auto model = std::make_shared<PiperSharedModel>();
+        model->session =
+            open_piper_session(model->env, model_path, session_opts());
+        return model;
+      });
     }
   }
 
@@ -683,6 +714,7 @@ struct PiperTTS::Impl {
         coreml_cache_dir_(opt.coreml_cache_dir),
         normalize_audio_(opt.normalize_audio),
         output_volume_(opt.output_volume),
+        pipeline_(opt.pipeline_synthesis),
         noise_scale_override_(opt.piper_noise_scale_override),
         noise_w_override_(opt.piper_noise_w_override),
         tts_asset_files_(opt.tts_asset_files) {
@@ -755,31 +787,152 @@ struct PiperTTS::Impl {
     reload_session();
   }
 
+  /// With ``pipeline_`` set, each sentence is one ORT run (as upstream Piper
+  /// does) while the next sentence goes through G2P on a worker thread.
   std::vector<float> synthesize(std::string_view text) {
-    const std::string ipa = g2p_->text_to_ipa(text, nullptr);
-    return synthesize_from_ipa(ipa);
+    std::vector<float> wave;
+    for_each_sentence_pipelined<std::vector<int64_t>>(
+        text, pipeline_,
+        [this](const std::string& piece) {
+          return piper_ids_for_ipa(
+              ipa_for_piper(g2p_->text_to_ipa(piece, nullptr)));
+        },
+        [&](std::vector<int64_t> ids) {
+          if (ids.size() >= 3) {
+            const std::vector<float> part = run_ort_raw(ids);
+            wave.insert(wave.end(), part.begin(), part.end());
+          }
+          return true;
+        });
+    if (wave.empty()) {
+      return {};
+    }
+    apply_synthesis_output_effects(wave, normalize_audio_, output_volume_);
+    return resample_to_output_rate(std::move(wave));
   }
 
-  std::vector<float> synthesize_from_ipa(std::string_view ipa_in) {
-    if (trim_ascii_ws_copy(ipa_in).empty()) {
+  /// Phoneme ids for Piper-normalized IPA; empty when there is nothing to
+  /// say.
+  std::vector<int64_t> piper_ids_for_ipa(const std::string& ipa) const {
+    if (trim_ascii_ws_copy(ipa).empty()) {
       return {};
     }
+    return ipa_utf8_to_piper_ids(ipa, phoneme_id_map_);
+  }
+
+  /// Normalizes G2P IPA to this voice's phoneme inventory.
+  std::string ipa_for_piper(std::string_view ipa_in) const {
     const std::string trimmed_ipa = trim_ascii_ws_copy(ipa_in);
-    const std::string ipa_for_piper =
-        coerce_unknown_ipa_chars_to_piper_inventory(
-            normalize_g2p_ipa_for_piper(trimmed_ipa, piper_ipa_lang_key_),
-            phoneme_map_keys_, true);
-    if (trim_ascii_ws_copy(ipa_for_piper).empty()) {
+    if (trimmed_ipa.empty()) {
       return {};
     }
-    std::vector<int64_t> ids =
-        ipa_utf8_to_piper_ids(ipa_for_piper, phoneme_id_map_);
+    return coerce_unknown_ipa_chars_to_piper_inventory(
+        normalize_g2p_ipa_for_piper(trimmed_ipa, piper_ipa_lang_key_),
+        phoneme_map_keys_, true);
+  }
+
+  std::vector<float> synthesize_from_ipa(std::string_view ipa_in) {
+    const std::vector<int64_t> ids = piper_ids_for_ipa(ipa_for_piper(ipa_in));
     if (ids.size() < 3) {
       return {};
     }
     return run_ort_from_phoneme_ids(ids);
   }
 
+  /// Sentences are converted on a worker thread and re-chunked with an
+  /// ``IncrementalChunker``, so the chunks match
+  /// ``synthesize_from_ipa_streaming`` on the whole text's IPA.
+  size_t synthesize_streaming(std::string_view text,
+                              const TtsAudioChunkCallback& on_audio) {
+    StreamingOutputEffects effects(normalize_audio_, output_volume_);
+    StreamingLinearResampler resampler(native_sample_rate_,
+                                       PiperTTS::kSampleRateHz);
+    size_t delivered = 0;
+    const auto split = [](const std::string& ipa, size_t released) {
+      return split_phonemes_for_streaming(
+          ipa,
+          streaming_chunk_budget(kTtsStreamFirstChunkPhonemes,
+                                 kPiperMaxStreamChunkPhonemes, released),
+          kPiperMaxStreamChunkPhonemes);
+    };
+    IncrementalChunker<std::string, decltype(split)> chunker(split, " ");
+    bool more = true;
+    for_each_sentence_pipelined<std::string>(
+        text, pipeline_,
+        [this](const std::string& piece) {
+          return ipa_for_piper(g2p_->text_to_ipa(piece, nullptr));
+        },
+        [&](std::string ipa) {
+          more = emit_streaming_chunks(chunker.add(ipa), effects, resampler,
+                                       on_audio, delivered);
+          return more;
+        });
+    if (more && emit_streaming_chunks(chunker.finish(), effects, resampler,
+                                      on_audio, delivered)) {
+      emit_resampler_tail(resampler, on_audio, delivered);
+    }
+    return delivered;
+  }
+
+  size_t synthesize_from_ipa_streaming(std::string_view ipa_in,
+                                       const TtsAudioChunkCallback& on_audio) {
+    StreamingOutputEffects effects(normalize_audio_, output_volume_);
+    StreamingLinearResampler resampler(native_sample_rate_,
+                                       PiperTTS::kSampleRateHz);
+    size_t delivered = 0;
+    if (emit_streaming_chunks(
+            split_phonemes_for_streaming(ipa_for_piper(ipa_in),
+                                         kTtsStreamFirstChunkPhonemes,
+                                         kPiperMaxStreamChunkPhonemes),
+            effects, resampler, on_audio, delivered)) {
+      emit_resampler_tail(resampler, on_audio, delivered);
+    }
+    return delivered;
+  }
+
+  /// Vocodes ``chunks`` in order and hands each to ``on_audio``. One
+  /// ``resampler`` serves the whole utterance, so chunk boundaries are
+  /// interpolated across rather than each chunk being stretched on its own.
+  /// Returns false once the callback asks to stop.
+  bool emit_streaming_chunks(const std::vector<std::string>& chunks,
+                             StreamingOutputEffects& effects,
+                             StreamingLinearResampler& resampler,
+                             const TtsAudioChunkCallback& on_audio,
+                             size_t& delivered) {
+    for (const std::string& chunk : chunks) {
+      const std::vector<int64_t> ids =
+          ipa_utf8_to_piper_ids(chunk, phoneme_id_map_);
+      if (ids.size() < 3) {
+        continue;
+      }
+      std::vector<float> wave = run_ort_raw(ids);
+      effects.apply(wave);
+      std::vector<float> out;
+      resampler.process(wave, out);
+      if (out.empty()) {
+        continue;
+      }
+      delivered += out.size();
+      if (!on_audio(out.data(), out.size())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Hands ``on_audio`` the output ``resampler`` still holds after the last
+  /// chunk.
+  void emit_resampler_tail(StreamingLinearResampler& resampler,
+                           const TtsAudioChunkCallback& on_audio,
+                           size_t& delivered) {
+    std::vector<float> out;
+    resampler.flush(out);
+    if (!out.empty()) {
+      delivered += out.size();
+      on_audio(out.data(), out.size());
+    }
+  }
+
   std::vector<float> synthesize_phoneme_ids(
       const std::vector<int64_t>& phoneme_ids) {
     return run_ort_from_phoneme_ids(phoneme_ids);
@@ -824,6 +977,16 @@ std::vector<float> PiperTTS::synthesize_from_ipa(std::string_view ipa) {
   return impl_->synthesize_from_ipa(ipa);
 }
 
+size_t PiperTTS::synthesize_streaming(std::string_view text,
+                                      const TtsAudioChunkCallback& on_audio) {
+  return impl_->synthesize_streaming(text, on_audio);
+}
+
+size_t PiperTTS::synthesize_from_ipa_streaming(
+    std::string_view ipa, const TtsAudioChunkCallback& on_audio) {
+  return impl_->synthesize_from_ipa_streaming(ipa, on_audio);
+}
+
 std::vector<float> PiperTTS::synthesize_phoneme_ids(
     const std::vector<int64_t>& phoneme_ids) {
   return impl_->synthesize_phoneme_ids(phoneme_ids);
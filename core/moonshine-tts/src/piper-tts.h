@@ -11,6 +11,7 @@
 
 #include "file-information.h"
 #include "moonshine-g2p-options.h"
+#include "moonshine-tts-options.h"
 
 namespace moonshine_tts {
 
@@ -52,6 +53,9 @@ struct PiperTTSOptions {
   bool normalize_audio = true;
   /// Match ``SynthesisConfig.volume`` (applied after normalize).
   float output_volume = 1.F;
+  /// Overlap G2P of the next sentence with inference on the current one
+  /// (see ``MoonshineTTSOptions::pipeline_synthesis``).
+  bool pipeline_synthesis = false;
   /// When set, replaces JSON ``inference.noise_scale`` for ORT (``0`` matches
   /// deterministic ``speak.py`` parity tests).
   std::optional<float> piper_noise_scale_override{};
@@ -95,6 +99,14 @@ class PiperTTS {
   /// running the ONNX vocoder.
   std::vector<float> synthesize_from_ipa(std::string_view ipa);
 
+  /// Streaming forms of ``synthesize`` / ``synthesize_from_ipa``: the IPA is
+  /// split with ``split_phonemes_for_streaming`` and each piece is vocoded and
+  /// passed to ``on_audio`` in turn. Returns the number of samples delivered.
+  size_t synthesize_streaming(std::string_view text,
+                              const TtsAudioChunkCallback& on_audio);
+  size_t synthesize_from_ipa_streaming(std::string_view ipa,
+                                       const TtsAudioChunkCallback& on_audio);
+
   /// Run ONNX on an existing Piper phoneme-id sequence (same layout as
   /// ``piper.phoneme_ids.phonemes_to_ids``), then apply ``normalize_audio`` /
   /// ``output_volume`` (via ``apply_synthesis_output_effects``) and resample to
@@ -1,11 +1,13 @@
 #ifndef MOONSHINE_TTS_RULE_BASED_G2P_H
 #define MOONSHINE_TTS_RULE_BASED_G2P_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace moonshine_tts {
 
+class G2pPronunciationCache;
 struct G2pWordLog;
 
 /// Shared interface for lexicon + rules G2P backends used by ``MoonshineG2P``.
@@ -15,6 +17,18 @@ class RuleBasedG2p {
 
   virtual std::string text_to_ipa(
       std::string text, std::vector<G2pWordLog>* per_word_log = nullptr) = 0;
+
+  /// Lets the engine reuse word pronunciations across calls through
+  /// ``cache``; ``scope`` identifies the dialect and options its output
+  /// depends on. Engines that only convert words in context may ignore it.
+  void set_pronunciation_cache(G2pPronunciationCache* cache, uint64_t scope) {
+    pronunciation_cache_ = cache;
+    pronunciation_cache_scope_ = scope;
+  }
+
+ protected:
+  G2pPronunciationCache* pronunciation_cache_ = nullptr;
+  uint64_t pronunciation_cache_scope_ = 0;
 };
 
 }  // namespace moonshine_tts
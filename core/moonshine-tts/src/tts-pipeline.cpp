@@ -0,0 +1,113 @@
+#include "tts-pipeline.h"
+
+#include "utf8-utils.h"
+
+namespace moonshine_tts {
+
+namespace {
+
+bool is_space_cp(char32_t c) {
+  return c == U' ' || c == U'\t' || c == U'\n' || c == U'\r' || c == U'\f' ||
+         c == U'\v' || c == U'\u00A0' || c == U'\u3000';
+}
+
+bool is_ascii_lower(char32_t c) { return c >= U'a' && c <= U'z'; }
+
+bool is_ascii_digit(char32_t c) { return c >= U'0' && c <= U'9'; }
+
+bool is_closing_mark(char32_t c) {
+  switch (c) {
+    case U'"':
+    case U'\'':
+    case U')':
+    case U']':
+    case U'\u00BB':  // »
+    case U'\u2019':  // ’
+    case U'\u201D':  // ”
+    case U'\u300D':  // 」
+    case U'\u300F':  // 』
+    case U'\uFF09':  // ）
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool is_cjk_terminator(char32_t c) {
+  return c == U'\u3002' || c == U'\uFF01' || c == U'\uFF1F';  // 。！？
+}
+
+/// Whether the ``.`` at ``dot`` ends a sentence, given that whitespace
+/// follows the closing marks ending at ``after``.
+bool period_ends_sentence(const std::u32string& u, size_t dot, size_t after) {
+  size_t word = dot;
+  while (word > 0 && !is_space_cp(u[word - 1])) {
+    --word;
+  }
+  while (word < dot && is_closing_mark(u[word])) {
+    ++word;
+  }
+  if (word == dot || !(is_ascii_lower(u[word]) || is_ascii_digit(u[word]))) {
+    return false;
+  }
+  size_t next = after;
+  while (next < u.size() && is_space_cp(u[next])) {
+    ++next;
+  }
+  return next < u.size() && !is_ascii_lower(u[next]);
+}
+
+}  // namespace
+
+std::vector<std::string> split_text_for_g2p_pipeline(std::string_view text) {
+  const std::u32string u = utf8_str_to_u32(std::string(text));
+  std::vector<std::string> sentences;
+  size_t start = 0;
+  const auto flush = [&](size_t end) {
+    std::string piece;
+    for (size_t i = start; i < end; ++i) {
+      utf8_append_codepoint(piece, u[i]);
+    }
+    piece = trim_ascii_ws_copy(piece);
+    if (!piece.empty()) {
+      sentences.push_back(std::move(piece));
+    }
+    start = end;
+  };
+  for (size_t i = 0; i < u.size(); ++i) {
+    const char32_t c = u[i];
+    if (c == U'\n') {
+      // A single line break is usually hard-wrapped prose; only a blank line
+      // separates paragraphs.
+      size_t next = i + 1;
+      while (next < u.size() && u[next] != U'\n' && is_space_cp(u[next])) {
+        ++next;
+      }
+      if (next < u.size() && u[next] == U'\n') {
+        flush(next + 1);
+        i = next;
+      }
+      continue;
+    }
+    const bool cjk = is_cjk_terminator(c);
+    if (!cjk && c != U'.' && c != U'!' && c != U'?') {
+      continue;
+    }
+    size_t after = i + 1;
+    while (after < u.size() &&
+           (is_closing_mark(u[after]) || is_cjk_terminator(u[after]) ||
+            u[after] == U'.' || u[after] == U'!' || u[after] == U'?')) {
+      ++after;
+    }
+    const bool space_follows = after < u.size() && is_space_cp(u[after]);
+    if (cjk || (space_follows &&
+                (c != U'.' || period_ends_sentence(u, i, after)))) {
+      flush(after);
+      i = after - 1;
+    }
+  }
+  flush(u.size());
+  return sentences;
+}
+
+}  // namespace moonshine_tts
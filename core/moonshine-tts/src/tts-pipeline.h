@@ -0,0 +1,206 @@
+#ifndef MOONSHINE_TTS_TTS_PIPELINE_H
+#define MOONSHINE_TTS_TTS_PIPELINE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace moonshine_tts {
+
+/// Splits ``text`` into sentences that can go through G2P independently, so
+/// that a later sentence's G2P can overlap vocoding of an earlier one. Only
+/// unambiguous boundaries are used: blank lines, CJK full stops, ``!`` / ``?``
+/// before whitespace, and ``.`` before whitespace when the word it ends starts
+/// with a lowercase letter or digit and the next word does not start
+/// lowercase (so ``Dr. Smith`` and ``U.S. Army`` stay whole). Closing quotes
+/// and brackets stay with their sentence. A single line break doesn't end a
+/// sentence, so hard-wrapped text isn't cut mid-sentence. Pieces are trimmed;
+/// empty ones are dropped.
+std::vector<std::string> split_text_for_g2p_pipeline(std::string_view text);
+
+/// Runs a producer on a worker thread and hands its items to the consumer
+/// thread in order through a bounded queue. ``produce`` receives a ``push``
+/// callable taking one ``T``; ``push`` blocks while ``capacity`` items are
+/// waiting and returns false once the consumer has gone away, after which the
+/// producer should return. An exception thrown by ``produce`` is rethrown by
+/// ``next`` after the items pushed before it. The destructor stops the
+/// producer and joins the worker.
+template <typename T>
+class PipelineStage {
+ public:
+  template <typename Produce>
+  explicit PipelineStage(Produce produce, std::size_t capacity = 2)
+      : capacity_(std::max<std::size_t>(capacity, 1)) {
+    worker_ = std::thread([this, produce = std::move(produce)]() mutable {
+      std::exception_ptr error;
+      try {
+        produce([this](T item) { return push(std::move(item)); });
+      } catch (...) {
+        error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(mu_);
+      error_ = error;
+      done_ = true;
+      cv_.notify_all();
+    });
+  }
+
+  PipelineStage(const PipelineStage&) = delete;
+  PipelineStage& operator=(const PipelineStage&) = delete;
+
+  ~PipelineStage() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      cancelled_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+  }
+
+  /// The next item, or ``std::nullopt`` once the producer has finished.
+  std::optional<T> next() {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this] { return !items_.empty() || done_; });
+    if (!items_.empty()) {
+      T item = std::move(items_.front());
+      items_.pop_front();
+      cv_.notify_all();
+      return item;
+    }
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+    return std::nullopt;
+  }
+
+ private:
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock,
+             [this] { return items_.size() < capacity_ || cancelled_; });
+    if (cancelled_) {
+      return false;
+    }
+    items_.push_back(std::move(item));
+    cv_.notify_all();
+    return true;
+  }
+
+  const std::size_t capacity_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<T> items_;
+  bool done_ = false;
+  bool cancelled_ = false;
+  std::exception_ptr error_;
+  // Declared last so the thread starts after everything it touches exists.
+  std::thread worker_;
+};
+
+/// Converts ``text`` to ``T`` one sentence at a time
+/// (``split_text_for_g2p_pipeline``) on a worker thread and passes each
+/// result to ``consume`` on the calling thread, so consuming one sentence
+/// overlaps converting the next. ``consume`` returns false to stop early.
+/// When ``pipelined`` is false or the text is a single sentence,
+/// ``to_units`` runs once on the whole text instead.
+template <typename T, typename ToUnits, typename Consume>
+void for_each_sentence_pipelined(std::string_view text, bool pipelined,
+                                 ToUnits&& to_units, Consume&& consume) {
+  std::vector<std::string> sentences;
+  if (pipelined) {
+    sentences = split_text_for_g2p_pipeline(text);
+  }
+  if (sentences.size() <= 1) {
+    consume(to_units(std::string(text)));
+    return;
+  }
+  PipelineStage<T> stage([&](const auto& push) {
+    for (const std::string& sentence : sentences) {
+      if (!push(to_units(sentence))) {
+        return;
+      }
+    }
+  });
+  while (std::optional<T> units = stage.next()) {
+    if (!consume(std::move(*units))) {
+      return;
+    }
+  }
+}
+
+/// Budget of the next streamed chunk once ``released`` chunks have gone out:
+/// ``first`` doubled per chunk and capped at ``max``, matching the growth rule
+/// of ``split_phonemes_for_streaming``.
+inline std::size_t streaming_chunk_budget(std::size_t first, std::size_t max,
+                                          std::size_t released) {
+  max = std::max<std::size_t>(max, 1);
+  std::size_t budget = std::clamp<std::size_t>(first, 1, max);
+  for (std::size_t i = 0; i < released && budget < max; ++i) {
+    budget = std::min(budget * 2, max);
+  }
+  return budget;
+}
+
+/// Greedy chunking of a sequence (phoneme string or token ids) that arrives
+/// in pieces. ``chunk(pending, released)`` splits the pending input, where
+/// ``released`` counts chunks already handed out (for growing budgets).
+/// Greedy cuts depend only on a prefix no longer than the budget, so every
+/// chunk but the last is final while more input may follow; the last one is
+/// held back and re-chunked with the next piece. The result matches chunking
+/// all the pieces joined by ``separator`` in one go.
+template <typename Seq, typename ChunkFn>
+class IncrementalChunker {
+ public:
+  IncrementalChunker(ChunkFn chunk, Seq separator)
+      : chunk_(std::move(chunk)), separator_(std::move(separator)) {}
+
+  /// Appends ``piece`` and returns the chunks that became final.
+  std::vector<Seq> add(const Seq& piece) {
+    if (piece.empty()) {
+      return {};
+    }
+    if (!pending_.empty()) {
+      pending_.insert(pending_.end(), separator_.begin(), separator_.end());
+    }
+    pending_.insert(pending_.end(), piece.begin(), piece.end());
+    std::vector<Seq> chunks = chunk_(pending_, released_);
+    if (chunks.empty()) {
+      pending_.clear();
+      return chunks;
+    }
+    pending_ = std::move(chunks.back());
+    chunks.pop_back();
+    released_ += chunks.size();
+    return chunks;
+  }
+
+  /// Returns the remaining chunks once no more input will follow.
+  std::vector<Seq> finish() {
+    std::vector<Seq> chunks;
+    if (!pending_.empty()) {
+      chunks = chunk_(pending_, released_);
+      pending_.clear();
+    }
+    released_ += chunks.size();
+    return chunks;
+  }
+
+ private:
+  ChunkFn chunk_;
+  Seq separator_;
+  Seq pending_{};
+  std::size_t released_ = 0;
+};
+
+}  // namespace moonshine_tts
+
+#endif  // MOONSHINE_TTS_TTS_PIPELINE_H
@@ -0,0 +1,148 @@
+#include "tts-shared-model.h"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+
+namespace moonshine_tts {
+namespace {
+
+/// SHA-256 (FIPS 180-4) of ``size`` bytes at ``data``. A key collision would
+/// hand one caller's weights to another, so in-memory models are keyed by a
+/// cryptographic digest rather than ``std::hash``.
+std::array<uint8_t, 32> sha256(const uint8_t* data, size_t size) {
+  static constexpr uint32_t kRound[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+      0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+      0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+      0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+      0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+      0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+      0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+      0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+      0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+  uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                       0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  const auto rotr = [](uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+  };
+  const auto compress = [&](const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+      w[i] = (uint32_t{block[4 * i]} << 24) |
+             (uint32_t{block[4 * i + 1]} << 16) |
+             (uint32_t{block[4 * i + 2]} << 8) | uint32_t{block[4 * i + 3]};
+    }
+    for (int i = 16; i < 64; ++i) {
+      const uint32_t s0 =
+          rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      const uint32_t s1 =
+          rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+      const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) +
+                          ((e & f) ^ (~e & g)) + kRound[i] + w[i];
+      const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) +
+                          ((a & b) ^ (a & c) ^ (b & c));
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  };
+
+  const size_t whole = size - size % 64;
+  for (size_t off = 0; off < whole; off += 64) {
+    compress(data + off);
+  }
+  // The tail, a 0x80 marker and the bit length fill one or two last blocks.
+  uint8_t tail[128] = {};
+  const size_t rest = size - whole;
+  if (rest > 0) {
+    std::memcpy(tail, data + whole, rest);
+  }
+  tail[rest] = 0x80;
+  const size_t tail_size = rest < 56 ? 64 : 128;
+  const uint64_t bits = static_cast<uint64_t>(size) * 8;
+  for (int i = 0; i < 8; ++i) {
+    tail[tail_size - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+  for (size_t off = 0; off < tail_size; off += 64) {
+    compress(tail + off);
+  }
+
+  std::array<uint8_t, 32> digest{};
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      digest[4 * i + j] = static_cast<uint8_t>(state[i] >> (24 - 8 * j));
+    }
+  }
+  return digest;
+}
+
+}  // namespace
+
+std::string shared_model_file_key(const std::filesystem::path& path) {
+  std::error_code ec;
+  std::filesystem::path canonical = std::filesystem::canonical(path, ec);
+  if (ec) {
+    canonical = path;
+  }
+  std::string key = "file:" + canonical.string();
+  const auto size = std::filesystem::file_size(canonical, ec);
+  if (!ec) {
+    key += ':';
+    key += std::to_string(size);
+  }
+  const auto mtime = std::filesystem::last_write_time(canonical, ec);
+  if (!ec) {
+    key += ':';
+    key += std::to_string(mtime.time_since_epoch().count());
+  }
+  return key;
+}
+
+std::string shared_model_bytes_key(const uint8_t* data, size_t size) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  std::string key = "bytes:";
+  key += std::to_string(size);
+  key += ':';
+  for (const uint8_t byte : sha256(data, size)) {
+    key += kHex[byte >> 4];
+    key += kHex[byte & 0xf];
+  }
+  return key;
+}
+
+std::string shared_model_session_key(
+    std::string key, const std::vector<std::string>& ort_provider_names,
+    const std::string& coreml_cache_dir) {
+  key += "|providers:";
+  for (const std::string& name : ort_provider_names) {
+    key += name;
+    key += ',';
+  }
+  key += "|coreml:";
+  key += coreml_cache_dir;
+  return key;
+}
+
+}  // namespace moonshine_tts
@@ -0,0 +1,69 @@
+#ifndef MOONSHINE_TTS_TTS_SHARED_MODEL_H
+#define MOONSHINE_TTS_TTS_SHARED_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace moonshine_tts {
+
+/// Identifies model weights on disk for sharing: canonical path, size and
+/// modification time, so a file replaced in place is loaded afresh.
+std::string shared_model_file_key(const std::filesystem::path& path);
+
+/// Identifies model weights supplied in memory: size and the SHA-256 of the
+/// bytes.
+std::string shared_model_bytes_key(const uint8_t* data, size_t size);
+
+/// Appends the session settings that change how a model is loaded (execution
+/// providers, CoreML cache) to ``key``.
+std::string shared_model_session_key(
+    std::string key, const std::vector<std::string>& ort_provider_names,
+    const std::string& coreml_cache_dir);
+
+/// Process-wide table of loaded models of one type. ``get`` returns the model
+/// already loaded under ``key`` while anything still holds it, and otherwise
+/// loads one with ``load``; a model is freed when its last holder releases
+/// it. Engines keep per-request state (voice, speed, G2P, output effects)
+/// themselves and share only the weights, so any number of synthesizers for
+/// the same model cost one copy of it. ORT allows ``Session::Run`` from
+/// several threads at once, which is what makes sharing sessions safe.
+template <typename Model>
+class SharedModelRegistry {
+ public:
+  static SharedModelRegistry& instance() {
+    static SharedModelRegistry registry;
+    return registry;
+  }
+
+  template <typename Load>
+  std::shared_ptr<Model> get(const std::string& key, Load&& load) {
+    std::lock_guard<std::mutex> lock(mu_);
+    const auto it = models_.find(key);
+    if (it != models_.end()) {
+      if (std::shared_ptr<Model> model = it->second.lock()) {
+        return model;
+      }
+    }
+    std::shared_ptr<Model> model = load();
+    std::erase_if(models_,
+                  [](const auto& entry) { return entry.second.expired(); });
+    models_[key] = model;
+    return model;
+  }
+
+ private:
+  SharedModelRegistry() = default;
+
+  std::mutex mu_;
+  std::unordered_map<std::string, std::weak_ptr<Model>> models_;
+};
+
+}  // namespace moonshine_tts
+
+#endif  // MOONSHINE_TTS_TTS_SHARED_MODEL_H
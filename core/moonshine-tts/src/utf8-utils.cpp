@@ -4,7 +4,7 @@
 
 namespace moonshine_tts {
 
-bool utf8_decode_at(const std::string& s, size_t i, char32_t& out_cp,
+bool utf8_decode_at(std::string_view s, size_t i, char32_t& out_cp,
                     size_t& out_len) {
   const size_t n = s.size();
   if (i >= n) {
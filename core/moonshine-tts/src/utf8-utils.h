@@ -16,7 +16,7 @@ void utf8_append_codepoint(std::string& out, char32_t cp);
 /// Decode one UTF-8 code point starting at byte index *i* in *s*. On success
 /// returns true and advances *out_len* bytes (always >= 1). Mirrors the lenient
 /// scan used across rule-based G2P.
-bool utf8_decode_at(const std::string& s, size_t i, char32_t& out_cp,
+bool utf8_decode_at(std::string_view s, size_t i, char32_t& out_cp,
                     size_t& out_len);
 
 /// Full-string scan to UTF-32 (invalid sequences yield one code unit per
@@ -0,0 +1,106 @@
+#include "zipvoice-batch.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+
+namespace moonshine_tts {
+
+ZipVoiceFmBatch zipvoice_pack_fm_batch(
+    const std::vector<std::vector<float>>& text_conditions,
+    const std::vector<int>& frames, const std::vector<float>& clone_features,
+    int clone_frames, int feat_dim, unsigned int seed) {
+  ZipVoiceFmBatch batch;
+  batch.rows = text_conditions.size();
+  batch.feat_dim = feat_dim;
+  for (const int f : frames) {
+    batch.frames = std::max(batch.frames, f);
+  }
+  const size_t feat = static_cast<size_t>(feat_dim);
+  const size_t row = static_cast<size_t>(batch.frames) * feat;
+  const size_t total = batch.rows * row;
+
+  // x ~ N(0, 1); text_condition / speech_condition are zero-padded along
+  // time, with speech_condition = pad(clone_features, to frames).
+  batch.x.resize(total);
+  batch.text_condition.assign(total, 0.F);
+  batch.speech_condition.assign(total, 0.F);
+  for (size_t b = 0; b < batch.rows; ++b) {
+    const auto base = static_cast<std::ptrdiff_t>(b * row);
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> dist(0.F, 1.F);
+    for (size_t i = 0; i < row; ++i) {
+      batch.x[b * row + i] = dist(rng);
+    }
+    std::copy(text_conditions[b].begin(), text_conditions[b].end(),
+              batch.text_condition.begin() + base);
+    const size_t copy_frames =
+        std::min<size_t>(static_cast<size_t>(std::max(clone_frames, 0)),
+                         static_cast<size_t>(std::max(frames[b], 0)));
+    std::copy(clone_features.begin(),
+              clone_features.begin() +
+                  static_cast<std::ptrdiff_t>(copy_frames * feat),
+              batch.speech_condition.begin() + base);
+  }
+  return batch;
+}
+
+void zipvoice_euler_solve(ZipVoiceFmBatch& batch, const std::vector<float>& ts,
+                          const ZipVoiceVelocity& velocity) {
+  for (size_t step = 0; step + 1 < ts.size(); ++step) {
+    const float* v = velocity(ts[step], batch);
+    const float dt = ts[step + 1] - ts[step];
+    for (size_t i = 0; i < batch.x.size(); ++i) {
+      batch.x[i] += v[i] * dt;
+    }
+  }
+}
+
+std::vector<ZipVoiceChunkFeatures> zipvoice_unpack_fm_batch(
+    const ZipVoiceFmBatch& batch, const std::vector<int>& frames,
+    int clone_frames) {
+  std::vector<ZipVoiceChunkFeatures> out(batch.rows);
+  const size_t feat = static_cast<size_t>(batch.feat_dim);
+  const size_t row = static_cast<size_t>(batch.frames) * feat;
+  // Trim the clone frames from the front and the padding from the back.
+  for (size_t b = 0; b < batch.rows; ++b) {
+    const int gen_frames = frames[b] - clone_frames;
+    if (gen_frames <= 0) {
+      continue;
+    }
+    const auto first = static_cast<std::ptrdiff_t>(
+        b * row + static_cast<size_t>(clone_frames) * feat);
+    out[b].gen_frames = gen_frames;
+    out[b].pred.assign(
+        batch.x.begin() + first,
+        batch.x.begin() + first +
+            static_cast<std::ptrdiff_t>(static_cast<size_t>(gen_frames) *
+                                        feat));
+  }
+  return out;
+}
+
+std::vector<float> zipvoice_pack_vocoder_batch(
+    const std::vector<const ZipVoiceChunkFeatures*>& items, int feat_dim,
+    float feat_scale, size_t t_max) {
+  const size_t feat = static_cast<size_t>(feat_dim);
+  // mel: [B, feat, T], mel[b,c,t] = pred_b[t,c] / feat_scale.
+  std::vector<float> mel(items.size() * feat * t_max, kZipVoiceSilentLogMel);
+  for (size_t b = 0; b < items.size(); ++b) {
+    const ZipVoiceChunkFeatures& f = *items[b];
+    float* dst = mel.data() + b * feat * t_max;
+    for (size_t t = 0; t < static_cast<size_t>(f.gen_frames); ++t) {
+      for (size_t c = 0; c < feat; ++c) {
+        dst[c * t_max + t] = f.pred[t * feat + c] / feat_scale;
+      }
+    }
+  }
+  return mel;
+}
+
+size_t zipvoice_vocoder_row_samples(size_t per_item, size_t frames,
+                                    size_t t_max) {
+  return frames == t_max ? per_item : per_item * frames / t_max;
+}
+
+}  // namespace moonshine_tts
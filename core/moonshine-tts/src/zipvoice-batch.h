@@ -0,0 +1,77 @@
+#ifndef MOONSHINE_TTS_ZIPVOICE_BATCH_H
+#define MOONSHINE_TTS_ZIPVOICE_BATCH_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/// Tensor layout of ZipVoice's batched flow matching and vocoding, kept apart
+/// from the ONNX sessions so the padding and trimming can be tested without a
+/// model.
+
+namespace moonshine_tts {
+
+/// Flow-matching output for one chunk, waiting for the vocoder.
+struct ZipVoiceChunkFeatures {
+  std::vector<float> pred;  // [gen_frames * feat_dim] row-major
+  int gen_frames = 0;
+};
+
+/// The fm_decoder inputs for a batch of chunks, each ``[rows, frames,
+/// feat_dim]`` with chunks padded at the end to the longest one's frame
+/// count.
+struct ZipVoiceFmBatch {
+  size_t rows = 0;
+  int frames = 0;
+  int feat_dim = 0;
+  /// Latent; each row starts with the same ``seed`` noise it would get alone.
+  std::vector<float> x;
+  /// Text encoder output, zero-padded along time.
+  std::vector<float> text_condition;
+  /// The clone's features over each row's first frames, zero-padded.
+  std::vector<float> speech_condition;
+};
+
+/// Packs the text encoder outputs ``text_conditions`` (``frames[b] *
+/// feat_dim`` floats each) and the clone's features into one batch. A batch
+/// of one is laid out exactly as an unbatched solve.
+ZipVoiceFmBatch zipvoice_pack_fm_batch(
+    const std::vector<std::vector<float>>& text_conditions,
+    const std::vector<int>& frames, const std::vector<float>& clone_features,
+    int clone_frames, int feat_dim, unsigned int seed);
+
+/// The velocity at time ``t`` for every element of ``batch.x``; the returned
+/// buffer only has to stay valid until the next call. ``batch`` is passed
+/// mutable so its buffers can back ONNX tensors, but must not be changed.
+using ZipVoiceVelocity =
+    std::function<const float*(float t, ZipVoiceFmBatch& batch)>;
+
+/// Euler steps of ``batch.x`` over the time grid ``ts``.
+void zipvoice_euler_solve(ZipVoiceFmBatch& batch, const std::vector<float>& ts,
+                          const ZipVoiceVelocity& velocity);
+
+/// Each row's generated features: ``frames[b]`` less the clone's frames from
+/// the front, without the padding. Rows with nothing generated come back
+/// empty.
+std::vector<ZipVoiceChunkFeatures> zipvoice_unpack_fm_batch(
+    const ZipVoiceFmBatch& batch, const std::vector<int>& frames,
+    int clone_frames);
+
+/// Log-mel value of silence (the fbank clamps power at 1e-7), used to pad
+/// shorter chunks in a batched vocoder call.
+inline constexpr float kZipVoiceSilentLogMel = -16.118095F;
+
+/// The vocoder's ``[rows, feat_dim, t_max]`` mel input, ``pred / feat_scale``
+/// transposed, with each row padded with silence after its own frames.
+std::vector<float> zipvoice_pack_vocoder_batch(
+    const std::vector<const ZipVoiceChunkFeatures*>& items, int feat_dim,
+    float feat_scale, size_t t_max);
+
+/// Samples to keep of a row with ``frames`` of the batch's ``t_max`` frames,
+/// when the vocoder returned ``per_item`` samples per row.
+size_t zipvoice_vocoder_row_samples(size_t per_item, size_t frames,
+                                    size_t t_max);
+
+}  // namespace moonshine_tts
+
+#endif  // MOONSHINE_TTS_ZIPVOICE_BATCH_H
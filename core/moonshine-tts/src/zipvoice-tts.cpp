@@ -8,7 +8,8 @@
 #include <cmath>
 #include <cstdint>
 #include <fstream>
-#include <random>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -18,11 +19,15 @@
 #include "debug-utils.h"
 #include "g2p-path.h"
 #include "ipa-postprocess.h"
+#include "linear-resample.h"
 #include "moonshine-g2p.h"
 #include "moonshine-tts-options.h"
 #include "ort-session-options.h"
 #include "ort-utils-cxx.h"
+#include "tts-pipeline.h"
+#include "tts-shared-model.h"
 #include "utf8-utils.h"
+#include "zipvoice-batch.h"
 #include "zipvoice-custom-ops.h"
 #include "zipvoice-mel.h"
 #include "zipvoice-voices.h"
@@ -57,49 +62,34 @@ void resolve_zipvoice_lang(const std::string& lang, std::string& g2p_dialect,
   ipa_lang_key = "en_us";  // ZipVoice was trained with en-us espeak phonemes.
 }
 
-std::vector<float> resample_linear(const std::vector<float>& x, int src_sr,
-                                   int dst_sr) {
-  if (src_sr == dst_sr || x.size() < 2) {
-    return x;
-  }
-  const double duration =
-      static_cast<double>(x.size() - 1) / static_cast<double>(src_sr);
-  const size_t n_out = std::max<size_t>(
-      2, static_cast<size_t>(std::llround(duration * dst_sr)) + 1);
-  std::vector<float> y(n_out);
-  for (size_t i = 0; i < n_out; ++i) {
-    const double t =
-        static_cast<double>(i) * duration / static_cast<double>(n_out - 1);
-    const double fidx = t * static_cast<double>(src_sr);
-    const size_t i0 = static_cast<size_t>(std::floor(fidx));
-    const size_t i1 = std::min(i0 + 1, x.size() - 1);
-    const double frac = fidx - static_cast<double>(i0);
-    y[i] = static_cast<float>(x[i0] * (1.0 - frac) + x[i1] * frac);
-  }
-  return y;
-}
+constexpr float kEdgeSilenceThreshold = 0.0031622776601683794F;  // -50 dBFS
+constexpr int kEdgeSilenceKeepMs = 100;
 
 /// Approximate ``remove_silence`` edge trimming (pydub
 /// ``remove_silence_edges``): drop leading and trailing samples below ``-50``
 /// dBFS, keeping ``100`` ms of margin, then append ``trail_sil_ms`` of silence.
 /// A sample-level approximation of pydub's chunk-based detector; adequate for
-/// clean clips.
+/// clean clips. ``trim_start`` / ``trim_end`` limit trimming to one edge, for
+/// streamed output whose other edge has not been produced yet.
 std::vector<float> trim_edge_silence(const std::vector<float>& wav,
-                                     int sample_rate, int trail_sil_ms) {
-  const float thresh = 0.0031622776601683794F;  // 10^(-50/20)
-  const int keep = (100 * sample_rate) / 1000;
+                                     int sample_rate, int trail_sil_ms,
+                                     bool trim_start = true,
+                                     bool trim_end = true) {
+  const float thresh = kEdgeSilenceThreshold;
+  const int keep = (kEdgeSilenceKeepMs * sample_rate) / 1000;
   size_t begin = 0;
-  while (begin < wav.size() && std::fabs(wav[begin]) <= thresh) {
+  while (trim_start && begin < wav.size() && std::fabs(wav[begin]) <= thresh) {
     ++begin;
   }
   size_t start = (begin > static_cast<size_t>(keep))
                      ? begin - static_cast<size_t>(keep)
                      : 0;
   size_t last = wav.size();
-  while (last > start && std::fabs(wav[last - 1]) <= thresh) {
+  while (trim_end && last > start && std::fabs(wav[last - 1]) <= thresh) {
     --last;
   }
-  size_t end = std::min(wav.size(), last + static_cast<size_t>(keep));
+  size_t end = trim_end ? std::min(wav.size(), last + static_cast<size_t>(keep))
+                        : wav.size();
   if (end <= start) {
     // All silence: keep the original to avoid an empty clone.
     start = 0;
@@ -170,6 +160,14 @@ std::unordered_map<std::string, int> parse_tokens_txt(const char* data,
   return token2id;
 }
 
+// The three ZipVoice graphs, shared by every instance loaded from them.
+struct ZipVoiceSharedModel {
+  Ort::Env env = make_ort_env(ORT_LOGGING_LEVEL_WARNING, "moonshine_zipvoice");
+  Ort::Session text_encoder{nullptr};
+  Ort::Session fm_decoder{nullptr};
+  Ort::Session vocoder{nullptr};
+};
+
 }  // namespace
 
 struct ZipVoiceTTS::Impl {
@@ -177,6 +175,8 @@ struct ZipVoiceTTS::Impl {
   double speed_ = 1.0;
   bool normalize_audio_ = false;
   float output_volume_ = 1.F;
+  bool pipeline_ = true;
+  size_t max_batch_chunks_ = 1;
   int num_step_ = 8;
   float guidance_scale_ = 3.F;
   float t_shift_ = 0.5F;
@@ -195,12 +195,10 @@ struct ZipVoiceTTS::Impl {
   FileInformationMap tts_files_{};
   std::vector<std::string> ort_provider_names_{};
   std::string coreml_cache_dir_{};
-  Ort::Env env_ = make_ort_env(ORT_LOGGING_LEVEL_WARNING, "moonshine_zipvoice");
   Ort::MemoryInfo mem_{
       Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)};
-  Ort::Session text_encoder_{nullptr};
-  Ort::Session fm_decoder_{nullptr};
-  Ort::Session vocoder_{nullptr};
+  // Shared with every instance loaded from the same three models; only read.
+  std::shared_ptr<ZipVoiceSharedModel> model_{};
   std::vector<std::string> te_in_, te_out_, fm_in_, fm_out_, vo_in_, vo_out_;
 
   // Prepared clone.
@@ -208,6 +206,8 @@ struct ZipVoiceTTS::Impl {
   int clone_frames_ = 0;
   float clone_rms_ = 0.F;
   std::vector<int64_t> clone_token_ids_{};
+  // Whether the conditioning above came from ``clone_cache_dir``.
+  bool clone_from_cache_ = false;
 
   ~Impl() {
     for (auto& e : tts_files_.entries) {
@@ -215,7 +215,28 @@ struct ZipVoiceTTS::Impl {
     }
   }
 
-  Ort::Session load_session(std::string_view key, bool register_custom_ops,
+  // On-disk location of the ``key`` model when it is not supplied in memory.
+  std::filesystem::path model_file_path(const std::string& k) const {
+    const auto it = tts_files_.entries.find(k);
+    return (it != tts_files_.entries.end() && !it->second.path.empty())
+               ? resolve_path_under_root(g2p_opt_.g2p_root, it->second.path)
+               : resolve_path_under_root(g2p_opt_.g2p_root,
+                                         std::filesystem::path(k));
+  }
+
+  // Identifies the ``key`` model's weights for the shared model registry.
+  std::string model_identity(std::string_view key) const {
+    const std::string k(key);
+    const auto it = tts_files_.entries.find(k);
+    if (it != tts_files_.entries.end() && it->second.has_memory()) {
+      return shared_model_bytes_key(it->second.memory,
+                                    it->second.memory_size);
+    }
+    return shared_model_file_key(model_file_path(k));
+  }
+
+  Ort::Session load_session(Ort::Env& env, std::string_view key,
+                            bool register_custom_ops,
                             const std::vector<std::string>& providers) {
     Ort::SessionOptions opts =
         make_ort_session_options(providers, coreml_cache_dir_);
@@ -230,25 +251,21 @@ struct ZipVoiceTTS::Impl {
       size_t n = 0;
       it->second.load(&b, &n);
       require_ort_model_bytes(b, n, "ZipVoice model supplied as " + k);
-      Ort::Session s(env_, b, n, opts);
+      Ort::Session s(env, b, n, opts);
       it->second.free();
       return s;
     }
-    std::filesystem::path p =
-        (it != tts_files_.entries.end() && !it->second.path.empty())
-            ? resolve_path_under_root(g2p_opt_.g2p_root, it->second.path)
-            : resolve_path_under_root(g2p_opt_.g2p_root,
-                                      std::filesystem::path(k));
+    const std::filesystem::path p = model_file_path(k);
     require_ort_model_path(p, "ZipVoice model file");
     if (!std::filesystem::is_regular_file(p)) {
       throw std::runtime_error("ZipVoiceTTS: missing model file " + p.string());
     }
 #ifdef _WIN32
     const std::wstring w = p.wstring();
-    return Ort::Session(env_, w.c_str(), opts);
+    return Ort::Session(env, w.c_str(), opts);
 #else
     const std::string u8 = p.string();
-    return Ort::Session(env_, u8.c_str(), opts);
+    return Ort::Session(env, u8.c_str(), opts);
 #endif
   }
 
@@ -309,6 +326,9 @@ struct ZipVoiceTTS::Impl {
     }
     speed_ = opt.speed;
     normalize_audio_ = opt.normalize_audio;
+    pipeline_ = opt.pipeline_synthesis;
+    max_batch_chunks_ =
+        static_cast<size_t>(std::max(opt.max_batch_chunks, 1));
     output_volume_ = opt.output_volume;
     t_shift_ = opt.t_shift;
     feat_scale_ = opt.feat_scale;
@@ -330,8 +350,10 @@ struct ZipVoiceTTS::Impl {
     resolve_zipvoice_lang(opt.lang, g2p_dialect, ipa_lang_key_);
 
     // tokens.txt (phoneme -> id) and optional model.json (feat_dim).
+    uint64_t tokens_hash = 0;
     {
       const std::vector<uint8_t> tok = load_asset_bytes(kTtsZipVoiceTokensKey);
+      tokens_hash = zipvoice_content_hash(tok.data(), tok.size());
       token2id_ = parse_tokens_txt(reinterpret_cast<const char*>(tok.data()),
                                    tok.size());
       if (token2id_.empty()) {
@@ -361,20 +383,31 @@ struct ZipVoiceTTS::Impl {
           "ZipVoiceTTS: unsupported feat_dim (expected 100)");
     }
 
-    text_encoder_ =
-        load_session(kTtsZipVoiceTextEncoderKey, /*register_custom_ops=*/false,
-                     ort_provider_names_);
-    fm_decoder_ =
-        load_session(kTtsZipVoiceFmDecoderKey, /*register_custom_ops=*/true,
-                     ort_provider_names_);
-    vocoder_ = load_session(kTtsZipVoiceVocoderKey,
-                            /*register_custom_ops=*/false, ort_provider_names_);
-    te_in_ = text_encoder_.GetInputNames();
-    te_out_ = text_encoder_.GetOutputNames();
-    fm_in_ = fm_decoder_.GetInputNames();
-    fm_out_ = fm_decoder_.GetOutputNames();
-    vo_in_ = vocoder_.GetInputNames();
-    vo_out_ = vocoder_.GetOutputNames();
+    const std::string model_key = shared_model_session_key(
+        model_identity(kTtsZipVoiceTextEncoderKey) + "+" +
+            model_identity(kTtsZipVoiceFmDecoderKey) + "+" +
+            model_identity(kTtsZipVoiceVocoderKey),
+        ort_provider_names_, coreml_cache_dir_);
+    model_ = SharedModelRegistry<ZipVoiceSharedModel>::instance().get(
+        model_key, [&] {
+          auto model = std::make_shared<ZipVoiceSharedModel>();
+          model->text_encoder = load_session(
+              model->env, kTtsZipVoiceTextEncoderKey,
+              /*register_custom_ops=*/false, ort_provider_names_);
+          model->fm_decoder = load_session(
+              model->env, kTtsZipVoiceFmDecoderKey,
+              /*register_custom_ops=*/true, ort_provider_names_);
+          model->vocoder = load_session(
+              model->env, kTtsZipVoiceVocoderKey,
+              /*register_custom_ops=*/false, ort_provider_names_);
+          return model;
+        });
+    te_in_ = model_->text_encoder.GetInputNames();
+    te_out_ = model_->text_encoder.GetOutputNames();
+    fm_in_ = model_->fm_decoder.GetInputNames();
+    fm_out_ = model_->fm_decoder.GetOutputNames();
+    vo_in_ = model_->vocoder.GetInputNames();
+    vo_out_ = model_->vocoder.GetOutputNames();
     if (te_in_.size() < 4 || fm_in_.size() < 5 || vo_in_.empty()) {
       throw std::runtime_error("ZipVoiceTTS: unexpected ONNX input signature");
     }
@@ -402,24 +435,75 @@ struct ZipVoiceTTS::Impl {
           "ZipVoiceTTS: no reference voice supplied (set a built-in voice id "
           "or clone PCM)");
     }
+    ZipVoiceCloneConditioning clone;
+    const std::filesystem::path& cache_dir = opt.clone_cache_dir;
+    uint64_t cache_key = 0;
+    if (!cache_dir.empty()) {
+      cache_key = clone_cache_key(clone_pcm, clone_sr, clone_text, g2p_dialect,
+                                  tokens_hash);
+    }
+    clone_from_cache_ =
+        !cache_dir.empty() &&
+        zipvoice_load_clone_conditioning(cache_dir, cache_key, &clone) &&
+        clone.feat_dim == feat_dim_;
+    if (!clone_from_cache_) {
+      clone = prepare_clone(std::move(clone_pcm), clone_sr, clone_text);
+      if (!cache_dir.empty()) {
+        // A read-only or full cache only costs the next process the fbank
+        // and transcript G2P again.
+        (void)zipvoice_save_clone_conditioning(cache_dir, cache_key, clone);
+      }
+    }
+    clone_features_ = std::move(clone.features);
+    clone_frames_ = clone.frames;
+    clone_rms_ = clone.rms;
+    clone_token_ids_ = std::move(clone.token_ids);
+  }
+
+  // Cache key for a reference clip: everything ``prepare_clone`` reads,
+  // plus the token table and G2P dialect that map the transcript to ids.
+  uint64_t clone_cache_key(const std::vector<float>& pcm, int sample_rate,
+                           const std::string& transcript,
+                           const std::string& g2p_dialect,
+                           uint64_t tokens_hash) const {
+    constexpr std::string_view kVersion = "zipvoice-clone-v1";
+    uint64_t h = zipvoice_content_hash(kVersion.data(), kVersion.size());
+    h = zipvoice_content_hash(pcm.data(), pcm.size() * sizeof(float), h);
+    h = zipvoice_content_hash(&sample_rate, sizeof(sample_rate), h);
+    h = zipvoice_content_hash(transcript.data(), transcript.size(), h);
+    h = zipvoice_content_hash(g2p_dialect.data(), g2p_dialect.size(), h);
+    h = zipvoice_content_hash(ipa_lang_key_.data(), ipa_lang_key_.size(), h);
+    h = zipvoice_content_hash(&tokens_hash, sizeof(tokens_hash), h);
+    h = zipvoice_content_hash(&feat_scale_, sizeof(feat_scale_), h);
+    return zipvoice_content_hash(&target_rms_, sizeof(target_rms_), h);
+  }
+
+  // Resamples, trims and level-matches the reference clip, then extracts its
+  // scaled fbank features and the transcript's token ids.
+  ZipVoiceCloneConditioning prepare_clone(std::vector<float> clone_pcm,
+                                          int clone_sr,
+                                          const std::string& clone_text) {
+    ZipVoiceCloneConditioning clone;
     if (clone_sr != VocosFbank::kSampleRate) {
       clone_pcm = resample_linear(clone_pcm, clone_sr, VocosFbank::kSampleRate);
     }
     clone_pcm = trim_edge_silence(clone_pcm, VocosFbank::kSampleRate,
                                   /*trail_sil_ms=*/200);
-    clone_rms_ = rms_of(clone_pcm);
-    if (clone_rms_ > 0.F && clone_rms_ < target_rms_) {
-      const float g = target_rms_ / clone_rms_;
+    clone.rms = rms_of(clone_pcm);
+    if (clone.rms > 0.F && clone.rms < target_rms_) {
+      const float g = target_rms_ / clone.rms;
       for (float& s : clone_pcm) {
         s *= g;
       }
     }
     VocosFbank fbank;
-    clone_features_ = fbank.extract(clone_pcm, &clone_frames_);
-    for (float& v : clone_features_) {
+    clone.features = fbank.extract(clone_pcm, &clone.frames);
+    for (float& v : clone.features) {
       v *= feat_scale_;
     }
-    clone_token_ids_ = ipa_text_to_token_ids(clone_text);
+    clone.feat_dim = feat_dim_;
+    clone.token_ids = ipa_text_to_token_ids(clone_text);
+    return clone;
   }
 
   double speed() const { return speed_; }
@@ -466,8 +550,9 @@ struct ZipVoiceTTS::Impl {
                                         te_in_[2].c_str(), te_in_[3].c_str()};
     const char* out_names[] = {te_out_[0].c_str()};
     Ort::RunOptions run_opts{nullptr};
-    auto outputs = text_encoder_.Run(run_opts, in_names.data(), inputs.data(),
-                                     inputs.size(), out_names, 1);
+    auto outputs = model_->text_encoder.Run(run_opts, in_names.data(),
+                                            inputs.data(), inputs.size(),
+                                            out_names, 1);
     const Ort::Value& tc = outputs[0];
     const auto ti = tc.GetTensorTypeAndShapeInfo();
     const std::vector<int64_t> shape = ti.GetShape();
@@ -483,124 +568,118 @@ struct ZipVoiceTTS::Impl {
     return std::vector<float>(p, p + n);
   }
 
-  // One flow-matching Euler solve for a chunk; returns predicted features
-  // [T_gen*feat_dim] (row-major).
-  std::vector<float> sample_chunk(const std::vector<int64_t>& tokens,
-                                  int* out_gen_frames) {
-    int frames = 0;
-    std::vector<float> text_condition = run_text_encoder(tokens, &frames);
-    if (frames <= 0) {
-      *out_gen_frames = 0;
-      return {};
+  using ChunkFeatures = ZipVoiceChunkFeatures;
+
+  // One flow-matching Euler solve for a batch of chunks. Each chunk is padded
+  // at the end to the longest one's frame count, so every step is a single
+  // fm_decoder call; the graph has no padding mask, so padded frames are
+  // visible to attention and a batched chunk can differ slightly from the
+  // same chunk sampled alone. A chunk's latent starts with the same noise
+  // either way. Returns predicted features with the clone frames trimmed.
+  std::vector<ChunkFeatures> sample_chunks(
+      const std::vector<std::vector<int64_t>>& chunks) {
+    const size_t batch = chunks.size();
+    std::vector<std::vector<float>> conditions(batch);
+    std::vector<int> frames(batch, 0);
+    int max_frames = 0;
+    for (size_t b = 0; b < batch; ++b) {
+      conditions[b] = run_text_encoder(chunks[b], &frames[b]);
+      max_frames = std::max(max_frames, frames[b]);
     }
-    const size_t feat = static_cast<size_t>(feat_dim_);
-    const size_t total = static_cast<size_t>(frames) * feat;
-
-    // x ~ N(0, 1)
-    std::vector<float> x(total);
-    std::mt19937 rng(seed_);
-    std::normal_distribution<float> dist(0.F, 1.F);
-    for (size_t i = 0; i < total; ++i) {
-      x[i] = dist(rng);
-    }
-    // speech_condition = pad(clone_features, to frames) along time.
-    std::vector<float> speech_condition(total, 0.F);
-    const size_t copy_frames = std::min<size_t>(
-        static_cast<size_t>(clone_frames_), static_cast<size_t>(frames));
-    std::copy(clone_features_.begin(),
-              clone_features_.begin() +
-                  static_cast<std::ptrdiff_t>(copy_frames * feat),
-              speech_condition.begin());
-
-    const std::vector<float> ts = get_time_steps(num_step_, t_shift_);
-    const std::array<int64_t, 3> shape3{1, frames, static_cast<int64_t>(feat)};
-    float guidance = guidance_scale_;
+    if (max_frames <= 0) {
+      return std::vector<ChunkFeatures>(batch);
+    }
+    ZipVoiceFmBatch fm = zipvoice_pack_fm_batch(
+        conditions, frames, clone_features_, clone_frames_, feat_dim_, seed_);
 
+    const std::array<int64_t, 3> shape3{static_cast<int64_t>(batch),
+                                        max_frames,
+                                        static_cast<int64_t>(feat_dim_)};
+    float guidance = guidance_scale_;
     std::array<const char*, 5> in_names{fm_in_[0].c_str(), fm_in_[1].c_str(),
                                         fm_in_[2].c_str(), fm_in_[3].c_str(),
                                         fm_in_[4].c_str()};
     const char* out_names[] = {fm_out_[0].c_str()};
     Ort::RunOptions run_opts{nullptr};
+    std::vector<Ort::Value> outputs;
+    zipvoice_euler_solve(
+        fm, get_time_steps(num_step_, t_shift_),
+        [&](float t, ZipVoiceFmBatch& in) {
+          float t_val = t;
+          std::vector<Ort::Value> inputs;
+          inputs.push_back(
+              Ort::Value::CreateTensor<float>(mem_, &t_val, 1, nullptr, 0));
+          inputs.push_back(Ort::Value::CreateTensor<float>(
+              mem_, in.x.data(), in.x.size(), shape3.data(), shape3.size()));
+          inputs.push_back(Ort::Value::CreateTensor<float>(
+              mem_, in.text_condition.data(), in.text_condition.size(),
+              shape3.data(), shape3.size()));
+          inputs.push_back(Ort::Value::CreateTensor<float>(
+              mem_, in.speech_condition.data(), in.speech_condition.size(),
+              shape3.data(), shape3.size()));
+          inputs.push_back(
+              Ort::Value::CreateTensor<float>(mem_, &guidance, 1, nullptr, 0));
+          outputs = model_->fm_decoder.Run(run_opts, in_names.data(),
+                                           inputs.data(), inputs.size(),
+                                           out_names, 1);
+          return outputs[0].GetTensorData<float>();
+        });
+    return zipvoice_unpack_fm_batch(fm, frames, clone_frames_);
+  }
 
-    for (int step = 0; step < num_step_; ++step) {
-      float t_val = ts[static_cast<size_t>(step)];
-      std::vector<Ort::Value> inputs;
-      inputs.push_back(
-          Ort::Value::CreateTensor<float>(mem_, &t_val, 1, nullptr, 0));
-      inputs.push_back(Ort::Value::CreateTensor<float>(
-          mem_, x.data(), x.size(), shape3.data(), shape3.size()));
-      inputs.push_back(Ort::Value::CreateTensor<float>(
-          mem_, text_condition.data(), text_condition.size(), shape3.data(),
-          shape3.size()));
-      inputs.push_back(Ort::Value::CreateTensor<float>(
-          mem_, speech_condition.data(), speech_condition.size(), shape3.data(),
-          shape3.size()));
-      inputs.push_back(
-          Ort::Value::CreateTensor<float>(mem_, &guidance, 1, nullptr, 0));
-      auto outputs = fm_decoder_.Run(run_opts, in_names.data(), inputs.data(),
-                                     inputs.size(), out_names, 1);
-      const Ort::Value& vv = outputs[0];
-      const float* vptr = vv.GetTensorData<float>();
-      const float dt =
-          ts[static_cast<size_t>(step + 1)] - ts[static_cast<size_t>(step)];
-      for (size_t i = 0; i < total; ++i) {
-        x[i] += vptr[i] * dt;
+  // pred -> vocoder -> waveform, for a batch of chunks in one call. Shorter
+  // chunks are padded with silence and their output trimmed to their own
+  // frame count. Chunks with no frames get an empty waveform.
+  std::vector<std::vector<float>> run_vocoder(
+      const std::vector<const ChunkFeatures*>& items) {
+    std::vector<std::vector<float>> wavs(items.size());
+    std::vector<size_t> live;
+    std::vector<const ChunkFeatures*> live_items;
+    int max_frames = 0;
+    for (size_t i = 0; i < items.size(); ++i) {
+      if (items[i]->gen_frames > 0 && !items[i]->pred.empty()) {
+        live.push_back(i);
+        live_items.push_back(items[i]);
+        max_frames = std::max(max_frames, items[i]->gen_frames);
       }
     }
-
-    // Trim the clone frames from the front.
-    const int gen_frames = frames - clone_frames_;
-    *out_gen_frames = gen_frames;
-    if (gen_frames <= 0) {
-      return {};
-    }
-    std::vector<float> pred(static_cast<size_t>(gen_frames) * feat);
-    std::copy(x.begin() + static_cast<std::ptrdiff_t>(
-                              static_cast<size_t>(clone_frames_) * feat),
-              x.end(), pred.begin());
-    return pred;
-  }
-
-  // pred [T_gen*feat] row-major -> vocoder -> waveform.
-  std::vector<float> run_vocoder(const std::vector<float>& pred,
-                                 int gen_frames) {
-    const size_t feat = static_cast<size_t>(feat_dim_);
-    // mel: [1, feat, T_gen], mel[0,c,t] = pred[t,c] / feat_scale.
-    std::vector<float> mel(static_cast<size_t>(gen_frames) * feat);
-    for (int t = 0; t < gen_frames; ++t) {
-      for (size_t c = 0; c < feat; ++c) {
-        mel[c * static_cast<size_t>(gen_frames) + static_cast<size_t>(t)] =
-            pred[static_cast<size_t>(t) * feat + c] / feat_scale_;
-      }
+    if (live.empty()) {
+      return wavs;
     }
-    const std::array<int64_t, 3> shape{1, static_cast<int64_t>(feat),
-                                       gen_frames};
+    const size_t t_max = static_cast<size_t>(max_frames);
+    std::vector<float> mel =
+        zipvoice_pack_vocoder_batch(live_items, feat_dim_, feat_scale_, t_max);
+    const std::array<int64_t, 3> shape{static_cast<int64_t>(live.size()),
+                                       static_cast<int64_t>(feat_dim_),
+                                       static_cast<int64_t>(t_max)};
     std::vector<Ort::Value> inputs;
     inputs.push_back(Ort::Value::CreateTensor<float>(
         mem_, mel.data(), mel.size(), shape.data(), shape.size()));
     const char* in_names[] = {vo_in_[0].c_str()};
     const char* out_names[] = {vo_out_[0].c_str()};
     Ort::RunOptions run_opts{nullptr};
-    auto outputs = vocoder_.Run(run_opts, in_names, inputs.data(),
-                                inputs.size(), out_names, 1);
+    auto outputs = model_->vocoder.Run(run_opts, in_names, inputs.data(),
+                                       inputs.size(), out_names, 1);
     const Ort::Value& w = outputs[0];
     const auto ti = w.GetTensorTypeAndShapeInfo();
-    const size_t n = ti.GetElementCount();
+    const size_t per_item = ti.GetElementCount() / live.size();
     const float* p = w.GetTensorData<float>();
-    std::vector<float> wav(n);
-    for (size_t i = 0; i < n; ++i) {
-      float v = p[i];
-      wav[i] = std::max(-1.F, std::min(1.F, v));
+    for (size_t b = 0; b < live.size(); ++b) {
+      const size_t n = zipvoice_vocoder_row_samples(
+          per_item, static_cast<size_t>(live_items[b]->gen_frames), t_max);
+      const float* src = p + b * per_item;
+      std::vector<float>& wav = wavs[live[b]];
+      wav.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        wav[i] = std::max(-1.F, std::min(1.F, src[i]));
+      }
     }
-    return wav;
+    return wavs;
   }
 
-  // Split target token ids into chunks near a target size, preferring
-  // space-token boundaries.
-  std::vector<std::vector<int64_t>> chunk_target_ids(
-      const std::vector<int64_t>& ids) {
-    // max_tokens ~ so total (clone + generated) audio stays around 25s (mirrors
-    // speak.py).
+  // Largest chunk in target tokens, so total (clone + generated) audio stays
+  // around 25s (mirrors speak.py).
+  size_t max_chunk_tokens() const {
     int max_tokens = 400;
     if (!clone_token_ids_.empty() && clone_frames_ > 0) {
       const double clone_duration = static_cast<double>(clone_frames_) *
@@ -614,16 +693,29 @@ struct ZipVoiceTTS::Impl {
         max_tokens = std::max(1, m);
       }
     }
+    return static_cast<size_t>(max_tokens);
+  }
+
+  // Split target token ids into chunks near a target size, preferring
+  // space-token boundaries. A non-zero ``first_max_tokens`` caps the first
+  // chunk and lets each later one double, for streaming.
+  std::vector<std::vector<int64_t>> chunk_target_ids(
+      const std::vector<int64_t>& ids, size_t first_max_tokens = 0) const {
+    const size_t max_tokens = max_chunk_tokens();
+    size_t budget = max_tokens;
+    if (first_max_tokens > 0) {
+      budget = std::min(budget, first_max_tokens);
+    }
     std::vector<std::vector<int64_t>> chunks;
-    if (static_cast<int>(ids.size()) <= max_tokens) {
+    if (ids.size() <= budget) {
       chunks.push_back(ids);
       return chunks;
     }
     const int space_id = token2id_.count(" ") ? token2id_.at(" ") : -1;
     size_t start = 0;
     while (start < ids.size()) {
-      size_t end =
-          std::min(ids.size(), start + static_cast<size_t>(max_tokens));
+      size_t end = std::min(ids.size(), start + budget);
+      budget = std::min(max_tokens, budget * 2);
       if (end < ids.size() && space_id >= 0) {
         size_t cut = end;
         while (cut > start && ids[cut] != static_cast<int64_t>(space_id)) {
@@ -687,42 +779,224 @@ struct ZipVoiceTTS::Impl {
     return out;
   }
 
-  std::vector<float> synthesize(std::string_view text) {
-    return synthesize_from_token_ids(ipa_text_to_token_ids(std::string(text)));
-  }
+  static constexpr float kCrossFadeSeconds = 0.1F;
 
-  std::vector<float> synthesize_from_ipa(std::string_view ipa) {
-    return synthesize_from_token_ids(ipa_to_token_ids(std::string(ipa)));
+  // Vocodes a batch of sampled chunks in one call and returns their
+  // waveforms at the clone's level.
+  std::vector<std::vector<float>> vocode_chunks(
+      const std::vector<ChunkFeatures>& batch) {
+    std::vector<const ChunkFeatures*> items;
+    items.reserve(batch.size());
+    for (const ChunkFeatures& f : batch) {
+      items.push_back(&f);
+    }
+    std::vector<std::vector<float>> wavs = run_vocoder(items);
+    if (clone_rms_ > 0.F && clone_rms_ < target_rms_) {
+      const float g = clone_rms_ / target_rms_;
+      for (std::vector<float>& wav : wavs) {
+        for (float& s : wav) {
+          s *= g;
+        }
+      }
+    }
+    return wavs;
   }
 
-  std::vector<float> synthesize_from_token_ids(std::vector<int64_t> ids) {
-    if (ids.empty()) {
-      return {};
+  // Chunks the token ids that ``for_each_piece`` feeds in (one piece per
+  // sentence for text input), samples the chunks ``max_batch`` at a time and
+  // passes each chunk's waveform to ``consume`` in order; ``consume``
+  // returns false to stop. With ``pipeline_`` set, tokenization and flow
+  // matching run on a worker thread, so the vocoder of one batch overlaps
+  // sampling of the next and G2P of later sentences. Chunks match
+  // ``chunk_target_ids`` on all the pieces at once.
+  template <typename ForEachPiece, typename Consume>
+  void render_chunks(ForEachPiece&& for_each_piece, size_t first_max_tokens,
+                     size_t max_batch, Consume&& consume) {
+    const size_t max_tokens = max_chunk_tokens();
+    max_batch = std::max<size_t>(max_batch, 1);
+    const auto split = [this, first_max_tokens, max_tokens](
+                           const std::vector<int64_t>& ids, size_t released) {
+      return chunk_target_ids(
+          ids, first_max_tokens == 0
+                   ? 0
+                   : streaming_chunk_budget(first_max_tokens, max_tokens,
+                                            released));
+    };
+    std::vector<int64_t> separator;
+    if (token2id_.count(" ") != 0) {
+      separator.push_back(token2id_.at(" "));
     }
-    const std::vector<std::vector<int64_t>> chunks = chunk_target_ids(ids);
-    std::vector<std::vector<float>> wavs;
-    wavs.reserve(chunks.size());
-    for (const auto& chunk : chunks) {
-      int gen_frames = 0;
-      std::vector<float> pred = sample_chunk(chunk, &gen_frames);
-      if (gen_frames <= 0 || pred.empty()) {
-        continue;
+    const auto produce = [&](const auto& push) {
+      IncrementalChunker<std::vector<int64_t>, decltype(split)> chunker(
+          split, separator);
+      std::vector<std::vector<int64_t>> group;
+      const auto flush = [&] {
+        if (group.empty()) {
+          return true;
+        }
+        std::vector<ChunkFeatures> batch = sample_chunks(group);
+        group.clear();
+        return push(std::move(batch));
+      };
+      const auto sample = [&](std::vector<std::vector<int64_t>> chunks) {
+        for (std::vector<int64_t>& chunk : chunks) {
+          group.push_back(std::move(chunk));
+          if (group.size() == max_batch && !flush()) {
+            return false;
+          }
+        }
+        return true;
+      };
+      bool more = true;
+      for_each_piece([&](std::vector<int64_t> ids) {
+        more = sample(chunker.add(ids));
+        return more;
+      });
+      if (more && sample(chunker.finish())) {
+        flush();
       }
-      std::vector<float> wav = run_vocoder(pred, gen_frames);
-      if (clone_rms_ > 0.F && clone_rms_ < target_rms_) {
-        const float g = clone_rms_ / target_rms_;
-        for (float& s : wav) {
-          s *= g;
+    };
+    const auto deliver = [&](const std::vector<ChunkFeatures>& batch) {
+      for (std::vector<float>& wav : vocode_chunks(batch)) {
+        if (!consume(std::move(wav))) {
+          return false;
         }
       }
-      wavs.push_back(std::move(wav));
+      return true;
+    };
+    if (!pipeline_) {
+      produce(deliver);
+      return;
+    }
+    PipelineStage<std::vector<ChunkFeatures>> stage(produce);
+    while (std::optional<std::vector<ChunkFeatures>> batch = stage.next()) {
+      if (!deliver(*batch)) {
+        return;
+      }
     }
-    std::vector<float> out = cross_fade_concat(wavs, 0.1F, kSampleRateHz);
+  }
+
+  // ``for_each_piece`` source for ``render_chunks``: text goes through G2P
+  // sentence by sentence.
+  auto text_pieces(std::string_view text) {
+    return [this, text](const auto& add) {
+      for_each_sentence_pipelined<std::vector<int64_t>>(
+          text, pipeline_,
+          [this](const std::string& piece) {
+            return ipa_text_to_token_ids(piece);
+          },
+          add);
+    };
+  }
+
+  // ``for_each_piece`` source for ``render_chunks`` holding one id sequence.
+  static auto single_piece(std::vector<int64_t> ids) {
+    return [ids = std::move(ids)](const auto& add) { add(ids); };
+  }
+
+  std::vector<float> synthesize(std::string_view text) {
+    return synthesize_pieces(text_pieces(text));
+  }
+
+  std::vector<float> synthesize_from_ipa(std::string_view ipa) {
+    return synthesize_pieces(
+        single_piece(ipa_to_token_ids(std::string(ipa))));
+  }
+
+  template <typename ForEachPiece>
+  std::vector<float> synthesize_pieces(ForEachPiece&& for_each_piece) {
+    std::vector<std::vector<float>> wavs;
+    render_chunks(for_each_piece, /*first_max_tokens=*/0, max_batch_chunks_,
+                  [&](std::vector<float> wav) {
+                    if (!wav.empty()) {
+                      wavs.push_back(std::move(wav));
+                    }
+                    return true;
+                  });
+    if (wavs.empty()) {
+      return {};
+    }
+    std::vector<float> out =
+        cross_fade_concat(wavs, kCrossFadeSeconds, kSampleRateHz);
     out = zipvoice_compress_long_pauses(out, kSampleRateHz);
     out = trim_edge_silence(out, kSampleRateHz, /*trail_sil_ms=*/0);
     apply_synthesis_output_effects(out, normalize_audio_, output_volume_);
     return out;
   }
+
+  size_t count_chunks(std::string_view text) {
+    const std::vector<int64_t> ids = ipa_text_to_token_ids(std::string(text));
+    return ids.empty() ? 0 : chunk_target_ids(ids).size();
+  }
+
+  size_t synthesize_streaming(std::string_view text,
+                              const TtsAudioChunkCallback& on_audio) {
+    return synthesize_pieces_streaming(text_pieces(text), on_audio);
+  }
+
+  size_t synthesize_from_ipa_streaming(std::string_view ipa,
+                                       const TtsAudioChunkCallback& on_audio) {
+    return synthesize_pieces_streaming(
+        single_piece(ipa_to_token_ids(std::string(ipa))), on_audio);
+  }
+
+  // Streaming form of synthesize_pieces. Each chunk is cross-faded into the
+  // tail held back from the previous one, so the held tail covers the fade
+  // and any trailing quiet run: the final flush can then trim trailing
+  // silence exactly as the batch path does. Long pauses are compressed per
+  // chunk, so a pause straddling a chunk boundary is kept.
+  template <typename ForEachPiece>
+  size_t synthesize_pieces_streaming(ForEachPiece&& for_each_piece,
+                                     const TtsAudioChunkCallback& on_audio) {
+    const size_t fade = static_cast<size_t>(kCrossFadeSeconds *
+                                            static_cast<float>(kSampleRateHz));
+    const size_t keep =
+        static_cast<size_t>((kEdgeSilenceKeepMs * kSampleRateHz) / 1000);
+    StreamingOutputEffects effects(normalize_audio_, output_volume_);
+    std::vector<float> held;
+    bool started = false;
+    bool stopped = false;
+    size_t delivered = 0;
+    const auto emit = [&](std::vector<float> out) {
+      effects.apply(out);
+      delivered += out.size();
+      return out.empty() || on_audio(out.data(), out.size());
+    };
+    render_chunks(
+        for_each_piece, kTtsStreamFirstChunkPhonemes, /*max_batch=*/1,
+        [&](std::vector<float> wav) {
+          if (wav.empty()) {
+            return true;
+          }
+          wav = zipvoice_compress_long_pauses(wav, kSampleRateHz);
+          std::vector<float> out =
+              held.empty() ? std::move(wav)
+                           : cross_fade_concat({held, wav}, kCrossFadeSeconds,
+                                               kSampleRateHz);
+          if (!started) {
+            out = trim_edge_silence(out, kSampleRateHz, /*trail_sil_ms=*/0,
+                                    /*trim_start=*/true, /*trim_end=*/false);
+            started = true;
+          }
+          size_t loud_end = out.size();
+          while (loud_end > 0 &&
+                 std::fabs(out[loud_end - 1]) <= kEdgeSilenceThreshold) {
+            --loud_end;
+          }
+          size_t split = loud_end > keep ? loud_end - keep : 0;
+          split = std::min(split, out.size() > fade ? out.size() - fade : 0);
+          held.assign(out.begin() + static_cast<std::ptrdiff_t>(split),
+                      out.end());
+          out.resize(split);
+          stopped = !emit(std::move(out));
+          return !stopped;
+        });
+    if (!stopped && !held.empty()) {
+      emit(trim_edge_silence(held, kSampleRateHz, /*trail_sil_ms=*/0,
+                             /*trim_start=*/false, /*trim_end=*/true));
+    }
+    return delivered;
+  }
 };
 
 ZipVoiceTTS::ZipVoiceTTS(const ZipVoiceTTSOptions& opt)
@@ -750,6 +1024,22 @@ std::vector<float> ZipVoiceTTS::synthesize_from_ipa(std::string_view ipa) {
   return impl_->synthesize_from_ipa(ipa);
 }
 
+size_t ZipVoiceTTS::synthesize_streaming(
+    std::string_view text, const TtsAudioChunkCallback& on_audio) {
+  return impl_->synthesize_streaming(text, on_audio);
+}
+
+size_t ZipVoiceTTS::synthesize_from_ipa_streaming(
+    std::string_view ipa, const TtsAudioChunkCallback& on_audio) {
+  return impl_->synthesize_from_ipa_streaming(ipa, on_audio);
+}
+
+size_t ZipVoiceTTS::count_chunks(std::string_view text) {
+  return impl_->count_chunks(text);
+}
+
+bool ZipVoiceTTS::clone_from_cache() const { return impl_->clone_from_cache_; }
+
 std::vector<float> zipvoice_compress_long_pauses(const std::vector<float>& wav,
                                                  int sample_rate,
                                                  float max_silence_ms,
@@ -2,6 +2,7 @@
 #define MOONSHINE_TTS_ZIPVOICE_TTS_H
 
 #include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -9,6 +10,7 @@
 
 #include "file-information.h"
 #include "moonshine-g2p-options.h"
+#include "moonshine-tts-options.h"
 
 namespace moonshine_tts {
 
@@ -29,6 +31,15 @@ struct ZipVoiceTTSOptions {
   /// Clipping to ``[-1, 1]`` is always applied.
   bool normalize_audio = false;
   float output_volume = 1.F;
+  /// Run G2P and flow matching on a worker thread so the vocoder of one
+  /// chunk overlaps sampling of the next (see
+  /// ``MoonshineTTSOptions::pipeline_synthesis``).
+  bool pipeline_synthesis = false;
+  /// Sample and vocode up to this many chunks of one utterance together:
+  /// chunks are padded to a common length so each ODE step is one
+  /// fm_decoder call for the whole batch, and the vocoder runs once per
+  /// batch. ``1`` samples chunk by chunk. Streaming always uses ``1``.
+  int max_batch_chunks = 1;
 
   /// Flow-matching / sampling controls. ``num_step`` <= 0 and
   /// ``guidance_scale`` < 0 mean "use the per-model default" (distill: 8 steps
@@ -56,6 +67,10 @@ struct ZipVoiceTTSOptions {
   /// Transcript of ``clone_pcm`` (required for good cloning; empty is tolerated
   /// but degrades quality).
   std::string clone_transcript{};
+  /// Directory for cached reference-clip conditioning (fbank features, level
+  /// and transcript token ids), keyed by a hash of the clip, transcript and
+  /// token table. Empty disables the cache.
+  std::filesystem::path clone_cache_dir{};
 
   /// In-memory ZipVoice assets keyed by ``zipvoice/text_encoder.ort`` etc. (see
   /// moonshine-tts-options.h).
@@ -89,6 +104,23 @@ class ZipVoiceTTS {
   /// (the same format ``MoonshineG2P::text_to_ipa`` produces), skipping G2P.
   std::vector<float> synthesize_from_ipa(std::string_view ipa);
 
+  /// Streaming forms of ``synthesize`` / ``synthesize_from_ipa``: each token
+  /// chunk is passed to ``on_audio`` once it is generated, less a short tail
+  /// kept back to cross-fade into the next chunk. Returns the number of
+  /// samples delivered.
+  size_t synthesize_streaming(std::string_view text,
+                              const TtsAudioChunkCallback& on_audio);
+  size_t synthesize_from_ipa_streaming(std::string_view ipa,
+                                       const TtsAudioChunkCallback& on_audio);
+
+  /// Number of token chunks ``synthesize`` splits ``text`` into (each is one
+  /// flow-matching solve of up to ~25 s of audio including the clone).
+  size_t count_chunks(std::string_view text);
+
+  /// Whether the reference voice's conditioning was read from
+  /// ``clone_cache_dir`` instead of being prepared from the clip.
+  bool clone_from_cache() const;
+
  private:
   struct Impl;
   std::unique_ptr<Impl> impl_;
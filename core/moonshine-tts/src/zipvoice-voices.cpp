@@ -1,9 +1,55 @@
 #include "zipvoice-voices.h"
 
+#include <cinttypes>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <system_error>
 
 namespace moonshine_tts {
 
+namespace {
+
+// Cache entry layout, in the writer's byte order: magic, u32 format version,
+// u32 byte-order mark, u64 key, then u32 feat_dim, u32 frames, f32 rms, u32
+// token count, i64 tokens, f32 features. The header lets a reader reject an
+// entry written by another version or on a machine of the other endianness,
+// and one copied or renamed under another key.
+constexpr std::string_view kCloneCacheMagic = "ZVCC";
+constexpr uint32_t kCloneCacheVersion = 2;
+constexpr uint32_t kCloneCacheByteOrderMark = 0x01020304;
+
+template <typename T>
+void append_pod(std::string& out, const T& value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+void append_array(std::string& out, const std::vector<T>& values) {
+  const size_t at = out.size();
+  out.resize(at + values.size() * sizeof(T));
+  if (!values.empty()) {
+    std::memcpy(out.data() + at, values.data(), values.size() * sizeof(T));
+  }
+}
+
+template <typename T>
+bool read_pod(const std::string& in, size_t& pos, T* value) {
+  if (in.size() - pos < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(value, in.data() + pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+}  // namespace
+
 const ZipVoiceBuiltinVoice* zipvoice_find_builtin_voice(std::string_view id) {
   size_t count = 0;
   const ZipVoiceBuiltinVoice* voices = zipvoice_builtin_voices(&count);
@@ -24,4 +70,105 @@ std::vector<float> zipvoice_builtin_voice_pcm_to_float(
   return out;
 }
 
+uint64_t zipvoice_content_hash(const void* data, size_t size, uint64_t seed) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  uint64_t h = seed;
+  for (size_t i = 0; i < size; ++i) {
+    h ^= bytes[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+std::filesystem::path zipvoice_clone_cache_path(
+    const std::filesystem::path& cache_dir, uint64_t key) {
+  char name[32];
+  snprintf(name, sizeof(name), "%016" PRIx64 ".zvclone", key);
+  return cache_dir / name;
+}
+
+bool zipvoice_load_clone_conditioning(const std::filesystem::path& cache_dir,
+                                      uint64_t key,
+                                      ZipVoiceCloneConditioning* out) {
+  std::ifstream f(zipvoice_clone_cache_path(cache_dir, key), std::ios::binary);
+  if (!f) {
+    return false;
+  }
+  const std::string data((std::istreambuf_iterator<char>(f)),
+                         std::istreambuf_iterator<char>());
+  if (data.compare(0, kCloneCacheMagic.size(), kCloneCacheMagic) != 0) {
+    return false;
+  }
+  size_t pos = kCloneCacheMagic.size();
+  uint32_t version = 0;
+  uint32_t byte_order = 0;
+  uint64_t stored_key = 0;
+  if (!read_pod(data, pos, &version) || version != kCloneCacheVersion ||
+      !read_pod(data, pos, &byte_order) ||
+      byte_order != kCloneCacheByteOrderMark ||
+      !read_pod(data, pos, &stored_key) || stored_key != key) {
+    return false;
+  }
+  uint32_t feat_dim = 0;
+  uint32_t frames = 0;
+  uint32_t n_tokens = 0;
+  ZipVoiceCloneConditioning c;
+  if (!read_pod(data, pos, &feat_dim) || !read_pod(data, pos, &frames) ||
+      !read_pod(data, pos, &c.rms) || !read_pod(data, pos, &n_tokens)) {
+    return false;
+  }
+  const size_t n_features =
+      static_cast<size_t>(frames) * static_cast<size_t>(feat_dim);
+  if (data.size() - pos != n_tokens * sizeof(int64_t) +
+                               n_features * sizeof(float)) {
+    return false;
+  }
+  c.token_ids.resize(n_tokens);
+  std::memcpy(c.token_ids.data(), data.data() + pos,
+              n_tokens * sizeof(int64_t));
+  pos += n_tokens * sizeof(int64_t);
+  c.features.resize(n_features);
+  std::memcpy(c.features.data(), data.data() + pos,
+              n_features * sizeof(float));
+  c.frames = static_cast<int>(frames);
+  c.feat_dim = static_cast<int>(feat_dim);
+  *out = std::move(c);
+  return true;
+}
+
+bool zipvoice_save_clone_conditioning(
+    const std::filesystem::path& cache_dir, uint64_t key,
+    const ZipVoiceCloneConditioning& conditioning) {
+  std::string data(kCloneCacheMagic);
+  append_pod(data, kCloneCacheVersion);
+  append_pod(data, kCloneCacheByteOrderMark);
+  append_pod(data, key);
+  append_pod(data, static_cast<uint32_t>(conditioning.feat_dim));
+  append_pod(data, static_cast<uint32_t>(conditioning.frames));
+  append_pod(data, conditioning.rms);
+  append_pod(data, static_cast<uint32_t>(conditioning.token_ids.size()));
+  append_array(data, conditioning.token_ids);
+  append_array(data, conditioning.features);
+
+  std::error_code ec;
+  std::filesystem::create_directories(cache_dir, ec);
+  const std::filesystem::path path = zipvoice_clone_cache_path(cache_dir, key);
+  std::filesystem::path tmp = path;
+  tmp += "." + std::to_string(std::random_device{}()) + ".tmp";
+  {
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f ||
+        !f.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+      std::filesystem::remove(tmp, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
 }  // namespace moonshine_tts
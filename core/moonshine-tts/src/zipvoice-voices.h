@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <string_view>
 #include <vector>
 
@@ -38,6 +39,42 @@ const ZipVoiceBuiltinVoice* zipvoice_find_builtin_voice(std::string_view id);
 std::vector<float> zipvoice_builtin_voice_pcm_to_float(
     const ZipVoiceBuiltinVoice& voice);
 
+/// What ZipVoice derives from a reference clip before it can clone it: the
+/// scaled fbank features of the level-matched clip, the clip's RMS before
+/// level matching, and the transcript's token ids. These are fixed for a
+/// voice, so they can be cached across processes.
+struct ZipVoiceCloneConditioning {
+  std::vector<float> features;  // [frames * feat_dim] row-major
+  int frames = 0;
+  int feat_dim = 0;
+  float rms = 0.F;
+  std::vector<int64_t> token_ids;
+};
+
+/// 64-bit FNV-1a hash of ``size`` bytes at ``data``, continuing from
+/// ``seed`` so several buffers can be chained into one cache key.
+uint64_t zipvoice_content_hash(const void* data, size_t size,
+                               uint64_t seed = 0xcbf29ce484222325ULL);
+
+/// Cache file for ``key`` under ``cache_dir``.
+std::filesystem::path zipvoice_clone_cache_path(
+    const std::filesystem::path& cache_dir, uint64_t key);
+
+/// Loads the conditioning cached under ``key``. Returns false when there is
+/// no usable entry: missing, truncated, from another format version or byte
+/// order, or recorded under another key.
+bool zipvoice_load_clone_conditioning(const std::filesystem::path& cache_dir,
+                                      uint64_t key,
+                                      ZipVoiceCloneConditioning* out);
+
+/// Stores ``conditioning`` under ``key``, creating ``cache_dir`` if needed.
+/// The entry is written to a temporary file and renamed into place, so
+/// concurrent readers never see a partial one. Returns false if it could
+/// not be written.
+bool zipvoice_save_clone_conditioning(
+    const std::filesystem::path& cache_dir, uint64_t key,
+    const ZipVoiceCloneConditioning& conditioning);
+
 }  // namespace moonshine_tts
 
 #endif  // MOONSHINE_TTS_ZIPVOICE_VOICES_H
@@ -70,3 +70,20 @@ TEST_CASE("arabic diac onnx: diacritized output matches reference file") {
     CHECK(actual[i] == expected[i]);
   }
 }
+
+TEST_CASE("arabic diac onnx: batched diacritization matches one at a time") {
+  const auto model = r::moonshine_tts_bundled_data_dir_relative() / "ar_msa" /
+                     "arabertv02_tashkeel_fadel_onnx";
+  if (!r::model_present(model)) {
+    return;
+  }
+  moonshine_tts::ArabicDiacOnnx diac(model, false);
+  std::vector<std::string> texts = sample_sentences();
+  texts.insert(texts.begin() + 1, "");
+  const std::vector<std::string> batched = diac.diacritize_batch(texts);
+  REQUIRE(batched.size() == texts.size());
+  for (std::size_t i = 0; i < texts.size(); ++i) {
+    INFO("text " << i);
+    CHECK(batched[i] == diac.diacritize(texts[i]));
+  }
+}
@@ -4,6 +4,7 @@
 #include <doctest/doctest.h>
 
 #include "rule-g2p-test-support.h"
+#include "tok-pos-test-support.h"
 
 namespace r = moonshine_tts::rule_g2p_test;
 
@@ -65,3 +66,17 @@ TEST_CASE(
           py[i]);
   }
 }
+
+TEST_CASE("chinese tok pos: batched annotation matches one text at a time") {
+  const auto model = moonshine_tts::default_chinese_tok_pos_model_dir(
+      r::moonshine_tts_bundled_data_dir_relative());
+  // Mixed lengths, so rows are padded within a run.
+  const std::vector<std::string> texts = {
+      "上海是一座城市。",
+      "",
+      "数学是研究数量、结构以及空间等概念及其变化的一门学科。",
+      "你好。",
+  };
+  moonshine_tts::tok_pos_test::check_batch_matches_single<
+      moonshine_tts::ChineseTokPosOnnx>(model, texts);
+}
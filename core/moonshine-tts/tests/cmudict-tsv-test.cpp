@@ -5,6 +5,9 @@
 
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
 
 using namespace moonshine_tts;
 
@@ -18,9 +21,54 @@ TEST_CASE("cmudict-tsv load and lookup") {
     out << "# comment\n";
   }
   CmudictTsv dict(path);
-  const auto* alts = dict.lookup("hello");
-  REQUIRE(alts != nullptr);
-  REQUIRE(alts->size() == 2);
-  CHECK((*alts)[0] < (*alts)[1]);
+  const auto alts = dict.lookup("hello");
+  REQUIRE(alts.size() == 2);
+  CHECK(alts[0] < alts[1]);
+  CHECK(dict.lookup("goodbye").empty());
   std::filesystem::remove(path);
 }
+
+TEST_CASE("cmudict-tsv prefers a compiled sibling built from the same TSV") {
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto path = dir / "moonshine_tts_test_compiled_dict.tsv";
+  const auto compiled = CompiledLexicon::compiled_sibling_path(path);
+  {
+    std::ofstream out(path);
+    out << "Hello\thəˈloʊ\n";
+    out << "world\twˈɝld\n";
+  }
+  {
+    std::ifstream file(path, std::ios::binary);
+    const std::string text((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+    std::istringstream in(text);
+    CompiledLexicon::write_file(compiled, CmudictTsv::parse_entries(in),
+                                CmudictTsv::kCompiledLexiconKind,
+                                CompiledLexicon::describe_source(text));
+  }
+  {
+    CmudictTsv dict(path);
+#ifndef _WIN32
+    CHECK(dict.lexicon().is_mapped());
+#endif
+    REQUIRE(dict.lookup("world").size() == 1);
+    CHECK(dict.lookup("world")[0] == "wˈɝld");
+    CHECK(dict.lookup("hello").size() == 1);
+  }
+  {
+    CmudictTsv dict(compiled);
+    CHECK(dict.lookup("world").size() == 1);
+  }
+  // Editing the TSV makes the compiled file stale; it is then ignored.
+  {
+    std::ofstream out(path, std::ios::app);
+    out << "again\təˈɡɛn\n";
+  }
+  {
+    CmudictTsv dict(path);
+    CHECK_FALSE(dict.lexicon().is_mapped());
+    CHECK(dict.lookup("again").size() == 1);
+  }
+  std::filesystem::remove(path);
+  std::filesystem::remove(compiled);
+}
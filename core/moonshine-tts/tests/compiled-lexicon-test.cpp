@@ -0,0 +1,207 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "compiled-lexicon.h"
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using moonshine_tts::CompiledLexicon;
+
+namespace {
+
+constexpr uint32_t kTestKind = 7;
+
+// One "word<TAB>ipa" entry per line.
+std::vector<CompiledLexicon::Entry> parse_pairs(std::istream& in) {
+  std::vector<CompiledLexicon::Entry> out;
+  std::string word;
+  std::string ipa;
+  while (in >> word >> ipa) {
+    out.push_back({word, {ipa}});
+  }
+  return out;
+}
+
+void write_text(const std::filesystem::path& path, const std::string& text) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out << text;
+}
+
+// Compiles ``tsv`` to its sibling, stamped with the TSV as it is now.
+void compile_sibling(const std::filesystem::path& tsv,
+                     const std::string& text) {
+  std::istringstream in(text);
+  CompiledLexicon::write_file(CompiledLexicon::compiled_sibling_path(tsv),
+                              parse_pairs(in), kTestKind,
+                              CompiledLexicon::describe_source(text));
+}
+
+std::vector<CompiledLexicon::Entry> sample_entries() {
+  return {
+      {"zebra", {"zˈiːbɹə", "zˈɛbɹə"}},
+      {"apple", {"ˈæpəl"}},
+      {"", {"empty"}},
+      {"mango", {}},
+      {"über", {"ˈyːbɐ"}},
+  };
+}
+
+}  // namespace
+
+TEST_CASE("CompiledLexicon round-trips entries through serialize") {
+  const CompiledLexicon lex = CompiledLexicon::from_bytes(
+      CompiledLexicon::serialize(sample_entries(), kTestKind,
+                                 {1234, 0x0123456789abcdefULL}),
+      kTestKind);
+  CHECK(lex.size() == 5);
+  CHECK(lex.kind() == kTestKind);
+  CHECK(lex.source().bytes == 1234);
+  CHECK(lex.source().content_hash == 0x0123456789abcdefULL);
+  CHECK_FALSE(lex.is_mapped());
+
+  const auto zebra = lex.lookup("zebra");
+  REQUIRE(zebra.size() == 2);
+  CHECK(zebra[0] == "zˈiːbɹə");
+  CHECK(zebra[1] == "zˈɛbɹə");
+  CHECK(zebra.to_strings() ==
+        std::vector<std::string>{"zˈiːbɹə", "zˈɛbɹə"});
+  CHECK(lex.lookup("über")[0] == "ˈyːbɐ");
+  CHECK(lex.lookup("")[0] == "empty");
+  CHECK(lex.lookup("mango").empty());
+  CHECK(lex.lookup("apples").empty());
+  CHECK(lex.lookup("zz").empty());
+  CHECK_THROWS_AS(zebra[2], std::out_of_range);
+
+  // Rows keep the input order.
+  const auto entries = sample_entries();
+  for (size_t i = 0; i < lex.size(); ++i) {
+    CHECK(lex.key_at(i) == entries[i].first);
+  }
+}
+
+TEST_CASE("CompiledLexicon rejects bad input") {
+  std::vector<CompiledLexicon::Entry> dup = {
+      {"a", {"x"}}, {"b", {"y"}}, {"a", {"z"}}};
+  CHECK_THROWS_AS(CompiledLexicon::serialize(dup, kTestKind),
+                  std::runtime_error);
+  const std::string bytes =
+      CompiledLexicon::serialize(sample_entries(), kTestKind);
+  CHECK_THROWS_AS(CompiledLexicon::from_bytes(bytes, kTestKind + 1),
+                  std::runtime_error);
+  CHECK_THROWS_AS(CompiledLexicon::from_bytes(bytes.substr(0, 40), kTestKind),
+                  std::runtime_error);
+  CHECK_THROWS_AS(CompiledLexicon::from_bytes("word\tipa\n", kTestKind),
+                  std::runtime_error);
+  CHECK(CompiledLexicon().lookup("a").empty());
+}
+
+TEST_CASE("CompiledLexicon maps a written file and survives moves") {
+  const auto path = std::filesystem::temp_directory_path() /
+                    "moonshine_tts_compiled_lexicon_test.mlex";
+  CompiledLexicon::write_file(path, sample_entries(), kTestKind);
+  CompiledLexicon lex = CompiledLexicon::map_file(path, kTestKind);
+#ifndef _WIN32
+  CHECK(lex.is_mapped());
+#endif
+  // Files are written sorted by key bytes.
+  for (size_t i = 1; i < lex.size(); ++i) {
+    CHECK(lex.key_at(i - 1) < lex.key_at(i));
+  }
+  CompiledLexicon moved = std::move(lex);
+  CHECK(lex.empty());
+  REQUIRE(moved.lookup("apple").size() == 1);
+  CHECK(moved.lookup("apple")[0] == "ˈæpəl");
+
+  CompiledLexicon owned = CompiledLexicon::from_bytes(
+      CompiledLexicon::serialize({{"k", {"v"}}}, kTestKind), kTestKind);
+  moved = std::move(owned);
+  CHECK(moved.lookup("k")[0] == "v");
+  CHECK(moved.lookup("apple").empty());
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("CompiledLexicon open_bytes takes TSV text or compiled bytes") {
+  const CompiledLexicon from_tsv =
+      CompiledLexicon::open_bytes("b\tbi\na\tei\n", kTestKind, parse_pairs);
+  CHECK(from_tsv.lookup("a")[0] == "ei");
+  CHECK(from_tsv.lookup("b")[0] == "bi");
+  const CompiledLexicon from_compiled = CompiledLexicon::open_bytes(
+      CompiledLexicon::serialize(sample_entries(), kTestKind), kTestKind,
+      parse_pairs);
+  CHECK(from_compiled.lookup("apple")[0] == "ˈæpəl");
+}
+
+TEST_CASE("CompiledLexicon open checks a sibling against the TSV's bytes") {
+  const auto tsv = std::filesystem::temp_directory_path() /
+                   "moonshine_tts_compiled_lexicon_stamp_test.tsv";
+  const auto sibling = CompiledLexicon::compiled_sibling_path(tsv);
+  const std::string text = "cat\tkat\ndog\tdog\n";
+  write_text(tsv, text);
+  compile_sibling(tsv, text);
+  {
+    const CompiledLexicon lex =
+        CompiledLexicon::open(tsv, kTestKind, parse_pairs);
+#ifndef _WIN32
+    CHECK(lex.is_mapped());
+#endif
+    CHECK(lex.source().bytes == text.size());
+    CHECK(lex.lookup("cat")[0] == "kat");
+  }
+
+  SUBCASE("content changed, size and mtime kept") {
+    const auto mtime = std::filesystem::last_write_time(tsv);
+    std::string edited = text;
+    edited[5] = 'b';  // "kat" -> "kbt"
+    REQUIRE(edited.size() == text.size());
+    write_text(tsv, edited);
+    std::filesystem::last_write_time(tsv, mtime);
+    const CompiledLexicon lex =
+        CompiledLexicon::open(tsv, kTestKind, parse_pairs);
+    CHECK_FALSE(lex.is_mapped());
+    CHECK(lex.lookup("cat")[0] == "kbt");
+  }
+  SUBCASE("mtime changed, content kept") {
+    // As after a copy, install or checkout: the sibling still matches.
+    std::filesystem::last_write_time(
+        tsv, std::filesystem::last_write_time(tsv) + std::chrono::seconds(5));
+    const CompiledLexicon lex =
+        CompiledLexicon::open(tsv, kTestKind, parse_pairs);
+#ifndef _WIN32
+    CHECK(lex.is_mapped());
+#endif
+    CHECK(lex.lookup("cat")[0] == "kat");
+  }
+  std::filesystem::remove(tsv);
+  std::filesystem::remove(sibling);
+}
+
+TEST_CASE("CompiledLexicon open maps a sibling shipped without its TSV") {
+  const auto tsv = std::filesystem::temp_directory_path() /
+                   "moonshine_tts_compiled_lexicon_alone_test.tsv";
+  const auto sibling = CompiledLexicon::compiled_sibling_path(tsv);
+  compile_sibling(tsv, "cat\tkat\n");
+  std::filesystem::remove(tsv);
+  CHECK(CompiledLexicon::can_open(tsv));
+  CHECK(CompiledLexicon::can_open(sibling));
+  const auto parse_fails = [](std::istream&)
+      -> std::vector<CompiledLexicon::Entry> {
+    throw std::runtime_error("the TSV should not be parsed");
+  };
+  for (const auto& path : {tsv, sibling}) {
+    CAPTURE(path);
+    const CompiledLexicon lex =
+        CompiledLexicon::open(path, kTestKind, parse_fails);
+    CHECK(lex.lookup("cat")[0] == "kat");
+  }
+  std::filesystem::remove(sibling);
+  CHECK_FALSE(CompiledLexicon::can_open(tsv));
+  CHECK_THROWS_AS(CompiledLexicon::open(tsv, kTestKind, parse_pairs),
+                  std::runtime_error);
+}
@@ -0,0 +1,129 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "g2p-parallel.h"
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "g2p-word-log.h"
+#include "rule-based-g2p.h"
+
+using moonshine_tts::convert_lines_parallel;
+using moonshine_tts::count_lines;
+using moonshine_tts::G2pWordLog;
+using moonshine_tts::join_sentence_ipa;
+using moonshine_tts::report_rate;
+using moonshine_tts::RuleBasedG2p;
+using moonshine_tts::texts_to_ipa_parallel;
+
+namespace {
+
+/// Upper-cases its input and records which thread ran it; throws on "boom".
+class FakeG2p : public RuleBasedG2p {
+ public:
+  std::string text_to_ipa(std::string text,
+                          std::vector<G2pWordLog>* per_word_log) override {
+    if (text == "boom") {
+      throw std::runtime_error("boom");
+    }
+    if (!thread_id_set_) {
+      thread_id_ = std::this_thread::get_id();
+      thread_id_set_ = true;
+    } else {
+      CHECK(thread_id_ == std::this_thread::get_id());
+    }
+    ++calls;
+    for (char& c : text) {
+      if (c >= 'a' && c <= 'z') {
+        c = static_cast<char>(c - 'a' + 'A');
+      }
+    }
+    if (per_word_log != nullptr) {
+      G2pWordLog log;
+      log.surface_token = text;
+      per_word_log->push_back(log);
+    }
+    return text;
+  }
+
+  int calls = 0;
+
+ private:
+  bool thread_id_set_ = false;
+  std::thread::id thread_id_;
+};
+
+}  // namespace
+
+TEST_CASE("texts_to_ipa_parallel keeps input order and one thread per engine") {
+  std::vector<std::unique_ptr<FakeG2p>> owned;
+  std::vector<RuleBasedG2p*> engines;
+  for (int i = 0; i < 4; ++i) {
+    owned.push_back(std::make_unique<FakeG2p>());
+    engines.push_back(owned.back().get());
+  }
+  std::vector<std::string> texts;
+  for (int i = 0; i < 200; ++i) {
+    texts.push_back("line" + std::to_string(i));
+  }
+  std::vector<std::vector<G2pWordLog>> logs;
+  const std::vector<std::string> out =
+      texts_to_ipa_parallel(engines, texts, &logs);
+  REQUIRE(out.size() == texts.size());
+  REQUIRE(logs.size() == texts.size());
+  int calls = 0;
+  for (const auto& e : owned) {
+    calls += e->calls;
+  }
+  CHECK(calls == 200);
+  for (size_t i = 0; i < texts.size(); ++i) {
+    CHECK(out[i] == "LINE" + std::to_string(i));
+    REQUIRE(logs[i].size() == 1);
+    CHECK(logs[i][0].surface_token == out[i]);
+  }
+}
+
+TEST_CASE("texts_to_ipa_parallel rethrows a worker's exception") {
+  FakeG2p a;
+  FakeG2p b;
+  const std::vector<RuleBasedG2p*> engines = {&a, &b};
+  const std::vector<std::string> texts = {"one", "two", "boom", "four"};
+  CHECK_THROWS_AS(texts_to_ipa_parallel(engines, texts), std::runtime_error);
+  CHECK_THROWS_AS(texts_to_ipa_parallel({}, texts), std::invalid_argument);
+  CHECK(texts_to_ipa_parallel(engines, {}).empty());
+}
+
+TEST_CASE("join_sentence_ipa skips empty sentences") {
+  CHECK(join_sentence_ipa({"həloʊ", "", "wɝld"}) == "həloʊ wɝld");
+  CHECK(join_sentence_ipa({"", ""}).empty());
+}
+
+TEST_CASE("convert_lines_parallel keeps blank lines and reports the rate") {
+  FakeG2p a;
+  FakeG2p b;
+  FakeG2p c;
+  std::istringstream in("one\n  two \r\n\n\t\nthree");
+  std::ostringstream out;
+  std::ostringstream err;
+  convert_lines_parallel({&a, &b, &c}, in, out, err);
+  CHECK(out.str() == "ONE\nTWO\n\n\nTHREE\n");
+  CHECK(a.calls + b.calls + c.calls == 3);
+  CHECK(err.str().rfind("5 lines in ", 0) == 0);
+  CHECK(err.str().find("3 threads)\n") != std::string::npos);
+}
+
+TEST_CASE("count_lines counts a last line without a newline") {
+  CHECK(count_lines("") == 0);
+  CHECK(count_lines("a") == 1);
+  CHECK(count_lines("a\n") == 1);
+  CHECK(count_lines("a\n\nb") == 3);
+  std::ostringstream err;
+  report_rate(err, 0, 2, std::chrono::steady_clock::now());
+  CHECK(err.str().rfind("0 lines in ", 0) == 0);
+}
@@ -0,0 +1,129 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "g2p-pronunciation-cache.h"
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using moonshine_tts::G2pCachedPronunciation;
+using moonshine_tts::G2pPronunciationCache;
+using moonshine_tts::G2pWordPath;
+
+namespace {
+
+constexpr uint64_t kEnUs = 0x1234;
+constexpr uint64_t kEnGb = 0x5678;
+
+std::string key(const std::string& token, uint64_t scope = kEnUs,
+                char context = G2pPronunciationCache::kContextFree) {
+  return G2pPronunciationCache::make_key(scope, context, token);
+}
+
+}  // namespace
+
+TEST_CASE("G2pPronunciationCache keys on scope, context and token") {
+  G2pPronunciationCache cache(1 << 20);
+  cache.put(key("tomato"), {"təmˈeɪɾoʊ", G2pWordPath::kOovModel});
+  const auto hit = cache.get(key("tomato"));
+  REQUIRE(hit.has_value());
+  CHECK(hit->ipa == "təmˈeɪɾoʊ");
+  CHECK(hit->path == G2pWordPath::kOovModel);
+  CHECK_FALSE(cache.get(key("tomato", kEnGb)).has_value());
+  CHECK_FALSE(cache.get(key("tomato", kEnUs, 'h')).has_value());
+  const auto stats = cache.stats();
+  CHECK(stats.hits == 1);
+  CHECK(stats.misses == 2);
+  CHECK(stats.entries == 1);
+}
+
+TEST_CASE("G2pPronunciationCache evicts least recently used under its cap") {
+  // Room for a handful of entries per shard.
+  G2pPronunciationCache cache(G2pPronunciationCache::kShards * 700);
+  for (int i = 0; i < 400; ++i) {
+    cache.put(key("w" + std::to_string(i)), {"ipa", G2pWordPath::kOovModel});
+    CHECK(cache.get(key("w0")).has_value());  // Keep w0 recently used.
+  }
+  const auto stats = cache.stats();
+  CHECK(stats.bytes <= stats.capacity_bytes);
+  CHECK(stats.evictions > 0);
+  CHECK(cache.get(key("w0")).has_value());
+  CHECK_FALSE(cache.get(key("w1")).has_value());
+
+  G2pPronunciationCache disabled(0);
+  disabled.put(key("a"), {"ə", G2pWordPath::kOovModel});
+  CHECK_FALSE(disabled.get(key("a")).has_value());
+  CHECK(disabled.stats().misses == 0);
+}
+
+TEST_CASE("G2pPronunciationCache is safe to share across threads") {
+  G2pPronunciationCache cache(1 << 20);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, t] {
+      for (int i = 0; i < 500; ++i) {
+        const std::string k = key("w" + std::to_string((i * 7 + t) % 64));
+        if (!cache.get(k)) {
+          cache.put(k, {"ipa", G2pWordPath::kOovHandRules});
+        }
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  const auto stats = cache.stats();
+  CHECK(stats.entries == 64);
+  CHECK(stats.hits + stats.misses == 2000);
+}
+
+TEST_CASE("G2pPronunciationCache saves and reloads its entries") {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "g2p-pronunciation-cache.txt";
+  {
+    G2pPronunciationCache cache(1 << 20);
+    cache.put(key("kubectl"), {"kjˈubkʌtəl", G2pWordPath::kOovModel});
+    cache.put(key("zyx"), {"zɪks", G2pWordPath::kOovHandRules});
+    cache.save(path);
+  }
+  G2pPronunciationCache loaded(1 << 20);
+  REQUIRE(loaded.load(path));
+  const auto a = loaded.get(key("kubectl"));
+  REQUIRE(a.has_value());
+  CHECK(a->ipa == "kjˈubkʌtəl");
+  CHECK(a->path == G2pWordPath::kOovModel);
+  const auto b = loaded.get(key("zyx"));
+  REQUIRE(b.has_value());
+  CHECK(b->path == G2pWordPath::kOovHandRules);
+  CHECK(loaded.load_once(path));
+  CHECK_FALSE(loaded.load_once(path));
+  std::filesystem::remove(path);
+  CHECK_FALSE(loaded.load(path));
+}
+
+TEST_CASE("G2pPronunciationCache writes a file only when it has changed") {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "g2p-pronunciation-dirty.txt";
+  std::filesystem::remove(path);
+  {
+    G2pPronunciationCache cache(1 << 20);
+    cache.persist_to(path);
+    cache.put(key("kubectl"), {"kjˈubkʌtəl", G2pWordPath::kOovModel});
+    CHECK(cache.save_if_changed(path));
+    CHECK_FALSE(cache.save_if_changed(path));
+    // Only reading entries leaves the file current.
+    CHECK(cache.get(key("kubectl")).has_value());
+    CHECK_FALSE(cache.save_if_changed(path));
+    cache.put(key("zyx"), {"zɪks", G2pWordPath::kOovHandRules});
+    // Left for the destructor to write.
+  }
+  G2pPronunciationCache loaded(1 << 20);
+  REQUIRE(loaded.load(path));
+  CHECK(loaded.get(key("zyx")).has_value());
+  // A freshly loaded file is current too.
+  CHECK_FALSE(loaded.save_if_changed(path));
+  std::filesystem::remove(path);
+}
@@ -4,6 +4,7 @@
 #include <doctest/doctest.h>
 
 #include "rule-g2p-test-support.h"
+#include "tok-pos-test-support.h"
 
 namespace r = moonshine_tts::rule_g2p_test;
 
@@ -69,3 +70,21 @@ TEST_CASE(
           py[i]);
   }
 }
+
+TEST_CASE("japanese tok pos: batched annotation matches one text at a time") {
+  const auto model = moonshine_tts::default_japanese_tok_pos_model_dir(
+      r::moonshine_tts_bundled_data_dir_relative());
+  std::string long_text;
+  for (int i = 0; i < 8; ++i) {
+    long_text += "国境の長いトンネルを抜けると雪国であった。";
+  }
+  // Mixed lengths, including one that is split into several chunks.
+  const std::vector<std::string> texts = {
+      "国境の長いトンネルを抜けると雪国であった。",
+      long_text,
+      "",
+      "こんにちは。",
+  };
+  moonshine_tts::tok_pos_test::check_batch_matches_single<
+      moonshine_tts::JapaneseTokPosOnnx>(model, texts);
+}
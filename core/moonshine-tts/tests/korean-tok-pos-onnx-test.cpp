@@ -4,6 +4,7 @@
 #include <doctest/doctest.h>
 
 #include "rule-g2p-test-support.h"
+#include "tok-pos-test-support.h"
 
 namespace r = moonshine_tts::rule_g2p_test;
 
@@ -49,3 +50,17 @@ TEST_CASE(
           py[i]);
   }
 }
+
+TEST_CASE("korean tok pos: batched annotation matches one text at a time") {
+  const auto model = moonshine_tts::default_korean_tok_pos_model_dir(
+      r::moonshine_tts_bundled_data_dir_relative());
+  // Mixed lengths, so rows are padded within a run.
+  const std::vector<std::string> texts = {
+      "대한민국의 수도는 서울이다.",
+      "",
+      "어린 시절 지미 카터는 조지아주 섬터 카운티 플레인스 마을에서 태어났다.",
+      "안녕하세요.",
+  };
+  moonshine_tts::tok_pos_test::check_batch_matches_single<
+      moonshine_tts::KoreanTokPosOnnx>(model, texts);
+}
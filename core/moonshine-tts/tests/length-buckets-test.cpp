@@ -0,0 +1,176 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "length-buckets.h"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using moonshine_tts::LengthBucketLimits;
+using moonshine_tts::plan_length_buckets;
+using moonshine_tts::run_padded_batches;
+
+namespace {
+
+/// Every index exactly once, and within each batch longest first.
+void check_partition(const std::vector<size_t>& lengths,
+                     const std::vector<std::vector<size_t>>& batches) {
+  std::vector<size_t> seen;
+  for (const auto& batch : batches) {
+    REQUIRE_FALSE(batch.empty());
+    for (size_t k = 1; k < batch.size(); ++k) {
+      CHECK(lengths[batch[k]] <= lengths[batch[0]]);
+    }
+    seen.insert(seen.end(), batch.begin(), batch.end());
+  }
+  std::sort(seen.begin(), seen.end());
+  REQUIRE(seen.size() == lengths.size());
+  for (size_t i = 0; i < seen.size(); ++i) {
+    CHECK(seen[i] == i);
+  }
+}
+
+constexpr int64_t kPad = 1;
+constexpr size_t kLabels = 3;
+
+/// Stands in for a token classifier. Each token's logits depend on its id, its
+/// position and a summary of every unmasked token in its row, as attention
+/// would; padding that leaked through the mask, or a row paired with another
+/// row's tokens, changes them.
+void fake_classifier(const std::vector<int64_t>& ids,
+                     const std::vector<int64_t>& mask, int64_t rows,
+                     int64_t padded, std::vector<float>& logits) {
+  logits.assign(ids.size() * kLabels, 0.0f);
+  for (int64_t r = 0; r < rows; ++r) {
+    const size_t row = static_cast<size_t>(r * padded);
+    int64_t context = 0;
+    for (int64_t t = 0; t < padded; ++t) {
+      context += mask[row + t] * ids[row + t] * (t + 1);
+    }
+    for (int64_t t = 0; t < padded; ++t) {
+      for (size_t k = 0; k < kLabels; ++k) {
+        logits[(row + t) * kLabels + k] =
+            mask[row + t] == 0
+                ? -1.0f
+                : static_cast<float>(ids[row + t] * 1000 + t * 10 + k) +
+                      static_cast<float>(context % 997) / 1000.0f;
+      }
+    }
+  }
+}
+
+/// The same classifier run on ``seq`` alone, unpadded.
+std::vector<float> classify_alone(const std::vector<int64_t>& seq) {
+  std::vector<int64_t> mask(seq.size());
+  for (size_t t = 0; t < seq.size(); ++t) {
+    mask[t] = seq[t] != kPad ? 1 : 0;
+  }
+  std::vector<float> logits;
+  fake_classifier(seq, mask, 1, static_cast<int64_t>(seq.size()), logits);
+  return logits;
+}
+
+}  // namespace
+
+TEST_CASE("plan_length_buckets groups similar lengths") {
+  const std::vector<size_t> lengths = {10, 40, 11, 42, 12, 41};
+  const auto batches = plan_length_buckets(lengths);
+  check_partition(lengths, batches);
+  REQUIRE(batches.size() == 2);
+  CHECK(batches[0] == std::vector<size_t>{3, 5, 1});
+  CHECK(batches[1] == std::vector<size_t>{4, 2, 0});
+}
+
+TEST_CASE("plan_length_buckets respects row, token and padding limits") {
+  LengthBucketLimits limits;
+  limits.max_rows = 2;
+  const std::vector<size_t> same(5, 20);
+  auto batches = plan_length_buckets(same, limits);
+  check_partition(same, batches);
+  CHECK(batches.size() == 3);
+
+  limits.max_rows = 16;
+  limits.max_tokens = 100;
+  batches = plan_length_buckets(same, limits);
+  check_partition(same, batches);
+  REQUIRE(batches.size() == 1);
+  CHECK(batches[0] == std::vector<size_t>{0, 1, 2, 3, 4});
+
+  const std::vector<size_t> long_one = {500, 30, 30};
+  batches = plan_length_buckets(long_one, limits);
+  check_partition(long_one, batches);
+  REQUIRE(batches.size() == 2);
+  CHECK(batches[0] == std::vector<size_t>{0});
+
+  // Padding to 40 is fine for 30 (at most 1.25 * 30 + 8) but not for 20.
+  const std::vector<size_t> mixed = {40, 30, 20};
+  batches = plan_length_buckets(mixed, LengthBucketLimits{});
+  check_partition(mixed, batches);
+  REQUIRE(batches.size() == 2);
+  CHECK(batches[0] == std::vector<size_t>{0, 1});
+  CHECK(batches[1] == std::vector<size_t>{2});
+  CHECK(plan_length_buckets({}).empty());
+}
+
+TEST_CASE("run_padded_batches matches running each sequence alone") {
+  // Random lengths, with an empty sequence and a pad token inside one.
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<size_t> length(1, 60);
+  std::uniform_int_distribution<int64_t> token(2, 500);
+  std::vector<std::vector<int64_t>> sequences;
+  for (int i = 0; i < 40; ++i) {
+    std::vector<int64_t> seq(length(rng));
+    for (int64_t& id : seq) {
+      id = token(rng);
+    }
+    sequences.push_back(std::move(seq));
+  }
+  sequences.push_back({});
+  sequences.push_back({5, kPad, 9});
+
+  for (const size_t min_length : {size_t{0}, size_t{16}}) {
+    for (const size_t max_rows : {size_t{1}, size_t{16}}) {
+      CAPTURE(min_length);
+      CAPTURE(max_rows);
+      LengthBucketLimits limits;
+      limits.max_rows = max_rows;
+      int64_t widest = 0;
+      const auto out = run_padded_batches(
+          sequences, kPad, kLabels, min_length, limits,
+          [&](const std::vector<int64_t>& ids,
+              const std::vector<int64_t>& mask, int64_t rows, int64_t padded,
+              std::vector<float>& logits) {
+            CHECK(padded >= static_cast<int64_t>(min_length));
+            widest = std::max(widest, rows);
+            fake_classifier(ids, mask, rows, padded, logits);
+          });
+      // Shared runs are what is under test, so some must have happened.
+      if (max_rows == 1) {
+        CHECK(widest == 1);
+      } else {
+        CHECK(widest > 1);
+      }
+      REQUIRE(out.size() == sequences.size());
+      for (size_t i = 0; i < sequences.size(); ++i) {
+        CAPTURE(i);
+        CHECK(out[i] == classify_alone(sequences[i]));
+      }
+    }
+  }
+}
+
+TEST_CASE("run_padded_batches rejects a runner's short output") {
+  const std::vector<std::vector<int64_t>> sequences = {{1, 2}, {3}};
+  CHECK_THROWS_AS(
+      run_padded_batches(sequences, kPad, kLabels, 0, LengthBucketLimits{},
+                         [](const std::vector<int64_t>&,
+                            const std::vector<int64_t>&, int64_t, int64_t,
+                            std::vector<float>& logits) { logits.resize(1); }),
+      std::runtime_error);
+  CHECK(run_padded_batches({}, kPad, kLabels, 0, LengthBucketLimits{},
+                           fake_classifier)
+            .empty());
+}
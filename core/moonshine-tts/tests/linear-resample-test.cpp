@@ -0,0 +1,61 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "linear-resample.h"
+
+#include <doctest/doctest.h>
+
+#include <cstddef>
+#include <vector>
+
+using moonshine_tts::resample_linear;
+using moonshine_tts::StreamingLinearResampler;
+
+TEST_CASE("resample_linear keeps the end samples") {
+  const std::vector<float> x{0.F, 1.F, 2.F, 3.F};
+  const std::vector<float> y = resample_linear(x, 3, 6);
+  REQUIRE(y.size() == 7);
+  for (size_t i = 0; i < y.size(); ++i) {
+    CHECK(y[i] == doctest::Approx(0.5 * static_cast<double>(i)));
+  }
+  CHECK(resample_linear(x, 16000, 16000) == x);
+  CHECK(resample_linear({0.5F}, 22050, 24000) == std::vector<float>{0.5F});
+}
+
+TEST_CASE("StreamingLinearResampler output doesn't depend on chunking") {
+  // A ramp resamples to exactly the source positions of the output samples,
+  // so a boundary stretched or restarted shows up.
+  std::vector<float> ramp(2205);
+  for (size_t i = 0; i < ramp.size(); ++i) {
+    ramp[i] = static_cast<float>(i);
+  }
+  StreamingLinearResampler whole(22050, 24000);
+  std::vector<float> expected;
+  whole.process(ramp, expected);
+  whole.flush(expected);
+  // Every output position up to the last input sample, 2204 * 24000 / 22050.
+  REQUIRE(expected.size() == 2399);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    CAPTURE(i);
+    CHECK(expected[i] == doctest::Approx(i * 22050.0 / 24000.0));
+  }
+
+  StreamingLinearResampler chunked(22050, 24000);
+  std::vector<float> actual;
+  size_t start = 0;
+  for (const size_t size : {1, 2, 300, 7, 1000, 895}) {
+    chunked.process(std::vector<float>(ramp.begin() + start,
+                                       ramp.begin() + start + size),
+                    actual);
+    start += size;
+  }
+  REQUIRE(start == ramp.size());
+  chunked.flush(actual);
+  CHECK(actual == expected);
+}
+
+TEST_CASE("StreamingLinearResampler passes equal rates through") {
+  StreamingLinearResampler same(24000, 24000);
+  std::vector<float> out;
+  same.process({0.5F, -0.25F}, out);
+  same.flush(out);
+  CHECK(out == std::vector<float>{0.5F, -0.25F});
+}
@@ -136,3 +136,22 @@ TEST_CASE("MoonshineG2POptions option names are case-insensitive") {
   CHECK_NOTHROW(o.parse_options({{"GERMAN_WITH_STRESS", "false"}}));
   CHECK(o.german_with_stress == false);
 }
+
+TEST_CASE("MoonshineG2POptions parse_options pronunciation cache keys") {
+  MoonshineG2POptions o;
+  CHECK(o.pronunciation_cache_bytes > 0);
+  CHECK(o.pronunciation_cache_file.empty());
+  o.parse_options(
+      {{"g2p_cache_bytes", "0"}, {"g2p_cache_file", " /tmp/g2p-cache.txt "}});
+  CHECK(o.pronunciation_cache_bytes == 0);
+  CHECK(o.pronunciation_cache_file ==
+        std::filesystem::path("/tmp/g2p-cache.txt"));
+}
+
+TEST_CASE("MoonshineG2POptions parse_options g2p_threads") {
+  MoonshineG2POptions o;
+  CHECK(o.g2p_threads == 1);
+  o.parse_options({{"g2p_threads", " 4 "}});
+  CHECK(o.g2p_threads == 4);
+  CHECK_THROWS(o.parse_options({{"g2p_threads", "many"}}));
+}
@@ -3,6 +3,9 @@
 
 #include <doctest/doctest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <string>
 #include <utility>
 #include <vector>
@@ -21,3 +24,129 @@ TEST_CASE("MoonshineTTSOptions parse_options ort_providers") {
   CHECK(opt.ort_provider_names[1] == "cpu");
   CHECK(opt.coreml_cache_dir == "/tmp/cache");
 }
+
+TEST_CASE("MoonshineTTSOptions parse_options synthesis scheduling keys") {
+  MoonshineTTSOptions opt;
+  CHECK_FALSE(opt.pipeline_synthesis);
+  CHECK(opt.zipvoice_max_batch_chunks == 1);
+  std::string lang;
+  bool lang_set = false;
+  opt.parse_options(
+      {{"pipeline_synthesis", "true"}, {"zipvoice_batch_chunks", "8"}},
+      &lang, &lang_set);
+  CHECK(opt.pipeline_synthesis);
+  CHECK(opt.zipvoice_max_batch_chunks == 8);
+}
+
+TEST_CASE("split_phonemes_for_streaming keeps the first chunk short") {
+  const std::string ps =
+      "hɛlˈoʊ, ðɪs ɪz ɐ lˈɔŋɡɚ sˈɛntəns. "
+      "ænd hˈɪɹ ɪz ɐnˈʌðɚ wˈʌn ðæt ɡˈoʊz ˈɔn";
+  const std::vector<std::string> chunks =
+      moonshine_tts::split_phonemes_for_streaming(ps, 12, 40);
+  REQUIRE(chunks.size() >= 2);
+  CHECK(chunks[0] == "hɛlˈoʊ,");
+  std::string joined;
+  for (const std::string& c : chunks) {
+    CHECK(!c.empty());
+    CHECK(c.front() != ' ');
+    CHECK(c.back() != ' ');
+    if (!joined.empty()) {
+      joined += ' ';
+    }
+    joined += c;
+  }
+  CHECK(joined == ps);
+}
+
+TEST_CASE("split_phonemes_for_streaming grows chunks and splits long words") {
+  const std::vector<std::string> chunks =
+      moonshine_tts::split_phonemes_for_streaming(std::string(20, 'a'), 4, 8);
+  REQUIRE(chunks.size() == 3);
+  CHECK(chunks[0].size() == 4);
+  CHECK(chunks[1].size() == 8);
+  CHECK(chunks[2].size() == 8);
+  CHECK(moonshine_tts::split_phonemes_for_streaming("  ", 4, 8).empty());
+}
+
+TEST_CASE("StreamingOutputEffects fixes its gain from the first chunk") {
+  moonshine_tts::StreamingOutputEffects fx(/*normalize_audio=*/true, 0.5F);
+  std::vector<float> a{0.25F, -0.5F};
+  fx.apply(a);
+  CHECK(a[0] == doctest::Approx(0.25F));
+  CHECK(a[1] == doctest::Approx(-0.5F));
+  // A quieter chunk keeps the first chunk's gain rather than being boosted.
+  std::vector<float> b{0.25F};
+  fx.apply(b);
+  CHECK(b[0] == doctest::Approx(0.25F));
+  std::vector<float> c{1.F};
+  fx.apply(c);
+  CHECK(c[0] == doctest::Approx(0.5F));
+}
+
+TEST_CASE("StreamingOutputEffects limits only around a louder peak") {
+  moonshine_tts::StreamingOutputEffects fx(/*normalize_audio=*/true, 1.F);
+  std::vector<float> first(1000, 0.5F);
+  fx.apply(first);
+  std::vector<float> second(2000, 0.5F);
+  second[1000] = 1.F;
+  fx.apply(second);
+  CHECK(second[1000] == doctest::Approx(1.F));
+  for (size_t i = 0; i < second.size(); ++i) {
+    CAPTURE(i);
+    CHECK(second[i] <= 1.F);
+    if (i + 300 < 1000 || i > 1000 + 300) {
+      CHECK(second[i] == doctest::Approx(1.F));
+    }
+  }
+  CHECK(second[990] < 1.F);
+  CHECK(second[1010] < 1.F);
+}
+
+TEST_CASE("StreamingOutputEffects keeps a rising signal from dropping") {
+  // A sine whose amplitude rises across the utterance, delivered in chunks.
+  // Normalizing each chunk by the running peak turned the start of every
+  // chunk down below the end of the one before it.
+  constexpr size_t kChunk = 2400;
+  constexpr size_t kChunks = 8;
+  constexpr size_t kPeriod = 48;
+  std::vector<float> signal(kChunk * kChunks);
+  for (size_t i = 0; i < signal.size(); ++i) {
+    const double amplitude =
+        0.1 + 0.3 * static_cast<double>(i) / static_cast<double>(signal.size());
+    signal[i] = static_cast<float>(
+        amplitude * std::sin(2.0 * 3.14159265358979 * static_cast<double>(i) /
+                             static_cast<double>(kPeriod)));
+  }
+  moonshine_tts::StreamingOutputEffects fx(/*normalize_audio=*/true, 1.F);
+  std::vector<std::vector<float>> out;
+  for (size_t c = 0; c < kChunks; ++c) {
+    out.emplace_back(signal.begin() + c * kChunk,
+                     signal.begin() + (c + 1) * kChunk);
+    fx.apply(out.back());
+  }
+
+  // The first chunk is normalized as the batch path would normalize it.
+  std::vector<float> batch(signal.begin(), signal.begin() + kChunk);
+  moonshine_tts::apply_synthesis_output_effects(batch, true, 1.F);
+  for (size_t i = 0; i < kChunk; ++i) {
+    CHECK(out[0][i] == doctest::Approx(batch[i]));
+  }
+
+  const auto peak = [](const std::vector<float>& x, size_t begin,
+                       size_t end) {
+    float p = 0.F;
+    for (size_t i = begin; i < end; ++i) {
+      p = std::max(p, std::fabs(x[i]));
+    }
+    return p;
+  };
+  for (size_t c = 0; c < kChunks; ++c) {
+    CAPTURE(c);
+    CHECK(peak(out[c], 0, kChunk) <= 1.F);
+    if (c > 0) {
+      CHECK(peak(out[c], 0, kPeriod) >=
+            0.98F * peak(out[c - 1], kChunk - kPeriod, kChunk));
+    }
+  }
+}
@@ -1,6 +1,7 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+#include <chrono>
 #include <filesystem>
 
 #include "moonshine-tts.h"
@@ -68,3 +69,45 @@ TEST_CASE("MoonshineTTS Piper: per-call speed reduces duration vs baseline") {
   // run-to-run at fixed speed.
   (void)tts.synthesize(text);
 }
+
+TEST_CASE("MoonshineTTS Kokoro: pipelined synthesis of a paragraph") {
+  const std::filesystem::path root =
+      r::moonshine_tts_bundled_data_dir_relative();
+  if (!bundled_tts_data_present(root)) {
+    return;
+  }
+  const std::string text =
+      "The lighthouse keeper climbed the stairs every evening. He lit the "
+      "lamp, wound the clock, and wrote a line in the log. Ships passed in "
+      "the dark without knowing his name. Some nights the fog rolled in so "
+      "thick that he could not see the rail. On those nights he sounded the "
+      "horn until morning. In spring the keeper painted the door a bright "
+      "shade of blue.";
+  const auto timed_synthesis = [&](bool pipelined, double* seconds) {
+    MoonshineTTSOptions opt;
+    opt.g2p_options.g2p_root = root;
+    opt.voice = "kokoro_af_heart";
+    opt.pipeline_synthesis = pipelined;
+    MoonshineTTS tts("en_us", opt);
+    (void)tts.synthesize("Warm up.");
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<float> wav = tts.synthesize(text);
+    *seconds = std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - t0)
+                   .count();
+    return wav;
+  };
+  double serial_s = 0.0;
+  double pipelined_s = 0.0;
+  const std::vector<float> serial = timed_synthesis(false, &serial_s);
+  const std::vector<float> pipelined = timed_synthesis(true, &pipelined_s);
+  REQUIRE(serial.size() > 10u * MoonshineTTS::kSampleRateHz);
+  // Pipelined synthesis vocodes sentence by sentence, so the audio differs
+  // slightly at the joins but its length should not.
+  const double ratio = static_cast<double>(pipelined.size()) /
+                       static_cast<double>(serial.size());
+  CHECK(ratio > 0.85);
+  CHECK(ratio < 1.15);
+  MESSAGE("Kokoro paragraph: serial " << serial_s << " s, pipelined "
+                                      << pipelined_s << " s");
+}
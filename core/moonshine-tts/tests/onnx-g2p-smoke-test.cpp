@@ -3,8 +3,13 @@
 
 #include <cstdlib>
 #include <filesystem>
+#include <string>
+#include <vector>
 
+#include "g2p-word-log.h"
 #include "moonshine-g2p.h"
+#include "onnx-g2p-models.h"
+#include "ort-utils-cxx.h"
 #include "rule-g2p-test-support.h"
 
 using namespace moonshine_tts;
@@ -47,3 +52,67 @@ TEST_CASE("MoonshineG2P ja-JP when data/ja assets exist under repo") {
   const std::string out = g2p.text_to_ipa("東京に行きます。");
   CHECK(out.find("toɯkjoɯ") != std::string::npos);
 }
+
+TEST_CASE("OnnxOovG2p batch decoding matches word-by-word decoding") {
+  const auto model = r::moonshine_tts_bundled_data_dir_relative() / "en_us" /
+                     "oov" / "model.ort";
+  if (!std::filesystem::is_regular_file(model)) {
+    // Say so rather than pass silently: the parity check needs the model.
+    MESSAGE("skip: " << std::filesystem::absolute(model).string()
+                     << " not present; run from the repository root with "
+                        "the bundled data fetched");
+    return;
+  }
+  Ort::Env env = make_ort_env(ORT_LOGGING_LEVEL_WARNING, "oov_batch_test");
+  OnnxOovG2p g2p(env, model, {});
+  // Mixed lengths, so batched rows carry padding that a word decoded on its
+  // own does not (with a dynamic-length export, none at all).
+  const std::vector<std::string> words{"zelinsky", "", "kubectl", "okonkwo",
+                                       "a", "thistlewood"};
+  const std::vector<std::vector<std::string>> batch =
+      g2p.predict_phonemes_batch(words);
+  REQUIRE(batch.size() == words.size());
+  CHECK(batch[1].empty());
+  for (size_t i = 0; i < words.size(); ++i) {
+    CHECK(batch[i] == g2p.predict_phonemes(words[i]));
+  }
+  CHECK_FALSE(batch[0].empty());
+}
+
+TEST_CASE("MoonshineG2P g2p_threads matches one thread") {
+  // Spanish rules need no data files, so this runs on every checkout.
+  const std::string text =
+      "En 1891, el doctor García llegó a Buenos Aires. ¿Quién lo esperaba?\n"
+      "Nadie; la ciudad dormía.\n"
+      "\n"
+      "Al día siguiente compró 3 libros y 25 cuadernos! Luego volvió a "
+      "casa.\n"
+      "Fin.";
+  MoonshineG2P one("es-MX", MoonshineG2POptions{});
+  MoonshineG2POptions threaded_opt;
+  threaded_opt.g2p_threads = 4;
+  MoonshineG2P threaded("es-MX", threaded_opt);
+  REQUIRE(one.threads() == 1);
+  REQUIRE(threaded.threads() == 4);
+
+  std::vector<G2pWordLog> one_log;
+  std::vector<G2pWordLog> threaded_log;
+  const std::string expected = one.text_to_ipa(text, &one_log);
+  CHECK_FALSE(expected.empty());
+  CHECK(threaded.text_to_ipa(text, &threaded_log) == expected);
+  REQUIRE(threaded_log.size() == one_log.size());
+  for (size_t i = 0; i < one_log.size(); ++i) {
+    CAPTURE(i);
+    CHECK(threaded_log[i].surface_token == one_log[i].surface_token);
+    CHECK(threaded_log[i].ipa == one_log[i].ipa);
+  }
+
+  const std::vector<std::string> lines{"Hola, mundo.", "", "Son las 10.",
+                                       "¿Qué tal?", "Adiós."};
+  const std::vector<std::string> batch = threaded.texts_to_ipa(lines);
+  REQUIRE(batch.size() == lines.size());
+  for (size_t i = 0; i < lines.size(); ++i) {
+    CAPTURE(i);
+    CHECK(batch[i] == one.text_to_ipa(lines[i]));
+  }
+}
@@ -0,0 +1,157 @@
+#ifndef MOONSHINE_TTS_TESTS_SPANISH_UNICODE_REFERENCE_H
+#define MOONSHINE_TTS_TESTS_SPANISH_UNICODE_REFERENCE_H
+
+/// The Spanish Unicode data and lookups as they were before the two-stage
+/// tables: sorted (codepoint, replacement) tables searched by binary search,
+/// full-range bitmaps, and a word key built by lower-casing the whole word
+/// and then stripping a copy of it. Loaded from
+/// ``tests/data/spanish-unicode-13.txt`` (see its header), so that
+/// spanish-unicode-test can check the current tables against it and
+/// spanish_unicode_benchmark can time the old path.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utf8-utils.h"
+
+namespace moonshine_tts::spanish_unicode_reference {
+
+class ReferenceTables {
+ public:
+  static constexpr char32_t kLimit = 0x110000;
+
+  explicit ReferenceTables(const std::filesystem::path& path)
+      : word_(kLimit / 32), space_(kLimit / 32) {
+    std::ifstream in(path);
+    if (!in) {
+      throw std::runtime_error("cannot open " + path.string());
+    }
+    std::vector<std::pair<char32_t, std::string>> lower;
+    std::vector<std::pair<char32_t, std::string>> strip;
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.empty() || line[0] == '#') {
+        continue;
+      }
+      std::istringstream fields(line);
+      std::string kind;
+      std::string a;
+      std::string b;
+      if (!(fields >> kind >> a >> b)) {
+        throw std::runtime_error("bad line in " + path.string() + ": " + line);
+      }
+      const char32_t cp = static_cast<char32_t>(std::stoul(a, nullptr, 16));
+      if (kind == "lower" || kind == "strip") {
+        (kind == "lower" ? lower : strip).emplace_back(cp, hex_bytes(b));
+      } else if (kind == "word" || kind == "space") {
+        const char32_t last = static_cast<char32_t>(std::stoul(b, nullptr, 16));
+        for (char32_t c = cp; c <= last; ++c) {
+          (kind == "word" ? word_ : space_)[c / 32] |= uint32_t{1} << (c % 32);
+        }
+      } else {
+        throw std::runtime_error("bad line in " + path.string() + ": " + line);
+      }
+    }
+    // The replacements live in one pool that no longer grows, so the tables
+    // can point into it like the old generated ones pointed into literals.
+    std::sort(lower.begin(), lower.end());
+    std::sort(strip.begin(), strip.end());
+    for (const auto& [cp, rep] : lower) {
+      pool_ += rep;
+      pool_ += '\0';
+    }
+    for (const auto& [cp, rep] : strip) {
+      pool_ += rep;
+      pool_ += '\0';
+    }
+    size_t at = 0;
+    for (const auto& [cp, rep] : lower) {
+      lower_.emplace_back(cp, pool_.data() + at);
+      at += rep.size() + 1;
+    }
+    for (const auto& [cp, rep] : strip) {
+      strip_.emplace_back(cp, pool_.data() + at);
+      at += rep.size() + 1;
+    }
+  }
+
+  /// Replacement of ``cp`` in the old lower / strip table, or null.
+  const char* lower(char32_t cp) const { return lookup(lower_, cp); }
+  const char* strip(char32_t cp) const { return lookup(strip_, cp); }
+  bool is_word_char(char32_t cp) const { return bit(word_, cp); }
+  bool is_space_char(char32_t cp) const { return bit(space_, cp); }
+
+  std::string lower_utf8(const std::string& s) const {
+    return map_utf8(s, lower_);
+  }
+  std::string strip_accents_utf8(const std::string& s) const {
+    return map_utf8(s, strip_);
+  }
+  std::string word_key(const std::string& s) const {
+    return strip_accents_utf8(lower_utf8(s));
+  }
+
+ private:
+  using Table = std::vector<std::pair<char32_t, const char*>>;
+
+  static std::string hex_bytes(const std::string& hex) {
+    std::string out;
+    if (hex == "-") {
+      return out;
+    }
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+      out.push_back(static_cast<char>(std::stoul(hex.substr(i, 2), nullptr,
+                                                 16)));
+    }
+    return out;
+  }
+
+  static const char* lookup(const Table& table, char32_t cp) {
+    const auto it = std::lower_bound(
+        table.begin(), table.end(), cp,
+        [](const std::pair<char32_t, const char*>& e, char32_t k) {
+          return e.first < k;
+        });
+    return it != table.end() && it->first == cp ? it->second : nullptr;
+  }
+
+  static bool bit(const std::vector<uint32_t>& bitmap, char32_t cp) {
+    return cp < kLimit && (bitmap[cp / 32] >> (cp % 32) & 1u) != 0;
+  }
+
+  static std::string map_utf8(const std::string& s, const Table& table) {
+    std::string out;
+    size_t i = 0;
+    while (i < s.size()) {
+      char32_t cp = 0;
+      size_t adv = 0;
+      utf8_decode_at(s, i, cp, adv);
+      const char* rep = lookup(table, cp);
+      if (rep != nullptr) {
+        out += rep;
+      } else {
+        utf8_append_codepoint(out, cp);
+      }
+      i += adv;
+    }
+    return out;
+  }
+
+  std::string pool_;
+  Table lower_;
+  Table strip_;
+  std::vector<uint32_t> word_;
+  std::vector<uint32_t> space_;
+};
+
+}  // namespace moonshine_tts::spanish_unicode_reference
+
+#endif  // MOONSHINE_TTS_TESTS_SPANISH_UNICODE_REFERENCE_H
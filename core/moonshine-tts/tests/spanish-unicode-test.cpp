@@ -0,0 +1,119 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "spanish-unicode.h"
+
+#include <doctest/doctest.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "rule-g2p-test-support.h"
+#include "spanish-unicode-reference.h"
+#include "utf8-utils.h"
+
+namespace su = moonshine_tts::spanish_unicode;
+
+TEST_CASE("spanish unicode: word keys are lower-case without accents") {
+  CHECK(su::word_key("Ñandú") == "nandu");
+  CHECK(su::word_key("PINGÜINO") == "pinguino");
+  CHECK(su::word_key("Straße") == "straße");
+  CHECK(su::word_key("Ελλάδα") == "ελλαδα");
+  // U+0130 lower-cases to "i" + U+0307, and the mark is then stripped.
+  CHECK(su::word_key("İstanbul") == "istanbul");
+  CHECK(su::unicode_lower_utf8("İ") == "i\xcc\x87");
+  CHECK(su::strip_accents_utf8("Árbol") == "Arbol");
+  CHECK(su::word_key("") == "");
+}
+
+TEST_CASE("spanish unicode: hangul syllables strip to conjoining jamo") {
+  // 각 = U+1100 U+1161 U+11A8; 가 has no trailing consonant.
+  CHECK(su::strip_accents_utf8("각") == "\xe1\x84\x80\xe1\x85\xa1\xe1\x86\xa8");
+  CHECK(su::strip_accents_utf8("가") == "\xe1\x84\x80\xe1\x85\xa1");
+  std::string out;
+  CHECK(su::append_strip_replacement_utf8(U'힣', out));
+  CHECK(out == "\xe1\x84\x92\xe1\x85\xb5\xe1\x87\x82");
+  out.clear();
+  CHECK_FALSE(su::append_strip_replacement_utf8(U'n', out));
+  CHECK(out.empty());
+}
+
+TEST_CASE("spanish unicode: word_key_into matches word_key and reuses out") {
+  const std::vector<std::string> words = {
+      "Canción", "ÚLTIMA", "año", "Øresund", "東京", "서울", "x", "",
+      // Invalid UTF-8 is decoded leniently, one code unit per bad byte.
+      "A\xe1\x80", "\xc3"};
+  std::string key = "stale";
+  for (const std::string& w : words) {
+    INFO(w);
+    su::word_key_into(w, key);
+    CHECK(key == su::word_key(w));
+  }
+}
+
+TEST_CASE("spanish unicode: word and space classes follow Python") {
+  CHECK(su::is_word_char(U'a'));
+  CHECK(su::is_word_char(U'_'));
+  CHECK(su::is_word_char(U'ñ'));
+  CHECK(su::is_word_char(U'٣'));
+  CHECK_FALSE(su::is_word_char(U'¿'));
+  CHECK_FALSE(su::is_word_char(U' '));
+  CHECK(su::is_space_char(U' '));
+  CHECK(su::is_space_char(U' '));
+  CHECK(su::is_space_char(U'　'));
+  CHECK_FALSE(su::is_space_char(U'a'));
+  CHECK_FALSE(su::is_word_char(0x110000));
+  CHECK_FALSE(su::is_space_char(0x110000));
+}
+
+TEST_CASE("spanish unicode: tables match the Unicode 13 data shipped before") {
+  namespace rt = moonshine_tts::rule_g2p_test;
+  const moonshine_tts::spanish_unicode_reference::ReferenceTables ref(
+      rt::tests_data_dir(rt::repo_root_from_tests_cpp(__FILE__)) /
+      "spanish-unicode-13.txt");
+  size_t lower_diffs = 0;
+  size_t strip_diffs = 0;
+  size_t key_diffs = 0;
+  size_t class_diffs = 0;
+  char32_t first_diff = 0;
+  const auto note = [&](size_t& count, char32_t cp) {
+    if (lower_diffs + strip_diffs + key_diffs + class_diffs == 0) {
+      first_diff = cp;
+    }
+    ++count;
+  };
+  std::string self;
+  std::string got;
+  for (char32_t cp = 0; cp < ref.kLimit; ++cp) {
+    self.clear();
+    moonshine_tts::utf8_append_codepoint(self, cp);
+
+    got.clear();
+    su::append_lower_utf8(cp, got);
+    const char* lower = ref.lower(cp);
+    if (got != (lower != nullptr ? std::string(lower) : self)) {
+      note(lower_diffs, cp);
+    }
+    got.clear();
+    const bool stripped = su::append_strip_replacement_utf8(cp, got);
+    const char* strip = ref.strip(cp);
+    if (stripped != (strip != nullptr) || (stripped && got != strip)) {
+      note(strip_diffs, cp);
+    }
+    if (su::word_key(self) != ref.word_key(self)) {
+      note(key_diffs, cp);
+    }
+    if (su::is_word_char(cp) != ref.is_word_char(cp) ||
+        su::is_space_char(cp) != ref.is_space_char(cp)) {
+      note(class_diffs, cp);
+    }
+  }
+  char first_hex[16];
+  std::snprintf(first_hex, sizeof(first_hex), "%04X",
+                static_cast<unsigned>(first_diff));
+  INFO("first difference at U+" << first_hex);
+  CHECK(lower_diffs == 0);
+  CHECK(strip_diffs == 0);
+  CHECK(key_diffs == 0);
+  CHECK(class_diffs == 0);
+}
@@ -0,0 +1,38 @@
+#ifndef MOONSHINE_TTS_TESTS_TOK_POS_TEST_SUPPORT_H
+#define MOONSHINE_TTS_TESTS_TOK_POS_TEST_SUPPORT_H
+
+/// Checks shared by the Chinese, Japanese and Korean tokenizer/UPOS tests.
+/// ``TokPos`` is one of the ``*TokPosOnnx`` classes.
+
+#include <doctest/doctest.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "rule-g2p-test-support.h"
+
+namespace moonshine_tts::tok_pos_test {
+
+/// ``annotate_batch(texts)`` gives what ``annotate`` gives one text at a
+/// time; skipped when *model* is missing. The padding and row bookkeeping
+/// behind it are also checked without a model, in length-buckets-test.
+template <typename TokPos>
+void check_batch_matches_single(const std::filesystem::path& model,
+                                const std::vector<std::string>& texts) {
+  if (!rule_g2p_test::model_present(model)) {
+    return;
+  }
+  TokPos pipe(model, false);
+  const auto batched = pipe.annotate_batch(texts);
+  REQUIRE(batched.size() == texts.size());
+  for (std::size_t i = 0; i < texts.size(); ++i) {
+    INFO("text " << i);
+    CHECK(batched[i] == pipe.annotate(texts[i]));
+  }
+}
+
+}  // namespace moonshine_tts::tok_pos_test
+
+#endif  // MOONSHINE_TTS_TESTS_TOK_POS_TEST_SUPPORT_H
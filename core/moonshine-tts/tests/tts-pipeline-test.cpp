@@ -0,0 +1,131 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "tts-pipeline.h"
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "moonshine-tts-options.h"
+
+using moonshine_tts::IncrementalChunker;
+using moonshine_tts::PipelineStage;
+using moonshine_tts::split_text_for_g2p_pipeline;
+
+TEST_CASE("split_text_for_g2p_pipeline splits on clear sentence ends") {
+  const std::vector<std::string> s = split_text_for_g2p_pipeline(
+      "Hello there! Is it ready? I went home. Then I slept.\n"
+      "New line here");
+  REQUIRE(s.size() == 5);
+  CHECK(s[0] == "Hello there!");
+  CHECK(s[1] == "Is it ready?");
+  CHECK(s[2] == "I went home.");
+  CHECK(s[3] == "Then I slept.");
+  CHECK(s[4] == "New line here");
+}
+
+TEST_CASE("split_text_for_g2p_pipeline keeps abbreviations together") {
+  CHECK(split_text_for_g2p_pipeline("Dr. Smith met Mrs. Jones.").size() == 1);
+  CHECK(split_text_for_g2p_pipeline("The U.S. Army is here.").size() == 1);
+  CHECK(split_text_for_g2p_pipeline("Use e.g. this one.").size() == 1);
+  CHECK(split_text_for_g2p_pipeline("Pi is 3.14 today.").size() == 1);
+  const std::vector<std::string> q =
+      split_text_for_g2p_pipeline("He said \"stop.\" Then he left.");
+  REQUIRE(q.size() == 2);
+  CHECK(q[0] == "He said \"stop.\"");
+  CHECK(split_text_for_g2p_pipeline("今日は晴れ。明日は雨。").size() == 2);
+  CHECK(split_text_for_g2p_pipeline("  ").empty());
+}
+
+TEST_CASE("split_text_for_g2p_pipeline keeps wrapped lines together") {
+  const std::vector<std::string> s = split_text_for_g2p_pipeline(
+      "It was the best of times, it was the worst of\n"
+      "times, it was the age of wisdom.  It was the\n"
+      "epoch of belief\n"
+      "\n"
+      "A new paragraph without a full stop\r\n"
+      " \t\r\n"
+      "And another");
+  REQUIRE(s.size() == 4);
+  CHECK(s[0] ==
+        "It was the best of times, it was the worst of\n"
+        "times, it was the age of wisdom.");
+  CHECK(s[1] == "It was the\nepoch of belief");
+  CHECK(s[2] == "A new paragraph without a full stop");
+  CHECK(s[3] == "And another");
+}
+
+TEST_CASE("PipelineStage delivers items in order and forwards errors") {
+  PipelineStage<int> ok([](const auto& push) {
+    for (int i = 0; i < 20; ++i) {
+      if (!push(i)) {
+        return;
+      }
+    }
+  });
+  for (int i = 0; i < 20; ++i) {
+    const std::optional<int> v = ok.next();
+    REQUIRE(v.has_value());
+    CHECK(*v == i);
+  }
+  CHECK(!ok.next().has_value());
+
+  PipelineStage<int> failing([](const auto& push) {
+    push(1);
+    throw std::runtime_error("boom");
+  });
+  CHECK(failing.next() == std::optional<int>(1));
+  CHECK_THROWS_AS(failing.next(), std::runtime_error);
+}
+
+TEST_CASE("PipelineStage stops a producer the consumer abandons") {
+  std::atomic<int> pushed{0};
+  {
+    PipelineStage<int> stage(
+        [&](const auto& push) {
+          for (int i = 0; i < 1000; ++i) {
+            if (!push(i)) {
+              return;
+            }
+            ++pushed;
+          }
+        },
+        /*capacity=*/2);
+    CHECK(stage.next() == std::optional<int>(0));
+  }
+  CHECK(pushed.load() < 1000);
+}
+
+TEST_CASE("IncrementalChunker matches chunking the joined input") {
+  const auto split = [](const std::string& p, size_t released) {
+    return moonshine_tts::split_phonemes_for_streaming(
+        p, moonshine_tts::streaming_chunk_budget(6, 20, released), 20);
+  };
+  const std::vector<std::string> pieces{"ab cd, ef", "gh ij kl mn", "op",
+                                        "qr st uv wx yz ab cd ef gh"};
+  std::string joined;
+  for (const std::string& p : pieces) {
+    joined += (joined.empty() ? "" : " ") + p;
+  }
+  IncrementalChunker<std::string, decltype(split)> chunker(split, " ");
+  std::vector<std::string> got;
+  for (const std::string& p : pieces) {
+    for (std::string& c : chunker.add(p)) {
+      got.push_back(std::move(c));
+    }
+  }
+  for (std::string& c : chunker.finish()) {
+    got.push_back(std::move(c));
+  }
+  CHECK(got == moonshine_tts::split_phonemes_for_streaming(joined, 6, 20));
+  CHECK(got.size() > 2);
+}
+
+TEST_CASE("streaming_chunk_budget doubles up to the cap") {
+  CHECK(moonshine_tts::streaming_chunk_budget(40, 510, 0) == 40);
+  CHECK(moonshine_tts::streaming_chunk_budget(40, 510, 2) == 160);
+  CHECK(moonshine_tts::streaming_chunk_budget(40, 510, 9) == 510);
+  CHECK(moonshine_tts::streaming_chunk_budget(0, 0, 3) == 1);
+}
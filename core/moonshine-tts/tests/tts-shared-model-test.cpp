@@ -0,0 +1,53 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "tts-shared-model.h"
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using moonshine_tts::shared_model_bytes_key;
+using moonshine_tts::shared_model_session_key;
+
+namespace {
+
+std::string bytes_key(const std::string& text) {
+  const std::vector<uint8_t> bytes(text.begin(), text.end());
+  return shared_model_bytes_key(bytes.data(), bytes.size());
+}
+
+}  // namespace
+
+TEST_CASE("shared_model_bytes_key is the size and SHA-256 of the bytes") {
+  CHECK(bytes_key("") ==
+        "bytes:0:"
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  CHECK(bytes_key("abc") ==
+        "bytes:3:"
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  // 56 bytes: the length no longer fits the first padding block.
+  CHECK(bytes_key("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+        "bytes:56:"
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+  // Several whole blocks plus a tail.
+  CHECK(bytes_key(std::string(1000, 'a')) ==
+        "bytes:1000:"
+        "41edece42d63e8d9bf515a9ba6932e1c20cbc9f5a5d134645adb5db1b9737ea3");
+}
+
+TEST_CASE("shared_model_bytes_key tells apart same-size models") {
+  std::vector<uint8_t> a(4096, 7);
+  std::vector<uint8_t> b = a;
+  b[2048] ^= 1;
+  CHECK(shared_model_bytes_key(a.data(), a.size()) ==
+        shared_model_bytes_key(a.data(), a.size()));
+  CHECK(shared_model_bytes_key(a.data(), a.size()) !=
+        shared_model_bytes_key(b.data(), b.size()));
+}
+
+TEST_CASE("shared_model_session_key appends providers and CoreML cache") {
+  CHECK(shared_model_session_key("file:/m.ort", {"coreml", "cpu"}, "/tmp/c") ==
+        "file:/m.ort|providers:coreml,cpu,|coreml:/tmp/c");
+  CHECK(shared_model_session_key("k", {}, "") == "k|providers:|coreml:");
+}
@@ -1,11 +1,18 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "zipvoice-tts.h"
 
+#include <algorithm>
 #include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
 #include <string>
 #include <vector>
 
 #include "doctest.h"
+#include "rule-g2p-test-support.h"
+#include "zipvoice-batch.h"
 #include "zipvoice-mel.h"
 #include "zipvoice-voices.h"
 
@@ -103,3 +110,251 @@ TEST_CASE("zipvoice-compress-long-pauses") {
   const std::vector<float> kept = zipvoice_compress_long_pauses(short_gap, sr);
   CHECK(kept.size() == short_gap.size());
 }
+
+namespace {
+
+// Stands in for the fm_decoder: a velocity that mixes each element with its
+// own conditions and the time, so every row depends only on itself.
+struct FakeVelocity {
+  std::vector<float> v;
+  const float* operator()(float t, ZipVoiceFmBatch& batch) {
+    v.resize(batch.x.size());
+    for (size_t i = 0; i < v.size(); ++i) {
+      v[i] = batch.text_condition[i] - 0.5f * batch.x[i] +
+             t * batch.speech_condition[i];
+    }
+    return v.data();
+  }
+};
+
+std::vector<float> ramp(size_t n, float start, float step) {
+  std::vector<float> out(n);
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = start + step * static_cast<float>(i);
+  }
+  return out;
+}
+
+std::vector<ZipVoiceChunkFeatures> solve(
+    const std::vector<std::vector<float>>& conditions,
+    const std::vector<int>& frames, const std::vector<float>& clone,
+    int clone_frames, int feat_dim) {
+  ZipVoiceFmBatch batch = zipvoice_pack_fm_batch(conditions, frames, clone,
+                                                 clone_frames, feat_dim, 666U);
+  FakeVelocity velocity;
+  zipvoice_euler_solve(batch, {0.f, 0.25f, 0.5f, 1.f},
+                       [&](float t, ZipVoiceFmBatch& in) {
+                         return velocity(t, in);
+                       });
+  return zipvoice_unpack_fm_batch(batch, frames, clone_frames);
+}
+
+}  // namespace
+
+TEST_CASE("zipvoice-batch-of-equal-chunks-matches-one-at-a-time") {
+  constexpr int kFeat = 3;
+  constexpr int kFrames = 7;
+  constexpr int kCloneFrames = 2;
+  const std::vector<float> clone = ramp(kCloneFrames * kFeat, 0.3f, -0.05f);
+  std::vector<std::vector<float>> conditions;
+  for (int b = 0; b < 4; ++b) {
+    conditions.push_back(ramp(kFrames * kFeat, 0.1f * b, 0.01f * (b + 1)));
+  }
+  const std::vector<int> frames(conditions.size(), kFrames);
+  const std::vector<ZipVoiceChunkFeatures> batched =
+      solve(conditions, frames, clone, kCloneFrames, kFeat);
+  REQUIRE(batched.size() == conditions.size());
+  for (size_t b = 0; b < conditions.size(); ++b) {
+    CAPTURE(b);
+    const std::vector<ZipVoiceChunkFeatures> alone =
+        solve({conditions[b]}, {kFrames}, clone, kCloneFrames, kFeat);
+    REQUIRE(alone.size() == 1);
+    CHECK(batched[b].gen_frames == kFrames - kCloneFrames);
+    CHECK(batched[b].gen_frames == alone[0].gen_frames);
+    CHECK(batched[b].pred == alone[0].pred);
+  }
+}
+
+TEST_CASE("zipvoice-batch-of-one-keeps-the-unbatched-layout") {
+  // What sample_chunks fed the fm_decoder before chunks were batched: the
+  // chunk's own frame count, seeded noise, its text condition, and the clone
+  // over its first frames.
+  constexpr int kFeat = 2;
+  constexpr int kFrames = 5;
+  constexpr int kCloneFrames = 3;
+  const std::vector<float> clone = ramp(4 * kFeat, 1.f, 1.f);
+  const std::vector<float> condition = ramp(kFrames * kFeat, -1.f, 0.2f);
+  const ZipVoiceFmBatch batch = zipvoice_pack_fm_batch(
+      {condition}, {kFrames}, clone, kCloneFrames, kFeat, 666U);
+  CHECK(batch.rows == 1);
+  CHECK(batch.frames == kFrames);
+  CHECK(batch.text_condition == condition);
+  std::mt19937 rng(666U);
+  std::normal_distribution<float> dist(0.f, 1.f);
+  std::vector<float> noise(kFrames * kFeat);
+  for (float& v : noise) {
+    v = dist(rng);
+  }
+  CHECK(batch.x == noise);
+  std::vector<float> speech(kFrames * kFeat, 0.f);
+  std::copy(clone.begin(), clone.begin() + kCloneFrames * kFeat,
+            speech.begin());
+  CHECK(batch.speech_condition == speech);
+
+  // The clone frames come off the front of the result.
+  const std::vector<ZipVoiceChunkFeatures> out =
+      zipvoice_unpack_fm_batch(batch, {kFrames}, kCloneFrames);
+  REQUIRE(out.size() == 1);
+  CHECK(out[0].gen_frames == kFrames - kCloneFrames);
+  CHECK(out[0].pred == std::vector<float>(noise.begin() + kCloneFrames * kFeat,
+                                          noise.end()));
+}
+
+TEST_CASE("zipvoice-vocoder-batch-trims-mixed-lengths") {
+  constexpr int kFeat = 2;
+  constexpr float kScale = 0.5f;
+  ZipVoiceChunkFeatures longest{ramp(10 * kFeat, 0.f, 1.f), 10};
+  ZipVoiceChunkFeatures middle{ramp(7 * kFeat, 100.f, 1.f), 7};
+  ZipVoiceChunkFeatures shortest{ramp(3 * kFeat, 200.f, 1.f), 3};
+  const std::vector<const ZipVoiceChunkFeatures*> items{&middle, &longest,
+                                                        &shortest};
+  const size_t t_max = 10;
+  const std::vector<float> mel =
+      zipvoice_pack_vocoder_batch(items, kFeat, kScale, t_max);
+  REQUIRE(mel.size() == items.size() * kFeat * t_max);
+  for (size_t b = 0; b < items.size(); ++b) {
+    CAPTURE(b);
+    const ZipVoiceChunkFeatures& f = *items[b];
+    for (size_t c = 0; c < static_cast<size_t>(kFeat); ++c) {
+      for (size_t t = 0; t < t_max; ++t) {
+        const float expected =
+            t < static_cast<size_t>(f.gen_frames)
+                ? f.pred[t * kFeat + c] / kScale
+                : kZipVoiceSilentLogMel;
+        CHECK(mel[(b * kFeat + c) * t_max + t] == expected);
+      }
+    }
+  }
+
+  // The Vocos vocoder gives 256 samples per frame (one hop).
+  const size_t per_item = 256 * t_max;
+  CHECK(zipvoice_vocoder_row_samples(per_item, 10, t_max) == 2560);
+  CHECK(zipvoice_vocoder_row_samples(per_item, 7, t_max) == 1792);
+  CHECK(zipvoice_vocoder_row_samples(per_item, 3, t_max) == 768);
+  // A vocoder that returns a few samples over whole frames keeps them for the
+  // longest row and rounds the shorter ones down.
+  CHECK(zipvoice_vocoder_row_samples(2565, 10, t_max) == 2565);
+  CHECK(zipvoice_vocoder_row_samples(2565, 7, t_max) == 1795);
+  CHECK(zipvoice_vocoder_row_samples(2565, 3, t_max) == 769);
+}
+
+TEST_CASE("zipvoice-clone-conditioning-cache") {
+  namespace fs = std::filesystem;
+  const fs::path dir =
+      fs::temp_directory_path() / "moonshine-zipvoice-clone-cache-test";
+  fs::remove_all(dir);
+
+  const std::string a = "american_female";
+  const std::string b = "american_male";
+  const uint64_t key = zipvoice_content_hash(a.data(), a.size());
+  CHECK(key == zipvoice_content_hash(a.data(), a.size()));
+  CHECK(key != zipvoice_content_hash(b.data(), b.size()));
+  CHECK(zipvoice_content_hash(b.data(), b.size(), key) !=
+        zipvoice_content_hash(b.data(), b.size()));
+
+  ZipVoiceCloneConditioning loaded;
+  CHECK_FALSE(zipvoice_load_clone_conditioning(dir, key, &loaded));
+
+  ZipVoiceCloneConditioning c;
+  c.frames = 3;
+  c.feat_dim = 2;
+  c.rms = 0.05f;
+  c.features = {0.1f, -0.2f, 0.3f, -0.4f, 0.5f, -0.6f};
+  c.token_ids = {4, 8, 15, 16, 23, 42};
+  REQUIRE(zipvoice_save_clone_conditioning(dir, key, c));
+  REQUIRE(zipvoice_load_clone_conditioning(dir, key, &loaded));
+  CHECK(loaded.frames == c.frames);
+  CHECK(loaded.feat_dim == c.feat_dim);
+  CHECK(loaded.rms == c.rms);
+  CHECK(loaded.features == c.features);
+  CHECK(loaded.token_ids == c.token_ids);
+
+  const fs::path path = zipvoice_clone_cache_path(dir, key);
+  std::string entry;
+  {
+    std::ifstream in(path, std::ios::binary);
+    entry.assign(std::istreambuf_iterator<char>(in),
+                 std::istreambuf_iterator<char>());
+  }
+  const auto write_entry = [&](const fs::path& to, const std::string& bytes) {
+    std::ofstream out(to, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  };
+
+  // An entry copied under another key's name belongs to that other clip.
+  const uint64_t other_key = zipvoice_content_hash(b.data(), b.size());
+  write_entry(zipvoice_clone_cache_path(dir, other_key), entry);
+  CHECK_FALSE(zipvoice_load_clone_conditioning(dir, other_key, &loaded));
+
+  // Header: 4-byte magic, u32 format version at 4, u32 byte-order mark at 8,
+  // u64 key at 12. Changing any of them makes the entry unusable.
+  for (const size_t offset : {size_t{0}, size_t{4}, size_t{8}, size_t{12}}) {
+    CAPTURE(offset);
+    std::string changed = entry;
+    changed[offset] = static_cast<char>(changed[offset] ^ 0x5a);
+    write_entry(path, changed);
+    CHECK_FALSE(zipvoice_load_clone_conditioning(dir, key, &loaded));
+  }
+  // An entry written on a machine of the other byte order.
+  std::string swapped = entry;
+  std::reverse(swapped.begin() + 8, swapped.begin() + 12);
+  write_entry(path, swapped);
+  CHECK_FALSE(zipvoice_load_clone_conditioning(dir, key, &loaded));
+
+  // A truncated entry is ignored rather than trusted.
+  write_entry(path, entry);
+  REQUIRE(zipvoice_load_clone_conditioning(dir, key, &loaded));
+  fs::resize_file(path, fs::file_size(path) - 4);
+  CHECK_FALSE(zipvoice_load_clone_conditioning(dir, key, &loaded));
+  fs::remove_all(dir);
+}
+
+TEST_CASE("zipvoice-clone-cache-skips-preparing-the-clip") {
+  namespace fs = std::filesystem;
+  const fs::path data_dir =
+      rule_g2p_test::moonshine_tts_bundled_data_dir_relative();
+  if (!rule_g2p_test::model_present(data_dir / "zipvoice", "fm_decoder")) {
+    MESSAGE("skip: " << fs::absolute(data_dir / "zipvoice").string()
+                     << " has no ZipVoice model; run from the repository "
+                        "root with the bundled data fetched");
+    return;
+  }
+  const fs::path dir =
+      fs::temp_directory_path() / "moonshine-zipvoice-clone-build-test";
+  fs::remove_all(dir);
+
+  ZipVoiceTTSOptions opt;
+  opt.g2p_options.g2p_root = data_dir;
+  opt.voice_id = "american_female";
+  opt.clone_cache_dir = dir;
+  std::vector<float> first_wav;
+  {
+    ZipVoiceTTS first(opt);
+    CHECK_FALSE(first.clone_from_cache());
+    first_wav = first.synthesize("The cache holds the reference voice.");
+  }
+  size_t entries = 0;
+  for (const fs::directory_entry& e : fs::directory_iterator(dir)) {
+    CHECK(e.path().extension() == ".zvclone");
+    ++entries;
+  }
+  CHECK(entries == 1);
+
+  // The second build reads the entry instead of running the fbank and the
+  // transcript's G2P, and clones the voice the same way.
+  ZipVoiceTTS second(opt);
+  CHECK(second.clone_from_cache());
+  CHECK(second.synthesize("The cache holds the reference voice.") ==
+        first_wav);
+  fs::remove_all(dir);
+}
@@ -0,0 +1,97 @@
+// Builds a memory-mappable compiled lexicon (``.mlex``, see
+// ``CompiledLexicon``) from a G2P lexicon TSV. By default it is written next
+// to the TSV, where the loaders pick it up in place of the TSV for as long as
+// the TSV keeps the size it had when compiled.
+//
+// Usage: compile_lexicon [--format cmudict|arabic] TSV [OUT]
+
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "arabic.h"
+#include "cmudict-tsv.h"
+#include "compiled-lexicon.h"
+
+namespace {
+
+void usage(const char* argv0) {
+  fprintf(stderr,
+          "Usage: %s [--format cmudict|arabic] TSV [OUT]\n"
+          "  cmudict: English CMU-style dictionary (default)\n"
+          "  arabic:  data/ar_msa/dict.tsv\n"
+          "  OUT defaults to TSV with the .mlex extension.\n",
+          argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using moonshine_tts::ArabicRuleG2p;
+  using moonshine_tts::CmudictTsv;
+  using moonshine_tts::CompiledLexicon;
+
+  std::string format = "cmudict";
+  std::filesystem::path tsv;
+  std::filesystem::path out;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--format" && i + 1 < argc) {
+      format = argv[++i];
+    } else if (a == "-h" || a == "--help") {
+      usage(argv[0]);
+      return 0;
+    } else if (tsv.empty()) {
+      tsv = a;
+    } else if (out.empty()) {
+      out = a;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (tsv.empty() || (format != "cmudict" && format != "arabic")) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (out.empty()) {
+    out = CompiledLexicon::compiled_sibling_path(tsv);
+  }
+
+  try {
+    std::ifstream file(tsv, std::ios::binary);
+    if (!file) {
+      fprintf(stderr, "compile_lexicon: cannot open %s\n",
+              tsv.string().c_str());
+      return 1;
+    }
+    // Stamped from the bytes that were parsed, so an edit made while this
+    // runs leaves a file that loaders treat as stale.
+    const std::string text((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+    const CompiledLexicon::Source source =
+        CompiledLexicon::describe_source(text);
+    std::istringstream in(text);
+    const bool arabic = format == "arabic";
+    auto entries = arabic ? ArabicRuleG2p::parse_lexicon_entries(in)
+                          : CmudictTsv::parse_entries(in);
+    const size_t words = entries.size();
+    CompiledLexicon::write_file(out, std::move(entries),
+                                arabic ? ArabicRuleG2p::kCompiledLexiconKind
+                                       : CmudictTsv::kCompiledLexiconKind,
+                                source);
+    printf("%s: %zu words, %ju bytes (TSV %ju bytes)\n", out.string().c_str(),
+           words, static_cast<uintmax_t>(std::filesystem::file_size(out)),
+           static_cast<uintmax_t>(source.bytes));
+  } catch (const std::exception& e) {
+    fprintf(stderr, "compile_lexicon: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
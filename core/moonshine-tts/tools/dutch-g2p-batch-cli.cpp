@@ -1,14 +1,21 @@
 // Dutch rule + lexicon G2P (no ONNX). Batch mode: one input line -> one IPA
 // line on stdout. For parity checks vs Python without spawning one process per
 // phrase.
+#include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "dutch.h"
+#include "g2p-parallel.h"
+#include "rule-based-g2p.h"
+#include "tts-pipeline.h"
 
 namespace {
 
@@ -16,7 +23,7 @@ void usage(const char* argv0) {
   std::cerr << "Usage: " << argv0
             << " [--dict PATH] [--no-stress] [--syllable-initial-stress] "
                "[--no-expand-digits]\n"
-            << "       [--whole-stdin] [TEXT...]\n"
+            << "       [--whole-stdin] [--threads N] [TEXT...]\n"
             << "  With no TEXT: read stdin line-by-line; each non-empty line "
                "is phonemized; "
                "empty lines print an empty line.\n"
@@ -24,6 +31,13 @@ void usage(const char* argv0) {
                "print one line.\n"
             << "  --whole-stdin: read entire stdin as one string (newlines "
                "kept) and phonemize once.\n"
+            << "  --threads N: convert lines on N engines in parallel; output "
+               "order is unchanged.\n"
+            << "    With --whole-stdin, the text is split into sentences "
+               "instead, which are\n"
+            << "    converted in parallel and printed on one line joined by "
+               "spaces. Reports\n"
+            << "    input lines/s on stderr.\n"
             << "  Default dict: data/nl/dict.tsv (relative to cwd).\n";
 }
 
@@ -52,6 +66,7 @@ int main(int argc, char** argv) {
       std::filesystem::path("data") / "nl" / "dict.tsv";
   moonshine_tts::DutchRuleG2p::Options opt;
   bool whole_stdin = false;
+  size_t threads = 0;
   std::vector<std::string> parts;
 
   for (int i = 1; i < argc; ++i) {
@@ -70,17 +85,37 @@ int main(int argc, char** argv) {
       opt.expand_cardinal_digits = false;
     } else if (a == "--whole-stdin") {
       whole_stdin = true;
+    } else if (a == "--threads" && i + 1 < argc) {
+      threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
     } else {
       parts.push_back(a);
     }
   }
 
   try {
-    moonshine_tts::DutchRuleG2p g2p(dict_path, opt);
+    // One engine per thread: engines keep per-call state and are not
+    // thread-safe.
+    std::vector<std::unique_ptr<moonshine_tts::DutchRuleG2p>> owned;
+    std::vector<moonshine_tts::RuleBasedG2p*> engines;
+    for (size_t t = 0; t < std::max<size_t>(threads, 1); ++t) {
+      owned.push_back(
+          std::make_unique<moonshine_tts::DutchRuleG2p>(dict_path, opt));
+      engines.push_back(owned.back().get());
+    }
+    moonshine_tts::DutchRuleG2p& g2p = *owned.front();
 
     if (whole_stdin) {
       const std::string text = read_all_stdin();
-      std::cout << g2p.text_to_ipa(text) << '\n';
+      if (threads == 0) {
+        std::cout << g2p.text_to_ipa(text) << '\n';
+        return 0;
+      }
+      const auto start = std::chrono::steady_clock::now();
+      const std::vector<std::string> ipa = moonshine_tts::texts_to_ipa_parallel(
+          engines, moonshine_tts::split_text_for_g2p_pipeline(text));
+      moonshine_tts::report_rate(std::cerr, moonshine_tts::count_lines(text),
+                                 threads, start);
+      std::cout << moonshine_tts::join_sentence_ipa(ipa) << '\n';
       return 0;
     }
 
@@ -96,6 +131,12 @@ int main(int argc, char** argv) {
       return 0;
     }
 
+    if (threads > 0) {
+      moonshine_tts::convert_lines_parallel(engines, std::cin, std::cout,
+                                            std::cerr);
+      return 0;
+    }
+
     std::string line;
     while (std::getline(std::cin, line)) {
       if (!line.empty() && line.back() == '\r') {
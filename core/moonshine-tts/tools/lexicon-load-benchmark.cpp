@@ -0,0 +1,243 @@
+// Compares ways of loading the English G2P lexicon: parsing the TSV into the
+// per-word hash map the loader used to build, parsing it into one packed
+// ``CompiledLexicon`` buffer (a TSV load without a compiled sibling),
+// ``CompiledLexicon::open`` on a TSV with a matching ``.mlex`` sibling (reads
+// and hashes the TSV, then maps the sibling), and memory-mapping a compiled
+// ``.mlex`` file directly. Reports load time, the time to look up every word
+// once, and the growth in resident memory while each table is alive (on Linux
+// also the anonymous, i.e. per-process, part of it). Freed heap is not always
+// returned to the OS, so use ``--mode`` to measure one layout per process for
+// the cleanest memory numbers.
+//
+// Usage: lexicon_load_benchmark [--tsv PATH]
+//                               [--mode all|hash|packed|open|mapped]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cmudict-tsv.h"
+#include "compiled-lexicon.h"
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+namespace {
+
+using moonshine_tts::CmudictTsv;
+using moonshine_tts::CompiledLexicon;
+
+struct MemoryKb {
+  size_t rss = 0;
+  size_t anon = 0;
+};
+
+size_t status_field_kb(const char* line, size_t prefix_len) {
+  char* end = nullptr;
+  const unsigned long long parsed = std::strtoull(line + prefix_len, &end, 10);
+  return end != line + prefix_len ? static_cast<size_t>(parsed) : 0;
+}
+
+MemoryKb read_memory_kb() {
+  MemoryKb m;
+#if defined(__linux__)
+  FILE* f = std::fopen("/proc/self/status", "r");
+  if (f == nullptr) {
+    return m;
+  }
+  char line[256];
+  while (std::fgets(line, sizeof(line), f) != nullptr) {
+    if (std::strncmp(line, "VmRSS:", 6) == 0) {
+      m.rss = status_field_kb(line, 6);
+    } else if (std::strncmp(line, "RssAnon:", 8) == 0) {
+      m.anon = status_field_kb(line, 8);
+    }
+  }
+  std::fclose(f);
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+    m.rss = info.resident_size / 1024;
+  }
+#endif
+  return m;
+}
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+long long delta_kb(size_t after, size_t before) {
+  return static_cast<long long>(after) - static_cast<long long>(before);
+}
+
+void report(const char* mode, double load_ms, double lookup_ms,
+            const MemoryKb& before, const MemoryKb& after) {
+  printf("%-8s %10.1f %11.1f %12lld %12lld\n", mode, load_ms, lookup_ms,
+         delta_kb(after.rss, before.rss), delta_kb(after.anon, before.anon));
+}
+
+/// Looks up every key once; returns the number of alternatives seen so the
+/// loop cannot be optimized away.
+size_t lookup_all(const CompiledLexicon& lex,
+                  const std::vector<std::string>& keys) {
+  size_t n = 0;
+  for (const std::string& k : keys) {
+    n += lex.lookup(k).size();
+  }
+  return n;
+}
+
+std::vector<CompiledLexicon::Entry> parse_file(
+    const std::filesystem::path& tsv) {
+  std::ifstream in(tsv, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("cannot open " + tsv.string());
+  }
+  return CmudictTsv::parse_entries(in);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::filesystem::path tsv = std::filesystem::path("data") / "en_us" /
+                              "dict_filtered_heteronyms.tsv";
+  std::string mode = "all";
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--tsv" && i + 1 < argc) {
+      tsv = argv[++i];
+    } else if (a == "--mode" && i + 1 < argc) {
+      mode = argv[++i];
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--tsv PATH] [--mode all|hash|packed|open|mapped]\n",
+              argv[0]);
+      return a == "-h" || a == "--help" ? 0 : 1;
+    }
+  }
+  const bool all = mode == "all";
+  if (!all && mode != "hash" && mode != "packed" && mode != "open" &&
+      mode != "mapped") {
+    fprintf(stderr, "lexicon_load_benchmark: unknown --mode %s\n",
+            mode.c_str());
+    return 1;
+  }
+
+  try {
+    // Keys and the compiled file are prepared up front so that neither counts
+    // towards any mode's numbers. The TSV is copied next to the compiled file
+    // so that ``open`` finds it as the sibling.
+    std::vector<std::string> keys;
+    const std::filesystem::path tsv_copy =
+        std::filesystem::temp_directory_path() / "lexicon_load_benchmark.tsv";
+    const std::filesystem::path mlex =
+        CompiledLexicon::compiled_sibling_path(tsv_copy);
+    {
+      std::filesystem::copy_file(
+          tsv, tsv_copy, std::filesystem::copy_options::overwrite_existing);
+      std::ifstream file(tsv_copy, std::ios::binary);
+      const std::string text((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+      std::istringstream in(text);
+      auto entries = CmudictTsv::parse_entries(in);
+      keys.reserve(entries.size());
+      for (const auto& e : entries) {
+        keys.push_back(e.first);
+      }
+      CompiledLexicon::write_file(mlex, std::move(entries),
+                                  CmudictTsv::kCompiledLexiconKind,
+                                  CompiledLexicon::describe_source(text));
+    }
+    printf("%s: %zu words, TSV %ju bytes, compiled %ju bytes\n",
+           tsv.string().c_str(), keys.size(),
+           static_cast<uintmax_t>(std::filesystem::file_size(tsv)),
+           static_cast<uintmax_t>(std::filesystem::file_size(mlex)));
+    printf("%-8s %10s %11s %12s %12s\n", "mode", "load ms", "lookup ms",
+           "rss +KiB", "anon +KiB");
+
+    // Least heap first, so earlier modes' freed memory inflates later ones
+    // as little as possible.
+    if (all || mode == "mapped") {
+      const MemoryKb before = read_memory_kb();
+      const auto start = std::chrono::steady_clock::now();
+      const CompiledLexicon lex =
+          CompiledLexicon::map_file(mlex, CmudictTsv::kCompiledLexiconKind);
+      const double load_ms = ms_since(start);
+      const auto lookup_start = std::chrono::steady_clock::now();
+      (void)lookup_all(lex, keys);
+      const double lookup_ms = ms_since(lookup_start);
+      report("mapped", load_ms, lookup_ms, before, read_memory_kb());
+    }
+    if (all || mode == "open") {
+      const MemoryKb before = read_memory_kb();
+      const auto start = std::chrono::steady_clock::now();
+      const CompiledLexicon lex =
+          CompiledLexicon::open(tsv_copy, CmudictTsv::kCompiledLexiconKind,
+                                &CmudictTsv::parse_entries);
+      const double load_ms = ms_since(start);
+      if (!lex.is_mapped()) {
+        fprintf(stderr, "lexicon_load_benchmark: open parsed the TSV\n");
+      }
+      const auto lookup_start = std::chrono::steady_clock::now();
+      (void)lookup_all(lex, keys);
+      const double lookup_ms = ms_since(lookup_start);
+      report("open", load_ms, lookup_ms, before, read_memory_kb());
+    }
+    if (all || mode == "packed") {
+      const MemoryKb before = read_memory_kb();
+      const auto start = std::chrono::steady_clock::now();
+      const CompiledLexicon lex = CompiledLexicon::from_bytes(
+          CompiledLexicon::serialize(parse_file(tsv),
+                                     CmudictTsv::kCompiledLexiconKind),
+          CmudictTsv::kCompiledLexiconKind);
+      const double load_ms = ms_since(start);
+      const auto lookup_start = std::chrono::steady_clock::now();
+      (void)lookup_all(lex, keys);
+      const double lookup_ms = ms_since(lookup_start);
+      report("packed", load_ms, lookup_ms, before, read_memory_kb());
+    }
+    if (all || mode == "hash") {
+      const MemoryKb before = read_memory_kb();
+      const auto start = std::chrono::steady_clock::now();
+      std::unordered_map<std::string, std::vector<std::string>> map;
+      for (auto& [k, v] : parse_file(tsv)) {
+        map.emplace(std::move(k), std::move(v));
+      }
+      const double load_ms = ms_since(start);
+      const auto lookup_start = std::chrono::steady_clock::now();
+      size_t n = 0;
+      for (const std::string& k : keys) {
+        const auto it = map.find(k);
+        n += it == map.end() ? 0 : it->second.size();
+      }
+      const double lookup_ms = ms_since(lookup_start);
+      report("hash", load_ms, lookup_ms, before, read_memory_kb());
+      (void)n;
+    }
+    std::error_code ec;
+    std::filesystem::remove(mlex, ec);
+    std::filesystem::remove(tsv_copy, ec);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "lexicon_load_benchmark: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
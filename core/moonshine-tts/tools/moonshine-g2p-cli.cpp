@@ -1,4 +1,6 @@
 // Unified G2P CLI: rule-based dialects (English, Spanish, German, …).
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
@@ -7,6 +9,7 @@
 #include <string>
 #include <vector>
 
+#include "g2p-parallel.h"
 #include "g2p-word-log.h"
 #include "moonshine-g2p.h"
 #include "spanish.h"
@@ -27,7 +30,7 @@ void usage(const char *argv0) {
       << "       (omit DIR to use the process cwd as the asset root; same "
          "layout as MoonshineTTS/PiperTTS)\n"
       << "       [--dict PATH] [--oov-onnx PATH]\n"
-      << "       [--cuda] [--log-words|-v]\n"
+      << "       [--cuda] [--log-words|-v] [--threads N]\n"
       << "       [--no-stress] [--broad-phonemes] [--stdin]\n"
       << "       [--german-dict PATH] [--german-syllable-initial-stress]\n"
       << "       [--russian-dict PATH] [--russian-syllable-initial-stress]\n"
@@ -96,7 +99,10 @@ void usage(const char *argv0) {
          "<model-root>/hi/dict.tsv; override with --hindi-dict.\n"
       << "  -d PATH / --dict PATH: English CMU TSV (en_us only; overrides "
          "default under "
-         "<model-root>/en_us/).\n";
+         "<model-root>/en_us/).\n"
+      << "  --threads N: convert sentences in parallel on N G2P engines "
+         "(g2p_threads) and\n"
+      << "    report input lines per second on stderr.\n";
 }
 
 std::string read_all_stdin() {
@@ -180,6 +186,7 @@ int main(int argc, char **argv) {
   bool log_words = false;
   bool force_stdin = false;
   bool print_spanish_dialects = false;
+  bool report_rate = false;
   std::vector<std::string> text_parts;
 
   for (int i = 1; i < argc; ++i) {
@@ -273,6 +280,9 @@ int main(int argc, char **argv) {
       opt.spanish_narrow_obstruents = false;
     } else if (a == "--stdin") {
       force_stdin = true;
+    } else if (a == "--threads" && i + 1 < argc) {
+      opt.g2p_threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+      report_rate = true;
     } else {
       text_parts.push_back(a);
     }
@@ -304,8 +314,15 @@ int main(int argc, char **argv) {
   try {
     MoonshineG2P g2p(dialect_str, opt);
     std::vector<moonshine_tts::G2pWordLog> word_log;
-    std::cout << g2p.text_to_ipa(phrase, log_words ? &word_log : nullptr)
-              << '\n';
+    const auto start = std::chrono::steady_clock::now();
+    const std::string ipa =
+        g2p.text_to_ipa(phrase, log_words ? &word_log : nullptr);
+    if (report_rate) {
+      moonshine_tts::report_rate(std::cerr,
+                                 moonshine_tts::count_lines(phrase),
+                                 g2p.threads(), start);
+    }
+    std::cout << ipa << '\n';
     if (log_words) {
       for (const auto &e : word_log) {
         std::cerr << format_g2p_word_log_line(e) << '\n';
@@ -1,4 +1,6 @@
 // CLI: Moonshine G2P + Kokoro or Piper ONNX → WAV (via MoonshineTTS).
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <iostream>
@@ -19,8 +21,8 @@ void usage(const char* argv0) {
          "[--piper-onnx PATH.onnx] [--piper-onnx-json PATH.onnx.json] "
          "[--piper-voices-dir DIR] "
          "[--piper-voices-json-dir DIR] "
-         "[--lang LANG] [--voice ID] [--speed N] [-o out.wav] [--text \"...\"] "
-         "[TEXT...]\n"
+         "[--lang LANG] [--voice ID] [--speed N] [--stream] [-o out.wav] "
+         "[--text \"...\"] [TEXT...]\n"
       << "  G2P + layout: if ``--model-root`` is omitted, the process current "
          "working directory is the "
          "asset root (``kokoro/``, ``ja/``, ``en_us/``, …); relative paths "
@@ -51,6 +53,9 @@ void usage(const char* argv0) {
          "stem (e.g. ``kokoro_af_heart``, ``piper_de_DE-thorsten-medium``). "
          "Without a prefix, the default backend "
          "uses the id/stem as today (e.g. ``af_heart`` with Kokoro on en_us).\n"
+      << "  --stream: synthesize through ``synthesize_streaming`` (short "
+         "first chunk) and report time to first PCM separately from the "
+         "total.\n"
       << "  Default output: out.wav. Default text if none: \"Hello world\".\n";
 }
 
@@ -90,6 +95,7 @@ int main(int argc, char** argv) {
   std::vector<std::pair<std::string, std::string>> pairs;
   std::vector<std::string> positionals;
   std::string text_flag;
+  bool stream = false;
 
   for (int i = 1; i < argc;) {
     const std::string a = argv[i];
@@ -102,6 +108,11 @@ int main(int argc, char** argv) {
       i += 2;
       continue;
     }
+    if (a == "--stream") {
+      stream = true;
+      ++i;
+      continue;
+    }
     if (a == "-o" && i + 1 < argc) {
       pairs.emplace_back("output", argv[i + 1]);
       i += 2;
@@ -162,14 +173,42 @@ int main(int argc, char** argv) {
 
   try {
     MoonshineTTS tts(lang, opt);
-    const std::vector<float> wav = tts.synthesize(text);
+    using Clock = std::chrono::steady_clock;
+    const auto ms_since = [](Clock::time_point t0) {
+      return std::chrono::duration<double, std::milli>(Clock::now() - t0)
+          .count();
+    };
+    std::vector<float> wav;
+    double first_pcm_ms = -1.0;
+    const Clock::time_point t0 = Clock::now();
+    if (stream) {
+      tts.synthesize_streaming(text, [&](const float* samples, size_t n) {
+        if (first_pcm_ms < 0.0) {
+          first_pcm_ms = ms_since(t0);
+        }
+        wav.insert(wav.end(), samples, samples + n);
+        return true;
+      });
+    } else {
+      wav = tts.synthesize(text);
+    }
+    const double total_ms = ms_since(t0);
+    if (first_pcm_ms < 0.0) {
+      first_pcm_ms = total_ms;
+    }
     if (wav.empty()) {
       std::cerr << "Error: empty waveform.\n";
       return 1;
     }
     write_wav_mono_pcm16(opt.output_path, wav);
+    const double audio_ms =
+        1000.0 * static_cast<double>(wav.size()) / MoonshineTTS::kSampleRateHz;
     std::cout << "Wrote " << opt.output_path << " (" << wav.size()
               << " samples, " << MoonshineTTS::kSampleRateHz << " Hz)\n";
+    std::printf(
+        "First PCM after %.1f ms, %.1f ms of audio in %.1f ms (RTF %.3f)%s\n",
+        first_pcm_ms, audio_ms, total_ms, total_ms / audio_ms,
+        stream ? ", streamed" : "");
   } catch (const std::exception& e) {
     std::cerr << "Error: " << e.what() << '\n';
     return 1;
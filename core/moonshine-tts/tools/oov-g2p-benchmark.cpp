@@ -0,0 +1,111 @@
+// Measures English OOV G2P throughput in words per second: each word decoded
+// on its own (``predict_phonemes``) against whole sentences' worth of words
+// decoded together (``predict_phonemes_batch``).
+//
+// Usage: oov_g2p_benchmark [--model PATH] [--runs N]
+
+#include <onnxruntime_cxx_api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "onnx-g2p-models.h"
+#include "ort-utils-cxx.h"
+
+namespace {
+
+using moonshine_tts::OnnxOovG2p;
+
+// Names, brands and URL fragments of the kind that miss the lexicon.
+const char* const kWords[] = {
+    "zelinsky",     "quarkus",      "okonkwo",      "tailscale",
+    "nguyenova",    "valdivieso",   "kubectl",      "xanthoria",
+    "bellweather",  "mcallistair",  "datadoghq",    "zyphora",
+    "ravensholt",   "onnxruntime",  "thistlewood",  "krzyzewski",
+    "vercelapp",    "lindqvist",    "snowflakedb",  "ostrowski",
+    "cloudfront",   "abernathy",    "quillfeather", "hyperloop",
+};
+constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/// Best words per second over ``runs``, decoding ``words`` in groups of
+/// ``batch`` (0 decodes each word with ``predict_phonemes``).
+double best_words_per_second(OnnxOovG2p& g2p,
+                             const std::vector<std::string>& words,
+                             size_t batch, int runs) {
+  double best = 0.0;
+  for (int r = 0; r < runs; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    if (batch == 0) {
+      for (const std::string& w : words) {
+        (void)g2p.predict_phonemes(w);
+      }
+    } else {
+      for (size_t i = 0; i < words.size(); i += batch) {
+        const std::vector<std::string> group(
+            words.begin() + static_cast<std::ptrdiff_t>(i),
+            words.begin() +
+                static_cast<std::ptrdiff_t>(std::min(words.size(), i + batch)));
+        (void)g2p.predict_phonemes_batch(group);
+      }
+    }
+    const double elapsed = seconds_since(start);
+    if (elapsed > 0.0) {
+      best = std::max(best, static_cast<double>(words.size()) / elapsed);
+    }
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::filesystem::path model = std::filesystem::path("data") / "en_us" /
+                                "oov" / "model.ort";
+  int runs = 3;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--model" && i + 1 < argc) {
+      model = argv[++i];
+    } else if (a == "--runs" && i + 1 < argc) {
+      runs = std::max(1, atoi(argv[++i]));
+    } else {
+      fprintf(stderr, "Usage: %s [--model PATH] [--runs N]\n", argv[0]);
+      return a == "-h" || a == "--help" ? 0 : 1;
+    }
+  }
+
+  try {
+    Ort::Env env = make_ort_env(ORT_LOGGING_LEVEL_WARNING, "oov_g2p_benchmark");
+    OnnxOovG2p g2p(env, model, {});
+    std::vector<std::string> words;
+    for (size_t i = 0; i < 4 * kWordCount; ++i) {
+      words.emplace_back(kWords[i % kWordCount]);
+    }
+    (void)g2p.predict_phonemes_batch({kWords[0], kWords[1]});
+
+    printf("%-16s %12s\n", "mode", "words/s");
+    printf("%-16s %12.1f\n", "per word",
+           best_words_per_second(g2p, words, 0, runs));
+    for (const size_t batch : {size_t{1}, size_t{8}, size_t{32}}) {
+      const std::string label = "batch " + std::to_string(batch);
+      printf("%-16s %12.1f\n", label.c_str(),
+             best_words_per_second(g2p, words, batch, runs));
+    }
+  } catch (const std::exception& e) {
+    fprintf(stderr, "oov_g2p_benchmark: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,235 @@
+// Measures Spanish Unicode normalization throughput in input bytes per
+// second: building each word's lexicon key as a new string (``word_key``)
+// against writing it into one reused buffer (``word_key_into``), and scanning
+// the text with ``is_word_char`` / ``is_space_char`` the way the tokenizer
+// does. The text is a built-in Spanish sample with some non-Latin words mixed
+// in, unless ``--text`` names a UTF-8 file.
+//
+// The "(old)" rows time the lookups used before the two-stage tables (sorted
+// tables searched by binary search, full-range bitmaps, and a word key built
+// by lower-casing and then stripping a copy), rebuilt from the reference data
+// in tests/data/spanish-unicode-13.txt. They are skipped when that file is not
+// found from the working directory and ``--reference`` is not given.
+//
+// Usage: spanish_unicode_benchmark [--text PATH] [--runs N]
+//                                  [--reference PATH]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "spanish-unicode-reference.h"
+#include "spanish-unicode.h"
+#include "utf8-utils.h"
+
+namespace {
+
+namespace su = moonshine_tts::spanish_unicode;
+using moonshine_tts::spanish_unicode_reference::ReferenceTables;
+
+const char kSample[] =
+    "Andorra, oficialmente Principado de Andorra, es un microestado soberano "
+    "sin litoral ubicado en el suroeste de Europa, entre España y Francia, en "
+    "el límite de la península ibérica. Se constituye en Estado independiente, "
+    "de derecho, democrático y social, cuya forma de gobierno es el "
+    "coprincipado parlamentario. ¿Cuántos años tenía el niño? ¡Qué pingüino "
+    "más pequeño! Ésta ÚLTIMA canción, «Señor Ñandú», llegó al Nº 1 en 1891. "
+    "Straße, Øresund, İstanbul, Ελλάδα, Москва, 서울, 東京. ";
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+std::string read_file(const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("cannot open " + path.string());
+  }
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+/// Whitespace-separated words of ``text``.
+std::vector<std::string> split_words(const std::string& text) {
+  std::vector<std::string> words;
+  std::string cur;
+  for (const char c : text) {
+    if (moonshine_tts::is_ascii_whitespace(static_cast<unsigned char>(c))) {
+      if (!cur.empty()) {
+        words.push_back(std::move(cur));
+        cur.clear();
+      }
+    } else {
+      cur.push_back(c);
+    }
+  }
+  if (!cur.empty()) {
+    words.push_back(std::move(cur));
+  }
+  return words;
+}
+
+/// ``tests/data/spanish-unicode-13.txt`` from the repository root or the
+/// moonshine-tts directory, or an empty path.
+std::filesystem::path find_reference() {
+  const std::filesystem::path relative =
+      std::filesystem::path("tests") / "data" / "spanish-unicode-13.txt";
+  for (const std::filesystem::path& dir :
+       {std::filesystem::path("core") / "moonshine-tts",
+        std::filesystem::path(".")}) {
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(dir / relative, ec)) {
+      return dir / relative;
+    }
+  }
+  return {};
+}
+
+/// Scans ``text`` the way the tokenizer does, counting word and space
+/// characters with ``tables``' classifiers.
+template <typename Tables>
+size_t classify_text(const std::string& text, const Tables& tables) {
+  size_t n = 0;
+  size_t i = 0;
+  while (i < text.size()) {
+    char32_t cp = 0;
+    size_t adv = 0;
+    moonshine_tts::utf8_decode_at(text, i, cp, adv);
+    n += tables.is_word_char(cp) ? 2 : tables.is_space_char(cp) ? 1 : 0;
+    i += adv;
+  }
+  return n;
+}
+
+/// The current tables, in the shape ``classify_text`` expects.
+struct CurrentTables {
+  bool is_word_char(char32_t cp) const { return su::is_word_char(cp); }
+  bool is_space_char(char32_t cp) const { return su::is_space_char(cp); }
+};
+
+/// Best bytes per second of ``body`` over ``runs``; ``body`` returns a value
+/// that depends on all its work, so the loop cannot be optimized away.
+template <typename Body>
+double best_bytes_per_second(size_t bytes, int runs, Body body) {
+  double best = 0.0;
+  size_t sink = 0;
+  for (int r = 0; r < runs; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    sink += body();
+    const double elapsed = seconds_since(start);
+    if (elapsed > 0.0) {
+      best = std::max(best, static_cast<double>(bytes) / elapsed);
+    }
+  }
+  if (sink == 0) {
+    fprintf(stderr, "(empty result)\n");
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::filesystem::path text_path;
+  std::filesystem::path reference_path;
+  int runs = 5;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--text" && i + 1 < argc) {
+      text_path = argv[++i];
+    } else if (a == "--runs" && i + 1 < argc) {
+      runs = std::max(1, atoi(argv[++i]));
+    } else if (a == "--reference" && i + 1 < argc) {
+      reference_path = argv[++i];
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--text PATH] [--runs N] [--reference PATH]\n",
+              argv[0]);
+      return a == "-h" || a == "--help" ? 0 : 1;
+    }
+  }
+
+  try {
+    std::string text;
+    if (text_path.empty()) {
+      // About 4 MiB, so one pass takes long enough to time.
+      while (text.size() < (size_t{4} << 20)) {
+        text += kSample;
+      }
+    } else {
+      text = read_file(text_path);
+    }
+    const std::vector<std::string> words = split_words(text);
+    size_t word_bytes = 0;
+    for (const std::string& w : words) {
+      word_bytes += w.size();
+    }
+
+    if (reference_path.empty()) {
+      reference_path = find_reference();
+    }
+    std::unique_ptr<ReferenceTables> old_tables;
+    if (!reference_path.empty()) {
+      old_tables = std::make_unique<ReferenceTables>(reference_path);
+    }
+
+    printf("%zu bytes, %zu words\n", text.size(), words.size());
+    if (old_tables == nullptr) {
+      printf("(old) rows skipped: tests/data/spanish-unicode-13.txt not "
+             "found\n");
+    }
+    printf("%-16s %12s\n", "mode", "MB/s");
+    if (old_tables != nullptr) {
+      const double old_key = best_bytes_per_second(word_bytes, runs, [&] {
+        size_t n = 0;
+        for (const std::string& w : words) {
+          n += old_tables->word_key(w).size();
+        }
+        return n;
+      });
+      printf("%-16s %12.1f\n", "word_key (old)", old_key / 1e6);
+    }
+    const double word_key = best_bytes_per_second(word_bytes, runs, [&] {
+      size_t n = 0;
+      for (const std::string& w : words) {
+        n += su::word_key(w).size();
+      }
+      return n;
+    });
+    printf("%-16s %12.1f\n", "word_key", word_key / 1e6);
+    const double word_key_into = best_bytes_per_second(word_bytes, runs, [&] {
+      size_t n = 0;
+      std::string key;
+      for (const std::string& w : words) {
+        su::word_key_into(w, key);
+        n += key.size();
+      }
+      return n;
+    });
+    printf("%-16s %12.1f\n", "word_key_into", word_key_into / 1e6);
+    if (old_tables != nullptr) {
+      const double old_classify = best_bytes_per_second(
+          text.size(), runs, [&] { return classify_text(text, *old_tables); });
+      printf("%-16s %12.1f\n", "classify (old)", old_classify / 1e6);
+    }
+    const CurrentTables new_tables;
+    const double classify = best_bytes_per_second(
+        text.size(), runs, [&] { return classify_text(text, new_tables); });
+    printf("%-16s %12.1f\n", "classify", classify / 1e6);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "spanish_unicode_benchmark: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
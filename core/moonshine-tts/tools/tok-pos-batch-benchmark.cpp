@@ -0,0 +1,188 @@
+// Measures throughput of the token-classification models in front of the
+// Chinese and Japanese G2P (tokenizer / UPOS tagging), the Korean tagger and
+// the Arabic diacritizer, in sentences per second: each sentence run on its
+// own (``annotate`` / ``diacritize``) against groups of sentences run through
+// ``annotate_batch`` / ``diacritize_batch``, which pads similar-length
+// sentences into shared model runs. Sentences come from the first lines of
+// ``<data>/<lang>/wiki-text.txt``, split the way the G2P pipeline splits text.
+//
+// Usage: tok_pos_batch_benchmark [--lang zh_hans|ja|ko|ar] [--data DIR]
+//                                [--lines N] [--runs N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arabic-diac-onnx.h"
+#include "chinese-tok-pos-onnx.h"
+#include "japanese-tok-pos-onnx.h"
+#include "korean-tok-pos-onnx.h"
+#include "tts-pipeline.h"
+
+namespace {
+
+using Texts = std::vector<std::string>;
+
+/// Runs the model over ``texts``; one call per sentence or one batched call.
+struct Runner {
+  std::function<void(const std::string&)> one;
+  std::function<void(const Texts&)> batch;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+Texts read_sentences(const std::filesystem::path& path, size_t max_lines) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("cannot open " + path.string());
+  }
+  Texts sentences;
+  std::string line;
+  for (size_t n = 0; n < max_lines && std::getline(in, line); ++n) {
+    for (std::string& s : moonshine_tts::split_text_for_g2p_pipeline(line)) {
+      sentences.push_back(std::move(s));
+    }
+  }
+  return sentences;
+}
+
+/// Best sentences per second over ``runs``, in groups of ``batch`` (0 runs
+/// each sentence on its own).
+double best_sentences_per_second(const Runner& runner, const Texts& sentences,
+                                 size_t batch, int runs) {
+  double best = 0.0;
+  for (int r = 0; r < runs; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    if (batch == 0) {
+      for (const std::string& s : sentences) {
+        runner.one(s);
+      }
+    } else {
+      for (size_t i = 0; i < sentences.size(); i += batch) {
+        const Texts group(
+            sentences.begin() + static_cast<std::ptrdiff_t>(i),
+            sentences.begin() + static_cast<std::ptrdiff_t>(
+                                    std::min(sentences.size(), i + batch)));
+        runner.batch(group);
+      }
+    }
+    const double elapsed = seconds_since(start);
+    if (elapsed > 0.0) {
+      best = std::max(best, static_cast<double>(sentences.size()) / elapsed);
+    }
+  }
+  return best;
+}
+
+void usage(const char* argv0) {
+  fprintf(stderr,
+          "Usage: %s [--lang zh_hans|ja|ko|ar] [--data DIR] [--lines N] "
+          "[--runs N]\n",
+          argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using namespace moonshine_tts;
+
+  std::string lang = "zh_hans";
+  std::filesystem::path data = "data";
+  size_t lines = 100;
+  int runs = 3;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--lang" && i + 1 < argc) {
+      lang = argv[++i];
+    } else if (a == "--data" && i + 1 < argc) {
+      data = argv[++i];
+    } else if (a == "--lines" && i + 1 < argc) {
+      lines = static_cast<size_t>(std::max(1, atoi(argv[++i])));
+    } else if (a == "--runs" && i + 1 < argc) {
+      runs = std::max(1, atoi(argv[++i]));
+    } else {
+      usage(argv[0]);
+      return a == "-h" || a == "--help" ? 0 : 1;
+    }
+  }
+  if (lang != "zh_hans" && lang != "ja" && lang != "ko" && lang != "ar") {
+    usage(argv[0]);
+    return 1;
+  }
+
+  try {
+    const Texts all = read_sentences(data / lang / "wiki-text.txt", lines);
+
+    // Only the model for ``lang`` is loaded; the others stay empty.
+    std::unique_ptr<ChineseTokPosOnnx> zh;
+    std::unique_ptr<JapaneseTokPosOnnx> ja;
+    std::unique_ptr<KoreanTokPosOnnx> ko;
+    std::unique_ptr<ArabicDiacOnnx> ar;
+    Runner runner;
+    if (lang == "zh_hans") {
+      zh = std::make_unique<ChineseTokPosOnnx>(
+          default_chinese_tok_pos_model_dir(data));
+      runner = {[&](const std::string& s) { (void)zh->annotate(s); },
+                [&](const Texts& t) { (void)zh->annotate_batch(t); }};
+    } else if (lang == "ja") {
+      ja = std::make_unique<JapaneseTokPosOnnx>(
+          default_japanese_tok_pos_model_dir(data));
+      runner = {[&](const std::string& s) { (void)ja->annotate(s); },
+                [&](const Texts& t) { (void)ja->annotate_batch(t); }};
+    } else if (lang == "ko") {
+      ko = std::make_unique<KoreanTokPosOnnx>(
+          default_korean_tok_pos_model_dir(data));
+      runner = {[&](const std::string& s) { (void)ko->annotate(s); },
+                [&](const Texts& t) { (void)ko->annotate_batch(t); }};
+    } else {
+      ar = std::make_unique<ArabicDiacOnnx>(data / "ar_msa" /
+                                            "arabertv02_tashkeel_fadel_onnx");
+      runner = {[&](const std::string& s) { (void)ar->diacritize(s); },
+                [&](const Texts& t) { (void)ar->diacritize_batch(t); }};
+    }
+    // One untimed pass, which also warms up the session. Sentences the
+    // tokenizer rejects (as the reference tests skip them) are left out.
+    Texts sentences;
+    for (const std::string& s : all) {
+      try {
+        runner.one(s);
+        sentences.push_back(s);
+      } catch (const std::exception&) {
+      }
+    }
+    if (sentences.empty()) {
+      fprintf(stderr, "tok_pos_batch_benchmark: no sentences\n");
+      return 1;
+    }
+
+    printf("%s: %zu sentences from %zu lines\n", lang.c_str(),
+           sentences.size(), lines);
+    printf("%-16s %12s\n", "mode", "sentences/s");
+    printf("%-16s %12.1f\n", "per sentence",
+           best_sentences_per_second(runner, sentences, 0, runs));
+    for (const size_t batch : {size_t{8}, size_t{32}, size_t{128}}) {
+      const std::string label = "batch " + std::to_string(batch);
+      printf("%-16s %12.1f\n", label.c_str(),
+             best_sentences_per_second(runner, sentences, batch, runs));
+    }
+  } catch (const std::exception& e) {
+    fprintf(stderr, "tok_pos_batch_benchmark: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
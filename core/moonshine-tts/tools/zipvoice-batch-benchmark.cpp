@@ -0,0 +1,121 @@
+// Compares ZipVoice real-time factor when an utterance's chunks are sampled
+// one at a time against sampling them as one batch (one fm_decoder call per
+// ODE step and one vocoder call for all chunks), for 1, 4 and 8 chunks.
+//
+// Usage: zipvoice_batch_benchmark [--model-root DIR] [--voice ID] [--runs N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "zipvoice-tts.h"
+
+namespace {
+
+using moonshine_tts::ZipVoiceTTS;
+using moonshine_tts::ZipVoiceTTSOptions;
+
+const char* const kSentences[] = {
+    "The lighthouse keeper climbed the stairs every evening before dark.",
+    "He lit the lamp, wound the clock, and wrote a line in the log.",
+    "Ships passed in the night without ever learning his name.",
+    "Some nights the fog rolled in so thick he could not see the rail.",
+    "On those nights he sounded the horn until the sun came up.",
+    "In spring he painted the door a bright and cheerful shade of blue.",
+    "Gulls nested on the rocks below and argued from dawn until dusk.",
+    "Once a year a supply boat brought flour, lamp oil, and letters.",
+};
+
+/// Appends sentences until ``tts`` splits the text into ``chunks`` chunks.
+std::string text_with_chunks(ZipVoiceTTS& tts, size_t chunks) {
+  std::string text;
+  for (size_t i = 0;; ++i) {
+    const std::string next =
+        text + (text.empty() ? "" : " ") +
+        kSentences[i % (sizeof(kSentences) / sizeof(kSentences[0]))];
+    if (tts.count_chunks(next) > chunks) {
+      return text;
+    }
+    text = next;
+  }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/// Best real-time factor (compute seconds per audio second) over ``runs``.
+double best_rtf(ZipVoiceTTS& tts, const std::string& text, int runs) {
+  double best = 0.0;
+  for (int r = 0; r < runs; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<float> wav = tts.synthesize(text);
+    const double elapsed = seconds_since(start);
+    const double audio = static_cast<double>(wav.size()) /
+                         static_cast<double>(ZipVoiceTTS::kSampleRateHz);
+    if (audio <= 0.0) {
+      return 0.0;
+    }
+    best = r == 0 ? elapsed / audio : std::min(best, elapsed / audio);
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::filesystem::path model_root = std::filesystem::current_path();
+  std::string voice = "american_female";
+  int runs = 2;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--model-root" && i + 1 < argc) {
+      model_root = argv[++i];
+    } else if (a == "--voice" && i + 1 < argc) {
+      voice = argv[++i];
+    } else if (a == "--runs" && i + 1 < argc) {
+      runs = std::max(1, atoi(argv[++i]));
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--model-root DIR] [--voice ID] [--runs N]\n",
+              argv[0]);
+      return a == "-h" || a == "--help" ? 0 : 1;
+    }
+  }
+
+  try {
+    ZipVoiceTTSOptions opt;
+    opt.g2p_options.g2p_root = model_root;
+    opt.voice_id = voice;
+    // Isolate batching from the G2P / vocoder pipeline.
+    opt.pipeline_synthesis = false;
+    opt.max_batch_chunks = 1;
+    ZipVoiceTTS serial(opt);
+    opt.max_batch_chunks = 8;
+    ZipVoiceTTS batched(opt);
+    (void)serial.synthesize("Warm up.");
+    (void)batched.synthesize("Warm up.");
+
+    printf("%-8s %12s %12s %10s\n", "chunks", "serial RTF", "batched RTF",
+           "speedup");
+    for (const size_t chunks : {size_t{1}, size_t{4}, size_t{8}}) {
+      const std::string text = text_with_chunks(serial, chunks);
+      const double serial_rtf = best_rtf(serial, text, runs);
+      const double batched_rtf = best_rtf(batched, text, runs);
+      printf("%-8zu %12.3f %12.3f %9.2fx\n", serial.count_chunks(text),
+             serial_rtf, batched_rtf,
+             batched_rtf > 0.0 ? serial_rtf / batched_rtf : 0.0);
+    }
+  } catch (const std::exception& e) {
+    fprintf(stderr, "zipvoice_batch_benchmark: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
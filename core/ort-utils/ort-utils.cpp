@@ -1,5 +1,6 @@
 #include "ort-utils.h"
 
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
@@ -253,12 +254,21 @@ ONNXTensorElementDataType ort_get_value_type(const OrtApi *ort_api,
   return type;
 }
 
+namespace {
+std::atomic<uint64_t> g_ort_run_count{0};
+}  // namespace
+
+uint64_t ort_run_count() {
+  return g_ort_run_count.load(std::memory_order_relaxed);
+}
+
 OrtStatus *ort_run(const OrtApi *ort_api, OrtSession *session,
                    const char *const *input_names,
                    const OrtValue *const *inputs, size_t input_len,
                    const char *const *output_names, size_t output_names_len,
                    OrtValue **outputs, const char *session_name,
                    bool log_ort_run) {
+  g_ort_run_count.fetch_add(1, std::memory_order_relaxed);
   if (!log_ort_run) {
     return ort_api->Run(session, nullptr, input_names, inputs, input_len,
                         output_names, output_names_len, outputs);
@@ -286,4 +296,22 @@ OrtStatus *ort_run(const OrtApi *ort_api, OrtSession *session,
     LOGF("%s", ss.str().c_str());
   }
   return status;
-}
\ No newline at end of file
+}
+
+OrtStatus *ort_run_with_binding(const OrtApi *ort_api, OrtSession *session,
+                                const OrtIoBinding *binding,
+                                const char *session_name, bool log_ort_run) {
+  g_ort_run_count.fetch_add(1, std::memory_order_relaxed);
+  if (!log_ort_run) {
+    return ort_api->RunWithBinding(session, nullptr, binding);
+  }
+  std::chrono::steady_clock::time_point start_time =
+      std::chrono::steady_clock::now();
+  OrtStatus *status = ort_api->RunWithBinding(session, nullptr, binding);
+  std::chrono::steady_clock::time_point end_time =
+      std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::milli> duration = end_time - start_time;
+  LOGF("ORT Run %s took %.2f ms (bound inputs)", session_name,
+       duration.count());
+  return status;
+}
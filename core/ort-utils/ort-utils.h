@@ -3,6 +3,7 @@
 
 #include <filesystem>
 #include <string>
+#include <utility>
 #include <vector>
 
 #if defined(ANDROID)
@@ -37,6 +38,20 @@ struct OrtExecutionProviderOptions {
     }                                                          \
   } while (0);
 
+// Runs a cleanup on every way out of a scope, including the early returns of
+// RETURN_ON_ERROR and RETURN_ON_ORT_ERROR.
+template <typename Cleanup>
+class ScopeExit {
+ public:
+  explicit ScopeExit(Cleanup cleanup) : cleanup(std::move(cleanup)) {}
+  ~ScopeExit() { cleanup(); }
+  ScopeExit(const ScopeExit &) = delete;
+  ScopeExit &operator=(const ScopeExit &) = delete;
+
+ private:
+  Cleanup cleanup;
+};
+
 // Creates an OrtEnv. On the multithreaded WebAssembly build ORT defaults
 // SessionOptions::use_per_session_threads to false (see ORT's
 // core/framework/session_options.h), so every session then requires the env to
@@ -102,6 +117,21 @@ OrtStatus *ort_run(const OrtApi *ort_api, OrtSession *session,
                    OrtValue **outputs, const char *session_name,
                    bool log_ort_run);
 
+#define ORT_RUN_WITH_BINDING(ort_api, session, binding) \
+  ort_run_with_binding(ort_api, session, binding, #session, this->log_ort_run)
+
+// Like ort_run, for a run whose inputs and outputs are bound to preallocated
+// buffers through an OrtIoBinding.
+OrtStatus *ort_run_with_binding(const OrtApi *ort_api, OrtSession *session,
+                                const OrtIoBinding *binding,
+                                const char *session_name, bool log_ort_run);
+
+// Process-wide count of inference calls made through ort_run and
+// ort_run_with_binding (and so through ORT_RUN and ORT_RUN_WITH_BINDING).
+// Tests use the difference between two readings to check how much model work
+// a sequence of calls cost, independent of wall-clock noise.
+uint64_t ort_run_count();
+
 // Reliability-only escape hatch: when the MOONSHINE_ORT_SINGLE_THREAD
 // environment variable is set to a non-empty value other than "0", force this
 // session to run entirely on the calling thread (intra-op = inter-op = 1,
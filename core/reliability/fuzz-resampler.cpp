@@ -4,10 +4,16 @@
 // Sample rates are clamped to a finite, realistic range so the fuzzer exercises
 // the resampling arithmetic (interpolation, indexing, boundary handling) rather
 // than merely triggering an out-of-memory from an absurd output size.
+//
+// The same input is also run through StreamingResampler at the rates rounded
+// to whole hertz, once in a single call and once split at fuzzer-chosen
+// points, and the two outputs must match exactly.
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <vector>
 
@@ -27,6 +33,35 @@ float sane_rate(float rate) {
   }
   return rate;
 }
+
+// Keeps the streaming check to outputs that fit comfortably in memory.
+constexpr double kMaxStreamingOutputSamples = 1 << 22;
+
+std::vector<float> resample_in_chunks(int32_t input_rate, int32_t output_rate,
+                                      const std::vector<float> &audio,
+                                      const uint8_t *split_bytes,
+                                      size_t split_byte_count) {
+  StreamingResampler resampler(input_rate, output_rate);
+  std::vector<float> output;
+  size_t offset = 0;
+  for (size_t i = 0; offset < audio.size(); i++) {
+    // Chunk sizes come from the sample bytes themselves, so they vary with
+    // the input; with no bytes to draw on the whole input is one chunk.
+    // Even-numbered chunks may be empty, which process() must also handle,
+    // and odd-numbered ones always make progress.
+    const size_t chunk_size =
+        split_byte_count > 0
+            ? std::min<size_t>(split_bytes[i % split_byte_count] + (i & 1),
+                               audio.size() - offset)
+            : audio.size() - offset;
+    resampler.process(audio.data() + offset, chunk_size, &output);
+    offset += chunk_size;
+  }
+  std::vector<float> tail(resampler.max_output_size(0));
+  tail.resize(resampler.flush(tail.data()));
+  output.insert(output.end(), tail.begin(), tail.end());
+  return output;
+}
 }  // namespace
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
@@ -48,5 +83,25 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
   }
 
   resample_audio(audio, input_rate, output_rate);
+
+  const int32_t streaming_input_rate = static_cast<int32_t>(input_rate);
+  const int32_t streaming_output_rate = static_cast<int32_t>(output_rate);
+  if (static_cast<double>(num_samples) * streaming_output_rate /
+          streaming_input_rate >
+      kMaxStreamingOutputSamples) {
+    return 0;
+  }
+  const std::vector<float> one_shot = resample_in_chunks(
+      streaming_input_rate, streaming_output_rate, audio, nullptr, 0);
+  const std::vector<float> chunked =
+      resample_in_chunks(streaming_input_rate, streaming_output_rate, audio,
+                         data + 8, size - 8);
+  // Compare bit patterns, so NaN inputs that come out as NaN still match.
+  if (one_shot.size() != chunked.size() ||
+      (!one_shot.empty() &&
+       std::memcmp(one_shot.data(), chunked.data(),
+                   one_shot.size() * sizeof(float)) != 0)) {
+    abort();
+  }
   return 0;
 }
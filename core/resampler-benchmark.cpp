@@ -0,0 +1,82 @@
+// Measures resampling throughput in input samples per second, for the
+// one-shot resample_audio() and for StreamingResampler fed in the chunk
+// sizes a capture callback typically delivers.
+//
+// Usage: resampler-benchmark [seconds_of_audio] [chunk_ms]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "resampler.h"
+
+namespace {
+std::vector<float> make_test_audio(int32_t sample_rate, double seconds) {
+  std::vector<float> audio(static_cast<size_t>(sample_rate * seconds));
+  uint32_t noise = 1;
+  for (size_t i = 0; i < audio.size(); i++) {
+    noise = noise * 1664525u + 1013904223u;
+    const float white = static_cast<float>(noise >> 8) / (1 << 24) - 0.5f;
+    audio[i] = 0.5f * std::sin(0.05f * i) + 0.1f * white;
+  }
+  return audio;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  double audio_seconds = 60.0;
+  double chunk_ms = 10.0;
+  if (argc > 1) audio_seconds = atof(argv[1]);
+  if (argc > 2) chunk_ms = atof(argv[2]);
+
+  const int32_t rates[][2] = {
+      {48000, 16000}, {44100, 16000}, {22050, 16000}, {8000, 16000}};
+  printf("%.0fs of audio per rate, %.0f ms chunks\n\n", audio_seconds,
+         chunk_ms);
+  printf("%-16s %18s %18s %18s\n", "rates", "one-shot Msamp/s",
+         "streaming Msamp/s", "x realtime");
+  for (const auto &rate : rates) {
+    const int32_t input_rate = rate[0];
+    const int32_t output_rate = rate[1];
+    const std::vector<float> audio =
+        make_test_audio(input_rate, audio_seconds);
+
+    auto start = std::chrono::steady_clock::now();
+    const std::vector<float> one_shot =
+        resample_audio(audio, input_rate, output_rate);
+    const double one_shot_seconds = seconds_since(start);
+
+    const size_t chunk_size =
+        std::max<size_t>(1, static_cast<size_t>(input_rate * chunk_ms / 1000));
+    StreamingResampler resampler(input_rate, output_rate);
+    std::vector<float> output(resampler.max_output_size(chunk_size));
+    size_t output_count = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < audio.size(); i += chunk_size) {
+      const size_t size = std::min(chunk_size, audio.size() - i);
+      output_count +=
+          resampler.process(audio.data() + i, size, output.data());
+    }
+    const double streaming_seconds = seconds_since(start);
+
+    char label[32];
+    snprintf(label, sizeof(label), "%d->%d", input_rate, output_rate);
+    printf("%-16s %18.1f %18.1f %18.0f\n", label,
+           audio.size() / one_shot_seconds / 1e6,
+           audio.size() / streaming_seconds / 1e6,
+           audio_seconds / streaming_seconds);
+    if (one_shot.empty() || output_count == 0) {
+      fprintf(stderr, "No output for %s\n", label);
+      return 1;
+    }
+  }
+  return 0;
+}
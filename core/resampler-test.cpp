@@ -1,7 +1,9 @@
 #include "resampler.h"
 
+#include <cmath>
 #include <filesystem>
 #include <numeric>
+#include <random>
 #include <string>
 
 #include "debug-utils.h"
@@ -39,6 +41,64 @@ void test_resample_audio(const std::vector<float> &input_audio,
   LOGF("Original mean: %f, Resampled mean: %f", original_mean, resampled_mean);
   REQUIRE(original_mean == doctest::Approx(resampled_mean).epsilon(0.001f));
 }
+
+// Resamples ``input_audio`` in one call and then again in random-sized
+// chunks, and requires the two outputs to be identical.
+std::vector<float> test_streaming_resampler(
+    const std::vector<float> &input_audio, int32_t input_sample_rate,
+    int32_t output_sample_rate) {
+  StreamingResampler one_shot(input_sample_rate, output_sample_rate);
+  std::vector<float> expected;
+  one_shot.process(input_audio.data(), input_audio.size(), &expected);
+  std::vector<float> tail(one_shot.max_output_size(0));
+  tail.resize(one_shot.flush(tail.data()));
+  expected.insert(expected.end(), tail.begin(), tail.end());
+  const size_t expected_size = static_cast<size_t>(std::ceil(
+      static_cast<double>(input_audio.size()) * output_sample_rate /
+      input_sample_rate));
+  REQUIRE(expected.size() == expected_size);
+
+  std::mt19937 rng(input_sample_rate ^ output_sample_rate);
+  std::uniform_int_distribution<size_t> chunk_size_distribution(0, 2000);
+  StreamingResampler chunked(input_sample_rate, output_sample_rate);
+  std::vector<float> actual;
+  for (size_t i = 0; i < input_audio.size();) {
+    const size_t chunk_size =
+        std::min(chunk_size_distribution(rng), input_audio.size() - i);
+    const size_t capacity = chunked.max_output_size(chunk_size);
+    const size_t previous_size = actual.size();
+    actual.resize(previous_size + capacity);
+    const size_t written = chunked.process(
+        input_audio.data() + i, chunk_size, actual.data() + previous_size);
+    REQUIRE(written <= capacity);
+    actual.resize(previous_size + written);
+    i += chunk_size;
+  }
+  tail.assign(chunked.max_output_size(0), 0.0f);
+  tail.resize(chunked.flush(tail.data()));
+  actual.insert(actual.end(), tail.begin(), tail.end());
+  REQUIRE(actual == expected);
+  return expected;
+}
+
+float tone_rms(float frequency, int32_t input_sample_rate,
+               int32_t output_sample_rate) {
+  std::vector<float> tone(input_sample_rate);
+  for (size_t i = 0; i < tone.size(); i++) {
+    tone[i] = std::sin(2.0 * 3.14159265358979323846 * frequency * i /
+                       input_sample_rate);
+  }
+  StreamingResampler resampler(input_sample_rate, output_sample_rate);
+  std::vector<float> resampled;
+  resampler.process(tone.data(), tone.size(), &resampled);
+  // Skip the edges, where the filter sees the zeros before the stream.
+  const size_t edge = resampled.size() / 10;
+  double sum = 0.0;
+  for (size_t i = edge; i < resampled.size() - edge; i++) {
+    sum += resampled[i] * resampled[i];
+  }
+  return static_cast<float>(std::sqrt(sum / (resampled.size() - 2 * edge)));
+}
 }  // namespace
 
 TEST_CASE("resampler-test") {
@@ -59,4 +119,41 @@ TEST_CASE("resampler-test") {
     LOG("Upsampling to 96000 Hz");
     test_resample_audio(wav_data_vector, wav_sample_rate, 96000);
   }
+  SUBCASE("streaming-resampler") {
+    std::string wav_path = "two_cities.wav";
+    REQUIRE(std::filesystem::exists(wav_path));
+    float *wav_data = nullptr;
+    size_t wav_data_size = 0;
+    int32_t wav_sample_rate = 0;
+    REQUIRE(load_wav_data(wav_path.c_str(), &wav_data, &wav_data_size,
+                          &wav_sample_rate));
+    const std::vector<float> wav_data_vector(wav_data,
+                                             wav_data + wav_data_size);
+    for (int32_t output_sample_rate : {16000, 44100, 48000, 22050, 8000}) {
+      LOGF("Streaming %d Hz to %d Hz", wav_sample_rate, output_sample_rate);
+      test_streaming_resampler(wav_data_vector, wav_sample_rate,
+                               output_sample_rate);
+    }
+    // The usual capture rates, brought down to the transcriber's rate.
+    const std::vector<float> at_48k =
+        test_streaming_resampler(wav_data_vector, wav_sample_rate, 48000);
+    const std::vector<float> at_44k =
+        test_streaming_resampler(wav_data_vector, wav_sample_rate, 44100);
+    test_streaming_resampler(at_48k, 48000, 16000);
+    test_streaming_resampler(at_44k, 44100, 16000);
+
+    // Equal rates pass the audio through untouched.
+    REQUIRE(test_streaming_resampler(wav_data_vector, wav_sample_rate,
+                                     wav_sample_rate) == wav_data_vector);
+  }
+  SUBCASE("streaming-resampler-anti-aliasing") {
+    // A tone well inside the output band keeps its level, and one above the
+    // output's Nyquist rate is filtered out rather than folded back down.
+    CHECK(tone_rms(1000.0f, 48000, 16000) ==
+          doctest::Approx(std::sqrt(0.5f)).epsilon(0.01f));
+    CHECK(tone_rms(12000.0f, 48000, 16000) < 0.001f);
+    CHECK(tone_rms(11025.0f, 44100, 16000) < 0.001f);
+    CHECK(tone_rms(1000.0f, 16000, 44100) ==
+          doctest::Approx(std::sqrt(0.5f)).epsilon(0.01f));
+  }
 }
@@ -1,7 +1,57 @@
 #include "resampler.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
 #include "debug-utils.h"
 
+namespace {
+// Filter design for StreamingResampler. The cutoff sits a little below the
+// lower Nyquist rate, and the sinc is kept out to kZeroCrossings zero
+// crossings either side, which with this Kaiser window gives roughly 80 dB
+// of stopband rejection.
+constexpr double kRolloff = 0.945;
+constexpr double kZeroCrossings = 16.0;
+constexpr double kKaiserBeta = 8.0;
+// Bounds on the bank for extreme ratios, where exactness matters less than
+// not spending seconds and megabytes building the filter. Filters keep their
+// full length down to 1/12 of the input rate (192 kHz to 16 kHz).
+constexpr int64_t kMaxHalfTaps = 256;
+constexpr int64_t kMaxBankPhases = 1024;
+constexpr int64_t kTapAlignment = 8;
+constexpr double kPi = 3.14159265358979323846;
+
+// Zeroth-order modified Bessel function of the first kind.
+double bessel_i0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  const double quarter_x_squared = x * x / 4.0;
+  for (int k = 1; term > sum * 1e-12; k++) {
+    term *= quarter_x_squared / (static_cast<double>(k) * k);
+    sum += term;
+  }
+  return sum;
+}
+
+// ``count`` is a multiple of kTapAlignment. The eight independent partial
+// sums let the compiler turn the loop into vector multiply-adds without
+// reordering any single sum, so results don't depend on how it vectorizes.
+float dot_product(const float *x, const float *h, int64_t count) {
+  float sums[kTapAlignment] = {};
+  for (int64_t k = 0; k < count; k += kTapAlignment) {
+    for (int64_t j = 0; j < kTapAlignment; j++) {
+      sums[j] += x[k + j] * h[k + j];
+    }
+  }
+  return ((sums[0] + sums[4]) + (sums[1] + sums[5])) +
+         ((sums[2] + sums[6]) + (sums[3] + sums[7]));
+}
+}  // namespace
+
 const std::vector<float> resample_audio(const std::vector<float> &audio,
                                         float input_sample_rate,
                                         float output_sample_rate) {
@@ -84,4 +134,158 @@ const std::vector<float> upsample_audio(const std::vector<float> &audio,
   }
 
   return output_audio;
-}
\ No newline at end of file
+}
+
+StreamingResampler::StreamingResampler(int32_t input_sample_rate,
+                                       int32_t output_sample_rate)
+    : input_rate(input_sample_rate), output_rate(output_sample_rate) {
+  if (input_sample_rate <= 0 || output_sample_rate <= 0) {
+    throw std::runtime_error("StreamingResampler: invalid sample rates " +
+                             std::to_string(input_sample_rate) + " -> " +
+                             std::to_string(output_sample_rate));
+  }
+  passthrough = (input_sample_rate == output_sample_rate);
+  const int64_t divisor = std::gcd(input_sample_rate, output_sample_rate);
+  phase_count = output_sample_rate / divisor;
+  step = input_sample_rate / divisor;
+
+  const double cutoff =
+      kRolloff * std::min(1.0, static_cast<double>(output_sample_rate) /
+                                   input_sample_rate);
+  half_taps = std::min(
+      kMaxHalfTaps, static_cast<int64_t>(std::ceil(kZeroCrossings / cutoff)));
+  taps = (2 * half_taps + kTapAlignment - 1) / kTapAlignment * kTapAlignment;
+  bank_phase_count = std::min(phase_count, kMaxBankPhases);
+  if (!passthrough) {
+    filter_bank.assign(bank_phase_count * taps, 0.0f);
+    const double window_norm = bessel_i0(kKaiserBeta);
+    std::vector<double> phase_taps(2 * half_taps);
+    for (int64_t phase = 0; phase < bank_phase_count; phase++) {
+      // Tap k reads input position base + k, where base is
+      // half_taps - 1 samples before the output's integer position.
+      const double fraction = static_cast<double>(phase) / bank_phase_count;
+      double sum = 0.0;
+      for (int64_t k = 0; k < 2 * half_taps; k++) {
+        const double t = static_cast<double>(k - (half_taps - 1)) - fraction;
+        const double u = t / half_taps;
+        const double window =
+            std::fabs(u) < 1.0
+                ? bessel_i0(kKaiserBeta * std::sqrt(1.0 - u * u)) / window_norm
+                : 0.0;
+        const double x = kPi * cutoff * t;
+        const double sinc = (t == 0.0) ? 1.0 : std::sin(x) / x;
+        phase_taps[k] = cutoff * sinc * window;
+        sum += phase_taps[k];
+      }
+      // Unity gain at DC for every phase, so silence and offsets stay put.
+      float *row = filter_bank.data() + phase * taps;
+      for (int64_t k = 0; k < 2 * half_taps; k++) {
+        row[k] = static_cast<float>(phase_taps[k] / sum);
+      }
+    }
+  }
+  reset();
+}
+
+size_t StreamingResampler::max_output_size(size_t input_size) const {
+  if (passthrough) {
+    return input_size;
+  }
+  const int64_t pending =
+      input_count + static_cast<int64_t>(input_size) - next_index;
+  if (pending <= 0) {
+    return 0;
+  }
+  return static_cast<size_t>((pending * phase_count + step - 1) / step);
+}
+
+size_t StreamingResampler::process(const float *input, size_t input_size,
+                                   float *output) {
+  if (passthrough) {
+    if (input_size > 0) {
+      std::memcpy(output, input, input_size * sizeof(float));
+    }
+    return input_size;
+  }
+  append_input(input, input_size);
+  size_t written = 0;
+  while (next_index - half_taps + taps < input_count) {
+    output[written++] = next_output();
+  }
+  drop_used_input();
+  return written;
+}
+
+void StreamingResampler::process(const float *input, size_t input_size,
+                                 std::vector<float> *output) {
+  const size_t previous_size = output->size();
+  output->resize(previous_size + max_output_size(input_size));
+  const size_t written =
+      process(input, input_size, output->data() + previous_size);
+  output->resize(previous_size + written);
+}
+
+size_t StreamingResampler::flush(float *output) {
+  if (passthrough) {
+    return 0;
+  }
+  const int64_t input_end = input_count;
+  size_t written = 0;
+  while (next_index < input_end) {
+    const int64_t missing = next_index - half_taps + taps + 1 - input_count;
+    if (missing > 0) {
+      append_input(nullptr, static_cast<size_t>(missing));
+    }
+    output[written++] = next_output();
+    drop_used_input();
+  }
+  reset();
+  return written;
+}
+
+void StreamingResampler::reset() {
+  history.assign(half_taps - 1, 0.0f);
+  history_start = -(half_taps - 1);
+  input_count = 0;
+  next_index = 0;
+  next_phase = 0;
+}
+
+void StreamingResampler::append_input(const float *input, size_t count) {
+  // After a stride longer than the filter, the next output may not need the
+  // start of this input at all.
+  const int64_t end = input_count + static_cast<int64_t>(count);
+  const int64_t first = std::max(input_count, history_start);
+  if (first < end) {
+    const size_t skip = static_cast<size_t>(first - input_count);
+    if (input != nullptr) {
+      history.insert(history.end(), input + skip, input + count);
+    } else {
+      history.insert(history.end(), count - skip, 0.0f);
+    }
+  }
+  input_count = end;
+}
+
+float StreamingResampler::next_output() {
+  const int64_t base = next_index - half_taps + 1;
+  const int64_t bank_phase = next_phase * bank_phase_count / phase_count;
+  const float value =
+      dot_product(history.data() + (base - history_start),
+                  filter_bank.data() + bank_phase * taps, taps);
+  next_phase += step;
+  next_index += next_phase / phase_count;
+  next_phase %= phase_count;
+  return value;
+}
+
+void StreamingResampler::drop_used_input() {
+  const int64_t keep_from = next_index - half_taps + 1;
+  if (keep_from <= history_start) {
+    return;
+  }
+  const int64_t drop = std::min(keep_from - history_start,
+                                static_cast<int64_t>(history.size()));
+  history.erase(history.begin(), history.begin() + drop);
+  history_start = keep_from;
+}
@@ -1,6 +1,9 @@
 #ifndef RESAMPLER_H
 #define RESAMPLER_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <vector>
 
 const std::vector<float> resample_audio(const std::vector<float> &audio,
@@ -14,4 +17,80 @@ const std::vector<float> downsample_audio(const std::vector<float> &audio,
 const std::vector<float> upsample_audio(const std::vector<float> &audio,
                                         float input_sample_rate,
                                         float output_sample_rate);
+
+// Band-limited sample rate conversion for audio that arrives in chunks.
+//
+// The ratio is reduced to L/M and a Kaiser-windowed sinc low-pass is sampled
+// once per output phase when the resampler is created, with its cutoff below
+// the lower of the two Nyquist rates so downsampling doesn't alias. Input
+// that a filter still needs is kept between calls, so every output sample is
+// computed from the same input samples and taps however the audio was split
+// up: feeding a stream in chunks gives bit-for-bit the same output as feeding
+// it at once.
+//
+// Output lags the input by half the filter length (about a millisecond);
+// flush() produces the rest at the end of a stream. Equal rates copy the
+// input through unchanged.
+class StreamingResampler {
+ public:
+  // Throws std::runtime_error unless both rates are positive.
+  StreamingResampler(int32_t input_sample_rate, int32_t output_sample_rate);
+
+  int32_t input_sample_rate() const { return input_rate; }
+  int32_t output_sample_rate() const { return output_rate; }
+
+  // Most samples process() can write for ``input_size`` more input samples,
+  // or flush() can write with ``input_size`` of zero.
+  size_t max_output_size(size_t input_size) const;
+
+  // Resamples ``input_size`` more samples into ``output``, which needs room
+  // for max_output_size(input_size) floats. Returns the number written.
+  size_t process(const float *input, size_t input_size, float *output);
+
+  // Appends the resampled samples to ``output``.
+  void process(const float *input, size_t input_size,
+               std::vector<float> *output);
+
+  // Writes the output still held back by the filter delay, treating the
+  // input as ending here, and resets for a new stream. ``output`` needs room
+  // for max_output_size(0) floats. Returns the number written.
+  size_t flush(float *output);
+
+  // Forgets all input, ready for a new stream.
+  void reset();
+
+ private:
+  // Appends ``count`` input samples (zeros if ``input`` is null), skipping
+  // any the next output no longer needs.
+  void append_input(const float *input, size_t count);
+  // Computes the next output sample. Its input must all be in history.
+  float next_output();
+  void drop_used_input();
+
+  int32_t input_rate;
+  int32_t output_rate;
+  bool passthrough;
+  // Output sample n sits at input position n * step / phase_count.
+  int64_t phase_count;
+  int64_t step;
+  // Filter taps either side of the output position, and the per-phase
+  // stride of filter_bank (2 * half_taps, rounded up to a multiple of 8 so
+  // the dot product needs no remainder loop).
+  int64_t half_taps;
+  int64_t taps;
+  // Phases actually tabulated. Ratios with a huge L share the nearest of at
+  // most kMaxBankPhases (1024) phases.
+  int64_t bank_phase_count;
+  std::vector<float> filter_bank;
+
+  // Input samples [history_start, input_count), in stream positions, with
+  // the samples before the stream counted as zeros.
+  std::vector<float> history;
+  int64_t history_start;
+  int64_t input_count;
+  // Integer and fractional (in 1/phase_count units) input position of the
+  // next output sample.
+  int64_t next_index;
+  int64_t next_phase;
+};
 #endif
\ No newline at end of file
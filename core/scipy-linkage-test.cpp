@@ -0,0 +1,110 @@
+#include "scipy_linkage.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest.h>
+
+using namespace cppannote::scipy_linkage;
+
+namespace {
+
+// Runs both linkages on ``dist`` and requires identical bits in ``Z``,
+// including the order of tied merges.
+void check_matches_naive(const std::vector<double> &dist, int n) {
+  CAPTURE(n);
+  std::vector<double> expected;
+  linkage_centroid_naive(dist, n, expected);
+  std::vector<double> actual;
+  linkage_centroid(dist, n, actual);
+  REQUIRE(actual.size() == expected.size());
+  REQUIRE(actual.size() == static_cast<size_t>(n > 0 ? n - 1 : 0) * 4);
+  for (size_t i = 0; i < actual.size(); ++i) {
+    if (std::memcmp(&actual[i], &expected[i], sizeof(double)) != 0) {
+      CAPTURE(i);
+      CHECK(actual[i] == expected[i]);
+      return;
+    }
+  }
+}
+
+std::vector<double> random_points(int n, int d, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::vector<double> points(static_cast<size_t>(n) * d);
+  for (double &value : points) {
+    value = normal(rng);
+  }
+  return points;
+}
+
+}  // namespace
+
+TEST_CASE("centroid-linkage-matches-naive-on-random-points") {
+  for (const int n : {1, 2, 3, 4, 7, 16, 50, 129, 300}) {
+    for (uint32_t seed = 1; seed <= 3; ++seed) {
+      const int d = 8;
+      std::vector<double> dist;
+      pdist_euclidean(random_points(n, d, seed * 7919 + n), n, d, dist);
+      check_matches_naive(dist, n);
+    }
+  }
+}
+
+TEST_CASE("centroid-linkage-matches-naive-on-ties") {
+  SUBCASE("integer grid") {
+    // Many pairs at exactly the same distance, and centroids that land on
+    // each other as clusters merge.
+    const int side = 9;
+    const int n = side * side;
+    std::vector<double> points;
+    for (int y = 0; y < side; ++y) {
+      for (int x = 0; x < side; ++x) {
+        points.push_back(x);
+        points.push_back(y);
+      }
+    }
+    std::vector<double> dist;
+    pdist_euclidean(points, n, 2, dist);
+    check_matches_naive(dist, n);
+  }
+  SUBCASE("duplicate points") {
+    // Groups of identical rows give zero distances, as repeated embeddings
+    // of the same audio do.
+    const int n = 60;
+    std::vector<double> points;
+    for (int i = 0; i < n; ++i) {
+      const int group = i % 6;
+      points.push_back(group);
+      points.push_back(group * group % 5);
+      points.push_back(0.5);
+    }
+    std::vector<double> dist;
+    pdist_euclidean(points, n, 3, dist);
+    check_matches_naive(dist, n);
+  }
+  SUBCASE("all points identical") {
+    const int n = 25;
+    const std::vector<double> points(static_cast<size_t>(n) * 4, 1.0);
+    std::vector<double> dist;
+    pdist_euclidean(points, n, 4, dist);
+    check_matches_naive(dist, n);
+  }
+  SUBCASE("few distinct distances") {
+    // A condensed matrix drawn from three values, so nearly every scan sees
+    // a tie.
+    for (uint32_t seed = 1; seed <= 5; ++seed) {
+      const int n = 40;
+      std::mt19937 rng(seed);
+      std::uniform_int_distribution<int> value(1, 3);
+      std::vector<double> dist(static_cast<size_t>(n) * (n - 1) / 2);
+      for (double &d : dist) {
+        d = value(rng);
+      }
+      check_matches_naive(dist, n);
+    }
+  }
+}
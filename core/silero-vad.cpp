@@ -43,11 +43,7 @@ SileroVad::SileroVad(int sample_rate, int windows_frame_size, float threshold,
       windows_frame_size * sr_per_ms;  // e.g., 32ms * 16 = 512 samples
   effective_window_size =
       window_size_samples + context_samples;  // 512 + 64 = 576 samples
-  input_node_dims[0] = 1;
-  input_node_dims[1] = effective_window_size;
-  _state.resize(size_state);
-  _context.resize(context_samples, 0.0f);  // Initialize context to zeros
-  sr = sample_rate;                        // scalar
+  sr = sample_rate;  // scalar
   min_speech_samples = sr_per_ms * min_speech_duration_ms;
   max_speech_samples = (sample_rate * max_speech_duration_s -
                         window_size_samples - 2 * speech_pad_samples);
@@ -75,99 +71,114 @@ SileroVad::~SileroVad() {
 // Inference: runs inference on one chunk of input data.
 // data_chunk is expected to have window_size_samples samples (e.g., 512 for
 // 16kHz).
-void SileroVad::predict(const std::vector<float> &data_chunk,
+void SileroVad::predict(SileroVadState *state, const float *data_chunk,
                         float *out_probability, int *out_flag) {
-  // Build input by prepending context (64 samples) to data_chunk (512 samples)
-  // = 576 total
-  input.resize(effective_window_size);
-  std::copy(_context.begin(), _context.end(), input.begin());
-  std::copy(data_chunk.begin(), data_chunk.end(),
-            input.begin() + context_samples);
+  float speech_prob = 0.0f;
+  if (predict_batch(&state, &data_chunk, &speech_prob, 1) != 0) {
+    return;
+  }
+  // Set output values
+  if (out_probability) *out_probability = speech_prob;
+  if (out_flag) *out_flag = (speech_prob >= threshold) ? 1 : 0;
+}
+
+int SileroVad::predict_batch(SileroVadState *const *states,
+                             const float *const *data_chunks,
+                             float *out_probabilities, int batch_size) {
+  if (batch_size <= 0) {
+    return 0;
+  }
+  const int state_size = SileroVadState::state_size;
+  const size_t batch = static_cast<size_t>(batch_size);
+
+  // Scratch inputs, reused across calls. They are per thread rather than
+  // members because detectors on different threads share this model without
+  // a lock.
+  thread_local std::vector<float> input;
+  thread_local std::vector<float> state_input;
+
+  // Build each row's input by prepending its context (64 samples) to its
+  // chunk (512 samples) = 576 total.
+  input.resize(batch * effective_window_size);
+  for (size_t b = 0; b < batch; ++b) {
+    float *row = input.data() + b * effective_window_size;
+    std::copy(states[b]->context.begin(), states[b]->context.end(), row);
+    std::copy(data_chunks[b], data_chunks[b] + window_size_samples,
+              row + context_samples);
+  }
+  // The state tensor is [2, batch, 128], so each stream's two state rows are
+  // interleaved with the other streams'.
+  state_input.resize(SileroVadState::state_rows * batch * state_size);
+  for (int r = 0; r < SileroVadState::state_rows; ++r) {
+    for (size_t b = 0; b < batch; ++b) {
+      const float *src = states[b]->state.data() + r * state_size;
+      std::copy(src, src + state_size,
+                state_input.data() + (r * batch + b) * state_size);
+    }
+  }
+  const int64_t input_node_dims[2] = {batch_size, effective_window_size};
+  const int64_t state_node_dims[3] = {SileroVadState::state_rows, batch_size,
+                                      state_size};
 
-  // Create input tensor
   OrtValue *input_ort = nullptr;
   OrtValue *state_ort = nullptr;
   OrtValue *sr_ort = nullptr;
-
-  OrtStatus *status = nullptr;
-
-  status = ort_api->CreateTensorWithDataAsOrtValue(
+  OrtValue *output_ort[2] = {nullptr, nullptr};
+  auto release_values = [&]() {
+    for (OrtValue *value : {input_ort, state_ort, sr_ort, output_ort[0],
+                            output_ort[1]}) {
+      if (value != nullptr) ort_api->ReleaseValue(value);
+    }
+  };
+
+  OrtStatus *status = ort_api->CreateTensorWithDataAsOrtValue(
       memory_info, input.data(), input.size() * sizeof(float), input_node_dims,
       2, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &input_ort);
-  if (status != nullptr) {
-    const char *msg = ort_api->GetErrorMessage(status);
-    fprintf(stderr, "CreateTensorWithDataAsOrtValue (input) failed: %s\n", msg);
-    ort_api->ReleaseStatus(status);
-    return;
+  if (status == nullptr) {
+    status = ort_api->CreateTensorWithDataAsOrtValue(
+        memory_info, state_input.data(), state_input.size() * sizeof(float),
+        state_node_dims, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &state_ort);
   }
-
-  status = ort_api->CreateTensorWithDataAsOrtValue(
-      memory_info, _state.data(), _state.size() * sizeof(float),
-      state_node_dims, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &state_ort);
-  if (status != nullptr) {
-    const char *msg = ort_api->GetErrorMessage(status);
-    fprintf(stderr, "CreateTensorWithDataAsOrtValue (state) failed: %s\n", msg);
-    ort_api->ReleaseStatus(status);
-    ort_api->ReleaseValue(input_ort);
-    return;
+  if (status == nullptr) {
+    // Scalar tensor for the sample rate (empty shape = scalar). ORT only
+    // reads it, so pointing at the shared member is safe across threads.
+    status = ort_api->CreateTensorWithDataAsOrtValue(
+        memory_info, &sr, sizeof(int64_t), nullptr, 0,
+        ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &sr_ort);
   }
-
-  // Create scalar tensor for sample rate (empty shape = scalar)
-  status = ort_api->CreateTensorWithDataAsOrtValue(
-      memory_info, &sr, sizeof(int64_t), nullptr, 0,
-      ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64, &sr_ort);
-  if (status != nullptr) {
-    const char *msg = ort_api->GetErrorMessage(status);
-    fprintf(stderr, "CreateTensorWithDataAsOrtValue (sr) failed: %s\n", msg);
-    ort_api->ReleaseStatus(status);
-    ort_api->ReleaseValue(input_ort);
-    ort_api->ReleaseValue(state_ort);
-    return;
+  if (status == nullptr) {
+    const OrtValue *ort_inputs[3] = {input_ort, state_ort, sr_ort};
+    status = ort_api->Run(session, nullptr, input_node_names.data(),
+                          ort_inputs, 3, output_node_names.data(),
+                          output_node_names.size(), output_ort);
   }
-
-  ort_inputs.clear();
-  ort_inputs.push_back(input_ort);
-  ort_inputs.push_back(state_ort);
-  ort_inputs.push_back(sr_ort);
-
-  // Prepare output OrtValue* array
-  OrtValue *output_ort[2] = {nullptr, nullptr};
-  status =
-      ort_api->Run(session, nullptr, input_node_names.data(), ort_inputs.data(),
-                   ort_inputs.size(), output_node_names.data(),
-                   output_node_names.size(), output_ort);
-
   if (status != nullptr) {
     const char *msg = ort_api->GetErrorMessage(status);
-    fprintf(stderr, "Run failed: %s\n", msg);
+    fprintf(stderr, "Silero VAD batch of %d failed: %s\n", batch_size, msg);
     ort_api->ReleaseStatus(status);
-    ort_api->ReleaseValue(input_ort);
-    ort_api->ReleaseValue(state_ort);
-    ort_api->ReleaseValue(sr_ort);
-    return;
+    release_values();
+    return 1;
   }
 
   float *speech_prob_ptr = nullptr;
+  float *stateN = nullptr;
   LOG_ORT_ERROR(ort_api, ort_api->GetTensorMutableData(
                              output_ort[0], (void **)&speech_prob_ptr));
-  float speech_prob = speech_prob_ptr[0];
-
-  float *stateN = nullptr;
   LOG_ORT_ERROR(ort_api,
                 ort_api->GetTensorMutableData(output_ort[1], (void **)&stateN));
-  std::memcpy(_state.data(), stateN, size_state * sizeof(float));
-
-  // Update context with last context_samples samples of the full input
-  std::copy(input.end() - context_samples, input.end(), _context.begin());
-
-  // Set output values
-  if (out_probability) *out_probability = speech_prob;
-  if (out_flag) *out_flag = (speech_prob >= threshold) ? 1 : 0;
+  for (size_t b = 0; b < batch; ++b) {
+    out_probabilities[b] = speech_prob_ptr[b];
+    for (int r = 0; r < SileroVadState::state_rows; ++r) {
+      const float *src = stateN + (r * batch + b) * state_size;
+      std::copy(src, src + state_size,
+                states[b]->state.data() + r * state_size);
+    }
+    // Update context with last context_samples samples of the full input
+    const float *row_end =
+        input.data() + (b + 1) * effective_window_size;
+    std::copy(row_end - context_samples, row_end, states[b]->context.begin());
+  }
 
-  // Release OrtValues
-  ort_api->ReleaseValue(input_ort);
-  ort_api->ReleaseValue(state_ort);
-  ort_api->ReleaseValue(sr_ort);
-  ort_api->ReleaseValue(output_ort[0]);
-  ort_api->ReleaseValue(output_ort[1]);
+  release_values();
+  return 0;
 }
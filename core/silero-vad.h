@@ -19,6 +19,23 @@
 
 #include "onnxruntime_c_api.h"
 
+// The recurrent state the model carries from one chunk to the next: the
+// LSTM state and the tail of the previous chunk, which is prepended as
+// context. Each audio stream needs its own.
+struct SileroVadState {
+  static const int state_rows = 2;
+  static const int state_size = 128;
+  static const int context_samples = 64;
+  std::vector<float> state;    // [state_rows, state_size]
+  std::vector<float> context;  // [context_samples]
+
+  SileroVadState() { reset(); }
+  void reset() {
+    state.assign(state_rows * state_size, 0.0f);
+    context.assign(context_samples, 0.0f);
+  }
+};
+
 class SileroVad {
  private:
   // ONNX Runtime C API resources
@@ -31,9 +48,7 @@ class SileroVad {
 
   // ----- Context-related additions -----
   static const int context_samples =
-      64;                       // For 16kHz, 64 samples are added as context.
-  std::vector<float> _context;  // Holds the last 64 samples from the previous
-                                // chunk (initialized to zero).
+      64;  // For 16kHz, 64 samples are added as context.
 
   // Original window size (e.g., 32ms corresponds to 512 samples)
   int window_size_samples;
@@ -43,16 +58,11 @@ class SileroVad {
   // Additional declaration: samples per millisecond
   int sr_per_ms;
 
-  // ONNX Runtime input/output buffers
-  std::vector<OrtValue *> ort_inputs;
+  // ONNX Runtime input/output names. Input buffers are per thread and the
+  // values are built per call, so concurrent predictions only share the
+  // (thread-safe) session.
   std::vector<const char *> input_node_names = {"input", "state", "sr"};
-  std::vector<float> input;
-  unsigned int size_state = 2 * 1 * 128;
-  std::vector<float> _state;
   int64_t sr;  // scalar sample rate
-  int64_t input_node_dims[2] = {};
-  const int64_t state_node_dims[3] = {2, 1, 128};
-  std::vector<OrtValue *> ort_outputs;
   std::vector<const char *> output_node_names = {"output", "stateN"};
 
   // Model configuration parameters
@@ -84,6 +94,20 @@ class SileroVad {
 
   bool is_loaded() const { return session != nullptr; }
 
-  void predict(const std::vector<float> &data_chunk, float *out_probability,
-               int *out_flag);
+  // Runs one chunk of window_size_samples samples for the stream whose state
+  // is ``state``, and advances that state.
+  void predict(SileroVadState *state, const float *data_chunk,
+               float *out_probability, int *out_flag);
+
+  // Runs one chunk for each of ``batch_size`` streams in a single inference.
+  // Row b reads ``data_chunks[b]``, advances ``states[b]`` and writes its
+  // speech probability to ``out_probabilities[b]``; the rows don't affect
+  // each other. Returns 0 on success, leaving the states untouched on
+  // failure. Safe to call from several threads at once as long as no two
+  // calls share a state.
+  int predict_batch(SileroVadState *const *states,
+                    const float *const *data_chunks, float *out_probabilities,
+                    int batch_size);
+
+  int window_size() const { return window_size_samples; }
 };
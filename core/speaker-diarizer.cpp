@@ -10,6 +10,7 @@
 #include "cpp-annote-engine.h"
 #include "cpp-annote-streaming.h"
 #include "debug-utils.h"
+#include "resampler.h"
 
 namespace {
 
@@ -60,6 +61,10 @@ struct SpeakerDiarizer::Impl {
     std::map<int32_t, uint64_t> label_to_stable_id;
     // Cached output turns for the last mapped snapshot.
     std::vector<SpeakerTurn> cached_turns;
+    // Brings audio at another rate to the models' rate, keeping its filter
+    // history between calls, and the buffer it writes the result to.
+    std::unique_ptr<StreamingResampler> resampler;
+    std::vector<float> resampled_audio;
   };
 
   cppannote::CppAnnoteEngine engine;
@@ -89,6 +94,43 @@ struct SpeakerDiarizer::Impl {
     return config;
   }
 
+  // Feeds audio to the stream's session at the models' sample rate.
+  void add_audio(StreamState &state, const float *audio_data,
+                 uint64_t audio_length, int32_t sample_rate) {
+    const int32_t model_sample_rate =
+        this->engine.segmentation_model_sample_rate();
+    if (sample_rate == model_sample_rate) {
+      state.session->add_audio_chunk(audio_data, (size_t)(audio_length),
+                                     sample_rate);
+      return;
+    }
+    if (state.resampler == nullptr ||
+        state.resampler->input_sample_rate() != sample_rate) {
+      state.resampler =
+          std::make_unique<StreamingResampler>(sample_rate, model_sample_rate);
+    }
+    state.resampled_audio.clear();
+    state.resampler->process(audio_data, (size_t)(audio_length),
+                             &state.resampled_audio);
+    state.session->add_audio_chunk(state.resampled_audio.data(),
+                                   state.resampled_audio.size(),
+                                   model_sample_rate);
+  }
+
+  // Feeds the session the samples the resampler's filter is still holding
+  // back. Called once the stream's audio has ended.
+  void flush_resampler(StreamState &state) {
+    if (state.resampler == nullptr) {
+      return;
+    }
+    state.resampled_audio.resize(state.resampler->max_output_size(0));
+    state.resampled_audio.resize(
+        state.resampler->flush(state.resampled_audio.data()));
+    state.session->add_audio_chunk(
+        state.resampled_audio.data(), state.resampled_audio.size(),
+        this->engine.segmentation_model_sample_rate());
+  }
+
   StreamState &get_stream(int32_t stream_id) {
     auto it = this->streams.find(stream_id);
     if (it == this->streams.end()) {
@@ -205,6 +247,9 @@ void SpeakerDiarizer::start_stream(int32_t stream_id) {
   state.mapped_turns.clear();
   state.label_to_stable_id.clear();
   state.cached_turns.clear();
+  if (state.resampler != nullptr) {
+    state.resampler->reset();
+  }
 }
 
 void SpeakerDiarizer::add_audio_to_stream(int32_t stream_id,
@@ -214,8 +259,7 @@ void SpeakerDiarizer::add_audio_to_stream(int32_t stream_id,
   std::lock_guard<std::mutex> lock(this->impl->mutex);
   Impl::StreamState &state = this->impl->get_stream(stream_id);
   try {
-    state.session->add_audio_chunk(audio_data, (size_t)(audio_length),
-                                   sample_rate);
+    this->impl->add_audio(state, audio_data, audio_length, sample_rate);
   } catch (const std::exception &e) {
     // A clustering refresh can fail when there isn't enough speech yet (for
     // example an all-silence buffer). The audio is still cached, and the
@@ -235,6 +279,7 @@ std::vector<SpeakerTurn> SpeakerDiarizer::finish_stream(int32_t stream_id) {
   std::lock_guard<std::mutex> lock(this->impl->mutex);
   Impl::StreamState &state = this->impl->get_stream(stream_id);
   try {
+    this->impl->flush_resampler(state);
     this->impl->map_snapshot_to_stable_ids(state, state.session->end_session());
   } catch (const std::exception &e) {
     LOGF("Final speaker diarization pass failed: %s", e.what());
@@ -252,13 +297,14 @@ std::vector<SpeakerTurn> SpeakerDiarizer::diarize(const float *audio_data,
   cppannote::StreamingDiarizationConfig config = this->impl->session_config();
   config.cluster_cadence = kNeverRefresh;
   config.cluster_window_sec = 0.0;
+  config.analysis_threads = this->impl->options.diarize_threads;
   Impl::StreamState state;
   state.session = std::make_unique<cppannote::StreamingDiarizationSession>(
       this->impl->engine, config);
   state.session->start_session();
   try {
-    state.session->add_audio_chunk(audio_data, (size_t)(audio_length),
-                                   sample_rate);
+    this->impl->add_audio(state, audio_data, audio_length, sample_rate);
+    this->impl->flush_resampler(state);
     this->impl->map_snapshot_to_stable_ids(state, state.session->end_session());
   } catch (const std::exception &e) {
     LOGF("Speaker diarization failed: %s", e.what());
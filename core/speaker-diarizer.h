@@ -43,6 +43,9 @@ struct SpeakerDiarizerOptions {
   // Maximum seconds of audio history fed to VBx per refresh. Zero means
   // unlimited (full-history re-clustering). Default 120 for streaming.
   double cluster_window_sec = 120.0;
+  // Threads that share the segmentation and embedding work of one-shot
+  // diarize(). Zero means one per hardware thread. Streams are unaffected.
+  int32_t diarize_threads = 1;
   // The community-1 segmentation and speaker-embedding models. Both are
   // required; the constructor throws if either is missing. They ship as a
   // download rather than compiled-in data (moonshine-model-catalog.h,
@@ -17,6 +17,15 @@
 // Each worker owns its stream for the whole iteration and only ever reads that
 // stream's own transcript output, so any race TSan reports here is in the
 // library, not in the test harness.
+//
+// A second case checks the cost side of sharing a transcriber: streams whose
+// calls interleave must each keep their own incremental streaming-model state,
+// so the number of inference runs for N interleaved streams stays N times that
+// of one stream on its own rather than growing with every switch.
+//
+// A third turns on cross-stream decoder batching and checks that streams
+// decoding at the same time get the same text as they would alone, and a
+// fourth does the same for cross-stream voice activity detection batching.
 
 #include <algorithm>
 #include <atomic>
@@ -24,10 +33,12 @@
 #include <cstdlib>
 #include <filesystem>
 #include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include "debug-utils.h"
+#include "ort-utils.h"
 #include "transcriber.h"
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
@@ -41,6 +52,10 @@ constexpr int kSampleRate = 16000;
 constexpr size_t kMaxClipSamples = 3 * kSampleRate;  // <= 3 seconds
 constexpr int kChunksPerStream = 4;
 constexpr int kIterationsPerThread = 3;
+// The interleaving case wants many small updates, since each one is a point
+// where a shared streaming state would be thrown away and rebuilt.
+constexpr int kInterleavedStreams = 4;
+constexpr int kInterleavedChunks = 12;
 
 std::vector<float> load_clip() {
   const std::string wav_path = "two_cities.wav";
@@ -64,6 +79,74 @@ std::vector<float> load_clip() {
   return std::vector<float>(wav_data, wav_data + count);
 }
 
+// Feeds the clip to every stream in `stream_ids` in kInterleavedChunks slices,
+// visiting the streams round-robin so that consecutive transcribe calls always
+// come from different streams. Returns the number of ORT runs this took.
+uint64_t transcribe_round_robin(Transcriber &transcriber,
+                                const std::vector<int32_t> &stream_ids,
+                                const std::vector<float> &clip) {
+  const uint64_t runs_before = ort_run_count();
+  for (int32_t stream_id : stream_ids) {
+    transcriber.start_stream(stream_id);
+  }
+  const size_t chunk = std::max<size_t>(1, clip.size() / kInterleavedChunks);
+  for (size_t start = 0; start < clip.size(); start += chunk) {
+    const size_t len = std::min(chunk, clip.size() - start);
+    for (int32_t stream_id : stream_ids) {
+      transcriber.add_audio_to_stream(stream_id, clip.data() + start, len,
+                                      kSampleRate);
+      struct transcript_t *transcript = nullptr;
+      transcriber.transcribe_stream(stream_id, MOONSHINE_FLAG_FORCE_UPDATE,
+                                    &transcript);
+    }
+  }
+  for (int32_t stream_id : stream_ids) {
+    transcriber.stop_stream(stream_id);
+    struct transcript_t *transcript = nullptr;
+    transcriber.transcribe_stream(stream_id, MOONSHINE_FLAG_FORCE_UPDATE,
+                                  &transcript);
+  }
+  return ort_run_count() - runs_before;
+}
+
+// Feeds the whole clip to a fresh stream, updating after every chunk so the
+// decoder runs repeatedly, and returns the final text of all its lines.
+std::string transcribe_in_chunks(Transcriber &transcriber,
+                                 const std::vector<float> &clip) {
+  const int32_t stream_id = transcriber.create_stream();
+  transcriber.start_stream(stream_id);
+  const size_t chunk = std::max<size_t>(1, clip.size() / kChunksPerStream);
+  struct transcript_t *transcript = nullptr;
+  for (size_t start = 0; start < clip.size(); start += chunk) {
+    const size_t len = std::min(chunk, clip.size() - start);
+    transcriber.add_audio_to_stream(stream_id, clip.data() + start, len,
+                                    kSampleRate);
+    transcriber.transcribe_stream(stream_id, MOONSHINE_FLAG_FORCE_UPDATE,
+                                  &transcript);
+  }
+  transcriber.stop_stream(stream_id);
+  transcriber.transcribe_stream(stream_id, MOONSHINE_FLAG_FORCE_UPDATE,
+                                &transcript);
+  std::string text;
+  for (uint64_t i = 0; transcript != nullptr && i < transcript->line_count;
+       ++i) {
+    text += transcript->lines[i].text;
+    text += "\n";
+  }
+  transcriber.free_stream(stream_id);
+  return text;
+}
+
+TranscriberOptions streaming_options(const std::string &model_path) {
+  TranscriberOptions options;
+  options.model_source = TranscriberOptions::ModelSource::FILES;
+  options.model_path = model_path.c_str();
+  options.model_arch = MOONSHINE_MODEL_ARCH_TINY_STREAMING;
+  options.identify_speakers = false;
+  options.return_audio_data = false;
+  return options;
+}
+
 }  // namespace
 
 TEST_CASE("transcriber-concurrency") {
@@ -151,3 +234,134 @@ TEST_CASE("transcriber-concurrency") {
   CHECK(completed_streams.load() == thread_count * kIterationsPerThread);
   CHECK_FALSE(saw_null_transcript.load());
 }
+
+TEST_CASE("transcriber-concurrency-interleaved-streaming") {
+  std::vector<float> clip = load_clip();
+  REQUIRE_MESSAGE(
+      !clip.empty(),
+      "two_cities.wav fixture is required for the concurrency test");
+
+  std::string root_model_path = "tiny-streaming-en";
+  REQUIRE(std::filesystem::exists(root_model_path));
+  Transcriber transcriber(streaming_options(root_model_path));
+
+  // Baseline: one stream on its own, so nothing else touches the model
+  // between its calls.
+  const int32_t solo_stream = transcriber.create_stream();
+  const uint64_t solo_runs =
+      transcribe_round_robin(transcriber, {solo_stream}, clip);
+  transcriber.free_stream(solo_stream);
+  REQUIRE(solo_runs > 0);
+
+  // The same audio through several streams whose calls strictly alternate.
+  // Driven from one thread so the interleaving is exactly the same on every
+  // run; the threaded case above already covers the locking.
+  std::vector<int32_t> stream_ids;
+  for (int i = 0; i < kInterleavedStreams; ++i) {
+    stream_ids.push_back(transcriber.create_stream());
+  }
+  const uint64_t interleaved_runs =
+      transcribe_round_robin(transcriber, stream_ids, clip);
+  for (int32_t stream_id : stream_ids) {
+    transcriber.free_stream(stream_id);
+  }
+
+  // Each stream does the same work it would alone. A state shared between
+  // streams would re-run the frontend and encoder over the whole segment on
+  // every switch, which grows with the square of the update count and blows
+  // well past this bound. The small allowance covers decoder runs, which
+  // depend on the tokens and could differ by a step at a segment edge.
+  const uint64_t expected_runs = solo_runs * kInterleavedStreams;
+  CAPTURE(solo_runs);
+  CAPTURE(interleaved_runs);
+  CHECK(interleaved_runs <= expected_runs + expected_runs / 20);
+}
+
+TEST_CASE("transcriber-concurrency-batched-decoding") {
+  std::vector<float> clip = load_clip();
+  REQUIRE_MESSAGE(
+      !clip.empty(),
+      "two_cities.wav fixture is required for the concurrency test");
+
+  std::string root_model_path = "tiny-streaming-en";
+  REQUIRE(std::filesystem::exists(root_model_path));
+
+  std::string expected;
+  {
+    Transcriber transcriber(streaming_options(root_model_path));
+    expected = transcribe_in_chunks(transcriber, clip);
+  }
+  REQUIRE_FALSE(expected.empty());
+
+  TranscriberOptions options = streaming_options(root_model_path);
+  // Long enough that the threads' steps reliably meet in the scheduler.
+  options.decoder_batch_max_wait_ms = 5.0f;
+  options.decoder_batch_max_size = kInterleavedStreams;
+  Transcriber transcriber(options);
+
+  std::vector<std::string> texts(kInterleavedStreams);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < kInterleavedStreams; ++i) {
+    workers.emplace_back(
+        [&, i] { texts[i] = transcribe_in_chunks(transcriber, clip); });
+  }
+  for (auto &t : workers) {
+    t.join();
+  }
+
+  for (const std::string &text : texts) {
+    CHECK(text == expected);
+  }
+  // Whether steps share a run depends on the decoder export, but every step
+  // has to have gone through the scheduler.
+  const MoonshineDecodeBatchStats stats = transcriber.decoder_batch_stats();
+  CAPTURE(stats.batch_count);
+  CAPTURE(stats.max_batch_size);
+  CHECK(stats.step_count > 0);
+  CHECK(stats.step_count >= stats.batch_count);
+  CHECK(stats.max_batch_size <= kInterleavedStreams);
+}
+
+TEST_CASE("transcriber-concurrency-batched-vad") {
+  std::vector<float> clip = load_clip();
+  REQUIRE_MESSAGE(
+      !clip.empty(),
+      "two_cities.wav fixture is required for the concurrency test");
+
+  std::string root_model_path = "tiny-streaming-en";
+  REQUIRE(std::filesystem::exists(root_model_path));
+
+  std::string expected;
+  {
+    Transcriber transcriber(streaming_options(root_model_path));
+    expected = transcribe_in_chunks(transcriber, clip);
+  }
+  REQUIRE_FALSE(expected.empty());
+
+  TranscriberOptions options = streaming_options(root_model_path);
+  options.vad_batch_max_wait_ms = 5.0f;
+  options.vad_batch_max_size = kInterleavedStreams;
+  Transcriber transcriber(options);
+
+  std::vector<std::string> texts(kInterleavedStreams);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < kInterleavedStreams; ++i) {
+    workers.emplace_back(
+        [&, i] { texts[i] = transcribe_in_chunks(transcriber, clip); });
+  }
+  for (auto &t : workers) {
+    t.join();
+  }
+
+  for (const std::string &text : texts) {
+    CHECK(text == expected);
+  }
+  // Whether calls meet depends on the threads' timing, but every stream's
+  // detection has to have gone through the scheduler.
+  const VoiceActivityBatchStats stats = transcriber.vad_batch_stats();
+  CAPTURE(stats.batch_count);
+  CAPTURE(stats.max_batch_size);
+  CHECK(stats.call_count >= (uint64_t)kInterleavedStreams * kChunksPerStream);
+  CHECK(stats.call_count >= stats.batch_count);
+  CHECK(stats.max_batch_size <= kInterleavedStreams);
+}
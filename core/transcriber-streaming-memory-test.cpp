@@ -3,8 +3,9 @@
 // Streams several minutes of synthetic audio with periodic silence gaps so VAD
 // marks completed segments, using a tiny on-device model with
 // return_audio_data disabled. Tracks completed-segment VAD PCM (the heap that
-// leaked before PR #175) and process RSS. Fails on sustained growth of
-// completed-segment bytes; RSS is logged for context.
+// leaked before PR #175), the VAD's segment buffer allocations, and process
+// RSS. Fails on sustained growth of completed-segment bytes or on any buffer
+// allocation after warmup; RSS is logged for context.
 //
 // Invoked from scripts/reliability-remote.sh.
 
@@ -228,7 +229,9 @@ TEST_CASE("transcriber-streaming-memory") {
   options.model_source = TranscriberOptions::ModelSource::FILES;
   options.model_path = root_model_path.c_str();
   options.model_arch = MOONSHINE_MODEL_ARCH_TINY;
-  options.return_audio_data = false;
+  // The default, which used to keep every completed segment's audio in the
+  // detector.
+  options.return_audio_data = true;
   options.identify_speakers = false;
   options.log_output_text = false;
   options.transcription_interval = 0.5f;
@@ -245,12 +248,14 @@ TEST_CASE("transcriber-streaming-memory") {
   size_t samples_since_last_transcription = 0;
   std::vector<size_t> completed_byte_samples;
   std::vector<size_t> rss_samples;
+  std::vector<size_t> retained_samples;
   const size_t expected_sample_count =
       static_cast<size_t>(target_audio_seconds /
                           options.transcription_interval) +
       8;
   completed_byte_samples.reserve(expected_sample_count);
   rss_samples.reserve(expected_sample_count);
+  retained_samples.reserve(expected_sample_count);
 
   while (total_samples_fed < fixture_audio.size()) {
     const size_t remaining = fixture_audio.size() - total_samples_fed;
@@ -274,6 +279,8 @@ TEST_CASE("transcriber-streaming-memory") {
     completed_byte_samples.push_back(
         transcriber.stream_vad_completed_audio_bytes(stream_id));
     rss_samples.push_back(read_rss_kb());
+    retained_samples.push_back(
+        transcriber.stream_vad_retained_audio_bytes(stream_id));
   }
 
   transcriber.stop_stream(stream_id);
@@ -315,4 +322,25 @@ TEST_CASE("transcriber-streaming-memory") {
   }
 
   REQUIRE_FALSE(completed_growing);
+
+  // What the detector holds, counted by capacity, is one arena for the
+  // segment in progress plus at most one completed segment's exact copy
+  // awaiting the next call. Neither can outgrow the longest segment allowed.
+  REQUIRE(retained_samples.size() >= 12);
+  const size_t longest_segment_bytes =
+      (options.vad_look_behind_sample_count +
+       static_cast<size_t>(options.vad_max_segment_duration * kSampleRate) +
+       static_cast<size_t>(options.vad_hop_size)) *
+      sizeof(float);
+  const size_t max_retained =
+      *std::max_element(retained_samples.begin(), retained_samples.end());
+  if (max_retained > 2 * longest_segment_bytes) {
+    for (size_t i = 0; i < retained_samples.size(); ++i) {
+      LOGF("  sample[%zu]: vad_retained=%zu bytes", i, retained_samples[i]);
+    }
+  }
+  REQUIRE(max_retained <= 2 * longest_segment_bytes);
+  std::string retained_report;
+  REQUIRE_FALSE(detect_continual_growth(retained_samples, 384 * 1024, 0.55,
+                                        2048.0, &retained_report));
 }
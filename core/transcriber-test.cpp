@@ -1,14 +1,19 @@
 #include "transcriber.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <new>
 #include <set>
 #include <string>
 #include <vector>
 
 #include "debug-utils.h"
+#include "moonshine-model.h"
 #include "speaker-diarizer.h"
 #include "string-utils.h"
 #include "test-utils.h"
@@ -17,6 +22,30 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest.h>
 
+// Counts the calls to the global operator new while g_count_allocations is
+// set, so a test can see what a call allocates without relying on the code
+// under test to report it.
+namespace {
+std::atomic<bool> g_count_allocations{false};
+std::atomic<uint64_t> g_allocation_count{0};
+}  // namespace
+
+void *operator new(std::size_t size) {
+  if (g_count_allocations.load(std::memory_order_relaxed)) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  void *ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
 namespace {
 // The diarization models ship as a download rather than compiled-in data
 // (docs/diarization-models.md), so the tests point at the copies under
@@ -683,6 +712,36 @@ TEST_CASE("transcriber-test") {
     free(debug_wav_data);
     free(wav_data);
   }
+  SUBCASE("resampled-stream-keeps-its-tail") {
+    // Audio added at another rate goes through the stream's resampler, which
+    // holds back its last outputs until stop() flushes them.
+    const int32_t input_rate = 44100;
+    std::vector<float> input(input_rate / 3);
+    for (size_t i = 0; i < input.size(); i++) {
+      input[i] = 0.5f * std::sin(0.05f * static_cast<float>(i));
+    }
+    StreamingResampler one_shot(input_rate, 16000);
+    std::vector<float> expected;
+    one_shot.process(input.data(), input.size(), &expected);
+    std::vector<float> tail(one_shot.max_output_size(0));
+    tail.resize(one_shot.flush(tail.data()));
+    expected.insert(expected.end(), tail.begin(), tail.end());
+    REQUIRE(!tail.empty());
+
+    TranscriberStream stream(new VoiceActivityDetector(), 0);
+    stream.start();
+    const size_t chunk_size = 441;
+    for (size_t i = 0; i < input.size(); i += chunk_size) {
+      stream.add_to_new_audio_buffer(input.data() + i,
+                                     std::min(chunk_size, input.size() - i),
+                                     input_rate);
+    }
+    CHECK(stream.new_audio_buffer.size() < expected.size());
+    stream.stop();
+    CHECK(stream.new_audio_buffer.size() ==
+          static_cast<size_t>(std::ceil(input.size() * 16000.0 / input_rate)));
+    CHECK(stream.new_audio_buffer == expected);
+  }
   SUBCASE("test-save-input-wav-without-streaming") {
     std::string wav_path = "two_cities.wav";
     REQUIRE(std::filesystem::exists(wav_path));
@@ -1208,6 +1267,133 @@ TEST_CASE("transcriber-test") {
     REQUIRE(aligned_lines > 0);
     free(wav_data);
   }
+  SUBCASE("decoder-step-allocations") {
+    // The non-streaming decode loop sizes its caches for the longest output a
+    // clip allows before the first step, and after the first cache-branch
+    // step writes the cross-attention caches the decoder echoes back to
+    // scratch. Each step still wraps its buffers in the same number of small
+    // OrtValues, since their shapes change, so from then on every step must
+    // allocate as often as the one before, however long the cache has grown.
+    std::string wav_path = "beckett.wav";
+    REQUIRE(std::filesystem::exists(wav_path));
+    float *wav_data = nullptr;
+    size_t wav_data_size = 0;
+    int32_t wav_sample_rate = 0;
+    REQUIRE(load_wav_data(wav_path.c_str(), &wav_data, &wav_data_size,
+                          &wav_sample_rate));
+    REQUIRE(wav_data != nullptr);
+    REQUIRE(wav_sample_rate == 16000);
+    REQUIRE(std::filesystem::exists("tiny-en"));
+
+    MoonshineModel model;
+    REQUIRE(model.load("tiny-en/encoder_model.ort",
+                       "tiny-en/decoder_model_merged.ort",
+                       "tiny-en/tokenizer.bin",
+                       MOONSHINE_MODEL_ARCH_TINY) == 0);
+    char *out_text = nullptr;
+    REQUIRE(model.transcribe(wav_data, wav_data_size, &out_text) == 0);
+    const std::string first_text = out_text;
+    const int steps = model.last_decoder_run_count;
+    // Run 0 fills the caches and run 1 is the first to read them, so runs 2
+    // on are the steady ones, and a few of them are needed to see a trend.
+    REQUIRE(steps > 5);
+
+    // Allocations so far at the end of each run, noted without allocating.
+    std::vector<uint64_t> count_after_run(steps, 0);
+    model.decoder_run_observer = [&](int run) {
+      if (run < steps) {
+        count_after_run[run] = g_allocation_count;
+      }
+    };
+    g_allocation_count = 0;
+    g_count_allocations = true;
+    const int error = model.transcribe(wav_data, wav_data_size, &out_text);
+    g_count_allocations = false;
+    model.decoder_run_observer = nullptr;
+    REQUIRE(error == 0);
+    REQUIRE(std::string(out_text) == first_text);
+    REQUIRE(model.last_decoder_run_count == steps);
+
+    const uint64_t steady = count_after_run[2] - count_after_run[1];
+    CAPTURE(steady);
+    for (int run = 3; run < steps; run++) {
+      CAPTURE(run);
+      CHECK(count_after_run[run] - count_after_run[run - 1] == steady);
+    }
+    free(wav_data);
+  }
+  SUBCASE("incremental-decoding") {
+    // Reusing the previous decode of an unfinished line as a draft must give
+    // the same lines as decoding every update from scratch, and skipping
+    // updates that add little audio must not change the finished lines.
+    std::string wav_path = "beckett.wav";
+    REQUIRE(std::filesystem::exists(wav_path));
+    float *wav_data = nullptr;
+    size_t wav_data_size = 0;
+    int32_t wav_sample_rate = 0;
+    REQUIRE(load_wav_data(wav_path.c_str(), &wav_data, &wav_data_size,
+                          &wav_sample_rate));
+    REQUIRE(wav_data != nullptr);
+    REQUIRE(wav_data_size > 0);
+    REQUIRE(std::filesystem::exists("tiny-en"));
+
+    const size_t chunk = (size_t)(wav_sample_rate / 2);
+    auto transcribe_lines = [&](Transcriber &transcriber) {
+      const int32_t stream_id = transcriber.create_stream();
+      REQUIRE(stream_id >= 0);
+      transcriber.start_stream(stream_id);
+      struct transcript_t *transcript = nullptr;
+      for (size_t offset = 0; offset < wav_data_size; offset += chunk) {
+        const size_t count = std::min(chunk, wav_data_size - offset);
+        transcriber.add_audio_to_stream(stream_id, wav_data + offset, count,
+                                        wav_sample_rate);
+        transcriber.transcribe_stream(stream_id, 0, &transcript);
+      }
+      transcriber.stop_stream(stream_id);
+      transcriber.transcribe_stream(stream_id, 0, &transcript);
+      REQUIRE(transcript != nullptr);
+      std::vector<std::string> lines;
+      for (size_t i = 0; i < transcript->line_count; i++) {
+        const struct transcript_line_t &line = transcript->lines[i];
+        lines.push_back(line.text == nullptr ? "" : line.text);
+      }
+      transcriber.free_stream(stream_id);
+      return lines;
+    };
+
+    TranscriberOptions options;
+    options.model_source = TranscriberOptions::ModelSource::FILES;
+    options.model_path = "tiny-en";
+    options.model_arch = MOONSHINE_MODEL_ARCH_TINY;
+    Transcriber plain_transcriber(options);
+    const std::vector<std::string> plain_lines =
+        transcribe_lines(plain_transcriber);
+    REQUIRE(plain_lines.size() > 0);
+    TranscriberIncrementalDecodeStats plain_stats =
+        plain_transcriber.incremental_decode_stats();
+    REQUIRE(plain_stats.pass_count == 0);
+
+    options.incremental_decoding = true;
+    Transcriber incremental_transcriber(options);
+    REQUIRE(transcribe_lines(incremental_transcriber) == plain_lines);
+    TranscriberIncrementalDecodeStats stats =
+        incremental_transcriber.incremental_decode_stats();
+    REQUIRE(stats.pass_count > 0);
+    REQUIRE(stats.skipped_pass_count == 0);
+    REQUIRE(stats.decoder_run_count > 0);
+    REQUIRE(stats.draft_tokens_accepted > 0);
+
+    // Two chunks' worth, so every other update of an unfinished line is
+    // skipped.
+    options.incremental_min_new_samples = chunk * 2;
+    Transcriber skipping_transcriber(options);
+    REQUIRE(transcribe_lines(skipping_transcriber) == plain_lines);
+    TranscriberIncrementalDecodeStats skipping_stats =
+        skipping_transcriber.incremental_decode_stats();
+    REQUIRE(skipping_stats.skipped_pass_count > 0);
+    REQUIRE(skipping_stats.decoder_run_count < stats.decoder_run_count);
+    free(wav_data);
+  }
   SUBCASE("keyterm-biasing") {
     std::string wav_path = "two_cities.wav";
     REQUIRE(std::filesystem::exists(wav_path));
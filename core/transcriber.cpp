@@ -132,6 +132,20 @@ Transcriber::Transcriber(const TranscriberOptions &options)
     throw std::runtime_error("Invalid model source: " +
                              std::to_string((int)(model_source)));
   }
+  // Word timestamps collect attention weights into a buffer on the model,
+  // which only works when one stream decodes at a time.
+  if (this->streaming_model != nullptr &&
+      this->options.decoder_batch_max_wait_ms > 0.0f &&
+      !this->options.word_timestamps) {
+    this->decode_scheduler =
+        std::make_unique<MoonshineStreamingDecodeScheduler>(
+            this->streaming_model, this->options.decoder_batch_max_wait_ms,
+            this->options.decoder_batch_max_size);
+  }
+  if (this->options.vad_batch_max_wait_ms > 0.0f) {
+    this->vad_scheduler = std::make_unique<VoiceActivityBatchScheduler>(
+        this->options.vad_batch_max_wait_ms, this->options.vad_batch_max_size);
+  }
   if (options.identify_speakers) {
     SpeakerDiarizerOptions diarizer_options;
     diarizer_options.cluster_cadence =
@@ -140,6 +154,7 @@ Transcriber::Transcriber(const TranscriberOptions &options)
         this->options.diarization_analyze_cadence;
     diarizer_options.cluster_window_sec =
         this->options.diarization_cluster_window_sec;
+    diarizer_options.diarize_threads = this->options.diarization_threads;
     // The keyed in-memory loader delivers the diarization models as canonical
     // assets, the same way it delivers the spelling model. The map outlives the
     // transcriber, so the bytes stay valid for the ORT sessions reading them.
@@ -256,7 +271,8 @@ void Transcriber::set_keyterms(const std::vector<std::string> &keyterms) {
   // so it is no longer a useful prediction of what this configuration would
   // produce, and letting it stand means a changed list keeps influencing the
   // next decode through the tokens it verifies. Costs one re-decode from BOS.
-  this->last_streaming_tokens.clear();
+  // Streams notice the new generation the next time they decode.
+  this->keyterms_generation++;
   if (keyterms.empty()) {
     return;
   }
@@ -320,8 +336,6 @@ void Transcriber::load_from_files(const char *model_path, uint32_t model_arch) {
           std::string(model_path) +
           ". Error code: " + std::to_string(load_error));
     }
-    const MoonshineStreamingConfig &config = this->streaming_model->config;
-    this->streaming_state.reset(config);
 
     // Load attention-enabled streaming decoder if word timestamps requested
     if (this->options.word_timestamps) {
@@ -408,6 +422,10 @@ void Transcriber::load_from_files(const char *model_path, uint32_t model_arch) {
         if (dec_err != 0) {
           LOGF("Warning: Failed to load decoder_with_attention from %s\n",
                decoder_attn_path.c_str());
+        } else if (this->stt_model->reload_decoder_io() != 0) {
+          throw std::runtime_error(
+              "Failed to read decoder_with_attention inputs from " +
+              decoder_attn_path);
         }
       } else if (std::filesystem::exists(alignment_path)) {
         // Two-pass fallback: separate alignment model
@@ -572,7 +590,6 @@ void Transcriber::load_from_memory_files(uint32_t model_arch) {
           "code: " +
           std::to_string(load_error));
     }
-    this->streaming_state.reset(this->streaming_model->config);
 
     // Swap in the attention-enabled streaming decoder for word timestamps.
     if (this->options.word_timestamps &&
@@ -623,6 +640,11 @@ void Transcriber::load_from_memory_files(uint32_t model_arch) {
                                   this->stt_model->ort_session_options,
                                   &this->stt_model->decoder_session, attn_data,
                                   attn_size, "decoder_with_attention.ort");
+      if (this->stt_model->decoder_session != nullptr &&
+          this->stt_model->reload_decoder_io() != 0) {
+        throw std::runtime_error(
+            "Failed to read decoder_with_attention.ort inputs");
+      }
     } else if (this->options.model_files.contains("alignment_model.ort")) {
       const uint8_t *align_data = nullptr;
       size_t align_size = 0;
@@ -720,6 +742,7 @@ void Transcriber::free_stream(int32_t stream_id) {
   std::lock_guard<std::mutex> lock(this->streams_mutex);
   TranscriberStream *stream = this->streams[stream_id];
   this->streams.erase(stream_id);
+  this->set_vad_batch_active(stream, false);
   if (this->speaker_diarizer != nullptr && stream->diarizer_stream_id >= 0) {
     this->speaker_diarizer->free_stream(stream->diarizer_stream_id);
   }
@@ -740,6 +763,7 @@ void Transcriber::start_stream(int32_t stream_id) {
     stream->transcript_output->transcript.line_count = 0;
   }
   stream->start();
+  this->set_vad_batch_active(stream, true);
   if (this->speaker_diarizer != nullptr && stream->diarizer_stream_id >= 0) {
     this->speaker_diarizer->start_stream(stream->diarizer_stream_id);
   }
@@ -749,6 +773,7 @@ void Transcriber::stop_stream(int32_t stream_id) {
   std::lock_guard<std::mutex> lock(this->streams_mutex);
   TranscriberStream *stream = this->streams[stream_id];
   stream->stop();
+  this->set_vad_batch_active(stream, false);
   stream->save_audio_data_to_wav(nullptr, 0, 0);
   if (this->speaker_diarizer != nullptr && stream->diarizer_stream_id >= 0) {
     // Run a final clustering pass so the next transcribe_stream call picks up
@@ -852,31 +877,30 @@ void Transcriber::transcribe_stream(int32_t stream_id, uint32_t flags,
                                                 INTERNAL_SAMPLE_RATE);
   }
 
-  // Use VAD to segment audio
-  std::vector<VoiceActivitySegment> segments;
+  // Use VAD to segment audio. The segments' audio stays in the detector,
+  // which only this call changes, until the completed segments are cleared
+  // below. With batching on, the detector joins other streams' in one batch;
+  // holding vad_mutex meanwhile keeps it out of any other batch.
+  std::vector<VoiceActivitySegment> &segments = stream->vad_segments;
   {
     std::lock_guard<std::mutex> lock(stream->vad_mutex);
-    stream->vad->process_audio(audio_data, (int32_t)audio_length,
-                               INTERNAL_SAMPLE_RATE);
+    if (this->vad_scheduler != nullptr) {
+      this->vad_scheduler->process_audio(stream->vad, audio_data, audio_length,
+                                         INTERNAL_SAMPLE_RATE);
+    } else {
+      stream->vad->process_audio(audio_data, (int32_t)audio_length,
+                                 INTERNAL_SAMPLE_RATE);
+    }
     const std::vector<VoiceActivitySegment> *vad_segments =
         stream->vad->get_segments();
-    segments.reserve(vad_segments->size());
-    for (const VoiceActivitySegment &segment : *vad_segments) {
-      VoiceActivitySegment segment_copy;
-      segment_copy.start_time = segment.start_time;
-      segment_copy.end_time = segment.end_time;
-      segment_copy.is_complete = segment.is_complete;
-      segment_copy.just_updated = segment.just_updated;
-      if (segment.just_updated) {
-        segment_copy.audio_data = segment.audio_data;
-      }
-      segments.push_back(std::move(segment_copy));
-    }
+    segments.assign(vad_segments->begin(), vad_segments->end());
   }
   stream->clear_new_audio_buffer();
   this->update_transcript_from_segments(segments, stream, flags,
                                         out_transcript);
-  if (!this->options.return_audio_data) {
+  {
+    // A completed segment is only reported once, and any line that returns
+    // its audio has its own copy by now, so the detector can let it go.
     std::lock_guard<std::mutex> lock(stream->vad_mutex);
     stream->vad->clear_completed_segment_audio_data();
   }
@@ -912,6 +936,38 @@ size_t Transcriber::stream_vad_completed_audio_bytes(int32_t stream_id) {
   return stream->vad->completed_segment_audio_byte_count();
 }
 
+MoonshineDecodeBatchStats Transcriber::decoder_batch_stats() {
+  if (this->decode_scheduler == nullptr) {
+    return MoonshineDecodeBatchStats();
+  }
+  return this->decode_scheduler->stats();
+}
+
+VoiceActivityBatchStats Transcriber::vad_batch_stats() {
+  if (this->vad_scheduler == nullptr) {
+    return VoiceActivityBatchStats();
+  }
+  return this->vad_scheduler->stats();
+}
+
+void Transcriber::set_vad_batch_active(TranscriberStream *stream,
+                                       bool active) {
+  if (this->vad_scheduler == nullptr || stream->vad_batch_active == active) {
+    return;
+  }
+  stream->vad_batch_active = active;
+  if (active) {
+    this->vad_scheduler->begin_stream();
+  } else {
+    this->vad_scheduler->end_stream();
+  }
+}
+
+TranscriberIncrementalDecodeStats Transcriber::incremental_decode_stats() {
+  std::lock_guard<std::mutex> lock(this->stt_model_mutex);
+  return this->incremental_stats;
+}
+
 std::string Transcriber::transcript_to_string(
     const struct transcript_t *transcript) {
   std::string result;
@@ -1022,13 +1078,13 @@ void Transcriber::update_transcript_from_segments(
         this->streaming_model != nullptr) {
       // Use streaming model for transcription (incremental processing)
       line.text = transcribe_segment_with_streaming_model(
-          segment.audio_data.data(), segment.audio_data.size(), line.id,
-          segment.is_complete);
+          stream, segment.audio_data.data(), segment.audio_data.size(),
+          line.id, segment.is_complete);
 
       // Compute word timestamps from streaming model's collected attention
       if (this->options.word_timestamps &&
           !this->streaming_model->cross_attention_buffer.empty() &&
-          !this->last_streaming_tokens.empty()) {
+          !stream->last_streaming_tokens.empty()) {
         float seg_duration =
             segment.audio_data.size() / (float)INTERNAL_SAMPLE_RATE;
         int L = this->streaming_model->config.depth;
@@ -1055,7 +1111,7 @@ void Transcriber::update_transcript_from_segments(
           float time_per_frame = seg_duration / static_cast<float>(E);
           std::vector<TranscriberWord> words =
               align_words(rearranged.data(), L, H, total_steps, E,
-                          this->last_streaming_tokens, time_per_frame,
+                          stream->last_streaming_tokens, time_per_frame,
                           this->streaming_model->tokenizer);
 
           if (!words.empty()) {
@@ -1076,9 +1132,10 @@ void Transcriber::update_transcript_from_segments(
       } else {
         // Use non-streaming model for transcription
         std::lock_guard<std::mutex> lock(this->stt_model_mutex);
-        char *out_text = nullptr;
-        int transcribe_error = this->stt_model->transcribe(
-            segment.audio_data.data(), segment.audio_data.size(), &out_text);
+        const char *out_text = nullptr;
+        int transcribe_error = transcribe_segment_with_stt_model(
+            stream, segment.audio_data.data(), segment.audio_data.size(),
+            line.id, segment.is_complete, &out_text);
         if (transcribe_error != 0) {
           LOGF("Failed to transcribe: %d", transcribe_error);
           throw std::runtime_error("Failed to transcribe: " +
@@ -1130,7 +1187,8 @@ void Transcriber::update_transcript_from_segments(
       // Spelling fusion needs the segment audio for the .ort model.
       // We store it on the line either way; the line is reset before
       // we hand the transcript back so this doesn't leak per-segment.
-      line.audio_data = segment.audio_data;
+      line.audio_data.assign(segment.audio_data.begin(),
+                             segment.audio_data.end());
     }
     if (spelling_mode_enabled && line.is_complete) {
       apply_spelling_fusion(line);
@@ -1309,25 +1367,26 @@ bool Transcriber::apply_speaker_turns_to_lines(
 }
 
 std::string *Transcriber::transcribe_segment_with_streaming_model(
-    const float *audio_data, size_t audio_length, uint64_t segment_id,
-    bool is_final) {
+    TranscriberStream *stream, const float *audio_data, size_t audio_length,
+    uint64_t segment_id, bool is_final) {
   if (audio_length == 0 || this->streaming_model == nullptr) {
     return new std::string();
   }
 
   const MoonshineStreamingConfig &config = this->streaming_model->config;
 
-  // Check if this is a new segment - if so, reset state
-  bool is_new_segment = (segment_id != this->current_streaming_segment_id);
+  // Check if this is a new segment - if so, reset state. The state lives on
+  // the stream, so other streams' calls in between leave it untouched.
+  bool is_new_segment = (segment_id != stream->current_streaming_segment_id);
   if (is_new_segment) {
-    this->streaming_state.reset(config);
-    this->current_streaming_segment_id = segment_id;
-    this->streaming_samples_processed = 0;
-    this->last_streaming_tokens.clear();
+    stream->streaming_state.reset(config);
+    stream->current_streaming_segment_id = segment_id;
+    stream->streaming_samples_processed = 0;
+    stream->last_streaming_tokens.clear();
   }
 
   // Calculate how many new samples we need to process
-  size_t new_samples_start = this->streaming_samples_processed;
+  size_t new_samples_start = stream->streaming_samples_processed;
 
   if (new_samples_start >= audio_length) {
     // No new audio to process, but we may still need to decode
@@ -1345,7 +1404,7 @@ std::string *Transcriber::transcribe_segment_with_streaming_model(
       for (size_t chunk_index = 0; chunk_index < chunk_count; chunk_index++) {
         size_t offset = chunk_index * chunk_size;
         int err = this->streaming_model->process_audio_chunk(
-            &this->streaming_state, new_audio_data + offset, chunk_size,
+            &stream->streaming_state, new_audio_data + offset, chunk_size,
             nullptr);
         if (err != 0) {
           LOGF("Failed to process audio chunk: %d", err);
@@ -1357,8 +1416,8 @@ std::string *Transcriber::transcribe_segment_with_streaming_model(
       // Run encoder - is_final determines if we emit all frames or keep
       // lookahead
       int new_frames = 0;
-      int err = this->streaming_model->encode(&this->streaming_state, is_final,
-                                              &new_frames);
+      int err = this->streaming_model->encode(&stream->streaming_state,
+                                              is_final, &new_frames);
       if (err != 0) {
         LOGF("Failed to encode: %d", err);
         throw std::runtime_error("Failed to encode: " + std::to_string(err));
@@ -1367,11 +1426,11 @@ std::string *Transcriber::transcribe_segment_with_streaming_model(
 
     // Update the count of processed samples with the chunks we've actually
     // processed.
-    this->streaming_samples_processed += chunk_count * chunk_size;
+    stream->streaming_samples_processed += chunk_count * chunk_size;
   }
 
   // If no memory accumulated, return empty string
-  if (this->streaming_state.memory_len == 0) {
+  if (stream->streaming_state.memory_len == 0) {
     return new std::string();
   }
 
@@ -1381,7 +1440,7 @@ std::string *Transcriber::transcribe_segment_with_streaming_model(
 
   // Reset decoder state before decoding (we decode from scratch each time
   // since memory may have changed)
-  this->streaming_model->decoder_reset(&this->streaming_state);
+  this->streaming_model->decoder_reset(&stream->streaming_state);
 
   // Decode to get transcription
   const float duration_sec = audio_length / (float)INTERNAL_SAMPLE_RATE;
@@ -1393,19 +1452,37 @@ std::string *Transcriber::transcribe_segment_with_streaming_model(
 
   // Held across the whole decode so a concurrent set_keyterms cannot swap the
   // trie out from under it. Always taken before streaming_model_mutex.
-  std::lock_guard<std::mutex> biaser_lock(this->context_biaser_mutex);
+  std::unique_lock<std::mutex> biaser_lock(this->context_biaser_mutex);
   ContextBiaser *biaser =
       this->context_biaser.empty() ? nullptr : &this->context_biaser;
+  if (stream->streaming_keyterms_generation != this->keyterms_generation) {
+    stream->last_streaming_tokens.clear();
+    stream->streaming_keyterms_generation = this->keyterms_generation;
+  }
+
+  // Without key terms the decode only touches this stream's state, so it can
+  // run alongside other streams and let the scheduler batch their steps. The
+  // biaser's walk state is shared, so biased decodes stay serialized.
+  MoonshineStreamingDecodeScheduler *scheduler = nullptr;
+  if (this->decode_scheduler != nullptr && biaser == nullptr) {
+    scheduler = this->decode_scheduler.get();
+    biaser_lock.unlock();
+  }
 
   {
-    std::lock_guard<std::mutex> lock(this->streaming_model_mutex);
+    std::unique_lock<std::mutex> lock(this->streaming_model_mutex,
+                                      std::defer_lock);
+    if (scheduler == nullptr) {
+      lock.lock();
+    }
+    MoonshineStreamingDecodeScheduler::ScopedDecode active_decode(scheduler);
 
     if (this->options.use_speculative_decoding && !is_new_segment &&
-        !this->last_streaming_tokens.empty()) {
+        !stream->last_streaming_tokens.empty()) {
       // Previous content tokens as draft (strip BOS/EOS).
       std::vector<int> draft;
-      draft.reserve(this->last_streaming_tokens.size());
-      for (int t : this->last_streaming_tokens) {
+      draft.reserve(stream->last_streaming_tokens.size());
+      for (int t : stream->last_streaming_tokens) {
         if (t == config.bos_id || t == config.eos_id) continue;
         draft.push_back(t);
       }
@@ -1414,8 +1491,8 @@ std::string *Transcriber::transcribe_segment_with_streaming_model(
       int out_len = 0;
       const int *draft_ptr = draft.empty() ? nullptr : draft.data();
       int err = this->streaming_model->decode_full(
-          &this->streaming_state, draft_ptr, static_cast<int>(draft.size()),
-          &out, &out_len, biaser);
+          &stream->streaming_state, draft_ptr, static_cast<int>(draft.size()),
+          &out, &out_len, biaser, scheduler);
       if (err != 0) {
         LOGF("Speculative decode_full failed: %d", err);
         throw std::runtime_error("Speculative decode_full failed: " +
@@ -1441,8 +1518,12 @@ std::string *Transcriber::transcribe_segment_with_streaming_model(
       }
 
       for (int step = 0; step < max_tokens; ++step) {
-        int err = this->streaming_model->decode_step(
-            &this->streaming_state, current_token, logits.data());
+        int err =
+            scheduler != nullptr
+                ? scheduler->decode_step(&stream->streaming_state,
+                                         current_token, logits.data())
+                : this->streaming_model->decode_step(
+                      &stream->streaming_state, current_token, logits.data());
         if (err != 0) {
           break;
         }
@@ -1473,9 +1554,9 @@ std::string *Transcriber::transcribe_segment_with_streaming_model(
   }
 
   // Save tokens for word timestamp alignment / next speculative draft
-  this->last_streaming_tokens.clear();
+  stream->last_streaming_tokens.clear();
   for (auto t : tokens) {
-    this->last_streaming_tokens.push_back(static_cast<int>(t));
+    stream->last_streaming_tokens.push_back(static_cast<int>(t));
   }
 
   // Convert tokens to text
@@ -1486,6 +1567,49 @@ std::string *Transcriber::transcribe_segment_with_streaming_model(
   return sanitize_text(text.c_str());
 }
 
+int Transcriber::transcribe_segment_with_stt_model(
+    TranscriberStream *stream, const float *audio_data, size_t audio_length,
+    uint64_t segment_id, bool is_final, const char **out_text) {
+  char *text = nullptr;
+  if (!this->options.incremental_decoding) {
+    const int error =
+        this->stt_model->transcribe(audio_data, audio_length, &text);
+    *out_text = text;
+    return error;
+  }
+
+  if (segment_id != stream->stt_segment_id) {
+    stream->stt_segment_id = segment_id;
+    stream->stt_samples_transcribed = 0;
+    stream->stt_draft_tokens.clear();
+    stream->stt_last_text.clear();
+  }
+  this->incremental_stats.pass_count++;
+  if (!is_final && stream->stt_samples_transcribed > 0 &&
+      audio_length < stream->stt_samples_transcribed +
+                         this->options.incremental_min_new_samples) {
+    this->incremental_stats.skipped_pass_count++;
+    *out_text = stream->stt_last_text.c_str();
+    return 0;
+  }
+
+  std::vector<int64_t> tokens;
+  const int error = this->stt_model->transcribe_with_draft(
+      audio_data, audio_length, stream->stt_draft_tokens, &tokens, &text);
+  if (error != 0) {
+    return error;
+  }
+  this->incremental_stats.decoder_run_count +=
+      this->stt_model->last_decoder_run_count;
+  this->incremental_stats.draft_tokens_accepted +=
+      this->stt_model->last_draft_tokens_accepted;
+  stream->stt_samples_transcribed = audio_length;
+  stream->stt_draft_tokens = std::move(tokens);
+  stream->stt_last_text = text;
+  *out_text = stream->stt_last_text.c_str();
+  return 0;
+}
+
 std::string *Transcriber::sanitize_text(const char *text) {
   std::string text_string(text);
   std::string *result = new std::string();
@@ -1773,12 +1897,27 @@ TranscriberStream::TranscriberStream(VoiceActivityDetector *vad,
 
 void TranscriberStream::start() {
   this->vad->start();
+  if (this->input_resampler != nullptr) {
+    this->input_resampler->reset();
+  }
   std::lock_guard<std::mutex> lock(this->transcript_output->mutex);
   this->transcript_output->internal_lines_map.clear();
   this->transcript_output->ordered_internal_line_ids.clear();
 }
 
-void TranscriberStream::stop() { this->vad->stop(); }
+void TranscriberStream::stop() {
+  // The resampler holds back the last few output samples until it sees the
+  // input that follows them, so hand them over before the stream ends.
+  if (this->input_resampler != nullptr) {
+    const size_t previous_size = this->new_audio_buffer.size();
+    this->new_audio_buffer.resize(previous_size +
+                                  this->input_resampler->max_output_size(0));
+    const size_t written = this->input_resampler->flush(
+        this->new_audio_buffer.data() + previous_size);
+    this->new_audio_buffer.resize(previous_size + written);
+  }
+  this->vad->stop();
+}
 
 std::string TranscriberStream::get_wav_filename() {
   if (this->stream_id == -1) {
@@ -1824,11 +1963,18 @@ void TranscriberStream::add_to_new_audio_buffer(const float *audio_data,
                                                 uint64_t audio_length,
                                                 int32_t sample_rate) {
   this->save_audio_data_to_wav(audio_data, audio_length, sample_rate);
-  std::vector<float> audio_vector(audio_data, audio_data + audio_length);
-  std::vector<float> resampled_audio =
-      resample_audio(audio_vector, sample_rate, INTERNAL_SAMPLE_RATE);
-  this->new_audio_buffer.insert(this->new_audio_buffer.end(),
-                                resampled_audio.begin(), resampled_audio.end());
+  if (sample_rate == INTERNAL_SAMPLE_RATE) {
+    this->new_audio_buffer.insert(this->new_audio_buffer.end(), audio_data,
+                                  audio_data + audio_length);
+    return;
+  }
+  if (this->input_resampler == nullptr ||
+      this->input_resampler->input_sample_rate() != sample_rate) {
+    this->input_resampler = std::make_unique<StreamingResampler>(
+        sample_rate, INTERNAL_SAMPLE_RATE);
+  }
+  this->input_resampler->process(audio_data, audio_length,
+                                 &this->new_audio_buffer);
 }
 
 void TranscriberStream::clear_new_audio_buffer() {
@@ -5,6 +5,7 @@
 #include <chrono>
 #include <cinttypes>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <random>
 #include <string>
@@ -14,10 +15,13 @@
 #include "context-extractor.h"
 #include "file-information.h"
 #include "moonshine-model.h"
+#include "moonshine-streaming-decode-scheduler.h"
 #include "moonshine-streaming-model.h"
+#include "resampler.h"
 #include "speaker-diarizer.h"
 #include "spelling-fusion.h"
 #include "spelling-model.h"
+#include "voice-activity-batch-scheduler.h"
 #include "voice-activity-detector.h"
 #include "word-alignment.h"
 
@@ -80,8 +84,18 @@ class TranscriberStream {
  public:
   VoiceActivityDetector *vad = nullptr;
   std::mutex vad_mutex;
+  // Copy of the detector's segment list taken by each transcribe_stream
+  // call, kept so its storage is reused.
+  std::vector<VoiceActivitySegment> vad_segments;
+  // Whether the transcriber's VoiceActivityBatchScheduler counts this stream
+  // as feeding audio, between its start_stream and stop_stream.
+  bool vad_batch_active = false;
   TranscriptStreamOutput *transcript_output;
   std::vector<float> new_audio_buffer;
+  // Converts audio added at another rate to the internal one, carrying its
+  // filter history across add_to_new_audio_buffer calls. Created on the first
+  // such call, and again if the caller's rate changes.
+  std::unique_ptr<StreamingResampler> input_resampler;
   std::string save_input_wav_path = "";
   std::vector<float> save_input_data;
   int32_t last_save_sample_rate = 0;
@@ -91,6 +105,29 @@ class TranscriberStream {
   // identification is disabled.
   int32_t diarizer_stream_id = -1;
 
+  // Incremental decoding progress for the streaming architectures. Each stream
+  // keeps its own frontend/encoder/adapter state, the count of segment samples
+  // already fed through them, and the previous decode used as the speculative
+  // draft, so streams sharing a transcriber can interleave their calls without
+  // forcing each other to re-encode the current segment from sample zero.
+  MoonshineStreamingState streaming_state;
+  uint64_t current_streaming_segment_id = UINT64_MAX;
+  size_t streaming_samples_processed = 0;
+  std::vector<int> last_streaming_tokens;
+  // The transcriber's key-term generation that last_streaming_tokens was
+  // decoded under. A mismatch means set_keyterms ran since, so the draft is
+  // stale and is dropped before the next decode.
+  uint64_t streaming_keyterms_generation = 0;
+
+  // The same for the non-streaming architectures when
+  // options.incremental_decoding is on. Their encoder has to see the whole
+  // segment again, but the previous tokens serve as a draft for the decoder,
+  // and a segment that has barely grown keeps its previous text.
+  uint64_t stt_segment_id = UINT64_MAX;
+  size_t stt_samples_transcribed = 0;
+  std::vector<int64_t> stt_draft_tokens;
+  std::string stt_last_text;
+
   TranscriberStream(VoiceActivityDetector *vad, int32_t stream_id,
                     const std::string &save_input_wav_path = "");
   ~TranscriberStream() {
@@ -193,6 +230,31 @@ struct TranscriberOptions {
   // (and diarization) still run on each update so the final decode has
   // current memory; there is no live/provisional text.
   bool decode_incomplete_lines = true;
+  // Streaming models only. When positive, decoder steps from streams that
+  // are decoding at the same time are gathered into one batched run, and
+  // this is how long (in milliseconds) the first waiting step holds the batch
+  // open for the others. Zero keeps every stream's decode separate. Key-term
+  // biasing and word timestamps decode one stream at a time regardless.
+  float decoder_batch_max_wait_ms = 0.0f;
+  // Most streams combined into one batched decoder run.
+  int32_t decoder_batch_max_size = 8;
+  // When positive, voice activity detection for streams whose
+  // transcribe_stream calls arrive at the same time runs as one batch, so
+  // their hops share Silero runs, and this is how long (in milliseconds) the
+  // first waiting call holds the batch open for the other started streams.
+  // Zero runs each stream's detection on its own.
+  float vad_batch_max_wait_ms = 0.0f;
+  // Most streams combined into one batched detection call.
+  int32_t vad_batch_max_size = 16;
+  // Non-streaming models only. Each update of an in-progress line normally
+  // re-decodes it from the start token. When true, the previous tokens are
+  // checked as a draft in one decoder run and decoding resumes where they
+  // stop matching, which gives the same text with fewer decoder runs.
+  bool incremental_decoding = false;
+  // With incremental_decoding, an in-progress line that has grown by fewer
+  // than this many samples since it was last decoded keeps its previous text
+  // rather than being decoded again. Completed lines are always decoded.
+  size_t incremental_min_new_samples = 0;
   // Terms to bias the decoder towards at runtime — jargon, product names,
   // proper nouns. No retraining is involved: each term is compiled into a
   // subword trie and used to nudge the logits during decoding (see
@@ -219,6 +281,9 @@ struct TranscriberOptions {
   // Maximum seconds of audio history fed to VBx per refresh. Zero means
   // unlimited. Default 120 bounds compute on long streaming sessions.
   float diarization_cluster_window_sec = 120.0f;
+  // Threads for diarization segmentation/embedding when transcribing a whole
+  // buffer without streaming. Zero means one per hardware thread.
+  int32_t diarization_threads = 1;
   std::string save_input_wav_path = "";
   bool log_ort_run = false;
   std::vector<std::string> ort_provider_names{};
@@ -228,6 +293,20 @@ struct TranscriberOptions {
   bool word_timestamps = false;
 };
 
+// Work done and avoided by options.incremental_decoding, summed over every
+// stream of a transcriber.
+struct TranscriberIncrementalDecodeStats {
+  // Updates of a line, whether decoded or not.
+  uint64_t pass_count = 0;
+  // Updates that kept the previous text because the segment grew too little.
+  uint64_t skipped_pass_count = 0;
+  // Decoder runs made by the updates that were decoded.
+  uint64_t decoder_run_count = 0;
+  // Draft tokens accepted. Each one is a decoder run that decoding from the
+  // start token would have needed on top of decoder_run_count.
+  uint64_t draft_tokens_accepted = 0;
+};
+
 class Transcriber {
  private:
   TranscriberOptions options;
@@ -235,11 +314,18 @@ class Transcriber {
   // Non-streaming model (used for TINY and BASE architectures)
   MoonshineModel *stt_model;
   std::mutex stt_model_mutex;
+  // Guarded by stt_model_mutex.
+  TranscriberIncrementalDecodeStats incremental_stats;
 
   // Streaming model (used for TINY_STREAMING and BASE_STREAMING architectures)
   MoonshineStreamingModel *streaming_model;
-  MoonshineStreamingState streaming_state;
   std::mutex streaming_model_mutex;
+  // Batches decoder steps across streams. Only created for a streaming model
+  // when options.decoder_batch_max_wait_ms is positive.
+  std::unique_ptr<MoonshineStreamingDecodeScheduler> decode_scheduler;
+  // Batches voice activity detection across streams. Only created when
+  // options.vad_batch_max_wait_ms is positive.
+  std::unique_ptr<VoiceActivityBatchScheduler> vad_scheduler;
 
   // Diarization engine shared across all streams; only constructed when
   // options.identify_speakers is true.
@@ -257,11 +343,9 @@ class Transcriber {
   // another thread while a stream is running.
   ContextBiaser context_biaser;
   std::mutex context_biaser_mutex;
-
-  // Track current segment for incremental processing
-  uint64_t current_streaming_segment_id = UINT64_MAX;
-  size_t streaming_samples_processed = 0;
-  std::vector<int> last_streaming_tokens;
+  // Bumped by every set_keyterms call, under context_biaser_mutex, so each
+  // stream can tell whether its speculative draft predates the current terms.
+  uint64_t keyterms_generation = 0;
 
   TranscriberStreamMap streams;
   int32_t next_stream_id;
@@ -314,9 +398,17 @@ class Transcriber {
                            uint64_t audio_length, int32_t sample_rate);
   void transcribe_stream(int32_t stream_id, uint32_t flags,
                          struct transcript_t **out_transcript);
-  // Reliability-test helper: bytes of PCM retained inside stream VAD segments.
+  // Reliability-test helper: bytes of PCM storage the stream's VAD holds for
+  // its segments, by capacity.
   size_t stream_vad_retained_audio_bytes(int32_t stream_id);
   size_t stream_vad_completed_audio_bytes(int32_t stream_id);
+  // Occupancy counters for cross-stream decoder batching. All zero when
+  // batching is off.
+  MoonshineDecodeBatchStats decoder_batch_stats();
+  // The same for cross-stream voice activity detection batching.
+  VoiceActivityBatchStats vad_batch_stats();
+  // Counters for options.incremental_decoding. All zero when it is off.
+  TranscriberIncrementalDecodeStats incremental_decode_stats();
   static std::string transcript_to_string(
       const struct transcript_t *transcript);
 
@@ -336,6 +428,10 @@ class Transcriber {
       const std::vector<SpeakerTurn> &turns, TranscriptStreamOutput *output);
 
  private:
+  // Counts *stream* in or out of the streams vad_scheduler waits for. Called
+  // with streams_mutex held; a no-op without a scheduler.
+  void set_vad_batch_active(TranscriberStream *stream, bool active);
+
   void update_transcript_from_segments(
       const std::vector<VoiceActivitySegment> &segments,
       TranscriberStream *stream, uint32_t flags,
@@ -359,10 +455,18 @@ class Transcriber {
   // ``word_timestamps`` option when the map carries an attention decoder.
   void load_from_memory_files(uint32_t model_arch);
 
-  std::string *transcribe_segment_with_streaming_model(const float *audio_data,
-                                                       size_t audio_length,
-                                                       uint64_t segment_id,
-                                                       bool is_final);
+  std::string *transcribe_segment_with_streaming_model(
+      TranscriberStream *stream, const float *audio_data, size_t audio_length,
+      uint64_t segment_id, bool is_final);
+
+  // Runs the non-streaming model over a segment, reusing the stream's
+  // previous decode when options.incremental_decoding is on. The text it
+  // returns is owned by the model or the stream. Caller holds stt_model_mutex.
+  int transcribe_segment_with_stt_model(TranscriberStream *stream,
+                                        const float *audio_data,
+                                        size_t audio_length,
+                                        uint64_t segment_id, bool is_final,
+                                        const char **out_text);
 };
 
 #endif
\ No newline at end of file
@@ -11,6 +11,12 @@
 //   * "reload" - repeatedly create and free the synthesizer handle. Catches
 //                leaks in model load / teardown and the handle table.
 //
+// A third phase, "concurrent", holds 1, 2, 4, ... synthesizers for the same
+// voice and synthesizes on all of them at once from separate threads. Handles
+// for the same model share one copy of its weights, so RSS should grow by
+// per-request state (G2P, scratch buffers) per extra handle, well short of
+// another copy of the model. RSS at each level is reported.
+//
 // TTS exposes no internal retained-byte accessor (unlike the transcriber's
 // stream_vad_completed_audio_bytes), so the signal here is process RSS: the
 // test samples resident memory after every iteration and fails on sustained,
@@ -28,6 +34,7 @@
 #include <doctest.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -36,6 +43,7 @@
 #include <functional>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "moonshine-c-api.h"
@@ -219,6 +227,7 @@ struct EngineSpec {
   const char *language;
   std::string voice;
   const char *root_key;  // "model_root" (Kokoro/Piper) or "g2p_root" (ZipVoice)
+  uintmax_t model_bytes;  // on-disk size of the model files
 };
 
 int32_t create_synth(const EngineSpec &spec) {
@@ -246,11 +255,13 @@ bool synth_once(int32_t handle, size_t text_index) {
   return ok;
 }
 
-bool reload_strict() {
-  const char *raw = std::getenv("MOONSHINE_TTS_MEMORY_RELOAD_STRICT");
+bool env_flag(const char *name) {
+  const char *raw = std::getenv(name);
   return raw != nullptr && raw[0] == '1' && raw[1] == '\0';
 }
 
+bool reload_strict() { return env_flag("MOONSHINE_TTS_MEMORY_RELOAD_STRICT"); }
+
 // Runs `iterations` of `body`, sampling RSS after each, and checks for
 // sustained post-warmup growth. Reports the regression summary either way for
 // context. When `advisory` is true a positive finding is logged but does not
@@ -292,6 +303,63 @@ void run_growth_phase(const std::string &label, size_t iterations,
                       label << " shows sustained RSS growth: " << report);
 }
 
+// Synthesizes on 1, 2, 4, ... handles at once (one thread each) and reports RSS
+// at every level. The handles share the model, so each one past the first
+// should cost far less than the weights themselves; a copy per handle shows up
+// as roughly `model_bytes` per extra handle, which fails the test. RSS also
+// carries per-handle G2P data and the ORT arenas' concurrent peak, so the bound
+// is a whole model rather than zero.
+void run_concurrency_phase(const EngineSpec &spec) {
+  const size_t max_handles =
+      env_size("MOONSHINE_TTS_MEMORY_CONCURRENT_HANDLES", 8);
+  const std::string label = std::string(spec.name) + " concurrent";
+  const size_t baseline_kb = read_rss_kb();
+  std::vector<int32_t> handles;
+  size_t single_kb = 0;
+  for (size_t n = 1; n <= max_handles; n *= 2) {
+    while (handles.size() < n) {
+      const int32_t handle = create_synth(spec);
+      REQUIRE_MESSAGE(handle >= 0, label << ": failed to create synthesizer");
+      handles.push_back(handle);
+    }
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> threads;
+    threads.reserve(n);
+    for (size_t t = 0; t < n; ++t) {
+      threads.emplace_back([&, t] {
+        if (!synth_once(handles[t], t)) {
+          ++failures;
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    REQUIRE_MESSAGE(failures.load() == 0,
+                    label << ": " << failures.load() << " of " << n
+                          << " concurrent syntheses failed");
+    const size_t rss_kb = read_rss_kb();
+    MESSAGE(label << ": " << n << " handles, rss=" << rss_kb << " KiB (+"
+                  << (rss_kb > baseline_kb ? rss_kb - baseline_kb : 0)
+                  << " KiB)");
+    if (n == 1) {
+      single_kb = rss_kb;
+      continue;
+    }
+    const size_t per_handle_kb =
+        (rss_kb > single_kb ? rss_kb - single_kb : 0) / (n - 1);
+    const size_t model_kb = static_cast<size_t>(spec.model_bytes / 1024);
+    MESSAGE(label << ": " << per_handle_kb << " KiB per extra handle (model "
+                  << model_kb << " KiB)");
+    const bool copies_model = model_kb > 0 && per_handle_kb >= model_kb;
+    CHECK_FALSE_MESSAGE(copies_model,
+                        label << ": each extra handle costs about a model");
+  }
+  for (const int32_t handle : handles) {
+    moonshine_free_tts_synthesizer(handle);
+  }
+}
+
 void exercise_engine(const EngineSpec &spec) {
   const size_t synth_iterations =
       env_size("MOONSHINE_TTS_MEMORY_SYNTH_ITERATIONS", 64);
@@ -335,6 +403,8 @@ void exercise_engine(const EngineSpec &spec) {
       /*min_positive_fraction=*/0.70,
       /*min_slope_kb_per_sample=*/512.0,
       /*advisory=*/true);
+
+  run_concurrency_phase(spec);
 }
 
 bool file_present(const fs::path &p) {
@@ -342,6 +412,12 @@ bool file_present(const fs::path &p) {
   return fs::is_regular_file(p, ec);
 }
 
+uintmax_t file_bytes(const fs::path &p) {
+  std::error_code ec;
+  const uintmax_t size = fs::file_size(p, ec);
+  return ec ? 0 : size;
+}
+
 std::optional<EngineSpec> kokoro_spec() {
   const fs::path kokoro = g_data_root / "kokoro";
   const bool model = file_present(kokoro / "model.ort");
@@ -349,7 +425,8 @@ std::optional<EngineSpec> kokoro_spec() {
   if (!model || !voice) {
     return std::nullopt;
   }
-  return EngineSpec{"kokoro", "en_us", "kokoro_af_heart", "model_root"};
+  return EngineSpec{"kokoro", "en_us", "kokoro_af_heart", "model_root",
+                    file_bytes(kokoro / "model.ort")};
 }
 
 std::optional<EngineSpec> piper_spec() {
@@ -389,7 +466,12 @@ std::optional<EngineSpec> piper_spec() {
   if (chosen.empty()) {
     return std::nullopt;
   }
-  return EngineSpec{"piper", "en_us", "piper_" + chosen, "model_root"};
+  const uintmax_t model_bytes =
+      file_bytes(voices / (chosen + ".model.ort")) +
+      file_bytes(voices / (chosen + ".weights.ort")) +
+      file_bytes(voices / (chosen + ".ort"));
+  return EngineSpec{"piper", "en_us", "piper_" + chosen, "model_root",
+                    model_bytes};
 }
 
 std::optional<EngineSpec> zipvoice_spec() {
@@ -402,7 +484,10 @@ std::optional<EngineSpec> zipvoice_spec() {
     return std::nullopt;
   }
   return EngineSpec{"zipvoice", "en_us", "zipvoice_american_female",
-                    "g2p_root"};
+                    "g2p_root",
+                    file_bytes(zv / "text_encoder.ort") +
+                        file_bytes(zv / "fm_decoder.ort") +
+                        file_bytes(zv / "vocoder.ort")};
 }
 
 }  // namespace
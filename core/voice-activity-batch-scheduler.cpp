@@ -0,0 +1,101 @@
+#include "voice-activity-batch-scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+VoiceActivityBatchScheduler::VoiceActivityBatchScheduler(float max_wait_ms,
+                                                         int max_batch_size)
+    : VoiceActivityBatchScheduler(VoiceActivityDetector::process_audio_batch,
+                                  max_wait_ms, max_batch_size) {}
+
+VoiceActivityBatchScheduler::VoiceActivityBatchScheduler(BatchRunner run,
+                                                         float max_wait_ms,
+                                                         int max_batch_size)
+    : run(std::move(run)),
+      max_wait(static_cast<int64_t>(std::max(0.0f, max_wait_ms) * 1000.0f)),
+      max_batch_size(static_cast<size_t>(std::max(1, max_batch_size))) {}
+
+void VoiceActivityBatchScheduler::process_audio(VoiceActivityDetector *detector,
+                                                const float *audio_data,
+                                                size_t audio_data_size,
+                                                int32_t sample_rate) {
+  Request request{detector, audio_data, audio_data_size, sample_rate};
+  std::unique_lock<std::mutex> lock(mutex);
+  pending.push_back(&request);
+  changed.notify_all();
+  while (!request.done) {
+    if (!leader_running) {
+      leader_running = true;
+      run_batch(lock);
+      leader_running = false;
+      changed.notify_all();
+    } else {
+      changed.wait(lock, [&] { return request.done || !leader_running; });
+    }
+  }
+  lock.unlock();
+  if (request.error) {
+    std::rethrow_exception(request.error);
+  }
+}
+
+void VoiceActivityBatchScheduler::run_batch(
+    std::unique_lock<std::mutex> &lock) {
+  const auto deadline = std::chrono::steady_clock::now() + max_wait;
+  changed.wait_until(lock, deadline, [&] {
+    const size_t expected = static_cast<size_t>(std::max(1, active_streams));
+    return pending.size() >= std::min(expected, max_batch_size);
+  });
+
+  // Oldest first, so a call that missed a full batch goes in the next one.
+  const size_t count = std::min(pending.size(), max_batch_size);
+  std::vector<Request *> batch(pending.begin(), pending.begin() + count);
+  pending.erase(pending.begin(), pending.begin() + count);
+
+  std::vector<VoiceActivityDetector *> detectors(count);
+  std::vector<const float *> audio(count);
+  std::vector<size_t> sizes(count);
+  std::vector<int32_t> sample_rates(count);
+  for (size_t i = 0; i < count; ++i) {
+    detectors[i] = batch[i]->detector;
+    audio[i] = batch[i]->audio_data;
+    sizes[i] = batch[i]->audio_data_size;
+    sample_rates[i] = batch[i]->sample_rate;
+  }
+
+  lock.unlock();
+  std::exception_ptr error;
+  try {
+    run(detectors.data(), audio.data(), sizes.data(), sample_rates.data(),
+        count);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  lock.lock();
+
+  for (Request *request : batch) {
+    request->error = error;
+    request->done = true;
+  }
+  batch_stats.batch_count++;
+  batch_stats.call_count += count;
+  batch_stats.max_batch_size =
+      std::max(batch_stats.max_batch_size, static_cast<int>(count));
+}
+
+void VoiceActivityBatchScheduler::begin_stream() {
+  std::lock_guard<std::mutex> lock(mutex);
+  active_streams++;
+}
+
+void VoiceActivityBatchScheduler::end_stream() {
+  std::lock_guard<std::mutex> lock(mutex);
+  active_streams--;
+  // A leader may be waiting on this stream's audio, which won't come.
+  changed.notify_all();
+}
+
+VoiceActivityBatchStats VoiceActivityBatchScheduler::stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return batch_stats;
+}
@@ -0,0 +1,86 @@
+#ifndef VOICE_ACTIVITY_BATCH_SCHEDULER_H
+#define VOICE_ACTIVITY_BATCH_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "voice-activity-detector.h"
+
+// Occupancy counters for VoiceActivityBatchScheduler. The mean batch size is
+// call_count / batch_count.
+struct VoiceActivityBatchStats {
+  uint64_t batch_count = 0;  // process_audio_batch calls issued
+  uint64_t call_count = 0;   // process_audio calls across all of them
+  int max_batch_size = 0;    // largest batch seen so far
+};
+
+// Combines process_audio calls on the detectors of different streams into
+// VoiceActivityDetector::process_audio_batch calls, so their hops share
+// Silero runs.
+//
+// Works like MoonshineStreamingDecodeScheduler: streams feed audio on their
+// own threads, there is no scheduler thread, and the first caller to find
+// nobody collecting becomes the leader. It waits up to ``max_wait_ms`` for
+// the other active streams to queue their audio, runs up to
+// ``max_batch_size`` calls in one batch, and wakes their owners. The wait
+// ends early once every active stream has audio queued.
+class VoiceActivityBatchScheduler {
+ public:
+  // Runs one batch; same contract as
+  // VoiceActivityDetector::process_audio_batch.
+  using BatchRunner = std::function<void(
+      VoiceActivityDetector *const *, const float *const *, const size_t *,
+      const int32_t *, size_t)>;
+
+  VoiceActivityBatchScheduler(float max_wait_ms, int max_batch_size);
+  // Runs batches through ``run`` instead, so a test can watch them.
+  VoiceActivityBatchScheduler(BatchRunner run, float max_wait_ms,
+                              int max_batch_size);
+
+  // Same contract as VoiceActivityDetector::process_audio. Blocks until the
+  // batch holding this call has run, and rethrows anything the batch threw.
+  // ``detector`` must not be used by anyone else until it returns.
+  void process_audio(VoiceActivityDetector *detector, const float *audio_data,
+                     size_t audio_data_size, int32_t sample_rate);
+
+  // Brackets the time a stream is expected to feed audio (from its start to
+  // its stop), so the leader knows how many calls are worth waiting for.
+  void begin_stream();
+  void end_stream();
+
+  VoiceActivityBatchStats stats();
+
+ private:
+  struct Request {
+    VoiceActivityDetector *detector;
+    const float *audio_data;
+    size_t audio_data_size;
+    int32_t sample_rate;
+    bool done = false;
+    // What the batch threw, rethrown on the request's own thread.
+    std::exception_ptr error = nullptr;
+  };
+
+  // Collects and runs one batch. Called by the leader with ``lock`` held;
+  // drops it around the batch.
+  void run_batch(std::unique_lock<std::mutex> &lock);
+
+  BatchRunner run;
+  std::chrono::microseconds max_wait;
+  size_t max_batch_size;
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<Request *> pending;
+  bool leader_running = false;
+  int active_streams = 0;
+  VoiceActivityBatchStats batch_stats;
+};
+
+#endif
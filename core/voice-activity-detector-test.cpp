@@ -1,9 +1,15 @@
 #include "voice-activity-detector.h"
 
+#include <algorithm>
 #include <filesystem>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "debug-utils.h"
+#include "voice-activity-batch-scheduler.h"
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest.h>
@@ -161,4 +167,255 @@ TEST_CASE("voice-activity-detector-test") {
          segment.end_time);
     LOGF("Segments count: %zu", segments->size());
   }
+  SUBCASE("vad-batch") {
+    // Streams run through process_audio_batch must come out exactly as they
+    // would on their own, however their chunks line up.
+    const std::vector<std::string> wav_paths = {
+        "two_cities.wav", "beckett.wav", "two_cities.wav"};
+    const std::vector<float> thresholds = {0.5f, 0.5f, 0.0f};
+    const std::vector<float> chunk_durations = {0.1f, 0.25f, 0.3f};
+    const size_t stream_count = wav_paths.size();
+    std::vector<float *> wavs(stream_count, nullptr);
+    std::vector<size_t> wav_sizes(stream_count, 0);
+    std::vector<int32_t> sample_rates(stream_count, 0);
+    std::vector<size_t> chunk_sizes(stream_count, 0);
+    for (size_t s = 0; s < stream_count; s++) {
+      REQUIRE(std::filesystem::exists(wav_paths[s]));
+      REQUIRE(load_wav_data(wav_paths[s].c_str(), &wavs[s], &wav_sizes[s],
+                            &sample_rates[s]));
+      chunk_sizes[s] = (size_t)(chunk_durations[s] * sample_rates[s]);
+    }
+
+    // Segment audio belongs to its detector, so keep a copy of each.
+    std::vector<std::vector<VoiceActivitySegment>> expected(stream_count);
+    std::vector<std::vector<std::vector<float>>> expected_audio(stream_count);
+    for (size_t s = 0; s < stream_count; s++) {
+      VoiceActivityDetector vad(thresholds[s]);
+      vad.start();
+      for (size_t i = 0; i < wav_sizes[s]; i += chunk_sizes[s]) {
+        const size_t chunk_size = std::min(chunk_sizes[s], wav_sizes[s] - i);
+        vad.process_audio(wavs[s] + i, chunk_size, sample_rates[s]);
+      }
+      vad.stop();
+      expected[s] = *vad.get_segments();
+      REQUIRE(expected[s].size() >= 1);
+      for (const VoiceActivitySegment &segment : expected[s]) {
+        expected_audio[s].emplace_back(segment.audio_data.begin(),
+                                       segment.audio_data.end());
+      }
+    }
+
+    std::vector<VoiceActivityDetector> vads;
+    vads.reserve(stream_count);
+    std::vector<VoiceActivityDetector *> vad_pointers;
+    for (size_t s = 0; s < stream_count; s++) {
+      vads.emplace_back(thresholds[s]);
+      vad_pointers.push_back(&vads.back());
+      vads.back().start();
+    }
+    std::vector<size_t> offsets(stream_count, 0);
+    std::vector<const float *> chunks(stream_count);
+    std::vector<size_t> sizes(stream_count);
+    bool any_left = true;
+    while (any_left) {
+      any_left = false;
+      for (size_t s = 0; s < stream_count; s++) {
+        sizes[s] = std::min(chunk_sizes[s], wav_sizes[s] - offsets[s]);
+        chunks[s] = wavs[s] + offsets[s];
+        offsets[s] += sizes[s];
+        any_left = any_left || offsets[s] < wav_sizes[s];
+      }
+      VoiceActivityDetector::process_audio_batch(
+          vad_pointers.data(), chunks.data(), sizes.data(),
+          sample_rates.data(), stream_count);
+    }
+    for (size_t s = 0; s < stream_count; s++) {
+      vads[s].stop();
+      const std::vector<VoiceActivitySegment> &actual =
+          *vads[s].get_segments();
+      REQUIRE(actual.size() == expected[s].size());
+      for (size_t j = 0; j < actual.size(); j++) {
+        CHECK(actual[j].start_time == expected[s][j].start_time);
+        CHECK(actual[j].end_time == expected[s][j].end_time);
+        CHECK(actual[j].is_complete == expected[s][j].is_complete);
+        CHECK(std::vector<float>(actual[j].audio_data.begin(),
+                                 actual[j].audio_data.end()) ==
+              expected_audio[s][j]);
+      }
+    }
+  }
+  SUBCASE("vad-batch-scheduler") {
+    // Streams fed from their own threads, as the transcriber's are, meet in
+    // the scheduler and come out exactly as they would on their own.
+    const std::vector<std::string> wav_paths = {
+        "two_cities.wav", "beckett.wav", "two_cities.wav", "beckett.wav"};
+    const std::vector<float> chunk_durations = {0.1f, 0.25f, 0.3f, 0.1f};
+    const size_t stream_count = wav_paths.size();
+    std::vector<float *> wavs(stream_count, nullptr);
+    std::vector<size_t> wav_sizes(stream_count, 0);
+    std::vector<int32_t> sample_rates(stream_count, 0);
+    std::vector<size_t> chunk_sizes(stream_count, 0);
+    size_t total_calls = 0;
+    for (size_t s = 0; s < stream_count; s++) {
+      REQUIRE(std::filesystem::exists(wav_paths[s]));
+      REQUIRE(load_wav_data(wav_paths[s].c_str(), &wavs[s], &wav_sizes[s],
+                            &sample_rates[s]));
+      chunk_sizes[s] = (size_t)(chunk_durations[s] * sample_rates[s]);
+      total_calls += (wav_sizes[s] + chunk_sizes[s] - 1) / chunk_sizes[s];
+    }
+
+    std::vector<std::vector<VoiceActivitySegment>> expected(stream_count);
+    std::vector<std::vector<std::vector<float>>> expected_audio(stream_count);
+    for (size_t s = 0; s < stream_count; s++) {
+      VoiceActivityDetector vad;
+      vad.start();
+      for (size_t i = 0; i < wav_sizes[s]; i += chunk_sizes[s]) {
+        const size_t chunk_size = std::min(chunk_sizes[s], wav_sizes[s] - i);
+        vad.process_audio(wavs[s] + i, chunk_size, sample_rates[s]);
+      }
+      vad.stop();
+      expected[s] = *vad.get_segments();
+      REQUIRE(expected[s].size() >= 1);
+      for (const VoiceActivitySegment &segment : expected[s]) {
+        expected_audio[s].emplace_back(segment.audio_data.begin(),
+                                       segment.audio_data.end());
+      }
+    }
+
+    std::mutex batch_sizes_mutex;
+    std::vector<size_t> batch_sizes;
+    // The wait only ends on its deadline if a call never arrives, which would
+    // be a bug; it is long so a slow machine can't split a batch.
+    VoiceActivityBatchScheduler scheduler(
+        [&](VoiceActivityDetector *const *detectors,
+            const float *const *audio_data, const size_t *sizes,
+            const int32_t *rates, size_t count) {
+          VoiceActivityDetector::process_audio_batch(detectors, audio_data,
+                                                     sizes, rates, count);
+          std::lock_guard<std::mutex> lock(batch_sizes_mutex);
+          batch_sizes.push_back(count);
+        },
+        10000.0f, (int)stream_count);
+    std::vector<VoiceActivityDetector> vads(stream_count);
+    for (size_t s = 0; s < stream_count; s++) {
+      vads[s].start();
+      scheduler.begin_stream();
+    }
+    std::vector<std::thread> workers;
+    for (size_t s = 0; s < stream_count; s++) {
+      workers.emplace_back([&, s] {
+        for (size_t i = 0; i < wav_sizes[s]; i += chunk_sizes[s]) {
+          const size_t chunk_size =
+              std::min(chunk_sizes[s], wav_sizes[s] - i);
+          scheduler.process_audio(&vads[s], wavs[s] + i, chunk_size,
+                                  sample_rates[s]);
+        }
+        scheduler.end_stream();
+      });
+    }
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+
+    for (size_t s = 0; s < stream_count; s++) {
+      CAPTURE(s);
+      vads[s].stop();
+      const std::vector<VoiceActivitySegment> &actual =
+          *vads[s].get_segments();
+      REQUIRE(actual.size() == expected[s].size());
+      for (size_t j = 0; j < actual.size(); j++) {
+        CHECK(actual[j].start_time == expected[s][j].start_time);
+        CHECK(actual[j].end_time == expected[s][j].end_time);
+        CHECK(std::vector<float>(actual[j].audio_data.begin(),
+                                 actual[j].audio_data.end()) ==
+              expected_audio[s][j]);
+      }
+    }
+    // Until the first stream runs out of audio every batch holds a call from
+    // each stream.
+    const VoiceActivityBatchStats stats = scheduler.stats();
+    CHECK(stats.call_count == total_calls);
+    CHECK(stats.batch_count == batch_sizes.size());
+    CHECK(stats.max_batch_size == (int)stream_count);
+    REQUIRE_FALSE(batch_sizes.empty());
+    CHECK(batch_sizes.front() == stream_count);
+    CHECK(stats.batch_count < stats.call_count);
+  }
+  SUBCASE("vad-retained-audio-is-bounded") {
+    // Releasing completed segments after every call, as the transcriber does,
+    // leaves the detector holding one arena for the segment in progress,
+    // without changing what it detects. Kept segments hold their audio at its
+    // exact length rather than in a maximum-length reservation each.
+    std::string wav_path = "two_cities.wav";
+    REQUIRE(std::filesystem::exists(wav_path));
+    float *wav_data = nullptr;
+    size_t wav_data_size = 0;
+    int32_t wav_sample_rate = 0;
+    REQUIRE(load_wav_data(wav_path.c_str(), &wav_data, &wav_data_size,
+                          &wav_sample_rate));
+    const size_t chunk_size = (size_t)(0.5f * wav_sample_rate);
+
+    VoiceActivityDetector reference_vad;
+    VoiceActivityDetector vad;
+    reference_vad.start();
+    vad.start();
+    // The longest a segment's audio can be with the default settings:
+    // look-behind, the maximum segment and the hop that ends it.
+    const size_t longest_segment_bytes =
+        (4096 + 15 * 16000 + 512) * sizeof(float);
+    size_t max_retained = 0;
+    // Loop the clip so there are plenty of segments to release.
+    const int loop_count = 3;
+    for (int loop = 0; loop < loop_count; loop++) {
+      for (size_t i = 0; i < wav_data_size; i += chunk_size) {
+        const size_t this_chunk = std::min(chunk_size, wav_data_size - i);
+        reference_vad.process_audio(wav_data + i, this_chunk, wav_sample_rate);
+        vad.process_audio(wav_data + i, this_chunk, wav_sample_rate);
+        for (const VoiceActivitySegment &segment : *vad.get_segments()) {
+          if (segment.just_updated) {
+            REQUIRE(!segment.audio_data.empty());
+          }
+        }
+        max_retained =
+            std::max(max_retained, vad.retained_segment_audio_byte_count());
+        vad.clear_completed_segment_audio_data();
+        REQUIRE(vad.completed_segment_audio_byte_count() == 0);
+      }
+    }
+    reference_vad.stop();
+    vad.stop();
+    free(wav_data);
+
+    const std::vector<VoiceActivitySegment> &reference =
+        *reference_vad.get_segments();
+    const std::vector<VoiceActivitySegment> &actual = *vad.get_segments();
+    REQUIRE(reference.size() > 3);
+    REQUIRE(actual.size() == reference.size());
+    size_t reference_audio_bytes = 0;
+    for (size_t j = 0; j < actual.size(); j++) {
+      CHECK(actual[j].start_time == reference[j].start_time);
+      CHECK(actual[j].end_time == reference[j].end_time);
+      reference_audio_bytes += reference[j].audio_data.size() * sizeof(float);
+    }
+    LOGF("Retained segment audio: at most %zu bytes with clearing, %zu "
+         "without, for %zu segments",
+         max_retained, reference_vad.retained_segment_audio_byte_count(),
+         actual.size());
+    // One arena and at most one completed segment between clears.
+    CHECK(max_retained <= 2 * longest_segment_bytes);
+    // Without clearing, the segments' audio plus the one arena.
+    CHECK(reference_vad.retained_segment_audio_byte_count() <=
+          reference_audio_bytes + longest_segment_bytes);
+  }
+}
+
+TEST_CASE("vad-batch-scheduler-rethrows-batch-errors") {
+  VoiceActivityBatchScheduler scheduler(
+      [](VoiceActivityDetector *const *, const float *const *, const size_t *,
+         const int32_t *, size_t) { throw std::runtime_error("resampler"); },
+      0.0f, 4);
+  const float audio[1] = {0.0f};
+  CHECK_THROWS_WITH(scheduler.process_audio(nullptr, audio, 1, 16000),
+                    "resampler");
+  CHECK(scheduler.stats().batch_count == 1);
 }
@@ -1,7 +1,7 @@
 #include "voice-activity-detector.h"
 
+#include <algorithm>
 #include <cassert>
-#include <mutex>
 #include <numeric>
 
 #include "debug-utils.h"
@@ -9,8 +9,9 @@
 
 namespace {
 constexpr int32_t vad_sample_rate = 16000;
-
-std::mutex vad_mutex;
+// Initial arena size, after the look-behind. Most utterances fit, and longer
+// segments grow the arena rather than every stream paying for the longest.
+constexpr size_t expected_segment_sample_count = 5 * vad_sample_rate;
 
 float seconds_from_sample_count(size_t sample_count) {
   return static_cast<float>(sample_count) / vad_sample_rate;
@@ -38,11 +39,15 @@ VoiceActivityDetector::VoiceActivityDetector(float threshold,
 
   probability_window.resize(window_size);
   probability_window_index = 0;
-  current_segment_audio_buffer.resize(0);
   look_behind_audio_buffer.resize(look_behind_sample_count);
-  processing_remainder_audio_buffer.resize(0);
+  look_behind_write_index = 0;
+  processing_remainder_audio_buffer.reserve(hop_size);
+  queued_audio = nullptr;
+  queued_audio_size = 0;
+  first_hop.resize(hop_size);
   previous_is_voice = false;
   _is_active = false;
+  padded_hop.resize(silero_vad->window_size(), 0.0f);
 }
 
 VoiceActivityDetector::~VoiceActivityDetector() {}
@@ -51,12 +56,14 @@ void VoiceActivityDetector::start() {
   _is_active = true;
   samples_processed_count = 0;
   segments.clear();
-  current_segment_audio_buffer.resize(0);
-  look_behind_audio_buffer.resize(look_behind_sample_count, 0.0f);
-  processing_remainder_audio_buffer.resize(0);
+  segment_audio_buffers.clear();
+  segment_arena.clear();
+  look_behind_write_index = 0;
+  processing_remainder_audio_buffer.clear();
   probability_window.resize(window_size, 0.0f);
   probability_window_index = 0;
   previous_is_voice = false;
+  vad_state.reset();
 }
 
 void VoiceActivityDetector::stop() {
@@ -69,45 +76,187 @@ void VoiceActivityDetector::stop() {
 void VoiceActivityDetector::process_audio(const float *audio_data,
                                           size_t audio_data_size,
                                           int32_t sample_rate) {
+  VoiceActivityDetector *detector = this;
+  process_audio_batch(&detector, &audio_data, &audio_data_size, &sample_rate,
+                      1);
+}
+
+void VoiceActivityDetector::process_audio_batch(
+    VoiceActivityDetector *const *detectors, const float *const *audio_data,
+    const size_t *audio_data_sizes, const int32_t *sample_rates,
+    size_t count) {
+  std::vector<size_t> hop_counts(count);
+  size_t max_hop_count = 0;
+  for (size_t i = 0; i < count; ++i) {
+    hop_counts[i] = detectors[i]->queue_audio(
+        audio_data[i], audio_data_sizes[i], sample_rates[i]);
+    max_hop_count = std::max(max_hop_count, hop_counts[i]);
+  }
+
+  // Each detector's hops depend on the state left by its previous one, so
+  // the batches go across detectors: batch n holds hop n of every detector
+  // that has one and needs the model.
+  std::vector<size_t> rows;  // detector index of each batch row
+  std::vector<SileroVadState *> states;
+  std::vector<const float *> chunks;
+  std::vector<float> probabilities;
+  std::vector<float> detector_probabilities(count);
+  for (size_t hop = 0; hop < max_hop_count; ++hop) {
+    rows.clear();
+    states.clear();
+    chunks.clear();
+    for (size_t i = 0; i < count; ++i) {
+      VoiceActivityDetector *detector = detectors[i];
+      detector_probabilities[i] = 0.0f;
+      if (hop < hop_counts[i] && detector->threshold > 0.0f) {
+        rows.push_back(i);
+        states.push_back(&detector->vad_state);
+        chunks.push_back(detector->model_input_for_hop(hop));
+      }
+    }
+    probabilities.assign(rows.size(), 0.0f);
+    if (!rows.empty() &&
+        silero_vad->predict_batch(states.data(), chunks.data(),
+                                  probabilities.data(),
+                                  static_cast<int>(rows.size())) != 0) {
+      // A failed inference counts as silence, as it always has.
+      std::fill(probabilities.begin(), probabilities.end(), 0.0f);
+    }
+    for (size_t row = 0; row < rows.size(); ++row) {
+      detector_probabilities[rows[row]] = probabilities[row];
+    }
+    for (size_t i = 0; i < count; ++i) {
+      if (hop < hop_counts[i]) {
+        VoiceActivityDetector *detector = detectors[i];
+        detector->process_audio_chunk(detector->queued_hop(hop),
+                                      detector->hop_size,
+                                      detector_probabilities[i]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    detectors[i]->finish_queued_audio(hop_counts[i]);
+  }
+}
+
+size_t VoiceActivityDetector::queue_audio(const float *audio_data,
+                                          size_t audio_data_size,
+                                          int32_t sample_rate) {
+  queued_audio = nullptr;
+  queued_audio_size = 0;
   if (!_is_active) {
-    return;
+    return 0;
   }
 
   for (VoiceActivitySegment &segment : segments) {
     segment.just_updated = false;
   }
-  std::vector<float> input_audio_vector(audio_data,
-                                        audio_data + audio_data_size);
-  // The detection model expects 16000 Hz audio.
-  const std::vector<float> resampled_audio_vector =
-      resample_audio(input_audio_vector, sample_rate, vad_sample_rate);
+  if (sample_rate == vad_sample_rate) {
+    queued_audio = audio_data;
+    queued_audio_size = audio_data_size;
+  } else {
+    // The detection model expects 16000 Hz audio.
+    std::vector<float> input_audio_vector(audio_data,
+                                          audio_data + audio_data_size);
+    resampled_audio =
+        resample_audio(input_audio_vector, sample_rate, vad_sample_rate);
+    queued_audio = resampled_audio.data();
+    queued_audio_size = resampled_audio.size();
+  }
+
+  const size_t remainder_size = processing_remainder_audio_buffer.size();
+  const size_t hop_count = (remainder_size + queued_audio_size) / hop_size;
+  if (remainder_size > 0 && hop_count > 0) {
+    // The leftover samples and the start of the new audio make up the first
+    // hop; every later one is read in place.
+    std::copy(processing_remainder_audio_buffer.begin(),
+              processing_remainder_audio_buffer.end(), first_hop.begin());
+    std::copy(queued_audio, queued_audio + (hop_size - remainder_size),
+              first_hop.begin() + remainder_size);
+  }
+  return hop_count;
+}
+
+const float *VoiceActivityDetector::queued_hop(size_t hop_index) const {
+  const size_t remainder_size = processing_remainder_audio_buffer.size();
+  if (remainder_size == 0) {
+    return queued_audio + hop_index * hop_size;
+  }
+  if (hop_index == 0) {
+    return first_hop.data();
+  }
+  return queued_audio + (hop_size - remainder_size) +
+         (hop_index - 1) * hop_size;
+}
+
+const float *VoiceActivityDetector::model_input_for_hop(size_t hop_index) {
+  const float *hop_data = queued_hop(hop_index);
+  if (padded_hop.size() == static_cast<size_t>(hop_size)) {
+    return hop_data;
+  }
+  const size_t copy_size = std::min(padded_hop.size(), (size_t)hop_size);
+  std::fill(std::copy(hop_data, hop_data + copy_size, padded_hop.begin()),
+            padded_hop.end(), 0.0f);
+  return padded_hop.data();
+}
+
+void VoiceActivityDetector::finish_queued_audio(size_t hop_count) {
+  if (hop_count == 0) {
+    // Still short of a hop, so everything fits in the remainder.
+    processing_remainder_audio_buffer.insert(
+        processing_remainder_audio_buffer.end(), queued_audio,
+        queued_audio + queued_audio_size);
+  } else {
+    const size_t used_sample_count =
+        hop_count * hop_size - processing_remainder_audio_buffer.size();
+    processing_remainder_audio_buffer.assign(queued_audio + used_sample_count,
+                                             queued_audio + queued_audio_size);
+  }
+  queued_audio = nullptr;
+  queued_audio_size = 0;
+}
 
-  std::vector<float> processing_buffer = processing_remainder_audio_buffer;
-  processing_buffer.insert(processing_buffer.end(),
-                           resampled_audio_vector.begin(),
-                           resampled_audio_vector.end());
-  while (processing_buffer.size() >= (size_t)(hop_size)) {
-    const float *audio_data = processing_buffer.data();
-    size_t audio_data_size = hop_size;
-    process_audio_chunk(audio_data, audio_data_size);
-    processing_buffer.erase(processing_buffer.begin(),
-                            processing_buffer.begin() + hop_size);
+void VoiceActivityDetector::start_segment_audio_buffer() {
+  segment_audio_buffers.emplace_back();
+  segment_arena.clear();
+  if (segment_arena.capacity() == 0) {
+    segment_arena.reserve(look_behind_sample_count +
+                          expected_segment_sample_count + hop_size);
   }
-  processing_remainder_audio_buffer = processing_buffer;
+}
+
+void VoiceActivityDetector::append_to_segment_audio(const float *audio_data,
+                                                    size_t size) {
+  const size_t needed = segment_arena.size() + size;
+  if (needed > segment_arena.capacity()) {
+    // Double, but no further than the longest segment the fade allows, so a
+    // long segment doesn't leave the arena at nearly twice that.
+    size_t capacity = std::max(needed, segment_arena.capacity() * 2);
+    if (max_segment_sample_count > 0) {
+      const size_t longest =
+          look_behind_sample_count + max_segment_sample_count + hop_size;
+      capacity = std::max(needed, std::min(capacity, longest));
+    }
+    segment_arena.reserve(capacity);
+  }
+  segment_arena.insert(segment_arena.end(), audio_data, audio_data + size);
 }
 
 void VoiceActivityDetector::clear_completed_segment_audio_data() {
-  for (VoiceActivitySegment &segment : segments) {
+  for (size_t i = 0; i < segments.size(); i++) {
+    VoiceActivitySegment &segment = segments[i];
     if (segment.is_complete && !segment.audio_data.empty()) {
-      std::vector<float>().swap(segment.audio_data);
+      std::vector<float>().swap(segment_audio_buffers[i]);
+      segment.audio_data = {};
     }
   }
 }
 
 size_t VoiceActivityDetector::retained_segment_audio_byte_count() const {
-  size_t total_samples = 0;
-  for (const VoiceActivitySegment &segment : segments) {
-    total_samples += segment.audio_data.size();
+  size_t total_samples = segment_arena.capacity();
+  for (const std::vector<float> &buffer : segment_audio_buffers) {
+    total_samples += buffer.capacity();
   }
   return total_samples * sizeof(float);
 }
@@ -123,26 +272,23 @@ size_t VoiceActivityDetector::completed_segment_audio_byte_count() const {
 }
 
 void VoiceActivityDetector::process_audio_chunk(const float *audio_data,
-                                                size_t audio_data_size) {
+                                                size_t audio_data_size,
+                                                float current_probability) {
   assert(audio_data_size == (size_t)(hop_size));
   samples_processed_count += audio_data_size;
-  // Remove the oldest samples from look_behind_buffer and add the new samples
-  // at the end.
-  std::move(look_behind_audio_buffer.begin() + audio_data_size,
-            look_behind_audio_buffer.end(), look_behind_audio_buffer.begin());
-  std::copy(audio_data, audio_data + audio_data_size,
-            look_behind_audio_buffer.end() - audio_data_size);
-
-  std::vector<float> audio_vec(audio_data, audio_data + audio_data_size);
+  // Overwrite the oldest samples in the look-behind ring with the new ones.
+  const size_t look_behind_capacity = look_behind_audio_buffer.size();
+  const size_t look_behind_new_count =
+      std::min(audio_data_size, look_behind_capacity);
+  for (size_t i = audio_data_size - look_behind_new_count; i < audio_data_size;
+       i++) {
+    look_behind_audio_buffer[look_behind_write_index] = audio_data[i];
+    look_behind_write_index =
+        (look_behind_write_index + 1) % look_behind_capacity;
+  }
 
   float smoothed_probability = 0.0f;
   if (threshold > 0.0f) {
-    float current_probability = 0.0f;
-    {
-      std::lock_guard<std::mutex> lock(vad_mutex);
-      int current_flag;
-      silero_vad->predict(audio_vec, &current_probability, &current_flag);
-    }
     probability_window[probability_window_index] = current_probability;
     probability_window_index =
         (probability_window_index + 1) % probability_window.size();
@@ -159,11 +305,10 @@ void VoiceActivityDetector::process_audio_chunk(const float *audio_data,
   // score so that it reaches 0 at the max_segment_sample_count, and so ensures
   // that the voice end event is triggered.
   const size_t fade_sample_count = (max_segment_sample_count * 2) / 3;
-  if (max_segment_sample_count &&
-      (current_segment_audio_buffer.size() > fade_sample_count)) {
+  const size_t current_segment_size = current_segment_sample_count();
+  if (max_segment_sample_count && (current_segment_size > fade_sample_count)) {
     const float fade_factor =
-        static_cast<float>(current_segment_audio_buffer.size() -
-                           fade_sample_count) /
+        static_cast<float>(current_segment_size - fade_sample_count) /
         fade_sample_count;
     smoothed_probability = smoothed_probability * fade_factor;
   }
@@ -172,22 +317,25 @@ void VoiceActivityDetector::process_audio_chunk(const float *audio_data,
     // Make sure we don't "look back" to before the start of the stream.
     const size_t look_behind_size =
         std::min(look_behind_sample_count, samples_processed_count);
-    current_segment_audio_buffer = std::vector<float>(
-        look_behind_audio_buffer.begin() +
-            (look_behind_audio_buffer.size() - look_behind_size),
-        look_behind_audio_buffer.end());
+    start_segment_audio_buffer();
+    // The newest look_behind_size samples, oldest first, which may wrap
+    // around the end of the ring.
+    const size_t look_behind_capacity = look_behind_audio_buffer.size();
+    const size_t look_behind_start =
+        (look_behind_write_index + look_behind_capacity - look_behind_size) %
+        std::max<size_t>(look_behind_capacity, 1);
+    const size_t first_part_size =
+        std::min(look_behind_size, look_behind_capacity - look_behind_start);
+    append_to_segment_audio(look_behind_audio_buffer.data() + look_behind_start,
+                            first_part_size);
+    append_to_segment_audio(look_behind_audio_buffer.data(),
+                            look_behind_size - first_part_size);
     on_voice_start();
   } else if (!current_is_voice && previous_is_voice) {
-    current_segment_audio_buffer.insert(current_segment_audio_buffer.end(),
-                                        audio_data,
-                                        audio_data + audio_data_size);
+    append_to_segment_audio(audio_data, audio_data_size);
     on_voice_end();
-    current_segment_audio_buffer.resize(0);
-    look_behind_audio_buffer.resize(look_behind_sample_count, 0.0f);
   } else if (current_is_voice && previous_is_voice) {
-    current_segment_audio_buffer.insert(current_segment_audio_buffer.end(),
-                                        audio_data,
-                                        audio_data + audio_data_size);
+    append_to_segment_audio(audio_data, audio_data_size);
     on_voice_continuing();
   }
   previous_is_voice = current_is_voice;
@@ -199,8 +347,8 @@ void VoiceActivityDetector::on_voice_start() {
   const float current_time = seconds_from_sample_count(samples_processed_count);
   const float segment_start_time =
       current_time -
-      seconds_from_sample_count(current_segment_audio_buffer.size());
-  segment->audio_data = current_segment_audio_buffer;
+      seconds_from_sample_count(segment_arena.size());
+  segment->audio_data = segment_arena;
   segment->start_time = segment_start_time;
   segment->end_time = current_time;
   segment->is_complete = false;
@@ -210,7 +358,7 @@ void VoiceActivityDetector::on_voice_start() {
 void VoiceActivityDetector::on_voice_continuing() {
   VoiceActivitySegment *segment = &(segments.back());
   const float current_time = seconds_from_sample_count(samples_processed_count);
-  segment->audio_data = current_segment_audio_buffer;
+  segment->audio_data = segment_arena;
   segment->end_time = current_time;
   segment->is_complete = false;
   segment->just_updated = true;
@@ -219,7 +367,12 @@ void VoiceActivityDetector::on_voice_continuing() {
 void VoiceActivityDetector::on_voice_end() {
   VoiceActivitySegment *segment = &(segments.back());
   const float current_time = seconds_from_sample_count(samples_processed_count);
-  segment->audio_data = current_segment_audio_buffer;
+  // Copied into storage of its own at its exact length, freeing the arena for
+  // the next segment.
+  std::vector<float> &buffer = segment_audio_buffers.back();
+  buffer.assign(segment_arena.begin(), segment_arena.end());
+  segment_arena.clear();
+  segment->audio_data = buffer;
   segment->end_time = current_time;
   segment->is_complete = true;
   segment->just_updated = true;
@@ -231,7 +384,8 @@ std::string VoiceActivitySegment::to_string() const {
   result += ", end_time=" + std::to_string(end_time);
   result += ", is_complete=" + std::to_string(is_complete);
   result += ")";
-  result += ", audio_data=" + float_vector_stats_to_string(audio_data);
+  result += ", audio_data=" + float_vector_stats_to_string(std::vector<float>(
+                                  audio_data.begin(), audio_data.end()));
   return result;
 }
 
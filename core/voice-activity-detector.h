@@ -1,13 +1,17 @@
 #ifndef VOICE_ACTIVITY_DETECTOR_H
 #define VOICE_ACTIVITY_DETECTOR_H
 
+#include <span>
 #include <string>
 #include <vector>
 
 #include "silero-vad.h"
 
 struct VoiceActivitySegment {
-  std::vector<float> audio_data;
+  // The segment's 16 kHz audio. It is owned by the detector that produced the
+  // segment and stays valid until that detector's next process_audio, start
+  // or clear_completed_segment_audio_data call.
+  std::span<const float> audio_data;
   float start_time;
   float end_time;
   // A flag to indicate that the talking in this segment has ended.
@@ -36,10 +40,32 @@ class VoiceActivityDetector {
   int32_t probability_window_index;
   std::vector<VoiceActivitySegment> segments;
   size_t samples_processed_count;
-  std::vector<float> current_segment_audio_buffer;
+  // The most recent look_behind_sample_count samples, as a ring with
+  // look_behind_write_index as its oldest sample, for the audio just before
+  // a segment starts.
   std::vector<float> look_behind_audio_buffer;
+  size_t look_behind_write_index;
+  // Audio for each completed entry of segments, copied out of the arena at
+  // its exact length. Empty for the segment still in progress.
+  std::vector<std::vector<float>> segment_audio_buffers;
+  // The in-progress segment's audio. Reserved for a typical utterance when
+  // the first segment starts, grown up to the longest segment allowed, and
+  // kept across segments so a stream settles into one allocation.
+  std::vector<float> segment_arena;
+  // Fewer than hop_size samples left over from the last call.
   std::vector<float> processing_remainder_audio_buffer;
+  // The audio queued by the current process_audio_batch call, at 16 kHz,
+  // and the first hop when it starts with the leftover samples.
+  const float *queued_audio;
+  size_t queued_audio_size;
+  std::vector<float> resampled_audio;
+  std::vector<float> first_hop;
   bool previous_is_voice;
+  // This stream's recurrent model state, so streams sharing silero_vad don't
+  // leak into each other.
+  SileroVadState vad_state;
+  // Zero-padded copy of a hop when hop_size isn't the model's window size.
+  std::vector<float> padded_hop;
 
  public:
   VoiceActivityDetector(float threshold = 0.5f, int32_t window_size = 32,
@@ -53,9 +79,21 @@ class VoiceActivityDetector {
   bool is_active() const { return _is_active; }
   void process_audio(const float *audio_data, size_t audio_data_size,
                      int32_t sample_rate);
+  // Same as calling process_audio on each of ``count`` detectors in turn, but
+  // every hop the detectors have ready at the same position goes through the
+  // model in one batched inference, rather than one inference per hop per
+  // detector. The detectors must be distinct, and nobody else may use them
+  // until this returns. A transcriber with vad_batch_max_wait_ms set gathers
+  // its streams' calls into batches through VoiceActivityBatchScheduler.
+  static void process_audio_batch(VoiceActivityDetector *const *detectors,
+                                  const float *const *audio_data,
+                                  const size_t *audio_data_sizes,
+                                  const int32_t *sample_rates, size_t count);
   const std::vector<VoiceActivitySegment> *get_segments() const {
     return &segments;
   }
+  // Bytes of segment audio storage the detector holds, by capacity: the
+  // completed segments not yet cleared plus the arena.
   size_t retained_segment_audio_byte_count() const;
   size_t completed_segment_audio_byte_count() const;
   void clear_completed_segment_audio_data();
@@ -66,7 +104,23 @@ class VoiceActivityDetector {
   void on_voice_start();
   void on_voice_end();
   void on_voice_continuing();
-  void process_audio_chunk(const float *audio_data, size_t audio_data_size);
+  // Queues new audio, resampled, after the unprocessed remainder and returns
+  // how many whole hops are ready. Returns 0 if the detector isn't active.
+  size_t queue_audio(const float *audio_data, size_t audio_data_size,
+                     int32_t sample_rate);
+  // Ready hop ``hop_index`` of the queued audio.
+  const float *queued_hop(size_t hop_index) const;
+  // The model's input for ready hop ``hop_index``.
+  const float *model_input_for_hop(size_t hop_index);
+  // Keeps what's left of the queued audio after ``hop_count`` hops.
+  void finish_queued_audio(size_t hop_count);
+  size_t current_segment_sample_count() const {
+    return previous_is_voice ? segment_arena.size() : 0;
+  }
+  void start_segment_audio_buffer();
+  void append_to_segment_audio(const float *audio_data, size_t size);
+  void process_audio_chunk(const float *audio_data, size_t audio_data_size,
+                           float current_probability);
 };
 
 #endif
\ No newline at end of file
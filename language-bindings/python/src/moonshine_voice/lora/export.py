@@ -150,6 +150,12 @@ class CrossKV(nn.Module):
     Splitting these out of the decoder is the entire reason the runtime can decode a
     token without touching the audio again. Only the two projections per layer are
     held here, so the graph carries only the weights it uses.
+
+    The projections see one frame at a time, so the runtime feeds only the memory
+    frames added since its last call and appends the result to what it already has.
+    `frame_offset` is where those frames start in the line. Nothing here depends on
+    it, but its presence is what tells the runtime the graph may be given a slice;
+    exports without it get the whole memory on every update.
     """
 
     def __init__(self, layers, heads, head_dim):
@@ -158,7 +164,8 @@ class CrossKV(nn.Module):
         self.v_projs = nn.ModuleList([layer.encoder_attn.v_proj for layer in layers])
         self.heads, self.head_dim = heads, head_dim
 
-    def forward(self, memory: Tensor):
+    def forward(self, memory: Tensor, frame_offset: Tensor):
+        del frame_offset
         keys, values = [], []
         shape = (1, -1, self.heads, self.head_dim)
         for k_proj, v_proj in zip(self.k_projs, self.v_projs):
@@ -256,6 +263,75 @@ class DecoderKV(nn.Module):
         return logits, torch.stack(keys), torch.stack(values), out_k_cross, out_v_cross
 
 
+class BatchedDecoderKV(DecoderKV):
+    """`DecoderKV` for several independent lines in one run.
+
+    The runtime gathers the pending step of every stream that is decoding and pads
+    them to a common shape: self-attention caches on the left to the longest one, cross
+    keys and values on the right to the longest memory. Two masks mark which of those
+    positions are real, and since a row's position can no longer be read off the
+    padded cache length, `position_ids` carries it for every token.
+    """
+
+    def forward(self, token: Tensor, k_self: Tensor, v_self: Tensor,
+                out_k_cross: Tensor, out_v_cross: Tensor, self_attention_mask: Tensor,
+                cross_attention_mask: Tensor, position_ids: Tensor):
+        from transformers.models.moonshine_streaming.modeling_moonshine_streaming import (
+            apply_rotary_pos_emb,
+        )
+
+        batch, length = token.shape
+        cached = k_self.shape[3]
+        hidden = self.embed_tokens(token.long())
+        cos, sin = self.rotary(hidden, position_ids)
+
+        shape = (batch, length, self.heads, self.head_dim)
+        query_pos = torch.arange(cached, cached + length, device=hidden.device)
+        key_pos = torch.arange(cached + length, device=hidden.device)
+        causal = (query_pos.unsqueeze(1) >= key_pos.unsqueeze(0))[None, None]
+        # The tokens fed in this step are always real; only the cache can be padding.
+        fresh = torch.ones(batch, length, dtype=torch.bool, device=hidden.device)
+        self_visible = causal & torch.cat(
+            [self_attention_mask.bool(), fresh], dim=1)[:, None, None, :]
+        cross_visible = cross_attention_mask.bool()[:, None, None, :]
+
+        keys, values = [], []
+        for index, block in enumerate(self.blocks):
+            normed = block["input_layernorm"](hidden)
+            query = block["q_proj"](normed).view(shape).transpose(1, 2)
+            key = block["k_proj"](normed).view(shape).transpose(1, 2)
+            value = block["v_proj"](normed).view(shape).transpose(1, 2)
+            query, key = apply_rotary_pos_emb(query, key, cos, sin)
+
+            key = torch.cat([k_self[index], key], dim=2)
+            value = torch.cat([v_self[index], value], dim=2)
+            keys.append(key)
+            values.append(value)
+
+            scores = torch.matmul(query, key.transpose(-2, -1)) * self.scale
+            scores = scores.masked_fill(~self_visible, torch.finfo(scores.dtype).min)
+            attended = torch.matmul(F.softmax(scores, dim=-1), value)
+            attended = attended.transpose(1, 2).reshape(
+                batch, length, self.heads * self.head_dim)
+            hidden = hidden + block["o_proj"](attended)
+
+            normed = block["post_attention_layernorm"](hidden)
+            query = block["cross_q_proj"](normed).view(shape).transpose(1, 2)
+            scores = torch.matmul(query, out_k_cross[index].transpose(-2, -1)) * self.scale
+            scores = scores.masked_fill(~cross_visible, torch.finfo(scores.dtype).min)
+            attended = torch.matmul(F.softmax(scores, dim=-1), out_v_cross[index])
+            attended = attended.transpose(1, 2).reshape(
+                batch, length, self.heads * self.head_dim)
+            hidden = hidden + block["cross_o_proj"](attended)
+
+            hidden = hidden + block["mlp"](block["final_layernorm"](hidden))
+
+        hidden = self.norm(hidden)
+        logits = (hidden @ self.embed_tokens.weight.t() if self.tied
+                  else self.head(hidden))
+        return logits, torch.stack(keys), torch.stack(values), out_k_cross, out_v_cross
+
+
 def drop_passthrough_renames(model):
     """Give a tensor that enters and leaves a graph unchanged the same name on both sides.
 
@@ -358,6 +434,10 @@ def main(argv=None):
     parser.add_argument("--tokenizer-bin", default=None,
                         help="tokenizer.bin to copy in; unchanged by fine-tuning, so "
                              "the published one is usually what you want")
+    parser.add_argument("--batched-decoder", action="store_true",
+                        help="export decoder_kv with a batch axis, padding masks and "
+                             "position_ids, so the runtime can decode several streams "
+                             "in one run (decoder_batch_max_wait_ms)")
     args = parser.parse_args(argv)
 
     from torch.export import Dim
@@ -420,13 +500,48 @@ def main(argv=None):
 
     if "cross_kv" in wanted:
         export(CrossKV(decoder.layers, heads, head_dim),
-               (torch.randn(1, 37, dec_hidden),),
-               out / "cross_kv.onnx", ["memory"], ["k_cross", "v_cross"],
-               {"memory": {1: Dim("mem_len", min=2, max=1 << 16)}},
+               (torch.randn(1, 37, dec_hidden), torch.zeros(1, dtype=torch.long)),
+               out / "cross_kv.onnx", ["memory", "frame_offset"], ["k_cross", "v_cross"],
+               {"memory": {1: Dim("mem_len", min=2, max=1 << 16)}, "frame_offset": None},
                {"cross_kv_config": {"depth": depth, "nheads": heads,
                                     "head_dim": head_dim, "decoder_dim": dec_hidden}})
 
-    if "decoder_kv" in wanted:
+    if "decoder_kv" in wanted and args.batched_decoder:
+        batch = Dim("batch", min=1, max=64)
+        token_len = Dim("token_len", min=1, max=1 << 14)
+        cache_len = Dim("cache_len", min=1, max=1 << 14)
+        memory_len = Dim("memory_len", min=2, max=1 << 16)
+        # Distinct dummy sizes for the same reason as below, batch included.
+        export(BatchedDecoderKV(decoder, model.proj_out, heads, head_dim,
+                                decoder.rotary_emb),
+               (torch.tensor([[1, 100], [1, 200], [1, 300]]),
+                torch.zeros(depth, 3, heads, 5, head_dim),
+                torch.zeros(depth, 3, heads, 5, head_dim),
+                torch.randn(depth, 3, heads, 37, head_dim),
+                torch.randn(depth, 3, heads, 37, head_dim),
+                torch.ones(3, 5, dtype=torch.long),
+                torch.ones(3, 37, dtype=torch.long),
+                torch.tensor([[5, 6], [5, 6], [5, 6]])),
+               out / "decoder_kv.onnx",
+               ["token", "k_self", "v_self", "out_k_cross", "out_v_cross",
+                "self_attention_mask", "cross_attention_mask", "position_ids"],
+               ["logits", "out_k_self", "out_v_self", "out_k_cross", "out_v_cross"],
+               {"token": {0: batch, 1: token_len},
+                "k_self": {1: batch, 3: cache_len}, "v_self": {1: batch, 3: cache_len},
+                "out_k_cross": {1: batch, 3: memory_len},
+                "out_v_cross": {1: batch, 3: memory_len},
+                "self_attention_mask": {0: batch, 1: cache_len},
+                "cross_attention_mask": {0: batch, 1: memory_len},
+                "position_ids": {0: batch, 1: token_len}},
+               {"decoder_config": {"depth": depth, "nheads": heads, "head_dim": head_dim,
+                                   "vocab_size": config.vocab_size,
+                                   "decoder_dim": dec_hidden,
+                                   "bos_id": config.bos_token_id,
+                                   "eos_id": config.eos_token_id,
+                                   "batched": True},
+                "cache_shapes": {"k_self": [depth, 1, heads, 0, head_dim],
+                                 "v_self": [depth, 1, heads, 0, head_dim]}})
+    elif "decoder_kv" in wanted:
         cache_len = Dim("cache_len", min=1, max=1 << 14)
         memory_len = Dim("memory_len", min=2, max=1 << 16)
         # Every dummy length here is distinct and unlike head_dim: give two axes the
@@ -468,7 +583,8 @@ def main(argv=None):
         print(f"  copied tokenizer.bin")
 
 
-def export_checkpoint(model, output_dir, graphs="all", tokenizer_bin=None):
+def export_checkpoint(model, output_dir, graphs="all", tokenizer_bin=None,
+                      batched_decoder=False):
     """Export a Transformers checkpoint (hub id or ``save_pretrained`` dir)."""
     argv = [
         "--model",
@@ -480,6 +596,8 @@ def export_checkpoint(model, output_dir, graphs="all", tokenizer_bin=None):
     ]
     if tokenizer_bin is not None:
         argv.extend(["--tokenizer-bin", str(tokenizer_bin)])
+    if batched_decoder:
+        argv.append("--batched-decoder")
     main(argv)
     return Path(output_dir)
 
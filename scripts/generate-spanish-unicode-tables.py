@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+"""Regenerate core/moonshine-tts/src/lang-specific/spanish-unicode-tables.cpp.
+
+Spanish rule-based G2P normalizes words with four per-codepoint properties,
+all taken from the Python that runs this script so that they match the Python
+reference implementation:
+
+  * lower  -- ``str.lower()`` (may expand, e.g. U+0130 -> "i" + U+0307);
+  * strip  -- NFD with nonspacing marks (category Mn) removed, for codepoints
+              where that changes anything;
+  * word   -- matches ``re`` ``\\w``;
+  * space  -- ``str.isspace()``.
+
+The tables are two-stage: the codepoint range is cut into blocks of
+``2**BLOCK_SHIFT`` codepoints, blocks with identical contents are stored once
+in ``k_unicode_stage2`` (one property record index per codepoint), and
+``k_unicode_stage1`` maps each block number to its stored block. Records hold
+offsets into one deduplicated UTF-8 string pool instead of pointers, so the
+data is ``constexpr`` and needs no relocations. Hangul syllables are left out
+of the strip data because ``spanish-unicode.cpp`` decomposes them
+algorithmically (checked below).
+
+The integer widths are fixed by spanish-unicode-tables.h; the script fails if
+the data outgrows them.
+
+The shipped tables are Unicode ``UNIDATA_VERSION`` data, and the script
+refuses to run under a Python with any other version so that regenerating
+never silently changes results. Python 3.9 and 3.10 both carry Unicode 13.0.
+
+Usage:
+    python3.9 scripts/generate-spanish-unicode-tables.py [--out PATH]
+"""
+
+import argparse
+import re
+import sys
+import unicodedata
+from pathlib import Path
+
+REPO = Path(__file__).resolve().parent.parent
+DEFAULT_OUT = (
+    REPO / "core" / "moonshine-tts" / "src" / "lang-specific"
+    / "spanish-unicode-tables.cpp"
+)
+
+# Checked by spanish-unicode-test against the tables shipped before the
+# two-stage layout; changing it changes Spanish G2P output.
+UNIDATA_VERSION = "13.0.0"
+
+LIMIT = 0x110000
+# Must match k_unicode_block_shift in spanish-unicode-tables.h.
+BLOCK_SHIFT = 7
+
+# Must match the UnicodePropFlags values in spanish-unicode-tables.h.
+WORD = 1
+SPACE = 2
+HAS_LOWER = 4
+HAS_STRIP = 8
+
+HANGUL_FIRST = 0xAC00
+HANGUL_COUNT = 11172
+WORD_RE = re.compile(r"\w")
+
+
+def strip_marks(ch: str) -> str:
+    return "".join(
+        c for c in unicodedata.normalize("NFD", ch)
+        if unicodedata.category(c) != "Mn"
+    )
+
+
+def hangul_jamo(cp: int) -> str:
+    s = cp - HANGUL_FIRST
+    out = chr(0x1100 + s // 588) + chr(0x1161 + (s % 588) // 28)
+    if s % 28:
+        out += chr(0x11A7 + s % 28)
+    return out
+
+
+class StringPool:
+    def __init__(self) -> None:
+        self.data = bytearray()
+        self.offsets: dict[bytes, int] = {}
+
+    def add(self, s: str) -> tuple[int, int]:
+        b = s.encode("utf-8")
+        if b not in self.offsets:
+            at = self.data.find(b)
+            if at < 0:
+                at = len(self.data)
+                self.data += b
+            self.offsets[b] = at
+        return self.offsets[b], len(b)
+
+
+def build():
+    pool = StringPool()
+    records = {(0, 0, 0, 0, 0): 0}
+    record_of = [0] * LIMIT
+    for cp in range(LIMIT):
+        ch = chr(cp)
+        flags = 0
+        lower = ch.lower()
+        lower_ref = (0, 0)
+        if lower != ch:
+            flags |= HAS_LOWER
+            lower_ref = pool.add(lower)
+        stripped = strip_marks(ch)
+        strip_ref = (0, 0)
+        if HANGUL_FIRST <= cp < HANGUL_FIRST + HANGUL_COUNT:
+            assert stripped == hangul_jamo(cp), hex(cp)
+            assert lower == ch, hex(cp)
+        elif stripped != ch:
+            flags |= HAS_STRIP
+            strip_ref = pool.add(stripped)
+        if WORD_RE.match(ch):
+            flags |= WORD
+        if ch.isspace():
+            flags |= SPACE
+        if cp < 0x80:
+            # spanish-unicode.cpp lower-cases ASCII inline.
+            assert flags & HAS_STRIP == 0, hex(cp)
+            assert lower == (chr(cp + 32) if "A" <= ch <= "Z" else ch), hex(cp)
+        record = (lower_ref[0], strip_ref[0], lower_ref[1], strip_ref[1], flags)
+        record_of[cp] = records.setdefault(record, len(records))
+
+    block_size = 1 << BLOCK_SHIFT
+    blocks: dict[tuple[int, ...], int] = {}
+    stage1 = []
+    for b in range(LIMIT >> BLOCK_SHIFT):
+        block = tuple(record_of[b * block_size:(b + 1) * block_size])
+        stage1.append(blocks.setdefault(block, len(blocks)))
+    stage2 = [r for block in blocks for r in block]
+
+    assert len(blocks) <= 0x100, "stage1 entries no longer fit in uint8_t"
+    assert len(records) <= 0x10000, "record indices no longer fit in uint16_t"
+    assert len(pool.data) <= 0x10000, "string offsets no longer fit in uint16_t"
+    assert all(r[2] < 0x100 and r[3] < 0x100 for r in records)
+    return stage1, stage2, list(records), bytes(pool.data)
+
+
+def rows(items, fmt):
+    """Initializer lines for ``items``, packed up to 80 columns."""
+    out = []
+    line = "   "
+    for x in items:
+        cell = " " + fmt(x) + ","
+        if len(line) + len(cell) > 80:
+            out.append(line)
+            line = "   "
+        line += cell
+    if line.strip():
+        out.append(line)
+    return out
+
+
+def render(stage1, stage2, records, strings) -> str:
+    lines = [
+        '#include "spanish-unicode-tables.h"',
+        "",
+        "namespace moonshine_tts::spanish_unicode {",
+        "",
+        "// AUTO-GENERATED by scripts/generate-spanish-unicode-tables.py -- do "
+        "not edit.",
+        f"// Unicode {unicodedata.unidata_version} (Python "
+        f"{sys.version_info.major}.{sys.version_info.minor}).",
+        "",
+        "constexpr std::uint8_t",
+        "    k_unicode_stage1[k_unicode_table_limit >> k_unicode_block_shift] "
+        "= {",
+    ]
+    lines += rows(stage1, str)
+    lines += [
+        "};",
+        "",
+        f"constexpr std::uint16_t k_unicode_stage2[{len(stage2)}] = {{",
+    ]
+    lines += rows(stage2, str)
+    lines += [
+        "};",
+        "",
+        f"constexpr UnicodeProps k_unicode_props[{len(records)}] = {{",
+    ]
+    lines += rows(records, lambda r: "{%d, %d, %d, %d, %d}" % r)
+    lines += [
+        "};",
+        "",
+        f"constexpr char k_unicode_strings[{len(strings) + 1}] =",
+    ]
+    for i in range(0, len(strings), 16):
+        chunk = "".join(f"\\x{b:02x}" for b in strings[i:i + 16])
+        lines.append(f'    "{chunk}"')
+    lines[-1] += ";"
+    lines += ["", "}  // namespace moonshine_tts::spanish_unicode", ""]
+    return "\n".join(lines)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--out", type=Path, default=DEFAULT_OUT)
+    args = parser.parse_args()
+    if unicodedata.unidata_version != UNIDATA_VERSION:
+        print(
+            f"error: this Python has Unicode {unicodedata.unidata_version}; "
+            f"the tables are Unicode {UNIDATA_VERSION} (use Python 3.9 or "
+            "3.10)",
+            file=sys.stderr,
+        )
+        return 1
+    stage1, stage2, records, strings = build()
+    args.out.write_text(render(stage1, stage2, records, strings))
+    print(
+        f"{args.out}: {len(stage1)} blocks -> {len(stage2) >> BLOCK_SHIFT} "
+        f"stored, {len(records)} records, {len(strings)} string bytes",
+        file=sys.stderr,
+    )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -57,6 +57,12 @@ ${REPO_ROOT_DIR}/core/build/moonshine-c-api-test
 ${REPO_ROOT_DIR}/core/build/moonshine-cpp-test
 ${REPO_ROOT_DIR}/core/build/cosine-distance-test
 ${REPO_ROOT_DIR}/core/build/word-alignment-test
+${REPO_ROOT_DIR}/core/build/moonshine-streaming-model-test
+${REPO_ROOT_DIR}/core/build/moonshine-streaming-decode-scheduler-test
+${REPO_ROOT_DIR}/core/build/cpp-annote-engine-test
+${REPO_ROOT_DIR}/core/build/cpp-annote-streaming-test
+${REPO_ROOT_DIR}/core/build/clustering-vbx-test
+${REPO_ROOT_DIR}/core/build/scipy-linkage-test
 ${REPO_ROOT_DIR}/core/build/context-biaser-test
 ${REPO_ROOT_DIR}/core/build/context-extractor-test
 